@@ -984,6 +984,21 @@ static bool is_package_name(const char *pkg) {
 
 static char *read_file(const char *path) { return ny_read_file(path); }
 
+/* Module sources are only scanned and copied, so they are read through a
+   file view (mapped when large) with any shebang line skipped in place. */
+static bool read_source_view(ny_file_view_t *v, const char *path) {
+  if (!ny_file_view_open(v, path, 0, SIZE_MAX, 0))
+    return false;
+  ny_file_view_advise(v, NY_FILE_ADVISE_SEQUENTIAL);
+  if (v->len >= 2 && v->data[0] == '#' && v->data[1] == '!') {
+    const char *nl = memchr(v->data, '\n', v->len);
+    size_t skip = nl ? (size_t)(nl - v->data) + 1 : v->len;
+    v->data += skip;
+    v->len -= skip;
+  }
+  return true;
+}
+
 static bool ny_mod_ident_start(char c) {
   unsigned char uc = (unsigned char)c;
   return isalpha(uc) || c == '_';
@@ -1997,13 +2012,14 @@ static char *ny_build_module_chunk(const char *path, const char *name, size_t *o
   if (ny_std_trace_enabled()) {
     fprintf(stderr, "STD_TRACE chunk: %s\n", path);
   }
-  char *txt = read_file(path);
-  if (!txt)
+  ny_file_view_t view;
+  if (!read_source_view(&view, path))
     return NULL;
-  size_t total = 0, cap = strlen(txt) + 256;
+  const char *txt = view.data;
+  size_t total = 0, cap = view.len + 256;
   char *bundle = malloc(cap);
   if (!bundle) {
-    free(txt);
+    ny_file_view_close(&view);
     return NULL;
   }
   bundle[0] = '\0';
@@ -2051,7 +2067,7 @@ static char *ny_build_module_chunk(const char *path, const char *name, size_t *o
     append_text(&bundle, &total, &cap, use_stmt);
     append_text(&bundle, &total, &cap, "\n");
   }
-  free(txt);
+  ny_file_view_close(&view);
   if (out_len)
     *out_len = total;
   if (ny_std_trace_chunks_enabled()) {
@@ -2105,11 +2121,12 @@ static void scan_dependencies(mod_list *list, size_t idx) {
   }
   NY_LOG_V2("Scanning dependencies for %s\n", list->entries[idx].path);
   list->entries[idx].processed = true;
-  char *txt = read_file(list->entries[idx].path);
-  if (!txt) {
+  ny_file_view_t view;
+  if (!read_source_view(&view, list->entries[idx].path)) {
     NY_LOG_V2("Failed to read file: %s\n", list->entries[idx].path);
     return;
   }
+  const char *txt = view.data;
 
   char *base_dir = dir_from_path(list->entries[idx].path);
   bool prefer_local = !list->entries[idx].is_std;
@@ -2192,7 +2209,7 @@ static void scan_dependencies(mod_list *list, size_t idx) {
   }
 
   free(base_dir);
-  free(txt);
+  ny_file_view_close(&view);
 }
 
 char *ny_build_std_source_ex(const char **modules, size_t module_count, std_mode_t mode,
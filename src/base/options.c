@@ -614,6 +614,7 @@ static void ny_sync_opt_profile_env(ny_options *opt) {
     ny_setenv("NYTRIX_PROVEN_INT_MOD_FAST", "1", 0);
   }
   if (profile == NY_OPT_PROFILE_PEAK) {
+    ny_setenv("NYTRIX_PGO_USE", "nytrix.nypgo", 0);
     ny_setenv("NYTRIX_MONO_IMPERATIVE", "1", 0);
     ny_setenv("NYTRIX_PROVEN_RAW_INT_EXPR_FAST", "1", 0);
     ny_setenv("NYTRIX_RAW_INT_EXPR_FAST", "1", 0);
@@ -1453,6 +1454,10 @@ static bool ny_options_apply_toggle(ny_options *opt, const char *a) {
        NY_OPT_TOGGLE_INT},
       {"--no-opt-autotune", offsetof(ny_options, opt_autotune), 0,
        NY_OPT_TOGGLE_INT},
+      {"--runtime-lto", offsetof(ny_options, runtime_lto), 1,
+       NY_OPT_TOGGLE_INT},
+      {"--no-runtime-lto", offsetof(ny_options, runtime_lto), 0,
+       NY_OPT_TOGGLE_INT},
       {"--gpu-async", offsetof(ny_options, gpu_async), 1, NY_OPT_TOGGLE_INT},
       {"--no-gpu-async", offsetof(ny_options, gpu_async), 0, NY_OPT_TOGGLE_INT},
       {"--gpu-fast-math", offsetof(ny_options, gpu_fast_math), 1,
@@ -1585,6 +1590,7 @@ void ny_options_init(ny_options *opt) {
   opt->opt_internalize = -1;
   opt->opt_loops = 0;
   opt->opt_autotune = 0;
+  opt->runtime_lto = -1;
   opt->opt_level_explicit = false;
   opt->profiler_mode = false;
   opt->debug_symbols = false;
@@ -1693,6 +1699,12 @@ static void ny_options_usage_impl(const char *prog, bool show_env) {
        "peak"},
       {NY_CLR_GREEN, "-passes=PIPE",
        "Custom LLVM pass pipeline (e.g., 'default<O2>')"},
+      {NY_CLR_GREEN, "--pgo-gen=FILE",
+       "Instrument call sites; runs write type feedback to FILE"},
+      {NY_CLR_GREEN, "--pgo-use=FILE",
+       "Specialize and lay out code from a --pgo-gen profile"},
+      {NY_CLR_GREEN, "--[no-]runtime-lto",
+       "Link the runtime into AOT builds as bitcode (default at -O2+)"},
       {NULL, NULL, NULL}});
   ny_usage_section("PARALLELISM");
   ny_usage_items((const ny_usage_entry_t[]){
@@ -2258,6 +2270,12 @@ void ny_options_parse(ny_options *opt, int argc, char **argv) {
           exit(1);
         }
         opt->opt_profile = value;
+      } else if ((value = ny_option_value_or_die(a, "--pgo-gen", &i, argc,
+                                                 argv, argv[0])) != NULL) {
+        ny_setenv("NYTRIX_PGO_GEN", value, 1);
+      } else if ((value = ny_option_value_or_die(a, "--pgo-use", &i, argc,
+                                                 argv, argv[0])) != NULL) {
+        ny_setenv("NYTRIX_PGO_USE", value, 1);
       } else if (strcmp(a, "-O1") == 0) {
         ny_set_opt_level(opt, 1);
       } else if (strcmp(a, "-O0") == 0) {
@@ -235,6 +235,7 @@ typedef struct {
   int opt_internalize;
   int opt_loops;
   int opt_autotune;
+  int runtime_lto;
   bool opt_level_explicit;
   bool repl_plain;
   const char *gpu_mode;
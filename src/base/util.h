@@ -10,6 +10,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 static inline char *ny_read_file_raw(const char *path, size_t *out_len) {
   if (!path)
@@ -43,6 +48,149 @@ static inline char *ny_read_file_raw(const char *path, size_t *out_len) {
   return content;
 }
 char *ny_read_file(const char *path);
+
+/*
+ * Read-only, NUL-terminated view of a byte range of a file. Ranges of at
+ * least NY_FILE_VIEW_MAP_MIN bytes that start on an 8-byte boundary and run
+ * to the end of the file are mapped privately, so scanning a large file needs
+ * address space rather than heap; other ranges (and every range on Windows)
+ * are read into a malloc'd block. Either way `data` is word-aligned. `head` bytes before
+ * `data` are writable scratch for the caller, such as a runtime string
+ * header. Call ny_file_view_seal once that is written.
+ */
+#define NY_FILE_VIEW_MAP_MIN ((size_t)64 * 1024)
+
+typedef enum {
+  NY_FILE_ADVISE_NORMAL = 0,
+  NY_FILE_ADVISE_SEQUENTIAL = 1,
+  NY_FILE_ADVISE_RANDOM = 2,
+  NY_FILE_ADVISE_WILLNEED = 3,
+  NY_FILE_ADVISE_DONTNEED = 4,
+} ny_file_advice_t;
+
+typedef struct {
+  char *data;
+  size_t len;
+  void *base;      /* mapping or malloc block */
+  size_t map_len;  /* 0 when base is a malloc block */
+  size_t head_len; /* bytes of base before the file pages */
+} ny_file_view_t;
+
+static inline bool ny_file_view_read(ny_file_view_t *v, FILE *f, size_t off, size_t len,
+                                     size_t head) {
+  head = (head + 15) & ~(size_t)15;
+  char *buf = malloc(head + len + 1);
+  if (!buf)
+    return false;
+#if defined(_WIN32)
+  bool ok = _fseeki64(f, (long long)off, SEEK_SET) == 0;
+#else
+  bool ok = fseeko(f, (off_t)off, SEEK_SET) == 0;
+#endif
+  size_t got = ok ? fread(buf + head, 1, len, f) : 0;
+  if (!ok || got != len) {
+    free(buf);
+    return false;
+  }
+  buf[head + len] = '\0';
+  v->base = buf;
+  v->data = buf + head;
+  v->len = len;
+  v->map_len = 0;
+  v->head_len = head;
+  return true;
+}
+
+/* Opens [off, off + len) of path; a len past the end is clipped to the file. */
+static inline bool ny_file_view_open(ny_file_view_t *v, const char *path, size_t off, size_t len,
+                                     size_t head) {
+  memset(v, 0, sizeof(*v));
+  if (!path)
+    return false;
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+#if defined(_WIN32)
+  struct _stat64 st;
+  bool ok = _fstat64(_fileno(f), &st) == 0 && (st.st_mode & _S_IFREG);
+#else
+  struct stat st;
+  bool ok = fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode);
+#endif
+  size_t size = ok ? (size_t)st.st_size : 0;
+  if (!ok || off > size) {
+    fclose(f);
+    return false;
+  }
+  if (len > size - off)
+    len = size - off;
+#if !defined(_WIN32)
+  if (len >= NY_FILE_VIEW_MAP_MIN && (off & 7) == 0 && off + len == size) {
+    /* Reserve the head page(s), the file pages and one zero page, then lay
+       the file over the middle. The terminator is the zero fill past EOF (or
+       the reserved page), never a write into the file pages: a private copy
+       would be dropped again by MADV_DONTNEED. */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = off & ~(page - 1), delta = off - start;
+    size_t lead = (head + page - 1) & ~(page - 1);
+    size_t span = (delta + len + page) & ~(page - 1);
+    char *base = mmap(NULL, lead + span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED) {
+      void *m = mmap(base + lead, delta + len, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+                     fileno(f), (off_t)start);
+      if (m != MAP_FAILED && base[lead + delta + len] == '\0') {
+        fclose(f);
+        v->base = base;
+        v->map_len = lead + span;
+        v->head_len = lead;
+        v->data = base + lead + delta;
+        v->len = len;
+        return true;
+      }
+      munmap(base, lead + span);
+    }
+  }
+#endif
+  ok = ny_file_view_read(v, f, off, len, head);
+  fclose(f);
+  return ok;
+}
+
+/* Makes a mapped view's pages read-only. */
+static inline void ny_file_view_seal(ny_file_view_t *v) {
+#if !defined(_WIN32)
+  if (v && v->map_len)
+    mprotect(v->base, v->map_len, PROT_READ);
+#else
+  (void)v;
+#endif
+}
+
+static inline void ny_file_view_advise(ny_file_view_t *v, ny_file_advice_t advice) {
+#if !defined(_WIN32) && defined(MADV_SEQUENTIAL)
+  if (!v || !v->map_len)
+    return;
+  static const int kinds[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED,
+                              MADV_DONTNEED};
+  if ((unsigned)advice < sizeof(kinds) / sizeof(kinds[0]))
+    madvise((char *)v->base + v->head_len, v->map_len - v->head_len, kinds[advice]);
+#else
+  (void)v;
+  (void)advice;
+#endif
+}
+
+static inline void ny_file_view_close(ny_file_view_t *v) {
+  if (!v || !v->base)
+    return;
+#if !defined(_WIN32)
+  if (v->map_len)
+    munmap(v->base, v->map_len);
+  else
+#endif
+    free(v->base);
+  memset(v, 0, sizeof(*v));
+}
 char *ny_read_url(const char *url);
 int ny_write_file(const char *path, const char *content, size_t len);
 bool ny_write_if_changed(const char *path, const char *content, size_t len);
@@ -64,10 +212,10 @@ static inline void ny_ensure_dir_recursive(const char *path) {
   if (!path || !*path)
     return;
   char tmp[1024];
-  snprintf(tmp, sizeof(tmp), "%s", path);
-  size_t len = strlen(tmp);
-  if (len == 0)
-    return;
+  int n = snprintf(tmp, sizeof(tmp), "%s", path);
+  if (n <= 0 || (size_t)n >= sizeof(tmp))
+    return; /* never create a truncated prefix of the requested path */
+  size_t len = (size_t)n;
   if (tmp[len - 1] == '/')
     tmp[len - 1] = 0;
   for (char *p = tmp + 1; *p; p++) {
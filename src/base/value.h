@@ -0,0 +1,117 @@
+#ifndef NYTRIX_BASE_VALUE_H
+#define NYTRIX_BASE_VALUE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Tagged value encoding shared by codegen and the runtime.
+ *
+ * A value is one 64-bit word. Low bits select the kind:
+ *
+ *   ...xx1  small int, payload in the upper 63 bits
+ *   ...000  heap pointer (8-aligned), kind in the header word at v-8
+ *   ...110  native handle (64-bit hosts)
+ *   ...100  inline float (only with NYTRIX_INLINE_FLOAT), see below
+ *   0, 2, 8 nil, false, true
+ *
+ * Without NYTRIX_INLINE_FLOAT every float is a 16-byte heap box whose payload
+ * sits at an address with (v & 15) == 8. With it, doubles whose binary
+ * exponent is in [-126, 128] (and +-0.0) are stored in the word itself using
+ * a rotated-exponent encoding: the IEEE bits are rotated left by one so the
+ * sign is the low bit, the exponent is rebased by 896 so it fits in 8 bits,
+ * and the result is shifted over the 3 tag bits. Everything else (NaN, inf,
+ * denormals, huge/tiny magnitudes) keeps the heap box, so both forms must be
+ * accepted wherever a float is read.
+ *
+ * The low tag alone is not enough: raw pointer arithmetic (`p + 4`) yields
+ * untagged addresses with the same low bits. A nonzero inline float always
+ * carries its rebased exponent (1..255) in the top byte, so it is at least
+ * 2^56 and above any user-space address, and +-0.0 encode as 4 and 12, below
+ * NY_VALUE_PTR_MIN_ADDR. The check is therefore a mask and compare plus one
+ * range compare, still with no memory access.
+ *
+ * NYTRIX_INLINE_FLOAT is a build-wide choice: the compiler, the runtime it
+ * links into JIT code and the runtime object compiled for executables must
+ * all agree, which is why the builder forwards it and why NY_VALUE_ENCODING
+ * is part of every cache key.
+ */
+
+#ifndef NYTRIX_INLINE_FLOAT
+#define NYTRIX_INLINE_FLOAT 0
+#endif
+
+#define NY_VALUE_INT_TAG_BIT UINT64_C(1)
+#define NY_VALUE_INT_SHIFT 1
+#define NY_VALUE_PTR_TAG_MASK UINT64_C(7)
+#define NY_VALUE_PTR_MIN_ADDR ((uintptr_t)0x1000)
+
+#if UINTPTR_MAX == 0xffffffff
+#define NY_NATIVE_TAG_MASK UINT64_C(3)
+#define NY_NATIVE_TAG UINT64_C(2)
+#define NY_NATIVE_SHIFT 2
+#define NY_NATIVE_MARK (UINT64_C(1) << 63)
+#define NY_NATIVE_IS(v)                                                                            \
+  (((((uint64_t)(v) & NY_NATIVE_MARK) != 0ULL) &&                                                  \
+    (((uint64_t)(v) & NY_NATIVE_TAG_MASK) == NY_NATIVE_TAG)))
+#else
+#define NY_NATIVE_TAG_MASK NY_VALUE_PTR_TAG_MASK
+#define NY_NATIVE_TAG UINT64_C(6)
+#define NY_NATIVE_SHIFT 3
+#define NY_NATIVE_IS(v) ((((uint64_t)(v)) & NY_NATIVE_TAG_MASK) == NY_NATIVE_TAG)
+#endif
+
+#define NY_VALUE_FLT_TAG_MASK UINT64_C(7)
+#define NY_VALUE_FLT_TAG UINT64_C(4)
+#define NY_VALUE_FLT_SHIFT 3
+#define NY_VALUE_FLT_ZERO_MAX UINT64_C(16)
+#define NY_VALUE_FLT_MIN_NONZERO (UINT64_C(1) << 56)
+#define NY_VALUE_FLT_EXP_MIN 897u
+#define NY_VALUE_FLT_EXP_MAX 1151u
+#define NY_VALUE_FLT_EXP_BIAS (UINT64_C(896) << 53)
+
+#if NYTRIX_INLINE_FLOAT && UINTPTR_MAX != 0xffffffff
+#define NY_VALUE_HAS_INLINE_FLOAT 1
+#define NY_VALUE_ENCODING "lowtag-iflt1"
+#else
+#define NY_VALUE_HAS_INLINE_FLOAT 0
+#define NY_VALUE_ENCODING "lowtag1"
+#endif
+
+static inline bool ny_value_is_flt_imm(uint64_t v) {
+#if NY_VALUE_HAS_INLINE_FLOAT
+  /* v < 16 or v >= 2^56, as one unsigned compare. */
+  return (v & NY_VALUE_FLT_TAG_MASK) == NY_VALUE_FLT_TAG &&
+         v - NY_VALUE_FLT_ZERO_MAX >= NY_VALUE_FLT_MIN_NONZERO - NY_VALUE_FLT_ZERO_MAX;
+#else
+  (void)v;
+  return false;
+#endif
+}
+
+/* Encode IEEE-754 bits as an inline float; false when the value needs a box. */
+static inline bool ny_value_flt_imm_encode(uint64_t bits, uint64_t *out) {
+#if NY_VALUE_HAS_INLINE_FLOAT
+  uint64_t rot = (bits << 1) | (bits >> 63);
+  if (rot > 1) {
+    unsigned exp = (unsigned)((bits >> 52) & 0x7ffu);
+    if (exp < NY_VALUE_FLT_EXP_MIN || exp > NY_VALUE_FLT_EXP_MAX)
+      return false;
+    rot -= NY_VALUE_FLT_EXP_BIAS;
+  }
+  *out = (rot << NY_VALUE_FLT_SHIFT) | NY_VALUE_FLT_TAG;
+  return true;
+#else
+  (void)bits;
+  (void)out;
+  return false;
+#endif
+}
+
+static inline uint64_t ny_value_flt_imm_decode(uint64_t v) {
+  uint64_t rot = v >> NY_VALUE_FLT_SHIFT;
+  if (rot > 1)
+    rot += NY_VALUE_FLT_EXP_BIAS;
+  return (rot >> 1) | (rot << 63);
+}
+
+#endif
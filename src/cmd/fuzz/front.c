@@ -0,0 +1,961 @@
+#include "core.h"
+#include "code/code.h"
+#include "code/typepipeline.h"
+#include "parse/parser.h"
+#include <sys/mman.h>
+
+/*
+ * In-process, coverage-guided fuzzer for the front end.
+ *
+ * ny-fuzz drives the ny binary one process per case, which spends most of
+ * its time in exec and LLVM start-up. This tool links the compiler objects
+ * instead and pushes inputs straight through lexer_next, parse_program and
+ * the type pipeline. When the compiler objects are built with sanitizer
+ * coverage (NYTRIX_BUILD_FUZZ_FRONT selects trace-pc-guard on clang and
+ * trace-pc on gcc) the callbacks below count edge hits in a shared map, and
+ * an input that reaches a new (edge, hit bucket) pair joins the corpus.
+ * Without instrumentation the map falls back to token-kind bigrams plus the
+ * parse/type outcome, which still steers the mutator, just less precisely.
+ *
+ * Inputs execute in a forked worker that inherits the warmed-up compiler
+ * state and handles up to --persist inputs before it is recycled. The parent
+ * owns the corpus and the mutator and hands inputs over a pipe, so a crash or
+ * hang only costs one worker: the parent saves the offending input under
+ * <out>/crashes or <out>/hangs and forks a fresh one.
+ *
+ * Mutations work on lexer tokens (drop, duplicate, replace, splice balanced
+ * bracket groups between corpus entries, swap in boundary numbers) with an
+ * occasional raw byte edit. Fresh seeds come from the shape-driven C
+ * synthesiser passed through cbridge, which keeps new material close to
+ * well-formed Ny.
+ */
+
+#define FRONT_MAP_SIZE (1u << 16)
+#define FRONT_MAX_INPUT (64u * 1024u)
+#define FRONT_MAX_TOKENS 16384u
+
+typedef enum {
+  FRONT_STAGE_LEX,
+  FRONT_STAGE_PARSE,
+  FRONT_STAGE_TYPE,
+} front_stage_t;
+
+typedef enum {
+  FRONT_RUN_OK,
+  FRONT_RUN_CRASH,
+  FRONT_RUN_HANG,
+  FRONT_RUN_EXIT,
+  FRONT_RUN_FAILED,
+} front_outcome_t;
+
+typedef struct {
+  char *data;
+  size_t len;
+  uint32_t bits;
+} front_entry_t;
+
+typedef VEC(front_entry_t) front_corpus_t;
+
+typedef struct {
+  uint32_t off;
+  uint32_t len;
+  token_kind kind;
+} front_tok_t;
+
+typedef struct {
+  pid_t pid;
+  int to_child;
+  int from_child;
+  int execs;
+} front_worker_t;
+
+typedef struct {
+  front_stage_t stage;
+  const char *out_dir;
+  const char *shape_dir;
+  int persist;
+  int timeout_ms;
+  size_t max_len;
+  bool verbose;
+  uint64_t rng;
+  front_worker_t worker;
+  uint8_t virgin[FRONT_MAP_SIZE];
+  front_corpus_t corpus;
+  uint64_t execs;
+  uint64_t crashes;
+  uint64_t hangs;
+  uint64_t exits;
+  uint64_t synth_seeds;
+  uint32_t covered;
+} front_state_t;
+
+static uint8_t front_local_map[FRONT_MAP_SIZE];
+static uint8_t *front_map = front_local_map;
+static uint32_t front_guard_count; /* guards handed out by trace-pc-guard */
+
+#if defined(NYTRIX_FUZZ_SANCOV_GUARD)
+#define FRONT_COVERAGE_NAME "trace-pc-guard"
+void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop) {
+  if (start == stop || *start) return;
+  for (uint32_t *g = start; g < stop; ++g)
+    *g = 1u + (front_guard_count++ % (FRONT_MAP_SIZE - 1u));
+}
+
+void __sanitizer_cov_trace_pc_guard(uint32_t *guard) { front_map[*guard]++; }
+#elif defined(NYTRIX_FUZZ_SANCOV_PC)
+#define FRONT_COVERAGE_NAME "trace-pc"
+static __thread uintptr_t front_prev_loc;
+
+void __sanitizer_cov_trace_pc(void) {
+  uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+  uintptr_t cur = (pc ^ (pc >> 12)) & (FRONT_MAP_SIZE - 1u);
+  front_map[cur ^ front_prev_loc]++;
+  front_prev_loc = cur >> 1;
+}
+#else
+#define FRONT_COVERAGE_NAME "tokens"
+#endif
+
+static bool front_instrumented(void) {
+#if defined(NYTRIX_FUZZ_SANCOV_PC)
+  return true;
+#else
+  return front_guard_count != 0;
+#endif
+}
+
+static uint64_t front_rand(front_state_t *st) {
+  uint64_t x = st->rng ? st->rng : UINT64_C(0x9e3779b97f4a7c15);
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  st->rng = x;
+  return x * UINT64_C(0x2545f4914f6cdd1d);
+}
+
+static size_t front_below(front_state_t *st, size_t n) {
+  return n ? (size_t)(front_rand(st) % n) : 0;
+}
+
+/* ---- target ---------------------------------------------------------- */
+
+static void front_mark(uint32_t feature) {
+  uint8_t *slot = &front_map[feature & (FRONT_MAP_SIZE - 1u)];
+  if (*slot < 255) (*slot)++;
+}
+
+static int front_exec(const char *src, front_stage_t stage) {
+  bool tokens = !front_instrumented();
+  lexer_t lx;
+  lexer_init(&lx, src, "<fuzz>");
+  lx.quiet = true;
+  uint32_t prev = NY_T_EOF;
+  for (uint32_t n = 0; n < FRONT_MAX_TOKENS; ++n) {
+    token_t t = lexer_next(&lx);
+    if (tokens) front_mark(prev * 131u + (uint32_t)t.kind);
+    prev = (uint32_t)t.kind;
+    if (t.kind == NY_T_EOF) break;
+  }
+  int rc = lx.had_error ? 1 : 0;
+  if (stage == FRONT_STAGE_LEX) return rc;
+
+  parser_global_cleanup();
+  parser_t parser;
+  parser_init_quiet(&parser, src, "<fuzz>");
+  parser.error_limit = 0;
+  program_t prog = parse_program(&parser);
+  rc = parser.had_error ? 1 : 0;
+  if (!parser.had_error && stage == FRONT_STAGE_TYPE) {
+    codegen_t cg;
+    codegen_init(&cg, &prog, parser.arena, "nytrix_fuzz");
+    cg.skip_stdlib = true;
+    codegen_collect_links(&cg, &prog);
+    codegen_prepare(&cg);
+    if (cg.had_error) {
+      rc = 2;
+    } else {
+      ny_type_pipeline_stage_t failed = NY_TYPE_PIPELINE_STAGE_OK;
+      int errors = ny_type_pipeline_validate_semantics(
+          &prog, &cg, "<fuzz>", false, NY_TYPE_PIPELINE_STAGE_ABI, &failed,
+          false, NULL);
+      if (errors > 0) rc = 3 + (int)failed;
+    }
+    codegen_dispose(&cg);
+  }
+  program_free(&prog, parser.arena);
+  if (tokens) front_mark(0xfff0u + (uint32_t)rc);
+  return rc;
+}
+
+/* ---- fork server ----------------------------------------------------- */
+
+static bool front_read_full(int fd, void *buf, size_t len) {
+  char *p = (char *)buf;
+  while (len) {
+    ssize_t n = read(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+static bool front_write_full(int fd, const void *buf, size_t len) {
+  const char *p = (const char *)buf;
+  while (len) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+static void front_child_loop(int in_fd, int out_fd, front_stage_t stage) {
+  char *buf = (char *)malloc(FRONT_MAX_INPUT + 1u);
+  if (!buf) _exit(1);
+  for (;;) {
+    uint32_t len = 0;
+    if (!front_read_full(in_fd, &len, sizeof(len)) || len == 0 || len > FRONT_MAX_INPUT)
+      _exit(0);
+    if (!front_read_full(in_fd, buf, len)) _exit(0);
+    buf[len] = '\0';
+    int32_t rc = front_exec(buf, stage);
+    if (!front_write_full(out_fd, &rc, sizeof(rc))) _exit(0);
+  }
+}
+
+static void front_worker_stop(front_worker_t *w, bool kill_it) {
+  if (w->pid <= 0) return;
+  if (kill_it) {
+    kill(w->pid, SIGKILL);
+  } else {
+    uint32_t zero = 0;
+    (void)front_write_full(w->to_child, &zero, sizeof(zero));
+  }
+  close(w->to_child);
+  close(w->from_child);
+  int status = 0;
+  while (waitpid(w->pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  memset(w, 0, sizeof(*w));
+}
+
+static bool front_worker_start(front_state_t *st) {
+  int to_child[2], from_child[2];
+  if (pipe(to_child) != 0) return false;
+  if (pipe(from_child) != 0) {
+    close(to_child[0]);
+    close(to_child[1]);
+    return false;
+  }
+  fflush(NULL);
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(to_child[0]);
+    close(to_child[1]);
+    close(from_child[0]);
+    close(from_child[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(to_child[1]);
+    close(from_child[0]);
+    signal(SIGPIPE, SIG_DFL);
+    if (!st->verbose) {
+      int devnull = open("/dev/null", O_WRONLY);
+      if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+      }
+    }
+    front_child_loop(to_child[0], from_child[1], st->stage);
+    _exit(0);
+  }
+  close(to_child[0]);
+  close(from_child[1]);
+  st->worker.pid = pid;
+  st->worker.to_child = to_child[1];
+  st->worker.from_child = from_child[0];
+  st->worker.execs = 0;
+  return true;
+}
+
+static front_outcome_t front_run(front_state_t *st, const char *data, size_t len, int *rc_out) {
+  if (len > FRONT_MAX_INPUT) len = FRONT_MAX_INPUT;
+  if (len == 0) {
+    data = "\n";
+    len = 1;
+  }
+  if (st->worker.pid > 0 && st->worker.execs >= st->persist)
+    front_worker_stop(&st->worker, false);
+  if (st->worker.pid <= 0 && !front_worker_start(st)) return FRONT_RUN_FAILED;
+  memset(front_map, 0, FRONT_MAP_SIZE);
+  uint32_t n = (uint32_t)len;
+  st->execs++;
+  st->worker.execs++;
+  if (front_write_full(st->worker.to_child, &n, sizeof(n)) &&
+      front_write_full(st->worker.to_child, data, len)) {
+    struct pollfd pfd = {.fd = st->worker.from_child, .events = POLLIN};
+    int ready;
+    do {
+      ready = poll(&pfd, 1, st->timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready == 0) {
+      front_worker_stop(&st->worker, true);
+      return FRONT_RUN_HANG;
+    }
+    int32_t rc = 0;
+    if (ready > 0 && front_read_full(st->worker.from_child, &rc, sizeof(rc))) {
+      if (rc_out) *rc_out = rc;
+      return FRONT_RUN_OK;
+    }
+  }
+  int status = 0;
+  pid_t pid = st->worker.pid;
+  close(st->worker.to_child);
+  close(st->worker.from_child);
+  memset(&st->worker, 0, sizeof(st->worker));
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  if (WIFSIGNALED(status)) {
+    if (rc_out) *rc_out = WTERMSIG(status);
+    return FRONT_RUN_CRASH;
+  }
+  return FRONT_RUN_EXIT;
+}
+
+/* ---- coverage bookkeeping -------------------------------------------- */
+
+static uint8_t front_bucket(uint8_t hits) {
+  if (hits <= 3) return hits == 3 ? 4 : hits;
+  if (hits < 8) return 8;
+  if (hits < 16) return 16;
+  if (hits < 32) return 32;
+  if (hits < 128) return 64;
+  return 128;
+}
+
+/* Folds the last run's map into `virgin` and returns how many new
+ * (edge, bucket) bits it contributed. */
+static uint32_t front_merge(front_state_t *st, uint8_t *virgin) {
+  uint32_t fresh = 0;
+  const uint64_t *words = (const uint64_t *)(const void *)front_map;
+  for (size_t w = 0; w < FRONT_MAP_SIZE / sizeof(uint64_t); ++w) {
+    if (!words[w]) continue;
+    for (size_t i = w * sizeof(uint64_t); i < (w + 1) * sizeof(uint64_t); ++i) {
+      uint8_t b = front_bucket(front_map[i]);
+      if (!(b & (uint8_t)~virgin[i])) continue;
+      if (!virgin[i]) st->covered++;
+      virgin[i] |= b;
+      fresh++;
+    }
+  }
+  return fresh;
+}
+
+static void front_save(const char *dir, const char *prefix, const char *data, size_t len) {
+  if (!dir || !*dir) return;
+  mkdir_p(dir);
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s%016" PRIx64 ".ny", dir, prefix, fnv1a64(data, len));
+  if (access(path, F_OK) == 0) return;
+  FILE *f = fopen(path, "wb");
+  if (!f) return;
+  fwrite(data, 1, len, f);
+  fclose(f);
+}
+
+static void front_record(front_state_t *st, front_outcome_t outcome, int rc,
+                         const char *data, size_t len) {
+  char sub[4096];
+  char prefix[32];
+  if (outcome == FRONT_RUN_CRASH) {
+    st->crashes++;
+    snprintf(sub, sizeof(sub), "%s/crashes", st->out_dir);
+    snprintf(prefix, sizeof(prefix), "sig%d-", rc);
+    front_save(sub, prefix, data, len);
+  } else if (outcome == FRONT_RUN_HANG) {
+    st->hangs++;
+    snprintf(sub, sizeof(sub), "%s/hangs", st->out_dir);
+    front_save(sub, "", data, len);
+  } else if (outcome == FRONT_RUN_EXIT) {
+    st->exits++;
+  }
+}
+
+/* Runs one input and keeps it when it is new; returns true if added. */
+static bool front_try(front_state_t *st, const char *data, size_t len, bool save) {
+  int rc = 0;
+  front_outcome_t outcome = front_run(st, data, len, &rc);
+  if (outcome != FRONT_RUN_OK) {
+    front_record(st, outcome, rc, data, len);
+    return false;
+  }
+  uint32_t fresh = front_merge(st, st->virgin);
+  if (!fresh) return false;
+  front_entry_t e = {0};
+  e.data = (char *)malloc(len + 1u);
+  if (!e.data) return false;
+  memcpy(e.data, data, len);
+  e.data[len] = '\0';
+  e.len = len;
+  e.bits = fresh;
+  vec_push(&st->corpus, e);
+  if (save) {
+    char sub[4096];
+    snprintf(sub, sizeof(sub), "%s/corpus", st->out_dir);
+    front_save(sub, "", data, len);
+  }
+  return true;
+}
+
+/* ---- mutation -------------------------------------------------------- */
+
+static const char *const front_dict[] = {
+    "fn", "return", "if", "else", "elif", "while", "for", "in", "match",
+    "struct", "enum", "def", "mut", "use", "defer", "comptime", "lambda",
+    "try", "catch", "break", "continue", "nil", "true", "false", "as",
+    "sizeof", "extern", "module", "del", "(", ")", "{", "}", "[", "]",
+    ",", ":", ";", ".", "..", "...", "->", "=", "==", "!=", "<", ">",
+    "+", "-", "*", "/", "%", "**", "&", "|", "^", "<<", ">>", "~", "!",
+    "?", "??", "?.", "@", "|>", "+=", "++", "\n", "\"\"", "f\"{x}\"",
+};
+
+static const char *const front_numbers[] = {
+    "0", "1", "-1", "2", "7", "8", "127", "128", "255", "256", "65535",
+    "2147483647", "-2147483648", "4294967296", "9223372036854775807",
+    "-9223372036854775808", "0x7f", "0b1", "1.0", "0.5", "1e308", "-0.0",
+};
+
+static size_t front_tokenize(const char *src, size_t len, front_tok_t *out, size_t cap) {
+  lexer_t lx;
+  lexer_init(&lx, src, "<fuzz>");
+  lx.quiet = true;
+  size_t n = 0;
+  while (n < cap) {
+    token_t t = lexer_next(&lx);
+    if (t.kind == NY_T_EOF || t.kind == NY_T_ERROR) break;
+    if (!t.lexeme || t.lexeme < src || t.lexeme + t.len > src + len) continue;
+    out[n].off = (uint32_t)(t.lexeme - src);
+    out[n].len = (uint32_t)t.len;
+    out[n].kind = t.kind;
+    n++;
+  }
+  return n;
+}
+
+static bool front_is_open(token_kind k) {
+  return k == NY_T_LPAREN || k == NY_T_LBRACE || k == NY_T_LBRACK;
+}
+
+/* Index of the token closing the group opened at `open`, or 0. */
+static size_t front_group_end(const front_tok_t *toks, size_t n, size_t open) {
+  int depth = 0;
+  for (size_t i = open; i < n; ++i) {
+    if (front_is_open(toks[i].kind)) depth++;
+    if (toks[i].kind == NY_T_RPAREN || toks[i].kind == NY_T_RBRACE ||
+        toks[i].kind == NY_T_RBRACK) {
+      if (--depth == 0) return i;
+    }
+  }
+  return 0;
+}
+
+static bool front_pick_group(front_state_t *st, const front_tok_t *toks, size_t n,
+                             size_t *lo, size_t *hi) {
+  for (int tries = 0; tries < 8 && n; ++tries) {
+    size_t i = front_below(st, n);
+    while (i < n && !front_is_open(toks[i].kind)) i++;
+    if (i >= n) continue;
+    size_t end = front_group_end(toks, n, i);
+    if (!end) continue;
+    *lo = toks[i].off;
+    *hi = toks[end].off + toks[end].len;
+    return true;
+  }
+  return false;
+}
+
+static void front_emit(str_buf_t *out, const char *src, size_t from, size_t to) {
+  if (to > from) (void)sb_append_n(out, src + from, to - from);
+}
+
+/* One token-level edit of `src` into `out`. `other` supplies donor text for
+ * splices and replacements. */
+static void front_mutate_once(front_state_t *st, const char *src, size_t len,
+                              const char *other, size_t other_len, str_buf_t *out) {
+  static front_tok_t toks[FRONT_MAX_TOKENS];
+  static front_tok_t donor[FRONT_MAX_TOKENS];
+  size_t n = front_tokenize(src, len, toks, FRONT_MAX_TOKENS);
+  size_t dn = other ? front_tokenize(other, other_len, donor, FRONT_MAX_TOKENS) : 0;
+  size_t at = n ? front_below(st, n) : 0;
+  size_t span = 1 + front_below(st, n > 8 ? 4 : 1);
+  size_t a = n ? toks[at].off : len;
+  size_t b_tok = at + span <= n ? at + span - 1 : (n ? n - 1 : 0);
+  size_t b = n ? toks[b_tok].off + toks[b_tok].len : len;
+  size_t lo = 0, hi = 0, dlo = 0, dhi = 0;
+  switch (n ? front_below(st, 8) : 7) {
+  case 0: /* drop tokens */
+    front_emit(out, src, 0, a);
+    front_emit(out, src, b, len);
+    return;
+  case 1: /* duplicate tokens */
+    front_emit(out, src, 0, b);
+    (void)sb_append_c(out, ' ');
+    front_emit(out, src, a, len);
+    return;
+  case 2: /* replace a token with a donor token, same kind when possible */
+    if (dn) {
+      size_t pick = front_below(st, dn);
+      for (size_t i = 0; i < dn; ++i) {
+        size_t j = (pick + i) % dn;
+        if (donor[j].kind == toks[at].kind) {
+          pick = j;
+          break;
+        }
+      }
+      front_emit(out, src, 0, toks[at].off);
+      front_emit(out, other, donor[pick].off, donor[pick].off + donor[pick].len);
+      front_emit(out, src, toks[at].off + toks[at].len, len);
+      return;
+    }
+    break;
+  case 3: /* swap a balanced group for one from the donor */
+    if (dn && front_pick_group(st, toks, n, &lo, &hi) &&
+        front_pick_group(st, donor, dn, &dlo, &dhi)) {
+      front_emit(out, src, 0, lo);
+      front_emit(out, other, dlo, dhi);
+      front_emit(out, src, hi, len);
+      return;
+    }
+    break;
+  case 4: /* insert a donor group at a token boundary */
+    if (dn && front_pick_group(st, donor, dn, &dlo, &dhi)) {
+      front_emit(out, src, 0, a);
+      front_emit(out, other, dlo, dhi);
+      (void)sb_append_c(out, ' ');
+      front_emit(out, src, a, len);
+      return;
+    }
+    break;
+  case 5: /* boundary numbers */
+    for (size_t i = 0; i < n; ++i) {
+      size_t j = (at + i) % n;
+      if (toks[j].kind != NY_T_NUMBER) continue;
+      front_emit(out, src, 0, toks[j].off);
+      (void)sb_append(out, front_numbers[front_below(st, sizeof(front_numbers) / sizeof(front_numbers[0]))]);
+      front_emit(out, src, toks[j].off + toks[j].len, len);
+      return;
+    }
+    break;
+  case 6: /* drop a whole group, keeping the brackets */
+    if (front_pick_group(st, toks, n, &lo, &hi) && hi - lo >= 2) {
+      front_emit(out, src, 0, lo + 1);
+      front_emit(out, src, hi - 1, len);
+      return;
+    }
+    break;
+  default:
+    break;
+  }
+  /* dictionary insert, with a rare raw byte edit */
+  if (front_below(st, 16) == 0 && len) {
+    size_t pos = front_below(st, len);
+    front_emit(out, src, 0, pos);
+    (void)sb_append_c(out, (char)(front_rand(st) & 0x7f));
+    front_emit(out, src, pos + 1, len);
+    return;
+  }
+  front_emit(out, src, 0, a);
+  (void)sb_append(out, front_dict[front_below(st, sizeof(front_dict) / sizeof(front_dict[0]))]);
+  (void)sb_append_c(out, ' ');
+  front_emit(out, src, a, len);
+}
+
+static char *front_mutate(front_state_t *st, const front_entry_t *base,
+                          const front_entry_t *donor, size_t *len_out) {
+  char *cur = (char *)malloc(base->len + 1u);
+  if (!cur) return NULL;
+  memcpy(cur, base->data, base->len + 1u);
+  size_t cur_len = base->len;
+  int rounds = 1 + (int)front_below(st, 4);
+  for (int r = 0; r < rounds; ++r) {
+    str_buf_t out = {0};
+    front_mutate_once(st, cur, cur_len, donor ? donor->data : NULL,
+                      donor ? donor->len : 0, &out);
+    if (!out.data) break;
+    if (out.len > st->max_len) out.len = st->max_len;
+    free(cur);
+    cur_len = out.len;
+    cur = sb_take(&out);
+    if (!cur) return NULL;
+    cur[cur_len] = '\0';
+  }
+  *len_out = cur_len;
+  return cur;
+}
+
+/* ---- seeds ----------------------------------------------------------- */
+
+static char *front_synth_seed(front_state_t *st, int seed, size_t *len_out) {
+  static const char *const profiles[] = {"balanced", "optimizer", "memory", "strings", "state"};
+  if (!st->shape_dir || !*st->shape_dir) return NULL;
+  char c_path[4096];
+  snprintf(c_path, sizeof(c_path), "%s/.synth-%d.c", st->out_dir, (int)getpid());
+  FILE *f = fopen(c_path, "wb");
+  if (!f) return NULL;
+  int rc = nytrix_synth_print_c_program(f, st->shape_dir, "mixed",
+                                        profiles[seed % 5], NULL, seed, true, false);
+  fclose(f);
+  char *src = NULL;
+  if (rc == 0) {
+    cbridge_convert_result_t r = convert_cbridge_file(c_path);
+    if (r.ny_source) {
+      src = r.ny_source;
+      r.ny_source = NULL;
+      *len_out = strlen(src);
+      st->synth_seeds++;
+    }
+    cbridge_convert_result_free(&r);
+  }
+  unlink(c_path);
+  return src;
+}
+
+static int front_entry_size_cmp(const void *a, const void *b) {
+  const front_entry_t *x = (const front_entry_t *)a;
+  const front_entry_t *y = (const front_entry_t *)b;
+  return x->len < y->len ? -1 : x->len > y->len ? 1 : 0;
+}
+
+static void front_load_dir(front_corpus_t *out, const char *dir, size_t max_len) {
+  DIR *d = dir && *dir ? opendir(dir) : NULL;
+  if (!d) return;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != NULL) {
+    if (ent->d_name[0] == '.' || !has_suffix(ent->d_name, ".ny")) continue;
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+    file_buf_t f = {0};
+    if (!read_file(path, &f)) continue;
+    if (f.len > max_len) {
+      f.len = max_len;
+      f.data[f.len] = '\0';
+    }
+    front_entry_t e = {.data = f.data, .len = f.len, .bits = 0};
+    vec_push(out, e);
+  }
+  closedir(d);
+  qsort(out->data, out->len, sizeof(out->data[0]), front_entry_size_cmp);
+}
+
+static void front_corpus_free(front_corpus_t *c) {
+  for (size_t i = 0; i < c->len; ++i) free(c->data[i].data);
+  vec_free(c);
+}
+
+/* ---- commands -------------------------------------------------------- */
+
+static front_stage_t front_parse_stage(const char *s) {
+  if (strcmp(s, "lex") == 0) return FRONT_STAGE_LEX;
+  if (strcmp(s, "parse") == 0) return FRONT_STAGE_PARSE;
+  return FRONT_STAGE_TYPE;
+}
+
+static const char *front_stage_name(front_stage_t s) {
+  return s == FRONT_STAGE_LEX ? "lex" : s == FRONT_STAGE_PARSE ? "parse" : "type";
+}
+
+static bool front_init(front_state_t *st, int argc, char **argv) {
+  memset(st, 0, sizeof(*st));
+  st->stage = front_parse_stage(arg_value(argc, argv, "--stage", "type"));
+  st->out_dir = arg_value(argc, argv, "--out", "build/fuzz/front");
+  st->shape_dir = arg_value(argc, argv, "--shape-dir", "etc/tests/fuzz/shapes");
+  st->persist = atoi(arg_value(argc, argv, "--persist", "1000"));
+  st->timeout_ms = atoi(arg_value(argc, argv, "--timeout-ms", "2000"));
+  st->max_len = (size_t)strtoull(arg_value(argc, argv, "--max-len", "8192"), NULL, 10);
+  st->verbose = arg_flag(argc, argv, "--verbose");
+  st->rng = (uint64_t)strtoull(arg_value(argc, argv, "--seed", "1337"), NULL, 10) *
+                UINT64_C(0x9e3779b97f4a7c15) + 1u;
+  if (st->persist < 1) st->persist = 1;
+  if (st->timeout_ms < 1) st->timeout_ms = 1;
+  if (st->max_len < 16) st->max_len = 16;
+  if (st->max_len > FRONT_MAX_INPUT) st->max_len = FRONT_MAX_INPUT;
+  mkdir_p(st->out_dir);
+  void *map = mmap(NULL, FRONT_MAP_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) return false;
+  front_map = (uint8_t *)map;
+  signal(SIGPIPE, SIG_IGN);
+  /* Warm interners and lazily built tables once so every worker inherits
+   * them instead of rebuilding them after fork. */
+  (void)front_exec("fn main() {\n  return 0\n}\n", st->stage);
+  return true;
+}
+
+static void front_finish(front_state_t *st) {
+  front_worker_stop(&st->worker, false);
+  front_corpus_free(&st->corpus);
+  if (front_map != front_local_map) munmap(front_map, FRONT_MAP_SIZE);
+  front_map = front_local_map;
+}
+
+static void front_print_summary(FILE *out, const char *cmd, const front_state_t *st,
+                                double elapsed_ms) {
+  fprintf(out,
+          "{\"ok\":%s,\"engine\":\"nytrix_front\",\"command\":\"%s\",\"stage\":\"%s\","
+          "\"coverage\":\"%s\",\"execs\":%" PRIu64 ",\"execs_per_s\":%.1f,"
+          "\"corpus\":%zu,\"edges\":%u,\"synth_seeds\":%" PRIu64 ",\"crashes\":%" PRIu64
+          ",\"hangs\":%" PRIu64 ",\"exits\":%" PRIu64 ",\"elapsed_ms\":%.1f,\"out\":",
+          st->crashes || st->hangs ? "false" : "true", cmd, front_stage_name(st->stage),
+          front_instrumented() ? FRONT_COVERAGE_NAME : "tokens", st->execs,
+          elapsed_ms > 0 ? (double)st->execs * 1000.0 / elapsed_ms : 0.0, st->corpus.len,
+          st->covered, st->synth_seeds, st->crashes, st->hangs, st->exits, elapsed_ms);
+  json_str(out, st->out_dir);
+  fputs("}\n", out);
+}
+
+static int front_cmd_run(int argc, char **argv) {
+  static front_state_t st;
+  if (!front_init(&st, argc, argv)) return 2;
+  uint64_t runs = (uint64_t)strtoull(arg_value(argc, argv, "--runs", "100000"), NULL, 10);
+  double budget_ms = atof(arg_value(argc, argv, "--seconds", "0")) * 1000.0;
+  int synth_every = atoi(arg_value(argc, argv, "--synth-every", "64"));
+  int seed_count = atoi(arg_value(argc, argv, "--seeds", "16"));
+  double start = now_ms();
+
+  front_corpus_t seeds = {0};
+  front_load_dir(&seeds, arg_value(argc, argv, "--corpus", ""), st.max_len);
+  for (size_t i = 0; i < seeds.len; ++i)
+    (void)front_try(&st, seeds.data[i].data, seeds.data[i].len, false);
+  front_corpus_free(&seeds);
+  for (int i = 0; i < seed_count; ++i) {
+    size_t len = 0;
+    char *src = front_synth_seed(&st, (int)front_below(&st, 1u << 30), &len);
+    if (!src) break;
+    (void)front_try(&st, src, len < st.max_len ? len : st.max_len, true);
+    free(src);
+  }
+  if (st.corpus.len == 0) {
+    static const char fallback[] = "fn main() {\n  mut x = 1\n  return x + 2\n}\n";
+    int rc = 0;
+    if (front_run(&st, fallback, sizeof(fallback) - 1, &rc) == FRONT_RUN_OK)
+      (void)front_merge(&st, st.virgin);
+    front_entry_t e = {.data = strdup(fallback), .len = sizeof(fallback) - 1, .bits = 1};
+    if (e.data) vec_push(&st.corpus, e);
+  }
+
+  double last_status = now_ms();
+  for (uint64_t i = 0; i < runs && st.corpus.len; ++i) {
+    if (budget_ms > 0 && now_ms() - start >= budget_ms) break;
+    size_t len = 0;
+    char *input = NULL;
+    if (synth_every > 0 && front_below(&st, (size_t)synth_every) == 0)
+      input = front_synth_seed(&st, (int)front_below(&st, 1u << 30), &len);
+    if (!input) {
+      /* Bias towards recent, smaller finds: pick two and keep the shorter. */
+      size_t a = front_below(&st, st.corpus.len);
+      size_t b = st.corpus.len - 1 - front_below(&st, (st.corpus.len + 3) / 4);
+      const front_entry_t *base = st.corpus.data[a].len <= st.corpus.data[b].len
+                                      ? &st.corpus.data[a] : &st.corpus.data[b];
+      const front_entry_t *donor = &st.corpus.data[front_below(&st, st.corpus.len)];
+      input = front_mutate(&st, base, donor, &len);
+    }
+    if (!input) continue;
+    (void)front_try(&st, input, len < st.max_len ? len : st.max_len, true);
+    free(input);
+    if (st.verbose && now_ms() - last_status >= 2000.0) {
+      last_status = now_ms();
+      front_print_summary(stderr, "run", &st, last_status - start);
+    }
+  }
+  front_print_summary(stdout, "run", &st, now_ms() - start);
+  int rc = st.crashes || st.hangs ? 1 : 0;
+  front_finish(&st);
+  return rc;
+}
+
+/* Greedy corpus minimisation: run inputs smallest first and keep each one
+ * only if it adds an (edge, bucket) bit that nothing kept so far covers. */
+static int front_cmd_cmin(int argc, char **argv) {
+  static front_state_t st;
+  const char *in_dir = arg_value(argc, argv, "--corpus", "");
+  if (!*in_dir) {
+    printf("{\"ok\":false,\"error\":\"usage\",\"reason\":\"missing --corpus\"}\n");
+    return 3;
+  }
+  if (!front_init(&st, argc, argv)) return 2;
+  double start = now_ms();
+  front_corpus_t inputs = {0};
+  front_load_dir(&inputs, in_dir, FRONT_MAX_INPUT);
+  char keep_dir[4096];
+  snprintf(keep_dir, sizeof(keep_dir), "%s/cmin", st.out_dir);
+  const char *dest = arg_value(argc, argv, "--min-out", keep_dir);
+  size_t kept = 0;
+  for (size_t i = 0; i < inputs.len; ++i) {
+    int rc = 0;
+    front_outcome_t outcome = front_run(&st, inputs.data[i].data, inputs.data[i].len, &rc);
+    if (outcome != FRONT_RUN_OK) {
+      front_record(&st, outcome, rc, inputs.data[i].data, inputs.data[i].len);
+      continue;
+    }
+    if (!front_merge(&st, st.virgin)) continue;
+    front_save(dest, "", inputs.data[i].data, inputs.data[i].len);
+    kept++;
+  }
+  printf("{\"ok\":true,\"engine\":\"nytrix_front\",\"command\":\"cmin\",\"inputs\":%zu,"
+         "\"kept\":%zu,\"edges\":%u,\"crashes\":%" PRIu64 ",\"hangs\":%" PRIu64
+         ",\"elapsed_ms\":%.1f,\"out\":",
+         inputs.len, kept, st.covered, st.crashes, st.hangs, now_ms() - start);
+  json_str(stdout, dest);
+  fputs("}\n", stdout);
+  front_corpus_free(&inputs);
+  front_finish(&st);
+  return 0;
+}
+
+static int front_cmd_replay(int argc, char **argv) {
+  static front_state_t st;
+  if (!front_init(&st, argc, argv)) return 2;
+  st.out_dir = "";
+  int failures = 0;
+  str_buf_t results = {0};
+  for (int i = 2; i < argc; ++i) {
+    if (argv[i][0] == '-') {
+      if (!strchr(argv[i], '=') && i + 1 < argc && strcmp(argv[i], "--verbose") != 0) i++;
+      continue;
+    }
+    file_buf_t f = {0};
+    if (!read_file(argv[i], &f)) continue;
+    int rc = 0;
+    front_outcome_t outcome = front_run(&st, f.data, f.len, &rc);
+    static const char *const names[] = {"ok", "crash", "hang", "exit", "failed"};
+    if (outcome != FRONT_RUN_OK) failures++;
+    if (results.len) (void)sb_append_c(&results, ',');
+    (void)sb_append(&results, "{\"path\":");
+    (void)sb_append_json_str(&results, argv[i]);
+    (void)sb_appendf(&results, ",\"outcome\":\"%s\",\"code\":%d}", names[outcome], rc);
+    free(f.data);
+  }
+  printf("{\"ok\":%s,\"engine\":\"nytrix_front\",\"command\":\"replay\",\"results\":[%s]}\n",
+         failures ? "false" : "true", results.data ? results.data : "");
+  free(results.data);
+  front_finish(&st);
+  return failures ? 1 : 0;
+}
+
+/* Removes the file front_save would have written for data; false if absent. */
+static bool front_selftest_take(const char *dir, const char *prefix, const char *data,
+                                size_t len) {
+  char path[4096];
+  int n = snprintf(path, sizeof(path), "%s/%s%016" PRIx64 ".ny", dir, prefix,
+                   fnv1a64(data, len));
+  return n > 0 && (size_t)n < sizeof(path) && unlink(path) == 0;
+}
+
+static void front_selftest_check(str_buf_t *errors, bool ok, const char *what) {
+  if (ok) return;
+  if (errors->len) (void)sb_append_c(errors, ',');
+  (void)sb_append_json_str(errors, what);
+}
+
+/* Drives the fork server on fixed inputs: front-end result codes, feedback
+ * for new and repeated inputs, worker reuse up to --persist, and recovery
+ * from a worker that dies or stops answering. */
+static int front_cmd_selftest(int argc, char **argv) {
+  static front_state_t st;
+  if (!front_init(&st, argc, argv)) return 2;
+  static const char good[] = "fn main() {\n  mut x = 1\n  return x + 2\n}\n";
+  static const char bad[] = "fn main( {\n  return\n";
+  static const char other[] = "fn f(a, b) {\n  return [a, b]\n}\n";
+  char out_dir[4096];
+  snprintf(out_dir, sizeof(out_dir), "%s/selftest", st.out_dir);
+  st.out_dir = out_dir;
+  st.stage = FRONT_STAGE_TYPE;
+  st.timeout_ms = 300;
+  double start = now_ms();
+  str_buf_t errors = {0};
+  int rc = -1;
+
+  /* A fresh worker per input, so every run starts from the same state. */
+  st.persist = 1;
+  front_selftest_check(&errors, front_run(&st, good, sizeof(good) - 1, &rc) == FRONT_RUN_OK &&
+                                    rc == 0, "clean input");
+  front_selftest_check(&errors, front_merge(&st, st.virgin) > 0, "clean input feedback");
+  front_selftest_check(&errors, front_run(&st, good, sizeof(good) - 1, &rc) == FRONT_RUN_OK &&
+                                    front_merge(&st, st.virgin) == 0,
+                       "repeated input feedback");
+  front_selftest_check(&errors, front_run(&st, bad, sizeof(bad) - 1, &rc) == FRONT_RUN_OK &&
+                                    rc == 1, "rejected input");
+  front_selftest_check(&errors, front_merge(&st, st.virgin) > 0, "rejected input feedback");
+
+  st.persist = 3;
+  front_worker_stop(&st.worker, false);
+  pid_t first = 0;
+  bool reused = true;
+  for (int i = 0; i < 3; ++i) {
+    reused = reused && front_run(&st, other, sizeof(other) - 1, &rc) == FRONT_RUN_OK;
+    if (i == 0) first = st.worker.pid;
+    reused = reused && st.worker.pid == first;
+  }
+  front_selftest_check(&errors, reused, "worker reuse");
+  front_selftest_check(&errors, front_run(&st, other, sizeof(other) - 1, &rc) == FRONT_RUN_OK &&
+                                    st.worker.pid != first, "worker recycle");
+
+  /* A worker that dies mid-input is a crash, one that stops answering is a
+   * hang; either way the input is saved and the next run forks a new one. */
+  char sub[4096];
+  if (st.worker.pid > 0) kill(st.worker.pid, SIGKILL);
+  (void)front_try(&st, good, sizeof(good) - 1, false);
+  snprintf(sub, sizeof(sub), "%s/crashes", st.out_dir);
+  front_selftest_check(&errors, st.crashes == 1 && front_selftest_take(sub, "sig9-", good,
+                                                                       sizeof(good) - 1),
+                       "dead worker recorded");
+  front_selftest_check(&errors, front_run(&st, good, sizeof(good) - 1, &rc) == FRONT_RUN_OK &&
+                                    rc == 0, "worker replaced after crash");
+  if (st.worker.pid > 0) kill(st.worker.pid, SIGSTOP);
+  (void)front_try(&st, other, sizeof(other) - 1, false);
+  snprintf(sub, sizeof(sub), "%s/hangs", st.out_dir);
+  front_selftest_check(&errors, st.hangs == 1 && front_selftest_take(sub, "", other,
+                                                                     sizeof(other) - 1),
+                       "stopped worker recorded");
+  front_selftest_check(&errors, front_run(&st, good, sizeof(good) - 1, &rc) == FRONT_RUN_OK &&
+                                    rc == 0, "worker replaced after hang");
+
+  printf("{\"ok\":%s,\"engine\":\"nytrix_front\",\"command\":\"selftest\",\"coverage\":\"%s\","
+         "\"execs\":%" PRIu64 ",\"elapsed_ms\":%.1f,\"failed\":[%s]}\n",
+         errors.len ? "false" : "true", front_instrumented() ? FRONT_COVERAGE_NAME : "tokens",
+         st.execs, now_ms() - start, errors.data ? errors.data : "");
+  int status = errors.len ? 1 : 0;
+  free(errors.data);
+  front_finish(&st);
+  return status;
+}
+
+static void front_usage(FILE *out) {
+  fputs("{\"ok\":false,\"error\":\"usage\",\"engine\":\"nytrix_front\",\"commands\":["
+        "\"run [--corpus DIR] [--out DIR] [--shape-dir DIR] [--stage lex|parse|type] "
+        "[--runs N] [--seconds S] [--seeds N] [--synth-every N] [--persist N] "
+        "[--timeout-ms MS] [--max-len N] [--seed S] [--verbose]\","
+        "\"cmin --corpus DIR [--min-out DIR] [--stage lex|parse|type]\","
+        "\"replay <file.ny>... [--stage lex|parse|type]\","
+        "\"selftest [--out DIR]\"]}\n",
+        out);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    front_usage(stdout);
+    return 3;
+  }
+  if (strcmp(argv[1], "run") == 0) return front_cmd_run(argc, argv);
+  if (strcmp(argv[1], "cmin") == 0) return front_cmd_cmin(argc, argv);
+  if (strcmp(argv[1], "replay") == 0) return front_cmd_replay(argc, argv);
+  if (strcmp(argv[1], "selftest") == 0) return front_cmd_selftest(argc, argv);
+  front_usage(stdout);
+  return 3;
+}
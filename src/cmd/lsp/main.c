@@ -13,7 +13,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #ifndef _WIN32
+#include <pthread.h>
 #include <strings.h>
 #include <unistd.h>
 #endif
@@ -33,23 +35,43 @@ static ssize_t read_exact(int fd, void *buf, size_t len) {
   return (ssize_t)total;
 }
 
+/*
+ * stdin is drained through one buffer so header lines are scanned in place
+ * instead of costing a read(2) per byte.
+ */
+static char g_in_buf[64 * 1024];
+static size_t g_in_pos = 0;
+static size_t g_in_len = 0;
+
+static bool in_fill(void) {
+  if (g_in_pos < g_in_len)
+    return true;
+  ssize_t n = read(STDIN_FILENO, g_in_buf, sizeof(g_in_buf));
+  if (n <= 0)
+    return false;
+  g_in_pos = 0;
+  g_in_len = (size_t)n;
+  return true;
+}
+
 static ssize_t read_header_line(char *buf, size_t cap) {
   size_t idx = 0;
-  while (idx + 1 < cap) {
-    char c;
-    ssize_t n = read_exact(STDIN_FILENO, &c, 1);
-    if (n <= 0)
-      return -1;
-    if (c == '\r')
-      continue;
-    if (c == '\n') {
+  while (in_fill()) {
+    const char *start = g_in_buf + g_in_pos;
+    size_t avail = g_in_len - g_in_pos;
+    const char *nl = memchr(start, '\n', avail);
+    size_t take = nl ? (size_t)(nl - start) : avail;
+    for (size_t i = 0; i < take; ++i) {
+      if (start[i] != '\r' && idx + 1 < cap)
+        buf[idx++] = start[i];
+    }
+    g_in_pos += nl ? take + 1 : take;
+    if (nl) {
       buf[idx] = '\0';
       return (ssize_t)idx;
     }
-    buf[idx++] = c;
   }
-  buf[idx] = '\0';
-  return (ssize_t)idx;
+  return -1;
 }
 
 static char *read_message(void) {
@@ -71,7 +93,13 @@ static char *read_message(void) {
   char *body = malloc((size_t)content_len + 1);
   if (!body)
     return NULL;
-  if (read_exact(STDIN_FILENO, body, (size_t)content_len) <= 0) {
+  size_t have = g_in_len - g_in_pos;
+  if (have > (size_t)content_len)
+    have = (size_t)content_len;
+  memcpy(body, g_in_buf + g_in_pos, have);
+  g_in_pos += have;
+  size_t rest = (size_t)content_len - have;
+  if (rest && read_exact(STDIN_FILENO, body + have, rest) != (ssize_t)rest) {
     free(body);
     return NULL;
   }
@@ -114,6 +142,37 @@ static char *json_decode_string(const char *start, size_t len) {
       case 't':
         out[o++] = '\t';
         break;
+      case 'u': {
+        unsigned cp = 0;
+        if (i + 4 >= len || sscanf(start + i + 1, "%4x", &cp) != 1) {
+          out[o++] = esc;
+          break;
+        }
+        i += 4;
+        unsigned lo = 0;
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < len && start[i + 1] == '\\' &&
+            start[i + 2] == 'u' && sscanf(start + i + 3, "%4x", &lo) == 1 && lo >= 0xDC00 &&
+            lo < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+          i += 6;
+        }
+        if (cp < 0x80) {
+          out[o++] = (char)cp;
+        } else if (cp < 0x800) {
+          out[o++] = (char)(0xC0 | (cp >> 6));
+          out[o++] = (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+          out[o++] = (char)(0xE0 | (cp >> 12));
+          out[o++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+          out[o++] = (char)(0x80 | (cp & 0x3F));
+        } else {
+          out[o++] = (char)(0xF0 | (cp >> 18));
+          out[o++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+          out[o++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+          out[o++] = (char)(0x80 | (cp & 0x3F));
+        }
+        break;
+      }
       default:
         out[o++] = esc;
         break;
@@ -126,6 +185,45 @@ static char *json_decode_string(const char *start, size_t len) {
   return out;
 }
 
+/* p is at an opening quote; returns the position just past the closing one. */
+static const char *json_skip_string(const char *p) {
+  p++;
+  while (*p && *p != '"') {
+    if (*p == '\\' && p[1])
+      p += 2;
+    else
+      p++;
+  }
+  return *p ? p + 1 : p;
+}
+
+static const char *json_skip_value(const char *p) {
+  while (*p && isspace((unsigned char)*p))
+    p++;
+  if (*p == '"')
+    return json_skip_string(p);
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (*p) {
+      if (*p == '"') {
+        p = json_skip_string(p);
+        continue;
+      }
+      if (*p == '{' || *p == '[') {
+        depth++;
+      } else if (*p == '}' || *p == ']') {
+        if (--depth == 0)
+          return p + 1;
+      }
+      p++;
+    }
+    return p;
+  }
+  while (*p && *p != ',' && *p != '}' && *p != ']')
+    p++;
+  return p;
+}
+
 static char *json_extract_string(const char *json, const char *key) {
   if (!json || !key)
     return NULL;
@@ -142,8 +240,8 @@ static char *json_extract_string(const char *json, const char *key) {
     return NULL;
   const char *start = quote + 1;
   const char *end = start;
-  while (*end && (*end != '"' || *(end - 1) == '\\'))
-    end++;
+  while (*end && *end != '"')
+    end += (*end == '\\' && end[1]) ? 2 : 1;
   size_t len = (size_t)(end - start);
   return json_decode_string(start, len);
 }
@@ -318,6 +416,132 @@ static void sb_append_json(sbuf_t *b, const char *s) {
   sb_append(b, "\"");
 }
 
+#define LSP_INDEX_NONE UINT32_MAX
+
+typedef struct {
+  const char *key;
+  uint32_t id;
+} lsp_index_key_t;
+
+/*
+ * Name lookup over an array of borrowed symbol names: hash chains on the full
+ * and the tail name for definitions, and a tail-sorted array for completion
+ * prefixes. Chains run in id order, so a hit is the first match a linear scan
+ * would have found. Rebuilt whenever the names change.
+ */
+typedef struct {
+  const char **names;
+  uint32_t len;
+  uint32_t mask;
+  uint32_t *full_head;
+  uint32_t *tail_head;
+  uint32_t *full_next;
+  uint32_t *tail_next;
+  lsp_index_key_t *sorted;
+  uint32_t sorted_len;
+} lsp_name_index_t;
+
+static void name_index_free(lsp_name_index_t *ix) {
+  free(ix->names);
+  free(ix->full_head);
+  free(ix->tail_head);
+  free(ix->full_next);
+  free(ix->tail_next);
+  free(ix->sorted);
+  memset(ix, 0, sizeof(*ix));
+}
+
+static int index_key_cmp(const void *a, const void *b) {
+  const lsp_index_key_t *x = a, *y = b;
+  int c = strcmp(x->key, y->key);
+  if (c)
+    return c;
+  return x->id < y->id ? -1 : x->id > y->id;
+}
+
+/* Takes ownership of `names`; NULL entries are never found. */
+static bool name_index_build(lsp_name_index_t *ix, const char **names, size_t n) {
+  name_index_free(ix);
+  ix->names = names;
+  if (!n)
+    return true;
+  if (n >= LSP_INDEX_NONE / 2) {
+    name_index_free(ix);
+    return false;
+  }
+  uint32_t cap = 16;
+  while (cap < n * 2)
+    cap <<= 1;
+  ix->len = (uint32_t)n;
+  ix->mask = cap - 1;
+  ix->full_head = malloc(cap * sizeof(uint32_t));
+  ix->tail_head = malloc(cap * sizeof(uint32_t));
+  ix->full_next = malloc(n * sizeof(uint32_t));
+  ix->tail_next = malloc(n * sizeof(uint32_t));
+  ix->sorted = malloc(n * sizeof(lsp_index_key_t));
+  if (!ix->full_head || !ix->tail_head || !ix->full_next || !ix->tail_next || !ix->sorted) {
+    name_index_free(ix);
+    return false;
+  }
+  memset(ix->full_head, 0xff, cap * sizeof(uint32_t));
+  memset(ix->tail_head, 0xff, cap * sizeof(uint32_t));
+  for (uint32_t i = ix->len; i-- > 0;) {
+    ix->full_next[i] = ix->tail_next[i] = LSP_INDEX_NONE;
+    if (!names[i])
+      continue;
+    const char *tail = ny_tail_name(names[i]);
+    uint32_t f = (uint32_t)ny_hash64_cstr(names[i]) & ix->mask;
+    uint32_t t = (uint32_t)ny_hash64_cstr(tail) & ix->mask;
+    ix->full_next[i] = ix->full_head[f];
+    ix->full_head[f] = i;
+    ix->tail_next[i] = ix->tail_head[t];
+    ix->tail_head[t] = i;
+  }
+  for (uint32_t i = 0; i < ix->len; ++i) {
+    if (names[i])
+      ix->sorted[ix->sorted_len++] = (lsp_index_key_t){ny_tail_name(names[i]), i};
+  }
+  qsort(ix->sorted, ix->sorted_len, sizeof(*ix->sorted), index_key_cmp);
+  return true;
+}
+
+/* First exact match on the full name; with `tail`, else the first tail-name match. */
+static uint32_t name_index_find(const lsp_name_index_t *ix, const char *word, bool tail) {
+  if (!ix->len || !word || !*word)
+    return LSP_INDEX_NONE;
+  uint32_t h = (uint32_t)ny_hash64_cstr(word) & ix->mask;
+  for (uint32_t i = ix->full_head[h]; i != LSP_INDEX_NONE; i = ix->full_next[i]) {
+    if (strcmp(ix->names[i], word) == 0)
+      return i;
+  }
+  if (!tail)
+    return LSP_INDEX_NONE;
+  const char *short_word = ny_tail_name(word);
+  h = (uint32_t)ny_hash64_cstr(short_word) & ix->mask;
+  for (uint32_t i = ix->tail_head[h]; i != LSP_INDEX_NONE; i = ix->tail_next[i]) {
+    if (strcmp(ny_tail_name(ix->names[i]), short_word) == 0)
+      return i;
+  }
+  return LSP_INDEX_NONE;
+}
+
+/* Range [*lo, return) of ix->sorted whose tail names start with `prefix`. */
+static uint32_t name_index_prefix(const lsp_name_index_t *ix, const char *prefix, uint32_t *lo) {
+  size_t plen = strlen(prefix);
+  uint32_t a = 0, b = ix->sorted_len;
+  while (a < b) {
+    uint32_t mid = a + (b - a) / 2;
+    if (strcmp(ix->sorted[mid].key, prefix) < 0)
+      a = mid + 1;
+    else
+      b = mid;
+  }
+  *lo = a;
+  while (b < ix->sorted_len && strncmp(ix->sorted[b].key, prefix, plen) == 0)
+    b++;
+  return b;
+}
+
 typedef struct {
   char *name;
   char *detail;
@@ -330,14 +554,6 @@ typedef struct {
   int end_col;
 } lsp_symbol_t;
 
-typedef struct {
-  char *uri;
-  char *text;
-  lsp_symbol_t *symbols;
-  size_t symbols_len;
-  size_t symbols_cap;
-} lsp_doc_t;
-
 typedef struct {
   int line;
   int col;
@@ -356,6 +572,56 @@ typedef struct {
   size_t cap;
 } lsp_diag_vec_t;
 
+/* Running count and first position of one document-wide style pattern. */
+typedef struct {
+  int count;
+  int line;
+  int col;
+} lsp_hint_tally_t;
+
+typedef struct {
+  lsp_hint_tally_t dict_lookup;
+  lsp_hint_tally_t layout_probe;
+  lsp_hint_tally_t parser_emit;
+  lsp_hint_tally_t alloc;
+} lsp_style_tally_t;
+
+/*
+ * One top-level statement of an open document. Edits re-lex from the span
+ * before the change and reparse spans until the old boundaries line up again;
+ * the rest only have their offsets and lines shifted.
+ */
+typedef struct {
+  size_t start;
+  size_t len;
+  int line;
+  bool opens_module;
+  char *module; /* file-level module that governs the spans after this one */
+  size_t symbols_len; /* this span's run in doc->symbols */
+  lsp_diag_t err; /* parse error; message is NULL when the span is clean */
+  lsp_diag_vec_t hints; /* per-line style hints */
+  lsp_style_tally_t tally;
+} lsp_chunk_t;
+
+typedef struct {
+  char *uri;
+  char *text;
+  size_t text_len;
+  size_t text_cap;
+  size_t *line_starts;
+  size_t lines_len;
+  size_t lines_cap;
+  lsp_chunk_t *chunks;
+  size_t chunks_len;
+  bool whole; /* comptime code spans statements: parse as one unit */
+  lsp_symbol_t *symbols;
+  size_t symbols_len;
+  size_t symbols_cap;
+  lsp_name_index_t index;
+  bool index_dirty;
+} lsp_doc_t;
+
+
 static lsp_doc_t *g_docs = NULL;
 static size_t g_docs_len = 0;
 static size_t g_docs_cap = 0;
@@ -364,11 +630,35 @@ static size_t g_stdlib_symbols_len = 0;
 static size_t g_stdlib_symbols_cap = 0;
 static bool g_stdlib_loaded = false;
 static lsp_symbol_t g_stdlib_symbol_hit = {0};
+static lsp_name_index_t g_stdlib_index = {0};
+#ifndef _WIN32
+/* The std index loads on a worker; parsing touches process-wide parser state. */
+static pthread_mutex_t g_parse_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t g_stdlib_thread;
+static bool g_stdlib_thread_live = false;
+#endif
 
 static void doc_rebuild_symbols(lsp_doc_t *doc);
+static void doc_rebuild_chunks(lsp_doc_t *doc);
+static void stdlib_index_join(void);
+static void analyze_style_lines(const char *text, size_t len, int first_line, lsp_diag_vec_t *out,
+                                lsp_style_tally_t *tally);
+static void style_tally_init(lsp_style_tally_t *t);
 static void append_range(sbuf_t *b, int line, int col, int end_line, int end_col);
 static bool symbol_name_matches(const lsp_symbol_t *s, const char *word);
 
+static void parse_lock(void) {
+#ifndef _WIN32
+  pthread_mutex_lock(&g_parse_lock);
+#endif
+}
+
+static void parse_unlock(void) {
+#ifndef _WIN32
+  pthread_mutex_unlock(&g_parse_lock);
+#endif
+}
+
 static void diag_free(lsp_diag_t *d) {
   if (!d)
     return;
@@ -464,6 +754,34 @@ static void doc_clear_symbols(lsp_doc_t *doc) {
   doc->symbols = NULL;
   doc->symbols_len = 0;
   doc->symbols_cap = 0;
+  doc->index_dirty = true;
+}
+
+static void doc_clear_chunks(lsp_doc_t *doc) {
+  if (!doc)
+    return;
+  for (size_t i = 0; i < doc->chunks_len; ++i) {
+    free(doc->chunks[i].module);
+    diag_free(&doc->chunks[i].err);
+    diag_vec_free(&doc->chunks[i].hints);
+  }
+  free(doc->chunks);
+  doc->chunks = NULL;
+  doc->chunks_len = 0;
+}
+
+static void doc_release(lsp_doc_t *doc) {
+  free(doc->text);
+  free(doc->line_starts);
+  doc->text = NULL;
+  doc->text_len = 0;
+  doc->text_cap = 0;
+  doc->line_starts = NULL;
+  doc->lines_len = 0;
+  doc->lines_cap = 0;
+  doc_clear_chunks(doc);
+  doc_clear_symbols(doc);
+  name_index_free(&doc->index);
 }
 
 static void doc_add_symbol(lsp_doc_t *doc, const char *name, const char *detail, const char *docstr,
@@ -480,6 +798,7 @@ static void doc_add_symbol(lsp_doc_t *doc, const char *name, const char *detail,
     doc->symbols_cap = nc;
   }
   lsp_symbol_t *s = &doc->symbols[doc->symbols_len++];
+  doc->index_dirty = true;
   s->name = ny_strdup(name);
   s->detail = detail ? ny_strdup(detail) : ny_strdup(name);
   s->doc = docstr ? ny_strdup(docstr) : NULL;
@@ -535,12 +854,18 @@ static void doc_put(const char *uri, const char *text) {
     doc->uri = ny_strdup(uri);
     doc->text = NULL;
   }
-  char *copy = ny_strdup(text);
+  size_t len = strlen(text);
+  if (doc->text && doc->text_len == len && memcmp(doc->text, text, len) == 0)
+    return;
+  char *copy = malloc(len + 1);
   if (!copy)
     return;
+  memcpy(copy, text, len + 1);
   free(doc->text);
   doc->text = copy;
-  doc_rebuild_symbols(doc);
+  doc->text_len = len;
+  doc->text_cap = len + 1;
+  doc_rebuild_chunks(doc);
 }
 
 static void doc_remove(const char *uri) {
@@ -549,8 +874,7 @@ static void doc_remove(const char *uri) {
   for (size_t i = 0; i < g_docs_len; ++i) {
     if (g_docs[i].uri && strcmp(g_docs[i].uri, uri) == 0) {
       free(g_docs[i].uri);
-      free(g_docs[i].text);
-      doc_clear_symbols(&g_docs[i]);
+      doc_release(&g_docs[i]);
       g_docs[i] = g_docs[g_docs_len - 1];
       g_docs_len--;
       return;
@@ -558,23 +882,28 @@ static void doc_remove(const char *uri) {
   }
 }
 
+static void stdlib_symbols_reset(void) {
+  for (size_t i = 0; i < g_stdlib_symbols_len; ++i)
+    symbol_free(&g_stdlib_symbols[i]);
+  free(g_stdlib_symbols);
+  g_stdlib_symbols = NULL;
+  g_stdlib_symbols_len = 0;
+  g_stdlib_symbols_cap = 0;
+}
+
 static void doc_clear_all(void) {
+  stdlib_index_join();
   for (size_t i = 0; i < g_docs_len; ++i) {
     free(g_docs[i].uri);
-    free(g_docs[i].text);
-    doc_clear_symbols(&g_docs[i]);
+    doc_release(&g_docs[i]);
   }
   symbol_free(&g_stdlib_symbol_hit);
   free(g_docs);
   g_docs = NULL;
   g_docs_len = 0;
   g_docs_cap = 0;
-  for (size_t i = 0; i < g_stdlib_symbols_len; ++i)
-    symbol_free(&g_stdlib_symbols[i]);
-  free(g_stdlib_symbols);
-  g_stdlib_symbols = NULL;
-  g_stdlib_symbols_len = 0;
-  g_stdlib_symbols_cap = 0;
+  stdlib_symbols_reset();
+  name_index_free(&g_stdlib_index);
   g_stdlib_loaded = false;
   symbol_free(&g_stdlib_symbol_hit);
 }
@@ -822,12 +1151,542 @@ static void doc_rebuild_symbols(lsp_doc_t *doc) {
   doc_clear_symbols(doc);
   if (!doc->text)
     return;
+  parse_lock();
+  parser_global_cleanup();
   parser_t parser;
   parser_init_quiet(&parser, doc->text, "<lsp>");
   parser.error_limit = 0;
   program_t prog = parse_program(&parser);
   collect_stmt_symbols(doc, &prog.body);
   program_free(&prog, parser.arena);
+  parse_unlock();
+}
+
+static bool doc_lines_reserve(lsp_doc_t *doc, size_t need) {
+  if (need <= doc->lines_cap)
+    return true;
+  size_t nc = doc->lines_cap ? doc->lines_cap : 256;
+  while (nc < need)
+    nc *= 2;
+  size_t *next = realloc(doc->line_starts, nc * sizeof(*next));
+  if (!next)
+    return false;
+  doc->line_starts = next;
+  doc->lines_cap = nc;
+  return true;
+}
+
+static void doc_index_lines(lsp_doc_t *doc) {
+  doc->lines_len = 0;
+  if (!doc_lines_reserve(doc, 1))
+    return;
+  doc->line_starts[doc->lines_len++] = 0;
+  const char *end = doc->text + doc->text_len;
+  for (const char *p = doc->text; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; ++p) {
+    if (!doc_lines_reserve(doc, doc->lines_len + 1))
+      return;
+    doc->line_starts[doc->lines_len++] = (size_t)(p - doc->text) + 1;
+  }
+}
+
+static size_t doc_line_of(const lsp_doc_t *doc, size_t off) {
+  size_t lo = 0, hi = doc->lines_len;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (doc->line_starts[mid] <= off)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Byte offset of an LSP position; `character` counts UTF-16 code units. */
+static size_t doc_pos_offset(const lsp_doc_t *doc, int line, int character) {
+  if (line < 0 || doc->lines_len == 0)
+    return 0;
+  if ((size_t)line >= doc->lines_len)
+    return doc->text_len;
+  size_t off = doc->line_starts[line];
+  size_t end = (size_t)line + 1 < doc->lines_len ? doc->line_starts[line + 1] - 1 : doc->text_len;
+  int units = 0;
+  while (off < end && units < character) {
+    unsigned char c = (unsigned char)doc->text[off];
+    size_t width = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 1;
+    units += width == 4 ? 2 : 1;
+    off += width;
+  }
+  return off < end ? off : end;
+}
+
+/* Replaces text[lo, hi) with ins and patches the line index in place. */
+static bool doc_splice(lsp_doc_t *doc, size_t lo, size_t hi, const char *ins, size_t ins_len,
+                       int *line_delta) {
+  size_t tail = doc->text_len - hi;
+  size_t need = lo + ins_len + tail + 1;
+  if (need > doc->text_cap) {
+    size_t nc = doc->text_cap ? doc->text_cap : 4096;
+    while (nc < need)
+      nc *= 2;
+    char *next = realloc(doc->text, nc);
+    if (!next)
+      return false;
+    doc->text = next;
+    doc->text_cap = nc;
+  }
+  size_t added = 0;
+  for (size_t i = 0; i < ins_len; ++i)
+    added += ins[i] == '\n';
+  size_t first = doc_line_of(doc, lo) + 1;
+  size_t last = doc_line_of(doc, hi) + 1;
+  size_t lines = doc->lines_len - (last - first) + added;
+  if (!doc_lines_reserve(doc, lines))
+    return false;
+  memmove(doc->text + lo + ins_len, doc->text + hi, tail + 1);
+  memcpy(doc->text + lo, ins, ins_len);
+  doc->text_len = lo + ins_len + tail;
+  size_t delta = ins_len - (hi - lo);
+  memmove(&doc->line_starts[first + added], &doc->line_starts[last],
+          (doc->lines_len - last) * sizeof(*doc->line_starts));
+  for (size_t k = first + added; k < lines; ++k)
+    doc->line_starts[k] += delta;
+  size_t at = first;
+  for (size_t i = 0; i < ins_len; ++i) {
+    if (ins[i] == '\n')
+      doc->line_starts[at++] = lo + i + 1;
+  }
+  doc->lines_len = lines;
+  *line_delta = (int)added - (int)(last - first);
+  return true;
+}
+
+typedef struct {
+  lsp_chunk_t *items;
+  size_t len;
+  size_t cap;
+} lsp_chunk_vec_t;
+
+static bool chunk_vec_push(lsp_chunk_vec_t *v, size_t start, size_t end, int line,
+                           bool opens_module) {
+  if (v->len == v->cap) {
+    size_t nc = v->cap ? v->cap * 2 : 64;
+    lsp_chunk_t *next = realloc(v->items, nc * sizeof(*next));
+    if (!next)
+      return false;
+    v->items = next;
+    v->cap = nc;
+  }
+  lsp_chunk_t *c = &v->items[v->len++];
+  memset(c, 0, sizeof(*c));
+  c->start = start;
+  c->len = end - start;
+  c->line = line;
+  c->opens_module = opens_module;
+  style_tally_init(&c->tally);
+  return true;
+}
+
+static void chunk_vec_free(lsp_chunk_vec_t *v) {
+  for (size_t i = 0; i < v->len; ++i) {
+    free(v->items[i].module);
+    diag_free(&v->items[i].err);
+    diag_vec_free(&v->items[i].hints);
+  }
+  free(v->items);
+  memset(v, 0, sizeof(*v));
+}
+
+static size_t chunk_index_at(const lsp_doc_t *doc, size_t off) {
+  size_t lo = 0, hi = doc->chunks_len;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (doc->chunks[mid].start <= off)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static bool chunk_token_starts(token_kind k) {
+  switch (k) {
+  case NY_T_ELSE:
+  case NY_T_ELIF:
+  case NY_T_CATCH:
+  case NY_T_IN:
+  case NY_T_AS:
+    return false;
+  case NY_T_AT:
+  case NY_T_HASH:
+    return true;
+  default:
+    return k >= NY_T_IDENT && k <= NY_T_ENUM;
+  }
+}
+
+/* A line ending in one of these continues the statement on the next line. */
+static bool chunk_token_continues(token_kind k) {
+  return (k >= NY_T_PLUS && k <= NY_T_BITNOT) || k == NY_T_COMMA || k == NY_T_COLON ||
+         k == NY_T_DOT || k == NY_T_RANGE || k == NY_T_QUESTION || k == NY_T_PIPE ||
+         k == NY_T_QUESTION_QUESTION || k == NY_T_QUESTION_DOT;
+}
+
+/* '#endif', '#else' and '#elif' close the guard before them, never start a span. */
+static bool chunk_hash_continues(const lexer_t *lx) {
+  lexer_t peek = *lx;
+  token_t t = lexer_next(&peek);
+  if (t.kind == NY_T_ELSE || t.kind == NY_T_ELIF)
+    return true;
+  return t.kind == NY_T_IDENT && t.len == 5 && memcmp(t.lexeme, "endif", 5) == 0;
+}
+
+/*
+ * Splits text[from..] into top-level statements: a span starts at a token in
+ * column one, at bracket depth zero, outside '#if' regions, that neither
+ * follows a decorator line nor continues the previous line. Once a span start
+ * at or past `sync_from` lands on an old span start shifted by `delta`, the
+ * rest of the old spans are still valid: *sync_idx gets that span's index.
+ */
+static bool doc_scan_chunks(const lsp_doc_t *doc, size_t from, size_t sync_from, ptrdiff_t delta,
+                            size_t *sync_idx, lsp_chunk_vec_t *out, bool *comptime) {
+  lexer_t lx;
+  lexer_init(&lx, doc->text + from, "<lsp>");
+  lx.quiet = true;
+  lx.intern_identifiers = false;
+  int depth = 0, cond = 0;
+  bool any = false, glue = false, after_hash = false, cur_module = false;
+  token_kind last = NY_T_EOF;
+  size_t cur = from;
+  *sync_idx = doc->chunks_len;
+  for (;;) {
+    token_t t = lexer_next(&lx);
+    if (t.kind == NY_T_EOF)
+      break;
+    size_t off = (size_t)(t.lexeme - doc->text);
+    bool bol = off == 0 || doc->text[off - 1] == '\n';
+    if (bol && depth == 0) {
+      if (any && cond == 0 && !glue && !chunk_token_continues(last) &&
+          chunk_token_starts(t.kind) && !(t.kind == NY_T_HASH && chunk_hash_continues(&lx))) {
+        if (!chunk_vec_push(out, cur, off, (int)doc_line_of(doc, cur), cur_module))
+          return false;
+        if (off >= sync_from && doc->chunks_len) {
+          size_t old = (size_t)((ptrdiff_t)off - delta);
+          size_t j = chunk_index_at(doc, old);
+          if (doc->chunks[j].start == old) {
+            *sync_idx = j;
+            return true;
+          }
+        }
+        cur = off;
+        cur_module = t.kind == NY_T_MODULE;
+      }
+      glue = t.kind == NY_T_AT;
+    }
+    if (!any) {
+      any = true;
+      cur_module = t.kind == NY_T_MODULE;
+    }
+    if (after_hash) {
+      if (t.kind == NY_T_IF)
+        cond++;
+      else if (t.kind == NY_T_IDENT && t.len == 5 && memcmp(t.lexeme, "endif", 5) == 0 && cond > 0)
+        cond--;
+    }
+    after_hash = bol && t.kind == NY_T_HASH;
+    switch (t.kind) {
+    case NY_T_LPAREN:
+    case NY_T_LBRACE:
+    case NY_T_LBRACK:
+      depth++;
+      break;
+    case NY_T_RPAREN:
+    case NY_T_RBRACE:
+    case NY_T_RBRACK:
+      if (depth > 0)
+        depth--;
+      break;
+    case NY_T_COMPTIME:
+      *comptime = true;
+      break;
+    default:
+      break;
+    }
+    last = t.kind;
+  }
+  return chunk_vec_push(out, cur, doc->text_len, (int)doc_line_of(doc, cur), cur_module);
+}
+
+/* A module without its own braces keeps naming the statements that follow it. */
+static bool chunk_module_is_file_level(const stmt_t *s) {
+  const char *end = s->as.module.src_end;
+  if (!end || end == s->as.module.src_start || end[-1] != '}')
+    return true;
+  if (s->as.module.body.len == 0)
+    return false;
+  for (size_t i = 0; i < s->as.module.body.len; ++i) {
+    if (!s->as.module.body.data[i] || s->as.module.body.data[i]->kind != NY_S_EXPORT)
+      return false;
+  }
+  return true;
+}
+
+static void chunk_parse(lsp_doc_t *sink, lsp_chunk_t *c, const char *text, const char *module) {
+  char *src = malloc(c->len + 1);
+  if (!src)
+    return;
+  memcpy(src, text + c->start, c->len);
+  src[c->len] = '\0';
+  /* The parser dedups repeated errors process-wide; a server reparses the same text. */
+  parse_lock();
+  parser_global_cleanup();
+  parser_t parser;
+  parser_init_quiet(&parser, src, "<lsp>");
+  parser.error_limit = 0;
+  parser.current_module = (char *)module;
+  program_t prog = parse_program(&parser);
+  size_t first = sink->symbols_len;
+  collect_stmt_symbols(sink, &prog.body);
+  for (size_t i = first; i < sink->symbols_len; ++i) {
+    sink->symbols[i].line += c->line;
+    sink->symbols[i].end_line += c->line;
+  }
+  c->symbols_len = sink->symbols_len - first;
+  free(c->module);
+  c->module = NULL;
+  stmt_t *head = prog.body.len ? prog.body.data[0] : NULL;
+  if (c->opens_module && head && head->kind == NY_S_MODULE && head->as.module.name &&
+      chunk_module_is_file_level(head))
+    c->module = ny_strdup(head->as.module.name);
+  diag_free(&c->err);
+  if (parser.error_count > 0) {
+    c->err.line = c->line + (parser.last_error_line > 0 ? parser.last_error_line - 1 : 0);
+    c->err.col = parser.last_error_col > 0 ? parser.last_error_col - 1 : 0;
+    c->err.end_line = c->err.line;
+    c->err.end_col = parser.last_error_end_col > 0 ? parser.last_error_end_col - 1 : c->err.col + 1;
+    c->err.message = ny_strdup(parser.last_error_msg[0] ? parser.last_error_msg : "parse error");
+    c->err.hint = parser.last_error_hint[0] ? ny_strdup(parser.last_error_hint) : NULL;
+  }
+  program_free(&prog, parser.arena);
+  parse_unlock();
+  diag_vec_free(&c->hints);
+  style_tally_init(&c->tally);
+  analyze_style_lines(src, c->len, c->line, &c->hints, &c->tally);
+  free(src);
+}
+
+static const char *doc_module_before(const lsp_doc_t *doc, size_t idx) {
+  while (idx-- > 0) {
+    if (doc->chunks[idx].opens_module)
+      return doc->chunks[idx].module;
+  }
+  return NULL;
+}
+
+/* File-level module symbols span every statement up to the next module. */
+static void doc_fix_module_ranges(lsp_doc_t *doc) {
+  size_t sym = 0;
+  for (size_t i = 0; i < doc->chunks_len; ++i) {
+    const lsp_chunk_t *c = &doc->chunks[i];
+    if (c->module && c->symbols_len && doc->symbols[sym].kind == LSP_SK_MODULE) {
+      size_t k = i + 1;
+      while (k < doc->chunks_len && !doc->chunks[k].opens_module)
+        k++;
+      if (k > i + 1) {
+        const lsp_chunk_t *end = &doc->chunks[k - 1];
+        doc->symbols[sym].end_line = (int)doc_line_of(doc, end->start + (end->len ? end->len - 1 : 0));
+      }
+    }
+    sym += c->symbols_len;
+  }
+}
+
+static void doc_rebuild_chunks(lsp_doc_t *doc) {
+  if (!doc)
+    return;
+  doc_clear_chunks(doc);
+  doc_clear_symbols(doc);
+  doc->whole = false;
+  if (!doc->text)
+    return;
+  doc_index_lines(doc);
+  lsp_chunk_vec_t fresh = {0};
+  bool comptime = false;
+  size_t sync = 0;
+  if (!doc_scan_chunks(doc, 0, SIZE_MAX, 0, &sync, &fresh, &comptime) || comptime) {
+    fresh.len = 0;
+    doc->whole = true;
+    if (!chunk_vec_push(&fresh, 0, doc->text_len, 0, false)) {
+      chunk_vec_free(&fresh);
+      return;
+    }
+  }
+  const char *module = NULL;
+  for (size_t i = 0; i < fresh.len; ++i) {
+    chunk_parse(doc, &fresh.items[i], doc->text, module);
+    if (fresh.items[i].opens_module)
+      module = fresh.items[i].module;
+  }
+  doc->chunks = fresh.items;
+  doc->chunks_len = fresh.len;
+  doc_fix_module_ranges(doc);
+}
+
+/*
+ * Reparses after text[lo, old_hi) became text[lo, new_hi). Only the spans from
+ * the one before the edit up to the first unchanged boundary are parsed again.
+ */
+static void doc_reparse(lsp_doc_t *doc, size_t lo, size_t old_hi, size_t new_hi, int line_delta) {
+  if (doc->whole || doc->chunks_len == 0) {
+    doc_rebuild_chunks(doc);
+    return;
+  }
+  size_t a = chunk_index_at(doc, lo);
+  if (a > 0)
+    a--;
+  ptrdiff_t delta = (ptrdiff_t)new_hi - (ptrdiff_t)old_hi;
+  lsp_chunk_vec_t fresh = {0};
+  bool comptime = false;
+  size_t b = doc->chunks_len;
+  bool redo = !doc_scan_chunks(doc, doc->chunks[a].start, new_hi, delta, &b, &fresh, &comptime) ||
+              comptime;
+  for (size_t i = a; i < b && !redo; ++i)
+    redo = doc->chunks[i].opens_module;
+  for (size_t i = 0; i < fresh.len && !redo; ++i)
+    redo = fresh.items[i].opens_module;
+  size_t chunks_need = doc->chunks_len - (b - a) + fresh.len;
+  if (!redo && chunks_need > doc->chunks_len) {
+    lsp_chunk_t *next = realloc(doc->chunks, chunks_need * sizeof(*next));
+    redo = next == NULL;
+    if (next)
+      doc->chunks = next;
+  }
+  if (redo) {
+    chunk_vec_free(&fresh);
+    doc_rebuild_chunks(doc);
+    return;
+  }
+
+  lsp_doc_t sink = {0};
+  sink.uri = doc->uri;
+  const char *module = doc_module_before(doc, a);
+  for (size_t i = 0; i < fresh.len; ++i)
+    chunk_parse(&sink, &fresh.items[i], doc->text, module);
+
+  size_t pre = 0, mid = 0;
+  for (size_t i = 0; i < a; ++i)
+    pre += doc->chunks[i].symbols_len;
+  for (size_t i = a; i < b; ++i)
+    mid += doc->chunks[i].symbols_len;
+  size_t tail = doc->symbols_len - pre - mid;
+  size_t syms_need = pre + sink.symbols_len + tail;
+  if (syms_need > doc->symbols_cap) {
+    lsp_symbol_t *next = realloc(doc->symbols, syms_need * sizeof(*next));
+    if (!next) {
+      doc_clear_symbols(&sink);
+      chunk_vec_free(&fresh);
+      doc_rebuild_chunks(doc);
+      return;
+    }
+    doc->symbols = next;
+    doc->symbols_cap = syms_need;
+  }
+  for (size_t k = pre; k < pre + mid; ++k)
+    symbol_free(&doc->symbols[k]);
+  memmove(&doc->symbols[pre + sink.symbols_len], &doc->symbols[pre + mid],
+          tail * sizeof(*doc->symbols));
+  for (size_t k = pre + sink.symbols_len; k < syms_need; ++k) {
+    doc->symbols[k].line += line_delta;
+    doc->symbols[k].end_line += line_delta;
+  }
+  if (sink.symbols_len)
+    memcpy(&doc->symbols[pre], sink.symbols, sink.symbols_len * sizeof(*doc->symbols));
+  free(sink.symbols);
+  doc->symbols_len = syms_need;
+  doc->index_dirty = true;
+
+  for (size_t i = a; i < b; ++i) {
+    free(doc->chunks[i].module);
+    diag_free(&doc->chunks[i].err);
+    diag_vec_free(&doc->chunks[i].hints);
+  }
+  size_t ctail = doc->chunks_len - b;
+  memmove(&doc->chunks[a + fresh.len], &doc->chunks[b], ctail * sizeof(*doc->chunks));
+  for (size_t k = a + fresh.len; k < chunks_need; ++k) {
+    lsp_chunk_t *c = &doc->chunks[k];
+    c->start = (size_t)((ptrdiff_t)c->start + delta);
+    c->line += line_delta;
+    c->err.line += line_delta;
+    c->err.end_line += line_delta;
+    for (size_t h = 0; h < c->hints.len; ++h) {
+      c->hints.items[h].line += line_delta;
+      c->hints.items[h].end_line += line_delta;
+    }
+    lsp_hint_tally_t *tallies[] = {&c->tally.dict_lookup, &c->tally.layout_probe,
+                                   &c->tally.parser_emit, &c->tally.alloc};
+    for (size_t t = 0; t < sizeof(tallies) / sizeof(tallies[0]); ++t) {
+      if (tallies[t]->line >= 0)
+        tallies[t]->line += line_delta;
+    }
+  }
+  if (fresh.len)
+    memcpy(&doc->chunks[a], fresh.items, fresh.len * sizeof(*doc->chunks));
+  free(fresh.items);
+  doc->chunks_len = chunks_need;
+  doc_fix_module_ranges(doc);
+}
+
+static void doc_edit(lsp_doc_t *doc, int line, int col, int end_line, int end_col,
+                     const char *text) {
+  if (!doc || !doc->text || !text)
+    return;
+  size_t lo = doc_pos_offset(doc, line, col);
+  size_t hi = doc_pos_offset(doc, end_line, end_col);
+  if (hi < lo) {
+    size_t t = lo;
+    lo = hi;
+    hi = t;
+  }
+  size_t n = strlen(text);
+  int line_delta = 0;
+  if (doc_splice(doc, lo, hi, text, n, &line_delta))
+    doc_reparse(doc, lo, hi, lo + n, line_delta);
+}
+
+/* Applies a didChange "contentChanges" array: ranged edits in order, or full text. */
+static void doc_apply_changes(lsp_doc_t *doc, const char *changes) {
+  const char *p = changes ? strchr(changes, '[') : NULL;
+  if (!doc || !p)
+    return;
+  p++;
+  while (*p) {
+    while (*p && (isspace((unsigned char)*p) || *p == ','))
+      p++;
+    if (!*p || *p == ']')
+      break;
+    const char *end = json_skip_value(p);
+    if (*p == '{') {
+      size_t n = (size_t)(end - p);
+      char *obj = malloc(n + 1);
+      if (!obj)
+        return;
+      memcpy(obj, p, n);
+      obj[n] = '\0';
+      char *text = json_extract_string(obj, "text");
+      int line = 0, col = 0, end_line = 0, end_col = 0;
+      if (text && strstr(obj, "\"range\"") &&
+          json_extract_int_near(obj, "\"start\"", "line", &line) &&
+          json_extract_int_near(obj, "\"start\"", "character", &col) &&
+          json_extract_int_near(obj, "\"end\"", "line", &end_line) &&
+          json_extract_int_near(obj, "\"end\"", "character", &end_col)) {
+        doc_edit(doc, line, col, end_line, end_col, text);
+      } else if (text) {
+        doc_put(doc->uri, text);
+      }
+      free(text);
+      free(obj);
+    }
+    p = end;
+  }
 }
 
 static void stdlib_symbol_hit_set(const lsp_symbol_t *src) {
@@ -851,11 +1710,7 @@ static void stdlib_symbol_push(const lsp_symbol_t *src) {
   symbol_copy(&g_stdlib_symbols[g_stdlib_symbols_len++], src);
 }
 
-static void stdlib_index_ensure(void) {
-  if (g_stdlib_loaded) {
-    return;
-  }
-  g_stdlib_loaded = true;
+static void stdlib_index_parse(void) {
   for (size_t i = 0; i < ny_std_module_count(); ++i) {
     const char *mod_path = ny_std_module_path(i);
     if (!mod_path || !*mod_path) {
@@ -867,22 +1722,247 @@ static void stdlib_index_ensure(void) {
     } else {
       ny_join_path(full, sizeof(full), ny_src_root(), mod_path);
     }
-    char *text = ny_read_file(full);
-    if (!text) {
+    ny_file_view_t text;
+    if (!ny_file_view_open(&text, full, 0, SIZE_MAX, 0)) {
       continue;
     }
     char *uri = path_to_file_uri(full);
     lsp_doc_t doc = {0};
     doc.uri = uri;
-    doc.text = text;
+    doc.text = text.data;
     doc_rebuild_symbols(&doc);
     for (size_t j = 0; j < doc.symbols_len; ++j) {
       stdlib_symbol_push(&doc.symbols[j]);
     }
     doc_clear_symbols(&doc);
     free(uri);
-    free(text);
+    ny_file_view_close(&text);
+  }
+}
+
+/*
+ * The std symbol table is cached under the cache root, keyed by the std source
+ * fingerprint and source root, so a new session skips reparsing the library.
+ */
+#define LSP_STD_CACHE_MAGIC "NYLSPSY1"
+
+static bool stdlib_cache_path(char *out, size_t cap, uint64_t key) {
+  const char *root = ny_default_cache_root_dir();
+  if (!root || !*root)
+    return false;
+  char dir[PATH_MAX];
+  int n = snprintf(dir, sizeof(dir), "%s/lsp", root);
+  if (n < 0 || (size_t)n >= sizeof(dir))
+    return false;
+  /* A truncated name could alias another key's cache file; skip caching. */
+  n = snprintf(out, cap, "%s/std_symbols_%016llx.bin", dir, (unsigned long long)key);
+  if (n < 0 || (size_t)n >= cap)
+    return false;
+  ny_ensure_dir_recursive(dir);
+  return true;
+}
+
+static void cache_put_u32(sbuf_t *b, uint32_t v) {
+  const char raw[4] = {(char)(v & 0xff), (char)((v >> 8) & 0xff), (char)((v >> 16) & 0xff),
+                       (char)((v >> 24) & 0xff)};
+  sb_append_n(b, raw, sizeof(raw));
+}
+
+static void cache_put_str(sbuf_t *b, const char *s) {
+  if (!s) {
+    cache_put_u32(b, UINT32_MAX);
+    return;
+  }
+  size_t n = strlen(s);
+  cache_put_u32(b, (uint32_t)n);
+  sb_append_n(b, s, n);
+}
+
+typedef struct {
+  const unsigned char *p;
+  const unsigned char *end;
+  bool ok;
+} lsp_cache_reader_t;
+
+static uint32_t cache_get_u32(lsp_cache_reader_t *r) {
+  if (!r->ok || r->end - r->p < 4) {
+    r->ok = false;
+    return 0;
+  }
+  uint32_t v = (uint32_t)r->p[0] | ((uint32_t)r->p[1] << 8) | ((uint32_t)r->p[2] << 16) |
+               ((uint32_t)r->p[3] << 24);
+  r->p += 4;
+  return v;
+}
+
+static char *cache_get_str(lsp_cache_reader_t *r) {
+  uint32_t n = cache_get_u32(r);
+  if (!r->ok || n == UINT32_MAX)
+    return NULL;
+  if ((size_t)(r->end - r->p) < n) {
+    r->ok = false;
+    return NULL;
+  }
+  char *s = ny_strndup((const char *)r->p, n);
+  r->p += n;
+  return s;
+}
+
+static void stdlib_cache_write(const char *path, uint64_t key) {
+  sbuf_t b = {0};
+  sb_append_n(&b, LSP_STD_CACHE_MAGIC, 8);
+  cache_put_u32(&b, (uint32_t)key);
+  cache_put_u32(&b, (uint32_t)(key >> 32));
+  cache_put_u32(&b, (uint32_t)g_stdlib_symbols_len);
+  for (size_t i = 0; i < g_stdlib_symbols_len; ++i) {
+    const lsp_symbol_t *s = &g_stdlib_symbols[i];
+    cache_put_str(&b, s->name);
+    cache_put_str(&b, s->detail);
+    cache_put_str(&b, s->doc);
+    cache_put_str(&b, s->uri);
+    cache_put_u32(&b, (uint32_t)s->kind);
+    cache_put_u32(&b, (uint32_t)s->line);
+    cache_put_u32(&b, (uint32_t)s->col);
+    cache_put_u32(&b, (uint32_t)s->end_line);
+    cache_put_u32(&b, (uint32_t)s->end_col);
+  }
+  if (b.data) {
+    /* Write aside and rename so a concurrent server never reads a torn file. */
+    char tmp[PATH_MAX + 32];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+    if (ny_write_file(tmp, b.data, b.len) == 0 && rename(tmp, path) != 0)
+      remove(tmp);
+  }
+  free(b.data);
+}
+
+static bool stdlib_cache_read(const char *path, uint64_t key) {
+  ny_file_view_t view;
+  if (!ny_file_view_open(&view, path, 0, SIZE_MAX, 0))
+    return false;
+  const char *raw = view.data;
+  size_t len = view.len;
+  lsp_cache_reader_t r = {(const unsigned char *)raw, (const unsigned char *)raw + len, true};
+  bool ok = len >= 8 && memcmp(raw, LSP_STD_CACHE_MAGIC, 8) == 0;
+  r.p += 8;
+  uint64_t stored = ok ? cache_get_u32(&r) : 0;
+  stored |= ok ? (uint64_t)cache_get_u32(&r) << 32 : 0;
+  uint32_t count = ok ? cache_get_u32(&r) : 0;
+  ok = ok && r.ok && stored == key;
+  for (uint32_t i = 0; ok && i < count; ++i) {
+    lsp_symbol_t s = {0};
+    s.name = cache_get_str(&r);
+    s.detail = cache_get_str(&r);
+    s.doc = cache_get_str(&r);
+    s.uri = cache_get_str(&r);
+    s.kind = (int)cache_get_u32(&r);
+    s.line = (int)cache_get_u32(&r);
+    s.col = (int)cache_get_u32(&r);
+    s.end_line = (int)cache_get_u32(&r);
+    s.end_col = (int)cache_get_u32(&r);
+    ok = r.ok && s.name;
+    if (ok)
+      stdlib_symbol_push(&s);
+    symbol_free(&s);
+  }
+  ok = ok && r.p == r.end && g_stdlib_symbols_len == count;
+  if (!ok)
+    stdlib_symbols_reset();
+  ny_file_view_close(&view);
+  return ok;
+}
+
+static void stdlib_index_load(void) {
+  uint64_t key = ny_fnv1a64_cstr(ny_src_root(), ny_std_source_fingerprint());
+  char path[PATH_MAX];
+  bool cacheable = stdlib_cache_path(path, sizeof(path), key);
+  if (!cacheable || !stdlib_cache_read(path, key)) {
+    stdlib_index_parse();
+    if (cacheable)
+      stdlib_cache_write(path, key);
+  }
+  const char **names = g_stdlib_symbols_len ? malloc(g_stdlib_symbols_len * sizeof(*names)) : NULL;
+  if (names) {
+    for (size_t i = 0; i < g_stdlib_symbols_len; ++i)
+      names[i] = g_stdlib_symbols[i].name;
+  }
+  name_index_build(&g_stdlib_index, names, names ? g_stdlib_symbols_len : 0);
+}
+
+#ifndef _WIN32
+static void *stdlib_index_worker(void *arg) {
+  (void)arg;
+  stdlib_index_load();
+  return NULL;
+}
+#endif
+
+/* Loads the std index off the request loop so the first lookup finds it warm. */
+static void stdlib_index_start(void) {
+#ifndef _WIN32
+  if (g_stdlib_loaded)
+    return;
+  g_stdlib_loaded = true;
+  if (pthread_create(&g_stdlib_thread, NULL, stdlib_index_worker, NULL) == 0) {
+    g_stdlib_thread_live = true;
+    return;
+  }
+  g_stdlib_loaded = false;
+#endif
+}
+
+static void stdlib_index_join(void) {
+#ifndef _WIN32
+  if (g_stdlib_thread_live) {
+    pthread_join(g_stdlib_thread, NULL);
+    g_stdlib_thread_live = false;
+  }
+#endif
+}
+
+static void stdlib_index_ensure(void) {
+  stdlib_index_join();
+  if (g_stdlib_loaded) {
+    return;
   }
+  g_stdlib_loaded = true;
+  stdlib_index_load();
+}
+
+/*
+ * First symbol whose full name is `word`, else the first whose tail name
+ * matches. Scans linearly only when the index could not be built.
+ */
+static lsp_symbol_t *symbols_find(lsp_symbol_t *syms, size_t n, const lsp_name_index_t *ix,
+                                  const char *word) {
+  if (!n || !word || !*word)
+    return NULL;
+  if (ix->len == n) {
+    uint32_t id = name_index_find(ix, word, true);
+    return id == LSP_INDEX_NONE ? NULL : &syms[id];
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (syms[i].name && strcmp(syms[i].name, word) == 0)
+      return &syms[i];
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (symbol_name_matches(&syms[i], word))
+      return &syms[i];
+  }
+  return NULL;
+}
+
+static const lsp_name_index_t *doc_name_index(lsp_doc_t *doc) {
+  if (doc->index_dirty) {
+    doc->index_dirty = false;
+    const char **names = doc->symbols_len ? malloc(doc->symbols_len * sizeof(*names)) : NULL;
+    if (names) {
+      for (size_t i = 0; i < doc->symbols_len; ++i)
+        names[i] = doc->symbols[i].name;
+    }
+    name_index_build(&doc->index, names, names ? doc->symbols_len : 0);
+  }
+  return &doc->index;
 }
 
 static lsp_symbol_t *find_symbol_in_stdlib(const char *word) {
@@ -890,13 +1970,11 @@ static lsp_symbol_t *find_symbol_in_stdlib(const char *word) {
     return NULL;
   stdlib_index_ensure();
   symbol_free(&g_stdlib_symbol_hit);
-  for (size_t i = 0; i < g_stdlib_symbols_len; ++i) {
-    if (symbol_name_matches(&g_stdlib_symbols[i], word)) {
-      stdlib_symbol_hit_set(&g_stdlib_symbols[i]);
-      return &g_stdlib_symbol_hit;
-    }
-  }
-  return NULL;
+  lsp_symbol_t *hit = symbols_find(g_stdlib_symbols, g_stdlib_symbols_len, &g_stdlib_index, word);
+  if (!hit)
+    return NULL;
+  stdlib_symbol_hit_set(hit);
+  return &g_stdlib_symbol_hit;
 }
 
 typedef struct {
@@ -930,9 +2008,38 @@ static const lsp_builtin_t g_rt_builtins[] = {
 #undef RT_GV
 };
 
+#define LSP_CORE_BUILTINS_LEN (sizeof(g_core_builtins) / sizeof(g_core_builtins[0]))
+#define LSP_RT_BUILTINS_LEN (sizeof(g_rt_builtins) / sizeof(g_rt_builtins[0]))
+
+/* Core builtins take ids [0, LSP_CORE_BUILTINS_LEN), runtime builtins follow. */
+static lsp_name_index_t g_builtin_index = {0};
+static bool g_builtin_index_ready = false;
+
+static const lsp_builtin_t *builtin_at(uint32_t id) {
+  return id < LSP_CORE_BUILTINS_LEN ? &g_core_builtins[id] : &g_rt_builtins[id - LSP_CORE_BUILTINS_LEN];
+}
+
+static bool builtin_index_ensure(void) {
+  if (!g_builtin_index_ready) {
+    g_builtin_index_ready = true;
+    size_t n = LSP_CORE_BUILTINS_LEN + LSP_RT_BUILTINS_LEN;
+    const char **names = malloc(n * sizeof(*names));
+    if (names) {
+      for (size_t i = 0; i < n; ++i)
+        names[i] = builtin_at((uint32_t)i)->name;
+    }
+    name_index_build(&g_builtin_index, names, names ? n : 0);
+  }
+  return g_builtin_index.len == LSP_CORE_BUILTINS_LEN + LSP_RT_BUILTINS_LEN;
+}
+
 static const lsp_builtin_t *find_builtin(const char *name) {
   if (!name || !*name)
     return NULL;
+  if (builtin_index_ensure()) {
+    uint32_t id = name_index_find(&g_builtin_index, name, false);
+    return id == LSP_INDEX_NONE ? NULL : builtin_at(id);
+  }
   for (size_t i = 0; i < sizeof(g_core_builtins) / sizeof(g_core_builtins[0]); ++i) {
     if (strcmp(g_core_builtins[i].name, name) == 0)
       return &g_core_builtins[i];
@@ -956,18 +2063,18 @@ static lsp_symbol_t *find_symbol(const char *word, lsp_doc_t *current) {
   if (!word || !*word)
     return NULL;
   if (current) {
-    for (size_t i = 0; i < current->symbols_len; ++i) {
-      if (symbol_name_matches(&current->symbols[i], word))
-        return &current->symbols[i];
-    }
+    lsp_symbol_t *hit =
+        symbols_find(current->symbols, current->symbols_len, doc_name_index(current), word);
+    if (hit)
+      return hit;
   }
   for (size_t d = 0; d < g_docs_len; ++d) {
     if (&g_docs[d] == current)
       continue;
-    for (size_t i = 0; i < g_docs[d].symbols_len; ++i) {
-      if (symbol_name_matches(&g_docs[d].symbols[i], word))
-        return &g_docs[d].symbols[i];
-    }
+    lsp_symbol_t *hit =
+        symbols_find(g_docs[d].symbols, g_docs[d].symbols_len, doc_name_index(&g_docs[d]), word);
+    if (hit)
+      return hit;
   }
   return NULL;
 }
@@ -1120,18 +2227,51 @@ static bool line_starts_keyword(const char *line, const char *kw) {
   return strncmp(line, kw, n) == 0 && !isalnum((unsigned char)line[n]) && line[n] != '_';
 }
 
-static void analyze_style_hints(const char *text, lsp_diag_vec_t *out) {
-  if (!text || !out)
+static void style_tally_init(lsp_style_tally_t *t) {
+  lsp_hint_tally_t empty = {0, -1, 0};
+  t->dict_lookup = empty;
+  t->layout_probe = empty;
+  t->parser_emit = empty;
+  t->alloc = empty;
+}
+
+static void hint_tally_add(lsp_hint_tally_t *t, int count, int line, int col) {
+  if (t->line < 0) {
+    t->line = line;
+    t->col = col;
+  }
+  t->count += count;
+}
+
+static void style_tally_merge(lsp_style_tally_t *into, const lsp_style_tally_t *from) {
+  if (from->dict_lookup.count)
+    hint_tally_add(&into->dict_lookup, from->dict_lookup.count, from->dict_lookup.line,
+                   from->dict_lookup.col);
+  if (from->layout_probe.count)
+    hint_tally_add(&into->layout_probe, from->layout_probe.count, from->layout_probe.line,
+                   from->layout_probe.col);
+  if (from->parser_emit.count)
+    hint_tally_add(&into->parser_emit, from->parser_emit.count, from->parser_emit.line,
+                   from->parser_emit.col);
+  if (from->alloc.count)
+    hint_tally_add(&into->alloc, from->alloc.count, from->alloc.line, from->alloc.col);
+}
+
+/*
+ * Per-line style hints for text[0, len), numbered from first_line. Patterns
+ * that only matter in aggregate are counted into *tally for
+ * style_tally_finish.
+ */
+static void analyze_style_lines(const char *text, size_t len, int first_line, lsp_diag_vec_t *out,
+                                lsp_style_tally_t *tally) {
+  if (!text || !out || !tally)
     return;
-  int line = 0;
+  int line = first_line;
   const char *cur = text;
-  int dict_lookup_count = 0, dict_lookup_line = -1, dict_lookup_col = 0;
-  int layout_probe_count = 0, layout_probe_line = -1, layout_probe_col = 0;
-  int parser_emit_count = 0, parser_emit_line = -1, parser_emit_col = 0;
-  int alloc_count = 0, alloc_line = -1, alloc_col = 0;
-  while (*cur) {
+  const char *end = text + len;
+  while (cur < end) {
     const char *line_end = cur;
-    while (*line_end && *line_end != '\n')
+    while (line_end < end && *line_end != '\n')
       line_end++;
     size_t raw_len = (size_t)(line_end - cur);
     char buf[4096];
@@ -1179,11 +2319,7 @@ static void analyze_style_hints(const char *text, lsp_diag_vec_t *out) {
     int layout_col = line_contains_any_col(buf, layout_probes,
                                            sizeof(layout_probes) / sizeof(layout_probes[0]));
     if (layout_col >= 0) {
-      if (layout_probe_line < 0) {
-        layout_probe_line = line;
-        layout_probe_col = layout_col;
-      }
-      layout_probe_count++;
+      hint_tally_add(&tally->layout_probe, 1, line, layout_col);
       if (!strstr(buf, "comptime")) {
         diag_vec_push(out, line, layout_col, line, layout_col + 1, 3, "NYAUD3104",
                       "layout probe can usually be folded at compile time",
@@ -1196,43 +2332,40 @@ static void analyze_style_hints(const char *text, lsp_diag_vec_t *out) {
                     count_substr_occurrences(buf, "dict_get(") +
                     count_substr_occurrences(buf, "contains(");
     if (dict_here > 0) {
-      if (dict_lookup_line < 0) {
-        dict_lookup_line = line;
-        dict_lookup_col = line_contains_col(buf, ".get(");
-        if (dict_lookup_col < 0)
-          dict_lookup_col = line_contains_col(buf, "dict_get(");
-        if (dict_lookup_col < 0)
-          dict_lookup_col = line_contains_col(buf, "contains(");
-      }
-      dict_lookup_count += dict_here;
+      int dict_col = line_contains_col(buf, ".get(");
+      if (dict_col < 0)
+        dict_col = line_contains_col(buf, "dict_get(");
+      if (dict_col < 0)
+        dict_col = line_contains_col(buf, "contains(");
+      hint_tally_add(&tally->dict_lookup, dict_here, line, dict_col);
     }
 
     int parser_col = line_contains_any_col(
         buf, (const char *[]){"parser_error", "ny_diag_error", "issue_push", "comptime emit"},
         4);
-    if (parser_col >= 0) {
-      if (parser_emit_line < 0) {
-        parser_emit_line = line;
-        parser_emit_col = parser_col;
-      }
-      parser_emit_count++;
-    }
+    if (parser_col >= 0)
+      hint_tally_add(&tally->parser_emit, 1, line, parser_col);
 
     int alloc_col_here =
         line_contains_any_col(buf, (const char *[]){"malloc(", "zalloc(", "realloc("}, 3);
-    if (alloc_col_here >= 0) {
-      if (alloc_line < 0) {
-        alloc_line = line;
-        alloc_col = alloc_col_here;
-      }
-      alloc_count++;
-    }
+    if (alloc_col_here >= 0)
+      hint_tally_add(&tally->alloc, 1, line, alloc_col_here);
 
-    if (*line_end == '\n')
+    if (line_end < end)
       line_end++;
     cur = line_end;
     line++;
   }
+}
+
+static void style_tally_finish(const lsp_style_tally_t *t, lsp_diag_vec_t *out) {
+  int dict_lookup_count = t->dict_lookup.count, dict_lookup_line = t->dict_lookup.line;
+  int dict_lookup_col = t->dict_lookup.col;
+  int layout_probe_count = t->layout_probe.count, layout_probe_line = t->layout_probe.line;
+  int layout_probe_col = t->layout_probe.col;
+  int parser_emit_count = t->parser_emit.count, parser_emit_line = t->parser_emit.line;
+  int parser_emit_col = t->parser_emit.col;
+  int alloc_count = t->alloc.count, alloc_line = t->alloc.line, alloc_col = t->alloc.col;
   if (dict_lookup_count >= 8 && dict_lookup_line >= 0) {
     diag_vec_push(out, dict_lookup_line, dict_lookup_col, dict_lookup_line, dict_lookup_col + 1, 3,
                   "NYAUD4101", "metaprogramming candidate: repeated dynamic map lookups",
@@ -1259,6 +2392,15 @@ static void analyze_style_hints(const char *text, lsp_diag_vec_t *out) {
   }
 }
 
+static void analyze_style_hints(const char *text, lsp_diag_vec_t *out) {
+  if (!text || !out)
+    return;
+  lsp_style_tally_t tally;
+  style_tally_init(&tally);
+  analyze_style_lines(text, strlen(text), 0, out, &tally);
+  style_tally_finish(&tally, out);
+}
+
 static void publish_diagnostics(const char *uri, const lsp_diag_vec_t *diags) {
   if (!uri)
     return;
@@ -1300,12 +2442,15 @@ static void publish_diagnostics(const char *uri, const lsp_diag_vec_t *diags) {
 static bool analyze_text(const char *text, lsp_diag_vec_t *out) {
   if (!text || !out)
     return false;
+  parse_lock();
+  parser_global_cleanup();
   parser_t parser;
   parser_init_quiet(&parser, text, "<lsp>");
   parser.error_limit = 0;
   program_t prog = parse_program(&parser);
   (void)prog;
   program_free(&prog, parser.arena);
+  parse_unlock();
   if (parser.error_count > 0) {
     int line = parser.last_error_line > 0 ? parser.last_error_line - 1 : 0;
     int col = parser.last_error_col > 0 ? parser.last_error_col - 1 : 0;
@@ -1318,11 +2463,36 @@ static bool analyze_text(const char *text, lsp_diag_vec_t *out) {
   return out->len > 0;
 }
 
+static void doc_collect_diagnostics(const lsp_doc_t *doc, lsp_diag_vec_t *out) {
+  for (size_t i = 0; i < doc->chunks_len; ++i) {
+    const lsp_diag_t *e = &doc->chunks[i].err;
+    if (e->message)
+      diag_vec_push(out, e->line, e->col, e->end_line, e->end_col, 1, "NYPARSE1001", e->message,
+                    e->hint, "nytrix");
+  }
+  lsp_style_tally_t tally;
+  style_tally_init(&tally);
+  for (size_t i = 0; i < doc->chunks_len; ++i) {
+    const lsp_chunk_t *c = &doc->chunks[i];
+    for (size_t h = 0; h < c->hints.len; ++h) {
+      const lsp_diag_t *d = &c->hints.items[h];
+      diag_vec_push(out, d->line, d->col, d->end_line, d->end_col, d->severity, d->code,
+                    d->message, d->hint, d->source);
+    }
+    style_tally_merge(&tally, &c->tally);
+  }
+  style_tally_finish(&tally, out);
+}
+
 static void check_document(const char *uri, const char *text) {
   if (!uri)
     return;
   lsp_diag_vec_t diags = {0};
-  analyze_text(text, &diags);
+  lsp_doc_t *doc = doc_find(uri);
+  if (doc && doc->text && doc->text == text)
+    doc_collect_diagnostics(doc, &diags);
+  else
+    analyze_text(text, &diags);
   publish_diagnostics(uri, &diags);
   diag_vec_free(&diags);
 }
@@ -1638,46 +2808,95 @@ static void append_completion_item(sbuf_t *b, const char *label, int kind, const
   sb_append(b, "}");
 }
 
-static void handle_completion(const char *id) {
-  sbuf_t result = {0};
-  sb_append(&result, "{\"isIncomplete\":false,\"items\":[");
-  bool first = true;
-  for (size_t i = 0; i < sizeof(g_core_builtins) / sizeof(g_core_builtins[0]); ++i) {
-    if (!first)
-      sb_append(&result, ",");
-    append_completion_item(&result, g_core_builtins[i].name, 3, g_core_builtins[i].detail,
-                           g_core_builtins[i].doc);
-    first = false;
+static bool tail_has_prefix(const char *name, const char *prefix, size_t prefix_len) {
+  return name && strncmp(ny_tail_name(name), prefix, prefix_len) == 0;
+}
+
+/* Completion items for `syms` whose tail names start with `prefix` (all when empty). */
+static void append_symbol_completions(sbuf_t *b, bool *first, lsp_symbol_t *syms, size_t n,
+                                      const lsp_name_index_t *ix, const char *prefix) {
+  size_t prefix_len = strlen(prefix);
+  if (prefix_len && ix->len == n) {
+    uint32_t lo = 0, hi = name_index_prefix(ix, prefix, &lo);
+    for (uint32_t k = lo; k < hi; ++k) {
+      lsp_symbol_t *s = &syms[ix->sorted[k].id];
+      if (!*first)
+        sb_append(b, ",");
+      append_completion_item(b, s->name, completion_kind_for_symbol(s->kind), s->detail, s->doc);
+      *first = false;
+    }
+    return;
   }
-  for (size_t i = 0; i < sizeof(g_rt_builtins) / sizeof(g_rt_builtins[0]); ++i) {
-    if (!first)
-      sb_append(&result, ",");
-    append_completion_item(&result, g_rt_builtins[i].name, completion_kind_for_symbol(g_rt_builtins[i].kind),
-                           g_rt_builtins[i].detail, g_rt_builtins[i].doc);
-    first = false;
+  for (size_t i = 0; i < n; ++i) {
+    lsp_symbol_t *s = &syms[i];
+    if (prefix_len && !tail_has_prefix(s->name, prefix, prefix_len))
+      continue;
+    if (!*first)
+      sb_append(b, ",");
+    append_completion_item(b, s->name, completion_kind_for_symbol(s->kind), s->detail, s->doc);
+    *first = false;
   }
-  for (size_t d = 0; d < g_docs_len; ++d) {
-    for (size_t i = 0; i < g_docs[d].symbols_len; ++i) {
+}
+
+static void handle_completion(const char *id, const char *body) {
+  char *uri = json_extract_string_near(body, "\"textDocument\"", "uri");
+  int line = 0, ch = 0;
+  json_extract_int_near(body, "\"position\"", "line", &line);
+  json_extract_int_near(body, "\"position\"", "character", &ch);
+  lsp_doc_t *doc = doc_find(uri);
+  int word_start = 0;
+  char *word = word_at_position(doc ? doc->text : NULL, line, ch, &word_start, NULL);
+  /* Only the part of the word left of the cursor narrows the list. */
+  if (word && ch - word_start >= 0 && (size_t)(ch - word_start) < strlen(word))
+    word[ch - word_start] = '\0';
+  const char *prefix = word ? ny_tail_name(word) : "";
+  size_t prefix_len = strlen(prefix);
+
+  sbuf_t result = {0};
+  /* A filtered list must be re-requested as the prefix changes. */
+  sb_appendf(&result, "{\"isIncomplete\":%s,\"items\":[", prefix_len ? "true" : "false");
+  bool first = true;
+  if (prefix_len && builtin_index_ensure()) {
+    uint32_t lo = 0, hi = name_index_prefix(&g_builtin_index, prefix, &lo);
+    for (uint32_t k = lo; k < hi; ++k) {
+      const lsp_builtin_t *bi = builtin_at(g_builtin_index.sorted[k].id);
       if (!first)
         sb_append(&result, ",");
-      lsp_symbol_t *s = &g_docs[d].symbols[i];
-      append_completion_item(&result, s->name, completion_kind_for_symbol(s->kind), s->detail,
-                             s->doc);
+      append_completion_item(&result, bi->name, completion_kind_for_symbol(bi->kind), bi->detail,
+                             bi->doc);
+      first = false;
+    }
+  } else {
+    for (size_t i = 0; i < sizeof(g_core_builtins) / sizeof(g_core_builtins[0]); ++i) {
+      if (prefix_len && !tail_has_prefix(g_core_builtins[i].name, prefix, prefix_len))
+        continue;
+      if (!first)
+        sb_append(&result, ",");
+      append_completion_item(&result, g_core_builtins[i].name, 3, g_core_builtins[i].detail,
+                             g_core_builtins[i].doc);
+      first = false;
+    }
+    for (size_t i = 0; i < sizeof(g_rt_builtins) / sizeof(g_rt_builtins[0]); ++i) {
+      if (prefix_len && !tail_has_prefix(g_rt_builtins[i].name, prefix, prefix_len))
+        continue;
+      if (!first)
+        sb_append(&result, ",");
+      append_completion_item(&result, g_rt_builtins[i].name, completion_kind_for_symbol(g_rt_builtins[i].kind),
+                             g_rt_builtins[i].detail, g_rt_builtins[i].doc);
       first = false;
     }
   }
+  for (size_t d = 0; d < g_docs_len; ++d)
+    append_symbol_completions(&result, &first, g_docs[d].symbols, g_docs[d].symbols_len,
+                              doc_name_index(&g_docs[d]), prefix);
   stdlib_index_ensure();
-  for (size_t i = 0; i < g_stdlib_symbols_len; ++i) {
-    if (!first)
-      sb_append(&result, ",");
-    lsp_symbol_t *s = &g_stdlib_symbols[i];
-    append_completion_item(&result, s->name, completion_kind_for_symbol(s->kind), s->detail,
-                           s->doc);
-    first = false;
-  }
+  append_symbol_completions(&result, &first, g_stdlib_symbols, g_stdlib_symbols_len,
+                            &g_stdlib_index, prefix);
   sb_append(&result, "]}");
   send_result(id, result.data);
   free(result.data);
+  free(word);
+  free(uri);
 }
 
 static void handle_signature(const char *id, const char *body) {
@@ -2071,9 +3290,10 @@ static void handle_request(const char *body) {
     return;
   }
   if (strcmp(method, "initialize") == 0) {
+    stdlib_index_start();
     send_result(id,
                 "{\"capabilities\":{"
-                "\"textDocumentSync\":{\"openClose\":true,\"change\":1,"
+                "\"textDocumentSync\":{\"openClose\":true,\"change\":2,"
                 "\"save\":{\"includeText\":true}},"
                 "\"hoverProvider\":true,\"definitionProvider\":true,"
                 "\"referencesProvider\":true,\"renameProvider\":{\"prepareProvider\":false},"
@@ -2088,15 +3308,18 @@ static void handle_request(const char *body) {
     char *uri = json_extract_string_near(body, "\"textDocument\"", "uri");
     char *text = NULL;
     const char *changes = strstr(body, "\"contentChanges\"");
-    if (changes) {
+    lsp_doc_t *doc = uri ? doc_find(uri) : NULL;
+    if (changes && doc) {
+      doc_apply_changes(doc, changes);
+    } else if (changes) {
       text = json_extract_string(changes, "text");
     } else {
       text = json_extract_string_near(body, "\"textDocument\"", "text");
     }
     if (uri && text)
       doc_put(uri, text);
-    lsp_doc_t *doc = uri ? doc_find(uri) : NULL;
-    check_document(uri, text ? text : (doc ? doc->text : NULL));
+    doc = uri ? doc_find(uri) : NULL;
+    check_document(uri, doc ? doc->text : text);
     free(text);
     free(uri);
   } else if (strcmp(method, "textDocument/didSave") == 0) {
@@ -2107,7 +3330,7 @@ static void handle_request(const char *body) {
     if (uri && text)
       doc_put(uri, text);
     lsp_doc_t *doc = uri ? doc_find(uri) : NULL;
-    check_document(uri, text ? text : (doc ? doc->text : NULL));
+    check_document(uri, doc ? doc->text : text);
     free(text);
     free(uri);
   } else if (strcmp(method, "textDocument/didClose") == 0) {
@@ -2137,7 +3360,7 @@ static void handle_request(const char *body) {
   } else if (strcmp(method, "textDocument/codeAction") == 0) {
     handle_code_actions(id, body);
   } else if (strcmp(method, "textDocument/completion") == 0) {
-    handle_completion(id);
+    handle_completion(id, body);
   } else if (strcmp(method, "textDocument/signatureHelp") == 0) {
     handle_signature(id, body);
   } else if (strcmp(method, "shutdown") == 0) {
@@ -1427,6 +1427,18 @@ static void handle_timeout(int sig) {
 }
 #endif
 
+static int ny_run_main(int argc, char **argv, char **envp);
+
+/* Warm everything a test compile would otherwise redo per process, then let
+   ny-test fork copy-on-write compiles from this image. */
+static int ny_test_zygote(int argc, char **argv, char **envp) {
+  ny_jit_init_native_once();
+  (void)ny_std_module_count();
+  (void)ny_std_source_fingerprint();
+  (void)ny_src_root();
+  return ny_test_zygote_main(argc, argv, ny_run_main, envp);
+}
+
 int main(int argc, char **argv, char **envp) {
 #ifndef _WIN32
   // increase stack for large frames in clang_import for complex headers
@@ -1444,6 +1456,12 @@ int main(int argc, char **argv, char **envp) {
   }
 #endif
   ny_load_default_config();
+  if (argc >= 3 && strcmp(argv[1], "--test-zygote") == 0)
+    return ny_test_zygote(argc, argv, envp);
+  return ny_run_main(argc, argv, envp);
+}
+
+static int ny_run_main(int argc, char **argv, char **envp) {
   int unified_rc = 0;
   if (ny_try_unified_tool(argc, argv, &unified_rc))
     return unified_rc;
@@ -236,7 +236,12 @@ static ny_test_proc_t run_one_start(const char *bin, const char *path, const cha
   error_meta_free(flags, expect);
   return proc;
 #else
-  ny_test_proc_t pid = fork();
+  ny_test_proc_t pid = test_zygote_spawn(bin, argv, output_path);
+  if (pid > 0) {
+    error_meta_free(flags, expect);
+    return pid;
+  }
+  pid = fork();
   if (pid == 0) {
     apply_test_child_env();
     if (output_path) {
@@ -78,6 +78,8 @@ static int native_backend_explicit(const char *flags);
 static int path_is_native_runtime_test(const char *p);
 static int path_is_stdlib_source(const char *p);
 static int run_progress_selftest(const char *bin, int timeout_sec);
+static int run_zygote_selftest(const char *bin, int timeout_sec);
+static int run_lsp_selftest(const char *bin, int timeout_sec);
 static int make_test_capture_tmp(char *tmp, size_t tmp_len,
                                  const char *prefix);
 
@@ -641,8 +643,10 @@ static int split_words(char *s, char **out, int max);
 static char *read_small_file(const char *path);
 static int run_debug_argv(char *const argv[], int timeout_sec, int use_path_lookup);
 static int test_env_truthy(const char *name);
+static int test_env_falsey(const char *name);
 
 
+#include "zygote.c"
 #include "elf.c"
 
 static int test_env_truthy(const char *name) {
@@ -1527,6 +1531,57 @@ static int split_flag_matrix_rows(char *s, char **out, int max) {
   return n;
 }
 
+/* `{tmp}` in a flags_matrix expands to one temp path stem shared by every row
+ * of that run, so rows can hand files to each other (e.g. a --pgo-gen
+ * profile read back by --pgo-use) without a fixed path that outlives the run
+ * or collides with another session. */
+#define SHAPE_MATRIX_TMP "{tmp}"
+
+static int shape_matrix_expand_tmp(char *buf, size_t cap, char *stem, size_t stem_cap) {
+  if (!strstr(buf, SHAPE_MATRIX_TMP))
+    return 0;
+  static int seq = 0;
+  snprintf(stem, stem_cap, "%s/ny-shape-run-%ld-%lld-%d-tmp", nyt_temp_dir(), (long)getpid(),
+           (long long)now_ms(), ++seq);
+  char out[4096];
+  size_t n = 0;
+  size_t tok = strlen(SHAPE_MATRIX_TMP);
+  size_t stem_len = strlen(stem);
+  for (const char *p = buf; *p && n + 1 < sizeof(out);) {
+    if (strncmp(p, SHAPE_MATRIX_TMP, tok) == 0 && n + stem_len + 1 < sizeof(out)) {
+      memcpy(out + n, stem, stem_len);
+      n += stem_len;
+      p += tok;
+    } else {
+      out[n++] = *p++;
+    }
+  }
+  out[n] = '\0';
+  snprintf(buf, cap, "%s", out);
+  return 1;
+}
+
+/* Removes every temp entry the rows created under `stem`. */
+static void shape_matrix_remove_tmp(const char *stem) {
+  if (!stem || !*stem)
+    return;
+  const char *base = strrchr(stem, '/');
+  base = base ? base + 1 : stem;
+  size_t base_len = strlen(base);
+  DIR *d = opendir(nyt_temp_dir());
+  if (!d)
+    return;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != NULL) {
+    if (strncmp(ent->d_name, base, base_len) != 0)
+      continue;
+    char file[PATH_MAX];
+    nyt_path_join(file, sizeof(file), nyt_temp_dir(), ent->d_name);
+    remove(file);
+  }
+  closedir(d);
+}
+
 static int run_one_blocking(const char *bin, const char *path, const char *std_path, const char *std_bc,
                             int timeout_sec, int trace_exec) {
   char *matrix = (path && nyt_ends_with(path, ".nshape"))
@@ -1540,17 +1595,18 @@ static int run_one_blocking(const char *bin, const char *path, const char *std_p
   char matrix_buf[4096];
   snprintf(matrix_buf, sizeof(matrix_buf), "%s", matrix);
   free(matrix);
+  char tmp_stem[PATH_MAX] = {0};
+  shape_matrix_expand_tmp(matrix_buf, sizeof(matrix_buf), tmp_stem, sizeof(tmp_stem));
   char *rows[64];
   int rowc = split_flag_matrix_rows(matrix_buf, rows, 64);
   if (rowc <= 0)
     return run_one_blocking_once(bin, path, std_path, std_bc, timeout_sec, trace_exec, NULL);
 
-  for (int i = 0; i < rowc; i++) {
-    int rc = run_one_blocking_once(bin, path, std_path, std_bc, timeout_sec, trace_exec, rows[i]);
-    if (rc != 0)
-      return rc;
-  }
-  return 0;
+  int rc = 0;
+  for (int i = 0; i < rowc && rc == 0; i++)
+    rc = run_one_blocking_once(bin, path, std_path, std_bc, timeout_sec, trace_exec, rows[i]);
+  shape_matrix_remove_tmp(tmp_stem);
+  return rc;
 }
 
 static void trim_inplace(char *s) {
@@ -2160,10 +2216,12 @@ static void debug_replay_failed_tests(StrVec *failed_paths, const char *bin, con
                        ? shape_meta_string(path, "flags_matrix")
                        : NULL;
     char matrix_buf[4096] = {0};
+    char tmp_stem[PATH_MAX] = {0};
     char *rows[64];
     int rowc = 0;
     if (matrix && *matrix) {
       snprintf(matrix_buf, sizeof(matrix_buf), "%s", matrix);
+      shape_matrix_expand_tmp(matrix_buf, sizeof(matrix_buf), tmp_stem, sizeof(tmp_stem));
       rowc = split_flag_matrix_rows(matrix_buf, rows, 64);
     }
     int variants = rowc > 0 ? rowc : 1;
@@ -2195,6 +2253,7 @@ static void debug_replay_failed_tests(StrVec *failed_paths, const char *bin, con
       error_meta_free(flags, expect);
     }
     free(matrix);
+    shape_matrix_remove_tmp(tmp_stem);
     if (materialized_path) {
       remove(materialized_path);
       free(materialized_path);
@@ -2593,6 +2652,436 @@ static int run_progress_selftest(const char *bin, int timeout_sec) {
 #endif
 }
 
+/* Runs a passing, an exiting and a failing program concurrently through the
+   zygote and checks each child's exit code and captured output. */
+static int run_zygote_selftest(const char *bin, int timeout_sec) {
+  double start_ms = now_ms();
+#ifdef _WIN32
+  (void)bin;
+  (void)timeout_sec;
+  printf("zygote selftest: skipped (no zygote on Windows)\n");
+  return 0;
+#else
+  if (!test_zygote_enabled()) {
+    printf("zygote selftest: skipped (NYTRIX_TEST_ZYGOTE=0)\n");
+    return 0;
+  }
+  static const struct {
+    const char *src;
+    int rc;
+    const char *out;
+  } cases[] = {
+      {"def x = 1 + 2 * 3\nassert(x == 7, \"zygote arithmetic\")\nprint(\"zygote-ok \" + to_str(x))\n",
+       0, "zygote-ok 7"},
+      {"use std.os\nprint(\"zygote-exit\")\nexit(3)\n", 3, "zygote-exit"},
+      {"assert(1 == 2, \"zygote-assert\")\n", -1, "zygote-assert"},
+  };
+  enum { NCASES = sizeof(cases) / sizeof(cases[0]) };
+  char src_path[NCASES][PATH_MAX];
+  char out_path[NCASES][PATH_MAX];
+  pid_t pid[NCASES];
+  int status[NCASES];
+  int done[NCASES];
+  int failed = 0;
+  for (int i = 0; i < NCASES; i++) {
+    src_path[i][0] = out_path[i][0] = '\0';
+    pid[i] = -1;
+    status[i] = 0;
+    done[i] = 0;
+  }
+  for (int i = 0; i < NCASES && !failed; i++) {
+    snprintf(src_path[i], sizeof(src_path[i]), "%s/ny-zygote-selftest-%ld-XXXXXX.ny",
+             nyt_temp_dir(), (long)getpid());
+    int fd = mkstemps(src_path[i], 3);
+    size_t n = strlen(cases[i].src);
+    if (fd < 0 || write(fd, cases[i].src, n) != (ssize_t)n) {
+      printf("zygote selftest: source write failed\n");
+      failed = 1;
+    }
+    if (fd >= 0)
+      close(fd);
+    int out_fd = make_test_capture_tmp(out_path[i], sizeof(out_path[i]), "zygote-selftest");
+    if (out_fd < 0) {
+      printf("zygote selftest: capture file failed\n");
+      failed = 1;
+    } else {
+      close(out_fd);
+    }
+    if (failed)
+      break;
+    char *argv[] = {(char *)bin, src_path[i], NULL};
+    pid[i] = test_zygote_spawn(bin, argv, out_path[i]);
+    if (pid[i] <= 0) {
+      printf("zygote selftest: zygote unavailable for %s\n", bin);
+      failed = 1;
+    }
+  }
+
+  int remaining = 0;
+  for (int i = 0; i < NCASES; i++)
+    remaining += pid[i] > 0;
+  double timeout_ms = (double)timeout_sec * 1000.0;
+  while (remaining > 0) {
+    int st = 0;
+    pid_t reaped = test_reap_any(&st);
+    if (reaped <= 0) {
+      if (g_zygote.state <= 0) {
+        printf("zygote selftest: lost the zygote\n");
+        failed = 1;
+        break;
+      }
+      if (now_ms() - start_ms >= timeout_ms) {
+        printf("zygote selftest: timed out\n");
+        failed = 1;
+        break;
+      }
+      poll_sleep();
+      continue;
+    }
+    for (int i = 0; i < NCASES; i++) {
+      if (pid[i] == reaped && !done[i]) {
+        status[i] = st;
+        done[i] = 1;
+        remaining--;
+      }
+    }
+  }
+
+  for (int i = 0; i < NCASES; i++) {
+    if (!done[i]) {
+      if (pid[i] > 0) {
+        kill(pid[i], SIGKILL);
+        test_zygote_forget(pid[i]);
+      }
+    } else {
+      int rc = child_status_rc(status[i]);
+      char *out = read_small_file(out_path[i]);
+      int rc_ok = cases[i].rc < 0 ? rc != 0 : rc == cases[i].rc;
+      if (!rc_ok || !out || !strstr(out, cases[i].out)) {
+        if (cases[i].rc < 0)
+          printf("zygote selftest: case %d failed rc=%d (want nonzero)\n", i, rc);
+        else
+          printf("zygote selftest: case %d failed rc=%d (want %d)\n", i, rc, cases[i].rc);
+        if (out && *out)
+          fputs(out, stdout);
+        failed = 1;
+      }
+      free(out);
+    }
+    if (src_path[i][0])
+      remove(src_path[i]);
+    if (out_path[i][0])
+      remove(out_path[i]);
+  }
+  test_zygote_stop();
+  if (failed)
+    return 1;
+  printf("zygote selftest: passed in %dms\n", (int)(now_ms() - start_ms));
+  return 0;
+#endif
+}
+
+#ifndef _WIN32
+/* initialize, a workspace/symbol query that needs the std index, shutdown and
+   exit. */
+static const char *const lsp_selftest_std_msgs[] = {
+    "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"workspace/symbol\","
+    "\"params\":{\"query\":\"matrix_mul\"}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"shutdown\"}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}",
+};
+
+#define LSP_SELFTEST_CHANGE(ver, edit) \
+  "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":" \
+  "{\"uri\":\"file:///selftest/sync.ny\",\"version\":" #ver "},\"contentChanges\":[" edit "]}}"
+#define LSP_SELFTEST_RANGE(l0, c0, l1, c1) \
+  "\"range\":{\"start\":{\"line\":" #l0 ",\"character\":" #c0 "},\"end\":{\"line\":" #l1 \
+  ",\"character\":" #c1 "}}"
+#define LSP_SELFTEST_SYMBOLS(id) \
+  "{\"jsonrpc\":\"2.0\",\"id\":" #id ",\"method\":\"textDocument/documentSymbol\"," \
+  "\"params\":{\"textDocument\":{\"uri\":\"file:///selftest/sync.ny\"}}}"
+
+/* Incremental document sync. Range edits are spliced and only the touched
+   statements reparsed: an insertion after a non-ASCII character on the same
+   line (UTF-16 columns), a rename, a parse error added and removed above
+   untouched statements. A final change without a range resyncs the whole
+   text. documentSymbol requests 2-5 observe the document between edits. */
+static const char *const lsp_selftest_sync_msgs[] = {
+    "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":"
+    "{\"uri\":\"file:///selftest/sync.ny\",\"languageId\":\"nytrix\",\"version\":1,\"text\":"
+    "\"fn alpha() int { 1 }\\ndef label = \\\"\xc3\xa9\\\"\\nfn beta() int { 2 }\\n\"}}}",
+    LSP_SELFTEST_CHANGE(2, "{" LSP_SELFTEST_RANGE(1, 15, 1, 15)
+                           ",\"text\":\"\\nfn eps() int { 5 }\"}"),
+    LSP_SELFTEST_CHANGE(3, "{" LSP_SELFTEST_RANGE(3, 3, 3, 7) ",\"text\":\"gamma\"}"),
+    LSP_SELFTEST_SYMBOLS(2),
+    LSP_SELFTEST_CHANGE(4, "{" LSP_SELFTEST_RANGE(0, 0, 0, 0)
+                           ",\"text\":\"fn broken() int { 1 + }\\n\"}"),
+    LSP_SELFTEST_SYMBOLS(3),
+    LSP_SELFTEST_CHANGE(5, "{" LSP_SELFTEST_RANGE(0, 0, 1, 0) ",\"text\":\"\"}"),
+    LSP_SELFTEST_SYMBOLS(4),
+    LSP_SELFTEST_CHANGE(6, "{\"text\":\"fn omega() int { 9 }\\n\"}"),
+    LSP_SELFTEST_SYMBOLS(5),
+    "{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"shutdown\"}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}",
+};
+#undef LSP_SELFTEST_CHANGE
+#undef LSP_SELFTEST_RANGE
+#undef LSP_SELFTEST_SYMBOLS
+
+/* One ny-lsp session over pipes that sends msgs in order. */
+static int lsp_selftest_session(const char *lsp, const char *cache_dir,
+                                const char *const *msgs, size_t msg_count, int timeout_sec,
+                                char **out) {
+  int in_pipe[2], out_pipe[2];
+  if (pipe(in_pipe) != 0)
+    return -1;
+  if (pipe(out_pipe) != 0) {
+    close(in_pipe[0]);
+    close(in_pipe[1]);
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    ny_setenv("NYTRIX_CACHE_DIR", cache_dir, 1);
+    dup2(in_pipe[0], STDIN_FILENO);
+    dup2(out_pipe[1], STDOUT_FILENO);
+    close(in_pipe[0]);
+    close(in_pipe[1]);
+    close(out_pipe[0]);
+    close(out_pipe[1]);
+    char *argv[] = {(char *)lsp, NULL};
+    execv(lsp, argv);
+    _exit(127);
+  }
+  close(in_pipe[0]);
+  close(out_pipe[1]);
+  if (pid < 0) {
+    close(in_pipe[1]);
+    close(out_pipe[0]);
+    return -1;
+  }
+  for (size_t i = 0; i < msg_count; i++) {
+    char head[64];
+    int n = snprintf(head, sizeof(head), "Content-Length: %zu\r\n\r\n", strlen(msgs[i]));
+    if (write(in_pipe[1], head, (size_t)n) != n ||
+        write(in_pipe[1], msgs[i], strlen(msgs[i])) != (ssize_t)strlen(msgs[i]))
+      break;
+  }
+  close(in_pipe[1]);
+
+  int flags = fcntl(out_pipe[0], F_GETFL, 0);
+  if (flags >= 0)
+    fcntl(out_pipe[0], F_SETFL, flags | O_NONBLOCK);
+  size_t len = 0, cap = 0;
+  int status = 0, exited = 0, timed_out = 0;
+  double start_ms = now_ms();
+  double timeout_ms = (double)timeout_sec * 1000.0;
+  for (;;) {
+    char buf[4096];
+    ssize_t r = read(out_pipe[0], buf, sizeof(buf));
+    if (r > 0) {
+      repl_append_output(out, &len, &cap, buf, (size_t)r);
+      continue;
+    }
+    if (r == 0 && exited)
+      break;
+    if (!exited) {
+      pid_t wr = waitpid(pid, &status, WNOHANG);
+      if (wr == pid)
+        exited = 1;
+      else if (wr < 0 && errno != EINTR)
+        break;
+    }
+    if (!exited && now_ms() - start_ms >= timeout_ms) {
+      kill(pid, SIGKILL);
+      while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      timed_out = 1;
+      break;
+    }
+    if (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+      break;
+    if (!exited || r < 0)
+      poll_sleep();
+  }
+  close(out_pipe[0]);
+  if (!exited && !timed_out) {
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+  }
+  return timed_out ? NY_TEST_TIMEOUT_RC : child_status_rc(status);
+}
+
+/* Start line of the named symbol in the documentSymbol response with this id,
+   -1 when the response lacks it. */
+static int lsp_selftest_symbol_line(const char *out, int id, const char *name) {
+  char key[48], needle[96];
+  snprintf(key, sizeof(key), "\"id\":%d,\"result\":", id);
+  snprintf(needle, sizeof(needle), "\"name\":\"%s\"", name);
+  const char *resp = out ? strstr(out, key) : NULL;
+  if (!resp)
+    return -1;
+  const char *end = strstr(resp, "Content-Length:");
+  const char *sym = strstr(resp, needle);
+  if (!sym || (end && sym > end))
+    return -1;
+  const char *line = strstr(sym, "\"line\":");
+  return line ? atoi(line + 7) : -1;
+}
+
+/* Whether a parse error was published between the responses to from_id and
+   to_id. */
+static bool lsp_selftest_parse_error_between(const char *out, int from_id, int to_id) {
+  char from_key[48], to_key[48];
+  snprintf(from_key, sizeof(from_key), "\"id\":%d,\"result\":", from_id);
+  snprintf(to_key, sizeof(to_key), "\"id\":%d,\"result\":", to_id);
+  const char *from = out ? strstr(out, from_key) : NULL;
+  const char *to = from ? strstr(from, to_key) : NULL;
+  const char *err = from ? strstr(from, "\"NYPARSE1001\"") : NULL;
+  return err && to && err < to;
+}
+
+static bool lsp_selftest_sync_ok(const char *out) {
+  if (lsp_selftest_symbol_line(out, 2, "alpha") != 0 ||
+      lsp_selftest_symbol_line(out, 2, "eps") != 2 ||
+      lsp_selftest_symbol_line(out, 2, "gamma") != 3 ||
+      lsp_selftest_symbol_line(out, 2, "beta") != -1 ||
+      lsp_selftest_parse_error_between(out, 1, 2))
+    return false;
+  if (!lsp_selftest_parse_error_between(out, 2, 3) ||
+      lsp_selftest_symbol_line(out, 3, "gamma") != 4)
+    return false;
+  if (lsp_selftest_parse_error_between(out, 3, 4) ||
+      lsp_selftest_symbol_line(out, 4, "alpha") != 0 ||
+      lsp_selftest_symbol_line(out, 4, "eps") != 2 ||
+      lsp_selftest_symbol_line(out, 4, "gamma") != 3)
+    return false;
+  return lsp_selftest_symbol_line(out, 5, "omega") == 0 &&
+         lsp_selftest_symbol_line(out, 5, "alpha") == -1 &&
+         lsp_selftest_symbol_line(out, 5, "gamma") == -1;
+}
+
+static int lsp_selftest_cache_files(const char *cache_dir) {
+  char dir[PATH_MAX];
+  nyt_path_join(dir, sizeof(dir), cache_dir, "lsp");
+  DIR *d = opendir(dir);
+  if (!d)
+    return 0;
+  int count = 0;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != NULL) {
+    if (strncmp(ent->d_name, "std_symbols_", 12) == 0)
+      count++;
+  }
+  closedir(d);
+  return count;
+}
+
+static void lsp_selftest_remove_cache(const char *cache_dir) {
+  char dir[PATH_MAX];
+  nyt_path_join(dir, sizeof(dir), cache_dir, "lsp");
+  DIR *d = opendir(dir);
+  if (d) {
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+      if (strncmp(ent->d_name, "std_symbols_", 12) != 0)
+        continue;
+      char file[PATH_MAX];
+      nyt_path_join(file, sizeof(file), dir, ent->d_name);
+      remove(file);
+    }
+    closedir(d);
+  }
+  rmdir(dir);
+  rmdir(cache_dir);
+}
+#endif
+
+/* Drives ny-lsp with a fresh std symbol cache, again with that cache warm,
+   and with a cache root too long to hold the cache file name. Every session
+   must answer the std query; only the first may write a cache file. A last
+   session checks incremental document sync and its full-text fallback. */
+static int run_lsp_selftest(const char *bin, int timeout_sec) {
+  double start_ms = now_ms();
+#ifdef _WIN32
+  (void)bin;
+  (void)timeout_sec;
+  printf("lsp selftest: skipped (pipes unavailable on Windows)\n");
+  return 0;
+#else
+  char lsp[PATH_MAX];
+  companion_tool_path(lsp, sizeof(lsp), bin, "ny-lsp");
+  if (access(lsp, X_OK) != 0) {
+    printf("lsp selftest: %s not found\n", lsp);
+    return 1;
+  }
+  char cache_dir[PATH_MAX];
+  snprintf(cache_dir, sizeof(cache_dir), "%s/ny-lsp-selftest-%ld-XXXXXX", nyt_temp_dir(),
+           (long)getpid());
+  if (!mkdtemp(cache_dir)) {
+    printf("lsp selftest: mkdtemp failed\n");
+    return 1;
+  }
+  /* Long enough that "<root>/lsp" fits PATH_MAX but the cache file name does not. */
+  char long_top[PATH_MAX];
+  int top_len = snprintf(long_top, sizeof(long_top), "%s-long", cache_dir);
+  if (top_len < 0 || (size_t)top_len >= sizeof(long_top) - 24) {
+    rmdir(cache_dir);
+    printf("lsp selftest: temp dir path too long\n");
+    return 1;
+  }
+  char long_root[PATH_MAX];
+  size_t n = (size_t)top_len;
+  memcpy(long_root, long_top, n);
+  for (; n < sizeof(long_root) - 24; n++)
+    long_root[n] = (n - (size_t)top_len) % 201 == 0 ? '/' : 'd';
+  long_root[n] = '\0';
+
+  const char *roots[] = {cache_dir, cache_dir, long_root};
+  const char *labels[] = {"cold cache", "warm cache", "over-long cache root"};
+  int failed = 0;
+  for (int i = 0; i < 3 && !failed; i++) {
+    char *out = NULL;
+    int rc = lsp_selftest_session(lsp, roots[i], lsp_selftest_std_msgs,
+                                  sizeof(lsp_selftest_std_msgs) / sizeof(lsp_selftest_std_msgs[0]),
+                                  timeout_sec, &out);
+    int files = lsp_selftest_cache_files(cache_dir);
+    struct stat st;
+    int ok = rc == 0 && out && strstr(out, "\"id\":2") && strstr(out, "\"matrix_mul\"") &&
+             files == 1 && stat(long_top, &st) != 0;
+    if (!ok) {
+      printf("lsp selftest: %s failed rc=%d cache_files=%d stray_dir=%d\n", labels[i], rc, files,
+             stat(long_top, &st) == 0);
+      if (out && *out)
+        fputs(out, stdout);
+      failed = 1;
+    }
+    free(out);
+  }
+  if (!failed) {
+    char *out = NULL;
+    int rc = lsp_selftest_session(lsp, cache_dir, lsp_selftest_sync_msgs,
+                                  sizeof(lsp_selftest_sync_msgs) / sizeof(lsp_selftest_sync_msgs[0]),
+                                  timeout_sec, &out);
+    if (rc != 0 || !lsp_selftest_sync_ok(out)) {
+      printf("lsp selftest: incremental sync failed rc=%d\n", rc);
+      if (out && *out)
+        fputs(out, stdout);
+      failed = 1;
+    }
+    free(out);
+  }
+  lsp_selftest_remove_cache(cache_dir);
+  rmdir(long_top);
+  if (failed)
+    return 1;
+  printf("lsp selftest: passed in %dms\n", (int)(now_ms() - start_ms));
+  return 0;
+#endif
+}
+
 static int run_repl_paste_case(const char *bin, const char *path,
                                const char *std_path, const char *std_bc,
                                int timeout_sec, int *dur_ms, char *why,
@@ -3743,7 +4232,7 @@ static int run_suite(const char *suite_name, StrVec *files, const char *bin, con
       }
     }
 #else
-    done = waitpid(-1, &st, WNOHANG);
+    done = test_reap_any(&st);
     if (done < 0 && errno == EINTR)
       continue;
 #endif
@@ -3764,8 +4253,10 @@ static int run_suite(const char *suite_name, StrVec *files, const char *bin, con
         st = NY_TEST_TIMEOUT_RC;
 #else
         kill(done, SIGKILL);
+        /* Zygote children are reaped by the zygote; drop their late EXIT. */
         while (waitpid(done, &st, 0) < 0 && errno == EINTR) {
         }
+        test_zygote_forget(done);
 #endif
         break;
       }
@@ -3995,6 +4486,10 @@ int ny_test_main(int argc, char **argv) {
       failures_only = 1;
     else if (!strcmp(a, "--progress-selftest"))
       return run_progress_selftest(bin, timeout_sec);
+    else if (!strcmp(a, "--zygote-selftest"))
+      return run_zygote_selftest(bin, timeout_sec);
+    else if (!strcmp(a, "--lsp-selftest"))
+      return run_lsp_selftest(bin, timeout_sec);
     else if (!strcmp(a, "--debug-failures"))
       ny_setenv("NYTRIX_TEST_DEBUG_FAILURES", "1", 1);
     else if (!strcmp(a, "--no-debug-failures"))
@@ -4159,6 +4654,7 @@ int ny_test_main(int argc, char **argv) {
     printf("%s[note]%s stdlib sweep disabled (use --with-stdlib or NYTRIX_TEST_WITH_STDLIB=1)\n",
            nyt_clr(NYT_GRAY), nyt_clr(NYT_RESET));
 
+  test_zygote_stop();
   if (use_cache)
     cache_save(&cache, cache_path);
 
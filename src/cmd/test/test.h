@@ -3,4 +3,8 @@
 
 int ny_test_main(int argc, char **argv);
 
+typedef int (*ny_test_zygote_run_fn)(int argc, char **argv, char **envp);
+/* `ny --test-zygote <fd>`: serve warm forked compiles to the test runner. */
+int ny_test_zygote_main(int argc, char **argv, ny_test_zygote_run_fn run, char **envp);
+
 #endif
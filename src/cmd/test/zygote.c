@@ -0,0 +1,445 @@
+/*
+ * Warm compile server for the test runner.
+ *
+ * `ny --test-zygote <fd>` loads its configuration, LLVM targets and the std
+ * module table once, then forks a copy-on-write child per request instead of
+ * the runner exec'ing a cold compiler for every file. The runner talks to it
+ * over a socketpair with newline-framed messages:
+ *
+ *   runner -> zygote   RUN <argc>\n <argv[i]>\n ... <output path or empty>\n
+ *   zygote -> runner   READY\n                  once, after warm-up
+ *                      PID <pid>\n              reply to each RUN (-1: fork failed)
+ *                      EXIT <pid> <status>\n    raw wait status of a finished child
+ *
+ * Children belong to the zygote, so the runner reaps them through EXIT lines;
+ * it can still kill(2) a timed-out child directly. Anything the zygote cannot
+ * do falls back to the plain fork/exec path.
+ */
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+
+#define NY_TEST_ZYGOTE_READY_MS 30000
+
+typedef struct {
+  pid_t pid;
+  int fd;
+  int state; /* 0 not started, 1 live, -1 unavailable */
+  char *buf;
+  size_t len;
+  size_t cap;
+  pid_t *exit_pid;
+  int *exit_status;
+  size_t exits_len;
+  size_t exits_cap;
+  pid_t forgotten[64];
+  size_t forgotten_len;
+} TestZygote;
+
+static TestZygote g_zygote = {.fd = -1};
+
+static int zygote_write_all(int fd, const char *data, size_t len) {
+  while (len > 0) {
+#ifdef MSG_NOSIGNAL
+    ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+#else
+    ssize_t n = write(fd, data, len);
+#endif
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    data += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+/* Appends whatever is readable within timeout_ms; returns 0 on EOF/error. */
+static int zygote_buf_fill(int fd, char **buf, size_t *len, size_t *cap, int timeout_ms) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  int pr = poll(&pfd, 1, timeout_ms);
+  if (pr < 0)
+    return errno == EINTR ? 1 : 0;
+  if (pr == 0)
+    return 1;
+  if (*len + 4096 > *cap) {
+    size_t nc = *cap ? *cap * 2 : 8192;
+    while (nc < *len + 4096)
+      nc *= 2;
+    char *next = realloc(*buf, nc);
+    if (!next)
+      return 0;
+    *buf = next;
+    *cap = nc;
+  }
+  ssize_t n = read(fd, *buf + *len, *cap - *len - 1);
+  if (n < 0)
+    return errno == EINTR || errno == EAGAIN ? 1 : 0;
+  if (n == 0)
+    return 0;
+  *len += (size_t)n;
+  (*buf)[*len] = '\0';
+  return 1;
+}
+
+/* Pops one complete line from the front of buf into out. */
+static int zygote_buf_line(char *buf, size_t *len, char *out, size_t cap) {
+  char *nl = *len ? memchr(buf, '\n', *len) : NULL;
+  if (!nl)
+    return 0;
+  size_t n = (size_t)(nl - buf);
+  size_t keep = n < cap - 1 ? n : cap - 1;
+  memcpy(out, buf, keep);
+  out[keep] = '\0';
+  *len -= n + 1;
+  memmove(buf, nl + 1, *len);
+  return 1;
+}
+
+static void test_zygote_queue_exit(pid_t pid, int status) {
+  if (g_zygote.exits_len == g_zygote.exits_cap) {
+    size_t nc = g_zygote.exits_cap ? g_zygote.exits_cap * 2 : 16;
+    pid_t *np = realloc(g_zygote.exit_pid, nc * sizeof(*np));
+    if (!np)
+      return;
+    g_zygote.exit_pid = np;
+    int *ns = realloc(g_zygote.exit_status, nc * sizeof(*ns));
+    if (!ns)
+      return;
+    g_zygote.exit_status = ns;
+    g_zygote.exits_cap = nc;
+  }
+  g_zygote.exit_pid[g_zygote.exits_len] = pid;
+  g_zygote.exit_status[g_zygote.exits_len] = status;
+  g_zygote.exits_len++;
+}
+
+static void test_zygote_lost(void) {
+  if (g_zygote.fd >= 0)
+    close(g_zygote.fd);
+  g_zygote.fd = -1;
+  g_zygote.state = -1;
+}
+
+/* Reads one line from the zygote, queueing EXIT notices; 0 on timeout or loss. */
+static int test_zygote_next_line(char *out, size_t cap, int timeout_ms) {
+  double deadline = now_ms() + timeout_ms;
+  for (;;) {
+    while (zygote_buf_line(g_zygote.buf, &g_zygote.len, out, cap)) {
+      long long pid = 0;
+      int status = 0;
+      if (sscanf(out, "EXIT %lld %d", &pid, &status) == 2) {
+        test_zygote_queue_exit((pid_t)pid, status);
+        continue;
+      }
+      return 1;
+    }
+    int left = (int)(deadline - now_ms());
+    if (left < 0)
+      left = 0;
+    if (!zygote_buf_fill(g_zygote.fd, &g_zygote.buf, &g_zygote.len, &g_zygote.cap, left)) {
+      test_zygote_lost();
+      return 0;
+    }
+    if (left == 0 && (!g_zygote.len || !memchr(g_zygote.buf, '\n', g_zygote.len)))
+      return 0;
+  }
+}
+
+static int test_zygote_enabled(void) { return !test_env_falsey("NYTRIX_TEST_ZYGOTE"); }
+
+static int test_zygote_start(const char *bin) {
+  if (g_zygote.state != 0)
+    return g_zygote.state > 0;
+  g_zygote.state = -1;
+  if (!bin || !test_zygote_enabled())
+    return 0;
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+    return 0;
+  char fd_arg[16];
+  snprintf(fd_arg, sizeof(fd_arg), "%d", sv[1]);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(sv[0]);
+    apply_test_child_env();
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+      dup2(devnull, STDOUT_FILENO);
+      dup2(devnull, STDERR_FILENO);
+      close(devnull);
+    }
+    char *argv[] = {(char *)bin, (char *)"--test-zygote", fd_arg, NULL};
+    execv(bin, argv);
+    _exit(127);
+  }
+  close(sv[1]);
+  if (pid < 0) {
+    close(sv[0]);
+    return 0;
+  }
+  (void)fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  (void)setsockopt(sv[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  g_zygote.pid = pid;
+  g_zygote.fd = sv[0];
+  g_zygote.state = 1;
+  char line[64];
+  if (test_zygote_next_line(line, sizeof(line), NY_TEST_ZYGOTE_READY_MS) &&
+      strcmp(line, "READY") == 0)
+    return 1;
+  /* Older compilers reject the flag and exit: fall back to fork/exec. */
+  test_zygote_lost();
+  kill(pid, SIGKILL);
+  while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
+  }
+  g_zygote.pid = 0;
+  return 0;
+}
+
+static void test_zygote_stop(void) {
+  if (g_zygote.pid > 0) {
+    test_zygote_lost();
+    while (waitpid(g_zygote.pid, NULL, 0) < 0 && errno == EINTR) {
+    }
+  }
+  free(g_zygote.buf);
+  free(g_zygote.exit_pid);
+  free(g_zygote.exit_status);
+  memset(&g_zygote, 0, sizeof(g_zygote));
+  g_zygote.fd = -1;
+  g_zygote.state = -1;
+}
+
+/* Starts argv in a warm child; returns its pid, or -1 to fall back to exec. */
+static pid_t test_zygote_spawn(const char *bin, char *const argv[], const char *output_path) {
+  if (!test_zygote_start(bin))
+    return -1;
+  size_t argc = 0;
+  for (; argv[argc]; ++argc) {
+    if (strchr(argv[argc], '\n'))
+      return -1;
+  }
+  if (output_path && strchr(output_path, '\n'))
+    return -1;
+  char head[32];
+  snprintf(head, sizeof(head), "RUN %zu\n", argc);
+  int ok = zygote_write_all(g_zygote.fd, head, strlen(head)) == 0;
+  for (size_t i = 0; ok && i < argc; ++i)
+    ok = zygote_write_all(g_zygote.fd, argv[i], strlen(argv[i])) == 0 &&
+         zygote_write_all(g_zygote.fd, "\n", 1) == 0;
+  if (ok && output_path)
+    ok = zygote_write_all(g_zygote.fd, output_path, strlen(output_path)) == 0;
+  ok = ok && zygote_write_all(g_zygote.fd, "\n", 1) == 0;
+  char line[64];
+  long long pid = -1;
+  if (!ok || !test_zygote_next_line(line, sizeof(line), NY_TEST_ZYGOTE_READY_MS) ||
+      sscanf(line, "PID %lld", &pid) != 1) {
+    test_zygote_lost();
+    return -1;
+  }
+  return (pid_t)pid;
+}
+
+/* A killed child's EXIT may still be in flight; it must not be reported again. */
+static void test_zygote_forget(pid_t pid) {
+  if (g_zygote.state <= 0 || pid <= 0)
+    return;
+  for (size_t i = 0; i < g_zygote.exits_len; ++i) {
+    if (g_zygote.exit_pid[i] == pid) {
+      g_zygote.exit_pid[i] = -1;
+      return;
+    }
+  }
+  if (g_zygote.forgotten_len < sizeof(g_zygote.forgotten) / sizeof(g_zygote.forgotten[0]))
+    g_zygote.forgotten[g_zygote.forgotten_len++] = pid;
+}
+
+static int test_zygote_forgotten(pid_t pid) {
+  if (pid < 0)
+    return 1;
+  for (size_t i = 0; i < g_zygote.forgotten_len; ++i) {
+    if (g_zygote.forgotten[i] == pid) {
+      g_zygote.forgotten[i] = g_zygote.forgotten[--g_zygote.forgotten_len];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Non-blocking reap of one finished child, from the zygote or from fork/exec. */
+static pid_t test_reap_any(int *status) {
+  if (g_zygote.state > 0 && !g_zygote.exits_len) {
+    char line[64];
+    if (test_zygote_next_line(line, sizeof(line), 0))
+      return 0; /* stray reply; nothing finished */
+  }
+  if (g_zygote.exits_len) {
+    pid_t pid = g_zygote.exit_pid[0];
+    *status = g_zygote.exit_status[0];
+    g_zygote.exits_len--;
+    memmove(g_zygote.exit_pid, g_zygote.exit_pid + 1, g_zygote.exits_len * sizeof(pid_t));
+    memmove(g_zygote.exit_status, g_zygote.exit_status + 1, g_zygote.exits_len * sizeof(int));
+    return test_zygote_forgotten(pid) ? 0 : pid;
+  }
+  pid_t done = waitpid(-1, status, WNOHANG);
+  if (done > 0 && done == g_zygote.pid) {
+    test_zygote_lost();
+    g_zygote.pid = 0;
+    return 0;
+  }
+  return done;
+}
+
+/* Zygote side. */
+
+static int g_zygote_chld_pipe[2] = {-1, -1};
+
+static void zygote_on_sigchld(int sig) {
+  (void)sig;
+  int saved = errno;
+  if (write(g_zygote_chld_pipe[1], "c", 1) < 0) {
+  }
+  errno = saved;
+}
+
+static void zygote_reap(int fd) {
+  int status = 0;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    char line[64];
+    int n = snprintf(line, sizeof(line), "EXIT %lld %d\n", (long long)pid, status);
+    (void)zygote_write_all(fd, line, (size_t)n);
+  }
+}
+
+static pid_t zygote_fork_one(int fd, char **argv, int argc, const char *output_path,
+                             ny_test_zygote_run_fn run, char **envp) {
+  pid_t pid = fork();
+  if (pid != 0)
+    return pid;
+  signal(SIGCHLD, SIG_DFL);
+  signal(SIGPIPE, SIG_DFL);
+  close(fd);
+  close(g_zygote_chld_pipe[0]);
+  close(g_zygote_chld_pipe[1]);
+  int out = output_path && *output_path ? open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                                        : open("/dev/null", O_WRONLY);
+  if (out >= 0) {
+    dup2(out, STDOUT_FILENO);
+    dup2(out, STDERR_FILENO);
+    close(out);
+  }
+  exit(run(argc, argv, envp));
+}
+
+/* Handles every complete RUN request at the front of buf. */
+static void zygote_serve_requests(int fd, char *buf, size_t *len, ny_test_zygote_run_fn run,
+                                  char **envp) {
+  for (;;) {
+    char *nl = *len ? memchr(buf, '\n', *len) : NULL;
+    if (!nl)
+      return;
+    unsigned argc = 0;
+    if (sscanf(buf, "RUN %u", &argc) != 1 || argc == 0 || argc > 256) {
+      *len -= (size_t)(nl + 1 - buf);
+      memmove(buf, nl + 1, *len);
+      continue;
+    }
+    /* The request is complete once its argc + 1 payload lines have arrived. */
+    char *lines[258];
+    char *p = nl + 1;
+    char *end = buf + *len;
+    unsigned have = 0;
+    while (have < argc + 1 && p < end) {
+      char *e = memchr(p, '\n', (size_t)(end - p));
+      if (!e)
+        break;
+      lines[have++] = p;
+      *e = '\0';
+      p = e + 1;
+    }
+    if (have < argc + 1) {
+      for (unsigned i = 0; i < have; ++i)
+        lines[i][strlen(lines[i])] = '\n';
+      return;
+    }
+    lines[argc] = lines[argc][0] ? lines[argc] : NULL;
+    char *output_path = lines[argc];
+    lines[argc] = NULL;
+    pid_t pid = zygote_fork_one(fd, lines, (int)argc, output_path, run, envp);
+    char reply[48];
+    int n = snprintf(reply, sizeof(reply), "PID %lld\n", (long long)(pid > 0 ? pid : -1));
+    (void)zygote_write_all(fd, reply, (size_t)n);
+    *len -= (size_t)(p - buf);
+    memmove(buf, p, *len);
+  }
+}
+
+int ny_test_zygote_main(int argc, char **argv, ny_test_zygote_run_fn run, char **envp) {
+  if (argc < 3 || !run)
+    return 2;
+  int fd = atoi(argv[2]);
+  if (fd < 0 || fcntl(fd, F_GETFD) < 0)
+    return 2;
+  (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+  if (pipe(g_zygote_chld_pipe) != 0)
+    return 1;
+  for (int i = 0; i < 2; ++i) {
+    (void)fcntl(g_zygote_chld_pipe[i], F_SETFD, FD_CLOEXEC);
+    (void)fcntl(g_zygote_chld_pipe[i], F_SETFL, O_NONBLOCK);
+  }
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = zygote_on_sigchld;
+  sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGCHLD, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+  if (zygote_write_all(fd, "READY\n", 6) != 0)
+    return 1;
+
+  char *buf = NULL;
+  size_t len = 0, cap = 0;
+  for (;;) {
+    struct pollfd pfd[2] = {{fd, POLLIN, 0}, {g_zygote_chld_pipe[0], POLLIN, 0}};
+    if (poll(pfd, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (pfd[1].revents & POLLIN) {
+      char drain[64];
+      while (read(g_zygote_chld_pipe[0], drain, sizeof(drain)) > 0) {
+      }
+      zygote_reap(fd);
+    }
+    if (pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      if (!zygote_buf_fill(fd, &buf, &len, &cap, 0))
+        break;
+      zygote_serve_requests(fd, buf, &len, run, envp);
+    }
+  }
+  free(buf);
+  close(fd);
+  return 0;
+}
+
+#else
+
+static void test_zygote_stop(void) {}
+
+int ny_test_zygote_main(int argc, char **argv, ny_test_zygote_run_fn run, char **envp) {
+  (void)argc;
+  (void)argv;
+  (void)run;
+  (void)envp;
+  fprintf(stderr, "ny: --test-zygote is not supported on Windows\n");
+  return 2;
+}
+
+#endif
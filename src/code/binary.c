@@ -1946,16 +1946,14 @@ static LLVMValueRef ny_try_emit_tagged_int_fast_binary(codegen_t *cg, scope *sco
 static LLVMValueRef ny_direct_unbox_float(codegen_t *cg, LLVMValueRef v) {
   if (ny_module_target_is_apple_arm64(cg ? cg->module : NULL))
     return ny_unbox_float(cg, v);
-  LLVMValueRef ptr = LLVMBuildIntToPtr(cg->builder, v, LLVMPointerType(cg->type_f64, 0), "");
-  return LLVMBuildLoad2(cg->builder, cg->type_f64, ptr, "flt_load");
+  return ny_flt_payload(cg, v, "flt_load");
 }
 
 static LLVMValueRef ny_direct_box_float(codegen_t *cg, LLVMValueRef fval) {
   fun_sig *box_sig = lookup_fun(cg, "__flt_box_val", 0);
   if (!box_sig)
     return ny_c0(cg);
-  return LLVMBuildCall2(cg->builder, box_sig->type, box_sig->value,
-                        (LLVMValueRef[]){ny_bitcast(cg, fval, cg->type_i64, "")}, 1, "box");
+  return ny_box_f64_bits(cg, ny_bitcast(cg, fval, cg->type_i64, ""), box_sig);
 }
 
 static bool ny_bin_type_is_ptr_like(const char *type_name) {
@@ -278,6 +278,7 @@ typedef struct codegen_llvm_t {
   bool llvm_ctx_owned;
   LLVMExecutionEngineRef ee;
   void *orc_jit;
+  void *comptime_session;
   LLVMValueRef setjmp_fn;
   LLVMTypeRef setjmp_ty;
 } codegen_llvm_t;
@@ -540,6 +541,7 @@ struct codegen_t {
       bool llvm_ctx_owned;
       LLVMExecutionEngineRef ee;
       void *orc_jit;
+      void *comptime_session;
       LLVMValueRef setjmp_fn;
       LLVMTypeRef setjmp_ty;
     };
@@ -803,6 +805,8 @@ void ny_cg_emit_trace_return(codegen_t *cg, LLVMValueRef v,
 void ny_cg_emit_trace_return_void(codegen_t *cg);
 void codegen_debug_init(codegen_t *cg, const char *main_file);
 void codegen_debug_finalize(codegen_t *cg);
+void ny_pgo_annotate_functions(codegen_t *cg);
+void ny_pgo_place_hot_functions(LLVMModuleRef module);
 LLVMMetadataRef codegen_debug_subprogram(codegen_t *cg, LLVMValueRef func,
                                          const char *name, token_t tok);
 void codegen_debug_variable(codegen_t *cg, const char *name,
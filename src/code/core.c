@@ -2933,6 +2933,10 @@ void codegen_dispose(codegen_t *cg) {
     ny_orc_jit_dispose(cg->orc_jit);
     cg->orc_jit = NULL;
   }
+  if (cg->comptime_session) {
+    ny_comptime_session_free(cg->comptime_session);
+    cg->comptime_session = NULL;
+  }
   if (cg->builder) {
     LLVMDisposeBuilder(cg->builder);
     cg->builder = NULL;
@@ -3120,13 +3120,174 @@ static LLVMValueRef gen_range_expr(codegen_t *cg, scope *scopes, size_t depth, e
                         NY_LLVM_NAME(cg, "range"));
 }
 
+/*
+ * Float payload of a value already known to be a float. With
+ * NYTRIX_INLINE_FLOAT (base/value.h) the value may be an inline float, which
+ * decodes with shifts and no load; otherwise it is a pointer to the boxed
+ * double.
+ */
+LLVMValueRef ny_flt_payload(codegen_t *cg, LLVMValueRef v, const char *name) {
+#if NY_VALUE_HAS_INLINE_FLOAT
+  LLVMValueRef fn = ny_cur_fn(cg);
+  LLVMBasicBlockRef imm_bb = ny_bb_fn(fn, "flt.imm");
+  LLVMBasicBlockRef box_bb = ny_bb_fn(fn, "flt.box");
+  LLVMBasicBlockRef done_bb = ny_bb_fn(fn, "flt.done");
+  ny_cond_br(cg, ny_flt_imm_pred(cg, v), imm_bb, box_bb);
+
+  ny_pos(cg, imm_bb);
+  LLVMValueRef rot = LLVMBuildLShr(
+      cg->builder, v, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_SHIFT, false),
+      NY_LLVM_NAME(cg, "flt_imm_rot"));
+  LLVMValueRef rebased =
+      ny_add(cg, rot, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_EXP_BIAS, false),
+             "flt_imm_rebased");
+  rot = ny_select(cg, ny_ugt(cg, rot, ny_c1(cg), "flt_imm_nonzero"), rebased,
+                  rot, "flt_imm_exp");
+  LLVMValueRef bits =
+      ny_or(cg,
+            LLVMBuildLShr(cg->builder, rot, ny_c1(cg),
+                          NY_LLVM_NAME(cg, "flt_imm_hi")),
+            ny_shl(cg, rot, LLVMConstInt(cg->type_i64, 63, false),
+                   "flt_imm_sign"),
+            "flt_imm_bits");
+  LLVMValueRef from_imm = ny_bitcast(cg, bits, cg->type_f64, "flt_imm");
+  LLVMBasicBlockRef imm_done = ny_cur_block(cg);
+  ny_br(cg, done_bb);
+
+  ny_pos(cg, box_bb);
+  LLVMValueRef ptr =
+      LLVMBuildIntToPtr(cg->builder, v, LLVMPointerType(cg->type_f64, 0), "");
+  LLVMValueRef from_box = LLVMBuildLoad2(cg->builder, cg->type_f64, ptr,
+                                         NY_LLVM_NAME(cg, name));
+  LLVMBasicBlockRef box_done = ny_cur_block(cg);
+  ny_br(cg, done_bb);
+
+  ny_pos(cg, done_bb);
+  LLVMValueRef phi = ny_phi(cg, cg->type_f64, NY_LLVM_NAME(cg, name));
+  LLVMAddIncoming(phi, (LLVMValueRef[]){from_imm, from_box},
+                  (LLVMBasicBlockRef[]){imm_done, box_done}, 2);
+  return phi;
+#else
+  LLVMValueRef ptr =
+      LLVMBuildIntToPtr(cg->builder, v, LLVMPointerType(cg->type_f64, 0), "");
+  return LLVMBuildLoad2(cg->builder, cg->type_f64, ptr, NY_LLVM_NAME(cg, name));
+#endif
+}
+
+LLVMValueRef ny_flt_imm_pred(codegen_t *cg, LLVMValueRef v) {
+#if NY_VALUE_HAS_INLINE_FLOAT
+  LLVMValueRef low =
+      ny_and(cg, v, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_TAG_MASK, false),
+             "flt_imm_low");
+  LLVMValueRef tagged =
+      ny_eq(cg, low, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_TAG, false),
+            "flt_imm_tag");
+  /* Same range test as ny_value_is_flt_imm: keeps `ptr + 4` a pointer. */
+  LLVMValueRef off = ny_sub(
+      cg, v, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_ZERO_MAX, false),
+      "flt_imm_off");
+  LLVMValueRef ranged = ny_icmp(
+      cg, LLVMIntUGE, off,
+      LLVMConstInt(cg->type_i64,
+                   NY_VALUE_FLT_MIN_NONZERO - NY_VALUE_FLT_ZERO_MAX, false),
+      "flt_imm_range");
+  return ny_and(cg, tagged, ranged, "is_flt_imm");
+#else
+  (void)v;
+  return LLVMConstInt(ny_i1_ty(cg), 0, false);
+#endif
+}
+
+/*
+ * Box the f64 bit pattern `bits` as a float value. Inline-encodable values
+ * never reach __flt_box_val when NYTRIX_INLINE_FLOAT is on.
+ */
+LLVMValueRef ny_box_f64_bits(codegen_t *cg, LLVMValueRef bits, fun_sig *box_sig) {
+#if NY_VALUE_HAS_INLINE_FLOAT
+  LLVMValueRef rot =
+      ny_or(cg, ny_shl(cg, bits, ny_c1(cg), "flt_enc_hi"),
+            LLVMBuildLShr(cg->builder, bits,
+                          LLVMConstInt(cg->type_i64, 63, false),
+                          NY_LLVM_NAME(cg, "flt_enc_sign")),
+            "flt_enc_rot");
+  LLVMValueRef exp = ny_and(
+      cg,
+      LLVMBuildLShr(cg->builder, bits, LLVMConstInt(cg->type_i64, 52, false),
+                    NY_LLVM_NAME(cg, "flt_enc_exp_hi")),
+      LLVMConstInt(cg->type_i64, 0x7ff, false), "flt_enc_exp");
+  LLVMValueRef in_range = ny_icmp(
+      cg, LLVMIntULE,
+      ny_sub(cg, exp, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_EXP_MIN, false),
+             "flt_enc_exp_off"),
+      LLVMConstInt(cg->type_i64, NY_VALUE_FLT_EXP_MAX - NY_VALUE_FLT_EXP_MIN,
+                   false),
+      "flt_enc_in_range");
+  LLVMValueRef is_zero = ny_icmp(cg, LLVMIntULE, rot, ny_c1(cg), "flt_enc_zero");
+  LLVMValueRef fits = ny_or(cg, in_range, is_zero, "flt_enc_fits");
+  LLVMValueRef rebased =
+      ny_sub(cg, rot, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_EXP_BIAS, false),
+             "flt_enc_rebased");
+  rot = ny_select(cg, is_zero, rot, rebased, "flt_enc_exp");
+  LLVMValueRef imm = ny_or(
+      cg,
+      ny_shl(cg, rot, LLVMConstInt(cg->type_i64, NY_VALUE_FLT_SHIFT, false),
+             "flt_enc_shifted"),
+      LLVMConstInt(cg->type_i64, NY_VALUE_FLT_TAG, false), "flt_enc_imm");
+  if (!box_sig)
+    return ny_select(cg, fits, imm, ny_c0(cg), "flt_enc");
+
+  LLVMValueRef fn = ny_cur_fn(cg);
+  LLVMBasicBlockRef imm_bb = ny_cur_block(cg);
+  LLVMBasicBlockRef box_bb = ny_bb_fn(fn, "flt_enc.box");
+  LLVMBasicBlockRef done_bb = ny_bb_fn(fn, "flt_enc.done");
+  ny_cond_br(cg, fits, done_bb, box_bb);
+
+  ny_pos(cg, box_bb);
+  LLVMValueRef boxed = LLVMBuildCall2(cg->builder, box_sig->type,
+                                      box_sig->value, &bits, 1, "box");
+  LLVMBasicBlockRef box_done = ny_cur_block(cg);
+  ny_br(cg, done_bb);
+
+  ny_pos(cg, done_bb);
+  LLVMValueRef phi = ny_phi(cg, cg->type_i64, NY_LLVM_NAME(cg, "flt_enc"));
+  LLVMAddIncoming(phi, (LLVMValueRef[]){imm, boxed},
+                  (LLVMBasicBlockRef[]){imm_bb, box_done}, 2);
+  return phi;
+#else
+  if (!box_sig)
+    return ny_c0(cg);
+  return LLVMBuildCall2(cg->builder, box_sig->type, box_sig->value, &bits, 1,
+                        "box");
+#endif
+}
+
 LLVMValueRef ny_is_float(codegen_t *cg, LLVMValueRef v) {
   fun_sig *s = lookup_fun(cg, "__is_float_obj", 0);
   if (!s)
     return LLVMConstInt(ny_i1_ty(cg), 0, false);
+#if NY_VALUE_HAS_INLINE_FLOAT
+  LLVMValueRef fn = ny_cur_fn(cg);
+  LLVMBasicBlockRef imm_bb = ny_cur_block(cg);
+  LLVMBasicBlockRef call_bb = ny_bb_fn(fn, "is_flt.box");
+  LLVMBasicBlockRef done_bb = ny_bb_fn(fn, "is_flt.done");
+  ny_cond_br(cg, ny_flt_imm_pred(cg, v), done_bb, call_bb);
+  ny_pos(cg, call_bb);
+  LLVMValueRef res_tagged = LLVMBuildCall2(cg->builder, s->type, s->value,
+                                           (LLVMValueRef[]){v}, 1, "");
+  LLVMValueRef boxed = ny_eq(cg, res_tagged, ny_ctrue(cg), "is_flt_box");
+  LLVMBasicBlockRef call_done = ny_cur_block(cg);
+  ny_br(cg, done_bb);
+  ny_pos(cg, done_bb);
+  LLVMValueRef phi = ny_phi(cg, ny_i1_ty(cg), NY_LLVM_NAME(cg, "is_flt"));
+  LLVMAddIncoming(phi,
+                  (LLVMValueRef[]){LLVMConstInt(ny_i1_ty(cg), 1, false), boxed},
+                  (LLVMBasicBlockRef[]){imm_bb, call_done}, 2);
+  return phi;
+#else
   LLVMValueRef res_tagged = LLVMBuildCall2(cg->builder, s->type, s->value,
                                            (LLVMValueRef[]){v}, 1, "");
   return ny_eq(cg, res_tagged, ny_ctrue(cg), "is_flt");
+#endif
 }
 
 LLVMValueRef ny_unbox_float(codegen_t *cg, LLVMValueRef v) {
@@ -3159,10 +3320,7 @@ LLVMValueRef ny_unbox_float(codegen_t *cg, LLVMValueRef v) {
   ny_cond_br(cg, ny_is_float(cg, v), flt_bb, fallback_bb);
 
   ny_pos(cg, flt_bb);
-  LLVMValueRef ptr =
-      LLVMBuildIntToPtr(cg->builder, v, LLVMPointerType(cg->type_f64, 0), "");
-  LLVMValueRef d_from_p = LLVMBuildLoad2(cg->builder, cg->type_f64, ptr,
-                                         NY_LLVM_NAME(cg, "d_from_p"));
+  LLVMValueRef d_from_p = ny_flt_payload(cg, v, "d_from_p");
   LLVMBasicBlockRef flt_done_bb = ny_cur_block(cg);
   ny_br(cg, done_bb);
 
@@ -3201,11 +3359,7 @@ static LLVMValueRef ny_unbox_known_numeric_float(codegen_t *cg, LLVMValueRef v)
   ny_br(cg, done_bb);
 
   ny_pos(cg, flt_bb);
-  LLVMValueRef ptr =
-      LLVMBuildIntToPtr(cg->builder, v, LLVMPointerType(cg->type_f64, 0),
-                        "known_flt_ptr");
-  LLVMValueRef from_ptr =
-      LLVMBuildLoad2(cg->builder, cg->type_f64, ptr, "known_flt_load");
+  LLVMValueRef from_ptr = ny_flt_payload(cg, v, "known_flt_load");
   LLVMBasicBlockRef flt_done = ny_cur_block(cg);
   ny_br(cg, done_bb);
 
@@ -3288,11 +3442,7 @@ static LLVMValueRef ny_try_emit_f64_list_get_as_f64(codegen_t *cg,
     elem_ptr = LLVMBuildIntToPtr(cg->builder, elem_addr, ny_ptr_i64_ty(cg),
                                  "f64_list_get_elem_ptr_i64");
     boxed = ny_load(cg, elem_ptr, "f64_list_get_elem");
-    LLVMValueRef ptr = LLVMBuildIntToPtr(
-        cg->builder, boxed, LLVMPointerType(cg->type_f64, 0),
-        "f64_list_get_fptr");
-    return LLVMBuildLoad2(cg->builder, cg->type_f64, ptr,
-                          "f64_list_get_f64");
+    return ny_flt_payload(cg, boxed, "f64_list_get_f64");
   }
 
   LLVMBasicBlockRef entry_bb = ny_cur_block(cg);
@@ -3322,11 +3472,7 @@ static LLVMValueRef ny_try_emit_f64_list_get_as_f64(codegen_t *cg,
   elem_ptr = LLVMBuildIntToPtr(cg->builder, elem_addr, ny_ptr_i64_ty(cg),
                                "f64_list_get_elem_ptr_i64");
   boxed = ny_load(cg, elem_ptr, "f64_list_get_elem");
-  LLVMValueRef ptr =
-      LLVMBuildIntToPtr(cg->builder, boxed, LLVMPointerType(cg->type_f64, 0),
-                        "f64_list_get_fptr");
-  LLVMValueRef loaded =
-      LLVMBuildLoad2(cg->builder, cg->type_f64, ptr, "f64_list_get_f64");
+  LLVMValueRef loaded = ny_flt_payload(cg, boxed, "f64_list_get_f64");
   LLVMBasicBlockRef load_done = ny_cur_block(cg);
   ny_br(cg, join_bb);
 
@@ -4255,6 +4401,584 @@ static void ny_ct_emit_std_init(codegen_t *tcg, codegen_t *parent,
   ny_ct_emit_parent_std_init(tcg, parent, scopes, depth);
 }
 
+typedef struct ny_ct_memo_entry_t {
+  uint64_t key;
+  char *data;
+  size_t len;
+} ny_ct_memo_entry_t;
+
+typedef struct ny_ct_session_t {
+  VEC(ny_ct_memo_entry_t) memo;
+  size_t hits;
+  size_t disk_hits;
+  size_t stores;
+  size_t jit_runs;
+  size_t pruned_functions;
+} ny_ct_session_t;
+
+static bool ny_ct_trace_enabled(void) {
+  static int enabled = -1;
+  if (enabled < 0)
+    enabled = ny_env_enabled("NYTRIX_TRACE_COMPTIME") ? 1 : 0;
+  return enabled == 1;
+}
+
+static ny_ct_session_t *ny_ct_session_get(codegen_t *cg) {
+  codegen_t *root = cg;
+  while (root && root->parent)
+    root = root->parent;
+  if (!root)
+    return NULL;
+  if (!root->comptime_session)
+    root->comptime_session = calloc(1, sizeof(ny_ct_session_t));
+  return (ny_ct_session_t *)root->comptime_session;
+}
+
+void ny_comptime_session_free(void *session) {
+  ny_ct_session_t *s = (ny_ct_session_t *)session;
+  if (!s)
+    return;
+  if (ny_ct_trace_enabled()) {
+    fprintf(stderr,
+            "[comptime] session memo=%zu hits=%zu disk_hits=%zu stores=%zu "
+            "jit_runs=%zu pruned_functions=%zu\n",
+            s->memo.len, s->hits, s->disk_hits, s->stores, s->jit_runs,
+            s->pruned_functions);
+  }
+  for (size_t i = 0; i < s->memo.len; i++)
+    free(s->memo.data[i].data);
+  vec_free(&s->memo);
+  free(s);
+}
+
+/* Memo values use a small self-describing encoding so they can be stored in
+ * the compile cache:  n/f/t, i<tagged hex>, s<len>:<bytes>, L|T<n>:<items>,
+ * D<n>:<key value ...>, R<start>,<stop>,<step> (tagged hex). */
+#define NY_CT_MEMO_MAGIC "NYCT1"
+
+typedef struct ny_ct_memo_buf_t {
+  char *data;
+  size_t len;
+  size_t cap;
+  bool failed;
+} ny_ct_memo_buf_t;
+
+static void ny_ct_memo_put(ny_ct_memo_buf_t *b, const void *src, size_t n) {
+  if (!b || b->failed)
+    return;
+  if (b->len + n + 1 > b->cap) {
+    size_t next = b->cap ? b->cap * 2 : 256;
+    while (next < b->len + n + 1)
+      next *= 2;
+    if (next > ((size_t)64 << 20)) {
+      b->failed = true;
+      return;
+    }
+    char *grown = realloc(b->data, next);
+    if (!grown) {
+      b->failed = true;
+      return;
+    }
+    b->data = grown;
+    b->cap = next;
+  }
+  memcpy(b->data + b->len, src, n);
+  b->len += n;
+  b->data[b->len] = '\0';
+}
+
+static void ny_ct_memo_putf(ny_ct_memo_buf_t *b, const char *fmt, ...) {
+  char tmp[96];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= sizeof(tmp)) {
+    if (b)
+      b->failed = true;
+    return;
+  }
+  ny_ct_memo_put(b, tmp, (size_t)n);
+}
+
+static bool ny_ct_memo_encode(ny_ct_memo_buf_t *b, int64_t v, int depth) {
+  if (!b || b->failed || depth > 64)
+    return false;
+  if (v == NY_IMM_NIL) {
+    ny_ct_memo_put(b, "n", 1);
+    return !b->failed;
+  }
+  if (v == NY_IMM_FALSE || v == NY_IMM_TRUE) {
+    ny_ct_memo_put(b, v == NY_IMM_TRUE ? "t" : "f", 1);
+    return !b->failed;
+  }
+  if (is_int(v)) {
+    ny_ct_memo_putf(b, "i%016" PRIx64, (uint64_t)v);
+    return !b->failed;
+  }
+  if (is_v_str(v)) {
+    size_t len = rt_tagged_str_len(v);
+    ny_ct_memo_putf(b, "s%zu:", len);
+    ny_ct_memo_put(b, (const char *)(uintptr_t)v, len);
+    return !b->failed;
+  }
+  int64_t tag = 0;
+  if (!ny_ct_jit_heap_tag(v, &tag))
+    return false;
+  bool known_raw_tag = tag == TAG_LIST || tag == TAG_TUPLE ||
+                       tag == TAG_DICT || tag == TAG_RANGE;
+  int64_t decoded_tag = is_int(tag) ? tag >> 1 : tag;
+  bool tagged_heap_header =
+      !known_raw_tag && (decoded_tag == TAG_LIST || decoded_tag == TAG_TUPLE ||
+                         decoded_tag == TAG_DICT || decoded_tag == TAG_RANGE);
+  if (tagged_heap_header)
+    tag = decoded_tag;
+  if (tag == TAG_LIST || tag == TAG_TUPLE) {
+    int64_t n = 0;
+    if (!ny_ct_jit_seq_len(v, &n))
+      return false;
+    ny_ct_memo_putf(b, "%c%" PRId64 ":", tag == TAG_TUPLE ? 'T' : 'L', n);
+    for (int64_t i = 0; i < n; i++) {
+      int64_t item = 0;
+      if (!ny_ct_jit_seq_item(v, i, &item) ||
+          !ny_ct_memo_encode(b, item, depth + 1))
+        return false;
+    }
+    return !b->failed;
+  }
+  if (tag == TAG_DICT) {
+    int64_t p = rt_heap_object_ptr(v);
+    int64_t count_v = 0, cap_v = 0;
+    if (!p || !rt_try_read_i64((uintptr_t)p, &count_v) ||
+        !rt_try_read_i64((uintptr_t)p + 8, &cap_v))
+      return false;
+    int64_t count = tagged_heap_header ? count_v :
+                    (is_int(count_v) ? count_v >> 1 : count_v);
+    int64_t cap = tagged_heap_header ? cap_v :
+                  (is_int(cap_v) ? cap_v >> 1 : cap_v);
+    if (count < 0 || cap < count || cap > 65536)
+      return false;
+    ny_ct_memo_putf(b, "D%" PRId64 ":", count);
+    int64_t copied = 0;
+    for (int64_t i = 0; i < cap && copied < count; i++) {
+      uintptr_t off = (uintptr_t)p + 16 + (uintptr_t)i * 24;
+      int64_t state = 0;
+      if (!rt_try_read_i64(off + 16, &state))
+        return false;
+      int64_t state_raw = tagged_heap_header ? state :
+                          (is_int(state) ? state >> 1 : state);
+      if (state_raw != 1)
+        continue;
+      int64_t key_raw = 0, value_raw = 0;
+      if (!rt_try_read_i64(off, &key_raw) ||
+          !rt_try_read_i64(off + 8, &value_raw) ||
+          !ny_ct_memo_encode(b, key_raw, depth + 1) ||
+          !ny_ct_memo_encode(b, value_raw, depth + 1))
+        return false;
+      copied++;
+    }
+    return copied == count && !b->failed;
+  }
+  if (tag == TAG_RANGE) {
+    int64_t p = rt_heap_object_ptr(v);
+    int64_t start = 0, stop = 0, step = 0;
+    if (!p || !rt_try_read_i64((uintptr_t)p + 0, &start) ||
+        !rt_try_read_i64((uintptr_t)p + 8, &stop) ||
+        !rt_try_read_i64((uintptr_t)p + 16, &step))
+      return false;
+    ny_ct_memo_putf(b, "R%016" PRIx64 ",%016" PRIx64 ",%016" PRIx64,
+                    (uint64_t)start, (uint64_t)stop, (uint64_t)step);
+    return !b->failed;
+  }
+  return false;
+}
+
+typedef struct ny_ct_memo_reader_t {
+  const char *p;
+  const char *end;
+} ny_ct_memo_reader_t;
+
+static bool ny_ct_memo_read_size(ny_ct_memo_reader_t *r, char stop,
+                                 uint64_t *out) {
+  uint64_t n = 0;
+  const char *start = r->p;
+  while (r->p < r->end && *r->p >= '0' && *r->p <= '9') {
+    if (n > (UINT64_MAX - 9) / 10)
+      return false;
+    n = n * 10 + (uint64_t)(*r->p - '0');
+    r->p++;
+  }
+  if (r->p == start || r->p >= r->end || *r->p != stop)
+    return false;
+  r->p++;
+  *out = n;
+  return true;
+}
+
+static bool ny_ct_memo_read_hex(ny_ct_memo_reader_t *r, uint64_t *out) {
+  if ((size_t)(r->end - r->p) < 16)
+    return false;
+  uint64_t v = 0;
+  for (int i = 0; i < 16; i++) {
+    char c = r->p[i];
+    int d = (c >= '0' && c <= '9')   ? c - '0'
+            : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                     : -1;
+    if (d < 0)
+      return false;
+    v = (v << 4) | (uint64_t)d;
+  }
+  r->p += 16;
+  *out = v;
+  return true;
+}
+
+static bool ny_ct_memo_skip(ny_ct_memo_reader_t *r, int depth) {
+  if (depth > 64 || r->p >= r->end)
+    return false;
+  char k = *r->p++;
+  uint64_t n = 0, raw = 0;
+  switch (k) {
+  case 'n':
+  case 'f':
+  case 't':
+    return true;
+  case 'i':
+    return ny_ct_memo_read_hex(r, &raw) && is_int((int64_t)raw);
+  case 's':
+    if (!ny_ct_memo_read_size(r, ':', &n) || n > (uint64_t)(r->end - r->p))
+      return false;
+    r->p += n;
+    return true;
+  case 'L':
+  case 'T':
+  case 'D':
+    if (!ny_ct_memo_read_size(r, ':', &n) || n > 65536)
+      return false;
+    for (uint64_t i = 0; i < (k == 'D' ? n * 2 : n); i++) {
+      if (!ny_ct_memo_skip(r, depth + 1))
+        return false;
+    }
+    return true;
+  case 'R':
+    for (int i = 0; i < 3; i++) {
+      if (i && (r->p >= r->end || *r->p++ != ','))
+        return false;
+      if (!ny_ct_memo_read_hex(r, &raw))
+        return false;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool ny_ct_memo_valid(const char *data, size_t len) {
+  size_t magic_len = sizeof(NY_CT_MEMO_MAGIC) - 1;
+  if (!data || len <= magic_len || memcmp(data, NY_CT_MEMO_MAGIC, magic_len))
+    return false;
+  ny_ct_memo_reader_t r = {data + magic_len, data + len};
+  return ny_ct_memo_skip(&r, 0) && r.p == r.end;
+}
+
+static LLVMValueRef ny_ct_memo_materialize(codegen_t *cg,
+                                           ny_ct_memo_reader_t *r,
+                                           token_t tok, int depth) {
+  if (!cg || depth > 64 || r->p >= r->end)
+    return NULL;
+  char k = *r->p++;
+  uint64_t n = 0, raw = 0;
+  switch (k) {
+  case 'n':
+    return LLVMConstInt(cg->type_i64, (uint64_t)NY_IMM_NIL, true);
+  case 'f':
+    return LLVMConstInt(cg->type_i64, (uint64_t)NY_IMM_FALSE, true);
+  case 't':
+    return LLVMConstInt(cg->type_i64, (uint64_t)NY_IMM_TRUE, true);
+  case 'i':
+    if (!ny_ct_memo_read_hex(r, &raw))
+      return NULL;
+    return LLVMConstInt(cg->type_i64, raw, true);
+  case 's': {
+    if (!ny_ct_memo_read_size(r, ':', &n) || n > (uint64_t)(r->end - r->p))
+      return NULL;
+    LLVMValueRef g = const_string_ptr(cg, r->p, (size_t)n);
+    r->p += n;
+    return ny_load(cg, g, NY_LLVM_NAME(cg, "ct_memo_str"));
+  }
+  case 'L':
+  case 'T': {
+    if (!ny_ct_memo_read_size(r, ':', &n))
+      return NULL;
+    fun_sig *list_new = lookup_fun(cg, "__list_new", 0);
+    fun_sig *store_item = lookup_fun(cg, "__store_item_fast", 0);
+    fun_sig *set_len = lookup_fun(cg, "__list_set_len", 0);
+    if (!list_new || !store_item || !set_len)
+      return expr_fail(cg, tok,
+                       "comptime list result requires list runtime helpers");
+    LLVMValueRef tagged_len =
+        LLVMConstInt(cg->type_i64, ((n << 1) | 1u), false);
+    LLVMValueRef out =
+        LLVMBuildCall2(cg->builder, list_new->type, list_new->value,
+                       (LLVMValueRef[]){tagged_len}, 1,
+                       NY_LLVM_NAME(cg, "ct_memo_list"));
+    for (uint64_t i = 0; i < n; i++) {
+      LLVMValueRef item = ny_ct_memo_materialize(cg, r, tok, depth + 1);
+      if (!item)
+        return NULL;
+      (void)LLVMBuildCall2(
+          cg->builder, store_item->type, store_item->value,
+          (LLVMValueRef[]){
+              out, LLVMConstInt(cg->type_i64, ((i << 1) | 1u), false), item},
+          3, "");
+    }
+    (void)LLVMBuildCall2(cg->builder, set_len->type, set_len->value,
+                         (LLVMValueRef[]){out, tagged_len}, 2, "");
+    if (k == 'T') {
+      fun_sig *as_tuple = lookup_fun(cg, "__list_as_tuple", 0);
+      if (!as_tuple)
+        return expr_fail(cg, tok,
+                         "comptime tuple result requires tuple runtime helper");
+      out = LLVMBuildCall2(cg->builder, as_tuple->type, as_tuple->value,
+                           (LLVMValueRef[]){out}, 1,
+                           NY_LLVM_NAME(cg, "ct_memo_tuple"));
+    }
+    return out;
+  }
+  case 'D': {
+    if (!ny_ct_memo_read_size(r, ':', &n))
+      return NULL;
+    fun_sig *dict_new = lookup_fun(cg, "dict", 0);
+    if (!dict_new)
+      dict_new = lookup_fun(cg, "std.core.dict_mod.dict", 0);
+    fun_sig *dict_set = lookup_fun(cg, "__dict_write_fast", 0);
+    if (!dict_set)
+      dict_set = lookup_fun(cg, "std.core.set", 0);
+    if (!dict_new || !dict_set)
+      return expr_fail(cg, tok,
+                       "comptime dict result requires dict runtime helpers");
+    LLVMValueRef out = LLVMBuildCall2(
+        cg->builder, dict_new->type, dict_new->value,
+        (LLVMValueRef[]){LLVMConstInt(
+            cg->type_i64, ((n > 0 ? n : 1) << 2) | 1u, false)},
+        1, NY_LLVM_NAME(cg, "ct_memo_dict"));
+    for (uint64_t i = 0; i < n; i++) {
+      LLVMValueRef key = ny_ct_memo_materialize(cg, r, tok, depth + 1);
+      LLVMValueRef value =
+          key ? ny_ct_memo_materialize(cg, r, tok, depth + 1) : NULL;
+      if (!key || !value)
+        return NULL;
+      out = LLVMBuildCall2(cg->builder, dict_set->type, dict_set->value,
+                           (LLVMValueRef[]){out, key, value}, 3,
+                           NY_LLVM_NAME(cg, "ct_memo_dict_set"));
+    }
+    return out;
+  }
+  case 'R': {
+    uint64_t parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+      if (i && (r->p >= r->end || *r->p++ != ','))
+        return NULL;
+      if (!ny_ct_memo_read_hex(r, &parts[i]))
+        return NULL;
+    }
+    fun_sig *range_new = lookup_fun(cg, "__range_new", 0);
+    if (!range_new)
+      return expr_fail(cg, tok,
+                       "comptime range result requires range runtime helper");
+    return LLVMBuildCall2(cg->builder, range_new->type, range_new->value,
+                          (LLVMValueRef[]){
+                              LLVMConstInt(cg->type_i64, parts[0], true),
+                              LLVMConstInt(cg->type_i64, parts[1], true),
+                              LLVMConstInt(cg->type_i64, parts[2], true)},
+                          3, NY_LLVM_NAME(cg, "ct_memo_range"));
+  }
+  default:
+    return NULL;
+  }
+}
+
+static ny_ct_memo_entry_t *ny_ct_memo_find(ny_ct_session_t *s, uint64_t key) {
+  if (!s)
+    return NULL;
+  for (size_t i = 0; i < s->memo.len; i++) {
+    if (s->memo.data[i].key == key)
+      return &s->memo.data[i];
+  }
+  return NULL;
+}
+
+static LLVMValueRef ny_ct_memo_lookup(codegen_t *cg, ny_ct_session_t *s,
+                                      uint64_t key, token_t tok) {
+  ny_ct_memo_entry_t *hit = ny_ct_memo_find(s, key);
+  if (hit) {
+    s->hits++;
+  } else {
+    size_t len = 0;
+    char *data = ny_comptime_cache_load(key, &len);
+    if (!data)
+      return NULL;
+    if (!ny_ct_memo_valid(data, len)) {
+      free(data);
+      return NULL;
+    }
+    vec_push(&s->memo,
+             ((ny_ct_memo_entry_t){.key = key, .data = data, .len = len}));
+    hit = &s->memo.data[s->memo.len - 1];
+    s->disk_hits++;
+  }
+  if (ny_ct_trace_enabled())
+    fprintf(stderr, "[comptime] memo hit %016" PRIx64 " at %s:%d\n", key,
+            tok.filename ? tok.filename : "<input>", tok.line);
+  size_t magic_len = sizeof(NY_CT_MEMO_MAGIC) - 1;
+  ny_ct_memo_reader_t r = {hit->data + magic_len, hit->data + hit->len};
+  return ny_ct_memo_materialize(cg, &r, tok, 0);
+}
+
+static void ny_ct_memo_store(ny_ct_session_t *s, uint64_t key, int64_t value) {
+  if (!s || ny_ct_memo_find(s, key))
+    return;
+  ny_ct_memo_buf_t b = {0};
+  ny_ct_memo_put(&b, NY_CT_MEMO_MAGIC, sizeof(NY_CT_MEMO_MAGIC) - 1);
+  if (!ny_ct_memo_encode(&b, value, 0) || b.failed) {
+    free(b.data);
+    return;
+  }
+  vec_push(&s->memo,
+           ((ny_ct_memo_entry_t){.key = key, .data = b.data, .len = b.len}));
+  s->stores++;
+  (void)ny_comptime_cache_save(key, b.data, b.len);
+}
+
+/* Only the functions reachable from the comptime entry (directly, or through
+ * global initializers) are compiled; the rest of the snapshot is dropped
+ * before it reaches the JIT. */
+typedef struct ny_ct_reach_t {
+  LLVMValueRef *slots;
+  size_t cap;
+  size_t len;
+  bool failed;
+  VEC(LLVMValueRef) work;
+} ny_ct_reach_t;
+
+static bool ny_ct_reach_mark(ny_ct_reach_t *r, LLVMValueRef v) {
+  if (r->len * 2 >= r->cap) {
+    size_t next_cap = r->cap ? r->cap * 2 : 1024;
+    LLVMValueRef *next = calloc(next_cap, sizeof(*next));
+    if (!next) {
+      r->failed = true;
+      return false;
+    }
+    for (size_t i = 0; i < r->cap; i++) {
+      LLVMValueRef old = r->slots[i];
+      if (!old)
+        continue;
+      size_t j = (size_t)(((uintptr_t)old >> 4) * 0x9e3779b97f4a7c15ull) &
+                 (next_cap - 1);
+      while (next[j])
+        j = (j + 1) & (next_cap - 1);
+      next[j] = old;
+    }
+    free(r->slots);
+    r->slots = next;
+    r->cap = next_cap;
+  }
+  size_t j = (size_t)(((uintptr_t)v >> 4) * 0x9e3779b97f4a7c15ull) &
+             (r->cap - 1);
+  while (r->slots[j]) {
+    if (r->slots[j] == v)
+      return false;
+    j = (j + 1) & (r->cap - 1);
+  }
+  r->slots[j] = v;
+  r->len++;
+  return true;
+}
+
+static bool ny_ct_reach_has(const ny_ct_reach_t *r, LLVMValueRef v) {
+  if (!r->cap)
+    return false;
+  size_t j = (size_t)(((uintptr_t)v >> 4) * 0x9e3779b97f4a7c15ull) &
+             (r->cap - 1);
+  while (r->slots[j]) {
+    if (r->slots[j] == v)
+      return true;
+    j = (j + 1) & (r->cap - 1);
+  }
+  return false;
+}
+
+static void ny_ct_reach_value(ny_ct_reach_t *r, LLVMValueRef v, int depth) {
+  if (!v || depth > 64)
+    return;
+  if (LLVMIsAFunction(v)) {
+    if (ny_ct_reach_mark(r, v))
+      vec_push(&r->work, v);
+    return;
+  }
+  if (!LLVMIsAConstant(v))
+    return;
+  if (!LLVMIsAGlobalValue(v) && LLVMGetNumOperands(v) == 0)
+    return;
+  if (!ny_ct_reach_mark(r, v))
+    return;
+  if (LLVMIsAGlobalVariable(v)) {
+    ny_ct_reach_value(r, LLVMGetInitializer(v), depth + 1);
+    return;
+  }
+  if (LLVMIsAGlobalAlias(v)) {
+    ny_ct_reach_value(r, LLVMAliasGetAliasee(v), depth + 1);
+    return;
+  }
+  int n = LLVMGetNumOperands(v);
+  for (int i = 0; i < n; i++)
+    ny_ct_reach_value(r, LLVMGetOperand(v, (unsigned)i), depth + 1);
+}
+
+static size_t ny_ct_prune_unreachable(LLVMModuleRef mod, LLVMValueRef entry) {
+  if (!mod || !entry || !ny_env_enabled_default_on("NYTRIX_COMPTIME_PRUNE"))
+    return 0;
+  ny_ct_reach_t r = {0};
+  ny_ct_reach_value(&r, entry, 0);
+  for (LLVMValueRef g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g))
+    ny_ct_reach_value(&r, g, 0);
+  for (LLVMValueRef a = LLVMGetFirstGlobalAlias(mod); a;
+       a = LLVMGetNextGlobalAlias(a))
+    ny_ct_reach_value(&r, a, 0);
+  while (r.work.len > 0) {
+    LLVMValueRef f = r.work.data[--r.work.len];
+    LLVMValueRef personality =
+        LLVMHasPersonalityFn(f) ? LLVMGetPersonalityFn(f) : NULL;
+    ny_ct_reach_value(&r, personality, 0);
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(f); bb;
+         bb = LLVMGetNextBasicBlock(bb)) {
+      for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst;
+           inst = LLVMGetNextInstruction(inst)) {
+        int n = LLVMGetNumOperands(inst);
+        for (int i = 0; i < n; i++)
+          ny_ct_reach_value(&r, LLVMGetOperand(inst, (unsigned)i), 0);
+      }
+    }
+  }
+
+  size_t pruned = 0;
+  for (LLVMValueRef f = r.failed ? NULL : LLVMGetFirstFunction(mod); f;
+       f = LLVMGetNextFunction(f)) {
+    if (LLVMIsDeclaration(f) || ny_ct_reach_has(&r, f))
+      continue;
+    ny_llvm_clear_function(f);
+    LLVMSetLinkage(f, LLVMExternalLinkage);
+    LLVMSetVisibility(f, LLVMDefaultVisibility);
+    if (LLVMHasPersonalityFn(f))
+      LLVMSetPersonalityFn(f, NULL);
+    LLVMSetSubprogram(f, NULL);
+    pruned++;
+  }
+  free(r.slots);
+  vec_free(&r.work);
+  return pruned;
+}
+
 LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
   ny_ct_fast_val_t fast_value = ny_ct_fast_none();
   if (ny_try_eval_comptime_fast_value(cg, body, &fast_value)) {
@@ -4274,6 +4998,15 @@ LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
   }
   ny_ct_fast_val_free(&interp_value);
 
+  ny_ct_session_t *session = ny_ct_session_get(cg);
+  uint64_t memo_key = 0;
+  bool memo_enabled = session && ny_comptime_memo_key(cg, body, &memo_key);
+  if (memo_enabled) {
+    LLVMValueRef memo_value = ny_ct_memo_lookup(cg, session, memo_key, body->tok);
+    if (memo_value)
+      return memo_value;
+  }
+
   int64_t interp_tagged = 0;
   char *err = NULL;
   LLVMBasicBlockRef prev_bb = cg->builder ? ny_cur_block(cg) : NULL;
@@ -4446,6 +5179,13 @@ LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
   if (ctm_end_bb)
     LLVMPositionBuilderAtEnd(bld, ctm_end_bb);
 
+  size_t pruned = ny_ct_prune_unreachable(mod, entry_fn);
+  if (session)
+    session->pruned_functions += pruned;
+  if (ny_ct_trace_enabled())
+    fprintf(stderr, "[comptime] %s pruned=%zu memo=%s\n", entry_name, pruned,
+            memo_enabled ? "store" : "off");
+
   ny_jit_define_runtime_trampolines(mod);
 
   verify_err = NULL;
@@ -4489,8 +5229,9 @@ LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
     uint64_t saddr = 0;
     void *rt = NULL;
     bool module_consumed = false;
-    bool executed = ny_orc_jit_execute(
-        &tcg, mod, ctm_ctx, &saddr, NULL, &rt, &module_consumed, &orc_error);
+    bool executed = ny_orc_jit_execute_entry(
+        &tcg, mod, ctm_ctx, entry_name, &saddr, &rt, &module_consumed,
+        &orc_error);
     if (module_consumed) {
       tcg.module = NULL;
       tcg.ctx = NULL;
@@ -4518,6 +5259,10 @@ LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
                          "comptime JIT code memory is not executable");
       }
       res = ((int64_t (*)(void))saddr)();
+      if (session)
+        session->jit_runs++;
+      if (memo_enabled)
+        ny_ct_memo_store(session, memo_key, res);
     }
 
     if (prev_bb)
@@ -4586,6 +5331,10 @@ LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body) {
                        "comptime JIT code memory is not executable");
     }
     res = ((int64_t (*)(void))addr)();
+    if (session)
+      session->jit_runs++;
+    if (memo_enabled)
+      ny_ct_memo_store(session, memo_key, res);
   }
 
   if (prev_bb)
@@ -5,6 +5,7 @@
 #include "../nullnarrow.h"
 #include "../priv.h"
 #include "../jit.h"
+#include "wire/cache.h"
 #include "rt/shared.h"
 #ifndef _WIN32
 #include <alloca.h>
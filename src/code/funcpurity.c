@@ -1,5 +1,6 @@
 #include "base/util.h"
 #include "code/visitor.h"
+#include "parse/json.h"
 #include "priv.h"
 
 #include <ctype.h>
@@ -2403,3 +2404,108 @@ void infer_pure_functions(codegen_t *cg) {
 #undef NY_FOREACH_POLICY_SIG
 #undef NY_FOREACH_NON_STD_FUNC_SIG
 #undef NY_FOREACH_FUNC_SIG
+
+typedef struct ny_memo_deps_ctx {
+  codegen_t *cg;
+  ny_sig_ptr_list *sigs;
+  uint64_t enum_hash;
+  bool overflow;
+} ny_memo_deps_ctx;
+
+static void ny_memo_deps_add(ny_memo_deps_ctx *ctx, fun_sig *sig) {
+  if (!ctx || !sig || !sig->stmt_t || sig->stmt_t->kind != NY_S_FUNC)
+    return;
+  for (size_t i = 0; i < ctx->sigs->len; i++) {
+    if (ctx->sigs->data[i] == sig)
+      return;
+  }
+  if (ctx->sigs->len >= 4096) {
+    ctx->overflow = true;
+    return;
+  }
+  vec_push(ctx->sigs, sig);
+}
+
+static bool memo_deps_visit_expr(ny_visitor_t *v, expr_t *e) {
+  ny_memo_deps_ctx *ctx = (ny_memo_deps_ctx *)v->ctx;
+  if (!e)
+    return false;
+  uint64_t no_locals[4] = {0, 0, 0, 0};
+  switch (e->kind) {
+  case NY_E_CALL:
+    ny_memo_deps_add(ctx, ny_purity_resolve_call_sig(ctx->cg, &e->as.call, NULL, NULL,
+                                                     no_locals));
+    return true;
+  case NY_E_MEMCALL:
+    ny_memo_deps_add(ctx, ny_purity_resolve_memcall_sig(ctx->cg, &e->as.memcall, NULL, NULL,
+                                                        no_locals));
+    return true;
+  case NY_E_IDENT: {
+    const char *name = e->as.ident.name;
+    if (!name || !*name)
+      return true;
+    fun_sig *sig = lookup_fun(ctx->cg, name, 0);
+    if (sig) {
+      ny_memo_deps_add(ctx, sig);
+      return true;
+    }
+    enum_member_def_t *member = lookup_enum_member(ctx->cg, name);
+    if (member) {
+      ctx->enum_hash = ny_fnv1a64_cstr(name, ctx->enum_hash);
+      ctx->enum_hash = ny_hash64_u64(ctx->enum_hash, (uint64_t)member->value);
+      ctx->enum_hash = ny_hash64_u64(ctx->enum_hash, (uint64_t)member->runtime_tag);
+    }
+    return true;
+  }
+  default:
+    return true;
+  }
+}
+
+static uint64_t ny_memo_hash_stmt(stmt_t *s, uint64_t h) {
+  char *json = ny_stmt_to_json(s);
+  h = ny_fnv1a64_cstr(json ? json : "null", h);
+  free(json);
+  return h;
+}
+
+bool ny_comptime_memo_key(codegen_t *cg, stmt_t *body, uint64_t *out_key) {
+  if (out_key)
+    *out_key = 0;
+  if (!cg || !body || !out_key)
+    return false;
+  assigned_name_list local_names = {0};
+  assigned_hash_list local_hashes = {0};
+  uint64_t local_bloom[4] = {0, 0, 0, 0};
+  bool safe = ny_stmt_is_memo_safe(cg, body, &local_names, &local_hashes, local_bloom);
+  vec_free(&local_names);
+  vec_free(&local_hashes);
+  if (!safe)
+    return false;
+
+  /* The key covers the block, every function it can reach and the enum
+   * members it names, so an edit anywhere along that graph changes the key. */
+  ny_sig_ptr_list sigs = {0};
+  ny_memo_deps_ctx ctx = {
+      .cg = cg, .sigs = &sigs, .enum_hash = NY_FNV1A64_OFFSET_BASIS, .overflow = false};
+  ny_visitor_t visitor = {.ctx = &ctx, .visit_expr_pre = memo_deps_visit_expr};
+  ny_visit_stmt(&visitor, body);
+  for (size_t i = 0; i < sigs.len && !ctx.overflow; i++)
+    ny_visit_stmt(&visitor, sigs.data[i]->stmt_t);
+
+  uint64_t h = ny_fnv1a64_cstr("comptime-memo-v1", NY_FNV1A64_OFFSET_BASIS);
+  h = ny_memo_hash_stmt(body, h);
+  for (size_t i = 0; i < sigs.len && !ctx.overflow; i++) {
+    fun_sig *sig = sigs.data[i];
+    h = ny_fnv1a64_cstr(sig->name ? sig->name : "", h);
+    h = ny_hash64_u64(h, (uint64_t)sig->arity);
+    h = ny_memo_hash_stmt(sig->stmt_t, h);
+  }
+  h = ny_hash64_u64(h, ctx.enum_hash);
+  bool ok = !ctx.overflow;
+  vec_free(&sigs);
+  if (!ok)
+    return false;
+  *out_key = h ? h : 1;
+  return true;
+}
@@ -0,0 +1,253 @@
+/*
+ * Inline caches for member calls on untyped receivers.
+ *
+ * `x.len()` or `x.get(i)` on an `any` value binds to the generic `any.*`
+ * method, which re-discovers the receiver kind with a chain of runtime tag
+ * checks on every call. When the builtin containers also attach a method of
+ * the same name and call shape (`list.get`, `dict.get`, `str.len`, ...), the
+ * call site instead reads the receiver tag once and jumps straight to the
+ * matching direct target; any other receiver takes the generic method as
+ * before. Entries are keyed on the heap tag at v-8 (or the small-int bit for
+ * `int`) and are bound when the site is compiled, so a hit is a compare and
+ * a direct, inlinable call.
+ *
+ * NYTRIX_MEMBER_IC=0 turns the caches off. With NYTRIX_IC_STATS set while
+ * compiling, every entry and the fallback also bump a per-site counter in
+ * the runtime (rt/ic.c), which prints the table at exit.
+ */
+
+#define NY_MEMBER_IC_MAX_WAYS 4
+
+typedef struct {
+  const char *owner;
+  int64_t tags[2];
+  bool small_int;
+} ny_member_ic_owner_t;
+
+static const ny_member_ic_owner_t ny_member_ic_owners[] = {
+    {"list", {TAG_LIST, 0}, false},
+    {"dict", {TAG_DICT, 0}, false},
+    {"str", {TAG_STR, TAG_STR_CONST}, false},
+    {"int", {0, 0}, true},
+    {"tuple", {TAG_TUPLE, 0}, false},
+    {"set", {TAG_SET, 0}, false},
+    {"bytes", {TAG_BYTES, 0}, false},
+    {"bigint", {TAG_BIGINT, 0}, false},
+    {"range", {TAG_RANGE, 0}, false},
+};
+
+typedef struct {
+  fun_sig *sig;
+  const ny_member_ic_owner_t *owner;
+} ny_member_ic_way_t;
+
+typedef struct {
+  size_t n;
+  ny_member_ic_way_t ways[NY_MEMBER_IC_MAX_WAYS];
+} ny_member_ic_t;
+
+static bool ny_member_ic_same_default(const expr_t *a, const expr_t *b) {
+  if (!a || !b)
+    return a == b;
+  if (a->kind != NY_E_LITERAL || b->kind != NY_E_LITERAL ||
+      a->tok.kind != b->tok.kind || a->as.literal.kind != b->as.literal.kind)
+    return false;
+  switch (a->as.literal.kind) {
+  case NY_LIT_INT:
+    return a->as.literal.as.i == b->as.literal.as.i;
+  case NY_LIT_BOOL:
+    return a->as.literal.as.b == b->as.literal.as.b;
+  case NY_LIT_STR:
+    return a->as.literal.as.s.len == b->as.literal.as.s.len &&
+           memcmp(a->as.literal.as.s.data, b->as.literal.as.s.data,
+                  a->as.literal.as.s.len) == 0;
+  default:
+    return false;
+  }
+}
+
+static ny_param_list *ny_member_ic_params(fun_sig *sig) {
+  if (!sig || !sig->stmt_t || sig->stmt_t->kind != NY_S_FUNC)
+    return NULL;
+  return &sig->stmt_t->as.fn.params;
+}
+
+static bool ny_member_ic_sig_ok(fun_sig *sig) {
+  return sig && sig->value && sig->type && !sig->is_extern &&
+         !sig->is_variadic && !sig->is_native_abi &&
+         ny_member_ic_params(sig) != NULL;
+}
+
+/*
+ * A way is usable when it has exactly the generic method's LLVM type and
+ * every parameter the caller left out has the same literal default, so the
+ * argument vector built for the generic call can be passed unchanged.
+ */
+static bool ny_member_ic_compatible(fun_sig *generic, fun_sig *way,
+                                    size_t supplied) {
+  if (!ny_member_ic_sig_ok(way) || way == generic ||
+      way->value == generic->value || way->type != generic->type ||
+      way->arity != generic->arity)
+    return false;
+  ny_param_list *gp = ny_member_ic_params(generic);
+  ny_param_list *wp = ny_member_ic_params(way);
+  if (gp->len != wp->len)
+    return false;
+  for (size_t i = supplied; i < gp->len; i++) {
+    if (!ny_member_ic_same_default(gp->data[i].def, wp->data[i].def))
+      return false;
+  }
+  return true;
+}
+
+static bool ny_member_ic_collect(codegen_t *cg, ny_member_ic_t *ic,
+                                 const char *method, fun_sig *generic,
+                                 const ny_call_arg_list *user_args) {
+  ic->n = 0;
+  if (!cg || !method || !*method || cg->comptime ||
+      !ny_member_ic_sig_ok(generic) ||
+      LLVMGetReturnType(generic->type) != cg->type_i64 ||
+      !ny_env_enabled_default_on("NYTRIX_MEMBER_IC"))
+    return false;
+  for (size_t i = 0; user_args && i < user_args->len; i++) {
+    if (user_args->data[i].name)
+      return false;
+  }
+  size_t supplied = (user_args ? user_args->len : 0) + 1;
+  size_t owners = sizeof(ny_member_ic_owners) / sizeof(ny_member_ic_owners[0]);
+  for (size_t i = 0; i < owners && ic->n < NY_MEMBER_IC_MAX_WAYS; i++) {
+    fun_sig *way = ny_gencall_lookup_attached_method(
+        cg, ny_member_ic_owners[i].owner, method);
+    if (!ny_member_ic_compatible(generic, way, supplied))
+      continue;
+    ic->ways[ic->n].sig = way;
+    ic->ways[ic->n].owner = &ny_member_ic_owners[i];
+    ic->n++;
+  }
+  return ic->n > 0;
+}
+
+static void ny_member_ic_count(codegen_t *cg, fun_sig *count_fn,
+                               LLVMValueRef site_v, LLVMValueRef label_v,
+                               int way) {
+  if (!count_fn)
+    return;
+  LLVMValueRef way_v = LLVMConstInt(cg->type_i64, (uint64_t)way, true);
+  LLVMBuildCall2(cg->builder, count_fn->type, count_fn->value,
+                 (LLVMValueRef[]){site_v, way_v, label_v}, 3, "");
+}
+
+static LLVMValueRef
+ny_gencall_emit_member_ic(codegen_t *cg, token_t tok, const char *method,
+                          const ny_member_ic_t *ic, LLVMTypeRef ft,
+                          LLVMValueRef generic_callee, LLVMValueRef *args,
+                          unsigned nargs) {
+  LLVMValueRef fn = ny_cur_fn(cg);
+  if (!fn || !ic || ic->n == 0 || nargs == 0 ||
+      LLVMTypeOf(args[0]) != cg->type_i64)
+    return NULL;
+
+  fun_sig *count_fn = NULL;
+  LLVMValueRef site_v = NULL;
+  LLVMValueRef label_v = NULL;
+  if (ny_env_truthy(getenv("NYTRIX_IC_STATS"))) {
+    count_fn = lookup_fun(cg, "__ic_count", 0);
+    if (count_fn && !ny_sig_in_current_sigs(cg, count_fn))
+      count_fn = NULL;
+  }
+  if (count_fn) {
+    const char *file = tok.filename ? tok.filename : "";
+    const char *base = strrchr(file, '/');
+    char label[256];
+    int n = snprintf(label, sizeof(label), "%s:%d:%d .%s", base ? base + 1 : file,
+                     tok.line, tok.col, method);
+    for (size_t i = 0; i < ic->n && n > 0 && (size_t)n < sizeof(label); i++)
+      n += snprintf(label + n, sizeof(label) - (size_t)n, " %s",
+                    ic->ways[i].owner->owner);
+    if (n < 0)
+      label[0] = '\0';
+    site_v = LLVMConstInt(cg->type_i64, ny_pgo_site_id(tok, method), false);
+    label_v = ny_load(cg, const_string_ptr(cg, label, strlen(label)), "");
+  }
+
+  LLVMValueRef recv = args[0];
+  bool want_int = false, want_heap = false;
+  for (size_t i = 0; i < ic->n; i++) {
+    if (ic->ways[i].owner->small_int)
+      want_int = true;
+    else
+      want_heap = true;
+  }
+
+  ny_dbg_loc(cg, tok);
+  LLVMBasicBlockRef miss_bb = ny_bb_fn(fn, "ic.miss");
+  LLVMBasicBlockRef done_bb = ny_bb_fn(fn, "ic.done");
+  LLVMBasicBlockRef way_bb[NY_MEMBER_IC_MAX_WAYS];
+  for (size_t i = 0; i < ic->n; i++)
+    way_bb[i] = ny_bb_fn(fn, "ic.hit");
+
+  if (want_int) {
+    size_t int_way = 0;
+    while (!ic->ways[int_way].owner->small_int)
+      int_way++;
+    LLVMBasicBlockRef not_int_bb =
+        want_heap ? ny_bb_fn(fn, "ic.not_int") : miss_bb;
+    ny_cond_br(cg, ny_is_tagged_int(cg, recv), way_bb[int_way], not_int_bb);
+    if (want_heap)
+      ny_pos(cg, not_int_bb);
+  }
+  if (want_heap) {
+    LLVMBasicBlockRef tag_bb = ny_bb_fn(fn, "ic.tag");
+    ny_cond_br(cg, ny_build_is_ptr_pred(cg, recv, "ic_ptr"), tag_bb, miss_bb);
+    ny_pos(cg, tag_bb);
+    LLVMValueRef tag_addr = ny_sub(
+        cg, recv, LLVMConstInt(cg->type_i64, 8, false), "ic_tag_addr");
+    LLVMValueRef tag_ptr = LLVMBuildIntToPtr(cg->builder, tag_addr,
+                                             ny_ptr_i64_ty(cg), "ic_tag_ptr");
+    LLVMValueRef tag_v = ny_load(cg, tag_ptr, NY_LLVM_NAME(cg, "ic_tag"));
+    for (size_t i = 0; i < ic->n; i++) {
+      const ny_member_ic_owner_t *owner = ic->ways[i].owner;
+      if (owner->small_int)
+        continue;
+      LLVMValueRef hit = ny_eq(
+          cg, tag_v, LLVMConstInt(cg->type_i64, (uint64_t)owner->tags[0], false),
+          NY_LLVM_NAME(cg, "ic_tag_hit"));
+      if (owner->tags[1])
+        hit = ny_or(cg, hit,
+                    ny_eq(cg, tag_v,
+                          LLVMConstInt(cg->type_i64, (uint64_t)owner->tags[1],
+                                       false),
+                          NY_LLVM_NAME(cg, "ic_tag_hit_alt")),
+                    NY_LLVM_NAME(cg, "ic_tag_hit_any"));
+      LLVMBasicBlockRef next_bb = ny_bb_fn(fn, "ic.next");
+      ny_cond_br(cg, hit, way_bb[i], next_bb);
+      ny_pos(cg, next_bb);
+    }
+    ny_br(cg, miss_bb);
+  }
+
+  LLVMValueRef results[NY_MEMBER_IC_MAX_WAYS + 1];
+  LLVMBasicBlockRef ends[NY_MEMBER_IC_MAX_WAYS + 1];
+  for (size_t i = 0; i < ic->n; i++) {
+    ny_pos(cg, way_bb[i]);
+    ny_member_ic_count(cg, count_fn, site_v, label_v, (int)i);
+    ny_dbg_loc(cg, tok);
+    results[i] = LLVMBuildCall2(cg->builder, ft, ic->ways[i].sig->value, args,
+                                nargs, NY_LLVM_NAME(cg, "ic_direct"));
+    ends[i] = ny_cur_block(cg);
+    ny_br(cg, done_bb);
+  }
+
+  ny_pos(cg, miss_bb);
+  ny_member_ic_count(cg, count_fn, site_v, label_v, -1);
+  ny_dbg_loc(cg, tok);
+  results[ic->n] = LLVMBuildCall2(cg->builder, ft, generic_callee, args, nargs,
+                                  NY_LLVM_NAME(cg, "ic_generic"));
+  ends[ic->n] = ny_cur_block(cg);
+  ny_br(cg, done_bb);
+
+  ny_pos(cg, done_bb);
+  LLVMValueRef res = ny_phi(cg, cg->type_i64, NY_LLVM_NAME(cg, "ic_call"));
+  LLVMAddIncoming(res, results, ends, (unsigned)ic->n + 1);
+  return res;
+}
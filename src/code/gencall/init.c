@@ -77,6 +77,7 @@ static bool ny_gencall_has_cache_attr(fun_sig *sig) {
   return sig->stmt_t->as.fn.attr_cache;
 }
 #include "abi.c"
+#include "ic.c"
 static void report_missing_runtime_call_helper(codegen_t *cg, token_t tok,
                                                const char *name, size_t want) {
   ny_diag_error(tok, "undefined runtime call helper '%s'", name);
@@ -625,6 +626,7 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
   bool has_sig = false;
   bool skip_target = false;
   fun_sig *sig_found = NULL;
+  bool member_ic_any = false;
 
   if (c && c->callee && c->callee->kind == NY_E_IDENT) {
     LLVMValueRef fast_numeric =
@@ -1584,6 +1586,8 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
       if (!sig_found)
         sig_found = ny_gencall_lookup_attached_method(cg, "any", mc->name);
       if (sig_found) {
+        const char *mc_owner = ny_gencall_attached_owner(mc_target_type);
+        member_ic_any = !mc_owner || strcmp(mc_owner, "any") == 0;
         ft = sig_found->type;
         fv = sig_found->value;
         sig_arity = sig_found->arity;
@@ -2030,6 +2034,9 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
     }
     memcpy(mono_tagged_args, args, sizeof(LLVMValueRef) * final_argc);
   }
+  if (has_sig && sig_meta && ny_pgo_gen_enabled())
+    ny_pgo_emit_site(cg, e->tok, mono_base_sig ? mono_base_sig : sig_meta,
+                     args, final_argc);
   if (has_sig && sig_meta) {
     ny_param_list *call_params = NULL;
     if (sig_meta->stmt_t && sig_meta->stmt_t->kind == NY_S_EXTERN) {
@@ -2354,6 +2361,11 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
     bool needs_guard = false;
     size_t guard_n =
         mono_params->len < final_argc ? mono_params->len : final_argc;
+    uint64_t pgo_site = ny_pgo_use_enabled()
+                            ? ny_pgo_site_id(e->tok, mono_base_sig->name)
+                            : 0;
+    uint64_t pgo_hits = UINT64_MAX;
+    uint64_t pgo_calls = 0;
     for (size_t i = 0; i < guard_n; i++) {
       const char *ptype = mono_params->data[i].type;
       if (ptype && ny_type_is(ptype, "int")) {
@@ -2365,6 +2377,11 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
         guard = ny_and(cg, guard, ny_is_tagged_int(cg, mono_tagged_args[i]),
                        NY_LLVM_NAME(cg, "mono_arg_is_small_int"));
         needs_guard = true;
+        uint64_t ints = 0;
+        if (pgo_site && ny_pgo_site_arg_int_counts(pgo_site, (int)i, &ints,
+                                                   &pgo_calls) &&
+            ints < pgo_hits)
+          pgo_hits = ints;
       }
     }
     if (needs_guard) {
@@ -2373,7 +2390,10 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
         LLVMBasicBlockRef fast_bb = ny_bb_fn(cur_fn, "mono.call.fast");
         LLVMBasicBlockRef slow_bb = ny_bb_fn(cur_fn, "mono.call.fallback");
         LLVMBasicBlockRef done_bb = ny_bb_fn(cur_fn, "mono.call.done");
-        ny_cond_br(cg, guard, fast_bb, slow_bb);
+        LLVMValueRef guard_br = ny_cond_br(cg, guard, fast_bb, slow_bb);
+        if (pgo_calls && pgo_hits != UINT64_MAX)
+          ny_pgo_set_branch_weights(cg, guard_br, pgo_hits,
+                                    pgo_calls - pgo_hits);
 
         ny_pos(cg, fast_bb);
         ny_dbg_loc(cg, e->tok);
@@ -2426,6 +2446,17 @@ LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth,
         ny_build_memoized_direct_call(cg, e->tok, ft, callee, args, call_nargs,
                                       memo_enabled, memo_for_impure);
   } else if (!did_mono_guarded_call) {
+    ny_member_ic_t member_ic;
+    if (member_ic_any && mc && !skip_target && !mono_base_sig &&
+        ny_member_ic_collect(cg, &member_ic, mc->name, sig_found, &mc->args))
+      res = ny_gencall_emit_member_ic(cg, e->tok, mc->name, &member_ic, ft,
+                                      callee, args, call_nargs);
+    if (res) {
+      free(arg_exprs);
+      free(mono_tagged_args);
+      free(args);
+      return res;
+    }
     ny_dbg_loc(cg, e->tok);
     res = LLVMBuildCall2(cg->builder, ft, callee, args, call_nargs, "");
     abi_apply_native_layout_call_attrs(cg, res, sig_meta);
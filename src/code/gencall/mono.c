@@ -777,7 +777,7 @@ static fun_sig *ny_try_monomorphize_call(codegen_t *cg, scope *scopes,
   if (!cg || !sig || !sig->stmt_t || sig->stmt_t->kind != NY_S_FUNC ||
       !sig->stmt_t->as.fn.body)
     return NULL;
-  if (cg->mono_emitting || !ny_mono_enabled(cg))
+  if (cg->mono_emitting || (!ny_mono_enabled(cg) && !ny_pgo_use_enabled()))
     return NULL;
   if (sig->is_extern || sig->is_variadic || sig->arity <= 0 ||
       sig->arity > NY_MONO_MAX_ARITY)
@@ -809,6 +809,7 @@ static fun_sig *ny_try_monomorphize_call(codegen_t *cg, scope *scopes,
   bool arg_list_len_min_known[NY_MONO_MAX_ARITY] = {0};
   int64_t arg_list_len_min_raw[NY_MONO_MAX_ARITY] = {0};
   bool useful = false;
+  bool profiled = false;
   bool has_keyword = false;
   call_arg_t *user_args = c ? c->args.data : (mc ? mc->args.data : NULL);
   size_t user_args_len = c ? c->args.len : (mc ? mc->args.len : 0);
@@ -820,11 +821,21 @@ static fun_sig *ny_try_monomorphize_call(codegen_t *cg, scope *scopes,
   }
   if (has_keyword)
     return NULL;
+  /* Profile feedback may only add int parameters: the call site guards
+   * those with a small-int check, which needs a tagged i64 return. */
+  uint64_t pgo_site = 0;
+  if (ny_pgo_use_enabled() && LLVMGetReturnType(sig->type) == cg->type_i64)
+    pgo_site = ny_pgo_site_id(call ? call->tok : fn->tok, sig->name);
   for (int i = 0; i < sig->arity && i < NY_MONO_MAX_ARITY; i++) {
     expr_t *arg_expr = ny_mono_call_arg_for_param(c, mc, skip_target, (size_t)i);
     if (!fn->as.fn.params.data[i].type) {
       ny_mono_type_kind_t kind =
           ny_mono_expr_kind(cg, scopes, depth, arg_expr);
+      if (kind == NY_MONO_TYPE_NONE && pgo_site &&
+          ny_pgo_site_arg_is_hot_int(pgo_site, i)) {
+        kind = NY_MONO_TYPE_INT;
+        profiled = true;
+      }
       if (kind != NY_MONO_TYPE_NONE) {
         types[i] = (uint8_t)kind;
         useful = true;
@@ -839,8 +850,10 @@ static fun_sig *ny_try_monomorphize_call(codegen_t *cg, scope *scopes,
   }
   if (!useful)
     return NULL;
+  if (!profiled && !ny_mono_enabled(cg))
+    return NULL;
   bool list_args_only =
-      ny_env_enabled("NYTRIX_MONO_LIST_ARGS") &&
+      !profiled && ny_env_enabled("NYTRIX_MONO_LIST_ARGS") &&
       !ny_codegen_speed_profile_enabled(cg) &&
       !ny_env_enabled("NYTRIX_MONO_TYPES") &&
       !ny_env_enabled("NYTRIX_ENABLE_MONOMORPHIZATION");
@@ -911,6 +924,8 @@ static fun_sig *ny_try_monomorphize_call(codegen_t *cg, scope *scopes,
                               "NYTRIX_MONO_ALWAYSINLINE_COST", 96)
                  ? "arg-specialized+inline-candidate"
                  : "arg-specialized");
+  if (profiled)
+    spec.accept_reason = "profile-guided";
   spec.return_policy =
       spec.raw_return_active
           ? "raw-return-active"
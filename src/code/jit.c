@@ -1065,10 +1065,11 @@ bool ny_orc_jit_ensure_engine(codegen_t *cg, char **error_message) {
 #endif
 }
 
-bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
-                        LLVMContextRef context, uint64_t *script_addr,
-                        uint64_t *main_addr, void **out_rt,
-                        bool *module_consumed, char **error_message) {
+static bool ny_orc_jit_add_module(codegen_t *cg, LLVMModuleRef module,
+                                  LLVMContextRef context, const char *entry_name,
+                                  uint64_t *script_addr, uint64_t *main_addr,
+                                  void **out_rt, bool *module_consumed,
+                                  char **error_message) {
   if (script_addr)
     *script_addr = 0;
   if (main_addr)
@@ -1085,7 +1086,7 @@ bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
                         : (cg->parent ? cg->parent->orc_jit : NULL))
          : NULL;
 
-  if (!cg || !orc_jit || !module || !context || !out_rt)
+  if (!cg || !orc_jit || !module || !context || !out_rt || !entry_name)
     return false;
 
 #if LLVM_VERSION_MAJOR < 21
@@ -1134,7 +1135,7 @@ bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
   }
 
   LLVMOrcExecutorAddress addr = 0;
-  err = LLVMOrcLLJITLookup(jit, &addr, "_ny_top_entry");
+  err = LLVMOrcLLJITLookup(jit, &addr, entry_name);
   if (err) {
     if (error_message)
       *error_message = ny_orc_error_message(err);
@@ -1147,12 +1148,14 @@ bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
   if (script_addr)
     *script_addr = (uint64_t)addr;
 
-  addr = 0;
-  err = LLVMOrcLLJITLookup(jit, &addr, "main");
-  if (!err && main_addr)
-    *main_addr = (uint64_t)addr;
-  else if (err)
-    LLVMConsumeError(err);
+  if (main_addr) {
+    addr = 0;
+    err = LLVMOrcLLJITLookup(jit, &addr, "main");
+    if (!err)
+      *main_addr = (uint64_t)addr;
+    else
+      LLVMConsumeError(err);
+  }
 
   if (out_rt)
     *out_rt = rt;
@@ -1160,6 +1163,25 @@ bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
 #endif
 }
 
+bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
+                        LLVMContextRef context, uint64_t *script_addr,
+                        uint64_t *main_addr, void **out_rt,
+                        bool *module_consumed, char **error_message) {
+  return ny_orc_jit_add_module(cg, module, context, "_ny_top_entry",
+                               script_addr, main_addr, out_rt,
+                               module_consumed, error_message);
+}
+
+bool ny_orc_jit_execute_entry(codegen_t *cg, LLVMModuleRef module,
+                              LLVMContextRef context, const char *entry_name,
+                              uint64_t *entry_addr, void **out_rt,
+                              bool *module_consumed, char **error_message) {
+  return ny_orc_jit_add_module(cg, module, context,
+                               entry_name ? entry_name : "_ny_top_entry",
+                               entry_addr, NULL, out_rt, module_consumed,
+                               error_message);
+}
+
 void ny_orc_jit_remove_module(void *rt) {
 #if LLVM_VERSION_MAJOR >= 21
   if (!rt)
@@ -1180,6 +1202,570 @@ void ny_orc_jit_dispose(void *jit) {
     LLVMConsumeError(err);
 }
 
+/*
+ * Incremental ORC session for the REPL.
+ *
+ * The std prelude is loaded once as a precompiled object. Each input chunk is
+ * then split so that only its entry is compiled eagerly: every function body
+ * moves into its own module behind a lazy reexport and is compiled the first
+ * time it is called. Public functions are reached through a stable stub that
+ * jumps through a slot, so a chunk that redefines `f` only retargets the slot
+ * instead of replaying the session. All chunks share the main JITDylib (the C
+ * API cannot set link orders) and each gets its own resource tracker. Chunks
+ * that would redefine a global or change the type of an existing function are
+ * reported as NY_ORC_REPL_REBUILD and left untouched.
+ */
+
+typedef struct ny_orc_repl_fn_t {
+  char *name;
+  LLVMTypeRef type;
+  uint64_t *slot;
+} ny_orc_repl_fn_t;
+
+struct ny_orc_repl {
+#if LLVM_VERSION_MAJOR >= 21
+  LLVMOrcLLJITRef jit;
+  LLVMOrcThreadSafeContextRef ts_ctx;
+  LLVMOrcLazyCallThroughManagerRef lctm;
+  LLVMOrcIndirectStubsManagerRef ism;
+#endif
+  LLVMContextRef ctx;
+  unsigned chunks;
+  VEC(ny_orc_repl_fn_t) fns;
+  uint64_t *defined;
+  size_t defined_cap;
+  size_t defined_len;
+};
+
+#if LLVM_VERSION_MAJOR >= 21
+typedef struct ny_orc_repl_split_t {
+  LLVMValueRef fn;
+  LLVMTypeRef type;
+  bool pub;
+  char *name;
+  char *body;
+  char *lazy;
+} ny_orc_repl_split_t;
+
+static uint64_t ny_orc_repl_name_hash(const char *name) {
+  uint64_t h = ny_fnv1a64_cstr(name, NY_FNV1A64_OFFSET_BASIS);
+  return h ? h : 1;
+}
+
+static bool ny_orc_repl_is_defined(const ny_orc_repl_t *s, const char *name) {
+  if (!s->defined_cap)
+    return false;
+  uint64_t h = ny_orc_repl_name_hash(name);
+  size_t mask = s->defined_cap - 1;
+  for (size_t i = (size_t)h & mask;; i = (i + 1) & mask) {
+    if (!s->defined[i])
+      return false;
+    if (s->defined[i] == h)
+      return true;
+  }
+}
+
+static void ny_orc_repl_mark_defined(ny_orc_repl_t *s, const char *name) {
+  if ((s->defined_len + 1) * 2 > s->defined_cap) {
+    size_t cap = s->defined_cap ? s->defined_cap * 2 : 1024;
+    uint64_t *tab = calloc(cap, sizeof(*tab));
+    if (!tab)
+      return;
+    for (size_t i = 0; i < s->defined_cap; i++) {
+      uint64_t h = s->defined[i];
+      if (!h)
+        continue;
+      size_t j = (size_t)h & (cap - 1);
+      while (tab[j])
+        j = (j + 1) & (cap - 1);
+      tab[j] = h;
+    }
+    free(s->defined);
+    s->defined = tab;
+    s->defined_cap = cap;
+  }
+  uint64_t h = ny_orc_repl_name_hash(name);
+  size_t mask = s->defined_cap - 1;
+  size_t i = (size_t)h & mask;
+  while (s->defined[i]) {
+    if (s->defined[i] == h)
+      return;
+    i = (i + 1) & mask;
+  }
+  s->defined[i] = h;
+  s->defined_len++;
+}
+
+static ny_orc_repl_fn_t *ny_orc_repl_find_fn(ny_orc_repl_t *s, const char *name) {
+  for (size_t i = 0; i < s->fns.len; i++) {
+    if (strcmp(s->fns.data[i].name, name) == 0)
+      return &s->fns.data[i];
+  }
+  return NULL;
+}
+
+static bool ny_orc_is_local(LLVMValueRef v) {
+  LLVMLinkage l = LLVMGetLinkage(v);
+  return l == LLVMPrivateLinkage || l == LLVMInternalLinkage;
+}
+
+static bool ny_orc_is_llvm_name(const char *name) {
+  return name && strncmp(name, "llvm.", 5) == 0;
+}
+
+static char *ny_orc_repl_suffixed(const char *name, const char *suffix,
+                                  unsigned chunk) {
+  size_t cap = strlen(name) + strlen(suffix) + 16;
+  char *out = malloc(cap);
+  if (out)
+    snprintf(out, cap, "%s%s%u", name, suffix, chunk);
+  return out;
+}
+
+static void ny_orc_set_name(LLVMValueRef v, const char *name) {
+  LLVMSetValueName2(v, name, strlen(name));
+}
+
+static void ny_orc_repl_drop_body(LLVMModuleRef mod, LLVMValueRef fn) {
+  if (!LLVMGetFirstUse(fn)) {
+    LLVMDeleteFunction(fn);
+    return;
+  }
+  char *name = ny_strdup(LLVMGetValueName(fn));
+  LLVMValueRef decl = LLVMAddFunction(mod, "", LLVMGlobalGetValueType(fn));
+  LLVMSetFunctionCallConv(decl, LLVMGetFunctionCallConv(fn));
+  LLVMReplaceAllUsesWith(fn, decl);
+  LLVMDeleteFunction(fn);
+  ny_orc_set_name(decl, name);
+  free(name);
+}
+
+static void ny_orc_repl_drop_llvm_used(LLVMModuleRef mod) {
+  LLVMValueRef g = LLVMGetNamedGlobal(mod, "llvm.used");
+  if (g)
+    LLVMDeleteGlobal(g);
+  g = LLVMGetNamedGlobal(mod, "llvm.compiler.used");
+  if (g)
+    LLVMDeleteGlobal(g);
+}
+
+/* Reduce a clone of the split chunk to the single body `keep`. */
+static void ny_orc_repl_keep_body(LLVMModuleRef mod, const char *keep) {
+  ny_orc_repl_drop_llvm_used(mod);
+  LLVMValueRef g = LLVMGetNamedGlobal(mod, "llvm.global_ctors");
+  if (g)
+    LLVMDeleteGlobal(g);
+  LLVMValueRef fn = LLVMGetFirstFunction(mod);
+  while (fn) {
+    LLVMValueRef next = LLVMGetNextFunction(fn);
+    if (!LLVMIsDeclaration(fn) && strcmp(LLVMGetValueName(fn), keep) != 0)
+      ny_orc_repl_drop_body(mod, fn);
+    fn = next;
+  }
+  for (g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g)) {
+    if (LLVMIsDeclaration(g))
+      continue;
+    LLVMSetInitializer(g, NULL);
+    LLVMSetLinkage(g, LLVMExternalLinkage);
+  }
+}
+
+static void ny_orc_repl_emit_stub(LLVMModuleRef mod, const char *name,
+                                  LLVMTypeRef type, unsigned cc) {
+  LLVMContextRef ctx = LLVMGetModuleContext(mod);
+  LLVMTypeRef ptr_ty = LLVMPointerTypeInContext(ctx, 0);
+  char *slot_name = ny_orc_repl_suffixed(name, ".__ny_slot", 0);
+  LLVMValueRef slot = LLVMAddGlobal(mod, ptr_ty, slot_name);
+  free(slot_name);
+  LLVMSetInitializer(slot, LLVMConstNull(ptr_ty));
+  LLVMValueRef fn = LLVMAddFunction(mod, name, type);
+  LLVMSetFunctionCallConv(fn, cc);
+  LLVMBuilderRef b = LLVMCreateBuilderInContext(ctx);
+  LLVMPositionBuilderAtEnd(b, LLVMAppendBasicBlockInContext(ctx, fn, "entry"));
+  LLVMValueRef target = LLVMBuildLoad2(b, ptr_ty, slot, "target");
+  unsigned argc = LLVMCountParams(fn);
+  LLVMValueRef *args = argc ? malloc(sizeof(LLVMValueRef) * argc) : NULL;
+  if (args)
+    LLVMGetParams(fn, args);
+  LLVMValueRef call = LLVMBuildCall2(b, type, target, args, argc, "");
+  LLVMSetInstructionCallConv(call, cc);
+  LLVMSetTailCallKind(call, LLVMTailCallKindMustTail);
+  if (LLVMGetTypeKind(LLVMGetReturnType(type)) == LLVMVoidTypeKind)
+    LLVMBuildRetVoid(b);
+  else
+    LLVMBuildRet(b, call);
+  free(args);
+  LLVMDisposeBuilder(b);
+}
+
+static bool ny_orc_repl_add_ir(ny_orc_repl_t *s, LLVMOrcResourceTrackerRef rt,
+                               LLVMModuleRef mod, char **error_message) {
+  LLVMOrcThreadSafeModuleRef tsm = LLVMOrcCreateNewThreadSafeModule(mod, s->ts_ctx);
+  LLVMErrorRef err =
+      rt ? LLVMOrcLLJITAddLLVMIRModuleWithRT(s->jit, rt, tsm)
+         : LLVMOrcLLJITAddLLVMIRModule(s->jit, LLVMOrcLLJITGetMainJITDylib(s->jit), tsm);
+  if (!err)
+    return true;
+  if (error_message && !*error_message)
+    *error_message = ny_orc_error_message(err);
+  else
+    LLVMConsumeError(err);
+  return false;
+}
+
+static void ny_orc_repl_lazy_call_failed(void) {
+  fprintf(stderr, "ORC JIT: lazy compilation failed\n");
+  abort();
+}
+
+static void ny_orc_repl_free(ny_orc_repl_t *s) {
+  if (s->jit) {
+    LLVMErrorRef err = LLVMOrcDisposeLLJIT(s->jit);
+    if (err)
+      LLVMConsumeError(err);
+  }
+  if (s->lctm)
+    LLVMOrcDisposeLazyCallThroughManager(s->lctm);
+  if (s->ism)
+    LLVMOrcDisposeIndirectStubsManager(s->ism);
+  for (size_t i = 0; i < s->fns.len; i++)
+    free(s->fns.data[i].name);
+  free(s->fns.data);
+  free(s->defined);
+  free(s);
+}
+
+ny_orc_repl_t *ny_orc_repl_create(LLVMContextRef ctx, LLVMModuleRef std_module,
+                                  codegen_t *std_cg, const char *std_object_path,
+                                  char **error_message) {
+  if (error_message)
+    *error_message = NULL;
+  if (!ctx)
+    return NULL;
+  ny_orc_repl_t *s = calloc(1, sizeof(*s));
+  if (!s)
+    return NULL;
+  s->ctx = ctx;
+  LLVMErrorRef err = LLVMOrcCreateLLJIT(&s->jit, NULL);
+  LLVMOrcJITDylibRef dylib = err ? NULL : LLVMOrcLLJITGetMainJITDylib(s->jit);
+  if (!err) {
+    LLVMOrcDefinitionGeneratorRef generator = NULL;
+    err = LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+        &generator, LLVMOrcLLJITGetGlobalPrefix(s->jit), NULL, NULL);
+    if (!err)
+      LLVMOrcJITDylibAddGenerator(dylib, generator);
+  }
+  const char *triple = err ? NULL : LLVMOrcLLJITGetTripleString(s->jit);
+  if (!err)
+    err = LLVMOrcCreateLocalLazyCallThroughManager(
+        triple, LLVMOrcLLJITGetExecutionSession(s->jit),
+        (LLVMOrcJITTargetAddress)(uintptr_t)ny_orc_repl_lazy_call_failed, &s->lctm);
+  if (!err && !(s->ism = LLVMOrcCreateLocalIndirectStubsManager(triple))) {
+    if (error_message)
+      *error_message = ny_strdup("could not create ORC indirect stubs manager");
+    ny_orc_repl_free(s);
+    return NULL;
+  }
+  if (!err && std_module && std_object_path) {
+    ny_orc_register_extern_symbols(std_module, std_cg);
+    LLVMMemoryBufferRef buf = NULL;
+    char *msg = NULL;
+    if (LLVMCreateMemoryBufferWithContentsOfFile(std_object_path, &buf, &msg)) {
+      if (error_message)
+        *error_message = ny_strdup(msg ? msg : "could not read std object");
+      if (msg)
+        LLVMDisposeMessage(msg);
+      ny_orc_repl_free(s);
+      return NULL;
+    }
+    err = LLVMOrcLLJITAddObjectFile(s->jit, dylib, buf);
+    for (LLVMValueRef fn = LLVMGetFirstFunction(std_module); fn;
+         fn = LLVMGetNextFunction(fn)) {
+      if (!LLVMIsDeclaration(fn) && !ny_orc_is_local(fn))
+        ny_orc_repl_mark_defined(s, LLVMGetValueName(fn));
+    }
+    for (LLVMValueRef g = LLVMGetFirstGlobal(std_module); g; g = LLVMGetNextGlobal(g)) {
+      if (!LLVMIsDeclaration(g) && !ny_orc_is_local(g))
+        ny_orc_repl_mark_defined(s, LLVMGetValueName(g));
+    }
+  }
+  if (err) {
+    if (error_message)
+      *error_message = ny_orc_error_message(err);
+    else
+      LLVMConsumeError(err);
+    ny_orc_repl_free(s);
+    return NULL;
+  }
+  return s;
+}
+
+bool ny_orc_repl_lookup(ny_orc_repl_t *s, const char *name, uint64_t *addr,
+                        char **error_message) {
+  if (addr)
+    *addr = 0;
+  if (!s || !name || !addr)
+    return false;
+  LLVMOrcExecutorAddress a = 0;
+  LLVMErrorRef err = LLVMOrcLLJITLookup(s->jit, &a, name);
+  if (err) {
+    if (error_message && !*error_message)
+      *error_message = ny_orc_error_message(err);
+    else
+      LLVMConsumeError(err);
+    return false;
+  }
+  *addr = (uint64_t)a;
+  return true;
+}
+
+static void ny_orc_repl_free_splits(ny_orc_repl_split_t *splits, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    free(splits[i].name);
+    free(splits[i].body);
+    free(splits[i].lazy);
+  }
+  free(splits);
+}
+
+ny_orc_repl_status ny_orc_repl_add_chunk(ny_orc_repl_t *s, LLVMModuleRef mod,
+                                         codegen_t *cg, const char *entry_name,
+                                         uint64_t *entry_addr, bool *module_consumed,
+                                         char **error_message) {
+  if (entry_addr)
+    *entry_addr = 0;
+  if (module_consumed)
+    *module_consumed = false;
+  if (error_message)
+    *error_message = NULL;
+  if (!s || !mod || !entry_name || !entry_addr)
+    return NY_ORC_REPL_ERROR;
+  LLVMValueRef entry = LLVMGetNamedFunction(mod, entry_name);
+  if (!entry || LLVMIsDeclaration(entry)) {
+    if (error_message)
+      *error_message = ny_strdup("REPL chunk has no entry function");
+    return NY_ORC_REPL_ERROR;
+  }
+
+  size_t nfn = 0;
+  for (LLVMValueRef g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g)) {
+    const char *name = LLVMGetValueName(g);
+    if (LLVMIsDeclaration(g) || ny_orc_is_local(g) || !name || !*name ||
+        ny_orc_is_llvm_name(name))
+      continue;
+    if (ny_orc_repl_is_defined(s, name) || ny_orc_repl_find_fn(s, name))
+      return NY_ORC_REPL_REBUILD;
+  }
+  for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+    if (LLVMIsDeclaration(fn) || fn == entry)
+      continue;
+    nfn++;
+    const char *name = LLVMGetValueName(fn);
+    if (ny_orc_is_local(fn) || !name || !*name)
+      continue;
+    ny_orc_repl_fn_t *prev = ny_orc_repl_find_fn(s, name);
+    if (ny_orc_repl_is_defined(s, name) ||
+        (prev && prev->type != LLVMGlobalGetValueType(fn)))
+      return NY_ORC_REPL_REBUILD;
+  }
+
+  unsigned chunk = ++s->chunks;
+  ny_orc_register_extern_symbols(mod, cg);
+
+  ny_orc_repl_split_t *splits = nfn ? calloc(nfn, sizeof(*splits)) : NULL;
+  size_t n = 0;
+  for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn && n < nfn;
+       fn = LLVMGetNextFunction(fn)) {
+    if (LLVMIsDeclaration(fn) || fn == entry)
+      continue;
+    const char *name = LLVMGetValueName(fn);
+    splits[n].fn = fn;
+    splits[n].type = LLVMGlobalGetValueType(fn);
+    splits[n].pub = !ny_orc_is_local(fn) && name && *name;
+    n++;
+  }
+  for (LLVMValueRef g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g)) {
+    const char *name = LLVMGetValueName(g);
+    if (LLVMIsDeclaration(g) || ny_orc_is_llvm_name(name))
+      continue;
+    if (ny_orc_is_local(g)) {
+      char *promoted = ny_orc_repl_suffixed(*name ? name : "__ny_anon", ".__ny_c", chunk);
+      ny_orc_set_name(g, promoted);
+      free(promoted);
+      LLVMSetLinkage(g, LLVMExternalLinkage);
+    } else {
+      ny_orc_repl_mark_defined(s, name);
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    ny_orc_repl_split_t *sp = &splits[i];
+    const char *name = LLVMGetValueName(sp->fn);
+    if (sp->pub) {
+      sp->name = ny_strdup(name);
+      sp->body = ny_orc_repl_suffixed(name, ".__ny_c", chunk);
+      sp->lazy = ny_orc_repl_suffixed(name, ".__ny_l", chunk);
+    } else {
+      sp->body = ny_orc_repl_suffixed(*name ? name : "__ny_anon", ".__ny_c", chunk);
+      sp->lazy = ny_orc_repl_suffixed(sp->body, ".__ny_l", chunk);
+    }
+    ny_orc_set_name(sp->fn, sp->body);
+    LLVMSetLinkage(sp->fn, LLVMExternalLinkage);
+    LLVMValueRef decl = LLVMAddFunction(mod, sp->pub ? sp->name : sp->lazy, sp->type);
+    LLVMSetFunctionCallConv(decl, LLVMGetFunctionCallConv(sp->fn));
+    LLVMReplaceAllUsesWith(sp->fn, decl);
+  }
+
+  LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(s->jit);
+  if (!s->ts_ctx)
+    s->ts_ctx = LLVMOrcCreateNewThreadSafeContextFromLLVMContext(s->ctx);
+  LLVMOrcResourceTrackerRef rt = LLVMOrcJITDylibCreateResourceTracker(dylib);
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    LLVMModuleRef body = LLVMCloneModule(mod);
+    ny_orc_repl_keep_body(body, splits[i].body);
+    ok = ny_orc_repl_add_ir(s, rt, body, error_message) && ok;
+  }
+  for (size_t i = 0; i < n; i++)
+    ny_orc_repl_drop_body(mod, splits[i].fn);
+  ny_orc_repl_drop_llvm_used(mod);
+  LLVMModuleRef stubs = NULL;
+  for (size_t i = 0; i < n; i++) {
+    if (!splits[i].pub || ny_orc_repl_find_fn(s, splits[i].name))
+      continue;
+    if (!stubs) {
+      stubs = LLVMModuleCreateWithNameInContext("repl_stubs", s->ctx);
+      LLVMSetTarget(stubs, LLVMGetTarget(mod));
+      LLVMSetDataLayout(stubs, LLVMGetDataLayoutStr(mod));
+    }
+    LLVMValueRef decl = LLVMGetNamedFunction(mod, splits[i].name);
+    ny_orc_repl_emit_stub(stubs, splits[i].name, splits[i].type,
+                          decl ? LLVMGetFunctionCallConv(decl) : LLVMCCallConv);
+  }
+  ok = ny_orc_repl_add_ir(s, rt, mod, error_message) && ok;
+  if (module_consumed)
+    *module_consumed = true;
+  if (stubs)
+    ok = ny_orc_repl_add_ir(s, NULL, stubs, error_message) && ok;
+
+  if (ok && n) {
+    LLVMOrcCSymbolAliasMapPairs pairs = calloc(n, sizeof(*pairs));
+    for (size_t i = 0; i < n; i++) {
+      pairs[i].Name = LLVMOrcLLJITMangleAndIntern(s->jit, splits[i].lazy);
+      pairs[i].Entry.Name = LLVMOrcLLJITMangleAndIntern(s->jit, splits[i].body);
+      pairs[i].Entry.Flags.GenericFlags =
+          LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable;
+      pairs[i].Entry.Flags.TargetFlags = 0;
+    }
+    LLVMOrcMaterializationUnitRef mu =
+        LLVMOrcLazyReexports(s->lctm, s->ism, dylib, pairs, n);
+    free(pairs);
+    LLVMErrorRef err = LLVMOrcJITDylibDefine(dylib, mu);
+    if (err) {
+      LLVMOrcDisposeMaterializationUnit(mu);
+      if (error_message && !*error_message)
+        *error_message = ny_orc_error_message(err);
+      else
+        LLVMConsumeError(err);
+      ok = false;
+    }
+  }
+
+  for (size_t i = 0; ok && i < n; i++) {
+    if (!splits[i].pub)
+      continue;
+    uint64_t lazy = 0;
+    ok = ny_orc_repl_lookup(s, splits[i].lazy, &lazy, error_message);
+    ny_orc_repl_fn_t *fn = ok ? ny_orc_repl_find_fn(s, splits[i].name) : NULL;
+    if (ok && !fn) {
+      char *slot_name = ny_orc_repl_suffixed(splits[i].name, ".__ny_slot", 0);
+      uint64_t slot = 0;
+      ok = ny_orc_repl_lookup(s, slot_name, &slot, error_message);
+      free(slot_name);
+      if (ok) {
+        ny_orc_repl_fn_t rec = {ny_strdup(splits[i].name), splits[i].type,
+                                (uint64_t *)(uintptr_t)slot};
+        vec_push(&s->fns, rec);
+        fn = &s->fns.data[s->fns.len - 1];
+      }
+    }
+    if (fn)
+      __atomic_store_n(fn->slot, lazy, __ATOMIC_RELEASE);
+  }
+  if (ok)
+    ok = ny_orc_repl_lookup(s, entry_name, entry_addr, error_message);
+  if (!ok) {
+    LLVMErrorRef err = LLVMOrcResourceTrackerRemove(rt);
+    if (err)
+      LLVMConsumeError(err);
+  }
+  LLVMOrcReleaseResourceTracker(rt);
+  ny_orc_repl_free_splits(splits, n);
+  return ok ? NY_ORC_REPL_OK : NY_ORC_REPL_ERROR;
+}
+
+void ny_orc_repl_dispose(ny_orc_repl_t *s) {
+  if (!s)
+    return;
+  LLVMOrcThreadSafeContextRef ts_ctx = s->ts_ctx;
+  LLVMContextRef ctx = s->ctx;
+  ny_orc_repl_free(s);
+  if (ts_ctx)
+    LLVMOrcDisposeThreadSafeContext(ts_ctx);
+  else if (ctx)
+    LLVMContextDispose(ctx);
+}
+#else
+ny_orc_repl_t *ny_orc_repl_create(LLVMContextRef ctx, LLVMModuleRef std_module,
+                                  codegen_t *std_cg, const char *std_object_path,
+                                  char **error_message) {
+  (void)ctx;
+  (void)std_module;
+  (void)std_cg;
+  (void)std_object_path;
+  if (error_message)
+    *error_message = ny_strdup(
+        "ORC JIT requires LLVM 21 or newer; use the default MCJIT engine");
+  return NULL;
+}
+
+ny_orc_repl_status ny_orc_repl_add_chunk(ny_orc_repl_t *s, LLVMModuleRef mod,
+                                         codegen_t *cg, const char *entry_name,
+                                         uint64_t *entry_addr, bool *module_consumed,
+                                         char **error_message) {
+  (void)s;
+  (void)mod;
+  (void)cg;
+  (void)entry_name;
+  if (entry_addr)
+    *entry_addr = 0;
+  if (module_consumed)
+    *module_consumed = false;
+  if (error_message)
+    *error_message = NULL;
+  return NY_ORC_REPL_ERROR;
+}
+
+bool ny_orc_repl_lookup(ny_orc_repl_t *s, const char *name, uint64_t *addr,
+                        char **error_message) {
+  (void)s;
+  (void)name;
+  (void)error_message;
+  if (addr)
+    *addr = 0;
+  return false;
+}
+
+void ny_orc_repl_dispose(ny_orc_repl_t *s) {
+  if (!s)
+    return;
+  if (s->ctx)
+    LLVMContextDispose(s->ctx);
+  free(s->fns.data);
+  free(s->defined);
+  free(s);
+}
+#endif
+
 static int compare_func_info(const void *a, const void *b) {
   const uint64_t a_addr = ((const struct {
                             uint64_t addr;
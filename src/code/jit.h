@@ -23,8 +23,30 @@ bool ny_orc_jit_execute(codegen_t *cg, LLVMModuleRef module,
                         LLVMContextRef context, uint64_t *script_addr,
                         uint64_t *main_addr, void **out_rt,
                         bool *module_consumed, char **error_message);
+bool ny_orc_jit_execute_entry(codegen_t *cg, LLVMModuleRef module,
+                              LLVMContextRef context, const char *entry_name,
+                              uint64_t *entry_addr, void **out_rt,
+                              bool *module_consumed, char **error_message);
 void ny_orc_jit_remove_module(void *rt);
 void ny_orc_jit_dispose(void *jit);
+
+typedef struct ny_orc_repl ny_orc_repl_t;
+typedef enum {
+  NY_ORC_REPL_OK,
+  NY_ORC_REPL_REBUILD,
+  NY_ORC_REPL_ERROR,
+} ny_orc_repl_status;
+
+ny_orc_repl_t *ny_orc_repl_create(LLVMContextRef ctx, LLVMModuleRef std_module,
+                                  codegen_t *std_cg, const char *std_object_path,
+                                  char **error_message);
+ny_orc_repl_status ny_orc_repl_add_chunk(ny_orc_repl_t *session, LLVMModuleRef module,
+                                         codegen_t *cg, const char *entry_name,
+                                         uint64_t *entry_addr, bool *module_consumed,
+                                         char **error_message);
+bool ny_orc_repl_lookup(ny_orc_repl_t *session, const char *name, uint64_t *addr,
+                        char **error_message);
+void ny_orc_repl_dispose(ny_orc_repl_t *session);
 int64_t rt_set_args(int64_t argc, int64_t argv, int64_t envp);
 
 #endif
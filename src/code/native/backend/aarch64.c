@@ -1,87 +1,463 @@
 #include "code/native/internal.h"
 
 #include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/* ------------------------------------------------------------------ */
+/* AAPCS64 planning shared with object/aarch64.c                      */
+/* ------------------------------------------------------------------ */
+
+static int ny_a64_align(int n, int align) {
+  return (n + align - 1) & ~(align - 1);
+}
+
+/* The packed call metadata carries SysV eightbyte classes. An AAPCS64
+ * composite that is not a homogeneous floating aggregate is passed as its
+ * memory image, which matches SysV INTEGER/MEMORY data. SSE-classed shapes
+ * and the 24/32-byte sizes that could be HFAs of doubles are not
+ * distinguishable here and are rejected rather than guessed. */
+static bool ny_a64_agg_supported(uint32_t packed) {
+  uint32_t size = NY_NIR_ARG_AGG_SIZE(packed);
+  if (size == 0)
+    return false;
+  if (size > 16)
+    return size != 24 && size != 32;
+  for (int chunk = 0; chunk < 2; ++chunk) {
+    unsigned cls = NY_NIR_ARG_AGG_CLASS(packed, chunk);
+    if (cls != NY_NIR_ARG_CLASS_NONE && cls != NY_NIR_ARG_CLASS_INTEGER &&
+        cls != NY_NIR_ARG_CLASS_MEMORY)
+      return false;
+  }
+  return true;
+}
+
+bool ny_a64_plan_call(const ny_nir_inst_t *in, int value_count,
+                      const ny_nir_type_map_t *types,
+                      ny_a64_call_plan_t *plan, char *err, size_t err_len) {
+  int vals[NY_NIR_CALL_MAX_ARGS];
+  int argc = 0;
+  if (!plan || !ny_nir_call_args(in, value_count, vals, NY_NIR_CALL_MAX_ARGS,
+                                 &argc, err, err_len))
+    return false;
+  plan->argc = 0;
+  plan->sret_value = -1;
+  plan->stack_bytes = 0;
+  plan->copy_bytes = 0;
+  int first = 0;
+  if (in->flags & NY_NIR_INST_F_SRET) {
+    if (argc == 0) {
+      ny_native_set_err(err, err_len,
+                        "AAPCS64 call: sret call has no return pointer");
+      return false;
+    }
+    plan->sret_value = vals[0];
+    first = 1;
+  }
+  int gp = 0, fp = 0, stack = 0, copy = 0;
+  for (int i = first; i < argc; ++i) {
+    ny_a64_arg_t *a = &plan->args[plan->argc++];
+    *a = (ny_a64_arg_t){.value = vals[i], .reg = -1, .stack_off = -1,
+                        .copy_off = -1};
+    uint32_t packed = in->arg_sizes ? in->arg_sizes[i] : 0;
+    if (packed) {
+      if (!ny_a64_agg_supported(packed)) {
+        ny_native_set_err(err, err_len,
+                          "AAPCS64 call: aggregate argument %d (%u bytes) may be "
+                          "a floating aggregate, which is not represented",
+                          i, (unsigned)NY_NIR_ARG_AGG_SIZE(packed));
+        return false;
+      }
+      a->size = NY_NIR_ARG_AGG_SIZE(packed);
+      if (a->size > 16) {
+        a->kind = NY_A64_ARG_AGG_REF;
+        a->copy_off = copy;
+        copy += ny_a64_align((int)a->size, 16);
+        if (gp < 8) {
+          a->reg = gp++;
+        } else {
+          a->stack_off = stack;
+          stack += 8;
+        }
+      } else {
+        a->kind = NY_A64_ARG_AGG;
+        a->words = (int)((a->size + 7) / 8);
+        if (gp + a->words <= 8) {
+          a->reg = gp;
+          gp += a->words;
+        } else {
+          gp = 8;
+          a->stack_off = stack;
+          stack += a->words * 8;
+        }
+      }
+      continue;
+    }
+    bool f64 = types && types->value_f64 && types->value_f64[vals[i]];
+    bool f32 = types && types->value_f32 && types->value_f32[vals[i]];
+    a->kind = (f64 || f32) ? NY_A64_ARG_FP : NY_A64_ARG_GP;
+    a->f32 = f32;
+    int *next = a->kind == NY_A64_ARG_FP ? &fp : &gp;
+    if (*next < 8) {
+      a->reg = (*next)++;
+    } else {
+      a->stack_off = stack;
+      stack += 8;
+    }
+  }
+  plan->stack_bytes = ny_a64_align(stack, 16);
+  plan->copy_bytes = ny_a64_align(copy, 16);
+  return true;
+}
+
+/* The lowerer binds parameters as the first locals. Any local read before a
+ * store must arrive from the caller, so the highest such slot bounds the
+ * parameter block even when an earlier parameter is assigned first. */
+int ny_a64_param_count(const ny_nir_func_t *nir, int local_count) {
+  if (!nir || local_count <= 0)
+    return 0;
+  bool *stored = calloc((size_t)local_count, sizeof(bool));
+  if (!stored)
+    return local_count < 8 ? local_count : 8;
+  int count = 0;
+  for (size_t i = 0; i < nir->len; ++i) {
+    const ny_nir_inst_t *in = &nir->data[i];
+    if (in->imm < 0 || in->imm >= local_count)
+      continue;
+    if (in->op == NY_NIR_STORE_LOCAL)
+      stored[in->imm] = true;
+    else if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NYIR_ADDR_LOCAL) &&
+             !stored[in->imm] && (int)in->imm + 1 > count)
+      count = (int)in->imm + 1;
+  }
+  free(stored);
+  return count;
+}
+
+/* Linear-scan assignment of integer values to registers. Values whose
+ * interval crosses a call live in callee-saved x19-x28, the others in the
+ * caller-saved temporaries x9-x15; x0-x8, x16 and x17 stay free for ABI
+ * setup and scratch. Intervals cover phi edge copies and are extended over
+ * loop back-edges so a value defined before a loop and read inside it keeps
+ * its register for the whole loop. Floating values and any overflow keep
+ * their stack slots.
+ * NYTRIX_NATIVE_NO_REGALLOC disables the pass. */
+bool ny_a64_allocate_registers(const ny_nir_func_t *nir,
+                               const ny_nir_type_map_t *types,
+                               int8_t *value_reg) {
+  int count = nir ? nir->next_value : 0;
+  if (!nir || !value_reg || count <= 0)
+    return true;
+  memset(value_reg, NY_A64_REG_NONE, (size_t)count);
+  const char *disabled = getenv("NYTRIX_NATIVE_NO_REGALLOC");
+  if (disabled && disabled[0] && strcmp(disabled, "0") != 0 &&
+      strcmp(disabled, "false") != 0 && strcmp(disabled, "off") != 0)
+    return true;
+  int *def = malloc((size_t)count * sizeof(*def));
+  int *last_use = malloc((size_t)count * sizeof(*last_use));
+  int *next_call = malloc((nir->len + 1u) * sizeof(*next_call));
+  if (!def || !last_use || !next_call) {
+    free(def);
+    free(last_use);
+    free(next_call);
+    return false;
+  }
+  for (int v = 0; v < count; ++v)
+    def[v] = last_use[v] = -1;
+  for (size_t i = 0; i < nir->len; ++i) {
+    const ny_nir_inst_t *in = &nir->data[i];
+    if (in->dst >= 0 && in->dst < count && def[in->dst] < 0)
+      def[in->dst] = (int)i;
+    const int operands[] = {in->a, in->b, in->c, in->d, in->e, in->f};
+    for (size_t k = 0; k < sizeof(operands) / sizeof(operands[0]); ++k) {
+      if (in->op == NY_NIR_BR || in->op == NY_NIR_LABEL)
+        break;
+      int v = operands[k];
+      if (v >= 0 && v < count)
+        last_use[v] = (int)i;
+    }
+    for (size_t k = 0; in->op == NY_NIR_CALL && k < in->extra_args_len; ++k) {
+      int v = in->extra_args[k];
+      if (v >= 0 && v < count)
+        last_use[v] = (int)i;
+    }
+  }
+  if (!ny_nir_phi_extend_intervals(nir, def, last_use, count)) {
+    free(def);
+    free(last_use);
+    free(next_call);
+    return false;
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < nir->len; ++i) {
+      const ny_nir_inst_t *br = &nir->data[i];
+      if (br->op != NY_NIR_BR && br->op != NY_NIR_BR_IF)
+        continue;
+      for (size_t l = 0; l <= i; ++l) {
+        if (nir->data[l].op != NY_NIR_LABEL || nir->data[l].imm != br->imm)
+          continue;
+        for (int v = 0; v < count; ++v) {
+          if (def[v] >= 0 && def[v] < (int)l && last_use[v] >= (int)l &&
+              last_use[v] < (int)i) {
+            last_use[v] = (int)i;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+  next_call[nir->len] = INT_MAX;
+  for (size_t i = nir->len; i > 0; --i)
+    next_call[i - 1] =
+        nir->data[i - 1].op == NY_NIR_CALL ? (int)(i - 1) : next_call[i];
+  static const int8_t caller_regs[] = {9, 10, 11, 12, 13, 14, 15};
+  static const int8_t callee_regs[] = {19, 20, 21, 22, 23, 24, 25, 26, 27, 28};
+  int caller_end[sizeof(caller_regs)];
+  int callee_end[sizeof(callee_regs)];
+  for (size_t r = 0; r < sizeof(caller_regs); ++r)
+    caller_end[r] = -1;
+  for (size_t r = 0; r < sizeof(callee_regs); ++r)
+    callee_end[r] = -1;
+  for (size_t i = 0; i < nir->len; ++i) {
+    int v = nir->data[i].dst;
+    /* A phi result is written on its incoming edges, ahead of the phi. */
+    bool phi = nir->data[i].op == NYIR_PHI;
+    if (v < 0 || v >= count || (def[v] != (int)i && !phi) ||
+        last_use[v] <= (int)i ||
+        (types && types->value_f64 && types->value_f64[v]) ||
+        (types && types->value_f32 && types->value_f32[v]))
+      continue;
+    int start = def[v];
+    bool crosses_call = next_call[start + 1] < last_use[v];
+    const int8_t *regs = crosses_call ? callee_regs : caller_regs;
+    int *end = crosses_call ? callee_end : caller_end;
+    size_t n = crosses_call ? sizeof(callee_regs) : sizeof(caller_regs);
+    for (size_t r = 0; r < n; ++r) {
+      if (start >= end[r]) {
+        value_reg[v] = regs[r];
+        end[r] = last_use[v];
+        break;
+      }
+    }
+  }
+  free(def);
+  free(last_use);
+  free(next_call);
+  return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* NYIR -> AArch64 assembly                                           */
+/*                                                                    */
+/* Frame (x29 == sp after the prologue, all offsets positive):        */
+/*   [x29, #0]   saved x29/x30                                        */
+/*   [x29, #16]  spill slots for values without a register            */
+/*               local slots                                          */
+/*               callee-saved registers used by the allocator         */
+/* Addressing through x29 leaves sp free for alloca and outgoing      */
+/* stack arguments.                                                   */
+/* ------------------------------------------------------------------ */
+
+static const char *const ny_a64_x[31] = {
+    "x0",  "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",
+    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
+    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+    "x24", "x25", "x26", "x27", "x28", "x29", "x30"};
+
 typedef struct {
   ny_native_writer_t *w;
   const ny_native_target_info_t *target;
   const ny_nir_func_t *nir;
-  int frame_bytes;
-  int local_base;
+  ny_nir_type_map_t types;
+  int8_t *value_reg;
+  int *value_spill;
+  int spill_slots;
   int max_local_slot;
+  int save_slot[31];
+  int save_count;
+  int frame_bytes;
+  const char *name;
+  int copy_seq;
+  /* Label of the block being emitted (-1 if none); phi edge copies are
+   * keyed by it. phi_edges numbers the skip labels around them. */
+  int64_t cur_label;
+  int phi_edges;
+  bool has_phi;
   char epilogue_label[128];
   char *err;
   size_t err_len;
 } ny_a64_nir_ctx_t;
 
-static int ny_a64_align(int n, int align) {
-  return (n + align - 1) & ~(align - 1);
+static int ny_a64_local_off(const ny_a64_nir_ctx_t *c, int local) {
+  return 16 + (c->spill_slots + local) * 8;
 }
 
-static void ny_a64_compute_frame(ny_a64_nir_ctx_t *c) {
-  c->max_local_slot = 0;
-  for (size_t i = 0; c->nir && i < c->nir->len; ++i) {
-    const ny_nir_inst_t *in = &c->nir->data[i];
-    if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NY_NIR_STORE_LOCAL ||
-         in->op == NYIR_ADDR_LOCAL) &&
-        in->imm >= c->max_local_slot)
-      c->max_local_slot = (int)in->imm + 1;
+static int ny_a64_save_off(const ny_a64_nir_ctx_t *c, int reg) {
+  return 16 + (c->spill_slots + c->max_local_slot + c->save_slot[reg]) * 8;
+}
+
+static bool ny_a64_compute_frame(ny_a64_nir_ctx_t *c) {
+  c->max_local_slot = (int)ny_native_nir_local_count(c->nir);
+  int values = c->nir->next_value > 0 ? c->nir->next_value : 0;
+  if (!ny_nir_type_map_init(&c->types, c->nir, (size_t)c->max_local_slot)) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 NYIR emit: type classification allocation failed");
+    return false;
+  }
+  if (values > 0) {
+    c->value_reg = malloc((size_t)values * sizeof(*c->value_reg));
+    c->value_spill = malloc((size_t)values * sizeof(*c->value_spill));
+    if (!c->value_reg || !c->value_spill ||
+        !ny_a64_allocate_registers(c->nir, &c->types, c->value_reg)) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 NYIR emit: register allocation out of memory");
+      return false;
+    }
+  }
+  for (int r = 0; r < 31; ++r)
+    c->save_slot[r] = -1;
+  for (int v = 0; v < values; ++v) {
+    int reg = c->value_reg[v];
+    if (reg == NY_A64_REG_NONE) {
+      c->value_spill[v] = c->spill_slots++;
+      continue;
+    }
+    c->value_spill[v] = -1;
+    if (reg >= 19 && reg <= 28 && c->save_slot[reg] < 0)
+      c->save_slot[reg] = c->save_count++;
+  }
+  c->frame_bytes = ny_a64_align(
+      16 + (c->spill_slots + c->max_local_slot + c->save_count) * 8, 16);
+  if (c->frame_bytes >= (1 << 24)) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 NYIR emit: frame of %d bytes is too large",
+                      c->frame_bytes);
+    return false;
   }
-  int value_slots = c->nir && c->nir->next_value > 0 ? c->nir->next_value : 0;
-  c->local_base = value_slots * 8;
-  c->frame_bytes = ny_a64_align((value_slots + c->max_local_slot) * 8, 16);
+  return true;
+}
+
+static void ny_a64_ctx_free(ny_a64_nir_ctx_t *c) {
+  ny_nir_type_map_free(&c->types);
+  free(c->value_reg);
+  free(c->value_spill);
 }
 
 static bool ny_a64_mem(ny_a64_nir_ctx_t *c, const char *op, const char *reg,
-                       int off) {
-  if (off < 0 || off > 32760 || (off & 7) != 0) {
+                       const char *base, int off, int scale) {
+  if (off < 0 || off > 4095 * scale || (off % scale) != 0) {
     ny_native_set_err(c->err, c->err_len,
-                      "AArch64 NYIR emit: stack offset %d is out of encodable range",
+                      "AArch64 NYIR emit: frame offset %d is out of encodable range",
                       off);
     return false;
   }
-  return ny_native_printf(c->w, "\t%s\t%s, [sp, #%d]\n", op, reg, off);
+  return ny_native_printf(c->w, "\t%s\t%s, [%s, #%d]\n", op, reg, base, off);
 }
 
-static bool ny_a64_load_value(ny_a64_nir_ctx_t *c, const char *reg, int value) {
-  if (value < 0 || !c || !c->nir || value >= c->nir->next_value) {
-    ny_native_set_err(c ? c->err : NULL, c ? c->err_len : 0,
-                      "AArch64 NYIR emit: invalid value v%d", value);
+/* add/sub with an immediate of up to 24 bits. */
+static bool ny_a64_addsub_imm(ny_a64_nir_ctx_t *c, const char *op,
+                              const char *dst, const char *src, int imm) {
+  if (imm < 0 || imm >= (1 << 24)) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 NYIR emit: immediate %d is out of range", imm);
     return false;
   }
-  return ny_a64_mem(c, "ldr", reg, value * 8);
+  if (imm >> 12) {
+    if (!ny_native_printf(c->w, "\t%s\t%s, %s, #%d, lsl #12\n", op, dst, src,
+                          imm >> 12))
+      return false;
+    src = dst;
+  }
+  if ((imm & 4095) || !(imm >> 12))
+    return ny_native_printf(c->w, "\t%s\t%s, %s, #%d\n", op, dst, src,
+                            imm & 4095);
+  return true;
 }
 
-static bool ny_a64_store_value(ny_a64_nir_ctx_t *c, int value,
-                               const char *reg) {
-  if (value < 0 || !c || !c->nir || value >= c->nir->next_value) {
-    ny_native_set_err(c ? c->err : NULL, c ? c->err_len : 0,
-                      "AArch64 NYIR emit: invalid destination v%d", value);
+static bool ny_a64_check_value(ny_a64_nir_ctx_t *c, int value) {
+  if (value >= 0 && value < c->nir->next_value)
+    return true;
+  ny_native_set_err(c->err, c->err_len,
+                    "AArch64 NYIR emit: invalid value v%d", value);
+  return false;
+}
+
+/* Register holding value: its allocated register, or scratch after a reload. */
+static const char *ny_a64_src(ny_a64_nir_ctx_t *c, int value,
+                              const char *scratch) {
+  if (!ny_a64_check_value(c, value))
+    return NULL;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return ny_a64_x[(int)c->value_reg[value]];
+  return ny_a64_mem(c, "ldr", scratch, "x29", 16 + c->value_spill[value] * 8,
+                    8)
+             ? scratch
+             : NULL;
+}
+
+static bool ny_a64_load_value(ny_a64_nir_ctx_t *c, const char *reg,
+                              int value) {
+  const char *src = ny_a64_src(c, value, reg);
+  if (!src)
     return false;
+  return src == reg || strcmp(src, reg) == 0 ||
+         ny_native_printf(c->w, "\tmov\t%s, %s\n", reg, src);
+}
+
+/* Register a result should be computed into. */
+static const char *ny_a64_dst(ny_a64_nir_ctx_t *c, int value,
+                              const char *scratch) {
+  if (!ny_a64_check_value(c, value))
+    return NULL;
+  return c->value_reg[value] != NY_A64_REG_NONE
+             ? ny_a64_x[(int)c->value_reg[value]]
+             : scratch;
+}
+
+static bool ny_a64_finish(ny_a64_nir_ctx_t *c, int value, const char *reg) {
+  if (c->value_reg[value] != NY_A64_REG_NONE) {
+    const char *home = ny_a64_x[(int)c->value_reg[value]];
+    return strcmp(home, reg) == 0 ||
+           ny_native_printf(c->w, "\tmov\t%s, %s\n", home, reg);
   }
-  return ny_a64_mem(c, "str", reg, value * 8);
+  return ny_a64_mem(c, "str", reg, "x29", 16 + c->value_spill[value] * 8, 8);
 }
 
-static bool ny_a64_load_local(ny_a64_nir_ctx_t *c, const char *reg,
-                              int local) {
-  if (local < 0 || local >= c->max_local_slot) {
-    ny_native_set_err(c->err, c->err_len,
-                      "AArch64 NYIR emit: invalid local slot %d", local);
+static bool ny_a64_store_value(ny_a64_nir_ctx_t *c, int value,
+                               const char *reg) {
+  return ny_a64_check_value(c, value) && ny_a64_finish(c, value, reg);
+}
+
+static bool ny_a64_fp_value(ny_a64_nir_ctx_t *c, bool load, int value,
+                            int vreg, bool f32) {
+  if (!ny_a64_check_value(c, value))
     return false;
+  char reg[8];
+  snprintf(reg, sizeof(reg), "%c%d", f32 ? 's' : 'd', vreg);
+  if (c->value_reg[value] != NY_A64_REG_NONE) {
+    const char *x = ny_a64_x[(int)c->value_reg[value]];
+    return load ? ny_native_printf(c->w, "\tfmov\t%s, %s%s\n", reg,
+                                   f32 ? "w" : "x", x + 1)
+                : ny_native_printf(c->w, "\tfmov\t%s%s, %s\n",
+                                   f32 ? "w" : "x", x + 1, reg);
   }
-  return ny_a64_mem(c, "ldr", reg, c->local_base + local * 8);
+  return ny_a64_mem(c, load ? "ldr" : "str", reg, "x29",
+                    16 + c->value_spill[value] * 8, f32 ? 4 : 8);
 }
 
-static bool ny_a64_store_local(ny_a64_nir_ctx_t *c, int local,
-                               const char *reg) {
+static bool ny_a64_local(ny_a64_nir_ctx_t *c, bool load, const char *reg,
+                         int local, int scale) {
   if (local < 0 || local >= c->max_local_slot) {
     ny_native_set_err(c->err, c->err_len,
                       "AArch64 NYIR emit: invalid local slot %d", local);
     return false;
   }
-  return ny_a64_mem(c, "str", reg, c->local_base + local * 8);
+  return ny_a64_mem(c, load ? "ldr" : "str", reg, "x29",
+                    ny_a64_local_off(c, local), scale);
 }
 
 static bool ny_a64_mov_imm(ny_a64_nir_ctx_t *c, const char *reg,
@@ -99,6 +475,42 @@ static bool ny_a64_mov_imm(ny_a64_nir_ctx_t *c, const char *reg,
   return true;
 }
 
+/* Phi edge copies name registers by number and spill slots from 32 up; x16
+ * carries slot-to-slot moves and x17 parks one value when the copies form a
+ * cycle. */
+#define NY_A64_PHI_SCRATCH 17
+
+static int ny_a64_phi_location(void *ctx, int value) {
+  ny_a64_nir_ctx_t *c = (ny_a64_nir_ctx_t *)ctx;
+  if (value < 0 || value >= c->nir->next_value)
+    return -1;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return c->value_reg[value];
+  return 32 + c->value_spill[value];
+}
+
+static bool ny_a64_phi_move(void *ctx, int dst, int src) {
+  ny_a64_nir_ctx_t *c = (ny_a64_nir_ctx_t *)ctx;
+  if (dst < 0 || src < 0) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 NYIR emit: phi operand has no location");
+    return false;
+  }
+  const char *reg = src < 32 ? ny_a64_x[src] : "x16";
+  if (src >= 32 && !ny_a64_mem(c, "ldr", reg, "x29", 16 + (src - 32) * 8, 8))
+    return false;
+  if (dst >= 32)
+    return ny_a64_mem(c, "str", reg, "x29", 16 + (dst - 32) * 8, 8);
+  return ny_native_printf(c->w, "\tmov\t%s, %s\n", ny_a64_x[dst], reg);
+}
+
+static bool ny_a64_phi_edge(ny_a64_nir_ctx_t *c, int64_t label) {
+  if (!c->has_phi)
+    return true;
+  return ny_nir_phi_moves(c->nir, label, c->cur_label, ny_a64_phi_location,
+                          NY_A64_PHI_SCRATCH, ny_a64_phi_move, c);
+}
+
 static const char *ny_a64_cond(ny_nir_cmp_t cmp) {
   switch (cmp) {
   case NY_NIR_CMP_EQ:
@@ -117,12 +529,142 @@ static const char *ny_a64_cond(ny_nir_cmp_t cmp) {
   return "eq";
 }
 
+/* After fcmp an unordered result sets C and V: mi/ls make < and <= false on
+ * NaN, and ne is the only predicate that holds, matching the x86-64 lowering. */
+static const char *ny_a64_fcond(ny_nir_cmp_t cmp) {
+  switch (cmp) {
+  case NY_NIR_CMP_LT:
+    return "mi";
+  case NY_NIR_CMP_LE:
+    return "ls";
+  default:
+    return ny_a64_cond(cmp);
+  }
+}
+
 static bool ny_a64_emit_binop(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in,
                               const char *op) {
-  return ny_a64_load_value(c, "x0", in->a) &&
-         ny_a64_load_value(c, "x1", in->b) &&
-         ny_native_printf(c->w, "\t%s\tx0, x0, x1\n", op) &&
-         ny_a64_store_value(c, in->dst, "x0");
+  const char *a = ny_a64_src(c, in->a, "x0");
+  const char *b = a ? ny_a64_src(c, in->b, "x1") : NULL;
+  const char *d = b ? ny_a64_dst(c, in->dst, "x0") : NULL;
+  return d && ny_native_printf(c->w, "\t%s\t%s, %s, %s\n", op, d, a, b) &&
+         ny_a64_finish(c, in->dst, d);
+}
+
+static bool ny_a64_emit_fp_binop(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in,
+                                 const char *op, bool f32) {
+  char r = f32 ? 's' : 'd';
+  return ny_a64_fp_value(c, true, in->a, 0, f32) &&
+         ny_a64_fp_value(c, true, in->b, 1, f32) &&
+         ny_native_printf(c->w, "\t%s\t%c0, %c0, %c1\n", op, r, r, r) &&
+         ny_a64_fp_value(c, false, in->dst, 0, f32);
+}
+
+/* Byte copy from [x17] to [x16]; clobbers x0 and, for long copies, x2. */
+static bool ny_a64_emit_copy(ny_a64_nir_ctx_t *c, int64_t size) {
+  if (size <= 0)
+    return true;
+  if (size > 256) {
+    int seq = c->copy_seq++;
+    return ny_a64_mov_imm(c, "x2", size) &&
+           ny_native_printf(c->w,
+                            ".Lny_a64_copy_%s_%d:\n"
+                            "\tldrb\tw0, [x17], #1\n"
+                            "\tstrb\tw0, [x16], #1\n"
+                            "\tsubs\tx2, x2, #1\n"
+                            "\tb.ne\t.Lny_a64_copy_%s_%d\n",
+                            c->name, seq, c->name, seq);
+  }
+  int64_t off = 0;
+  for (; off + 8 <= size; off += 8)
+    if (!ny_native_printf(c->w, "\tldr\tx0, [x17, #%" PRId64 "]\n"
+                                "\tstr\tx0, [x16, #%" PRId64 "]\n",
+                          off, off))
+      return false;
+  for (; off < size; ++off)
+    if (!ny_native_printf(c->w, "\tldrb\tw0, [x17, #%" PRId64 "]\n"
+                                "\tstrb\tw0, [x16, #%" PRId64 "]\n",
+                          off, off))
+      return false;
+  return true;
+}
+
+static bool ny_a64_emit_call(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in) {
+  ny_a64_call_plan_t plan;
+  if (!ny_a64_plan_call(in, c->nir->next_value, &c->types, &plan, c->err,
+                        c->err_len))
+    return false;
+  int area = plan.stack_bytes + plan.copy_bytes;
+  if (area && !ny_a64_addsub_imm(c, "sub", "sp", "sp", area))
+    return false;
+  /* Memory-resident arguments first: the copies use x0/x2/x16/x17, which
+   * the register arguments below would otherwise lose. */
+  for (int i = 0; i < plan.argc; ++i) {
+    const ny_a64_arg_t *a = &plan.args[i];
+    if (a->kind == NY_A64_ARG_AGG_REF) {
+      if (!ny_a64_load_value(c, "x17", a->value) ||
+          !ny_a64_addsub_imm(c, "add", "x16", "sp",
+                             plan.stack_bytes + a->copy_off) ||
+          !ny_a64_emit_copy(c, a->size))
+        return false;
+      if (a->stack_off >= 0 &&
+          (!ny_a64_addsub_imm(c, "add", "x0", "sp",
+                              plan.stack_bytes + a->copy_off) ||
+           !ny_a64_mem(c, "str", "x0", "sp", a->stack_off, 8)))
+        return false;
+    } else if (a->kind == NY_A64_ARG_AGG && a->stack_off >= 0) {
+      if (!ny_a64_load_value(c, "x17", a->value) ||
+          !ny_a64_addsub_imm(c, "add", "x16", "sp", a->stack_off) ||
+          !ny_a64_emit_copy(c, a->size))
+        return false;
+    } else if (a->stack_off >= 0) {
+      if (!ny_a64_load_value(c, "x0", a->value) ||
+          !ny_a64_mem(c, "str", "x0", "sp", a->stack_off, 8))
+        return false;
+    }
+  }
+  for (int i = 0; i < plan.argc; ++i) {
+    const ny_a64_arg_t *a = &plan.args[i];
+    if (a->reg < 0)
+      continue;
+    switch (a->kind) {
+    case NY_A64_ARG_GP:
+      if (!ny_a64_load_value(c, ny_a64_x[a->reg], a->value))
+        return false;
+      break;
+    case NY_A64_ARG_FP:
+      if (!ny_a64_fp_value(c, true, a->value, a->reg, a->f32))
+        return false;
+      break;
+    case NY_A64_ARG_AGG:
+      if (!ny_a64_load_value(c, "x17", a->value))
+        return false;
+      for (int k = 0; k < a->words; ++k)
+        if (!ny_native_printf(c->w, "\tldr\t%s, [x17, #%d]\n",
+                              ny_a64_x[a->reg + k], k * 8))
+          return false;
+      break;
+    case NY_A64_ARG_AGG_REF:
+      if (!ny_a64_addsub_imm(c, "add", ny_a64_x[a->reg], "sp",
+                             plan.stack_bytes + a->copy_off))
+        return false;
+      break;
+    }
+  }
+  if (plan.sret_value >= 0 && !ny_a64_load_value(c, "x8", plan.sret_value))
+    return false;
+  const char *sym = in->symbol ? in->symbol : "";
+  bool is_ext = (in->flags & NY_NIR_INST_F_EXTERN) != 0;
+  if (!ny_native_printf(c->w, "\tbl\t%s%s%s\n", c->target->symbol_prefix,
+                        is_ext ? "" : "ny_fn_", sym))
+    return false;
+  if (area && !ny_a64_addsub_imm(c, "add", "sp", "sp", area))
+    return false;
+  if (in->dst < 0)
+    return true;
+  if (c->types.value_f64[in->dst] || c->types.value_f32[in->dst])
+    return ny_a64_fp_value(c, false, in->dst, 0, c->types.value_f32[in->dst]);
+  return ny_a64_store_value(c, in->dst, "x0");
 }
 
 static bool ny_a64_emit_inst(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in) {
@@ -130,11 +672,25 @@ static bool ny_a64_emit_inst(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in) {
   case NY_NIR_NOP:
     return true;
   case NY_NIR_CONST_I64:
-    return ny_a64_mov_imm(c, "x0", in->imm) &&
-           ny_a64_store_value(c, in->dst, "x0");
-  case NY_NIR_COPY:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_store_value(c, in->dst, "x0");
+  case NYIR_CONST_F64: {
+    if (in->dst < 0)
+      return true;
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d && ny_a64_mov_imm(c, d, in->imm) && ny_a64_finish(c, in->dst, d);
+  }
+  case NYIR_CONST_F32: {
+    if (in->dst < 0)
+      return true;
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d && ny_a64_mov_imm(c, d, (int64_t)(uint32_t)in->imm) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NY_NIR_COPY: {
+    if (in->dst < 0)
+      return true;
+    const char *a = ny_a64_src(c, in->a, "x0");
+    return a && ny_a64_store_value(c, in->dst, a);
+  }
   case NY_NIR_ADD_I64:
     return ny_a64_emit_binop(c, in, "add");
   case NY_NIR_SUB_I64:
@@ -152,104 +708,199 @@ static bool ny_a64_emit_inst(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in) {
   case NY_NIR_SAR_I64:
     return ny_a64_emit_binop(c, in, "asr");
   case NY_NIR_DIV_I64:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_load_value(c, "x1", in->b) &&
-           ny_native_put(c->w, "\tsdiv\tx0, x0, x1\n") &&
-           ny_a64_store_value(c, in->dst, "x0");
-  case NY_NIR_MOD_I64:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_load_value(c, "x1", in->b) &&
-           ny_native_put(c->w,
-                         "\tsdiv\tx2, x0, x1\n"
-                         "\tmsub\tx0, x2, x1, x0\n") &&
-           ny_a64_store_value(c, in->dst, "x0");
-  case NY_NIR_CMP_I64:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_load_value(c, "x1", in->b) &&
-           ny_native_put(c->w, "\tcmp\tx0, x1\n") &&
-           ny_native_printf(c->w, "\tcset\tx0, %s\n", ny_a64_cond(in->cmp)) &&
-           ny_a64_store_value(c, in->dst, "x0");
+    return ny_a64_emit_binop(c, in, "sdiv");
+  case NY_NIR_MOD_I64: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    const char *b = a ? ny_a64_src(c, in->b, "x1") : NULL;
+    const char *d = b ? ny_a64_dst(c, in->dst, "x0") : NULL;
+    return d &&
+           ny_native_printf(c->w, "\tsdiv\tx2, %s, %s\n\tmsub\t%s, x2, %s, %s\n",
+                            a, b, d, b, a) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NY_NIR_CMP_I64: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    const char *b = a ? ny_a64_src(c, in->b, "x1") : NULL;
+    const char *d = b ? ny_a64_dst(c, in->dst, "x0") : NULL;
+    return d && ny_native_printf(c->w, "\tcmp\t%s, %s\n\tcset\t%s, %s\n", a, b,
+                                 d, ny_a64_cond(in->cmp)) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NYIR_ADD_F64:
+    return ny_a64_emit_fp_binop(c, in, "fadd", false);
+  case NYIR_SUB_F64:
+    return ny_a64_emit_fp_binop(c, in, "fsub", false);
+  case NYIR_MUL_F64:
+    return ny_a64_emit_fp_binop(c, in, "fmul", false);
+  case NYIR_DIV_F64:
+    return ny_a64_emit_fp_binop(c, in, "fdiv", false);
+  case NYIR_ADD_F32:
+    return ny_a64_emit_fp_binop(c, in, "fadd", true);
+  case NYIR_SUB_F32:
+    return ny_a64_emit_fp_binop(c, in, "fsub", true);
+  case NYIR_MUL_F32:
+    return ny_a64_emit_fp_binop(c, in, "fmul", true);
+  case NYIR_DIV_F32:
+    return ny_a64_emit_fp_binop(c, in, "fdiv", true);
+  case NYIR_I64_TO_F64:
+  case NYIR_I64_TO_F32: {
+    bool f32 = in->op == NYIR_I64_TO_F32;
+    const char *a = ny_a64_src(c, in->a, "x0");
+    return a &&
+           ny_native_printf(c->w, "\tscvtf\t%c0, %s\n", f32 ? 's' : 'd', a) &&
+           ny_a64_fp_value(c, false, in->dst, 0, f32);
+  }
+  case NYIR_F64_TO_F32:
+    return ny_a64_fp_value(c, true, in->a, 0, false) &&
+           ny_native_put(c->w, "\tfcvt\ts0, d0\n") &&
+           ny_a64_fp_value(c, false, in->dst, 0, true);
+  case NYIR_F32_TO_F64:
+    return ny_a64_fp_value(c, true, in->a, 0, true) &&
+           ny_native_put(c->w, "\tfcvt\td0, s0\n") &&
+           ny_a64_fp_value(c, false, in->dst, 0, false);
+  case NYIR_CMP_F64:
+  case NYIR_CMP_F32: {
+    bool f32 = in->op == NYIR_CMP_F32;
+    char r = f32 ? 's' : 'd';
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d && ny_a64_fp_value(c, true, in->a, 0, f32) &&
+           ny_a64_fp_value(c, true, in->b, 1, f32) &&
+           ny_native_printf(c->w, "\tfcmp\t%c0, %c1\n\tcset\t%s, %s\n", r, r,
+                            d, ny_a64_fcond(in->cmp)) &&
+           ny_a64_finish(c, in->dst, d);
+  }
   case NY_NIR_LABEL:
     return ny_native_printf(c->w, ".Lny_nir_L%" PRId64 ":\n", in->imm);
-  case NY_NIR_LOAD_LOCAL:
-    return ny_a64_load_local(c, "x0", (int)in->imm) &&
-           ny_a64_store_value(c, in->dst, "x0");
-  case NY_NIR_STORE_LOCAL:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_store_local(c, (int)in->imm, "x0");
+  case NY_NIR_LOAD_LOCAL: {
+    if (in->dst < 0)
+      return true;
+    if (c->types.value_f64[in->dst] || c->types.value_f32[in->dst]) {
+      bool f32 = c->types.value_f32[in->dst];
+      return ny_a64_local(c, true, f32 ? "s0" : "d0", (int)in->imm,
+                          f32 ? 4 : 8) &&
+             ny_a64_fp_value(c, false, in->dst, 0, f32);
+    }
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d && ny_a64_local(c, true, d, (int)in->imm, 8) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NY_NIR_STORE_LOCAL: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    return a && ny_a64_local(c, false, a, (int)in->imm, 8);
+  }
   case NYIR_ADDR_LOCAL: {
-    int off = c->local_base + (int)in->imm * 8;
-    if (in->imm < 0 || in->imm >= c->max_local_slot || off > 4095) {
+    if (in->imm < 0 || in->imm >= c->max_local_slot) {
       ny_native_set_err(c->err, c->err_len,
                         "AArch64 NYIR emit: addr.local slot %" PRId64
                         " is out of range",
                         in->imm);
       return false;
     }
-    return ny_native_printf(c->w, "\tadd\tx0, sp, #%d\n", off) &&
-           ny_a64_store_value(c, in->dst, "x0");
-  }
-  case NYIR_LOAD_I64:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_native_put(c->w, "\tldr\tx0, [x0]\n") &&
-           ny_a64_store_value(c, in->dst, "x0");
-  case NYIR_STORE_I64:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_a64_load_value(c, "x1", in->c) &&
-           ny_native_put(c->w, "\tstr\tx1, [x0]\n");
-  case NY_NIR_CALL:
-  {
-    int args[NY_NIR_CALL_MAX_ARGS];
-    int argc = 0;
-    if (!ny_nir_call_args(in, c->nir->next_value, args,
-                          NY_NIR_CALL_MAX_ARGS, &argc, c->err, c->err_len))
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d &&
+           ny_a64_addsub_imm(c, "add", d, "x29",
+                             ny_a64_local_off(c, (int)in->imm)) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NYIR_ADDR_SYMBOL: {
+    if (in->dst < 0)
+      return true;
+    if (!in->symbol || !in->symbol[0]) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 NYIR emit: addr.symbol missing symbol name");
       return false;
-    if ((size_t)argc > c->target->gp_arg_reg_count) {
+    }
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    const char *p = c->target->symbol_prefix;
+    bool macho = strcmp(c->target->object_format, "macho") == 0;
+    return d &&
+           (macho ? ny_native_printf(c->w,
+                                     "\tadrp\t%s, %sny_fn_%s@PAGE\n"
+                                     "\tadd\t%s, %s, %sny_fn_%s@PAGEOFF\n",
+                                     d, p, in->symbol, d, d, p, in->symbol)
+                  : ny_native_printf(c->w,
+                                     "\tadrp\t%s, %sny_fn_%s\n"
+                                     "\tadd\t%s, %s, :lo12:%sny_fn_%s\n",
+                                     d, p, in->symbol, d, d, p, in->symbol)) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NYIR_ALLOCA: {
+    if (in->dst < 0)
+      return true;
+    if (in->imm < 0 || in->imm >= (1 << 24) - 15) {
       ny_native_set_err(c->err, c->err_len,
-                        "AArch64 NYIR emit: %d scalar arguments exceed the %zu-register ABI slice",
-                        argc, c->target->gp_arg_reg_count);
+                        "AArch64 NYIR emit: alloca of %" PRId64
+                        " bytes is out of range",
+                        in->imm);
       return false;
     }
-    for (int i = 0; i < argc; ++i)
-      if (!ny_a64_load_value(c, c->target->gp_arg_regs[i], args[i]))
-        return false;
-    const char *a64_sym = in->symbol ? in->symbol : "";
-    int a64_is_ext = (in->flags & NY_NIR_INST_F_EXTERN) ? 1 : 0;
-    if (!ny_native_printf(c->w, "\tbl\t%s%s%s\n", c->target->symbol_prefix,
-                          a64_is_ext ? "" : "ny_fn_", a64_sym))
+    int bytes = ny_a64_align((int)in->imm, 16);
+    const char *d = ny_a64_dst(c, in->dst, "x0");
+    return d && (bytes == 0 || ny_a64_addsub_imm(c, "sub", "sp", "sp", bytes)) &&
+           ny_native_printf(c->w, "\tmov\t%s, sp\n", d) &&
+           ny_a64_finish(c, in->dst, d);
+  }
+  case NYIR_COPY_STRUCT:
+    if (in->imm <= 0)
+      return true;
+    return ny_a64_load_value(c, "x16", in->a) &&
+           ny_a64_load_value(c, "x17", in->b) && ny_a64_emit_copy(c, in->imm);
+  case NYIR_CAPTURE_RET:
+    if (in->dst < 0)
+      return true;
+    /* Integer-classed pairs come back in x0/x1; the SysV selectors that name
+     * SSE halves have no AAPCS64 counterpart without HFA metadata. */
+    if (in->imm != 0) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 NYIR emit: capture.ret selector %" PRId64
+                        " needs floating aggregate classification",
+                        in->imm);
       return false;
-    return in->dst < 0 || ny_a64_store_value(c, in->dst, "x0");
+    }
+    return ny_a64_store_value(c, in->dst, "x1");
+  case NYIR_LOAD_I64: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    const char *d = a ? ny_a64_dst(c, in->dst, "x0") : NULL;
+    return d && ny_native_printf(c->w, "\tldr\t%s, [%s]\n", d, a) &&
+           ny_a64_finish(c, in->dst, d);
   }
+  case NYIR_STORE_I64: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    const char *v = a ? ny_a64_src(c, in->c, "x1") : NULL;
+    return v && ny_native_printf(c->w, "\tstr\t%s, [%s]\n", v, a);
+  }
+  case NY_NIR_CALL:
+    return ny_a64_emit_call(c, in);
   case NY_NIR_RET:
-    if (in->a >= 0 && !ny_a64_load_value(c, "x0", in->a))
+    if (in->a >= 0) {
+      bool f64 = c->types.value_f64[in->a], f32 = c->types.value_f32[in->a];
+      if ((f64 || f32) ? !ny_a64_fp_value(c, true, in->a, 0, f32)
+                       : !ny_a64_load_value(c, "x0", in->a))
+        return false;
+    } else if (!ny_native_put(c->w, "\tmov\tx0, #0\n")) {
       return false;
+    }
     return ny_native_printf(c->w, "\tb\t%s\n", c->epilogue_label);
+  case NYIR_PHI:
+    return true; /* copied in on each incoming edge */
   case NY_NIR_BR:
-    return ny_native_printf(c->w, "\tb\t.Lny_nir_L%" PRId64 "\n", in->imm);
-  case NY_NIR_BR_IF:
-    return ny_a64_load_value(c, "x0", in->a) &&
-           ny_native_put(c->w, "\tcmp\tx0, #0\n") &&
-           ny_native_printf(c->w, "\tb.ne\t.Lny_nir_L%" PRId64 "\n", in->imm);
-  case NYIR_CONST_F64:
-  case NYIR_ADD_F64:
-  case NYIR_SUB_F64:
-  case NYIR_MUL_F64:
-  case NYIR_DIV_F64:
-  case NYIR_I64_TO_F64:
-  case NYIR_CMP_F64:
-  case NYIR_CONST_F32:
-  case NYIR_ADD_F32:
-  case NYIR_SUB_F32:
-  case NYIR_MUL_F32:
-  case NYIR_DIV_F32:
-  case NYIR_I64_TO_F32:
-  case NYIR_F64_TO_F32:
-  case NYIR_F32_TO_F64:
-  case NYIR_CMP_F32:
-  case NYIR_ADDR_SYMBOL:
-  case NYIR_ALLOCA:
-  case NYIR_COPY_STRUCT:
-  case NYIR_CAPTURE_RET:
+    return ny_a64_phi_edge(c, in->imm) &&
+           ny_native_printf(c->w, "\tb\t.Lny_nir_L%" PRId64 "\n", in->imm);
+  case NY_NIR_BR_IF: {
+    const char *a = ny_a64_src(c, in->a, "x0");
+    if (!a)
+      return false;
+    if (!c->has_phi || !ny_nir_phi_has_edge(c->nir, in->imm, c->cur_label))
+      return ny_native_printf(c->w, "\tcbnz\t%s, .Lny_nir_L%" PRId64 "\n",
+                              a, in->imm);
+    /* The copies belong to the taken edge only. */
+    int skip = c->phi_edges++;
+    return ny_native_printf(c->w, "\tcbz\t%s, %s_phi%d\n", a,
+                            c->epilogue_label, skip) &&
+           ny_a64_phi_edge(c, in->imm) &&
+           ny_native_printf(c->w, "\tb\t.Lny_nir_L%" PRId64 "\n%s_phi%d:\n",
+                            in->imm, c->epilogue_label, skip);
+  }
   case NYIR_OP_COUNT:
     break;
   }
@@ -258,61 +909,78 @@ static bool ny_a64_emit_inst(ny_a64_nir_ctx_t *c, const ny_nir_inst_t *in) {
   return false;
 }
 
-bool ny_native_aarch64_emit_nir(ny_native_writer_t *w,
-                                const ny_native_target_info_t *target,
-                                const ny_nir_func_t *nir,
-                                const char *func_name, bool tag_return,
-                                char *err, size_t err_len) {
-  if (!w || !target || !nir)
-    return false;
-  const char *name = func_name && func_name[0] ? func_name : "rt_main";
-  ny_a64_nir_ctx_t ctx = {
-      .w = w, .target = target, .nir = nir, .err = err, .err_len = err_len};
-  snprintf(ctx.epilogue_label, sizeof(ctx.epilogue_label),
-           ".Lny_aarch64_epilogue_%s", name);
-  ny_a64_compute_frame(&ctx);
+static bool ny_a64_emit_params(ny_a64_nir_ctx_t *c) {
+  int params = ny_a64_param_count(c->nir, c->max_local_slot);
+  int gp = 0, fp = 0, stack = 0;
+  for (int i = 0; i < params; ++i) {
+    bool f64 = c->types.local_f64[i], f32 = c->types.local_f32[i];
+    if ((f64 || f32) && fp < 8) {
+      char reg[8];
+      snprintf(reg, sizeof(reg), "%c%d", f32 ? 's' : 'd', fp++);
+      if (!ny_a64_local(c, false, reg, i, f32 ? 4 : 8))
+        return false;
+    } else if (!f64 && !f32 && gp < 8) {
+      if (!ny_a64_local(c, false, ny_a64_x[gp++], i, 8))
+        return false;
+    } else {
+      /* Stack-passed: the caller's outgoing area starts at the entry sp. */
+      if (!ny_a64_mem(c, "ldr", "x16", "x29", c->frame_bytes + stack * 8, 8) ||
+          !ny_a64_local(c, false, "x16", i, 8))
+        return false;
+      stack++;
+    }
+  }
+  return true;
+}
 
-  if (!ny_native_put(w, "\t.text\n"))
-    return false;
-  if (strcmp(target->object_format, "macho") != 0 &&
-      !ny_native_printf(w, "\t.type\t%s%s, %%function\n", target->symbol_prefix,
-                        name))
-    return false;
-  if (!ny_native_printf(w, "\t.globl\t%s%s\n%s%s:\n", target->symbol_prefix,
-                        name, target->symbol_prefix, name))
-    return false;
-  if (!ny_native_put(w, "\tstp\tx29, x30, [sp, #-16]!\n\tmov\tx29, sp\n"))
+static bool ny_a64_emit_body(ny_a64_nir_ctx_t *c, const char *name,
+                             bool tag_return) {
+  ny_native_writer_t *w = c->w;
+  const ny_native_target_info_t *target = c->target;
+  if (!ny_a64_addsub_imm(c, "sub", "sp", "sp", c->frame_bytes) ||
+      !ny_native_put(w, "\tstp\tx29, x30, [sp]\n\tmov\tx29, sp\n"))
     return false;
-  if (ctx.frame_bytes > 0 &&
-      !ny_native_printf(w, "\tsub\tsp, sp, #%d\n", ctx.frame_bytes))
+  for (int r = 19; r <= 28; ++r)
+    if (c->save_slot[r] >= 0 &&
+        !ny_a64_mem(c, "str", ny_a64_x[r], "x29", ny_a64_save_off(c, r), 8))
+      return false;
+  if (strcmp(name, "rt_main") != 0 && !ny_a64_emit_params(c))
     return false;
 
-  if (strcmp(name, "rt_main") != 0) {
-    int max = ctx.max_local_slot < (int)target->gp_arg_reg_count
-                  ? ctx.max_local_slot
-                  : (int)target->gp_arg_reg_count;
-    for (int i = 0; i < max; ++i) {
-      if (!ny_a64_store_local(&ctx, i, target->gp_arg_regs[i]))
-        return false;
+  c->cur_label = -1;
+  for (size_t i = 0; i < c->nir->len && !c->has_phi; ++i)
+    c->has_phi = c->nir->data[i].op == NYIR_PHI;
+  for (size_t i = 0; i < c->nir->len; ++i) {
+    const ny_nir_inst_t *in = &c->nir->data[i];
+    ny_nir_op_t prev = i > 0 ? c->nir->data[i - 1].op : NY_NIR_NOP;
+    bool ok = true;
+    if (in->op == NY_NIR_LABEL) {
+      /* Falling into a label is an edge too. */
+      if (prev != NY_NIR_BR && prev != NY_NIR_RET)
+        ok = ny_a64_phi_edge(c, in->imm);
+      c->cur_label = in->imm;
+    } else if (prev == NY_NIR_BR || prev == NY_NIR_BR_IF ||
+               prev == NY_NIR_RET) {
+      c->cur_label = -1;
     }
-  }
-
-  for (size_t i = 0; i < nir->len; ++i) {
-    if (!ny_a64_emit_inst(&ctx, &nir->data[i])) {
+    if (!ok || !ny_a64_emit_inst(c, in)) {
       fprintf(stderr, "native NYIR repro (AArch64 emit failed):\n");
-      ny_nir_dump(stderr, nir, name);
+      ny_nir_dump(stderr, c->nir, name);
       return false;
     }
   }
 
-  if (!ny_native_printf(w, "%s:\n", ctx.epilogue_label))
+  if (!ny_native_printf(w, "%s:\n", c->epilogue_label))
     return false;
   if (tag_return && !ny_native_put(w, "\tlsl\tx0, x0, #1\n\tadd\tx0, x0, #1\n"))
     return false;
-  if (ctx.frame_bytes > 0 &&
-      !ny_native_printf(w, "\tadd\tsp, sp, #%d\n", ctx.frame_bytes))
-    return false;
-  if (!ny_native_put(w, "\tldp\tx29, x30, [sp], #16\n\tret\n"))
+  for (int r = 19; r <= 28; ++r)
+    if (c->save_slot[r] >= 0 &&
+        !ny_a64_mem(c, "ldr", ny_a64_x[r], "x29", ny_a64_save_off(c, r), 8))
+      return false;
+  if (!ny_native_put(w, "\tmov\tsp, x29\n\tldp\tx29, x30, [sp]\n") ||
+      !ny_a64_addsub_imm(c, "add", "sp", "sp", c->frame_bytes) ||
+      !ny_native_put(w, "\tret\n"))
     return false;
   if (strcmp(target->object_format, "macho") != 0 &&
       !ny_native_printf(w, "\t.size\t%s%s, .-%s%s\n", target->symbol_prefix,
@@ -320,3 +988,34 @@ bool ny_native_aarch64_emit_nir(ny_native_writer_t *w,
     return false;
   return true;
 }
+
+bool ny_native_aarch64_emit_nir(ny_native_writer_t *w,
+                                const ny_native_target_info_t *target,
+                                const ny_nir_func_t *nir,
+                                const char *func_name, bool tag_return,
+                                char *err, size_t err_len) {
+  if (!w || !target || !nir)
+    return false;
+  const char *name = func_name && func_name[0] ? func_name : "rt_main";
+  ny_a64_nir_ctx_t ctx = {
+      .w = w, .target = target, .nir = nir, .name = name, .err = err,
+      .err_len = err_len};
+  snprintf(ctx.epilogue_label, sizeof(ctx.epilogue_label),
+           ".Lny_aarch64_epilogue_%s", name);
+  if (!ny_a64_compute_frame(&ctx)) {
+    ny_a64_ctx_free(&ctx);
+    return false;
+  }
+
+  bool ok = ny_native_put(w, "\t.text\n\t.p2align 2\n");
+  if (ok && strcmp(target->object_format, "macho") != 0)
+    ok = ny_native_printf(w, "\t.type\t%s%s, %%function\n",
+                          target->symbol_prefix, name);
+  if (ok)
+    ok = ny_native_printf(w, "\t.globl\t%s%s\n%s%s:\n", target->symbol_prefix,
+                          name, target->symbol_prefix, name);
+  if (ok)
+    ok = ny_a64_emit_body(&ctx, name, tag_return);
+  ny_a64_ctx_free(&ctx);
+  return ok;
+}
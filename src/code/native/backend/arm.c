@@ -244,6 +244,7 @@ static bool ny_arm_emit_inst(ny_arm_nir_ctx_t *c, const ny_nir_inst_t *in) {
   case NYIR_ALLOCA:
   case NYIR_COPY_STRUCT:
   case NYIR_CAPTURE_RET:
+  case NYIR_PHI:
   case NYIR_OP_COUNT:
     break;
   }
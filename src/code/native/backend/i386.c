@@ -254,6 +254,7 @@ static bool ny_i386_emit_inst(ny_i386_nir_ctx_t *c, const ny_nir_inst_t *in) {
   case NYIR_ALLOCA:
   case NYIR_COPY_STRUCT:
   case NYIR_CAPTURE_RET:
+  case NYIR_PHI:
   case NYIR_OP_COUNT:
     break;
   }
@@ -789,6 +789,11 @@ typedef struct {
   /* valmap[i] = index of the NIR instruction that defines value i,
    * or -1 if not defined.  Used for immediate-operand detection. */
   int def_index[NY_X64_NIR_MAX_SLOTS];
+  /* Label of the block being emitted (-1 if none); phi edge copies are
+   * keyed by it. phi_edges numbers the skip labels around them. */
+  int64_t cur_label;
+  int phi_edges;
+  bool has_phi;
   char epilogue_label[128];
   char *err;
   size_t err_len;
@@ -1022,6 +1027,35 @@ static void ny_x64_nir_classify_values(ny_x64_nir_ctx_t *c) {
   }
 }
 
+/* Phi edge copies move between value slots through %rax; %rcx parks one
+ * value when the copies form a cycle. */
+#define NY_X64_NIR_PHI_SCRATCH (-2)
+
+static int ny_x64_nir_phi_location(void *ctx, int value) {
+  return ny_x64_nir_slot((ny_x64_nir_ctx_t *)ctx, value);
+}
+
+static bool ny_x64_nir_phi_move(void *ctx, int dst, int src) {
+  ny_x64_nir_ctx_t *c = (ny_x64_nir_ctx_t *)ctx;
+  if (src == NY_X64_NIR_PHI_SCRATCH) {
+    if (!ny_native_put(c->w, "\tmovq\t%rcx, %rax\n"))
+      return false;
+  } else if (!ny_x64_nir_load(c, src)) {
+    return false;
+  }
+  if (dst == NY_X64_NIR_PHI_SCRATCH)
+    return ny_native_put(c->w, "\tmovq\t%rax, %rcx\n");
+  return ny_x64_nir_store(c, dst);
+}
+
+static bool ny_x64_nir_phi_edge(ny_x64_nir_ctx_t *c, int64_t label) {
+  if (!c->has_phi)
+    return true;
+  return ny_nir_phi_moves(c->nir, label, c->cur_label,
+                          ny_x64_nir_phi_location, NY_X64_NIR_PHI_SCRATCH,
+                          ny_x64_nir_phi_move, c);
+}
+
 static const char *ny_x64_nir_setcc(ny_nir_cmp_t cmp) {
   switch (cmp) {
   case NY_NIR_CMP_EQ:
@@ -1401,12 +1435,26 @@ static bool ny_x64_nir_emit_inst(ny_x64_nir_ctx_t *c,
   }
   case NY_NIR_LABEL:
     return ny_native_printf(c->w, ".Lny_nir_L%" PRId64 ":\n", in->imm);
+  case NYIR_PHI:
+    return true; /* copied in on each incoming edge */
   case NY_NIR_BR:
-    return ny_native_printf(c->w, "\tjmp\t.Lny_nir_L%" PRId64 "\n", in->imm);
-  case NY_NIR_BR_IF:
-    return ny_x64_nir_load(c, ny_x64_nir_slot(c, in->a)) &&
-           ny_native_put(c->w, "\ttestq\t%rax, %rax\n") &&
-           ny_native_printf(c->w, "\tjne\t.Lny_nir_L%" PRId64 "\n", in->imm);
+    return ny_x64_nir_phi_edge(c, in->imm) &&
+           ny_native_printf(c->w, "\tjmp\t.Lny_nir_L%" PRId64 "\n", in->imm);
+  case NY_NIR_BR_IF: {
+    if (!ny_x64_nir_load(c, ny_x64_nir_slot(c, in->a)) ||
+        !ny_native_put(c->w, "\ttestq\t%rax, %rax\n"))
+      return false;
+    if (!c->has_phi || !ny_nir_phi_has_edge(c->nir, in->imm, c->cur_label))
+      return ny_native_printf(c->w, "\tjne\t.Lny_nir_L%" PRId64 "\n",
+                              in->imm);
+    /* The copies belong to the taken edge only. */
+    int skip = c->phi_edges++;
+    return ny_native_printf(c->w, "\tje\t%s_phi%d\n", c->epilogue_label,
+                            skip) &&
+           ny_x64_nir_phi_edge(c, in->imm) &&
+           ny_native_printf(c->w, "\tjmp\t.Lny_nir_L%" PRId64 "\n%s_phi%d:\n",
+                            in->imm, c->epilogue_label, skip);
+  }
   case NY_NIR_RET: {
     /* Load return value into %rax (skip if -1 = void return). */
       if (in->a >= 0) {
@@ -1723,8 +1771,24 @@ bool ny_native_x86_64_emit_nir(ny_native_writer_t *w,
   }
 
   /* Emit each NYIR instruction. */
+  ctx.cur_label = -1;
+  for (size_t i = 0; i < nir->len && !ctx.has_phi; ++i)
+    ctx.has_phi = nir->data[i].op == NYIR_PHI;
   for (size_t i = 0; i < nir->len; ++i) {
-    if (!ny_x64_nir_emit_inst(&ctx, &nir->data[i])) {
+    const ny_nir_inst_t *in = &nir->data[i];
+    ny_nir_op_t prev = i > 0 ? nir->data[i - 1].op : NY_NIR_NOP;
+    bool block_end = prev == NY_NIR_BR || prev == NY_NIR_BR_IF ||
+                     prev == NY_NIR_RET;
+    bool ok = true;
+    if (in->op == NY_NIR_LABEL) {
+      /* Falling into a label is an edge too. */
+      if (prev != NY_NIR_BR && prev != NY_NIR_RET)
+        ok = ny_x64_nir_phi_edge(&ctx, in->imm);
+      ctx.cur_label = in->imm;
+    } else if (block_end) {
+      ctx.cur_label = -1;
+    }
+    if (!ok || !ny_x64_nir_emit_inst(&ctx, in)) {
       fprintf(stderr, "native NYIR repro (x86-64 emit failed):\n");
       ny_nir_dump(stderr, nir, name);
       return false;
@@ -64,6 +64,47 @@ bool ny_native_aarch64_emit_nir(ny_native_writer_t *w,
                                 bool tag_return,
                                 char *err, size_t err_len);
 
+/* AAPCS64 planning shared by the AArch64 assembly emitter and the in-process
+ * object writer. Scalars take x0-x7 / v0-v7 and then 8-byte stack slots;
+ * integer-classed aggregates of at most 16 bytes take consecutive x
+ * registers (or the stack once they no longer fit), larger ones are copied
+ * by the caller and passed by reference, and an sret pointer goes in x8. */
+typedef enum {
+  NY_A64_ARG_GP = 0,
+  NY_A64_ARG_FP,
+  NY_A64_ARG_AGG,
+  NY_A64_ARG_AGG_REF,
+} ny_a64_arg_kind_t;
+
+typedef struct {
+  ny_a64_arg_kind_t kind;
+  int value;
+  bool f32;
+  int reg;       /* first x/v register, or -1 when stack-passed */
+  int stack_off; /* offset in the outgoing area, or -1 */
+  int copy_off;  /* NY_A64_ARG_AGG_REF: offset of the callee-owned copy */
+  int words;     /* NY_A64_ARG_AGG: 8-byte words */
+  uint32_t size;
+} ny_a64_arg_t;
+
+typedef struct {
+  ny_a64_arg_t args[NY_NIR_CALL_MAX_ARGS];
+  int argc;
+  int sret_value;  /* value passed in x8, or -1 */
+  int stack_bytes; /* outgoing argument area at sp, 16-byte aligned */
+  int copy_bytes;  /* by-reference copies above it, 16-byte aligned */
+} ny_a64_call_plan_t;
+
+#define NY_A64_REG_NONE ((int8_t)-1)
+
+bool ny_a64_plan_call(const ny_nir_inst_t *in, int value_count,
+                      const ny_nir_type_map_t *types,
+                      ny_a64_call_plan_t *plan, char *err, size_t err_len);
+int ny_a64_param_count(const ny_nir_func_t *nir, int local_count);
+bool ny_a64_allocate_registers(const ny_nir_func_t *nir,
+                               const ny_nir_type_map_t *types,
+                               int8_t *value_reg);
+
 bool ny_native_riscv_emit_nir(ny_native_writer_t *w,
                               const ny_native_target_info_t *target,
                               const ny_nir_func_t *nir,
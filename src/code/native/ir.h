@@ -51,6 +51,7 @@ typedef enum {
   NYIR_ALLOCA,       /* allocate stack space for byval/sret */
   NYIR_COPY_STRUCT,  /* copy aggregate data */
   NYIR_CAPTURE_RET,  /* capture a secondary ABI return register */
+  NYIR_PHI,          /* block-entry merge: extra_args[i] arrives from phi_labels[i] */
   NYIR_OP_COUNT,
 } ny_nir_op_t;
 
@@ -74,6 +75,8 @@ typedef enum {
 #define NY_NIR_INST_F_EXTERN 1u
 #define NY_NIR_INST_F_RET_F64 2u
 #define NY_NIR_INST_F_RET_F32 4u
+/* NY_NIR_CALL: the first argument is the hidden aggregate-return pointer. */
+#define NY_NIR_INST_F_SRET 8u
 
 /* Packed NY_NIR_CALL aggregate-argument metadata. */
 #define NY_NIR_ARG_AGG_SIZE_MASK 0x00ffffffu
@@ -175,6 +178,9 @@ typedef struct {
    * containing packed by-value aggregate size and SysV eightbyte classes.
    * Zero marks a scalar argument. Owned by the instruction. */
   uint32_t *arg_sizes;
+  /* For NYIR_PHI: the label of the predecessor block each extra_args entry
+   * flows in from, extra_args_len entries. Owned by the instruction. */
+  int64_t *phi_labels;
 } ny_nir_inst_t;
 
 /* Decode and validate the positional value IDs carried by a call instruction.
@@ -206,6 +212,25 @@ bool ny_nir_type_map_init(ny_nir_type_map_t *map, const ny_nir_func_t *nir,
                           size_t local_count);
 void ny_nir_type_map_free(ny_nir_type_map_t *map);
 
+/* Edge copies a backend emits for the phis of label when leaving the block
+ * labelled from (-1 for an unlabelled block). Locations are backend-defined
+ * keys; move(ctx, dst, src) copies one location to another, and scratch names
+ * a location outside the set used to break cycles. */
+typedef bool (*ny_nir_move_fn)(void *ctx, int dst, int src);
+bool ny_nir_phi_has_edge(const ny_nir_func_t *f, int64_t label, int64_t from);
+bool ny_nir_phi_moves(const ny_nir_func_t *f, int64_t label, int64_t from,
+                      int (*location)(void *ctx, int value), int scratch,
+                      ny_nir_move_fn move, void *ctx);
+/* Widens linear live intervals (instruction indices, count values) for a
+ * register allocator: each phi result starts at, and each phi operand stays
+ * live past, the predecessor ends where the edge copies run. */
+bool ny_nir_phi_extend_intervals(const ny_nir_func_t *f, int *start,
+                                 int *last_use, int count);
+
+/* Optimizer pipeline slots in ny_nir_opt_stats_t.pass_time_ms; the last one
+ * holds the total. */
+#define NY_NIR_OPT_PASS_COUNT 15
+
 typedef struct {
   size_t before_insts;
   size_t after_insts;
@@ -213,7 +238,7 @@ typedef struct {
   int after_values;
   size_t before_ops[NYIR_OP_COUNT];
   size_t after_ops[NYIR_OP_COUNT];
-  double pass_time_ms[9];  /* timing for each of the 9 optimizer passes */
+  double pass_time_ms[NY_NIR_OPT_PASS_COUNT];
 } ny_nir_opt_stats_t;
 
 void ny_nir_func_free(ny_nir_func_t *f);
@@ -255,10 +280,48 @@ bool ny_nir_peephole(ny_nir_func_t *f);
 bool ny_nir_dce(ny_nir_func_t *f);
 bool ny_nir_cfg_simplify(ny_nir_func_t *f);
 bool ny_nir_compact(ny_nir_func_t *f);
+/* SSA and loop passes; they share the dominator tree and loop forest built
+ * by ir/cfg.c. */
+bool ny_nir_mem2reg(ny_nir_func_t *f);
+bool ny_nir_gvn(ny_nir_func_t *f);
+bool ny_nir_licm(ny_nir_func_t *f);
+bool ny_nir_strength_reduce(ny_nir_func_t *f);
+/* Demotes every NYIR_PHI to a fresh local slot stored at the end of each
+ * predecessor, for backends without NY_NATIVE_CAP_NIR_PHI. */
+bool ny_nir_lower_phis(ny_nir_func_t *f);
 bool ny_nir_optimize_with_stats(ny_nir_func_t *f, ny_nir_opt_stats_t *stats);
 bool ny_nir_optimize(ny_nir_func_t *f);
 bool ny_nir_optimize_debug(ny_nir_func_t *f, FILE *dump, ny_nir_opt_stats_t *stats);
 const char *ny_nir_opt_pass_name(int pass);
+
+/* Module-level pipeline over the functions of one program. Direct calls
+ * resolve by name (plain or ny_fn_-prefixed); functions with a NULL name,
+ * such as rt_main, are never call targets. */
+typedef struct {
+  ny_nir_func_t **funcs;
+  const char **names;
+  size_t count;
+} ny_nir_module_t;
+
+typedef struct {
+  size_t functions;
+  size_t call_sites;        /* direct calls to module functions */
+  size_t recursive;         /* functions on a call cycle */
+  size_t ipcp_params;       /* parameters replaced by a constant */
+  size_t inline_candidates;
+  size_t inlined;
+  size_t inline_rejected;   /* over the cost budget */
+  size_t inline_failed;     /* rolled back after optimize/verify */
+  size_t before_insts;
+  size_t after_insts;
+  double time_ms;
+} ny_nir_module_stats_t;
+
+/* Runs interprocedural constant propagation, then inlines bottom-up over the
+ * call graph and re-optimizes every changed function. A function whose
+ * rewrite fails to verify keeps its previous body. */
+bool ny_nir_optimize_module(ny_nir_module_t *m, ny_nir_module_stats_t *stats);
+void ny_nir_dump_module_stats(FILE *out, const ny_nir_module_stats_t *stats);
 const char *ny_nir_op_name(ny_nir_op_t op);
 
 #endif
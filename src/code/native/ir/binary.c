@@ -141,7 +141,7 @@ bool ny_nir_dump_binary(FILE *out, const ny_nir_func_t *f, const char *name) {
     return false;
   if (fwrite("NYIR", 1, 4, out) != 4)
     return false;
-  if (!ny_nir_write_u16le(out, 7) ||              /* format version */
+  if (!ny_nir_write_u16le(out, 8) ||              /* format version */
       !ny_nir_write_u16le(out, 0) ||              /* flags */
       !ny_nir_write_str(out, name && name[0] ? name : "<anon>") ||
       !ny_nir_write_i32le(out, f->next_value) ||
@@ -153,6 +153,8 @@ bool ny_nir_dump_binary(FILE *out, const ny_nir_func_t *f, const char *name) {
         (in->op != NY_NIR_CALL || in->imm <= 0 ||
          in->imm > NY_NIR_CALL_MAX_ARGS))
       return false;
+    if ((in->phi_labels != NULL) != (in->op == NYIR_PHI && in->extra_args_len))
+      return false;
     if (!ny_nir_write_u16le(out, (uint16_t)in->op) ||
         !ny_nir_write_u16le(out, (uint16_t)in->cmp) ||
         !ny_nir_write_i32le(out, in->dst) ||
@@ -186,6 +188,13 @@ bool ny_nir_dump_binary(FILE *out, const ny_nir_func_t *f, const char *name) {
       if (!ny_nir_write_u32le(out, in->arg_sizes[k]))
         return false;
     }
+    uint32_t phi_len = in->phi_labels ? (uint32_t)in->extra_args_len : 0;
+    if (!ny_nir_write_u32le(out, phi_len))
+      return false;
+    for (uint32_t k = 0; k < phi_len; ++k) {
+      if (!ny_nir_write_i64le(out, in->phi_labels[k]))
+        return false;
+    }
   }
   return true;
 }
@@ -208,7 +217,7 @@ bool ny_nir_load_binary(FILE *in, ny_nir_func_t *out, char *name,
   if (!ny_nir_read_u16le(in, &version) || !ny_nir_read_u16le(in, &flags))
     goto malformed;
   if (version != 1 && version != 2 && version != 3 && version != 4 &&
-      version != 5 && version != 6 && version != 7)
+      version != 5 && version != 6 && version != 7 && version != 8)
     return ny_nir_binary_err(err, err_len, "native NYIR load: unsupported version %u",
                    (unsigned)version);
   if (flags != 0)
@@ -285,9 +294,11 @@ bool ny_nir_load_binary(FILE *in, ny_nir_func_t *out, char *name,
     uint32_t extra_len = 0;
     int *extra = NULL;
     uint32_t *arg_sizes = NULL;
+    int64_t *phi_labels = NULL;
     if (version >= 5) {
+      /* A phi has one entry per predecessor rather than per argument. */
       if (!ny_nir_read_u32le(in, &extra_len) ||
-          extra_len > NY_NIR_CALL_MAX_ARGS) {
+          extra_len > (op == NYIR_PHI ? inst_count : NY_NIR_CALL_MAX_ARGS)) {
         free(symbol);
         goto malformed;
       }
@@ -344,13 +355,46 @@ bool ny_nir_load_binary(FILE *in, ny_nir_func_t *out, char *name,
         }
       }
     }
-    if (op >= NYIR_OP_COUNT || cmp > NY_NIR_CMP_GE) {
+    if (version >= 8) {
+      uint32_t phi_len = 0;
+      if (!ny_nir_read_u32le(in, &phi_len) ||
+          (phi_len != 0 && (op != NYIR_PHI || phi_len != extra_len))) {
+        free(arg_sizes);
+        free(extra);
+        free(symbol);
+        goto malformed;
+      }
+      if (phi_len > 0) {
+        phi_labels = (int64_t *)malloc((size_t)phi_len * sizeof(*phi_labels));
+        if (!phi_labels) {
+          free(arg_sizes);
+          free(extra);
+          free(symbol);
+          free(loaded_name);
+          ny_nir_func_free(&loaded);
+          return ny_nir_binary_err(err, err_len, "native NYIR load: out of memory");
+        }
+        for (uint32_t k = 0; k < phi_len; ++k) {
+          if (!ny_nir_read_i64le(in, &phi_labels[k])) {
+            free(phi_labels);
+            free(arg_sizes);
+            free(extra);
+            free(symbol);
+            goto malformed;
+          }
+        }
+      }
+    }
+    if (op >= NYIR_OP_COUNT || cmp > NY_NIR_CMP_GE ||
+        (op == NYIR_PHI && extra_len && !phi_labels)) {
+      free(phi_labels);
       free(arg_sizes);
       free(extra);
       free(symbol);
       goto malformed;
     }
     inst.arg_sizes = arg_sizes;
+    inst.phi_labels = phi_labels;
     inst.extra_args = extra;
     inst.extra_args_len = extra_len;
     inst.op = (ny_nir_op_t)op;
@@ -367,6 +411,7 @@ bool ny_nir_load_binary(FILE *in, ny_nir_func_t *out, char *name,
     if (debug_file && debug_file[0]) {
       inst.debug.file = ny_nir_func_own_symbol(&loaded, debug_file);
       if (!inst.debug.file) {
+        free(inst.phi_labels);
         free(inst.arg_sizes);
         free(inst.extra_args);
         free(symbol);
@@ -380,6 +425,7 @@ bool ny_nir_load_binary(FILE *in, ny_nir_func_t *out, char *name,
     if (symbol[0]) {
       inst.symbol = ny_nir_func_own_symbol(&loaded, symbol);
       if (!inst.symbol) {
+        free(inst.phi_labels);
         free(inst.arg_sizes);
         free(inst.extra_args);
         free(loaded_name);
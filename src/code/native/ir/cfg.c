@@ -0,0 +1,668 @@
+#include "code/native/ir/internal.h"
+#include "code/native/ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  int64_t label;
+  int block;
+} nir_cfg_label_t;
+
+static int nir_cfg_label_cmp(const void *lhs, const void *rhs) {
+  const nir_cfg_label_t *a = (const nir_cfg_label_t *)lhs;
+  const nir_cfg_label_t *b = (const nir_cfg_label_t *)rhs;
+  if (a->label != b->label)
+    return a->label < b->label ? -1 : 1;
+  return a->block - b->block;
+}
+
+static int nir_cfg_label_block(const nir_cfg_label_t *labels, size_t count,
+                               int64_t label) {
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (labels[mid].label < label)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < count && labels[lo].label == label ? labels[lo].block : -1;
+}
+
+static bool nir_cfg_is_terminator(ny_nir_op_t op) {
+  return op == NY_NIR_BR || op == NY_NIR_BR_IF || op == NY_NIR_RET;
+}
+
+void ny_nir_cfg_free(ny_nir_cfg_t *cfg) {
+  if (!cfg)
+    return;
+  free(cfg->blocks);
+  free(cfg->preds);
+  free(cfg->block_of);
+  free(cfg->rpo);
+  free(cfg->def_index);
+  memset(cfg, 0, sizeof(*cfg));
+}
+
+static int nir_cfg_intersect(const ny_nir_cfg_t *cfg, int a, int b) {
+  while (a != b) {
+    while (cfg->blocks[a].rpo > cfg->blocks[b].rpo)
+      a = cfg->blocks[a].idom;
+    while (cfg->blocks[b].rpo > cfg->blocks[a].rpo)
+      b = cfg->blocks[b].idom;
+  }
+  return a;
+}
+
+static bool nir_cfg_order(ny_nir_cfg_t *cfg) {
+  int n = cfg->block_count;
+  int *stack = (int *)malloc((size_t)n * sizeof(*stack));
+  int *next_succ = (int *)calloc((size_t)n, sizeof(*next_succ));
+  bool *seen = (bool *)calloc((size_t)n, sizeof(*seen));
+  int *post = (int *)malloc((size_t)n * sizeof(*post));
+  cfg->rpo = (int *)malloc((size_t)n * sizeof(*cfg->rpo));
+  if (!stack || !next_succ || !seen || !post || !cfg->rpo) {
+    free(stack);
+    free(next_succ);
+    free(seen);
+    free(post);
+    return false;
+  }
+  int depth = 0;
+  int post_count = 0;
+  stack[depth++] = 0;
+  seen[0] = true;
+  while (depth > 0) {
+    int b = stack[depth - 1];
+    ny_nir_block_t *blk = &cfg->blocks[b];
+    if (next_succ[b] < blk->succ_count) {
+      int s = blk->succ[next_succ[b]++];
+      if (!seen[s]) {
+        seen[s] = true;
+        stack[depth++] = s;
+      }
+      continue;
+    }
+    post[post_count++] = b;
+    depth--;
+  }
+  cfg->rpo_count = post_count;
+  for (int i = 0; i < post_count; ++i) {
+    int b = post[post_count - 1 - i];
+    cfg->rpo[i] = b;
+    cfg->blocks[b].rpo = i;
+  }
+  free(stack);
+  free(next_succ);
+  free(seen);
+  free(post);
+  return true;
+}
+
+static bool nir_cfg_dominators(ny_nir_cfg_t *cfg) {
+  /* Cooper, Harvey and Kennedy's iterative scheme over reverse postorder. */
+  cfg->blocks[cfg->rpo[0]].idom = cfg->rpo[0];
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 1; i < cfg->rpo_count; ++i) {
+      ny_nir_block_t *blk = &cfg->blocks[cfg->rpo[i]];
+      int idom = -1;
+      for (int p = 0; p < blk->pred_count; ++p) {
+        int pred = blk->preds[p];
+        if (cfg->blocks[pred].rpo < 0 || cfg->blocks[pred].idom < 0)
+          continue;
+        idom = idom < 0 ? pred : nir_cfg_intersect(cfg, pred, idom);
+      }
+      if (idom != blk->idom) {
+        blk->idom = idom;
+        changed = true;
+      }
+    }
+  }
+
+  /* Number the dominator tree so dominance queries are two comparisons. */
+  int n = cfg->block_count;
+  int *child_head = (int *)malloc((size_t)n * sizeof(*child_head));
+  int *child_next = (int *)malloc((size_t)n * sizeof(*child_next));
+  int *stack = (int *)malloc((size_t)n * sizeof(*stack));
+  int *cursor = (int *)malloc((size_t)n * sizeof(*cursor));
+  if (!child_head || !child_next || !stack || !cursor) {
+    free(child_head);
+    free(child_next);
+    free(stack);
+    free(cursor);
+    return false;
+  }
+  for (int b = 0; b < n; ++b) {
+    child_head[b] = -1;
+    child_next[b] = -1;
+  }
+  for (int i = cfg->rpo_count - 1; i > 0; --i) {
+    int b = cfg->rpo[i];
+    int parent = cfg->blocks[b].idom;
+    child_next[b] = child_head[parent];
+    child_head[parent] = b;
+  }
+  int clock = 0;
+  int depth = 0;
+  stack[depth++] = cfg->rpo[0];
+  cursor[cfg->rpo[0]] = child_head[cfg->rpo[0]];
+  cfg->blocks[cfg->rpo[0]].dom_pre = clock++;
+  while (depth > 0) {
+    int b = stack[depth - 1];
+    int child = cursor[b];
+    if (child >= 0) {
+      cursor[b] = child_next[child];
+      cursor[child] = child_head[child];
+      cfg->blocks[child].dom_pre = clock++;
+      stack[depth++] = child;
+      continue;
+    }
+    cfg->blocks[b].dom_post = clock++;
+    depth--;
+  }
+  free(child_head);
+  free(child_next);
+  free(stack);
+  free(cursor);
+  return true;
+}
+
+bool ny_nir_cfg_build(ny_nir_cfg_t *cfg, const ny_nir_func_t *f) {
+  if (!cfg || !f)
+    return false;
+  memset(cfg, 0, sizeof(*cfg));
+  if (f->next_value > 0) {
+    cfg->value_count = (size_t)f->next_value;
+    cfg->def_index = (int *)malloc(cfg->value_count * sizeof(int));
+    if (!cfg->def_index)
+      return false;
+    for (size_t v = 0; v < cfg->value_count; ++v)
+      cfg->def_index[v] = -1;
+  }
+  if (f->len == 0)
+    return true;
+
+  cfg->block_of = (int *)malloc(f->len * sizeof(int));
+  if (!cfg->block_of) {
+    ny_nir_cfg_free(cfg);
+    return false;
+  }
+  int blocks = 0;
+  size_t label_count = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    bool leader = i == 0 || in->op == NY_NIR_LABEL ||
+                  nir_cfg_is_terminator(f->data[i - 1].op);
+    if (leader)
+      blocks++;
+    cfg->block_of[i] = blocks - 1;
+    if (in->op == NY_NIR_LABEL)
+      label_count++;
+    if (in->dst >= 0 && (size_t)in->dst < cfg->value_count &&
+        cfg->def_index[in->dst] < 0)
+      cfg->def_index[in->dst] = (int)i;
+  }
+
+  cfg->block_count = blocks;
+  cfg->blocks = (ny_nir_block_t *)calloc((size_t)blocks, sizeof(*cfg->blocks));
+  nir_cfg_label_t *labels =
+      label_count ? (nir_cfg_label_t *)malloc(label_count * sizeof(*labels))
+                  : NULL;
+  if (!cfg->blocks || (label_count && !labels)) {
+    free(labels);
+    ny_nir_cfg_free(cfg);
+    return false;
+  }
+  size_t li = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    int b = cfg->block_of[i];
+    if (i == 0 || cfg->block_of[i - 1] != b)
+      cfg->blocks[b].start = i;
+    cfg->blocks[b].end = i + 1;
+    if (f->data[i].op == NY_NIR_LABEL)
+      labels[li++] = (nir_cfg_label_t){.label = f->data[i].imm, .block = b};
+  }
+  if (label_count)
+    qsort(labels, label_count, sizeof(*labels), nir_cfg_label_cmp);
+
+  int edge_count = 0;
+  for (int b = 0; b < blocks; ++b) {
+    ny_nir_block_t *blk = &cfg->blocks[b];
+    const ny_nir_inst_t *last = &f->data[blk->end - 1];
+    blk->idom = -1;
+    blk->rpo = -1;
+    blk->dom_pre = -1;
+    blk->dom_post = -1;
+    if (last->op == NY_NIR_BR || last->op == NY_NIR_BR_IF) {
+      int target = nir_cfg_label_block(labels, label_count, last->imm);
+      if (target >= 0)
+        blk->succ[blk->succ_count++] = target;
+    }
+    if (last->op != NY_NIR_BR && last->op != NY_NIR_RET && b + 1 < blocks &&
+        (blk->succ_count == 0 || blk->succ[0] != b + 1))
+      blk->succ[blk->succ_count++] = b + 1;
+    edge_count += blk->succ_count;
+  }
+  free(labels);
+
+  cfg->preds = edge_count ? (int *)malloc((size_t)edge_count * sizeof(int))
+                          : NULL;
+  if (edge_count && !cfg->preds) {
+    ny_nir_cfg_free(cfg);
+    return false;
+  }
+  for (int b = 0; b < blocks; ++b) {
+    for (int s = 0; s < cfg->blocks[b].succ_count; ++s)
+      cfg->blocks[cfg->blocks[b].succ[s]].pred_count++;
+  }
+  int offset = 0;
+  for (int b = 0; b < blocks; ++b) {
+    cfg->blocks[b].preds = cfg->preds + offset;
+    offset += cfg->blocks[b].pred_count;
+    cfg->blocks[b].pred_count = 0;
+  }
+  for (int b = 0; b < blocks; ++b) {
+    for (int s = 0; s < cfg->blocks[b].succ_count; ++s) {
+      ny_nir_block_t *succ = &cfg->blocks[cfg->blocks[b].succ[s]];
+      succ->preds[succ->pred_count++] = b;
+    }
+  }
+
+  if (!nir_cfg_order(cfg) || !nir_cfg_dominators(cfg)) {
+    ny_nir_cfg_free(cfg);
+    return false;
+  }
+  return true;
+}
+
+bool ny_nir_cfg_reachable(const ny_nir_cfg_t *cfg, int block) {
+  return cfg && block >= 0 && block < cfg->block_count &&
+         cfg->blocks[block].rpo >= 0;
+}
+
+bool ny_nir_cfg_dominates(const ny_nir_cfg_t *cfg, int a, int b) {
+  if (!ny_nir_cfg_reachable(cfg, a) || !ny_nir_cfg_reachable(cfg, b))
+    return false;
+  const ny_nir_block_t *da = &cfg->blocks[a];
+  const ny_nir_block_t *db = &cfg->blocks[b];
+  return da->dom_pre <= db->dom_pre && db->dom_post <= da->dom_post;
+}
+
+bool ny_nir_cfg_value_dominates(const ny_nir_cfg_t *cfg, int value,
+                                size_t use) {
+  if (!cfg || value < 0 || (size_t)value >= cfg->value_count)
+    return false;
+  int def = cfg->def_index[value];
+  if (def < 0)
+    return false;
+  int def_block = cfg->block_of[def];
+  int use_block = cfg->block_of[use];
+  if (def_block == use_block)
+    return (size_t)def < use;
+  return ny_nir_cfg_dominates(cfg, def_block, use_block);
+}
+
+bool ny_nir_cfg_loops(const ny_nir_cfg_t *cfg, ny_nir_loop_t **out,
+                      size_t *out_count) {
+  if (!cfg || !out || !out_count)
+    return false;
+  *out = NULL;
+  *out_count = 0;
+  int n = cfg->block_count;
+  if (n == 0)
+    return true;
+  int *loop_of_header = (int *)malloc((size_t)n * sizeof(int));
+  int *work = (int *)malloc((size_t)n * sizeof(int));
+  if (!loop_of_header || !work) {
+    free(loop_of_header);
+    free(work);
+    return false;
+  }
+  for (int b = 0; b < n; ++b)
+    loop_of_header[b] = -1;
+
+  ny_nir_loop_t *loops = NULL;
+  size_t count = 0;
+  size_t cap = 0;
+  for (int i = 0; i < cfg->rpo_count; ++i) {
+    int latch = cfg->rpo[i];
+    const ny_nir_block_t *blk = &cfg->blocks[latch];
+    for (int s = 0; s < blk->succ_count; ++s) {
+      int header = blk->succ[s];
+      if (!ny_nir_cfg_dominates(cfg, header, latch))
+        continue;
+      if (loop_of_header[header] < 0) {
+        if (count == cap) {
+          size_t next_cap = cap ? cap * 2 : 4;
+          ny_nir_loop_t *grown =
+              (ny_nir_loop_t *)realloc(loops, next_cap * sizeof(*loops));
+          if (!grown)
+            goto fail;
+          loops = grown;
+          cap = next_cap;
+        }
+        bool *member = (bool *)calloc((size_t)n, sizeof(bool));
+        if (!member)
+          goto fail;
+        member[header] = true;
+        loops[count] = (ny_nir_loop_t){.header = header,
+                                       .preheader = -1,
+                                       .member = member,
+                                       .block_count = 1};
+        loop_of_header[header] = (int)count++;
+      }
+      ny_nir_loop_t *loop = &loops[loop_of_header[header]];
+      int depth = 0;
+      if (!loop->member[latch]) {
+        loop->member[latch] = true;
+        loop->block_count++;
+        work[depth++] = latch;
+      }
+      while (depth > 0) {
+        const ny_nir_block_t *cur = &cfg->blocks[work[--depth]];
+        for (int p = 0; p < cur->pred_count; ++p) {
+          int pred = cur->preds[p];
+          if (loop->member[pred] || !ny_nir_cfg_reachable(cfg, pred))
+            continue;
+          loop->member[pred] = true;
+          loop->block_count++;
+          work[depth++] = pred;
+        }
+      }
+    }
+  }
+  for (size_t l = 0; l < count; ++l) {
+    const ny_nir_block_t *hdr = &cfg->blocks[loops[l].header];
+    int outside = -1;
+    int outside_count = 0;
+    for (int p = 0; p < hdr->pred_count; ++p) {
+      int pred = hdr->preds[p];
+      if (loops[l].member[pred] || !ny_nir_cfg_reachable(cfg, pred))
+        continue;
+      outside = pred;
+      outside_count++;
+    }
+    if (outside_count == 1)
+      loops[l].preheader = outside;
+  }
+  free(loop_of_header);
+  free(work);
+  *out = loops;
+  *out_count = count;
+  return true;
+fail:
+  free(loop_of_header);
+  free(work);
+  ny_nir_cfg_loops_free(loops, count);
+  return false;
+}
+
+void ny_nir_cfg_loops_free(ny_nir_loop_t *loops, size_t count) {
+  for (size_t i = 0; loops && i < count; ++i)
+    free(loops[i].member);
+  free(loops);
+}
+
+int64_t ny_nir_cfg_block_label(const ny_nir_cfg_t *cfg,
+                               const ny_nir_func_t *f, int block) {
+  if (!cfg || !f || block < 0 || block >= cfg->block_count)
+    return -1;
+  const ny_nir_inst_t *first = &f->data[cfg->blocks[block].start];
+  return first->op == NY_NIR_LABEL ? first->imm : -1;
+}
+
+static bool nir_phi_has_pred(const ny_nir_cfg_t *cfg, const ny_nir_func_t *f,
+                             const ny_nir_block_t *blk, int64_t label) {
+  for (int p = 0; p < blk->pred_count; ++p) {
+    if (ny_nir_cfg_reachable(cfg, blk->preds[p]) &&
+        ny_nir_cfg_block_label(cfg, f, blk->preds[p]) == label)
+      return true;
+  }
+  return false;
+}
+
+/* A phi whose incoming values are all v (or the phi itself) is a copy of v
+ * once v is defined outside the block and ahead of it in the list; reading
+ * the same block's phis would see their new values, not the edge values. */
+static int nir_phi_single_value(const ny_nir_cfg_t *cfg,
+                                const ny_nir_inst_t *in, size_t index,
+                                int block) {
+  int value = -1;
+  for (size_t k = 0; k < in->extra_args_len; ++k) {
+    int v = in->extra_args[k];
+    if (v == in->dst)
+      continue;
+    if (value >= 0 && v != value)
+      return -1;
+    value = v;
+  }
+  if (value < 0 || (size_t)value >= cfg->value_count)
+    return -1;
+  int def = cfg->def_index[value];
+  if (def < 0 || (size_t)def >= index || cfg->block_of[def] == block)
+    return -1;
+  return value;
+}
+
+bool ny_nir_phi_prune(ny_nir_func_t *f) {
+  if (!f)
+    return false;
+  bool any = false;
+  for (size_t i = 0; i < f->len && !any; ++i)
+    any = f->data[i].op == NYIR_PHI;
+  if (!any)
+    return false;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return false;
+  bool changed = false;
+  for (int b = 0; b < cfg.block_count; ++b) {
+    const ny_nir_block_t *blk = &cfg.blocks[b];
+    if (!ny_nir_cfg_reachable(&cfg, b))
+      continue;
+    size_t head_end = blk->start + 1;
+    bool copied = false;
+    for (; head_end < blk->end; ++head_end) {
+      ny_nir_inst_t *in = &f->data[head_end];
+      if (in->op == NY_NIR_NOP)
+        continue;
+      if (in->op != NYIR_PHI)
+        break;
+      size_t kept = 0;
+      for (size_t k = 0; k < in->extra_args_len; ++k) {
+        if (!nir_phi_has_pred(&cfg, f, blk, in->phi_labels[k]))
+          continue;
+        in->extra_args[kept] = in->extra_args[k];
+        in->phi_labels[kept++] = in->phi_labels[k];
+      }
+      if (kept != in->extra_args_len) {
+        in->extra_args_len = kept;
+        changed = true;
+      }
+      int value = nir_phi_single_value(&cfg, in, head_end, b);
+      if (value < 0)
+        continue;
+      int dst = in->dst;
+      ny_nir_debug_loc_t debug = in->debug;
+      ny_nir_inst_discard(in);
+      in->op = NY_NIR_COPY;
+      in->dst = dst;
+      in->a = value;
+      in->debug = debug;
+      in->effects = ny_nir_inst_effects(in);
+      copied = changed = true;
+    }
+    if (!copied)
+      continue;
+    /* Keep the remaining phis at the head of the block. */
+    size_t out = blk->start + 1;
+    for (size_t i = blk->start + 1; i < head_end; ++i) {
+      if (f->data[i].op != NYIR_PHI)
+        continue;
+      ny_nir_inst_t phi = f->data[i];
+      memmove(&f->data[out + 1], &f->data[out],
+              (i - out) * sizeof(*f->data));
+      f->data[out++] = phi;
+    }
+  }
+  ny_nir_cfg_free(&cfg);
+  return changed;
+}
+
+static bool nir_phi_entry(const ny_nir_inst_t *in, int64_t from,
+                          int *value) {
+  for (size_t k = 0; k < in->extra_args_len; ++k) {
+    if (in->phi_labels[k] == from) {
+      *value = in->extra_args[k];
+      return true;
+    }
+  }
+  return false;
+}
+
+static size_t nir_phi_head(const ny_nir_func_t *f, int64_t label) {
+  for (size_t i = 0; i < f->len; ++i) {
+    if (f->data[i].op == NY_NIR_LABEL && f->data[i].imm == label)
+      return i + 1;
+  }
+  return f->len;
+}
+
+bool ny_nir_phi_has_edge(const ny_nir_func_t *f, int64_t label,
+                         int64_t from) {
+  if (!f || from < 0)
+    return false;
+  for (size_t i = nir_phi_head(f, label); i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NY_NIR_NOP)
+      continue;
+    if (in->op != NYIR_PHI)
+      break;
+    int value;
+    if (nir_phi_entry(in, from, &value))
+      return true;
+  }
+  return false;
+}
+
+bool ny_nir_phi_moves(const ny_nir_func_t *f, int64_t label, int64_t from,
+                      int (*location)(void *ctx, int value), int scratch,
+                      ny_nir_move_fn move, void *ctx) {
+  if (!f || !location || !move)
+    return false;
+  size_t head = nir_phi_head(f, label);
+  size_t n = 0;
+  for (size_t i = head; i < f->len; ++i) {
+    if (f->data[i].op == NY_NIR_NOP)
+      continue;
+    if (f->data[i].op != NYIR_PHI)
+      break;
+    n++;
+  }
+  if (n == 0 || from < 0)
+    return true;
+  int *dst = (int *)malloc(n * sizeof(int));
+  int *src = (int *)malloc(n * sizeof(int));
+  if (!dst || !src) {
+    free(dst);
+    free(src);
+    return false;
+  }
+  size_t pending = 0;
+  for (size_t i = head; i < f->len && pending < n; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op != NYIR_PHI)
+      continue;
+    int value;
+    if (!nir_phi_entry(in, from, &value))
+      continue;
+    dst[pending] = location(ctx, in->dst);
+    src[pending] = location(ctx, value);
+    if (dst[pending] != src[pending])
+      pending++;
+  }
+  /* Sequentialize the parallel copy: emit every move whose destination no
+   * other pending move still reads, and break a cycle by parking one
+   * destination in scratch. */
+  bool ok = true;
+  while (ok && pending > 0) {
+    bool progressed = false;
+    for (size_t m = 0; ok && m < pending;) {
+      bool read = false;
+      for (size_t k = 0; k < pending && !read; ++k)
+        read = k != m && src[k] == dst[m];
+      if (read) {
+        ++m;
+        continue;
+      }
+      ok = move(ctx, dst[m], src[m]);
+      dst[m] = dst[pending - 1];
+      src[m] = src[pending - 1];
+      pending--;
+      progressed = true;
+    }
+    if (!ok || progressed || pending == 0)
+      continue;
+    ok = move(ctx, scratch, dst[0]);
+    for (size_t k = 0; k < pending; ++k) {
+      if (src[k] == dst[0])
+        src[k] = scratch;
+    }
+  }
+  free(dst);
+  free(src);
+  return ok;
+}
+
+bool ny_nir_phi_extend_intervals(const ny_nir_func_t *f, int *start,
+                                 int *last_use, int count) {
+  if (!f || !start || !last_use)
+    return false;
+  bool any = false;
+  for (size_t i = 0; i < f->len && !any; ++i)
+    any = f->data[i].op == NYIR_PHI;
+  if (!any)
+    return true;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return false;
+  nir_cfg_label_t *labels = (nir_cfg_label_t *)malloc(
+      ((size_t)cfg.block_count + 1u) * sizeof(*labels));
+  if (!labels) {
+    ny_nir_cfg_free(&cfg);
+    return false;
+  }
+  size_t label_count = 0;
+  for (int b = 0; b < cfg.block_count; ++b) {
+    int64_t label = ny_nir_cfg_block_label(&cfg, f, b);
+    if (label >= 0)
+      labels[label_count++] = (nir_cfg_label_t){.label = label, .block = b};
+  }
+  qsort(labels, label_count, sizeof(*labels), nir_cfg_label_cmp);
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op != NYIR_PHI || in->dst < 0 || in->dst >= count)
+      continue;
+    for (size_t k = 0; k < in->extra_args_len; ++k) {
+      int pred = nir_cfg_label_block(labels, label_count, in->phi_labels[k]);
+      if (pred < 0)
+        continue;
+      /* The edge copies run after the predecessor's last instruction, so
+       * an operand must outlive whatever that instruction defines. */
+      int end = (int)cfg.blocks[pred].end - 1;
+      if (end < start[in->dst])
+        start[in->dst] = end;
+      if (end > last_use[in->dst])
+        last_use[in->dst] = end;
+      int v = in->extra_args[k];
+      if (v >= 0 && v < count && end + 1 > last_use[v])
+        last_use[v] = end + 1;
+    }
+  }
+  free(labels);
+  ny_nir_cfg_free(&cfg);
+  return true;
+}
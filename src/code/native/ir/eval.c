@@ -76,11 +76,18 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
   }
   size_t *label_pc = label_count ? (size_t *)calloc(label_count, sizeof(size_t)) : NULL;
   bool *label_found = label_count ? (bool *)calloc(label_count, sizeof(bool)) : NULL;
-  if (label_count && (!label_pc || !label_found)) {
+  /* Phis at a block head read their edge values before any of them is
+   * written, so a run of them is staged here. */
+  bool has_phi = false;
+  for (size_t i = 0; i < f->len && !has_phi; ++i)
+    has_phi = f->data[i].op == NYIR_PHI;
+  int64_t *phi_tmp = has_phi ? (int64_t *)calloc(f->len, sizeof(*phi_tmp)) : NULL;
+  if ((label_count && (!label_pc || !label_found)) || (has_phi && !phi_tmp)) {
     free(values);
     free(known);
     free(label_pc);
     free(label_found);
+    free(phi_tmp);
     return ny_nir_err(err, err_len, "native NYIR VM: out of memory");
   }
   for (size_t i = 0; i < f->len; ++i) {
@@ -93,6 +100,8 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
 
   size_t pc = 0;
   size_t steps = 0;
+  int64_t cur_label = -1;  /* label of the executing block, -1 if none */
+  int64_t pred_label = -1; /* label of the block control arrived from */
   const ny_nir_inst_t *in = NULL;
   size_t inst_index = 0;
   const bool profiling = (result != NULL);
@@ -102,6 +111,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
       free(known);
       free(label_pc);
       free(label_found);
+      free(phi_tmp);
       return ny_nir_err(err, err_len, "native NYIR VM: step limit exceeded");
     }
     inst_index = pc;
@@ -115,8 +125,44 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
     int64_t out = 0;
     switch (in->op) {
     case NY_NIR_NOP:
+      break;
     case NY_NIR_LABEL:
+      pred_label = cur_label;
+      cur_label = in->imm;
+      break;
+    case NYIR_PHI: {
+      size_t end = inst_index;
+      size_t n = 0;
+      for (; end < f->len; ++end) {
+        const ny_nir_inst_t *phi = &f->data[end];
+        if (phi->op == NY_NIR_NOP)
+          continue;
+        if (phi->op != NYIR_PHI)
+          break;
+        size_t k = 0;
+        while (k < phi->extra_args_len && phi->phi_labels[k] != pred_label)
+          ++k;
+        if (k == phi->extra_args_len) {
+          in = phi;
+          inst_index = end;
+          goto missing_edge;
+        }
+        if (!ny_nir_eval_read_value(values, known, phi->extra_args[k],
+                                    &phi_tmp[n++]))
+          goto missing_value;
+      }
+      n = 0;
+      for (size_t k = inst_index; k < end; ++k) {
+        const ny_nir_inst_t *phi = &f->data[k];
+        if (phi->op != NYIR_PHI)
+          continue;
+        ny_nir_eval_note_value(result, phi->dst);
+        values[phi->dst] = phi_tmp[n++];
+        known[phi->dst] = true;
+      }
+      pc = end;
       break;
+    }
     case NY_NIR_CONST_I64:
     case NYIR_CONST_F64:
     case NYIR_CONST_F32:
@@ -311,6 +357,8 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
       if (in->imm < 0 || (size_t)in->imm >= label_count || !label_found[in->imm])
         goto missing_label;
       pc = label_pc[in->imm];
+      pred_label = cur_label;
+      cur_label = in->imm;
       break;
     case NY_NIR_BR_IF:
       if (!ny_nir_eval_read_value(values, known, in->a, &a))
@@ -321,9 +369,15 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
         if (in->imm < 0 || (size_t)in->imm >= label_count || !label_found[in->imm])
           goto missing_label;
         pc = label_pc[in->imm];
-      } else if (profiling) {
-        result->branch_not_taken++;
+        pred_label = cur_label;
+        cur_label = in->imm;
+        break;
       }
+      if (profiling)
+        result->branch_not_taken++;
+      /* Falling into a label keeps this block as its predecessor. */
+      if (pc >= f->len || f->data[pc].op != NY_NIR_LABEL)
+        cur_label = -1;
       break;
     case NY_NIR_RET:
       if (result) {
@@ -340,6 +394,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
       free(known);
       free(label_pc);
       free(label_found);
+      free(phi_tmp);
       if (err && err_len > 0)
         err[0] = '\0';
       return true;
@@ -351,6 +406,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
         free(known);
         free(label_pc);
         free(label_found);
+        free(phi_tmp);
         return ny_nir_inst_err(err, err_len, in, inst_index,
                             "NYIR VM does not execute external calls yet");
       }
@@ -359,6 +415,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
         free(known);
         free(label_pc);
         free(label_found);
+        free(phi_tmp);
         return ny_nir_inst_err(err, err_len, in, inst_index,
                             "NYIR VM supports a bounded number of call args");
       }
@@ -388,6 +445,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
         free(known);
         free(label_pc);
         free(label_found);
+        free(phi_tmp);
         return false;
       }
       if (in->dst >= 0) {
@@ -407,6 +465,7 @@ bool ny_nir_eval_with_calls(const ny_nir_func_t *f, int64_t *locals,
   free(known);
   free(label_pc);
   free(label_found);
+  free(phi_tmp);
   if (err && err_len > 0)
     err[0] = '\0';
   return true;
@@ -416,6 +475,7 @@ missing_value:
   free(known);
   free(label_pc);
   free(label_found);
+  free(phi_tmp);
   return ny_nir_inst_err(err, err_len, in, inst_index,
                       "NYIR VM read an unavailable value");
 bad_local:
@@ -423,13 +483,23 @@ bad_local:
   free(known);
   free(label_pc);
   free(label_found);
+  free(phi_tmp);
   return ny_nir_inst_err(err, err_len, in, inst_index,
                       "NYIR VM local slot is out of range");
+missing_edge:
+  free(values);
+  free(known);
+  free(label_pc);
+  free(label_found);
+  free(phi_tmp);
+  return ny_nir_inst_err(err, err_len, in, inst_index,
+                      "NYIR VM phi has no entry for the incoming edge");
 missing_label:
   free(values);
   free(known);
   free(label_pc);
   free(label_found);
+  free(phi_tmp);
   return ny_nir_inst_err(err, err_len, in, inst_index,
                       "NYIR VM branch target is missing");
 unsupported:
@@ -437,6 +507,7 @@ unsupported:
   free(known);
   free(label_pc);
   free(label_found);
+  free(phi_tmp);
   return ny_nir_inst_err(err, err_len, in, inst_index,
                       "NYIR VM operation is unsupported for these operands");
 }
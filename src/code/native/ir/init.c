@@ -128,6 +128,15 @@ bool ny_nir_type_map_init(ny_nir_type_map_t *map, const ny_nir_func_t *nir,
         (size_t)in->a < map->value_count && (size_t)in->imm < local_count)
       ny_nir_type_union(parents, (size_t)in->a,
                         map->value_count + (size_t)in->imm);
+    for (size_t k = 0; in->op == NYIR_PHI && in->dst >= 0 &&
+                       (size_t)in->dst < map->value_count &&
+                       k < in->extra_args_len;
+         ++k) {
+      if (in->extra_args[k] >= 0 &&
+          (size_t)in->extra_args[k] < map->value_count)
+        ny_nir_type_union(parents, (size_t)in->dst,
+                          (size_t)in->extra_args[k]);
+    }
   }
 
   for (size_t i = 0; i < nir->len; ++i) {
@@ -206,8 +215,7 @@ float ny_nir_bits_to_f32(int64_t bits) {
   return v;
 }
 
-static const char *ny_nir_own_symbol_copy(ny_nir_func_t *f,
-                                          const char *symbol) {
+const char *ny_nir_own_symbol_copy(ny_nir_func_t *f, const char *symbol) {
   if (!symbol)
     return NULL;
   char *copy = ny_strndup(symbol, strlen(symbol));
@@ -237,6 +245,7 @@ void ny_nir_func_free(ny_nir_func_t *f) {
   for (size_t i = 0; i < f->len; ++i) {
     free(f->data[i].extra_args);
     free(f->data[i].arg_sizes);
+    free(f->data[i].phi_labels);
   }
   free(f->data);
   memset(f, 0, sizeof(*f));
@@ -247,6 +256,7 @@ void ny_nir_inst_discard(ny_nir_inst_t *in) {
     return;
   free(in->extra_args);
   free(in->arg_sizes);
+  free(in->phi_labels);
   *in = (ny_nir_inst_t){.op = NY_NIR_NOP,
                         .dst = -1,
                         .a = -1,
@@ -347,6 +357,8 @@ const char *ny_nir_op_name(ny_nir_op_t op) {
     return "copy.struct";
   case NYIR_CAPTURE_RET:
     return "capture.ret";
+  case NYIR_PHI:
+    return "phi";
   case NYIR_OP_COUNT:
     break;
   }
@@ -506,6 +518,15 @@ static void ny_nir_normalize_operands(ny_nir_inst_t *inst) {
     inst->e = -1;
     inst->f = -1;
     break;
+  case NYIR_PHI:
+    inst->a = -1;
+    inst->b = -1;
+    inst->c = -1;
+    inst->d = -1;
+    inst->e = -1;
+    inst->f = -1;
+    inst->imm = 0;
+    break;
   case NYIR_OP_COUNT:
     break;
   }
@@ -636,6 +657,10 @@ void ny_nir_dump(FILE *out, const ny_nir_func_t *f, const char *name) {
       if (in->a >= 0)
         fprintf(out, " v%d", in->a);
       fprintf(out, " L%" PRId64, in->imm);
+    } else if (in->op == NYIR_PHI) {
+      for (size_t k = 0; k < in->extra_args_len; ++k)
+        fprintf(out, " [L%" PRId64 ": v%d]",
+                in->phi_labels ? in->phi_labels[k] : -1, in->extra_args[k]);
     } else {
       if (in->a >= 0)
         fprintf(out, " v%d", in->a);
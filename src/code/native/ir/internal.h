@@ -21,6 +21,10 @@ bool ny_nir_err(char *err, size_t err_len, const char *fmt, ...)
 bool ny_nir_inst_err(char *err, size_t err_len, const ny_nir_inst_t *in,
                      size_t index, const char *reason);
 
+/* init.c — copies symbol into f's owned symbol table; used by emit and by
+ * module passes that move instructions between functions. */
+const char *ny_nir_own_symbol_copy(ny_nir_func_t *f, const char *symbol);
+
 /* init.c — stats collection used by optimize. */
 void ny_nir_collect_stats(const ny_nir_func_t *f, size_t *insts,
                           int *values, size_t *ops, size_t op_count);
@@ -32,4 +36,56 @@ bool ny_nir_analyze_cmp_fold(ny_nir_cmp_t cmp, int64_t a, int64_t b,
                              int64_t *out);
 bool ny_nir_label_referenced(const ny_nir_func_t *f, int64_t label);
 
+/* cfg.c — basic blocks, dominators and natural loops over the linear
+ * instruction list. A block starts at index 0, at every LABEL and after every
+ * BR/BR_IF/RET; the analysis is a snapshot and must be rebuilt after a pass
+ * inserts or moves instructions. */
+typedef struct {
+  size_t start; /* first instruction */
+  size_t end;   /* one past the last instruction */
+  int succ[2];
+  int succ_count;
+  int *preds;
+  int pred_count;
+  int idom;     /* immediate dominator, or -1 when unreachable */
+  int rpo;      /* reverse-postorder index, or -1 when unreachable */
+  int dom_pre;  /* dominator-tree interval used by ny_nir_cfg_dominates */
+  int dom_post;
+} ny_nir_block_t;
+
+typedef struct {
+  ny_nir_block_t *blocks;
+  int block_count;
+  int *preds;     /* storage behind ny_nir_block_t.preds */
+  int *block_of;  /* instruction index -> block */
+  int *rpo;       /* reachable blocks in reverse postorder */
+  int rpo_count;
+  int *def_index; /* value -> defining instruction, or -1 */
+  size_t value_count;
+} ny_nir_cfg_t;
+
+typedef struct {
+  int header;
+  int preheader; /* the only predecessor outside the loop, or -1 */
+  bool *member;  /* block -> part of the loop body */
+  int block_count;
+} ny_nir_loop_t;
+
+bool ny_nir_cfg_build(ny_nir_cfg_t *cfg, const ny_nir_func_t *f);
+void ny_nir_cfg_free(ny_nir_cfg_t *cfg);
+bool ny_nir_cfg_reachable(const ny_nir_cfg_t *cfg, int block);
+bool ny_nir_cfg_dominates(const ny_nir_cfg_t *cfg, int a, int b);
+bool ny_nir_cfg_value_dominates(const ny_nir_cfg_t *cfg, int value,
+                                size_t use);
+/* Natural loops, one per header; loops sharing a header are merged. */
+bool ny_nir_cfg_loops(const ny_nir_cfg_t *cfg, ny_nir_loop_t **loops,
+                      size_t *count);
+void ny_nir_cfg_loops_free(ny_nir_loop_t *loops, size_t count);
+/* The label a block starts with, or -1; phi entries name predecessors by it. */
+int64_t ny_nir_cfg_block_label(const ny_nir_cfg_t *cfg,
+                               const ny_nir_func_t *f, int block);
+/* Drops phi entries whose label is no longer a reachable predecessor and
+ * turns phis with a single incoming value into copies. */
+bool ny_nir_phi_prune(ny_nir_func_t *f);
+
 #endif
@@ -0,0 +1,867 @@
+#include "code/native/ir/internal.h"
+#include "code/native/ir.h"
+#include "base/compat.h"
+#include "base/common.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Module pipeline: call graph, interprocedural constant propagation and
+ * bottom-up inlining. Every rewrite builds a fresh copy of the function and
+ * only replaces the original once the copy optimizes and verifies. */
+
+/* Inline when the callee's size minus the savings below stays within the
+ * base budget. Savings: the call itself and its argument moves, plus a
+ * bonus per folding use of a parameter whose argument is a known constant
+ * or a bounded range. */
+#define NIR_INLINE_BASE_COST 24
+#define NIR_INLINE_CALL_SAVING 6
+#define NIR_INLINE_CONST_BONUS 4
+#define NIR_INLINE_RANGE_BONUS 2
+#define NIR_INLINE_CALLER_LIMIT 4096
+
+static bool nir_module_symbol_matches(const char *symbol, const char *name) {
+  if (!symbol || !name)
+    return false;
+  if (strcmp(symbol, name) == 0)
+    return true;
+  return strncmp(symbol, "ny_fn_", 6) == 0 && strcmp(symbol + 6, name) == 0;
+}
+
+static int nir_module_callee(const ny_nir_module_t *m, const ny_nir_inst_t *in) {
+  if (in->op != NY_NIR_CALL || (in->flags & NY_NIR_INST_F_EXTERN) != 0)
+    return -1;
+  for (size_t i = 0; i < m->count; ++i) {
+    if (m->names[i] && nir_module_symbol_matches(in->symbol, m->names[i]))
+      return (int)i;
+  }
+  return -1;
+}
+
+static size_t nir_module_local_count(const ny_nir_func_t *f) {
+  int64_t max_slot = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NY_NIR_STORE_LOCAL ||
+         in->op == NYIR_ADDR_LOCAL) &&
+        in->imm > max_slot)
+      max_slot = in->imm;
+  }
+  return max_slot >= 0 ? (size_t)max_slot + 1 : 0;
+}
+
+static int64_t nir_module_label_count(const ny_nir_func_t *f) {
+  int64_t max_label = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if ((in->op == NY_NIR_LABEL || in->op == NY_NIR_BR ||
+         in->op == NY_NIR_BR_IF) &&
+        in->imm > max_label)
+      max_label = in->imm;
+    for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k)
+      if (in->phi_labels[k] > max_label)
+        max_label = in->phi_labels[k];
+  }
+  return max_label + 1;
+}
+
+/* Parameters are the first locals; a slot read before any store arrives
+ * from the caller (see ny_a64_param_count). */
+static size_t nir_module_param_count(const ny_nir_func_t *f, size_t locals) {
+  bool *stored = locals ? (bool *)calloc(locals, sizeof(bool)) : NULL;
+  if (locals && !stored)
+    return SIZE_MAX;
+  size_t count = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->imm < 0 || (size_t)in->imm >= locals)
+      continue;
+    if (in->op == NY_NIR_STORE_LOCAL)
+      stored[in->imm] = true;
+    else if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NYIR_ADDR_LOCAL) &&
+             !stored[in->imm] && (size_t)in->imm + 1 > count)
+      count = (size_t)in->imm + 1;
+  }
+  free(stored);
+  return count;
+}
+
+static int nir_module_call_arg(const ny_nir_inst_t *in, size_t k) {
+  const int regs[6] = {in->a, in->b, in->c, in->d, in->e, in->f};
+  if (k < 6)
+    return regs[k];
+  return in->extra_args && k - 6 < in->extra_args_len ? in->extra_args[k - 6]
+                                                      : -1;
+}
+
+static bool nir_module_copy_inst(ny_nir_func_t *to, const ny_nir_inst_t *src,
+                                 ny_nir_inst_t *out) {
+  *out = *src;
+  out->extra_args = NULL;
+  out->arg_sizes = NULL;
+  out->phi_labels = NULL;
+  if (src->symbol) {
+    out->symbol = ny_nir_own_symbol_copy(to, src->symbol);
+    if (!out->symbol)
+      return false;
+  }
+  if (src->extra_args && src->extra_args_len > 0) {
+    out->extra_args = (int *)malloc(src->extra_args_len * sizeof(int));
+    if (!out->extra_args)
+      return false;
+    memcpy(out->extra_args, src->extra_args,
+           src->extra_args_len * sizeof(int));
+  }
+  if (src->arg_sizes && src->imm > 0) {
+    out->arg_sizes = (uint32_t *)malloc((size_t)src->imm * sizeof(uint32_t));
+    if (!out->arg_sizes) {
+      free(out->extra_args);
+      out->extra_args = NULL;
+      return false;
+    }
+    memcpy(out->arg_sizes, src->arg_sizes, (size_t)src->imm * sizeof(uint32_t));
+  }
+  if (src->phi_labels && src->extra_args_len > 0) {
+    out->phi_labels =
+        (int64_t *)malloc(src->extra_args_len * sizeof(int64_t));
+    if (!out->phi_labels) {
+      free(out->extra_args);
+      free(out->arg_sizes);
+      out->extra_args = NULL;
+      out->arg_sizes = NULL;
+      return false;
+    }
+    memcpy(out->phi_labels, src->phi_labels,
+           src->extra_args_len * sizeof(int64_t));
+  }
+  return true;
+}
+
+static ny_nir_inst_t nir_module_inst(ny_nir_op_t op, int dst, int a,
+                                     int64_t imm) {
+  ny_nir_inst_t in = {.op = op, .dst = dst, .a = a, .b = -1, .c = -1,
+                      .d = -1, .e = -1, .f = -1, .imm = imm};
+  in.effects = ny_nir_inst_effects(&in);
+  return in;
+}
+
+static bool nir_module_push(ny_nir_func_t *f, ny_nir_inst_t in) {
+  if (f->len >= f->cap) {
+    size_t cap = f->cap ? f->cap * 2 : 64;
+    ny_nir_inst_t *data = (ny_nir_inst_t *)realloc(f->data, cap * sizeof(*data));
+    if (!data) {
+      free(in.extra_args);
+      free(in.arg_sizes);
+      free(in.phi_labels);
+      return false;
+    }
+    f->data = data;
+    f->cap = cap;
+  }
+  f->data[f->len++] = in;
+  return true;
+}
+
+/* Optimizes and verifies a rewritten copy; on success it replaces *f,
+ * otherwise the copy is dropped and *f is left as it was. */
+static bool nir_module_commit(ny_nir_func_t *f, ny_nir_func_t *copy) {
+  ny_nir_refresh_metadata(copy);
+  char err[256] = {0};
+  if (!ny_nir_optimize(copy) || !ny_nir_verify(copy, err, sizeof(err))) {
+    if (verbose_enabled >= 2)
+      fprintf(stderr, "nyir module: rewrite rolled back: %s\n",
+              err[0] ? err : "optimization failed");
+    ny_nir_func_free(copy);
+    return false;
+  }
+  ny_nir_func_free(f);
+  *f = *copy;
+  return true;
+}
+
+/* ---- call graph ---- */
+
+typedef struct {
+  size_t count;
+  bool *calls;     /* count x count: caller row calls callee column */
+  bool *recursive; /* function lies on a call cycle */
+  bool *escapes;   /* address taken through ADDR_SYMBOL */
+  size_t *order;   /* callees before callers */
+  size_t sites;
+} nir_call_graph_t;
+
+typedef struct {
+  nir_call_graph_t *cg;
+  int *index;
+  int *low;
+  bool *on_stack;
+  size_t *stack;
+  size_t depth;
+  int next_index;
+  size_t emitted;
+} nir_scc_state_t;
+
+static void nir_scc_visit(nir_scc_state_t *s, size_t v) {
+  nir_call_graph_t *cg = s->cg;
+  s->index[v] = s->low[v] = s->next_index++;
+  s->stack[s->depth++] = v;
+  s->on_stack[v] = true;
+  for (size_t w = 0; w < cg->count; ++w) {
+    if (!cg->calls[v * cg->count + w])
+      continue;
+    if (s->index[w] < 0) {
+      nir_scc_visit(s, w);
+      if (s->low[w] < s->low[v])
+        s->low[v] = s->low[w];
+    } else if (s->on_stack[w] && s->index[w] < s->low[v]) {
+      s->low[v] = s->index[w];
+    }
+  }
+  if (s->low[v] != s->index[v])
+    return;
+  size_t first = s->emitted;
+  size_t w;
+  do {
+    w = s->stack[--s->depth];
+    s->on_stack[w] = false;
+    cg->order[s->emitted++] = w;
+  } while (w != v);
+  bool cycle = s->emitted - first > 1 || cg->calls[v * cg->count + v];
+  for (size_t k = first; cycle && k < s->emitted; ++k)
+    cg->recursive[cg->order[k]] = true;
+}
+
+static void nir_call_graph_free(nir_call_graph_t *cg) {
+  free(cg->calls);
+  free(cg->recursive);
+  free(cg->escapes);
+  free(cg->order);
+  memset(cg, 0, sizeof(*cg));
+}
+
+static bool nir_call_graph_build(nir_call_graph_t *cg,
+                                 const ny_nir_module_t *m) {
+  size_t n = m->count;
+  memset(cg, 0, sizeof(*cg));
+  cg->count = n;
+  cg->calls = (bool *)calloc(n * n, sizeof(bool));
+  cg->recursive = (bool *)calloc(n, sizeof(bool));
+  cg->escapes = (bool *)calloc(n, sizeof(bool));
+  cg->order = (size_t *)calloc(n, sizeof(size_t));
+  nir_scc_state_t s = {.cg = cg};
+  s.index = (int *)malloc(n * sizeof(int));
+  s.low = (int *)malloc(n * sizeof(int));
+  s.on_stack = (bool *)calloc(n, sizeof(bool));
+  s.stack = (size_t *)malloc(n * sizeof(size_t));
+  bool ok = cg->calls && cg->recursive && cg->escapes && cg->order &&
+            s.index && s.low && s.on_stack && s.stack;
+  for (size_t i = 0; ok && i < n; ++i) {
+    const ny_nir_func_t *f = m->funcs[i];
+    for (size_t k = 0; k < f->len; ++k) {
+      const ny_nir_inst_t *in = &f->data[k];
+      if (in->op == NYIR_ADDR_SYMBOL) {
+        for (size_t j = 0; j < n; ++j)
+          if (m->names[j] && nir_module_symbol_matches(in->symbol, m->names[j]))
+            cg->escapes[j] = true;
+        continue;
+      }
+      int callee = nir_module_callee(m, in);
+      if (callee < 0)
+        continue;
+      cg->calls[i * n + (size_t)callee] = true;
+      cg->sites++;
+    }
+  }
+  for (size_t i = 0; ok && i < n; ++i)
+    s.index[i] = -1;
+  for (size_t i = 0; ok && i < n; ++i)
+    if (s.index[i] < 0)
+      nir_scc_visit(&s, i);
+  free(s.index);
+  free(s.low);
+  free(s.on_stack);
+  free(s.stack);
+  if (!ok)
+    nir_call_graph_free(cg);
+  return ok;
+}
+
+/* ---- per-function facts ---- */
+
+typedef struct {
+  ny_nir_value_fact_t *values;
+  ny_nir_type_map_t types;
+  size_t locals;
+} nir_func_facts_t;
+
+static void nir_func_facts_free(nir_func_facts_t *facts) {
+  free(facts->values);
+  ny_nir_type_map_free(&facts->types);
+  memset(facts, 0, sizeof(*facts));
+}
+
+static bool nir_func_facts_init(nir_func_facts_t *facts,
+                                const ny_nir_func_t *f) {
+  memset(facts, 0, sizeof(*facts));
+  size_t count = f->next_value > 0 ? (size_t)f->next_value : 0;
+  facts->locals = nir_module_local_count(f);
+  facts->values = (ny_nir_value_fact_t *)calloc(count ? count : 1,
+                                                sizeof(*facts->values));
+  if (!facts->values ||
+      !ny_nir_analyze_values(f, facts->values, count, NULL, 0) ||
+      !ny_nir_type_map_init(&facts->types, f, facts->locals)) {
+    nir_func_facts_free(facts);
+    return false;
+  }
+  return true;
+}
+
+static bool nir_facts_int_value(const nir_func_facts_t *facts, int v) {
+  return v >= 0 && (size_t)v < facts->types.value_count &&
+         !facts->types.value_f64[v] && !facts->types.value_f32[v];
+}
+
+/* ---- interprocedural constant propagation ---- */
+
+/* Whether every call of callee across the module passes the same known
+ * integer constant as argument k. */
+static bool nir_ipcp_common_const(const ny_nir_module_t *m, size_t callee,
+                                  size_t k, nir_func_facts_t *facts,
+                                  int64_t *out) {
+  bool seen = false;
+  for (size_t i = 0; i < m->count; ++i) {
+    const ny_nir_func_t *f = m->funcs[i];
+    for (size_t p = 0; p < f->len; ++p) {
+      const ny_nir_inst_t *in = &f->data[p];
+      if (nir_module_callee(m, in) != (int)callee)
+        continue;
+      if (in->imm <= (int64_t)k)
+        return false;
+      int arg = nir_module_call_arg(in, k);
+      if (arg < 0 || arg >= f->next_value || !nir_facts_int_value(&facts[i], arg))
+        return false;
+      const ny_nir_value_fact_t *fact = &facts[i].values[arg];
+      if (!fact->known_const || (seen && fact->const_value != *out))
+        return false;
+      *out = fact->const_value;
+      seen = true;
+    }
+  }
+  return seen;
+}
+
+/* Replaces every load of parameter slot k with a constant defined at entry.
+ * Only parameters that are never stored or address-taken qualify, so each
+ * load still observes the incoming value. */
+static bool nir_ipcp_param_ok(const ny_nir_func_t *f,
+                              const nir_func_facts_t *facts, size_t k) {
+  if (k < facts->types.local_count &&
+      (facts->types.local_f64[k] || facts->types.local_f32[k]))
+    return false;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if ((in->op == NY_NIR_STORE_LOCAL || in->op == NYIR_ADDR_LOCAL) &&
+        in->imm == (int64_t)k)
+      return false;
+  }
+  return true;
+}
+
+static bool nir_ipcp_rewrite(ny_nir_func_t *f, const bool *param_const,
+                             const int64_t *param_value, size_t params,
+                             ny_nir_func_t *copy) {
+  memset(copy, 0, sizeof(*copy));
+  copy->next_value = f->next_value;
+  int const_value[NY_NIR_CALL_MAX_ARGS];
+  for (size_t k = 0; k < params; ++k) {
+    const_value[k] = -1;
+    if (!param_const[k])
+      continue;
+    const_value[k] = copy->next_value++;
+    ny_nir_inst_t c =
+        nir_module_inst(NY_NIR_CONST_I64, const_value[k], -1, param_value[k]);
+    c.range = (ny_nir_range_t){.has_min = true, .has_max = true,
+                               .min = param_value[k], .max = param_value[k]};
+    if (!nir_module_push(copy, c))
+      return false;
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    ny_nir_inst_t out;
+    if (in->op == NY_NIR_LOAD_LOCAL && in->imm >= 0 &&
+        (size_t)in->imm < params && param_const[in->imm]) {
+      out = nir_module_inst(NY_NIR_COPY, in->dst, const_value[in->imm], 0);
+      out.debug = in->debug;
+    } else if (!nir_module_copy_inst(copy, in, &out)) {
+      return false;
+    }
+    if (!nir_module_push(copy, out))
+      return false;
+  }
+  return true;
+}
+
+/* Callers first, so constants a caller gains from its own specialization
+ * reach its callees. Parameters are specialized from the highest slot down
+ * and stop at the first that does not qualify: backends number incoming
+ * registers by the parameter slots still read, so a hole below a live
+ * parameter would shift its register. */
+static bool nir_module_ipcp(ny_nir_module_t *m, const nir_call_graph_t *cg,
+                            ny_nir_module_stats_t *stats) {
+  nir_func_facts_t *facts =
+      (nir_func_facts_t *)calloc(m->count ? m->count : 1, sizeof(*facts));
+  if (!facts)
+    return false;
+  bool ok = true;
+  for (size_t i = 0; ok && i < m->count; ++i)
+    ok = nir_func_facts_init(&facts[i], m->funcs[i]);
+  for (size_t o = m->count; ok && o-- > 0;) {
+    size_t callee = cg->order[o];
+    ny_nir_func_t *f = m->funcs[callee];
+    if (!m->names[callee] || cg->recursive[callee] || cg->escapes[callee])
+      continue;
+    size_t params = nir_module_param_count(f, facts[callee].locals);
+    if (params == 0 || params > NY_NIR_CALL_MAX_ARGS)
+      continue;
+    bool param_const[NY_NIR_CALL_MAX_ARGS] = {0};
+    int64_t param_value[NY_NIR_CALL_MAX_ARGS];
+    size_t found = 0;
+    for (size_t k = params; k-- > 0;) {
+      if (!nir_ipcp_param_ok(f, &facts[callee], k) ||
+          !nir_ipcp_common_const(m, callee, k, facts, &param_value[k]))
+        break;
+      param_const[k] = true;
+      found++;
+    }
+    if (found == 0)
+      continue;
+    ny_nir_func_t copy;
+    if (!nir_ipcp_rewrite(f, param_const, param_value, params, &copy)) {
+      ny_nir_func_free(&copy);
+      ok = false;
+      break;
+    }
+    if (!nir_module_commit(f, &copy))
+      continue;
+    stats->ipcp_params += found;
+    nir_func_facts_free(&facts[callee]);
+    ok = nir_func_facts_init(&facts[callee], f);
+  }
+  for (size_t i = 0; i < m->count; ++i)
+    nir_func_facts_free(&facts[i]);
+  free(facts);
+  return ok;
+}
+
+/* ---- inlining ---- */
+
+typedef struct {
+  size_t size;
+  size_t params;
+  size_t locals;
+  int64_t labels;
+  bool ret_f64;
+  bool ret_f32;
+  bool ret_int;
+  bool inlinable;
+  bool param_f64[NY_NIR_CALL_MAX_ARGS];
+  bool param_f32[NY_NIR_CALL_MAX_ARGS];
+  size_t param_weight[NY_NIR_CALL_MAX_ARGS];
+} nir_inline_summary_t;
+
+static size_t nir_inline_use_weight(const ny_nir_inst_t *use) {
+  switch (use->op) {
+  case NY_NIR_CMP_I64:
+  case NY_NIR_BR_IF:
+  case NY_NIR_DIV_I64:
+  case NY_NIR_MOD_I64:
+  case NY_NIR_MUL_I64:
+  case NY_NIR_SHL_I64:
+  case NY_NIR_SAR_I64:
+    return 2;
+  default:
+    return 1;
+  }
+}
+
+static bool nir_inline_summarize(const ny_nir_func_t *f,
+                                 const nir_func_facts_t *facts,
+                                 nir_inline_summary_t *sum) {
+  memset(sum, 0, sizeof(*sum));
+  sum->locals = facts->locals;
+  sum->labels = nir_module_label_count(f);
+  sum->params = nir_module_param_count(f, sum->locals);
+  if (sum->params > NY_NIR_CALL_MAX_ARGS)
+    return true;
+  for (size_t k = 0; k < sum->params && k < facts->types.local_count; ++k) {
+    sum->param_f64[k] = facts->types.local_f64[k];
+    sum->param_f32[k] = facts->types.local_f32[k];
+  }
+  size_t values = f->next_value > 0 ? (size_t)f->next_value : 0;
+  int *param_of = (int *)malloc((values ? values : 1) * sizeof(int));
+  if (!param_of)
+    return false;
+  for (size_t v = 0; v < values; ++v)
+    param_of[v] = -1;
+  bool has_ret = false;
+  bool ok = true;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    switch (in->op) {
+    case NY_NIR_NOP:
+    case NY_NIR_LABEL:
+      continue;
+    case NYIR_ALLOCA:
+    case NYIR_COPY_STRUCT:
+      ok = false;
+      break;
+    case NY_NIR_RET:
+      has_ret = true;
+      if (in->a < 0 || (size_t)in->a >= facts->types.value_count) {
+        ok = false;
+        break;
+      }
+      if (facts->types.value_f64[in->a])
+        sum->ret_f64 = true;
+      else if (facts->types.value_f32[in->a])
+        sum->ret_f32 = true;
+      else
+        sum->ret_int = true;
+      break;
+    case NY_NIR_LOAD_LOCAL:
+      if (in->dst >= 0 && (size_t)in->dst < values && in->imm >= 0 &&
+          (size_t)in->imm < sum->params)
+        param_of[in->dst] = (int)in->imm;
+      break;
+    default:
+      break;
+    }
+    sum->size++;
+    const int operands[2] = {in->a, in->b};
+    for (int k = 0; k < 2; ++k) {
+      int v = operands[k];
+      if (v >= 0 && (size_t)v < values && param_of[v] >= 0)
+        sum->param_weight[param_of[v]] += nir_inline_use_weight(in);
+    }
+  }
+  free(param_of);
+  sum->inlinable = ok && has_ret &&
+                   (int)sum->ret_f64 + (int)sum->ret_f32 + (int)sum->ret_int == 1;
+  return true;
+}
+
+typedef enum {
+  NIR_INLINE_NO = 0,
+  NIR_INLINE_YES,
+  NIR_INLINE_TOO_COSTLY,
+} nir_inline_decision_t;
+
+static nir_inline_decision_t nir_inline_decide(
+    const ny_nir_func_t *caller, const nir_func_facts_t *caller_facts,
+    size_t at, const nir_inline_summary_t *sum) {
+  const ny_nir_inst_t *in = &caller->data[at];
+  if (!sum->inlinable || in->arg_sizes ||
+      (in->flags & NY_NIR_INST_F_SRET) != 0 || in->imm < 0 ||
+      in->imm > NY_NIR_CALL_MAX_ARGS || (size_t)in->imm < sum->params)
+    return NIR_INLINE_NO;
+  if (at + 1 < caller->len && caller->data[at + 1].op == NYIR_CAPTURE_RET)
+    return NIR_INLINE_NO;
+  bool want_f64 = (in->flags & NY_NIR_INST_F_RET_F64) != 0;
+  bool want_f32 = (in->flags & NY_NIR_INST_F_RET_F32) != 0;
+  if (want_f64 != sum->ret_f64 || want_f32 != sum->ret_f32)
+    return NIR_INLINE_NO;
+  const ny_nir_type_map_t *types = &caller_facts->types;
+  size_t argc = (size_t)in->imm;
+  long bonus = NIR_INLINE_CALL_SAVING + (long)argc;
+  for (size_t k = 0; k < argc; ++k) {
+    int arg = nir_module_call_arg(in, k);
+    if (arg < 0 || (size_t)arg >= types->value_count)
+      return NIR_INLINE_NO;
+    if (k >= sum->params)
+      continue;
+    /* The argument becomes a store to the parameter slot, which must keep
+     * the callee's type. */
+    if (types->value_f64[arg] != sum->param_f64[k] ||
+        types->value_f32[arg] != sum->param_f32[k])
+      return NIR_INLINE_NO;
+    const ny_nir_value_fact_t *fact = &caller_facts->values[arg];
+    if (fact->known_const)
+      bonus += (long)(sum->param_weight[k] * NIR_INLINE_CONST_BONUS);
+    else if (fact->range.has_min && fact->range.has_max)
+      bonus += (long)(sum->param_weight[k] * NIR_INLINE_RANGE_BONUS);
+  }
+  if ((long)sum->size - bonus > NIR_INLINE_BASE_COST)
+    return NIR_INLINE_TOO_COSTLY;
+  return NIR_INLINE_YES;
+}
+
+/* Appends callee's body in place of the call at `call`: arguments are stored
+ * into fresh parameter slots, values, locals and labels are renumbered past
+ * the caller's, and every return stores to a result slot and jumps to a join
+ * label that reloads it into the call's destination. mem2reg folds the
+ * single-return case back into a direct use. */
+static bool nir_inline_expand(ny_nir_func_t *copy, const ny_nir_inst_t *call,
+                              const ny_nir_func_t *callee,
+                              const nir_inline_summary_t *sum,
+                              size_t *local_base, int64_t *label_base) {
+  int value_off = copy->next_value;
+  int64_t local_off = (int64_t)*local_base;
+  int64_t label_off = *label_base;
+  size_t argc = (size_t)call->imm;
+  size_t slots = sum->locals > argc ? sum->locals : argc;
+  int64_t result_slot = local_off + (int64_t)slots;
+  int64_t join = label_off + sum->labels;
+  copy->next_value += callee->next_value;
+  *local_base += slots + 1;
+  *label_base = join + 1;
+
+  for (size_t k = 0; k < argc; ++k) {
+    ny_nir_inst_t st = nir_module_inst(NY_NIR_STORE_LOCAL, -1,
+                                       nir_module_call_arg(call, k),
+                                       local_off + (int64_t)k);
+    st.debug = call->debug;
+    if (!nir_module_push(copy, st))
+      return false;
+  }
+  for (size_t i = 0; i < callee->len; ++i) {
+    const ny_nir_inst_t *in = &callee->data[i];
+    if (in->op == NY_NIR_NOP)
+      continue;
+    if (in->op == NY_NIR_RET) {
+      ny_nir_inst_t st = nir_module_inst(NY_NIR_STORE_LOCAL, -1,
+                                         in->a + value_off, result_slot);
+      ny_nir_inst_t br = nir_module_inst(NY_NIR_BR, -1, -1, join);
+      st.debug = br.debug = in->debug;
+      if (!nir_module_push(copy, st) || !nir_module_push(copy, br))
+        return false;
+      continue;
+    }
+    ny_nir_inst_t out;
+    if (!nir_module_copy_inst(copy, in, &out))
+      return false;
+    int *operands[7] = {&out.dst, &out.a, &out.b, &out.c,
+                        &out.d,   &out.e, &out.f};
+    for (int k = 0; k < 7; ++k)
+      if (*operands[k] >= 0)
+        *operands[k] += value_off;
+    for (size_t k = 0; out.extra_args && k < out.extra_args_len; ++k)
+      if (out.extra_args[k] >= 0)
+        out.extra_args[k] += value_off;
+    for (size_t k = 0; out.phi_labels && k < out.extra_args_len; ++k)
+      out.phi_labels[k] += label_off;
+    if ((out.op == NY_NIR_LOAD_LOCAL || out.op == NY_NIR_STORE_LOCAL ||
+         out.op == NYIR_ADDR_LOCAL) &&
+        out.imm >= 0)
+      out.imm += local_off;
+    else if ((out.op == NY_NIR_LABEL || out.op == NY_NIR_BR ||
+              out.op == NY_NIR_BR_IF) &&
+             out.imm >= 0)
+      out.imm += label_off;
+    if (!nir_module_push(copy, out))
+      return false;
+  }
+  ny_nir_inst_t label = nir_module_inst(NY_NIR_LABEL, -1, -1, join);
+  label.debug = call->debug;
+  if (!nir_module_push(copy, label))
+    return false;
+  if (call->dst < 0)
+    return true;
+  ny_nir_inst_t ld = nir_module_inst(NY_NIR_LOAD_LOCAL, call->dst, -1,
+                                     result_slot);
+  ld.debug = call->debug;
+  return nir_module_push(copy, ld);
+}
+
+/* A caller block that had a call expanded now leaves through the join label
+ * of its last inlined call, so phi entries naming the block move there. */
+static void nir_inline_remap_phis(ny_nir_func_t *copy, const int64_t *exit_label,
+                                  int64_t label_count) {
+  for (size_t i = 0; i < copy->len; ++i) {
+    ny_nir_inst_t *in = &copy->data[i];
+    for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k) {
+      int64_t label = in->phi_labels[k];
+      if (label >= 0 && label < label_count && exit_label[label] >= 0)
+        in->phi_labels[k] = exit_label[label];
+    }
+  }
+}
+
+/* Inlines the qualifying direct calls of one function. Returns 1 when a
+ * rewrite was committed, 0 when nothing changed, -1 on failure. */
+static int nir_module_inline_into(ny_nir_module_t *m, const nir_call_graph_t *cg,
+                                  size_t caller, ny_nir_module_stats_t *stats) {
+  ny_nir_func_t *f = m->funcs[caller];
+  nir_func_facts_t facts;
+  if (!nir_func_facts_init(&facts, f))
+    return -1;
+  nir_inline_summary_t *sums =
+      (nir_inline_summary_t *)calloc(m->count, sizeof(*sums));
+  bool *summarized = (bool *)calloc(m->count, sizeof(bool));
+  int *target = (int *)malloc((f->len ? f->len : 1) * sizeof(int));
+  int result = sums && summarized && target ? 0 : -1;
+  size_t growth = f->len;
+  size_t planned = 0;
+  for (size_t i = 0; result == 0 && i < f->len; ++i) {
+    target[i] = -1;
+    int callee = nir_module_callee(m, &f->data[i]);
+    if (callee < 0)
+      continue;
+    stats->inline_candidates++;
+    if ((size_t)callee == caller || cg->recursive[callee])
+      continue;
+    if (!summarized[callee]) {
+      nir_func_facts_t callee_facts;
+      if (!nir_func_facts_init(&callee_facts, m->funcs[callee])) {
+        result = -1;
+        break;
+      }
+      bool ok = nir_inline_summarize(m->funcs[callee], &callee_facts,
+                                     &sums[callee]);
+      nir_func_facts_free(&callee_facts);
+      if (!ok) {
+        result = -1;
+        break;
+      }
+      summarized[callee] = true;
+    }
+    switch (nir_inline_decide(f, &facts, i, &sums[callee])) {
+    case NIR_INLINE_YES:
+      if (growth + sums[callee].size > NIR_INLINE_CALLER_LIMIT) {
+        stats->inline_rejected++;
+        break;
+      }
+      growth += sums[callee].size;
+      target[i] = callee;
+      planned++;
+      break;
+    case NIR_INLINE_TOO_COSTLY:
+      stats->inline_rejected++;
+      break;
+    case NIR_INLINE_NO:
+      break;
+    }
+  }
+  nir_func_facts_free(&facts);
+  if (result == 0 && planned > 0) {
+    ny_nir_func_t copy = {.next_value = f->next_value};
+    size_t local_base = nir_module_local_count(f);
+    int64_t label_count = nir_module_label_count(f);
+    int64_t label_base = label_count;
+    int64_t *exit_label = (int64_t *)malloc(
+        (label_count > 0 ? (size_t)label_count : 1) * sizeof(int64_t));
+    int64_t block_label = -1;
+    bool ok = exit_label != NULL;
+    for (int64_t l = 0; ok && l < label_count; ++l)
+      exit_label[l] = -1;
+    for (size_t i = 0; ok && i < f->len; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if (in->op == NY_NIR_LABEL)
+        block_label = in->imm;
+      if (target[i] >= 0) {
+        ok = nir_inline_expand(&copy, in, m->funcs[target[i]],
+                               &sums[target[i]], &local_base, &label_base);
+        if (block_label >= 0 && block_label < label_count)
+          exit_label[block_label] = label_base - 1;
+        continue;
+      }
+      ny_nir_inst_t out;
+      ok = nir_module_copy_inst(&copy, in, &out) &&
+           nir_module_push(&copy, out);
+      if (in->op == NY_NIR_BR || in->op == NY_NIR_BR_IF ||
+          in->op == NY_NIR_RET)
+        block_label = -1;
+    }
+    if (ok)
+      nir_inline_remap_phis(&copy, exit_label, label_count);
+    free(exit_label);
+    if (!ok) {
+      ny_nir_func_free(&copy);
+      result = -1;
+    } else if (nir_module_commit(f, &copy)) {
+      stats->inlined += planned;
+      result = 1;
+    } else {
+      stats->inline_failed += planned;
+    }
+  }
+  free(sums);
+  free(summarized);
+  free(target);
+  return result;
+}
+
+/* Callees before callers, so each inlined body is already final. */
+static bool nir_module_inline(ny_nir_module_t *m, const nir_call_graph_t *cg,
+                              ny_nir_module_stats_t *stats) {
+  for (size_t o = 0; o < m->count; ++o) {
+    if (nir_module_inline_into(m, cg, cg->order[o], stats) < 0)
+      return false;
+  }
+  return true;
+}
+
+/* ---- pass manager ---- */
+
+static size_t nir_module_insts(const ny_nir_module_t *m) {
+  size_t total = 0;
+  for (size_t i = 0; i < m->count; ++i)
+    total += m->funcs[i]->len;
+  return total;
+}
+
+static bool (*const module_pipeline[])(ny_nir_module_t *,
+                                       const nir_call_graph_t *,
+                                       ny_nir_module_stats_t *) = {
+    nir_module_ipcp,
+    nir_module_inline,
+};
+
+bool ny_nir_optimize_module(ny_nir_module_t *m, ny_nir_module_stats_t *stats) {
+  ny_nir_module_stats_t local_stats;
+  if (!stats)
+    stats = &local_stats;
+  memset(stats, 0, sizeof(*stats));
+  if (!m || m->count == 0)
+    return true;
+  ny_tick_t t0 = ny_ticks_now();
+  stats->functions = m->count;
+  stats->before_insts = nir_module_insts(m);
+  nir_call_graph_t cg;
+  if (!nir_call_graph_build(&cg, m))
+    return false;
+  stats->call_sites = cg.sites;
+  for (size_t i = 0; i < m->count; ++i)
+    stats->recursive += cg.recursive[i] ? 1u : 0u;
+  /* Inlining only adds edges that shortcut existing paths, so the cycles
+   * and the bottom-up order found here stay valid for every pass. */
+  bool ok = true;
+  size_t pass_count = sizeof(module_pipeline) / sizeof(module_pipeline[0]);
+  for (size_t p = 0; ok && p < pass_count; ++p)
+    ok = module_pipeline[p](m, &cg, stats);
+  nir_call_graph_free(&cg);
+  stats->after_insts = nir_module_insts(m);
+  stats->time_ms = ny_ticks_elapsed_ms(t0);
+  if (verbose_enabled >= 1 && ok)
+    fprintf(stderr,
+            "nyir module: %zu funcs, %zu calls, inlined %zu, ipcp %zu, "
+            "%zu->%zu insts in %.2fms\n",
+            stats->functions, stats->call_sites, stats->inlined,
+            stats->ipcp_params, stats->before_insts, stats->after_insts,
+            stats->time_ms);
+  return ok;
+}
+
+void ny_nir_dump_module_stats(FILE *out, const ny_nir_module_stats_t *stats) {
+  if (!out)
+    out = stderr;
+  if (!stats)
+    return;
+  fprintf(out,
+          "nyir module functions=%zu call_sites=%zu recursive=%zu "
+          "ipcp_params=%zu inline_candidates=%zu inlined=%zu "
+          "inline_rejected=%zu inline_failed=%zu before_insts=%zu "
+          "after_insts=%zu\n",
+          stats->functions, stats->call_sites, stats->recursive,
+          stats->ipcp_params, stats->inline_candidates, stats->inlined,
+          stats->inline_rejected, stats->inline_failed, stats->before_insts,
+          stats->after_insts);
+}
@@ -200,6 +200,7 @@ bool ny_nir_const_fold(ny_nir_func_t *f) {
   free(local_known);
   free(local_addr_taken);
   free(local_value);
+  ny_nir_phi_prune(f); /* a folded branch may have removed a phi's edge */
   return true;
 }
 
@@ -245,6 +246,12 @@ bool ny_nir_copy_prop(ny_nir_func_t *f) {
         alias[in->dst] = in->dst;
     }
   }
+  /* Loop-carried phi operands are defined further down the list. */
+  for (size_t i = 0; i < f->len; ++i) {
+    ny_nir_inst_t *in = &f->data[i];
+    for (size_t k = 0; in->op == NYIR_PHI && k < in->extra_args_len; ++k)
+      in->extra_args[k] = nir_alias_find(alias, in->extra_args[k]);
+  }
   free(alias);
   return true;
 }
@@ -535,9 +542,34 @@ bool ny_nir_cfg_simplify(ny_nir_func_t *f) {
   }
   free(known);
   free(value);
+  ny_nir_phi_prune(f);
+  return true;
+}
+
+static bool nir_dce_mark(bool *used, int v) {
+  if (v < 0 || used[v])
+    return false;
+  used[v] = true;
   return true;
 }
 
+static bool nir_dce_keep(const ny_nir_func_t *f, size_t i, const bool *used,
+                         const bool *label_referenced, int64_t max_label) {
+  const ny_nir_inst_t *in = &f->data[i];
+  if (in->op == NY_NIR_LABEL) {
+    /* Phis name their predecessors by label and sit right after one. */
+    size_t next = nir_next_non_nop(f, i + 1);
+    if (next < f->len && f->data[next].op == NYIR_PHI)
+      return true;
+    return label_referenced && in->imm >= 0 && in->imm <= max_label
+               ? label_referenced[(size_t)in->imm]
+               : ny_nir_label_referenced(f, in->imm);
+  }
+  return in->effects != NY_NIR_EFFECT_NONE || in->op == NY_NIR_RET ||
+         in->op == NY_NIR_BR || in->op == NY_NIR_BR_IF ||
+         (in->dst >= 0 && used[in->dst]);
+}
+
 bool ny_nir_dce(ny_nir_func_t *f) {
   if (!f || f->next_value <= 0)
     return true;
@@ -545,6 +577,20 @@ bool ny_nir_dce(ny_nir_func_t *f) {
   if (!used)
     return false;
 
+  /* Blocks the CFG cannot reach go first, labels included, so a loop only
+   * entered from dead code does not outlive the definitions feeding it. */
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    free(used);
+    return false;
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    if (!ny_nir_cfg_reachable(&cfg, cfg.block_of[i]))
+      ny_nir_inst_discard(&f->data[i]);
+  }
+  ny_nir_cfg_free(&cfg);
+  ny_nir_phi_prune(f);
+
   int64_t max_label = -1;
   for (size_t i = 0; i < f->len; ++i) {
     const ny_nir_inst_t *in = &f->data[i];
@@ -552,6 +598,10 @@ bool ny_nir_dce(ny_nir_func_t *f) {
          in->op == NY_NIR_BR_IF) &&
         in->imm >= 0 && in->imm > max_label)
       max_label = in->imm;
+    for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k) {
+      if (in->phi_labels[k] > max_label)
+        max_label = in->phi_labels[k];
+    }
   }
   bool *label_referenced = NULL;
   if (max_label >= 0 && (uint64_t)max_label <= (uint64_t)f->len * 4u + 1024u) {
@@ -566,68 +616,37 @@ bool ny_nir_dce(ny_nir_func_t *f) {
       if ((in->op == NY_NIR_BR || in->op == NY_NIR_BR_IF) && in->imm >= 0 &&
           in->imm <= max_label)
         label_referenced[in->imm] = true;
+      for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k) {
+        if (in->phi_labels[k] >= 0)
+          label_referenced[in->phi_labels[k]] = true;
+      }
     }
   }
-#define NIR_LABEL_REFERENCED(label)                                            \
-  (label_referenced && (label) >= 0 && (label) <= max_label                    \
-       ? label_referenced[(size_t)(label)]                                     \
-       : ny_nir_label_referenced(f, (label)))
 
-  bool reachable = true;
-  bool fallthrough = true;
-  bool first_inst = true;
-  for (size_t i = 0; i < f->len; ++i) {
-    ny_nir_inst_t *in = &f->data[i];
-    if (in->op == NY_NIR_LABEL) {
-      reachable = first_inst || fallthrough || NIR_LABEL_REFERENCED(in->imm);
-      fallthrough = reachable;
+  /* Uses reach a definition backwards through the list except through a
+   * phi, whose loop-carried operands are defined further down; mark again
+   * until a phi adds nothing new. */
+  for (bool again = true; again;) {
+    again = false;
+    for (size_t i = f->len; i > 0; --i) {
+      const ny_nir_inst_t *in = &f->data[i - 1];
+      if (!nir_dce_keep(f, i - 1, used, label_referenced, max_label))
+        continue;
+      bool marked = nir_dce_mark(used, in->a) | nir_dce_mark(used, in->b) |
+                    nir_dce_mark(used, in->c) | nir_dce_mark(used, in->d) |
+                    nir_dce_mark(used, in->e) | nir_dce_mark(used, in->f);
+      for (size_t k = 0; k < in->extra_args_len; ++k)
+        marked |= nir_dce_mark(used, in->extra_args[k]);
+      if (marked && in->op == NYIR_PHI)
+        again = true;
     }
-    if (!reachable && in->op != NY_NIR_LABEL) {
-      ny_nir_inst_discard(in);
-      first_inst = false;
-      continue;
-    }
-    if (in->op == NY_NIR_RET || in->op == NY_NIR_BR) {
-      reachable = false;
-      fallthrough = false;
-    } else if (in->op != NY_NIR_NOP) {
-      fallthrough = reachable;
-    }
-    first_inst = false;
   }
-
   for (size_t i = f->len; i > 0; --i) {
-    ny_nir_inst_t *in = &f->data[i - 1];
-    bool side_effect = in->effects != NY_NIR_EFFECT_NONE ||
-                       in->op == NY_NIR_RET || in->op == NY_NIR_BR ||
-                       in->op == NY_NIR_BR_IF;
-    if (in->op == NY_NIR_LABEL)
-      side_effect = NIR_LABEL_REFERENCED(in->imm);
-    bool keep = side_effect || (in->dst >= 0 && used[in->dst]);
-    if (!keep) {
-      ny_nir_inst_discard(in);
-      continue;
-    }
-    if (in->a >= 0)
-      used[in->a] = true;
-    if (in->b >= 0)
-      used[in->b] = true;
-    if (in->c >= 0)
-      used[in->c] = true;
-    if (in->d >= 0)
-      used[in->d] = true;
-    if (in->e >= 0)
-      used[in->e] = true;
-    if (in->f >= 0)
-      used[in->f] = true;
-    for (size_t k = 0; k < in->extra_args_len; ++k) {
-      if (in->extra_args[k] >= 0)
-        used[in->extra_args[k]] = true;
-    }
+    if (!nir_dce_keep(f, i - 1, used, label_referenced, max_label))
+      ny_nir_inst_discard(&f->data[i - 1]);
   }
   free(label_referenced);
   free(used);
-#undef NIR_LABEL_REFERENCED
   return true;
 }
 
@@ -704,6 +723,1572 @@ bool ny_nir_compact(ny_nir_func_t *f) {
   return true;
 }
 
+/*
+ * SSA and loop passes. NYIR keeps named locals in memory slots. mem2reg first
+ * forwards a slot's reaching value wherever a single SSA value reaches a load
+ * along every path, then promotes the integer slots that are still read into
+ * SSA form, placing NYIR_PHI on the iterated dominance frontier of their
+ * stores where the slot is live. The passes share a CFG snapshot from cfg.c
+ * and the type map so a rewrite never joins an integer value class with a
+ * floating one.
+ */
+
+#define NIR_SSA_TOP (-2)
+#define NIR_SSA_UNKNOWN (-1)
+/* Block x slot state cells the promotion dataflow may allocate. */
+#define NIR_SSA_STATE_LIMIT ((size_t)1 << 22)
+/* Rebuild rounds for the loop passes, which transform one loop at a time. */
+#define NIR_LOOP_ROUND_LIMIT 64
+
+typedef struct {
+  size_t local_count;
+  bool *addr_taken;
+  int *first_store; /* first STORE_LOCAL per slot, or -1 */
+  int *first_load;  /* first LOAD_LOCAL per slot, or -1 */
+  ny_nir_type_map_t types;
+} nir_ssa_info_t;
+
+static void nir_ssa_info_free(nir_ssa_info_t *info) {
+  free(info->addr_taken);
+  free(info->first_store);
+  free(info->first_load);
+  ny_nir_type_map_free(&info->types);
+  memset(info, 0, sizeof(*info));
+}
+
+static bool nir_ssa_info_init(nir_ssa_info_t *info, const ny_nir_func_t *f) {
+  memset(info, 0, sizeof(*info));
+  int64_t max_local = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NY_NIR_STORE_LOCAL ||
+         in->op == NYIR_ADDR_LOCAL) &&
+        in->imm > max_local)
+      max_local = in->imm;
+  }
+  info->local_count = (size_t)(max_local + 1);
+  if (info->local_count) {
+    info->addr_taken = (bool *)calloc(info->local_count, sizeof(bool));
+    info->first_store = (int *)malloc(info->local_count * sizeof(int));
+    info->first_load = (int *)malloc(info->local_count * sizeof(int));
+    if (!info->addr_taken || !info->first_store || !info->first_load) {
+      nir_ssa_info_free(info);
+      return false;
+    }
+    for (size_t l = 0; l < info->local_count; ++l) {
+      info->first_store[l] = -1;
+      info->first_load[l] = -1;
+    }
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->imm < 0 || (size_t)in->imm >= info->local_count)
+      continue;
+    if (in->op == NYIR_ADDR_LOCAL)
+      info->addr_taken[in->imm] = true;
+    else if (in->op == NY_NIR_STORE_LOCAL && info->first_store[in->imm] < 0)
+      info->first_store[in->imm] = (int)i;
+    else if (in->op == NY_NIR_LOAD_LOCAL && info->first_load[in->imm] < 0)
+      info->first_load[in->imm] = (int)i;
+  }
+  if (!ny_nir_type_map_init(&info->types, f, info->local_count)) {
+    nir_ssa_info_free(info);
+    return false;
+  }
+  return true;
+}
+
+static bool nir_ssa_slot(const nir_ssa_info_t *info, int64_t slot) {
+  return slot >= 0 && (size_t)slot < info->local_count &&
+         !info->addr_taken[slot];
+}
+
+static bool nir_ssa_same_type(const nir_ssa_info_t *info, int a, int b) {
+  const ny_nir_type_map_t *t = &info->types;
+  return a >= 0 && b >= 0 && (size_t)a < t->value_count &&
+         (size_t)b < t->value_count && t->value_f64[a] == t->value_f64[b] &&
+         t->value_f32[a] == t->value_f32[b];
+}
+
+static bool nir_ssa_int_value(const nir_ssa_info_t *info, int v) {
+  const ny_nir_type_map_t *t = &info->types;
+  return v >= 0 && (size_t)v < t->value_count && !t->value_f64[v] &&
+         !t->value_f32[v];
+}
+
+static bool nir_ssa_int_slot(const nir_ssa_info_t *info, int64_t slot) {
+  return nir_ssa_slot(info, slot) && !info->types.local_f64[slot] &&
+         !info->types.local_f32[slot];
+}
+
+/* Backends treat a slot whose first linear access is a load as an incoming
+ * parameter, so a load placed at pos must not precede the slot's first
+ * store when a store used to come first. */
+static bool nir_ssa_load_allowed_at(const nir_ssa_info_t *info, int64_t slot,
+                                    size_t pos) {
+  int store = info->first_store[slot];
+  int load = info->first_load[slot];
+  if (store < 0 || (load >= 0 && load < store))
+    return true;
+  return (size_t)store < pos;
+}
+
+static ny_nir_inst_t nir_new_inst(ny_nir_op_t op, int dst, int a, int b,
+                                  int64_t imm) {
+  ny_nir_inst_t in = {.op = op,
+                      .dst = dst,
+                      .a = a,
+                      .b = b,
+                      .c = -1,
+                      .d = -1,
+                      .e = -1,
+                      .f = -1,
+                      .imm = imm};
+  in.effects = ny_nir_inst_effects(&in);
+  return in;
+}
+
+static bool nir_insert_at(ny_nir_func_t *f, size_t pos,
+                          const ny_nir_inst_t *insts, size_t count) {
+  if (pos > f->len)
+    return false;
+  if (f->len + count > f->cap) {
+    size_t cap = f->cap ? f->cap : 64;
+    while (cap < f->len + count)
+      cap *= 2;
+    ny_nir_inst_t *data = (ny_nir_inst_t *)realloc(f->data, cap * sizeof(*data));
+    if (!data)
+      return false;
+    f->data = data;
+    f->cap = cap;
+  }
+  memmove(&f->data[pos + count], &f->data[pos],
+          (f->len - pos) * sizeof(*f->data));
+  memcpy(&f->data[pos], insts, count * sizeof(*insts));
+  f->len += count;
+  return true;
+}
+
+static bool nir_const_def(const ny_nir_func_t *f, const ny_nir_cfg_t *cfg,
+                          int v, int64_t *out) {
+  if (v < 0 || (size_t)v >= cfg->value_count || cfg->def_index[v] < 0)
+    return false;
+  const ny_nir_inst_t *def = &f->data[cfg->def_index[v]];
+  if (def->op != NY_NIR_CONST_I64)
+    return false;
+  *out = def->imm;
+  return true;
+}
+
+static void nir_ssa_step(const ny_nir_inst_t *in, const nir_ssa_info_t *info,
+                         const bool *tracked, int *state) {
+  if (in->dst >= 0 && tracked[in->dst]) {
+    /* A new dynamic instance of the value no longer matches the slot. */
+    for (size_t l = 0; l < info->local_count; ++l) {
+      if (state[l] == in->dst)
+        state[l] = NIR_SSA_UNKNOWN;
+    }
+  }
+  if ((in->op != NY_NIR_STORE_LOCAL && in->op != NY_NIR_LOAD_LOCAL) ||
+      !nir_ssa_slot(info, in->imm))
+    return;
+  if (in->op == NY_NIR_STORE_LOCAL)
+    state[in->imm] = in->a;
+  else if (state[in->imm] < 0)
+    state[in->imm] = in->dst;
+}
+
+static int nir_ssa_meet(int a, int b) {
+  if (a == NIR_SSA_TOP)
+    return b;
+  if (b == NIR_SSA_TOP)
+    return a;
+  return a == b ? a : NIR_SSA_UNKNOWN;
+}
+
+/* Forwards a slot's reaching value to its loads where exactly one SSA value
+ * reaches along every path. */
+static bool nir_mem2reg_forward(ny_nir_func_t *f) {
+  nir_ssa_info_t info;
+  if (!nir_ssa_info_init(&info, f))
+    return false;
+  size_t slots = info.local_count;
+  if (slots == 0) {
+    nir_ssa_info_free(&info);
+    return true;
+  }
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    nir_ssa_info_free(&info);
+    return false;
+  }
+  size_t blocks = (size_t)cfg.block_count;
+  if (blocks > NIR_SSA_STATE_LIMIT / slots) {
+    ny_nir_cfg_free(&cfg);
+    nir_ssa_info_free(&info);
+    return true;
+  }
+  bool *tracked = (bool *)calloc((size_t)f->next_value, sizeof(bool));
+  int *in_state = (int *)malloc(blocks * slots * sizeof(int));
+  int *out_state = (int *)malloc(blocks * slots * sizeof(int));
+  int *cur = (int *)malloc(slots * sizeof(int));
+  size_t *loads = (size_t *)calloc(slots, sizeof(size_t));
+  bool ok = tracked && in_state && out_state && cur && loads;
+  if (!ok)
+    goto done;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NY_NIR_LOAD_LOCAL && in->dst >= 0)
+      tracked[in->dst] = true;
+    else if (in->op == NY_NIR_STORE_LOCAL && in->a >= 0)
+      tracked[in->a] = true;
+  }
+  for (size_t k = 0; k < blocks * slots; ++k)
+    out_state[k] = NIR_SSA_TOP;
+
+  bool changed = true;
+  for (int round = 0; changed; ++round) {
+    if (round > 2 * cfg.rpo_count + 8)
+      goto done; /* not converging: leave the function as it is */
+    changed = false;
+    for (int r = 0; r < cfg.rpo_count; ++r) {
+      int b = cfg.rpo[r];
+      const ny_nir_block_t *blk = &cfg.blocks[b];
+      for (size_t l = 0; l < slots; ++l)
+        cur[l] = r == 0 ? NIR_SSA_UNKNOWN : NIR_SSA_TOP;
+      for (int p = 0; r > 0 && p < blk->pred_count; ++p) {
+        int pred = blk->preds[p];
+        if (!ny_nir_cfg_reachable(&cfg, pred))
+          continue;
+        for (size_t l = 0; l < slots; ++l)
+          cur[l] = nir_ssa_meet(cur[l], out_state[(size_t)pred * slots + l]);
+      }
+      memcpy(&in_state[(size_t)b * slots], cur, slots * sizeof(int));
+      for (size_t i = blk->start; i < blk->end; ++i)
+        nir_ssa_step(&f->data[i], &info, tracked, cur);
+      int *out = &out_state[(size_t)b * slots];
+      if (memcmp(out, cur, slots * sizeof(int)) != 0) {
+        memcpy(out, cur, slots * sizeof(int));
+        changed = true;
+      }
+    }
+  }
+
+  for (int r = 0; r < cfg.rpo_count; ++r) {
+    const ny_nir_block_t *blk = &cfg.blocks[cfg.rpo[r]];
+    memcpy(cur, &in_state[(size_t)cfg.rpo[r] * slots], slots * sizeof(int));
+    for (size_t i = blk->start; i < blk->end; ++i) {
+      ny_nir_inst_t *in = &f->data[i];
+      int v = in->op == NY_NIR_LOAD_LOCAL && nir_ssa_slot(&info, in->imm)
+                  ? cur[in->imm]
+                  : NIR_SSA_UNKNOWN;
+      if (v >= 0 && v != in->dst && nir_ssa_same_type(&info, v, in->dst) &&
+          ny_nir_cfg_value_dominates(&cfg, v, i)) {
+        for (size_t l = 0; l < slots; ++l) {
+          if (cur[l] == in->dst)
+            cur[l] = NIR_SSA_UNKNOWN;
+        }
+        nir_make_copy(in, v);
+        continue;
+      }
+      nir_ssa_step(in, &info, tracked, cur);
+    }
+  }
+
+  /* Stores to integer slots that are never read again are dead. Float
+   * slots keep theirs: the store is what ties a promoted value's class to
+   * the slot's type. */
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NY_NIR_LOAD_LOCAL && in->imm >= 0 &&
+        (size_t)in->imm < slots)
+      loads[in->imm]++;
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NY_NIR_STORE_LOCAL && nir_ssa_int_slot(&info, in->imm) &&
+        loads[in->imm] == 0)
+      ny_nir_inst_discard(in);
+  }
+
+done:
+  free(tracked);
+  free(in_state);
+  free(out_state);
+  free(cur);
+  free(loads);
+  ny_nir_cfg_free(&cfg);
+  nir_ssa_info_free(&info);
+  return ok;
+}
+
+/* Dominance frontiers in the Cooper, Harvey and Kennedy formulation: a join
+ * block is in the frontier of every block on its predecessors' idom chains
+ * below its own idom. Block b's frontier is list[start[b]..start[b + 1]). */
+static bool nir_dom_frontiers(const ny_nir_cfg_t *cfg, int **out_start,
+                              int **out_list) {
+  int n = cfg->block_count;
+  int *start = (int *)calloc((size_t)n + 1u, sizeof(int));
+  int *fill = (int *)calloc((size_t)n, sizeof(int));
+  int *seen = (int *)malloc((size_t)n * sizeof(int));
+  int *list = NULL;
+  bool ok = start && fill && seen;
+  for (int pass = 0; ok && pass < 2; ++pass) {
+    if (pass == 1) {
+      for (int b = 0; b < n; ++b)
+        start[b + 1] = start[b] + fill[b];
+      list = (int *)malloc(((size_t)start[n] + 1u) * sizeof(int));
+      if (!(ok = list != NULL))
+        break;
+      memset(fill, 0, (size_t)n * sizeof(int));
+    }
+    for (int b = 0; b < n; ++b)
+      seen[b] = -1;
+    for (int b = 0; b < n; ++b) {
+      const ny_nir_block_t *blk = &cfg->blocks[b];
+      if (!ny_nir_cfg_reachable(cfg, b))
+        continue;
+      for (int p = 0; p < blk->pred_count; ++p) {
+        int runner = blk->preds[p];
+        if (!ny_nir_cfg_reachable(cfg, runner))
+          continue;
+        while (runner >= 0 && runner != blk->idom && seen[runner] != b) {
+          seen[runner] = b;
+          if (pass == 1)
+            list[start[runner] + fill[runner]] = b;
+          fill[runner]++;
+          runner = cfg->blocks[runner].idom;
+        }
+      }
+    }
+  }
+  free(fill);
+  free(seen);
+  if (!ok) {
+    free(start);
+    free(list);
+    return false;
+  }
+  *out_start = start;
+  *out_list = list;
+  return true;
+}
+
+/* Promotes the integer slots still read after forwarding. Phis go on the
+ * iterated dominance frontier of each slot's stores, pruned to blocks where
+ * the slot is live on entry, and a walk of the dominator tree turns loads
+ * into copies of the reaching value. A parameter slot enters as a load at
+ * the top of the function, and a slot that was read before its first store
+ * keeps that load so the backends still see the same parameters; any other
+ * slot starts out as zero.
+ * Unlabelled predecessors of a phi block get a fresh label so each phi entry
+ * can name its edge. */
+static bool nir_mem2reg_promote(ny_nir_func_t *f) {
+  nir_ssa_info_t info;
+  if (!nir_ssa_info_init(&info, f))
+    return false;
+  size_t slots = info.local_count;
+  if (slots == 0) {
+    nir_ssa_info_free(&info);
+    return true;
+  }
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    nir_ssa_info_free(&info);
+    return false;
+  }
+  size_t blocks = (size_t)cfg.block_count;
+  int entry = cfg.rpo[0];
+  bool ok = true;
+  int *cand = NULL, *cand_slot = NULL, *phi = NULL, *work = NULL;
+  int *queued = NULL, *df_start = NULL, *df_list = NULL, *order = NULL;
+  int *out_val = NULL, *cur = NULL, *phi_block = NULL, *phi_cand = NULL;
+  int **phi_args = NULL;
+  int64_t **phi_lbls = NULL;
+  int64_t *new_label = NULL;
+  size_t *phi_len = NULL;
+  bool *ue = NULL, *kill = NULL, *live = NULL, *entry_used = NULL;
+  ny_nir_inst_t *data = NULL;
+  size_t phi_count = 0;
+
+  /* Phis cannot go in the entry block, and a replacement value must be
+   * defined ahead of its uses in the list, so give up on CFGs where a block
+   * precedes its immediate dominator. */
+  for (int p = 0; p < cfg.blocks[entry].pred_count; ++p) {
+    if (ny_nir_cfg_reachable(&cfg, cfg.blocks[entry].preds[p]))
+      goto done;
+  }
+  for (int r = 1; r < cfg.rpo_count; ++r) {
+    const ny_nir_block_t *blk = &cfg.blocks[cfg.rpo[r]];
+    if (cfg.blocks[blk->idom].start >= blk->start)
+      goto done;
+  }
+
+  cand = (int *)malloc(slots * sizeof(int));
+  cand_slot = (int *)malloc(slots * sizeof(int));
+  if (!(ok = cand && cand_slot))
+    goto done;
+  /* Backends size the parameter block by the highest slot read before any
+   * store to it; every slot below that arrives from the caller. cand marks
+   * the stored slots for the moment. */
+  int64_t params = 0;
+  for (size_t l = 0; l < slots; ++l)
+    cand[l] = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->imm < 0 || (size_t)in->imm >= slots)
+      continue;
+    if (in->op == NY_NIR_STORE_LOCAL)
+      cand[in->imm] = 0;
+    else if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NYIR_ADDR_LOCAL) &&
+             cand[in->imm] < 0 && in->imm + 1 > params)
+      params = in->imm + 1;
+  }
+  for (size_t l = 0; l < slots; ++l)
+    cand[l] = -1;
+  size_t cands = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NY_NIR_LOAD_LOCAL && nir_ssa_int_slot(&info, in->imm) &&
+        cand[in->imm] < 0 && ny_nir_cfg_reachable(&cfg, cfg.block_of[i])) {
+      cand_slot[cands] = (int)in->imm;
+      cand[in->imm] = (int)cands++;
+    }
+  }
+  if (cands == 0 || blocks > NIR_SSA_STATE_LIMIT / cands)
+    goto done;
+
+  size_t cells = blocks * cands;
+  ue = (bool *)calloc(cells, sizeof(bool));
+  kill = (bool *)calloc(cells, sizeof(bool));
+  live = (bool *)calloc(cells, sizeof(bool));
+  phi = (int *)malloc(cells * sizeof(int));
+  out_val = (int *)malloc(cells * sizeof(int));
+  work = (int *)malloc(blocks * sizeof(int));
+  queued = (int *)malloc(blocks * sizeof(int));
+  order = (int *)malloc(2 * blocks * sizeof(int));
+  new_label = (int64_t *)malloc(blocks * sizeof(int64_t));
+  cur = (int *)malloc(cands * sizeof(int));
+  entry_used = (bool *)calloc(cands, sizeof(bool));
+  if (!(ok = ue && kill && live && phi && out_val && work && queued &&
+             order && new_label && cur && entry_used))
+    goto done;
+
+  /* Upward-exposed loads and stores per block, then live-in to a fixpoint. */
+  for (int r = 0; r < cfg.rpo_count; ++r) {
+    int b = cfg.rpo[r];
+    for (size_t i = cfg.blocks[b].start; i < cfg.blocks[b].end; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if ((in->op != NY_NIR_LOAD_LOCAL && in->op != NY_NIR_STORE_LOCAL) ||
+          !nir_ssa_slot(&info, in->imm) || cand[in->imm] < 0)
+        continue;
+      size_t cell = (size_t)b * cands + (size_t)cand[in->imm];
+      if (in->op == NY_NIR_STORE_LOCAL)
+        kill[cell] = true;
+      else if (!kill[cell])
+        ue[cell] = true;
+    }
+  }
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (int r = cfg.rpo_count - 1; r >= 0; --r) {
+      int b = cfg.rpo[r];
+      const ny_nir_block_t *blk = &cfg.blocks[b];
+      for (size_t c = 0; c < cands; ++c) {
+        size_t cell = (size_t)b * cands + c;
+        bool out = false;
+        for (int s = 0; s < blk->succ_count && !out; ++s)
+          out = live[(size_t)blk->succ[s] * cands + c];
+        bool in = ue[cell] || (out && !kill[cell]);
+        if (in != live[cell]) {
+          live[cell] = in;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  if (!(ok = nir_dom_frontiers(&cfg, &df_start, &df_list)))
+    goto done;
+  for (size_t k = 0; k < cells; ++k)
+    phi[k] = -1;
+  for (size_t b = 0; b < blocks; ++b) {
+    queued[b] = -1;
+    new_label[b] = -1;
+  }
+  for (size_t c = 0; c < cands; ++c) {
+    size_t top = 0;
+    for (int r = 0; r < cfg.rpo_count; ++r) {
+      int b = cfg.rpo[r];
+      if (kill[(size_t)b * cands + c]) {
+        queued[b] = (int)c;
+        work[top++] = b;
+      }
+    }
+    while (top > 0) {
+      int d = work[--top];
+      for (int k = df_start[d]; k < df_start[d + 1]; ++k) {
+        int y = df_list[k];
+        size_t cell = (size_t)y * cands + c;
+        if (phi[cell] >= 0 || !live[cell])
+          continue;
+        if (ny_nir_cfg_block_label(&cfg, f, y) < 0)
+          goto done; /* a join every predecessor reaches by fallthrough */
+        phi[cell] = (int)phi_count++;
+        if (queued[y] != (int)c) {
+          queued[y] = (int)c;
+          work[top++] = y;
+        }
+      }
+    }
+  }
+  if (phi_count == 0)
+    goto done;
+
+  /* Fresh labels for unlabelled predecessors of the phi blocks. */
+  int64_t max_label = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if ((in->op == NY_NIR_LABEL || in->op == NY_NIR_BR ||
+         in->op == NY_NIR_BR_IF) &&
+        in->imm > max_label)
+      max_label = in->imm;
+    for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k) {
+      if (in->phi_labels[k] > max_label)
+        max_label = in->phi_labels[k];
+    }
+  }
+  size_t label_count = 0;
+  phi_block = (int *)malloc(phi_count * sizeof(int));
+  phi_cand = (int *)malloc(phi_count * sizeof(int));
+  phi_args = (int **)calloc(phi_count, sizeof(*phi_args));
+  phi_lbls = (int64_t **)calloc(phi_count, sizeof(*phi_lbls));
+  phi_len = (size_t *)malloc(phi_count * sizeof(size_t));
+  if (!(ok = phi_block && phi_cand && phi_args && phi_lbls && phi_len))
+    goto done;
+  for (int r = 0; r < cfg.rpo_count; ++r) {
+    int y = cfg.rpo[r];
+    const ny_nir_block_t *blk = &cfg.blocks[y];
+    for (size_t c = 0; c < cands; ++c) {
+      int id = phi[(size_t)y * cands + c];
+      if (id < 0)
+        continue;
+      phi_block[id] = y;
+      phi_cand[id] = (int)c;
+      phi_args[id] = (int *)malloc((size_t)blk->pred_count * sizeof(int));
+      phi_lbls[id] =
+          (int64_t *)malloc((size_t)blk->pred_count * sizeof(int64_t));
+      if (!(ok = phi_args[id] && phi_lbls[id]))
+        goto done;
+      for (int p = 0; p < blk->pred_count; ++p) {
+        int pred = blk->preds[p];
+        if (ny_nir_cfg_reachable(&cfg, pred) &&
+            ny_nir_cfg_block_label(&cfg, f, pred) < 0 &&
+            new_label[pred] < 0) {
+          new_label[pred] = ++max_label;
+          label_count++;
+        }
+      }
+    }
+  }
+  size_t cap = f->len + cands + label_count + phi_count;
+  data = (ny_nir_inst_t *)malloc(cap * sizeof(*data));
+  if (!(ok = data != NULL))
+    goto done;
+
+  /* Rename in dominator-tree preorder: a block's incoming value is its phi
+   * or whatever leaves its immediate dominator. Nothing below can fail, so
+   * the function is rewritten in place from here on. */
+  int phi_base = f->next_value;
+  int entry_base = phi_base + (int)phi_count;
+  for (size_t k = 0; k < 2 * blocks; ++k)
+    order[k] = -1;
+  for (int r = 0; r < cfg.rpo_count; ++r)
+    order[cfg.blocks[cfg.rpo[r]].dom_pre] = cfg.rpo[r];
+  for (size_t k = 0; k < 2 * blocks; ++k) {
+    int b = order[k];
+    if (b < 0)
+      continue;
+    const ny_nir_block_t *blk = &cfg.blocks[b];
+    for (size_t c = 0; c < cands; ++c) {
+      int id = phi[(size_t)b * cands + c];
+      if (b == entry)
+        cur[c] = entry_base + (int)c;
+      else
+        cur[c] = id >= 0 ? phi_base + id
+                         : out_val[(size_t)blk->idom * cands + c];
+    }
+    for (size_t i = blk->start; i < blk->end; ++i) {
+      ny_nir_inst_t *in = &f->data[i];
+      if ((in->op != NY_NIR_LOAD_LOCAL && in->op != NY_NIR_STORE_LOCAL) ||
+          !nir_ssa_slot(&info, in->imm) || cand[in->imm] < 0)
+        continue;
+      int c = cand[in->imm];
+      if (in->op == NY_NIR_STORE_LOCAL) {
+        cur[c] = in->a;
+        ny_nir_inst_discard(in);
+        continue;
+      }
+      if (cur[c] >= entry_base)
+        entry_used[cur[c] - entry_base] = true;
+      nir_make_copy(in, cur[c]);
+    }
+    memcpy(&out_val[(size_t)b * cands], cur, cands * sizeof(int));
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    ny_nir_inst_t *in = &f->data[i];
+    if (ny_nir_cfg_reachable(&cfg, cfg.block_of[i]) ||
+        (in->op != NY_NIR_LOAD_LOCAL && in->op != NY_NIR_STORE_LOCAL) ||
+        !nir_ssa_slot(&info, in->imm) || cand[in->imm] < 0)
+      continue;
+    if (in->op == NY_NIR_STORE_LOCAL)
+      ny_nir_inst_discard(in);
+    else
+      nir_make_const(in, 0);
+  }
+  for (size_t id = 0; id < phi_count; ++id) {
+    const ny_nir_block_t *blk = &cfg.blocks[phi_block[id]];
+    size_t n = 0;
+    for (int p = 0; p < blk->pred_count; ++p) {
+      int pred = blk->preds[p];
+      if (!ny_nir_cfg_reachable(&cfg, pred))
+        continue;
+      int64_t label = ny_nir_cfg_block_label(&cfg, f, pred);
+      int v = out_val[(size_t)pred * cands + (size_t)phi_cand[id]];
+      if (v >= entry_base)
+        entry_used[v - entry_base] = true;
+      phi_args[id][n] = v;
+      phi_lbls[id][n++] = label >= 0 ? label : new_label[pred];
+    }
+    phi_len[id] = n;
+  }
+
+  /* Rebuild: entry values first, fresh labels at the head of their blocks
+   * and the new phis right after their block's label. */
+  size_t out = 0;
+  for (size_t c = 0; c < cands; ++c) {
+    int64_t slot = cand_slot[c];
+    bool read_first = info.first_load[slot] >= 0 &&
+                      (info.first_store[slot] < 0 ||
+                       info.first_load[slot] < info.first_store[slot]);
+    if (read_first || (slot < params && entry_used[c]))
+      data[out++] = nir_new_inst(NY_NIR_LOAD_LOCAL, entry_base + (int)c, -1,
+                                 -1, slot);
+    else if (entry_used[c])
+      data[out++] =
+          nir_new_inst(NY_NIR_CONST_I64, entry_base + (int)c, -1, -1, 0);
+  }
+  for (size_t i = 0; i < f->len; ++i) {
+    int b = cfg.block_of[i];
+    bool head = cfg.blocks[b].start == i && ny_nir_cfg_reachable(&cfg, b);
+    if (head && new_label[b] >= 0)
+      data[out++] = nir_new_inst(NY_NIR_LABEL, -1, -1, -1, new_label[b]);
+    data[out++] = f->data[i];
+    if (!head || f->data[i].op != NY_NIR_LABEL)
+      continue;
+    for (size_t c = 0; c < cands; ++c) {
+      int id = phi[(size_t)b * cands + c];
+      if (id < 0)
+        continue;
+      ny_nir_inst_t in = nir_new_inst(NYIR_PHI, phi_base + id, -1, -1, 0);
+      in.extra_args = phi_args[id];
+      in.phi_labels = phi_lbls[id];
+      in.extra_args_len = phi_len[id];
+      in.debug = f->data[i].debug;
+      phi_args[id] = NULL;
+      phi_lbls[id] = NULL;
+      data[out++] = in;
+    }
+  }
+  free(f->data);
+  f->data = data;
+  f->len = out;
+  f->cap = cap;
+  f->next_value = entry_base + (int)cands;
+  data = NULL;
+
+done:
+  for (size_t id = 0; phi_args && id < phi_count; ++id)
+    free(phi_args[id]);
+  for (size_t id = 0; phi_lbls && id < phi_count; ++id)
+    free(phi_lbls[id]);
+  free(phi_args);
+  free(phi_lbls);
+  free(phi_block);
+  free(phi_cand);
+  free(phi_len);
+  free(data);
+  free(cand);
+  free(cand_slot);
+  free(ue);
+  free(kill);
+  free(live);
+  free(phi);
+  free(out_val);
+  free(work);
+  free(queued);
+  free(order);
+  free(new_label);
+  free(cur);
+  free(entry_used);
+  free(df_start);
+  free(df_list);
+  ny_nir_cfg_free(&cfg);
+  nir_ssa_info_free(&info);
+  return ok;
+}
+
+bool ny_nir_mem2reg(ny_nir_func_t *f) {
+  if (!f || f->len == 0 || f->next_value <= 0)
+    return true;
+  if (!nir_mem2reg_forward(f) || !nir_mem2reg_promote(f))
+    return false;
+  for (int round = 0; round < NIR_LOOP_ROUND_LIMIT && ny_nir_phi_prune(f);
+       ++round) {
+  }
+  return true;
+}
+
+typedef struct {
+  uint64_t hash;
+  int inst;
+  int next;
+} nir_gvn_entry_t;
+
+static bool nir_gvn_candidate(const ny_nir_inst_t *in) {
+  if (in->dst < 0)
+    return false;
+  switch (in->op) {
+  case NY_NIR_ADD_I64:
+  case NY_NIR_SUB_I64:
+  case NY_NIR_MUL_I64:
+  case NY_NIR_DIV_I64:
+  case NY_NIR_MOD_I64:
+  case NY_NIR_AND_I64:
+  case NY_NIR_OR_I64:
+  case NY_NIR_XOR_I64:
+  case NY_NIR_SHL_I64:
+  case NY_NIR_SAR_I64:
+  case NY_NIR_CMP_I64:
+  case NYIR_ADD_F64:
+  case NYIR_SUB_F64:
+  case NYIR_MUL_F64:
+  case NYIR_DIV_F64:
+  case NYIR_I64_TO_F64:
+  case NYIR_CMP_F64:
+  case NYIR_ADD_F32:
+  case NYIR_SUB_F32:
+  case NYIR_MUL_F32:
+  case NYIR_DIV_F32:
+  case NYIR_I64_TO_F32:
+  case NYIR_F64_TO_F32:
+  case NYIR_F32_TO_F64:
+  case NYIR_CMP_F32:
+  case NYIR_ADDR_SYMBOL:
+  case NYIR_ADDR_LOCAL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool nir_gvn_commutes(const ny_nir_inst_t *in) {
+  switch (in->op) {
+  case NY_NIR_ADD_I64:
+  case NY_NIR_MUL_I64:
+  case NY_NIR_AND_I64:
+  case NY_NIR_OR_I64:
+  case NY_NIR_XOR_I64:
+    return true;
+  case NY_NIR_CMP_I64:
+    return in->cmp == NY_NIR_CMP_EQ || in->cmp == NY_NIR_CMP_NE;
+  default:
+    return false;
+  }
+}
+
+static void nir_gvn_operands(const ny_nir_inst_t *in, const int *leader,
+                             int *a, int *b) {
+  *a = in->a >= 0 ? leader[in->a] : -1;
+  *b = in->b >= 0 ? leader[in->b] : -1;
+  if (nir_gvn_commutes(in) && *a > *b) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+  }
+}
+
+static uint64_t nir_gvn_hash(const ny_nir_inst_t *in, int a, int b) {
+  uint64_t h = 1469598103934665603ull;
+  uint64_t parts[5] = {(uint64_t)in->op, (uint64_t)(int64_t)a,
+                       (uint64_t)(int64_t)b, (uint64_t)in->imm,
+                       (uint64_t)in->cmp};
+  for (size_t i = 0; i < 5; ++i)
+    h = (h ^ parts[i]) * 1099511628211ull;
+  for (const char *s = in->symbol; s && *s; ++s)
+    h = (h ^ (unsigned char)*s) * 1099511628211ull;
+  return h;
+}
+
+static bool nir_gvn_same(const ny_nir_inst_t *x, const ny_nir_inst_t *y,
+                         const int *leader) {
+  int xa, xb, ya, yb;
+  nir_gvn_operands(x, leader, &xa, &xb);
+  nir_gvn_operands(y, leader, &ya, &yb);
+  if (x->op != y->op || xa != ya || xb != yb || x->imm != y->imm ||
+      x->cmp != y->cmp)
+    return false;
+  if (!x->symbol || !y->symbol)
+    return x->symbol == y->symbol;
+  return strcmp(x->symbol, y->symbol) == 0;
+}
+
+/* Global value numbering: an instruction recomputing a pure expression whose
+ * earlier instance dominates it becomes a copy of that instance. */
+bool ny_nir_gvn(ny_nir_func_t *f) {
+  if (!f || f->len == 0 || f->next_value <= 0)
+    return true;
+  nir_ssa_info_t info;
+  if (!nir_ssa_info_init(&info, f))
+    return false;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    nir_ssa_info_free(&info);
+    return false;
+  }
+  size_t bucket_count = 16;
+  while (bucket_count < f->len * 2)
+    bucket_count *= 2;
+  int *leader = (int *)malloc((size_t)f->next_value * sizeof(int));
+  int *buckets = (int *)malloc(bucket_count * sizeof(int));
+  nir_gvn_entry_t *entries =
+      (nir_gvn_entry_t *)malloc(f->len * sizeof(*entries));
+  bool ok = leader && buckets && entries;
+  if (ok) {
+    for (int v = 0; v < f->next_value; ++v)
+      leader[v] = v;
+    for (size_t k = 0; k < bucket_count; ++k)
+      buckets[k] = -1;
+    int entry_count = 0;
+    for (size_t i = 0; i < f->len; ++i) {
+      ny_nir_inst_t *in = &f->data[i];
+      if (!nir_gvn_candidate(in) ||
+          !ny_nir_cfg_reachable(&cfg, cfg.block_of[i]))
+        continue;
+      int a, b;
+      nir_gvn_operands(in, leader, &a, &b);
+      uint64_t h = nir_gvn_hash(in, a, b);
+      size_t bucket = (size_t)(h & (bucket_count - 1));
+      int found = -1;
+      for (int e = buckets[bucket]; e >= 0; e = entries[e].next) {
+        const ny_nir_inst_t *prev = &f->data[entries[e].inst];
+        if (entries[e].hash == h && nir_gvn_same(prev, in, leader) &&
+            nir_ssa_same_type(&info, prev->dst, in->dst) &&
+            ny_nir_cfg_value_dominates(&cfg, prev->dst, i)) {
+          found = prev->dst;
+          break;
+        }
+      }
+      if (found >= 0) {
+        leader[in->dst] = found;
+        nir_make_copy(in, found);
+        continue;
+      }
+      entries[entry_count] = (nir_gvn_entry_t){
+          .hash = h, .inst = (int)i, .next = buckets[bucket]};
+      buckets[bucket] = entry_count++;
+    }
+  }
+  free(leader);
+  free(buckets);
+  free(entries);
+  ny_nir_cfg_free(&cfg);
+  nir_ssa_info_free(&info);
+  return ok;
+}
+
+/* Where code hoisted out of a loop goes: the end of the preheader, before
+ * its branch. Returns false when the loop has no usable preheader. */
+static bool nir_loop_insert_point(const ny_nir_func_t *f,
+                                  const ny_nir_cfg_t *cfg,
+                                  const ny_nir_loop_t *loop, size_t *pos) {
+  if (loop->preheader < 0)
+    return false;
+  const ny_nir_block_t *pre = &cfg->blocks[loop->preheader];
+  const ny_nir_block_t *hdr = &cfg->blocks[loop->header];
+  if (pre->end > hdr->start)
+    return false;
+  ny_nir_op_t last = f->data[pre->end - 1].op;
+  *pos = last == NY_NIR_BR || last == NY_NIR_BR_IF ? pre->end - 1 : pre->end;
+  return true;
+}
+
+static bool nir_loop_invariant(const ny_nir_cfg_t *cfg,
+                               const ny_nir_loop_t *loop, const bool *hoisted,
+                               int v, size_t pos) {
+  if (v < 0)
+    return true;
+  if ((size_t)v >= cfg->value_count)
+    return false;
+  if (hoisted && hoisted[v])
+    return true;
+  int def = cfg->def_index[v];
+  return def >= 0 && (size_t)def < pos && !loop->member[cfg->block_of[def]];
+}
+
+static bool nir_licm_speculable(const ny_nir_func_t *f,
+                                const ny_nir_cfg_t *cfg,
+                                const ny_nir_inst_t *in) {
+  int64_t k = 0;
+  switch (in->op) {
+  case NY_NIR_CONST_I64:
+  case NY_NIR_COPY:
+  case NY_NIR_ADD_I64:
+  case NY_NIR_SUB_I64:
+  case NY_NIR_MUL_I64:
+  case NY_NIR_AND_I64:
+  case NY_NIR_OR_I64:
+  case NY_NIR_XOR_I64:
+  case NY_NIR_CMP_I64:
+  case NYIR_CONST_F64:
+  case NYIR_ADD_F64:
+  case NYIR_SUB_F64:
+  case NYIR_MUL_F64:
+  case NYIR_DIV_F64:
+  case NYIR_I64_TO_F64:
+  case NYIR_CMP_F64:
+  case NYIR_CONST_F32:
+  case NYIR_ADD_F32:
+  case NYIR_SUB_F32:
+  case NYIR_MUL_F32:
+  case NYIR_DIV_F32:
+  case NYIR_I64_TO_F32:
+  case NYIR_F64_TO_F32:
+  case NYIR_F32_TO_F64:
+  case NYIR_CMP_F32:
+  case NYIR_ADDR_SYMBOL:
+  case NYIR_ADDR_LOCAL:
+    return true;
+  case NY_NIR_DIV_I64:
+  case NY_NIR_MOD_I64:
+    /* Hoisting runs the division even when the loop body would not. */
+    return nir_const_def(f, cfg, in->b, &k) && k != 0 && k != -1;
+  case NY_NIR_SHL_I64:
+  case NY_NIR_SAR_I64:
+    return nir_const_def(f, cfg, in->b, &k) && k >= 0 && k < 64;
+  default:
+    return false;
+  }
+}
+
+static bool nir_move_before(ny_nir_func_t *f, const size_t *moved,
+                            size_t moved_count, size_t pos) {
+  ny_nir_inst_t *data = (ny_nir_inst_t *)malloc(f->len * sizeof(*data));
+  bool *skip = (bool *)calloc(f->len, sizeof(bool));
+  if (!data || !skip) {
+    free(data);
+    free(skip);
+    return false;
+  }
+  for (size_t k = 0; k < moved_count; ++k)
+    skip[moved[k]] = true;
+  size_t out = 0;
+  for (size_t i = 0; i < pos; ++i) {
+    if (!skip[i])
+      data[out++] = f->data[i];
+  }
+  for (size_t k = 0; k < moved_count; ++k)
+    data[out++] = f->data[moved[k]];
+  for (size_t i = pos; i < f->len; ++i) {
+    if (!skip[i])
+      data[out++] = f->data[i];
+  }
+  memcpy(f->data, data, f->len * sizeof(*data));
+  free(data);
+  free(skip);
+  return true;
+}
+
+static int nir_loop_order_cmp(const void *lhs, const void *rhs) {
+  const ny_nir_loop_t *a = (const ny_nir_loop_t *)lhs;
+  const ny_nir_loop_t *b = (const ny_nir_loop_t *)rhs;
+  if (a->block_count != b->block_count)
+    return a->block_count - b->block_count;
+  return a->header - b->header;
+}
+
+/* One LICM round: hoists the invariant instructions of the innermost loop
+ * that has any. Returns 1 when the function changed, 0 when nothing moved
+ * and -1 on allocation failure. */
+static int nir_licm_round(ny_nir_func_t *f) {
+  nir_ssa_info_t info;
+  if (!nir_ssa_info_init(&info, f))
+    return -1;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    nir_ssa_info_free(&info);
+    return -1;
+  }
+  ny_nir_loop_t *loops = NULL;
+  size_t loop_count = 0;
+  if (!ny_nir_cfg_loops(&cfg, &loops, &loop_count)) {
+    ny_nir_cfg_free(&cfg);
+    nir_ssa_info_free(&info);
+    return -1;
+  }
+  if (loop_count > 1)
+    qsort(loops, loop_count, sizeof(*loops), nir_loop_order_cmp);
+  bool *hoisted = (bool *)calloc((size_t)f->next_value + 1, sizeof(bool));
+  bool *stored = (bool *)calloc(info.local_count + 1, sizeof(bool));
+  size_t *moved = (size_t *)malloc((f->len + 1) * sizeof(size_t));
+  int result = hoisted && stored && moved ? 0 : -1;
+  for (size_t l = 0; result == 0 && l < loop_count; ++l) {
+    const ny_nir_loop_t *loop = &loops[l];
+    size_t pos = 0;
+    if (!nir_loop_insert_point(f, &cfg, loop, &pos))
+      continue;
+    memset(hoisted, 0, ((size_t)f->next_value + 1) * sizeof(bool));
+    memset(stored, 0, (info.local_count + 1) * sizeof(bool));
+    for (size_t i = 0; i < f->len; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if (in->op == NY_NIR_STORE_LOCAL && loop->member[cfg.block_of[i]] &&
+          in->imm >= 0 && (size_t)in->imm < info.local_count)
+        stored[in->imm] = true;
+    }
+    size_t moved_count = 0;
+    for (size_t i = 0; i < f->len; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if (in->dst < 0 || !loop->member[cfg.block_of[i]])
+        continue;
+      bool movable = false;
+      if (in->op == NY_NIR_LOAD_LOCAL)
+        movable = nir_ssa_slot(&info, in->imm) && !stored[in->imm] &&
+                  nir_ssa_load_allowed_at(&info, in->imm, pos);
+      else
+        movable = nir_licm_speculable(f, &cfg, in) &&
+                  nir_loop_invariant(&cfg, loop, hoisted, in->a, pos) &&
+                  nir_loop_invariant(&cfg, loop, hoisted, in->b, pos);
+      if (!movable)
+        continue;
+      hoisted[in->dst] = true;
+      moved[moved_count++] = i;
+    }
+    if (moved_count == 0)
+      continue;
+    result = nir_move_before(f, moved, moved_count, pos) ? 1 : -1;
+  }
+  free(hoisted);
+  free(stored);
+  free(moved);
+  ny_nir_cfg_loops_free(loops, loop_count);
+  ny_nir_cfg_free(&cfg);
+  nir_ssa_info_free(&info);
+  return result;
+}
+
+/* Loop-invariant code motion into each loop's preheader. Pure instructions
+ * are speculated; loads of slots the loop never stores move as well. */
+bool ny_nir_licm(ny_nir_func_t *f) {
+  if (!f || f->len == 0 || f->next_value <= 0)
+    return true;
+  for (int round = 0; round < NIR_LOOP_ROUND_LIMIT; ++round) {
+    int r = nir_licm_round(f);
+    if (r < 0)
+      return false;
+    if (r == 0)
+      break;
+  }
+  return true;
+}
+
+/* A basic induction variable: the slot's only store inside the loop writes
+ * its current value plus a constant step, at most once per iteration.
+ * after_store marks the loop blocks reachable from that store without
+ * passing the header again. */
+typedef struct {
+  int64_t slot;
+  size_t store;
+  int64_t step;
+  bool *after_store;
+} nir_iv_t;
+
+static void nir_loop_reach(const ny_nir_cfg_t *cfg, const ny_nir_loop_t *loop,
+                           int from, bool *reach, int *work) {
+  memset(reach, 0, (size_t)cfg->block_count * sizeof(bool));
+  int depth = 0;
+  work[depth++] = from;
+  while (depth > 0) {
+    const ny_nir_block_t *blk = &cfg->blocks[work[--depth]];
+    for (int s = 0; s < blk->succ_count; ++s) {
+      int succ = blk->succ[s];
+      if (succ == loop->header || !loop->member[succ] || reach[succ])
+        continue;
+      reach[succ] = true;
+      work[depth++] = succ;
+    }
+  }
+}
+
+/* Whether the value loaded from an induction variable at load is still the
+ * variable's current value at use, i.e. its store cannot run in between. */
+static bool nir_iv_current_at(const ny_nir_cfg_t *cfg, const nir_iv_t *iv,
+                              size_t load, size_t use) {
+  int load_block = cfg->block_of[load];
+  int use_block = cfg->block_of[use];
+  int store_block = cfg->block_of[iv->store];
+  if (load_block == use_block)
+    return !(store_block == use_block && iv->store > load && iv->store < use);
+  if (store_block == use_block)
+    return iv->store > use;
+  return !iv->after_store[use_block];
+}
+
+static bool nir_basic_iv(const ny_nir_func_t *f, const ny_nir_cfg_t *cfg,
+                         const ny_nir_loop_t *loop, int64_t slot,
+                         size_t store, nir_iv_t *iv) {
+  const ny_nir_inst_t *st = &f->data[store];
+  if (iv->after_store[cfg->block_of[store]])
+    return false; /* the store sits on a cycle inside the loop */
+  if (st->a < 0 || (size_t)st->a >= cfg->value_count ||
+      cfg->def_index[st->a] < 0)
+    return false;
+  const ny_nir_inst_t *upd = &f->data[cfg->def_index[st->a]];
+  if (upd->op != NY_NIR_ADD_I64 && upd->op != NY_NIR_SUB_I64)
+    return false;
+  int operands[2] = {upd->a, upd->b};
+  for (int side = 0; side < 2; ++side) {
+    if (side == 1 && upd->op == NY_NIR_SUB_I64)
+      break;
+    int cur = operands[side];
+    int64_t step = 0;
+    if (cur < 0 || (size_t)cur >= cfg->value_count || cfg->def_index[cur] < 0 ||
+        !nir_const_def(f, cfg, operands[1 - side], &step))
+      continue;
+    size_t load = (size_t)cfg->def_index[cur];
+    const ny_nir_inst_t *ld = &f->data[load];
+    if (ld->op != NY_NIR_LOAD_LOCAL || ld->imm != slot ||
+        !loop->member[cfg->block_of[load]])
+      continue;
+    iv->slot = slot;
+    iv->store = store;
+    iv->step = upd->op == NY_NIR_SUB_I64 ? (int64_t)(0 - (uint64_t)step)
+                                         : step;
+    return true;
+  }
+  return false;
+}
+
+/* A multiply of an induction variable's current value by a constant or a
+ * loop-invariant value. */
+typedef struct {
+  size_t inst;
+  const nir_iv_t *iv;
+  bool const_factor;
+  int64_t factor;
+  int factor_value;
+} nir_iv_use_t;
+
+static bool nir_iv_use(const ny_nir_func_t *f, const ny_nir_cfg_t *cfg,
+                       const ny_nir_loop_t *loop, const nir_ssa_info_t *info,
+                       const nir_iv_t *ivs, size_t iv_count, size_t i,
+                       size_t pos, nir_iv_use_t *use) {
+  const ny_nir_inst_t *in = &f->data[i];
+  if (in->op != NY_NIR_MUL_I64 || !nir_ssa_int_value(info, in->dst))
+    return false;
+  int operands[2] = {in->a, in->b};
+  for (int side = 0; side < 2; ++side) {
+    int cur = operands[side];
+    int other = operands[1 - side];
+    if (cur < 0 || (size_t)cur >= cfg->value_count || cfg->def_index[cur] < 0)
+      continue;
+    size_t load = (size_t)cfg->def_index[cur];
+    const ny_nir_inst_t *ld = &f->data[load];
+    if (ld->op != NY_NIR_LOAD_LOCAL || !loop->member[cfg->block_of[load]])
+      continue;
+    for (size_t k = 0; k < iv_count; ++k) {
+      const nir_iv_t *iv = &ivs[k];
+      if (iv->slot != ld->imm || !nir_iv_current_at(cfg, iv, load, i))
+        continue;
+      nir_iv_use_t cand = {.inst = i, .iv = iv, .factor_value = -1};
+      if (nir_const_def(f, cfg, other, &cand.factor)) {
+        cand.const_factor = true;
+        /* Power-of-two factors are already a single shift. */
+        uint64_t m = (uint64_t)cand.factor;
+        if (m == 0 || (m & (m - 1)) == 0)
+          continue;
+      } else if (nir_loop_invariant(cfg, loop, NULL, other, pos) &&
+                 nir_ssa_int_value(info, other)) {
+        cand.factor_value = other;
+      } else {
+        continue;
+      }
+      *use = cand;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool nir_iv_same_family(const nir_iv_use_t *a, const nir_iv_use_t *b) {
+  if (a->iv != b->iv || a->const_factor != b->const_factor)
+    return false;
+  return a->const_factor ? a->factor == b->factor
+                         : a->factor_value == b->factor_value;
+}
+
+/* Rewrites every multiply in one (variable, factor) family to read a new
+ * slot that tracks variable * factor: the preheader initialises it and the
+ * variable's update bumps it by step * factor. */
+static bool nir_iv_reduce(ny_nir_func_t *f, const nir_iv_use_t *uses,
+                          size_t use_count, size_t pos, int64_t slot) {
+  const nir_iv_use_t *first = &uses[0];
+  for (size_t k = 0; k < use_count; ++k) {
+    ny_nir_inst_t *in = &f->data[uses[k].inst];
+    *in = nir_new_inst(NY_NIR_LOAD_LOCAL, in->dst, -1, -1, slot);
+  }
+
+  ny_nir_inst_t pre[7];
+  size_t pre_len = 0;
+  int cur = f->next_value++;
+  int factor = first->factor_value;
+  pre[pre_len++] = nir_new_inst(NY_NIR_LOAD_LOCAL, cur, -1, -1, first->iv->slot);
+  if (first->const_factor) {
+    factor = f->next_value++;
+    pre[pre_len++] = nir_new_inst(NY_NIR_CONST_I64, factor, -1, -1,
+                                  first->factor);
+  }
+  int scaled = f->next_value++;
+  pre[pre_len++] = nir_new_inst(NY_NIR_MUL_I64, scaled, cur, factor, 0);
+  pre[pre_len++] = nir_new_inst(NY_NIR_STORE_LOCAL, -1, scaled, -1, slot);
+  int delta = f->next_value++;
+  if (first->const_factor) {
+    pre[pre_len++] = nir_new_inst(
+        NY_NIR_CONST_I64, delta, -1, -1,
+        (int64_t)((uint64_t)first->iv->step * (uint64_t)first->factor));
+  } else {
+    int step = f->next_value++;
+    pre[pre_len++] = nir_new_inst(NY_NIR_CONST_I64, step, -1, -1,
+                                  first->iv->step);
+    pre[pre_len++] = nir_new_inst(NY_NIR_MUL_I64, delta, step, factor, 0);
+  }
+
+  ny_nir_inst_t bump[3];
+  int old = f->next_value++;
+  int next = f->next_value++;
+  bump[0] = nir_new_inst(NY_NIR_LOAD_LOCAL, old, -1, -1, slot);
+  bump[1] = nir_new_inst(NY_NIR_ADD_I64, next, old, delta, 0);
+  bump[2] = nir_new_inst(NY_NIR_STORE_LOCAL, -1, next, -1, slot);
+
+  size_t store = first->iv->store;
+  return nir_insert_at(f, store + 1, bump, 3) &&
+         nir_insert_at(f, pos, pre, pre_len);
+}
+
+/* One strength-reduction round over the innermost loop with a reducible
+ * multiply. Returns 1 on change, 0 when nothing applied, -1 on failure. */
+static int nir_strength_reduce_round(ny_nir_func_t *f) {
+  nir_ssa_info_t info;
+  if (!nir_ssa_info_init(&info, f))
+    return -1;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f)) {
+    nir_ssa_info_free(&info);
+    return -1;
+  }
+  ny_nir_loop_t *loops = NULL;
+  size_t loop_count = 0;
+  if (!ny_nir_cfg_loops(&cfg, &loops, &loop_count)) {
+    ny_nir_cfg_free(&cfg);
+    nir_ssa_info_free(&info);
+    return -1;
+  }
+  if (loop_count > 1)
+    qsort(loops, loop_count, sizeof(*loops), nir_loop_order_cmp);
+  size_t slots = info.local_count;
+  size_t blocks = (size_t)cfg.block_count;
+  if (loop_count == 0 || slots == 0 || blocks > NIR_SSA_STATE_LIMIT / slots) {
+    ny_nir_cfg_loops_free(loops, loop_count);
+    ny_nir_cfg_free(&cfg);
+    nir_ssa_info_free(&info);
+    return 0;
+  }
+  int *store_count = (int *)calloc(slots, sizeof(int));
+  size_t *store_at = (size_t *)calloc(slots, sizeof(size_t));
+  nir_iv_t *ivs = (nir_iv_t *)malloc(slots * sizeof(*ivs));
+  bool *reach = (bool *)malloc(slots * blocks * sizeof(bool));
+  int *work = (int *)malloc(blocks * sizeof(int));
+  nir_iv_use_t *uses = (nir_iv_use_t *)malloc(f->len * sizeof(*uses));
+  int result = store_count && store_at && ivs && reach && work && uses ? 0 : -1;
+  for (size_t l = 0; result == 0 && l < loop_count; ++l) {
+    const ny_nir_loop_t *loop = &loops[l];
+    size_t pos = 0;
+    if (!nir_loop_insert_point(f, &cfg, loop, &pos))
+      continue;
+    memset(store_count, 0, slots * sizeof(int));
+    for (size_t i = 0; i < f->len; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if (in->op != NY_NIR_STORE_LOCAL || !loop->member[cfg.block_of[i]] ||
+          in->imm < 0 || (size_t)in->imm >= slots)
+        continue;
+      store_count[in->imm]++;
+      store_at[in->imm] = i;
+    }
+    size_t iv_count = 0;
+    for (size_t s = 0; s < slots; ++s) {
+      if (store_count[s] != 1 || !nir_ssa_int_slot(&info, (int64_t)s) ||
+          !nir_ssa_load_allowed_at(&info, (int64_t)s, pos))
+        continue;
+      nir_iv_t *iv = &ivs[iv_count];
+      iv->after_store = &reach[iv_count * blocks];
+      nir_loop_reach(&cfg, loop, cfg.block_of[store_at[s]], iv->after_store,
+                     work);
+      if (nir_basic_iv(f, &cfg, loop, (int64_t)s, store_at[s], iv))
+        iv_count++;
+    }
+    if (iv_count == 0)
+      continue;
+    size_t use_count = 0;
+    for (size_t i = 0; i < f->len; ++i) {
+      nir_iv_use_t use;
+      if (!loop->member[cfg.block_of[i]] ||
+          !nir_iv_use(f, &cfg, loop, &info, ivs, iv_count, i, pos, &use))
+        continue;
+      if (use_count == 0 || nir_iv_same_family(&uses[0], &use))
+        uses[use_count++] = use;
+    }
+    if (use_count == 0)
+      continue;
+    result = nir_iv_reduce(f, uses, use_count, pos, (int64_t)slots) ? 1 : -1;
+  }
+  free(store_count);
+  free(store_at);
+  free(ivs);
+  free(reach);
+  free(work);
+  free(uses);
+  ny_nir_cfg_loops_free(loops, loop_count);
+  ny_nir_cfg_free(&cfg);
+  nir_ssa_info_free(&info);
+  return result;
+}
+
+static bool nir_pow2_factor(const ny_nir_func_t *f, const ny_nir_cfg_t *cfg,
+                            const ny_nir_inst_t *in, int *operand,
+                            int64_t *shift) {
+  if (in->op != NY_NIR_MUL_I64 || in->dst < 0)
+    return false;
+  int operands[2] = {in->a, in->b};
+  for (int side = 0; side < 2; ++side) {
+    int64_t k = 0;
+    if (!nir_const_def(f, cfg, operands[1 - side], &k) || k <= 1 ||
+        ((uint64_t)k & ((uint64_t)k - 1)) != 0)
+      continue;
+    int64_t n = 0;
+    while (((uint64_t)1 << n) != (uint64_t)k)
+      n++;
+    if (operand)
+      *operand = operands[side];
+    *shift = n;
+    return true;
+  }
+  return false;
+}
+
+/* Multiplies by a power of two become shifts. */
+static bool nir_mul_to_shift(ny_nir_func_t *f) {
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return false;
+  size_t count = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    int64_t shift = 0;
+    if (nir_pow2_factor(f, &cfg, &f->data[i], NULL, &shift))
+      count++;
+  }
+  if (count == 0) {
+    ny_nir_cfg_free(&cfg);
+    return true;
+  }
+  ny_nir_inst_t *data =
+      (ny_nir_inst_t *)malloc((f->len + count) * sizeof(*data));
+  if (!data) {
+    ny_nir_cfg_free(&cfg);
+    return false;
+  }
+  size_t out = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    ny_nir_inst_t in = f->data[i];
+    int operand = -1;
+    int64_t shift = 0;
+    if (nir_pow2_factor(f, &cfg, &in, &operand, &shift)) {
+      int amount = f->next_value++;
+      data[out++] = nir_new_inst(NY_NIR_CONST_I64, amount, -1, -1, shift);
+      in = nir_new_inst(NY_NIR_SHL_I64, in.dst, operand, amount, 0);
+    }
+    data[out++] = in;
+  }
+  free(f->data);
+  f->data = data;
+  f->len = out;
+  f->cap = out;
+  ny_nir_cfg_free(&cfg);
+  return true;
+}
+
+/* Strength reduction: power-of-two multiplies become shifts, and multiplies
+ * of a loop's induction variable by a constant or invariant factor become a
+ * running sum updated next to the variable's increment. */
+bool ny_nir_strength_reduce(ny_nir_func_t *f) {
+  if (!f || f->len == 0 || f->next_value <= 0)
+    return true;
+  if (!nir_mul_to_shift(f))
+    return false;
+  for (int round = 0; round < NIR_LOOP_ROUND_LIMIT; ++round) {
+    int r = nir_strength_reduce_round(f);
+    if (r < 0)
+      return false;
+    if (r == 0)
+      break;
+  }
+  return true;
+}
+
+typedef struct {
+  int64_t label;
+  int block;
+} nir_label_block_t;
+
+static int nir_label_block_cmp(const void *lhs, const void *rhs) {
+  int64_t a = ((const nir_label_block_t *)lhs)->label;
+  int64_t b = ((const nir_label_block_t *)rhs)->label;
+  return (a > b) - (a < b);
+}
+
+/* Phi demotion for backends without NY_NATIVE_CAP_NIR_PHI: each phi gets a
+ * fresh slot, every predecessor stores its incoming value just before it
+ * branches or falls through, and the phi becomes a load of the slot. The
+ * slots are zeroed on entry so their first access is a store and they never
+ * count as parameters. */
+bool ny_nir_lower_phis(ny_nir_func_t *f) {
+  if (!f || f->len == 0)
+    return true;
+  size_t phis = 0;
+  size_t entries = 0;
+  size_t labels = 0;
+  int64_t max_local = -1;
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op == NYIR_PHI) {
+      phis++;
+      entries += in->extra_args_len;
+    } else if (in->op == NY_NIR_LABEL) {
+      labels++;
+    } else if ((in->op == NY_NIR_LOAD_LOCAL || in->op == NY_NIR_STORE_LOCAL ||
+                in->op == NYIR_ADDR_LOCAL) &&
+               in->imm > max_local) {
+      max_local = in->imm;
+    }
+  }
+  if (phis == 0)
+    return true;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return false;
+  size_t blocks = (size_t)cfg.block_count;
+  nir_label_block_t *by_label =
+      (nir_label_block_t *)malloc((labels + 1) * sizeof(*by_label));
+  size_t *bucket = (size_t *)calloc(blocks + 1u, sizeof(size_t));
+  int *store_value = (int *)malloc((entries + 1) * sizeof(int));
+  int64_t *store_slot = (int64_t *)malloc((entries + 1) * sizeof(int64_t));
+  size_t cap = f->len + 2 * phis + entries + 1;
+  ny_nir_inst_t *data = (ny_nir_inst_t *)malloc(cap * sizeof(*data));
+  bool ok = by_label && bucket && store_value && store_slot && data;
+  if (!ok)
+    goto done;
+
+  size_t n = 0;
+  for (size_t i = 0; i < f->len; ++i) {
+    if (f->data[i].op == NY_NIR_LABEL)
+      by_label[n++] = (nir_label_block_t){f->data[i].imm, cfg.block_of[i]};
+  }
+  qsort(by_label, labels, sizeof(*by_label), nir_label_block_cmp);
+  /* Bucket the incoming values by predecessor block: count, then place. */
+  for (int pass = 0; pass < 2; ++pass) {
+    int64_t slot = max_local;
+    for (size_t i = 0; i < f->len; ++i) {
+      const ny_nir_inst_t *in = &f->data[i];
+      if (in->op != NYIR_PHI)
+        continue;
+      slot++;
+      for (size_t k = 0; k < in->extra_args_len; ++k) {
+        nir_label_block_t key = {in->phi_labels[k], -1};
+        const nir_label_block_t *hit = (const nir_label_block_t *)bsearch(
+            &key, by_label, labels, sizeof(*by_label), nir_label_block_cmp);
+        if (!hit)
+          continue;
+        size_t b = (size_t)hit->block;
+        if (pass == 0) {
+          bucket[b + 1]++;
+          continue;
+        }
+        store_value[bucket[b]] = in->extra_args[k];
+        store_slot[bucket[b]++] = slot;
+      }
+    }
+    if (pass == 0) {
+      for (size_t b = 0; b < blocks; ++b)
+        bucket[b + 1] += bucket[b];
+    } else {
+      /* Placing advanced each bucket to the next one's start. */
+      memmove(&bucket[1], &bucket[0], blocks * sizeof(size_t));
+      bucket[0] = 0;
+    }
+  }
+
+  int zero = f->next_value;
+  size_t out = 0;
+  data[out++] = nir_new_inst(NY_NIR_CONST_I64, zero, -1, -1, 0);
+  for (size_t k = 0; k < phis; ++k)
+    data[out++] = nir_new_inst(NY_NIR_STORE_LOCAL, -1, zero, -1,
+                               max_local + 1 + (int64_t)k);
+  int64_t slot = max_local;
+  for (size_t i = 0; i < f->len; ++i) {
+    ny_nir_inst_t in = f->data[i];
+    size_t b = (size_t)cfg.block_of[i];
+    bool last = i + 1 == cfg.blocks[b].end;
+    bool branch = in.op == NY_NIR_BR || in.op == NY_NIR_BR_IF;
+    if (in.op == NYIR_PHI) {
+      ny_nir_debug_loc_t debug = in.debug;
+      int dst = in.dst;
+      ny_nir_inst_discard(&in);
+      in = nir_new_inst(NY_NIR_LOAD_LOCAL, dst, -1, -1, ++slot);
+      in.debug = debug;
+    }
+    if (!(last && branch))
+      data[out++] = in;
+    for (size_t k = last ? bucket[b] : 0; last && k < bucket[b + 1]; ++k)
+      data[out++] = nir_new_inst(NY_NIR_STORE_LOCAL, -1, store_value[k], -1,
+                                 store_slot[k]);
+    if (last && branch)
+      data[out++] = in;
+  }
+  free(f->data);
+  f->data = data;
+  f->len = out;
+  f->cap = cap;
+  f->next_value = zero + 1;
+  data = NULL;
+
+done:
+  free(by_label);
+  free(bucket);
+  free(store_value);
+  free(store_slot);
+  free(data);
+  ny_nir_cfg_free(&cfg);
+  return ok;
+}
+
 static bool timed_pass(ny_nir_func_t *f, bool (*pass)(ny_nir_func_t *),
                        double *out_ms) {
   ny_tick_t t0 = ny_ticks_now();
@@ -715,14 +2300,28 @@ static bool timed_pass(ny_nir_func_t *f, bool (*pass)(ny_nir_func_t *),
   return ok;
 }
 
-static const char *pass_names[9] = {
-    "const_fold (1)", "peephole",    "copy_prop", "const_fold (2)",
-    "cfg_simplify",   "dce",         "cfg_simplify (2)", "compact",
-    "total",
+/* The optimizer pipeline, in order. Strength reduction rewrites induction
+ * variables that still live in slots, so it runs ahead of mem2reg. The
+ * trailing pass_names entry is the total reported in the last pass_time_ms
+ * slot. */
+static bool (*const pipeline[NY_NIR_OPT_PASS_COUNT - 1])(ny_nir_func_t *) = {
+    ny_nir_const_fold,      ny_nir_peephole,     ny_nir_licm,
+    ny_nir_strength_reduce, ny_nir_mem2reg,      ny_nir_copy_prop,
+    ny_nir_gvn,             ny_nir_licm,         ny_nir_copy_prop,
+    ny_nir_const_fold,      ny_nir_cfg_simplify, ny_nir_dce,
+    ny_nir_cfg_simplify,    ny_nir_compact,
+};
+
+static const char *pass_names[NY_NIR_OPT_PASS_COUNT] = {
+    "const_fold (1)",   "peephole",     "licm",
+    "strength_reduce",  "mem2reg",      "copy_prop",
+    "gvn",              "licm (2)",     "copy_prop (2)",
+    "const_fold (2)",   "cfg_simplify", "dce",
+    "cfg_simplify (2)", "compact",      "total",
 };
 
 const char *ny_nir_opt_pass_name(int pass) {
-  if (pass < 0 || pass >= 9)
+  if (pass < 0 || pass >= NY_NIR_OPT_PASS_COUNT)
     return "?";
   return pass_names[pass];
 }
@@ -734,34 +2333,29 @@ bool ny_nir_optimize_with_stats(ny_nir_func_t *f, ny_nir_opt_stats_t *stats) {
                          stats->before_ops, NYIR_OP_COUNT);
   }
   double *t = stats ? stats->pass_time_ms : NULL;
-  bool ok =
-      timed_pass(f, ny_nir_const_fold, t ? &t[0] : NULL) &&
-      timed_pass(f, ny_nir_peephole, t ? &t[1] : NULL) &&
-      timed_pass(f, ny_nir_copy_prop, t ? &t[2] : NULL) &&
-      timed_pass(f, ny_nir_const_fold, t ? &t[3] : NULL) &&
-      timed_pass(f, ny_nir_cfg_simplify, t ? &t[4] : NULL) &&
-      timed_pass(f, ny_nir_dce, t ? &t[5] : NULL) &&
-      timed_pass(f, ny_nir_cfg_simplify, t ? &t[6] : NULL) &&
-      timed_pass(f, ny_nir_compact, t ? &t[7] : NULL);
+  const int last = NY_NIR_OPT_PASS_COUNT - 1;
+  bool ok = true;
+  for (int i = 0; ok && i < last; ++i)
+    ok = timed_pass(f, pipeline[i], t ? &t[i] : NULL);
   if (stats) {
     ny_nir_collect_stats(f, &stats->after_insts, &stats->after_values,
                          stats->after_ops, NYIR_OP_COUNT);
-    stats->pass_time_ms[8] = 0;
-    for (int i = 0; i < 8; ++i)
-      stats->pass_time_ms[8] += stats->pass_time_ms[i];
+    stats->pass_time_ms[last] = 0;
+    for (int i = 0; i < last; ++i)
+      stats->pass_time_ms[last] += stats->pass_time_ms[i];
   }
   if (ok)
     ny_nir_refresh_metadata(f);
-  if (verbose_enabled >= 1 && stats && stats->pass_time_ms[8] > 0.001) {
+  if (verbose_enabled >= 1 && stats && stats->pass_time_ms[last] > 0.001) {
     size_t removed = stats->before_insts - stats->after_insts;
     double pct = stats->before_insts > 0
                      ? 100.0 * (double)removed / stats->before_insts
                      : 0.0;
     fprintf(stderr, "nyir opt: %zu->%zu insts (-%zu, %.1f%%) in %.2fms",
             stats->before_insts, stats->after_insts, removed, pct,
-            stats->pass_time_ms[8]);
+            stats->pass_time_ms[last]);
     if (verbose_enabled >= 2) {
-      for (int i = 0; i < 8; ++i)
+      for (int i = 0; i < last; ++i)
         fprintf(stderr, " %s=%.2fms", pass_names[i], stats->pass_time_ms[i]);
     }
     fputc('\n', stderr);
@@ -810,23 +2404,10 @@ bool ny_nir_optimize_debug(ny_nir_func_t *f, FILE *dump,
 
   /* Run with per-pass timing, dump, and verify checkpoints. */
   double *t = stats ? stats->pass_time_ms : NULL;
+  const int last = NY_NIR_OPT_PASS_COUNT - 1;
   bool ok = true;
-  ok = ok && timed_pass_verified(f, ny_nir_const_fold, t ? &t[0] : NULL,
-                                  dump, 0, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_peephole, t ? &t[1] : NULL,
-                                  dump, 1, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_copy_prop, t ? &t[2] : NULL,
-                                  dump, 2, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_const_fold, t ? &t[3] : NULL,
-                                  dump, 3, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_cfg_simplify, t ? &t[4] : NULL,
-                                  dump, 4, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_dce, t ? &t[5] : NULL,
-                                  dump, 5, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_cfg_simplify, t ? &t[6] : NULL,
-                                  dump, 6, &ok);
-  ok = ok && timed_pass_verified(f, ny_nir_compact, t ? &t[7] : NULL,
-                                  dump, 7, &ok);
+  for (int i = 0; ok && i < last; ++i)
+    ok = timed_pass_verified(f, pipeline[i], t ? &t[i] : NULL, dump, i, &ok);
   if (stats) {
     if (!t) {
       /* timing was not collected during passes due to NULL stats; collect now */
@@ -835,19 +2416,19 @@ bool ny_nir_optimize_debug(ny_nir_func_t *f, FILE *dump,
       ny_nir_collect_stats(f, &stats->after_insts, &stats->after_values,
                            stats->after_ops, NYIR_OP_COUNT);
     }
-    stats->pass_time_ms[8] = 0;
-    for (int i = 0; i < 8; ++i)
-      stats->pass_time_ms[8] += stats->pass_time_ms[i];
+    stats->pass_time_ms[last] = 0;
+    for (int i = 0; i < last; ++i)
+      stats->pass_time_ms[last] += stats->pass_time_ms[i];
   }
 
   if (ok)
     ny_nir_refresh_metadata(f);
 
   /* Print pass timings. */
-  if (stats && stats->pass_time_ms[8] > 0.001) {
+  if (stats && stats->pass_time_ms[last] > 0.001) {
     fprintf(dump, "nyir pass timing:");
-    for (int i = 0; i < 9; ++i) {
-      if (i < 8 || stats->pass_time_ms[i] > 0.001)
+    for (int i = 0; i <= last; ++i) {
+      if (i < last || stats->pass_time_ms[i] > 0.001)
         fprintf(dump, " %s=%.2fms", ny_nir_opt_pass_name(i),
                 stats->pass_time_ms[i]);
     }
@@ -34,6 +34,9 @@ bool ny_nir_label_referenced(const ny_nir_func_t *f, int64_t label) {
     const ny_nir_inst_t *in = &f->data[i];
     if ((in->op == NY_NIR_BR || in->op == NY_NIR_BR_IF) && in->imm == label)
       return true;
+    for (size_t k = 0; in->phi_labels && k < in->extra_args_len; ++k)
+      if (in->phi_labels[k] == label)
+        return true;
   }
   return false;
 }
@@ -43,6 +46,156 @@ static unsigned nir_known_effect_mask(void) {
          NY_NIR_EFFECT_CALL | NY_NIR_EFFECT_CONTROL;
 }
 
+static size_t nir_inst_operands(const ny_nir_inst_t *in, int *ops,
+                                size_t cap) {
+  size_t n = 0;
+  switch (in->op) {
+  case NY_NIR_NOP:
+  case NY_NIR_LABEL:
+  case NY_NIR_CONST_I64:
+  case NYIR_CONST_F64:
+  case NYIR_CONST_F32:
+  case NY_NIR_LOAD_LOCAL:
+  case NYIR_ADDR_LOCAL:
+  case NYIR_ADDR_SYMBOL:
+  case NYIR_ALLOCA:
+  case NYIR_CAPTURE_RET:
+  case NY_NIR_BR:
+  case NYIR_PHI: /* checked per edge by nir_verify_phis */
+    break;
+  case NY_NIR_COPY:
+  case NYIR_I64_TO_F64:
+  case NYIR_I64_TO_F32:
+  case NYIR_F64_TO_F32:
+  case NYIR_F32_TO_F64:
+  case NYIR_LOAD_I64:
+  case NY_NIR_STORE_LOCAL:
+  case NY_NIR_RET:
+  case NY_NIR_BR_IF:
+    ops[n++] = in->a;
+    break;
+  case NYIR_STORE_I64:
+    ops[n++] = in->a;
+    ops[n++] = in->c;
+    break;
+  case NY_NIR_CALL: {
+    int regs[6] = {in->a, in->b, in->c, in->d, in->e, in->f};
+    for (int64_t k = 0; k < in->imm && k < 6; ++k)
+      ops[n++] = regs[k];
+    for (size_t k = 0; k < in->extra_args_len && n < cap; ++k)
+      ops[n++] = in->extra_args[k];
+    break;
+  }
+  default:
+    ops[n++] = in->a;
+    ops[n++] = in->b;
+    break;
+  }
+  return n;
+}
+
+/* SSA form: every operand of a reachable instruction is defined in a block
+ * that dominates the use, or earlier in the same block. */
+static bool nir_verify_dominance(const ny_nir_func_t *f, char *err,
+                                 size_t err_len) {
+  if (f->len == 0 || f->next_value <= 0)
+    return true;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return ny_nir_err(err, err_len, "native NYIR verify: out of memory");
+  int ops[NY_NIR_CALL_MAX_ARGS + 2];
+  for (size_t i = 0; i < f->len; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (!ny_nir_cfg_reachable(&cfg, cfg.block_of[i]))
+      continue;
+    size_t n = nir_inst_operands(in, ops, sizeof(ops) / sizeof(ops[0]));
+    for (size_t k = 0; k < n; ++k) {
+      if (ops[k] >= 0 && !ny_nir_cfg_value_dominates(&cfg, ops[k], i)) {
+        ny_nir_cfg_free(&cfg);
+        return ny_nir_inst_err(err, err_len, in, i,
+                               "operand definition does not dominate its use");
+      }
+    }
+  }
+  ny_nir_cfg_free(&cfg);
+  return true;
+}
+
+static bool nir_phi_def_reaches(const ny_nir_cfg_t *cfg, int value, int pred) {
+  if (value < 0 || (size_t)value >= cfg->value_count)
+    return false;
+  int def = cfg->def_index[value];
+  if (def < 0)
+    return false;
+  return cfg->block_of[def] == pred ||
+         ny_nir_cfg_dominates(cfg, cfg->block_of[def], pred);
+}
+
+/* Phis sit at the head of a labelled block other than the entry and carry
+ * exactly one entry per reachable predecessor, keyed by the label that
+ * predecessor starts with. Each incoming value must be available at the end
+ * of its predecessor. */
+static bool nir_verify_phis(const ny_nir_func_t *f, char *err,
+                            size_t err_len) {
+  bool any = false;
+  for (size_t i = 0; i < f->len && !any; ++i)
+    any = f->data[i].op == NYIR_PHI;
+  if (!any)
+    return true;
+  ny_nir_cfg_t cfg;
+  if (!ny_nir_cfg_build(&cfg, f))
+    return ny_nir_err(err, err_len, "native NYIR verify: out of memory");
+  const char *reason = NULL;
+  size_t i = 0;
+  for (; i < f->len && !reason; ++i) {
+    const ny_nir_inst_t *in = &f->data[i];
+    if (in->op != NYIR_PHI)
+      continue;
+    int b = cfg.block_of[i];
+    const ny_nir_block_t *blk = &cfg.blocks[b];
+    bool head = b != 0 && f->data[blk->start].op == NY_NIR_LABEL;
+    for (size_t j = blk->start + 1; head && j < i; ++j)
+      head = f->data[j].op == NYIR_PHI || f->data[j].op == NY_NIR_NOP;
+    if (!head) {
+      reason = "phi is not at the head of a labelled non-entry block";
+      break;
+    }
+    if (!ny_nir_cfg_reachable(&cfg, b))
+      continue;
+    size_t preds = 0;
+    for (int p = 0; p < blk->pred_count && !reason; ++p) {
+      int pred = blk->preds[p];
+      if (!ny_nir_cfg_reachable(&cfg, pred))
+        continue;
+      preds++;
+      int64_t label = ny_nir_cfg_block_label(&cfg, f, pred);
+      if (label < 0) {
+        reason = "phi predecessor block has no label";
+        break;
+      }
+      size_t matches = 0;
+      for (size_t k = 0; k < in->extra_args_len; ++k) {
+        if (in->phi_labels[k] != label)
+          continue;
+        matches++;
+        if (!nir_phi_def_reaches(&cfg, in->extra_args[k], pred))
+          reason = "phi incoming value is not available at the end of its "
+                   "predecessor";
+      }
+      if (!reason && matches != 1)
+        reason = "phi needs exactly one entry per predecessor";
+    }
+    if (!reason && preds != in->extra_args_len)
+      reason = "phi arity does not match its predecessor count";
+    if (reason)
+      break;
+  }
+  ny_nir_cfg_free(&cfg);
+  if (reason)
+    return ny_nir_inst_err(err, err_len, &f->data[i], i, reason);
+  return true;
+}
+
 bool ny_nir_verify(const ny_nir_func_t *f, char *err, size_t err_len) {
   if (!f)
     return ny_nir_err(err, err_len, "native NYIR verify: missing function");
@@ -61,6 +214,11 @@ bool ny_nir_verify(const ny_nir_func_t *f, char *err, size_t err_len) {
       return ny_nir_inst_err(err, err_len, in, i,
                              "non-call instruction has aggregate argument metadata");
     }
+    if (in->op != NYIR_PHI && in->phi_labels) {
+      free(defined);
+      return ny_nir_inst_err(err, err_len, in, i,
+                             "non-phi instruction has phi labels");
+    }
     if (in->op < 0 || in->op >= NYIR_OP_COUNT) {
       free(defined);
       return ny_nir_inst_err(err, err_len, in, i, "unknown opcode");
@@ -322,6 +480,21 @@ bool ny_nir_verify(const ny_nir_func_t *f, char *err, size_t err_len) {
         }
       }
       break;
+    case NYIR_PHI:
+      if (in->dst < 0 ||
+          (in->extra_args_len && (!in->extra_args || !in->phi_labels))) {
+        free(defined);
+        return ny_nir_inst_err(err, err_len, in, i,
+                               "phi needs a destination and a label per value");
+      }
+      for (size_t k = 0; k < in->extra_args_len; ++k) {
+        if (!nir_value_valid(f, in->extra_args[k])) {
+          free(defined);
+          return ny_nir_inst_err(err, err_len, in, i,
+                                 "phi incoming value is invalid");
+        }
+      }
+      break;
     default:
       if (in->op == NYIR_OP_COUNT) {
         free(defined);
@@ -338,6 +511,9 @@ bool ny_nir_verify(const ny_nir_func_t *f, char *err, size_t err_len) {
       defined[in->dst] = true;
   }
   free(defined);
+  if (!nir_verify_dominance(f, err, err_len) ||
+      !nir_verify_phis(f, err, err_len))
+    return false;
   if (!ny_nir_validate_constraints(f, err, err_len))
     return false;
   if (err && err_len > 0)
@@ -713,7 +889,8 @@ bool ny_nir_analyze_values(const ny_nir_func_t *f, ny_nir_value_fact_t *facts,
       facts[in->a].use_count++;
     if (in->b >= 0 && facts && (size_t)in->b < fact_count)
       facts[in->b].use_count++;
-    if (in->op == NY_NIR_CALL && in->extra_args && facts) {
+    if ((in->op == NY_NIR_CALL || in->op == NYIR_PHI) && in->extra_args &&
+        facts) {
       for (size_t k = 0; k < in->extra_args_len; ++k) {
         int v = in->extra_args[k];
         if (v >= 0 && (size_t)v < fact_count)
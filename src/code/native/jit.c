@@ -182,6 +182,11 @@ static bool ny_native_jit_compile_aarch64_bundle(
       ny_native_jit_image_free(image);
       return false;
     }
+    if (relocs[i].type == NY_RELOC_AARCH64_ABS64) {
+      uint64_t absolute = (uint64_t)(uintptr_t)resolved;
+      memcpy(memory + relocs[i].disp_off, &absolute, sizeof(absolute));
+      continue;
+    }
     unsigned char *branch_target = (unsigned char *)resolved;
     if (ny_x64_obj_def_index(defs, def_count, relocs[i].symbol) < 0) {
       unsigned char *stub = memory + used;
@@ -1149,6 +1149,8 @@ static int ny_native_nir_lower_expr(ny_native_nir_builder_t *b, const expr_t *e)
                          builtin_c_call && strstr(leaf, "malloc") ? "malloc" :
                          builtin_c_call ? "free" : name;
     unsigned flags = (ext || builtin_c_call) ? NY_NIR_INST_F_EXTERN : 0;
+    if (has_sret)
+      flags |= NY_NIR_INST_F_SRET;
     if (callee_fn && ny_native_type_name_is_f64(callee_fn->as.fn.return_type)) {
       flags |= NY_NIR_INST_F_RET_F64;
     } else if (callee_fn && ny_native_type_name_is_f32(callee_fn->as.fn.return_type)) {
@@ -1966,14 +1968,15 @@ static bool ny_native_nir_finalize(ny_native_nir_builder_t *b,
   }
   if (!ny_nir_verify(&b->nir, err, err_len))
     goto fail;
-  if (verbose_enabled >= 1 && stats.pass_time_ms[8] > 0.001) {
+  double total_ms = stats.pass_time_ms[NY_NIR_OPT_PASS_COUNT - 1];
+  if (verbose_enabled >= 1 && total_ms > 0.001) {
     size_t removed = stats.before_insts - stats.after_insts;
     double pct = stats.before_insts > 0
                      ? 100.0 * (double)removed / stats.before_insts
                      : 0.0;
     fprintf(stderr, "nyir finalize: %zu→%zu insts (-%zu, %.1f%%) in %.2fms\n",
             stats.before_insts, stats.after_insts, removed, pct,
-            stats.pass_time_ms[8]);
+            total_ms);
   }
   return true;
 fail:
@@ -2317,13 +2320,85 @@ static bool ny_native_nir_build_rt_main(const program_t *prog, ny_nir_func_t *ou
   return ok;
 }
 
+/*
+ * Run the module pipeline (IPCP, inlining) over rt_main and the user
+ * functions. names[i] is the source name of funcs_out[i].
+ * NYTRIX_NYIR_NO_IPO keeps every function as lowered.
+ */
+static bool ny_native_nir_optimize_module(ny_nir_func_t *rt_main,
+                                          ny_nir_func_t *funcs,
+                                          const char **names, size_t count,
+                                          ny_nir_module_stats_t *stats,
+                                          char *err, size_t err_len) {
+  const char *disabled = getenv("NYTRIX_NYIR_NO_IPO");
+  if (disabled && disabled[0] && strcmp(disabled, "0") != 0)
+    return true;
+  ny_nir_func_t **module_funcs =
+      (ny_nir_func_t **)malloc((count + 1) * sizeof(*module_funcs));
+  const char **module_names =
+      (const char **)malloc((count + 1) * sizeof(*module_names));
+  if (!module_funcs || !module_names) {
+    free(module_funcs);
+    free(module_names);
+    ny_native_set_err(err, err_len, "native NYIR module: allocation failed");
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    module_funcs[i] = &funcs[i];
+    module_names[i] = names[i];
+  }
+  module_funcs[count] = rt_main;
+  module_names[count] = NULL;
+  ny_nir_module_t module = {
+      .funcs = module_funcs, .names = module_names, .count = count + 1};
+  bool ok = ny_nir_optimize_module(&module, stats);
+  free(module_funcs);
+  free(module_names);
+  if (!ok)
+    ny_native_set_err(err, err_len, "native NYIR module: optimization failed");
+  return ok;
+}
+
+/*
+ * mem2reg carries loop locals through NYIR_PHI. Targets whose backend does
+ * not lower phis (and the LLVM backend, which has no native target info) get
+ * them demoted back to slots; the NYIR VM runs either form.
+ */
+static bool ny_native_nir_demote_phis(const ny_options *opt,
+                                      ny_nir_func_t *rt_main,
+                                      ny_nir_func_t *funcs, size_t count,
+                                      char *err, size_t err_len) {
+  ny_native_target_info_t target;
+  if (ny_native_target_info_init(&target, opt) &&
+      (target.caps & NY_NATIVE_CAP_NIR_PHI) != 0)
+    return true;
+  bool ok = ny_nir_lower_phis(rt_main);
+  for (size_t i = 0; ok && funcs && i < count; ++i)
+    ok = ny_nir_lower_phis(&funcs[i]);
+  if (!ok)
+    ny_native_set_err(err, err_len, "native NYIR: phi lowering failed");
+  return ok;
+}
+
 bool ny_native_build_nir(const program_t *prog, const ny_options *opt,
                          ny_nir_func_t *rt_main_out,
                          ny_nir_func_t *funcs_out, size_t *func_count,
                          size_t max_funcs, char *err, size_t err_len) {
+  return ny_native_build_nir_with_stats(prog, opt, rt_main_out, funcs_out,
+                                        func_count, max_funcs, NULL, err,
+                                        err_len);
+}
+
+bool ny_native_build_nir_with_stats(const program_t *prog, const ny_options *opt,
+                                    ny_nir_func_t *rt_main_out,
+                                    ny_nir_func_t *funcs_out,
+                                    size_t *func_count, size_t max_funcs,
+                                    ny_nir_module_stats_t *module_stats,
+                                    char *err, size_t err_len) {
+  if (module_stats)
+    memset(module_stats, 0, sizeof(*module_stats));
   if (!prog || !rt_main_out)
     return false;
-  (void)opt; /* reserved for future NYIR pass-level options */
   memset(rt_main_out, 0, sizeof(*rt_main_out));
   if (func_count)
     *func_count = 0;
@@ -2339,7 +2414,14 @@ bool ny_native_build_nir(const program_t *prog, const ny_options *opt,
   }
 
   /* Build user functions first. */
+  const char **names = NULL;
   if (funcs_out && func_count && max_funcs > 0) {
+    names = (const char **)calloc(max_funcs, sizeof(*names));
+    if (!names) {
+      ny_native_set_err(err, err_len, "native NYIR: allocation failed");
+      ny_extern_table_free(&externs);
+      return false;
+    }
     size_t count = 0;
     for (size_t i = 0; i < prog->body.len && count < max_funcs; ++i) {
       const stmt_t *s = prog->body.data[i];
@@ -2357,7 +2439,7 @@ bool ny_native_build_nir(const program_t *prog, const ny_options *opt,
         if (err && err_len > 0 && local_err[0])
           ny_native_set_err(err, err_len, "%s", local_err);
       } else {
-        count++;
+        names[count++] = s->as.fn.name;
       }
     }
     *func_count = count;
@@ -2366,6 +2448,14 @@ bool ny_native_build_nir(const program_t *prog, const ny_options *opt,
   /* Build rt_main with extern table. */
   bool ok = ny_native_nir_build_rt_main(prog, rt_main_out, &externs, err, err_len);
   ny_extern_table_free(&externs);
+  if (ok)
+    ok = ny_native_nir_optimize_module(rt_main_out, funcs_out, names,
+                                       func_count ? *func_count : 0,
+                                       module_stats, err, err_len);
+  if (ok)
+    ok = ny_native_nir_demote_phis(opt, rt_main_out, funcs_out,
+                                   func_count ? *func_count : 0, err, err_len);
+  free(names);
   return ok;
 }
 
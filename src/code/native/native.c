@@ -539,6 +539,21 @@ bool ny_native_dump_ir_for_program(const program_t *prog,
             "native NYIR dump unavailable: unsupported program shape");
   }
 
+  if (opt->nyir_dump_stats) {
+    ny_nir_func_t rt_main = {0};
+    ny_nir_func_t funcs[128] = {{0}};
+    size_t count = 0;
+    ny_nir_module_stats_t module_stats = {0};
+    char module_err[512] = {0};
+    if (ny_native_build_nir_with_stats(prog, opt, &rt_main, funcs, &count, 128,
+                                       &module_stats, module_err,
+                                       sizeof(module_err)))
+      ny_nir_dump_module_stats(out, &module_stats);
+    for (size_t i = 0; i < count; ++i)
+      ny_nir_func_free(&funcs[i]);
+    ny_nir_func_free(&rt_main);
+  }
+
   if (!attempted_any)
     fputs("native NYIR dump unavailable: program has no dumpable body\n", out);
   if (out != stderr)
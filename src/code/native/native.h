@@ -30,6 +30,7 @@ typedef enum {
   NY_NATIVE_CAP_ELF_OBJECT = 1u << 4,
   NY_NATIVE_CAP_COFF_OBJECT = 1u << 5,
   NY_NATIVE_CAP_MACHO_OBJECT = 1u << 6,
+  NY_NATIVE_CAP_NIR_PHI = 1u << 7,
 } ny_native_target_cap_t;
 
 typedef struct ny_native_target_info_t {
@@ -101,6 +102,14 @@ bool ny_native_build_nir(const program_t *prog, const ny_options *opt,
                          ny_nir_func_t *rt_main_out,
                          ny_nir_func_t *funcs_out, size_t *func_count,
                          size_t max_funcs, char *err, size_t err_len);
+/* As above, also reporting what the module pipeline (IPCP, inlining) did.
+ * module_stats may be NULL. */
+bool ny_native_build_nir_with_stats(const program_t *prog, const ny_options *opt,
+                                    ny_nir_func_t *rt_main_out,
+                                    ny_nir_func_t *funcs_out,
+                                    size_t *func_count, size_t max_funcs,
+                                    ny_nir_module_stats_t *module_stats,
+                                    char *err, size_t err_len);
 
 bool ny_native_emit_asm(const program_t *prog, const ny_options *opt,
                         const char *path, char *err, size_t err_len);
@@ -1969,6 +1969,47 @@ static bool ny_x64_obj_patch_branches(ny_x64_obj_ctx_t *c) {
   return true;
 }
 
+/* Phi edge copies name registers by number and spill slots from 16 up; %rax
+ * carries slot-to-slot moves and %rcx, which the allocator never hands out,
+ * parks one value when the copies form a cycle. */
+#define NY_X64_OBJ_PHI_SCRATCH 1
+
+static int ny_x64_obj_phi_location(void *ctx, int value) {
+  ny_x64_obj_ctx_t *c = (ny_x64_obj_ctx_t *)ctx;
+  if (value < 0 || value >= c->value_slots)
+    return -1;
+  if (c->value_reg && c->value_reg[value] >= 0)
+    return c->value_reg[value];
+  if (c->value_spill && c->value_spill[value] >= 0)
+    return 16 + c->value_spill[value];
+  return -1;
+}
+
+static bool ny_x64_obj_phi_move(void *ctx, int dst, int src) {
+  ny_x64_obj_ctx_t *c = (ny_x64_obj_ctx_t *)ctx;
+  if (dst < 0 || src < 0) {
+    ny_native_set_err(c->err, c->err_len,
+                      "x86-64 object writer: phi operand has no location");
+    return false;
+  }
+  int dst_off = -8 * (dst - 16 + 1);
+  int src_off = -8 * (src - 16 + 1);
+  if (src < 16)
+    return dst < 16 ? ny_x64_obj_mov_reg_reg(c, src, dst)
+                    : ny_x64_obj_store_reg(c, src, dst_off);
+  if (dst < 16)
+    return ny_x64_obj_load_reg(c, dst, src_off);
+  return ny_x64_obj_load_rax(c, src_off) && ny_x64_obj_store_rax(c, dst_off);
+}
+
+static bool ny_x64_obj_phi_edge(ny_x64_obj_ctx_t *c, int64_t label) {
+  if (!c->has_phi)
+    return true;
+  return ny_nir_phi_moves(c->nir, label, c->cur_label,
+                          ny_x64_obj_phi_location, NY_X64_OBJ_PHI_SCRATCH,
+                          ny_x64_obj_phi_move, c);
+}
+
 static unsigned ny_x64_obj_setcc(ny_nir_cmp_t cmp) {
   switch (cmp) {
   case NY_NIR_CMP_EQ:
@@ -2215,6 +2256,8 @@ static bool ny_x64_obj_emit_inst(ny_x64_obj_ctx_t *c,
   }
   case NY_NIR_LABEL:
     return ny_x64_obj_add_label(c, in->imm);
+  case NYIR_PHI:
+    return true; /* copied in on each incoming edge */
   case NY_NIR_LOAD_LOCAL:
     if (in->imm < 0 || in->imm >= c->local_slots) {
       ny_native_set_err(c->err, c->err_len,
@@ -2300,19 +2343,31 @@ static bool ny_x64_obj_emit_inst(ny_x64_obj_ctx_t *c,
     return ny_x64_obj_load_value_rax(c, in->a) &&
            ny_x64_obj_store_rax(c, ny_x64_obj_local_off(c, (int)in->imm));
   case NY_NIR_BR: {
-    if (!ny_x64_obj_u8(c, 0xe9))
+    if (!ny_x64_obj_phi_edge(c, in->imm) || !ny_x64_obj_u8(c, 0xe9))
       return false;
     size_t disp = c->code.len;
     return ny_x64_obj_i32(c, 0) && ny_x64_obj_add_patch(c, in->imm, disp);
   }
   case NY_NIR_BR_IF: {
+    bool edge = c->has_phi &&
+                ny_nir_phi_has_edge(c->nir, in->imm, c->cur_label);
     if (!ny_x64_obj_load_value_rax(c, in->a) ||
         !ny_x64_obj_bytes(c, (const unsigned char[]){0x48, 0x85, 0xc0, 0x0f,
-                                                     0x85},
+                                                     edge ? 0x84 : 0x85},
                           5))
       return false;
     size_t disp = c->code.len;
-    return ny_x64_obj_i32(c, 0) && ny_x64_obj_add_patch(c, in->imm, disp);
+    if (!edge)
+      return ny_x64_obj_i32(c, 0) && ny_x64_obj_add_patch(c, in->imm, disp);
+    /* The copies belong to the taken edge only: je skips them. */
+    if (!ny_x64_obj_i32(c, 0) || !ny_x64_obj_phi_edge(c, in->imm) ||
+        !ny_x64_obj_u8(c, 0xe9))
+      return false;
+    size_t jmp = c->code.len;
+    if (!ny_x64_obj_i32(c, 0) || !ny_x64_obj_add_patch(c, in->imm, jmp))
+      return false;
+    ny_obj_patch_u32(&c->code, disp, (uint32_t)(c->code.len - (disp + 4)));
+    return true;
   }
   case NY_NIR_RET:
     if (in->a >= 0) {
@@ -2745,7 +2800,9 @@ static bool ny_x64_obj_classify_values(ny_x64_obj_ctx_t *c,
 
 /* Keep non-floating SSA intervals in caller-saved r11/r9/r8 when they neither
  * cross nor feed a call. Values with call-sensitive lifetimes remain spilled,
- * so ABI argument setup cannot clobber an allocated value. */
+ * so ABI argument setup cannot clobber an allocated value. Intervals cover
+ * phi edge copies and are extended over loop back-edges, so a value defined
+ * before a loop and read inside it keeps its register for the whole loop. */
 static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
                                           const ny_nir_func_t *nir) {
   const char *disabled = getenv("NYTRIX_NATIVE_NO_REGALLOC");
@@ -2756,10 +2813,13 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
     return true;
   c->value_reg = malloc((size_t)c->value_slots * sizeof(*c->value_reg));
   c->value_xmm = malloc((size_t)c->value_slots * sizeof(*c->value_xmm));
+  int *def = malloc((size_t)c->value_slots * sizeof(*def));
   int *last_use = malloc((size_t)c->value_slots * sizeof(*last_use));
   bool *call_use = calloc((size_t)c->value_slots, sizeof(*call_use));
   int *next_call = malloc((nir->len + 1u) * sizeof(*next_call));
-  if (!c->value_reg || !c->value_xmm || !last_use || !call_use || !next_call) {
+  if (!c->value_reg || !c->value_xmm || !def || !last_use || !call_use ||
+      !next_call) {
+    free(def);
     free(last_use);
     free(call_use);
     free(next_call);
@@ -2772,9 +2832,11 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
   memset(c->value_xmm, -1,
          (size_t)c->value_slots * sizeof(*c->value_xmm));
   for (int v = 0; v < c->value_slots; ++v)
-    last_use[v] = -1;
+    def[v] = last_use[v] = -1;
   for (size_t i = 0; nir && i < nir->len; ++i) {
     const ny_nir_inst_t *in = &nir->data[i];
+    if (in->dst >= 0 && in->dst < c->value_slots && def[in->dst] < 0)
+      def[in->dst] = (int)i;
     const int operands[] = {in->a, in->b, in->c, in->d, in->e, in->f};
     for (size_t k = 0; k < sizeof(operands) / sizeof(operands[0]); ++k) {
       int v = operands[k];
@@ -2794,6 +2856,35 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
       }
     }
   }
+  if (!ny_nir_phi_extend_intervals(nir, def, last_use, c->value_slots)) {
+    free(def);
+    free(last_use);
+    free(call_use);
+    free(next_call);
+    ny_native_set_err(c->err, c->err_len,
+                      "x86-64 object writer: out of memory in register allocation");
+    return false;
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < nir->len; ++i) {
+      const ny_nir_inst_t *br = &nir->data[i];
+      if (br->op != NY_NIR_BR && br->op != NY_NIR_BR_IF)
+        continue;
+      for (size_t l = 0; l <= i; ++l) {
+        if (nir->data[l].op != NY_NIR_LABEL || nir->data[l].imm != br->imm)
+          continue;
+        for (int v = 0; v < c->value_slots; ++v) {
+          if (def[v] >= 0 && def[v] < (int)l && last_use[v] >= (int)l &&
+              last_use[v] < (int)i) {
+            last_use[v] = (int)i;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
   next_call[nir->len] = INT_MAX;
   for (size_t i = nir->len; i > 0; --i)
     next_call[i - 1] = nir->data[i - 1].op == NY_NIR_CALL
@@ -2814,12 +2905,14 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
         (c->value_f64 && c->value_f64[v]) ||
         (c->value_f32 && c->value_f32[v]))
       continue;
-    bool crosses_call = next_call[i + 1] < last_use[v];
+    /* A phi result is written on its incoming edges, ahead of the phi. */
+    int start = def[v];
+    bool crosses_call = next_call[start + 1] < last_use[v];
     if (in->op == NY_NIR_CONST_I64 && !crosses_call)
       continue;
     if (!crosses_call && !call_use[v]) {
       for (size_t r = 0; r < sizeof(caller_regs) / sizeof(caller_regs[0]); ++r) {
-        if ((int)i >= caller_end[r]) {
+        if (start >= caller_end[r]) {
           c->value_reg[v] = (int8_t)caller_regs[r];
           caller_end[r] = last_use[v];
           break;
@@ -2827,7 +2920,7 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
       }
     } else if (crosses_call) {
       for (size_t r = 0; r < sizeof(callee_regs) / sizeof(callee_regs[0]); ++r) {
-        if ((int)i >= callee_end[r]) {
+        if (start >= callee_end[r]) {
           c->value_reg[v] = (int8_t)callee_regs[r];
           callee_end[r] = last_use[v];
           break;
@@ -2856,6 +2949,7 @@ static bool ny_x64_obj_allocate_registers(ny_x64_obj_ctx_t *c,
       }
     }
   }
+  free(def);
   free(last_use);
   free(call_use);
   free(next_call);
@@ -3078,8 +3172,22 @@ bool ny_x64_obj_emit_code(ny_x64_obj_ctx_t *c, const ny_nir_func_t *nir,
     return false;
   if (!ny_x64_obj_emit_param_spill(c, nir))
     return false;
+  c->cur_label = -1;
+  for (size_t i = 0; nir && i < nir->len && !c->has_phi; ++i)
+    c->has_phi = nir->data[i].op == NYIR_PHI;
   for (size_t i = 0; nir && i < nir->len; ++i) {
     const ny_nir_inst_t *in = &nir->data[i];
+    ny_nir_op_t prev = i > 0 ? nir->data[i - 1].op : NY_NIR_NOP;
+    if (in->op == NY_NIR_LABEL) {
+      /* Falling into a label is an edge too. */
+      if (prev != NY_NIR_BR && prev != NY_NIR_RET &&
+          !ny_x64_obj_phi_edge(c, in->imm))
+        return false;
+      c->cur_label = in->imm;
+    } else if (prev == NY_NIR_BR || prev == NY_NIR_BR_IF ||
+               prev == NY_NIR_RET) {
+      c->cur_label = -1;
+    }
     if (tag_return && in->op == NY_NIR_RET && in->a >= 0) {
       if (c->value_f64 && in->a < c->value_slots && c->value_f64[in->a]) {
         if (!ny_x64_obj_load_value_xmm(c, in->a, 0) ||
@@ -5,9 +5,10 @@
 #include <stdlib.h>
 #include <string.h>
 
-/* Internal AArch64 encoder and ELF64 packager for the proven scalar AAPCS64
- * NYIR slice. It deliberately rejects floating/aggregate shapes until their
- * ABI classification is represented; object success never invokes an
+/* Internal AArch64 encoder and ELF64 packager for NYIR. Call lowering and
+ * register assignment come from the AAPCS64 helpers in backend/aarch64.c so
+ * the assembly and object paths agree; aggregates whose classification may
+ * be a floating HFA are still rejected. Object success never invokes an
  * assembler or another compiler. */
 
 typedef struct {
@@ -24,6 +25,7 @@ typedef struct {
 typedef struct {
   char symbol[256];
   size_t off;
+  int type;
 } ny_a64_reloc_t;
 
 typedef struct {
@@ -38,9 +40,13 @@ typedef struct {
   const ny_native_target_info_t *target;
   int value_slots;
   int local_slots;
-  int local_base;
+  int spill_slots;
   int frame_bytes;
   ny_nir_type_map_t types;
+  int8_t *value_reg;
+  int *value_spill;
+  int save_slot[31];
+  int save_count;
   ny_a64_label_t labels[1024];
   size_t label_count;
   ny_a64_patch_t patches[1024];
@@ -49,10 +55,15 @@ typedef struct {
   size_t return_count;
   ny_a64_reloc_t relocs[256];
   size_t reloc_count;
+  int64_t cur_label; /* phi edge copies key on the block label */
+  bool has_phi;
   char *err;
   size_t err_len;
 } ny_a64_obj_ctx_t;
 
+enum { NY_A64_X0 = 0, NY_A64_X1 = 1, NY_A64_X2 = 2, NY_A64_X8 = 8,
+       NY_A64_X16 = 16, NY_A64_X17 = 17, NY_A64_FP = 29, NY_A64_SP = 31 };
+
 static int ny_a64_align(int value, int align) {
   return (value + align - 1) & ~(align - 1);
 }
@@ -66,25 +77,68 @@ static bool ny_a64_u32(ny_a64_obj_ctx_t *c, uint32_t word) {
   return true;
 }
 
+/* Scaled unsigned-offset load/store: op is the size/opc pattern with zero
+ * offset and registers. */
+static bool ny_a64_mem_at(ny_a64_obj_ctx_t *c, uint32_t op, unsigned reg,
+                          unsigned base, int off, int scale) {
+  if (reg > 31 || off < 0 || (off % scale) != 0 || off / scale > 4095) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 object writer: invalid memory access reg=%u off=%d",
+                      reg, off);
+    return false;
+  }
+  return ny_a64_u32(c, op | ((uint32_t)(off / scale) << 10) | (base << 5) |
+                           reg);
+}
+
 static bool ny_a64_reg_mem(ny_a64_obj_ctx_t *c, bool load, unsigned reg,
                            int off) {
-  if (reg > 30 || off < 0 || off > 32760 || (off & 7) != 0) {
+  return ny_a64_mem_at(c, load ? 0xf9400000u : 0xf9000000u, reg, NY_A64_FP,
+                       off, 8);
+}
+
+static bool ny_a64_fp_mem(ny_a64_obj_ctx_t *c, bool load, bool f32,
+                          unsigned reg, int off) {
+  uint32_t op = f32 ? (load ? 0xbd400000u : 0xbd000000u)
+                    : (load ? 0xfd400000u : 0xfd000000u);
+  return ny_a64_mem_at(c, op, reg, NY_A64_FP, off, f32 ? 4 : 8);
+}
+
+/* add/sub (immediate) of up to 24 bits; register 31 is sp. */
+static bool ny_a64_addsub(ny_a64_obj_ctx_t *c, bool sub, unsigned d,
+                          unsigned n, int imm) {
+  if (imm < 0 || imm >= (1 << 24)) {
     ny_native_set_err(c->err, c->err_len,
-                      "AArch64 object writer: invalid stack access reg=%u off=%d",
-                      reg, off);
+                      "AArch64 object writer: immediate %d is out of range",
+                      imm);
     return false;
   }
-  uint32_t op = load ? 0xf94003e0u : 0xf90003e0u;
-  return ny_a64_u32(c, op | ((uint32_t)(off / 8) << 10) | reg);
+  uint32_t op = sub ? 0xd1000000u : 0x91000000u;
+  if (imm >> 12) {
+    if (!ny_a64_u32(c, op | (1u << 22) | ((uint32_t)(imm >> 12) << 10) |
+                           (n << 5) | d))
+      return false;
+    n = d;
+  }
+  if ((imm & 4095) || !(imm >> 12))
+    return ny_a64_u32(c, op | ((uint32_t)(imm & 4095) << 10) | (n << 5) | d);
+  return true;
+}
+
+static bool ny_a64_mov(ny_a64_obj_ctx_t *c, unsigned d, unsigned m) {
+  return d == m || ny_a64_u32(c, 0xaa0003e0u | (m << 16) | d);
 }
 
-static int ny_a64_value_off(const ny_a64_obj_ctx_t *c, int value) {
-  (void)c;
-  return value * 8;
+static int ny_a64_spill_off(const ny_a64_obj_ctx_t *c, int value) {
+  return 16 + c->value_spill[value] * 8;
 }
 
 static int ny_a64_local_off(const ny_a64_obj_ctx_t *c, int local) {
-  return c->local_base + local * 8;
+  return 16 + (c->spill_slots + local) * 8;
+}
+
+static int ny_a64_save_off(const ny_a64_obj_ctx_t *c, int reg) {
+  return 16 + (c->spill_slots + c->local_slots + c->save_slot[reg]) * 8;
 }
 
 static bool ny_a64_check_value(ny_a64_obj_ctx_t *c, int value,
@@ -97,14 +151,39 @@ static bool ny_a64_check_value(ny_a64_obj_ctx_t *c, int value,
   return false;
 }
 
+/* Register holding value: its allocated register, or scratch after a reload.
+ * Returns -1 on error. */
+static int ny_a64_src(ny_a64_obj_ctx_t *c, int value, unsigned scratch) {
+  if (!ny_a64_check_value(c, value, "source"))
+    return -1;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return c->value_reg[value];
+  return ny_a64_reg_mem(c, true, scratch, ny_a64_spill_off(c, value))
+             ? (int)scratch
+             : -1;
+}
+
+static int ny_a64_dst(ny_a64_obj_ctx_t *c, int value, unsigned scratch) {
+  if (!ny_a64_check_value(c, value, "destination"))
+    return -1;
+  return c->value_reg[value] != NY_A64_REG_NONE ? c->value_reg[value]
+                                                 : (int)scratch;
+}
+
+static bool ny_a64_finish(ny_a64_obj_ctx_t *c, int value, unsigned reg) {
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return ny_a64_mov(c, (unsigned)c->value_reg[value], reg);
+  return ny_a64_reg_mem(c, false, reg, ny_a64_spill_off(c, value));
+}
+
 static bool ny_a64_load_value(ny_a64_obj_ctx_t *c, unsigned reg, int value) {
-  return ny_a64_check_value(c, value, "source") &&
-         ny_a64_reg_mem(c, true, reg, ny_a64_value_off(c, value));
+  int src = ny_a64_src(c, value, reg);
+  return src >= 0 && ny_a64_mov(c, reg, (unsigned)src);
 }
 
 static bool ny_a64_store_value(ny_a64_obj_ctx_t *c, int value, unsigned reg) {
   return ny_a64_check_value(c, value, "destination") &&
-         ny_a64_reg_mem(c, false, reg, ny_a64_value_off(c, value));
+         ny_a64_finish(c, value, reg);
 }
 
 static bool ny_a64_load_local(ny_a64_obj_ctx_t *c, unsigned reg, int local) {
@@ -125,26 +204,26 @@ static bool ny_a64_store_local(ny_a64_obj_ctx_t *c, int local, unsigned reg) {
   return ny_a64_reg_mem(c, false, reg, ny_a64_local_off(c, local));
 }
 
-static bool ny_a64_fp_mem(ny_a64_obj_ctx_t *c, bool load, bool f32,
-                          unsigned reg, int off) {
-  unsigned scale = f32 ? 4u : 8u;
-  if (reg > 31 || off < 0 || (off % (int)scale) != 0 ||
-      off / (int)scale > 4095) return false;
-  uint32_t op = f32 ? (load ? 0xbd4003e0u : 0xbd0003e0u)
-                    : (load ? 0xfd4003e0u : 0xfd0003e0u);
-  return ny_a64_u32(c, op | ((uint32_t)(off / (int)scale) << 10) | reg);
-}
-
+/* Floating values normally live in stack slots; one that was assigned a
+ * general register is moved with fmov. */
 static bool ny_a64_load_fp_value(ny_a64_obj_ctx_t *c, unsigned reg, int value,
                                  bool f32) {
-  return ny_a64_check_value(c, value, "floating source") &&
-         ny_a64_fp_mem(c, true, f32, reg, ny_a64_value_off(c, value));
+  if (!ny_a64_check_value(c, value, "floating source"))
+    return false;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return ny_a64_u32(c, (f32 ? 0x1e270000u : 0x9e670000u) |
+                             ((uint32_t)c->value_reg[value] << 5) | reg);
+  return ny_a64_fp_mem(c, true, f32, reg, ny_a64_spill_off(c, value));
 }
 
 static bool ny_a64_store_fp_value(ny_a64_obj_ctx_t *c, int value,
                                   unsigned reg, bool f32) {
-  return ny_a64_check_value(c, value, "floating destination") &&
-         ny_a64_fp_mem(c, false, f32, reg, ny_a64_value_off(c, value));
+  if (!ny_a64_check_value(c, value, "floating destination"))
+    return false;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return ny_a64_u32(c, (f32 ? 0x1e260000u : 0x9e660000u) | (reg << 5) |
+                             (uint32_t)c->value_reg[value]);
+  return ny_a64_fp_mem(c, false, f32, reg, ny_a64_spill_off(c, value));
 }
 
 static bool ny_a64_fp_binop(ny_a64_obj_ctx_t *c, const ny_nir_inst_t *in,
@@ -169,12 +248,16 @@ static bool ny_a64_mov_imm(ny_a64_obj_ctx_t *c, unsigned reg, int64_t value) {
   return true;
 }
 
+/* Three-register data-processing op: dst = a op b. */
 static bool ny_a64_binop(ny_a64_obj_ctx_t *c, const ny_nir_inst_t *in,
                          uint32_t op) {
-  return ny_a64_load_value(c, 0, in->a) &&
-         ny_a64_load_value(c, 1, in->b) &&
-         ny_a64_u32(c, op | (1u << 16)) &&
-         ny_a64_store_value(c, in->dst, 0);
+  int a = ny_a64_src(c, in->a, NY_A64_X0);
+  int b = a >= 0 ? ny_a64_src(c, in->b, NY_A64_X1) : -1;
+  int d = b >= 0 ? ny_a64_dst(c, in->dst, NY_A64_X0) : -1;
+  return d >= 0 &&
+         ny_a64_u32(c, op | ((uint32_t)b << 16) | ((uint32_t)a << 5) |
+                           (uint32_t)d) &&
+         ny_a64_finish(c, in->dst, (unsigned)d);
 }
 
 static unsigned ny_a64_cond(ny_nir_cmp_t cmp) {
@@ -182,6 +265,23 @@ static unsigned ny_a64_cond(ny_nir_cmp_t cmp) {
   return (unsigned)cmp < sizeof(conds) / sizeof(conds[0]) ? conds[cmp] : 0;
 }
 
+/* fcmp leaves C and V set for unordered operands; mi/ls keep < and <= false
+ * on NaN where the signed lt/le would report true. */
+static unsigned ny_a64_fcond(ny_nir_cmp_t cmp) {
+  if (cmp == NY_NIR_CMP_LT)
+    return 4;
+  if (cmp == NY_NIR_CMP_LE)
+    return 9;
+  return ny_a64_cond(cmp);
+}
+
+static bool ny_a64_cset(ny_a64_obj_ctx_t *c, int dst, unsigned cond) {
+  int d = ny_a64_dst(c, dst, NY_A64_X0);
+  return d >= 0 &&
+         ny_a64_u32(c, 0x9a9f07e0u | ((cond ^ 1u) << 12) | (uint32_t)d) &&
+         ny_a64_finish(c, dst, (unsigned)d);
+}
+
 static bool ny_a64_add_label(ny_a64_obj_ctx_t *c, int64_t label) {
   if (c->label_count >= sizeof(c->labels) / sizeof(c->labels[0])) {
     ny_native_set_err(c->err, c->err_len,
@@ -193,8 +293,10 @@ static bool ny_a64_add_label(ny_a64_obj_ctx_t *c, int64_t label) {
   return true;
 }
 
+/* Records a branch to label; conditional patches fill the imm19 field of
+ * b.cond/cbnz, the others the imm26 field of b. */
 static bool ny_a64_add_patch(ny_a64_obj_ctx_t *c, int64_t label,
-                             bool conditional) {
+                             bool conditional, uint32_t insn) {
   if (c->patch_count >= sizeof(c->patches) / sizeof(c->patches[0])) {
     ny_native_set_err(c->err, c->err_len,
                       "AArch64 object writer: too many branch patches");
@@ -203,7 +305,7 @@ static bool ny_a64_add_patch(ny_a64_obj_ctx_t *c, int64_t label,
   size_t off = c->code.len;
   c->patches[c->patch_count++] = (ny_a64_patch_t){
       .label = label, .off = off, .conditional = conditional};
-  return ny_a64_u32(c, conditional ? 0x54000001u : 0x14000000u);
+  return ny_a64_u32(c, insn);
 }
 
 static bool ny_a64_patch_branch(ny_a64_obj_ctx_t *c, size_t off,
@@ -224,7 +326,43 @@ static bool ny_a64_patch_branch(ny_a64_obj_ctx_t *c, size_t off,
   return true;
 }
 
-static bool ny_a64_add_reloc(ny_a64_obj_ctx_t *c, const char *symbol) {
+/* Phi edge copies name registers by number and spill slots from 32 up; x16
+ * carries slot-to-slot moves and x17 parks one value when the copies form a
+ * cycle. */
+static int ny_a64_phi_location(void *ctx, int value) {
+  ny_a64_obj_ctx_t *c = (ny_a64_obj_ctx_t *)ctx;
+  if (value < 0 || value >= c->value_slots)
+    return -1;
+  if (c->value_reg[value] != NY_A64_REG_NONE)
+    return c->value_reg[value];
+  return 32 + c->value_spill[value];
+}
+
+static bool ny_a64_phi_move(void *ctx, int dst, int src) {
+  ny_a64_obj_ctx_t *c = (ny_a64_obj_ctx_t *)ctx;
+  if (dst < 0 || src < 0) {
+    ny_native_set_err(c->err, c->err_len,
+                      "AArch64 object writer: phi operand has no location");
+    return false;
+  }
+  unsigned reg = src < 32 ? (unsigned)src : NY_A64_X16;
+  if (src >= 32 && !ny_a64_reg_mem(c, true, reg, 16 + (src - 32) * 8))
+    return false;
+  if (dst >= 32)
+    return ny_a64_reg_mem(c, false, reg, 16 + (dst - 32) * 8);
+  return ny_a64_mov(c, (unsigned)dst, reg);
+}
+
+static bool ny_a64_phi_edge(ny_a64_obj_ctx_t *c, int64_t label) {
+  if (!c->has_phi)
+    return true;
+  return ny_nir_phi_moves(c->nir, label, c->cur_label, ny_a64_phi_location,
+                          NY_A64_X17, ny_a64_phi_move, c);
+}
+
+/* CALL26 relocations sit on a bl; ABS64 ones on an 8-byte literal. */
+static bool ny_a64_add_reloc(ny_a64_obj_ctx_t *c, const char *symbol,
+                             int type) {
   if (!symbol || !*symbol ||
       c->reloc_count >= sizeof(c->relocs) / sizeof(c->relocs[0])) {
     ny_native_set_err(c->err, c->err_len,
@@ -234,19 +372,132 @@ static bool ny_a64_add_reloc(ny_a64_obj_ctx_t *c, const char *symbol) {
   ny_a64_reloc_t *r = &c->relocs[c->reloc_count++];
   snprintf(r->symbol, sizeof(r->symbol), "%s", symbol);
   r->off = c->code.len;
+  r->type = type;
+  if (type == NY_RELOC_AARCH64_ABS64)
+    return ny_a64_u32(c, 0) && ny_a64_u32(c, 0);
   return ny_a64_u32(c, 0x94000000u);
 }
 
+/* Copies size bytes from [x17] to [x16]; clobbers x0 and, for long copies,
+ * x2, x16 and x17. */
+static bool ny_a64_copy(ny_a64_obj_ctx_t *c, int64_t size) {
+  if (size <= 0)
+    return true;
+  if (size > 256)
+    return ny_a64_mov_imm(c, NY_A64_X2, size) &&
+           ny_a64_u32(c, 0x38401620u) && /* ldrb w0, [x17], #1 */
+           ny_a64_u32(c, 0x38001600u) && /* strb w0, [x16], #1 */
+           ny_a64_u32(c, 0xf1000442u) && /* subs x2, x2, #1 */
+           ny_a64_u32(c, 0x54000001u | ((uint32_t)-3 & 0x7ffffu) << 5);
+  int off = 0;
+  for (; off + 8 <= size; off += 8)
+    if (!ny_a64_mem_at(c, 0xf9400000u, NY_A64_X0, NY_A64_X17, off, 8) ||
+        !ny_a64_mem_at(c, 0xf9000000u, NY_A64_X0, NY_A64_X16, off, 8))
+      return false;
+  for (; off < size; ++off)
+    if (!ny_a64_mem_at(c, 0x39400000u, NY_A64_X0, NY_A64_X17, off, 1) ||
+        !ny_a64_mem_at(c, 0x39000000u, NY_A64_X0, NY_A64_X16, off, 1))
+      return false;
+  return true;
+}
+
+static bool ny_a64_emit_call(ny_a64_obj_ctx_t *c, const ny_nir_inst_t *in) {
+  ny_a64_call_plan_t plan;
+  if (!ny_a64_plan_call(in, c->value_slots, &c->types, &plan, c->err,
+                        c->err_len))
+    return false;
+  int area = plan.stack_bytes + plan.copy_bytes;
+  if (area && !ny_a64_addsub(c, true, NY_A64_SP, NY_A64_SP, area))
+    return false;
+  /* Memory-resident arguments first; the copies clobber x0/x2/x16/x17. */
+  for (int i = 0; i < plan.argc; ++i) {
+    const ny_a64_arg_t *a = &plan.args[i];
+    if (a->kind == NY_A64_ARG_AGG_REF) {
+      int copy = plan.stack_bytes + a->copy_off;
+      if (!ny_a64_load_value(c, NY_A64_X17, a->value) ||
+          !ny_a64_addsub(c, false, NY_A64_X16, NY_A64_SP, copy) ||
+          !ny_a64_copy(c, a->size))
+        return false;
+      if (a->stack_off >= 0 &&
+          (!ny_a64_addsub(c, false, NY_A64_X0, NY_A64_SP, copy) ||
+           !ny_a64_mem_at(c, 0xf9000000u, NY_A64_X0, NY_A64_SP, a->stack_off,
+                          8)))
+        return false;
+    } else if (a->kind == NY_A64_ARG_AGG && a->stack_off >= 0) {
+      if (!ny_a64_load_value(c, NY_A64_X17, a->value) ||
+          !ny_a64_addsub(c, false, NY_A64_X16, NY_A64_SP, a->stack_off) ||
+          !ny_a64_copy(c, a->size))
+        return false;
+    } else if (a->stack_off >= 0) {
+      if (!ny_a64_load_value(c, NY_A64_X0, a->value) ||
+          !ny_a64_mem_at(c, 0xf9000000u, NY_A64_X0, NY_A64_SP, a->stack_off,
+                         8))
+        return false;
+    }
+  }
+  for (int i = 0; i < plan.argc; ++i) {
+    const ny_a64_arg_t *a = &plan.args[i];
+    if (a->reg < 0)
+      continue;
+    bool ok = true;
+    switch (a->kind) {
+    case NY_A64_ARG_GP:
+      ok = ny_a64_load_value(c, (unsigned)a->reg, a->value);
+      break;
+    case NY_A64_ARG_FP:
+      ok = ny_a64_load_fp_value(c, (unsigned)a->reg, a->value, a->f32);
+      break;
+    case NY_A64_ARG_AGG:
+      ok = ny_a64_load_value(c, NY_A64_X17, a->value);
+      for (int k = 0; ok && k < a->words; ++k)
+        ok = ny_a64_mem_at(c, 0xf9400000u, (unsigned)(a->reg + k), NY_A64_X17,
+                           k * 8, 8);
+      break;
+    case NY_A64_ARG_AGG_REF:
+      ok = ny_a64_addsub(c, false, (unsigned)a->reg, NY_A64_SP,
+                         plan.stack_bytes + a->copy_off);
+      break;
+    }
+    if (!ok)
+      return false;
+  }
+  if (plan.sret_value >= 0 &&
+      !ny_a64_load_value(c, NY_A64_X8, plan.sret_value))
+    return false;
+  char symbol[256];
+  snprintf(symbol, sizeof(symbol), "%s%s%s",
+           c->target->symbol_prefix ? c->target->symbol_prefix : "",
+           (in->flags & NY_NIR_INST_F_EXTERN) ? "" : "ny_fn_",
+           in->symbol ? in->symbol : "");
+  if (!ny_a64_add_reloc(c, symbol, NY_RELOC_AARCH64_CALL26))
+    return false;
+  if (area && !ny_a64_addsub(c, false, NY_A64_SP, NY_A64_SP, area))
+    return false;
+  if (in->dst < 0) return true;
+  if (c->types.value_f64[in->dst] || c->types.value_f32[in->dst])
+    return ny_a64_store_fp_value(c, in->dst, 0, c->types.value_f32[in->dst]);
+  return ny_a64_store_value(c, in->dst, NY_A64_X0);
+}
+
 static bool ny_a64_emit_inst(ny_a64_obj_ctx_t *c,
                              const ny_nir_inst_t *in) {
   switch (in->op) {
   case NY_NIR_NOP: return true;
   case NY_NIR_CONST_I64:
-    return ny_a64_mov_imm(c, 0, in->imm) &&
-           ny_a64_store_value(c, in->dst, 0);
-  case NY_NIR_COPY:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_store_value(c, in->dst, 0);
+  case NYIR_CONST_F64:
+  case NYIR_CONST_F32: {
+    if (in->dst < 0) return true;
+    int64_t bits = in->op == NYIR_CONST_F32 ? (int64_t)(uint32_t)in->imm
+                                            : in->imm;
+    int d = ny_a64_dst(c, in->dst, NY_A64_X0);
+    return d >= 0 && ny_a64_mov_imm(c, (unsigned)d, bits) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NY_NIR_COPY: {
+    if (in->dst < 0) return true;
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    return a >= 0 && ny_a64_store_value(c, in->dst, (unsigned)a);
+  }
   case NY_NIR_ADD_I64: return ny_a64_binop(c, in, 0x8b000000u);
   case NY_NIR_SUB_I64: return ny_a64_binop(c, in, 0xcb000000u);
   case NY_NIR_MUL_I64: return ny_a64_binop(c, in, 0x9b007c00u);
@@ -256,48 +507,115 @@ static bool ny_a64_emit_inst(ny_a64_obj_ctx_t *c,
   case NY_NIR_SHL_I64: return ny_a64_binop(c, in, 0x9ac02000u);
   case NY_NIR_SAR_I64: return ny_a64_binop(c, in, 0x9ac02800u);
   case NY_NIR_DIV_I64: return ny_a64_binop(c, in, 0x9ac00c00u);
-  case NY_NIR_MOD_I64:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_load_value(c, 1, in->b) &&
-           ny_a64_u32(c, 0x9ac10c02u) && /* sdiv x2,x0,x1 */
-           ny_a64_u32(c, 0x9b018040u) && /* msub x0,x2,x1,x0 */
-           ny_a64_store_value(c, in->dst, 0);
+  case NY_NIR_MOD_I64: {
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    int b = a >= 0 ? ny_a64_src(c, in->b, NY_A64_X1) : -1;
+    int d = b >= 0 ? ny_a64_dst(c, in->dst, NY_A64_X0) : -1;
+    return d >= 0 &&
+           /* sdiv x2, a, b; msub d, x2, b, a */
+           ny_a64_u32(c, 0x9ac00c02u | ((uint32_t)b << 16) |
+                             ((uint32_t)a << 5)) &&
+           ny_a64_u32(c, 0x9b008040u | ((uint32_t)b << 16) |
+                             ((uint32_t)a << 10) | (uint32_t)d) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
   case NY_NIR_CMP_I64: {
-    unsigned inverse = ny_a64_cond(in->cmp) ^ 1u;
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_load_value(c, 1, in->b) &&
-           ny_a64_u32(c, 0xeb01001fu) &&
-           ny_a64_u32(c, 0x9a9f07e0u | (inverse << 12)) &&
-           ny_a64_store_value(c, in->dst, 0);
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    int b = a >= 0 ? ny_a64_src(c, in->b, NY_A64_X1) : -1;
+    return b >= 0 &&
+           ny_a64_u32(c, 0xeb00001fu | ((uint32_t)b << 16) |
+                             ((uint32_t)a << 5)) &&
+           ny_a64_cset(c, in->dst, ny_a64_cond(in->cmp));
   }
   case NY_NIR_LABEL: return ny_a64_add_label(c, in->imm);
-  case NY_NIR_LOAD_LOCAL:
-    return ny_a64_load_local(c, 0, (int)in->imm) &&
-           ny_a64_store_value(c, in->dst, 0);
-  case NY_NIR_STORE_LOCAL:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_store_local(c, (int)in->imm, 0);
+  case NY_NIR_LOAD_LOCAL: {
+    if (in->dst < 0) return true;
+    if (c->types.value_f64[in->dst] || c->types.value_f32[in->dst]) {
+      bool f32 = c->types.value_f32[in->dst];
+      if (in->imm < 0 || in->imm >= c->local_slots) return false;
+      return ny_a64_fp_mem(c, true, f32, 0,
+                           ny_a64_local_off(c, (int)in->imm)) &&
+             ny_a64_store_fp_value(c, in->dst, 0, f32);
+    }
+    int d = ny_a64_dst(c, in->dst, NY_A64_X0);
+    return d >= 0 && ny_a64_load_local(c, (unsigned)d, (int)in->imm) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NY_NIR_STORE_LOCAL: {
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    return a >= 0 && ny_a64_store_local(c, (int)in->imm, (unsigned)a);
+  }
   case NYIR_ADDR_LOCAL: {
     if (in->imm < 0 || in->imm >= c->local_slots) return false;
-    int off = ny_a64_local_off(c, (int)in->imm);
-    if (off > 4095) return false;
-    return ny_a64_u32(c, 0x910003e0u | ((uint32_t)off << 10)) &&
-           ny_a64_store_value(c, in->dst, 0);
-  }
-  case NYIR_LOAD_I64:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_u32(c, 0xf9400000u) &&
-           ny_a64_store_value(c, in->dst, 0);
-  case NYIR_STORE_I64:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_load_value(c, 1, in->c) &&
-           ny_a64_u32(c, 0xf9000001u);
-  case NYIR_CONST_F64:
-    return ny_a64_mov_imm(c, 0, in->imm) &&
-           ny_a64_store_value(c, in->dst, 0);
-  case NYIR_CONST_F32:
-    return ny_a64_mov_imm(c, 0, (uint32_t)in->imm) &&
-           ny_a64_store_value(c, in->dst, 0);
+    int d = ny_a64_dst(c, in->dst, NY_A64_X0);
+    return d >= 0 &&
+           ny_a64_addsub(c, false, (unsigned)d, NY_A64_FP,
+                         ny_a64_local_off(c, (int)in->imm)) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NYIR_ADDR_SYMBOL: {
+    if (in->dst < 0) return true;
+    if (!in->symbol || !in->symbol[0]) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 object writer: addr.symbol missing symbol name");
+      return false;
+    }
+    /* ldr d, #8; b #12; .quad symbol -- an absolute literal keeps the JIT
+     * free of the +-4 GiB adrp reach. */
+    char symbol[256];
+    snprintf(symbol, sizeof(symbol), "%sny_fn_%s",
+             c->target->symbol_prefix ? c->target->symbol_prefix : "",
+             in->symbol);
+    int d = ny_a64_dst(c, in->dst, NY_A64_X0);
+    return d >= 0 && ny_a64_u32(c, 0x58000040u | (uint32_t)d) &&
+           ny_a64_u32(c, 0x14000003u) &&
+           ny_a64_add_reloc(c, symbol, NY_RELOC_AARCH64_ABS64) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NYIR_ALLOCA: {
+    if (in->dst < 0) return true;
+    if (in->imm < 0 || in->imm >= (1 << 24) - 15) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 object writer: alloca of %lld bytes is out of range",
+                        (long long)in->imm);
+      return false;
+    }
+    int bytes = ny_a64_align((int)in->imm, 16);
+    int d = ny_a64_dst(c, in->dst, NY_A64_X0);
+    return d >= 0 &&
+           (bytes == 0 ||
+            ny_a64_addsub(c, true, NY_A64_SP, NY_A64_SP, bytes)) &&
+           ny_a64_addsub(c, false, (unsigned)d, NY_A64_SP, 0) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NYIR_COPY_STRUCT:
+    if (in->imm <= 0) return true;
+    return ny_a64_load_value(c, NY_A64_X16, in->a) &&
+           ny_a64_load_value(c, NY_A64_X17, in->b) &&
+           ny_a64_copy(c, in->imm);
+  case NYIR_CAPTURE_RET:
+    if (in->dst < 0) return true;
+    if (in->imm != 0) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 object writer: capture.ret selector %lld "
+                        "needs floating aggregate classification",
+                        (long long)in->imm);
+      return false;
+    }
+    return ny_a64_store_value(c, in->dst, NY_A64_X1);
+  case NYIR_LOAD_I64: {
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    int d = a >= 0 ? ny_a64_dst(c, in->dst, NY_A64_X0) : -1;
+    return d >= 0 &&
+           ny_a64_u32(c, 0xf9400000u | ((uint32_t)a << 5) | (uint32_t)d) &&
+           ny_a64_finish(c, in->dst, (unsigned)d);
+  }
+  case NYIR_STORE_I64: {
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    int v = a >= 0 ? ny_a64_src(c, in->c, NY_A64_X1) : -1;
+    return v >= 0 &&
+           ny_a64_u32(c, 0xf9000000u | ((uint32_t)a << 5) | (uint32_t)v);
+  }
   case NYIR_ADD_F64: return ny_a64_fp_binop(c, in, 0x1e602800u, false);
   case NYIR_SUB_F64: return ny_a64_fp_binop(c, in, 0x1e603800u, false);
   case NYIR_MUL_F64: return ny_a64_fp_binop(c, in, 0x1e600800u, false);
@@ -307,11 +625,14 @@ static bool ny_a64_emit_inst(ny_a64_obj_ctx_t *c,
   case NYIR_MUL_F32: return ny_a64_fp_binop(c, in, 0x1e200800u, true);
   case NYIR_DIV_F32: return ny_a64_fp_binop(c, in, 0x1e201800u, true);
   case NYIR_I64_TO_F64:
-    return ny_a64_load_value(c, 0, in->a) && ny_a64_u32(c, 0x9e620000u) &&
-           ny_a64_store_fp_value(c, in->dst, 0, false);
-  case NYIR_I64_TO_F32:
-    return ny_a64_load_value(c, 0, in->a) && ny_a64_u32(c, 0x9e220000u) &&
-           ny_a64_store_fp_value(c, in->dst, 0, true);
+  case NYIR_I64_TO_F32: {
+    bool f32 = in->op == NYIR_I64_TO_F32;
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    return a >= 0 &&
+           ny_a64_u32(c, (f32 ? 0x9e220000u : 0x9e620000u) |
+                             ((uint32_t)a << 5)) &&
+           ny_a64_store_fp_value(c, in->dst, 0, f32);
+  }
   case NYIR_F64_TO_F32:
     return ny_a64_load_fp_value(c, 0, in->a, false) &&
            ny_a64_u32(c, 0x1e624000u) &&
@@ -323,127 +644,157 @@ static bool ny_a64_emit_inst(ny_a64_obj_ctx_t *c,
   case NYIR_CMP_F64:
   case NYIR_CMP_F32: {
     bool f32 = in->op == NYIR_CMP_F32;
-    unsigned inverse = ny_a64_cond(in->cmp) ^ 1u;
     return ny_a64_load_fp_value(c, 0, in->a, f32) &&
            ny_a64_load_fp_value(c, 1, in->b, f32) &&
            ny_a64_u32(c, (f32 ? 0x1e212000u : 0x1e612000u)) &&
-           ny_a64_u32(c, 0x9a9f07e0u | (inverse << 12)) &&
-           ny_a64_store_value(c, in->dst, 0);
-  }
-  case NY_NIR_BR: return ny_a64_add_patch(c, in->imm, false);
-  case NY_NIR_BR_IF:
-    return ny_a64_load_value(c, 0, in->a) &&
-           ny_a64_u32(c, 0xf100001fu) &&
-           ny_a64_add_patch(c, in->imm, true);
-  case NY_NIR_CALL: {
-    int args[NY_NIR_CALL_MAX_ARGS];
-    int argc = 0;
-    if (in->arg_sizes) {
-      for (int i = 0; i < (int)in->imm; ++i)
-        if (in->arg_sizes[i]) {
-          ny_native_set_err(c->err, c->err_len,
-                            "AArch64 object writer: aggregate call ABI is not represented");
-          return false;
-        }
-    }
-    if (!ny_nir_call_args(in, c->value_slots, args, NY_NIR_CALL_MAX_ARGS,
-                          &argc, c->err, c->err_len))
-      return false;
-    if (argc > 8) {
-      ny_native_set_err(c->err, c->err_len,
-                        "AArch64 object writer: %d scalar arguments exceed AAPCS64 registers",
-                        argc);
+           ny_a64_cset(c, in->dst, ny_a64_fcond(in->cmp));
+  }
+  case NYIR_PHI:
+    return true; /* copied in on each incoming edge */
+  case NY_NIR_BR:
+    return ny_a64_phi_edge(c, in->imm) &&
+           ny_a64_add_patch(c, in->imm, false, 0x14000000u);
+  case NY_NIR_BR_IF: {
+    int a = ny_a64_src(c, in->a, NY_A64_X0);
+    if (a < 0)
       return false;
-    }
-    int gp = 0, fp = 0;
-    for (int i = 0; i < argc; ++i) {
-      bool f64 = c->types.value_f64[args[i]];
-      bool f32 = c->types.value_f32[args[i]];
-      if (f64 || f32) {
-        if (fp >= 8 || !ny_a64_load_fp_value(c, (unsigned)fp++, args[i], f32))
-          return false;
-      } else if (gp >= 8 || !ny_a64_load_value(c, (unsigned)gp++, args[i])) {
-        return false;
-      }
-    }
-    char symbol[256];
-    snprintf(symbol, sizeof(symbol), "%s%s%s",
-             c->target->symbol_prefix ? c->target->symbol_prefix : "",
-             (in->flags & NY_NIR_INST_F_EXTERN) ? "" : "ny_fn_",
-             in->symbol ? in->symbol : "");
-    if (!ny_a64_add_reloc(c, symbol)) return false;
-    if (in->dst < 0) return true;
-    if (in->flags & NY_NIR_INST_F_RET_F64)
-      return ny_a64_store_fp_value(c, in->dst, 0, false);
-    if (in->flags & NY_NIR_INST_F_RET_F32)
-      return ny_a64_store_fp_value(c, in->dst, 0, true);
-    return ny_a64_store_value(c, in->dst, 0);
+    if (!c->has_phi || !ny_nir_phi_has_edge(c->nir, in->imm, c->cur_label))
+      return ny_a64_add_patch(c, in->imm, true, 0xb5000000u | (uint32_t)a);
+    /* The copies belong to the taken edge only: cbz skips them. */
+    size_t skip = c->code.len;
+    return ny_a64_u32(c, 0xb4000000u | (uint32_t)a) &&
+           ny_a64_phi_edge(c, in->imm) &&
+           ny_a64_add_patch(c, in->imm, false, 0x14000000u) &&
+           ny_a64_patch_branch(c, skip, c->code.len, true);
   }
+  case NY_NIR_CALL:
+    return ny_a64_emit_call(c, in);
   case NY_NIR_RET:
     if (in->a >= 0) {
+      if (!ny_a64_check_value(c, in->a, "return")) return false;
       bool f64 = c->types.value_f64[in->a];
       bool f32 = c->types.value_f32[in->a];
       if ((f64 || f32) ? !ny_a64_load_fp_value(c, 0, in->a, f32)
-                       : !ny_a64_load_value(c, 0, in->a))
+                       : !ny_a64_load_value(c, NY_A64_X0, in->a))
         return false;
     }
     if (c->return_count >= sizeof(c->returns) / sizeof(c->returns[0]))
       return false;
     c->returns[c->return_count++] = c->code.len;
     return ny_a64_u32(c, 0x14000000u);
-  case NYIR_ADDR_SYMBOL: case NYIR_ALLOCA:
-  case NYIR_COPY_STRUCT: case NYIR_CAPTURE_RET: case NYIR_OP_COUNT:
-    ny_native_set_err(c->err, c->err_len,
-                      "AArch64 object writer: unsupported op %s",
-                      ny_nir_op_name(in->op));
-    return false;
+  case NYIR_OP_COUNT:
+    break;
   }
+  ny_native_set_err(c->err, c->err_len,
+                    "AArch64 object writer: unsupported op %s",
+                    ny_nir_op_name(in->op));
   return false;
 }
 
-static bool ny_a64_emit_code(ny_a64_obj_ctx_t *c, bool user_function,
-                             bool tag_return) {
+/* Frame: x29 == sp after the prologue. [x29] holds x29/x30, then spill
+ * slots, locals and callee-saved registers, all at positive offsets so sp
+ * can move for alloca and outgoing stack arguments. */
+static bool ny_a64_plan_frame(ny_a64_obj_ctx_t *c) {
   c->value_slots = c->nir->next_value;
   c->local_slots = (int)ny_native_nir_local_count(c->nir);
-  c->local_base = c->value_slots * 8;
-  c->frame_bytes = ny_a64_align((c->value_slots + c->local_slots) * 8, 16);
   if (!ny_nir_type_map_init(&c->types, c->nir, (size_t)c->local_slots)) {
     ny_native_set_err(c->err, c->err_len,
                       "AArch64 object writer: type classification allocation failed");
     return false;
   }
-  if (c->frame_bytes > 4095) {
+  if (c->value_slots > 0) {
+    c->value_reg = malloc((size_t)c->value_slots * sizeof(*c->value_reg));
+    c->value_spill = malloc((size_t)c->value_slots * sizeof(*c->value_spill));
+    if (!c->value_reg || !c->value_spill ||
+        !ny_a64_allocate_registers(c->nir, &c->types, c->value_reg)) {
+      ny_native_set_err(c->err, c->err_len,
+                        "AArch64 object writer: register allocation out of memory");
+      return false;
+    }
+  }
+  for (int r = 0; r < 31; ++r)
+    c->save_slot[r] = -1;
+  for (int v = 0; v < c->value_slots; ++v) {
+    int reg = c->value_reg[v];
+    c->value_spill[v] = reg == NY_A64_REG_NONE ? c->spill_slots++ : -1;
+    if (reg >= 19 && reg <= 28 && c->save_slot[reg] < 0)
+      c->save_slot[reg] = c->save_count++;
+  }
+  c->frame_bytes = ny_a64_align(
+      16 + (c->spill_slots + c->local_slots + c->save_count) * 8, 16);
+  if (c->frame_bytes >= (1 << 24)) {
     ny_native_set_err(c->err, c->err_len,
-                      "AArch64 object writer: frame %d exceeds immediate slice",
+                      "AArch64 object writer: frame %d is too large",
                       c->frame_bytes);
     return false;
   }
-  if (!ny_a64_u32(c, 0xa9bf7bfdu) || !ny_a64_u32(c, 0x910003fdu) ||
-      (c->frame_bytes &&
-       !ny_a64_u32(c, 0xd10003ffu | ((uint32_t)c->frame_bytes << 10))))
+  return true;
+}
+
+static bool ny_a64_emit_params(ny_a64_obj_ctx_t *c) {
+  int params = ny_a64_param_count(c->nir, c->local_slots);
+  int gp = 0, fp = 0, stack = 0;
+  for (int i = 0; i < params; ++i) {
+    bool f64 = c->types.local_f64[i], f32 = c->types.local_f32[i];
+    bool ok;
+    if ((f64 || f32) && fp < 8)
+      ok = ny_a64_fp_mem(c, false, f32, (unsigned)fp++,
+                         ny_a64_local_off(c, i));
+    else if (!f64 && !f32 && gp < 8)
+      ok = ny_a64_store_local(c, i, (unsigned)gp++);
+    else
+      ok = ny_a64_reg_mem(c, true, NY_A64_X16,
+                          c->frame_bytes + 8 * stack++) &&
+           ny_a64_store_local(c, i, NY_A64_X16);
+    if (!ok) return false;
+  }
+  return true;
+}
+
+static bool ny_a64_emit_code(ny_a64_obj_ctx_t *c, bool user_function,
+                             bool tag_return) {
+  if (!ny_a64_plan_frame(c))
     return false;
-  if (user_function) {
-    int gp = 0, fp = 0;
-    int limit = c->local_slots < 8 ? c->local_slots : 8;
-    for (int i = 0; i < limit; ++i) {
-      bool f64 = c->types.local_f64[i], f32 = c->types.local_f32[i];
-      if (f64 || f32) {
-        if (fp >= 8 || !ny_a64_fp_mem(c, false, f32, (unsigned)fp++,
-                                      ny_a64_local_off(c, i))) return false;
-      } else {
-        if (gp >= 8 || !ny_a64_store_local(c, i, (unsigned)gp++)) return false;
-      }
+  if (!ny_a64_addsub(c, true, NY_A64_SP, NY_A64_SP, c->frame_bytes) ||
+      !ny_a64_u32(c, 0xa9007bfdu) || /* stp x29, x30, [sp] */
+      !ny_a64_u32(c, 0x910003fdu))   /* mov x29, sp */
+    return false;
+  for (int r = 19; r <= 28; ++r)
+    if (c->save_slot[r] >= 0 &&
+        !ny_a64_reg_mem(c, false, (unsigned)r, ny_a64_save_off(c, r)))
+      return false;
+  if (user_function && !ny_a64_emit_params(c))
+    return false;
+  c->cur_label = -1;
+  for (size_t i = 0; i < c->nir->len && !c->has_phi; ++i)
+    c->has_phi = c->nir->data[i].op == NYIR_PHI;
+  for (size_t i = 0; i < c->nir->len; ++i) {
+    const ny_nir_inst_t *in = &c->nir->data[i];
+    ny_nir_op_t prev = i > 0 ? c->nir->data[i - 1].op : NY_NIR_NOP;
+    if (in->op == NY_NIR_LABEL) {
+      /* Falling into a label is an edge too. */
+      if (prev != NY_NIR_BR && prev != NY_NIR_RET &&
+          !ny_a64_phi_edge(c, in->imm))
+        return false;
+      c->cur_label = in->imm;
+    } else if (prev == NY_NIR_BR || prev == NY_NIR_BR_IF ||
+               prev == NY_NIR_RET) {
+      c->cur_label = -1;
     }
+    if (!ny_a64_emit_inst(c, in)) return false;
   }
-  for (size_t i = 0; i < c->nir->len; ++i)
-    if (!ny_a64_emit_inst(c, &c->nir->data[i])) return false;
   size_t epilogue = c->code.len;
   if (tag_return &&
       (!ny_a64_u32(c, 0xd37ff800u) || !ny_a64_u32(c, 0x91000400u)))
     return false;
-  if ((c->frame_bytes &&
-       !ny_a64_u32(c, 0x910003ffu | ((uint32_t)c->frame_bytes << 10))) ||
-      !ny_a64_u32(c, 0xa8c17bfdu) || !ny_a64_u32(c, 0xd65f03c0u))
+  for (int r = 19; r <= 28; ++r)
+    if (c->save_slot[r] >= 0 &&
+        !ny_a64_reg_mem(c, true, (unsigned)r, ny_a64_save_off(c, r)))
+      return false;
+  if (!ny_a64_u32(c, 0x910003bfu) || /* mov sp, x29 */
+      !ny_a64_u32(c, 0xa9407bfdu) || /* ldp x29, x30, [sp] */
+      !ny_a64_addsub(c, false, NY_A64_SP, NY_A64_SP, c->frame_bytes) ||
+      !ny_a64_u32(c, 0xd65f03c0u))
     return false;
   for (size_t i = 0; i < c->patch_count; ++i) {
     size_t target = SIZE_MAX;
@@ -466,6 +817,13 @@ static bool ny_a64_emit_code(ny_a64_obj_ctx_t *c, bool user_function,
   return true;
 }
 
+static void ny_a64_ctx_free(ny_a64_obj_ctx_t *c) {
+  ny_nir_type_map_free(&c->types);
+  free(c->value_reg);
+  free(c->value_spill);
+  ny_obj_free(&c->code);
+}
+
 static int ny_a64_def_index(const ny_a64_def_t *defs, size_t count,
                             const char *name) {
   for (size_t i = 0; i < count; ++i)
@@ -492,14 +850,10 @@ static bool ny_a64_append(ny_obj_buf_t *code, ny_a64_def_t *defs,
   size_t start = code->len;
   ny_a64_obj_ctx_t c = {.nir = nir, .target = target, .err = err,
                         .err_len = err_len};
-  if (!ny_a64_emit_code(&c, user_function, tag_return)) {
-    ny_nir_type_map_free(&c.types);
-    ny_obj_free(&c.code);
-    return false;
-  }
-  if (*reloc_count + c.reloc_count > 256 ||
+  if (!ny_a64_emit_code(&c, user_function, tag_return) ||
+      *reloc_count + c.reloc_count > 256 ||
       !ny_obj_emit(code, c.code.data, c.code.len)) {
-    ny_obj_free(&c.code);
+    ny_a64_ctx_free(&c);
     return false;
   }
   ny_a64_def_t *def = &defs[(*def_count)++];
@@ -511,8 +865,7 @@ static bool ny_a64_append(ny_obj_buf_t *code, ny_a64_def_t *defs,
     relocs[*reloc_count].off += start;
     (*reloc_count)++;
   }
-  ny_obj_free(&c.code);
-  ny_nir_type_map_free(&c.types);
+  ny_a64_ctx_free(&c);
   return true;
 }
 
@@ -583,7 +936,7 @@ bool ny_a64_obj_build_bundle(
     snprintf(out_relocs[i].symbol, sizeof(out_relocs[i].symbol), "%s",
              relocs[i].symbol);
     out_relocs[i].disp_off = relocs[i].off;
-    out_relocs[i].type = NY_RELOC_AARCH64_CALL26;
+    out_relocs[i].type = relocs[i].type;
   }
   *out_def_count = def_count;
   *out_reloc_count = reloc_count;
@@ -645,7 +998,9 @@ bool ny_native_emit_elf64_aarch64_object_from_nirs(
     if (di < 0 && ei < 0) goto done;
     uint32_t sym = di >= 0 ? (uint32_t)(1 + di)
                            : (uint32_t)(1 + def_count + (size_t)ei);
-    uint64_t info = ((uint64_t)sym << 32) | 283u; /* R_AARCH64_CALL26 */
+    /* R_AARCH64_ABS64 / R_AARCH64_CALL26 */
+    uint64_t info = ((uint64_t)sym << 32) |
+                    (relocs[i].type == NY_RELOC_AARCH64_ABS64 ? 257u : 283u);
     if (!ny_obj_u64(&file, relocs[i].off) || !ny_obj_u64(&file, info) ||
         !ny_obj_u64(&file, 0)) goto done;
   }
@@ -14,6 +14,7 @@ typedef struct {
 #define NY_RELOC_PC32 1
 #define NY_RELOC_PLT32 2
 #define NY_RELOC_AARCH64_CALL26 3
+#define NY_RELOC_AARCH64_ABS64 4
 
 typedef struct { int64_t label; size_t off; } ny_x64_obj_label_t;
 typedef struct { int64_t label; size_t disp_off; } ny_x64_obj_patch_t;
@@ -35,6 +36,7 @@ typedef struct {
   ny_x64_obj_label_t labels[256]; size_t label_count;
   ny_x64_obj_patch_t patches[256]; size_t patch_count;
   ny_x64_obj_reloc_t relocs[256]; size_t reloc_count;
+  int64_t cur_label; bool has_phi; /* phi edge copies key on the block label */
   char *err; size_t err_len;
 } ny_x64_obj_ctx_t;
 
@@ -439,6 +439,7 @@ static bool ny_port_emit_inst(ny_port_ctx_t *c, const ny_nir_inst_t *in) {
   case NYIR_CAPTURE_RET:
   case NYIR_LOAD_I64:
   case NYIR_STORE_I64:
+  case NYIR_PHI:
   case NYIR_OP_COUNT:
     break;
   }
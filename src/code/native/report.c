@@ -131,6 +131,7 @@ static void ny_native_print_caps(FILE *out, unsigned caps) {
   NY_CAP("elf-object", NY_NATIVE_CAP_ELF_OBJECT);
   NY_CAP("coff-object", NY_NATIVE_CAP_COFF_OBJECT);
   NY_CAP("macho-object", NY_NATIVE_CAP_MACHO_OBJECT);
+  NY_CAP("nir-phi", NY_NATIVE_CAP_NIR_PHI);
 #undef NY_CAP
   if (first)
     fputs("none", out);
@@ -160,8 +161,10 @@ bool ny_native_write_tier_report_for_program(const program_t *prog,
   memset(func_names, 0, sizeof(func_names));
   size_t func_count = 0;
   char local_err[512] = {0};
-  bool built = ny_native_build_nir(prog, opt, &rt_main, funcs, &func_count,
-                                   128, local_err, sizeof(local_err));
+  ny_nir_module_stats_t module_stats = {0};
+  bool built = ny_native_build_nir_with_stats(prog, opt, &rt_main, funcs,
+                                              &func_count, 128, &module_stats,
+                                              local_err, sizeof(local_err));
   if (!built) {
     ny_native_set_err(err, err_len, "native tier report: %s",
                       local_err[0] ? local_err : "failed to build NYIR");
@@ -263,6 +266,15 @@ bool ny_native_write_tier_report_for_program(const program_t *prog,
           vm_profile.steps, vm_profile.call_count, vm_profile.branch_taken,
           vm_profile.branch_not_taken, vm_profile.max_pc,
           vm_profile.max_value_index, vm_profile.max_local_index);
+  fprintf(out,
+          "ipo functions=%zu call_sites=%zu recursive=%zu ipcp_params=%zu "
+          "inline_candidates=%zu inlined=%zu inline_rejected=%zu "
+          "inline_failed=%zu insts=%zu->%zu\n",
+          module_stats.functions, module_stats.call_sites,
+          module_stats.recursive, module_stats.ipcp_params,
+          module_stats.inline_candidates, module_stats.inlined,
+          module_stats.inline_rejected, module_stats.inline_failed,
+          module_stats.before_insts, module_stats.after_insts);
   fprintf(out, "recommend=%s\n",
           ny_native_tier_recommendation_with_profile(
               &plan, &target, &facts, vm_profile_used ? &vm_profile : NULL));
@@ -139,7 +139,8 @@ bool ny_native_target_info_init(ny_native_target_info_t *info,
     info->shadow_space_bytes = 32;
     info->red_zone = false;
     info->caps = NY_NATIVE_CAP_NIR_ASM | NY_NATIVE_CAP_AST_FALLBACK |
-                 NY_NATIVE_CAP_ASM_OBJECT | NY_NATIVE_CAP_NIR_VM;
+                 NY_NATIVE_CAP_ASM_OBJECT | NY_NATIVE_CAP_NIR_VM |
+                 NY_NATIVE_CAP_NIR_PHI;
     if (strcmp(info->object_format, "elf") == 0)
       info->caps |= NY_NATIVE_CAP_ELF_OBJECT;
     else if (strcmp(info->object_format, "coff") == 0)
@@ -154,7 +155,8 @@ bool ny_native_target_info_init(ny_native_target_info_t *info,
     info->shadow_space_bytes = 0;
     info->red_zone = true;
     info->caps = NY_NATIVE_CAP_NIR_ASM | NY_NATIVE_CAP_AST_FALLBACK |
-                 NY_NATIVE_CAP_ASM_OBJECT | NY_NATIVE_CAP_NIR_VM;
+                 NY_NATIVE_CAP_ASM_OBJECT | NY_NATIVE_CAP_NIR_VM |
+                 NY_NATIVE_CAP_NIR_PHI;
     if (strcmp(info->object_format, "elf") == 0)
       info->caps |= NY_NATIVE_CAP_ELF_OBJECT;
     else if (strcmp(info->object_format, "coff") == 0)
@@ -170,7 +172,8 @@ bool ny_native_target_info_init(ny_native_target_info_t *info,
     info->shadow_space_bytes = 0;
     info->red_zone = false;
     info->pointer_bits = 64;
-    info->caps = NY_NATIVE_CAP_NIR_ASM | NY_NATIVE_CAP_NIR_VM;
+    info->caps = NY_NATIVE_CAP_NIR_ASM | NY_NATIVE_CAP_NIR_VM |
+                 NY_NATIVE_CAP_NIR_PHI;
     if (strcmp(info->object_format, "elf") == 0)
       info->caps |= NY_NATIVE_CAP_ASM_OBJECT | NY_NATIVE_CAP_ELF_OBJECT;
   } else if (info->target == NY_NATIVE_TARGET_X86) {
@@ -0,0 +1,343 @@
+#include "base/util.h"
+#include "priv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Profile-guided feedback.
+ *
+ * With NYTRIX_PGO_GEN (--pgo-gen) every direct call to a user function is
+ * preceded by __pgo_site and one __pgo_arg per untyped parameter; the
+ * runtime (rt/pgo.c) turns those into per-site call counts and argument
+ * class histograms. With NYTRIX_PGO_USE (--pgo-use, or nytrix.nypgo under
+ * --profile=peak) that file is read back here:
+ *
+ *  - monomorphization treats an untyped argument that was a small int in
+ *    at least NYTRIX_PGO_BIAS percent of a hot site's calls as int, which
+ *    gives the call the usual guarded fast path;
+ *  - the guard branch gets branch_weights from the same histogram;
+ *  - functions get function_entry_count from the summed site counts, and
+ *    the hottest ones are marked hot and placed in .text.hot.
+ *
+ * Site ids hash the file basename, line, column and callee name, so a
+ * profile stays valid while the profiled lines do not move.
+ */
+
+#define NY_PGO_MAX_ARGS 6
+#define NY_PGO_KINDS 5
+#define NY_PGO_KIND_INT 0
+
+typedef struct {
+  uint64_t site;
+  uint64_t callee;
+  uint64_t calls;
+  uint32_t nargs;
+  uint64_t kinds[NY_PGO_MAX_ARGS][NY_PGO_KINDS];
+} ny_pgo_site_t;
+
+typedef struct {
+  uint64_t callee;
+  uint64_t calls;
+} ny_pgo_callee_t;
+
+static struct {
+  bool loaded;
+  ny_pgo_site_t *sites;
+  size_t nsites;
+  ny_pgo_callee_t *callees;
+  size_t ncallees;
+  uint64_t max_callee_calls;
+} ny_pgo;
+
+bool ny_pgo_gen_enabled(void) {
+  return ny_env_truthy(getenv("NYTRIX_PGO_GEN"));
+}
+
+static int ny_pgo_env_int(const char *name, int fallback) {
+  const char *v = getenv(name);
+  if (!v || !*v)
+    return fallback;
+  char *end = NULL;
+  long n = strtol(v, &end, 10);
+  if (end == v || n < 0)
+    return fallback;
+  return n > 1000000000L ? 1000000000 : (int)n;
+}
+
+static int ny_pgo_cmp_site(const void *a, const void *b) {
+  uint64_t x = ((const ny_pgo_site_t *)a)->site;
+  uint64_t y = ((const ny_pgo_site_t *)b)->site;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int ny_pgo_cmp_callee(const void *a, const void *b) {
+  uint64_t x = ((const ny_pgo_callee_t *)a)->callee;
+  uint64_t y = ((const ny_pgo_callee_t *)b)->callee;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static bool ny_pgo_parse_line(char *p, ny_pgo_site_t *out) {
+  char *end = NULL;
+  memset(out, 0, sizeof(*out));
+  out->site = strtoull(p, &end, 16);
+  if (end == p)
+    return false;
+  p = end;
+  out->callee = strtoull(p, &end, 16);
+  if (end == p)
+    return false;
+  p = end;
+  out->calls = strtoull(p, &end, 10);
+  p = end;
+  unsigned long long nargs = strtoull(p, &end, 10);
+  if (end == p)
+    return false;
+  p = end;
+  out->nargs = nargs > NY_PGO_MAX_ARGS ? NY_PGO_MAX_ARGS : (uint32_t)nargs;
+  for (uint32_t a = 0; a < out->nargs; a++) {
+    for (int k = 0; k < NY_PGO_KINDS; k++) {
+      out->kinds[a][k] = strtoull(p, &end, 10);
+      if (end == p)
+        return false;
+      p = end;
+    }
+  }
+  return true;
+}
+
+static void ny_pgo_build_callees(void) {
+  if (!ny_pgo.nsites)
+    return;
+  ny_pgo.callees = calloc(ny_pgo.nsites, sizeof(*ny_pgo.callees));
+  if (!ny_pgo.callees)
+    return;
+  for (size_t i = 0; i < ny_pgo.nsites; i++) {
+    ny_pgo.callees[i].callee = ny_pgo.sites[i].callee;
+    ny_pgo.callees[i].calls = ny_pgo.sites[i].calls;
+  }
+  qsort(ny_pgo.callees, ny_pgo.nsites, sizeof(*ny_pgo.callees),
+        ny_pgo_cmp_callee);
+  size_t n = 0;
+  for (size_t i = 0; i < ny_pgo.nsites; i++) {
+    if (n && ny_pgo.callees[n - 1].callee == ny_pgo.callees[i].callee)
+      ny_pgo.callees[n - 1].calls += ny_pgo.callees[i].calls;
+    else
+      ny_pgo.callees[n++] = ny_pgo.callees[i];
+  }
+  ny_pgo.ncallees = n;
+  for (size_t i = 0; i < n; i++) {
+    if (ny_pgo.callees[i].calls > ny_pgo.max_callee_calls)
+      ny_pgo.max_callee_calls = ny_pgo.callees[i].calls;
+  }
+}
+
+static void ny_pgo_load(void) {
+  if (ny_pgo.loaded)
+    return;
+  ny_pgo.loaded = true;
+  const char *path = getenv("NYTRIX_PGO_USE");
+  if (!path || !*path || ny_pgo_gen_enabled())
+    return;
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return;
+  char line[1024];
+  if (!fgets(line, sizeof(line), f) || strncmp(line, "NYPGO1", 6) != 0) {
+    fprintf(stderr, "warning: ignoring %s: not a nytrix profile\n", path);
+    fclose(f);
+    return;
+  }
+  size_t cap = 0;
+  while (fgets(line, sizeof(line), f)) {
+    ny_pgo_site_t s;
+    if (!ny_pgo_parse_line(line, &s) || !s.calls)
+      continue;
+    if (ny_pgo.nsites == cap) {
+      size_t ncap = cap ? cap * 2 : 256;
+      ny_pgo_site_t *grown = realloc(ny_pgo.sites, ncap * sizeof(*grown));
+      if (!grown)
+        break;
+      ny_pgo.sites = grown;
+      cap = ncap;
+    }
+    ny_pgo.sites[ny_pgo.nsites++] = s;
+  }
+  fclose(f);
+  if (ny_pgo.nsites)
+    qsort(ny_pgo.sites, ny_pgo.nsites, sizeof(*ny_pgo.sites),
+          ny_pgo_cmp_site);
+  ny_pgo_build_callees();
+  if (ny_env_enabled("NYTRIX_PGO_TRACE"))
+    fprintf(stderr, "[pgo] loaded %zu sites, %zu callees from %s\n",
+            ny_pgo.nsites, ny_pgo.ncallees, path);
+}
+
+bool ny_pgo_use_enabled(void) {
+  ny_pgo_load();
+  return ny_pgo.nsites > 0;
+}
+
+uint64_t ny_pgo_callee_id(const char *callee) {
+  return ny_fnv1a64_cstr(callee ? callee : "", NY_FNV1A64_OFFSET_BASIS);
+}
+
+uint64_t ny_pgo_site_id(token_t tok, const char *callee) {
+  const char *file = tok.filename ? tok.filename : "";
+  const char *base = strrchr(file, '/');
+  base = base ? base + 1 : file;
+  uint64_t h = ny_fnv1a64_cstr(base, NY_FNV1A64_OFFSET_BASIS);
+  h = ny_hash64_u64(h, (uint64_t)(tok.line > 0 ? tok.line : 0));
+  h = ny_hash64_u64(h, (uint64_t)(tok.col > 0 ? tok.col : 0));
+  h = ny_hash64_u64(h, ny_pgo_callee_id(callee));
+  return h ? h : 1;
+}
+
+static const ny_pgo_site_t *ny_pgo_find_site(uint64_t site) {
+  if (!ny_pgo_use_enabled())
+    return NULL;
+  ny_pgo_site_t key = {.site = site};
+  return bsearch(&key, ny_pgo.sites, ny_pgo.nsites, sizeof(*ny_pgo.sites),
+                 ny_pgo_cmp_site);
+}
+
+bool ny_pgo_site_arg_int_counts(uint64_t site, int idx, uint64_t *out_int,
+                                uint64_t *out_calls) {
+  const ny_pgo_site_t *s = ny_pgo_find_site(site);
+  if (!s || idx < 0 || (uint32_t)idx >= s->nargs)
+    return false;
+  if (out_int)
+    *out_int = s->kinds[idx][NY_PGO_KIND_INT];
+  if (out_calls)
+    *out_calls = s->calls;
+  return true;
+}
+
+bool ny_pgo_site_arg_is_hot_int(uint64_t site, int idx) {
+  uint64_t ints = 0, calls = 0;
+  if (!ny_pgo_site_arg_int_counts(site, idx, &ints, &calls))
+    return false;
+  uint64_t min_calls = (uint64_t)ny_pgo_env_int("NYTRIX_PGO_MIN_CALLS", 32);
+  uint64_t bias = (uint64_t)ny_pgo_env_int("NYTRIX_PGO_BIAS", 90);
+  if (bias > 100)
+    bias = 100;
+  return calls >= min_calls && ints * 100u >= calls * bias;
+}
+
+void ny_pgo_set_branch_weights(codegen_t *cg, LLVMValueRef br, uint64_t taken,
+                               uint64_t not_taken) {
+  if (!cg || !br || (!taken && !not_taken))
+    return;
+  /* Keep both weights non-zero and within i32; only the ratio matters. */
+  while (taken > UINT32_MAX - 1u || not_taken > UINT32_MAX - 1u) {
+    taken >>= 1;
+    not_taken >>= 1;
+  }
+  LLVMMetadataRef ops[3] = {
+      LLVMMDStringInContext2(cg->ctx, "branch_weights", 14),
+      LLVMValueAsMetadata(
+          LLVMConstInt(cg->type_i32, taken ? taken : 1, false)),
+      LLVMValueAsMetadata(
+          LLVMConstInt(cg->type_i32, not_taken ? not_taken : 1, false)),
+  };
+  LLVMMetadataRef md = LLVMMDNodeInContext2(cg->ctx, ops, 3);
+  unsigned kind = LLVMGetMDKindIDInContext(cg->ctx, "prof", 4);
+  LLVMSetMetadata(br, kind, LLVMMetadataAsValue(cg->ctx, md));
+}
+
+void ny_pgo_emit_site(codegen_t *cg, token_t tok, fun_sig *sig,
+                      LLVMValueRef *args, size_t argc) {
+  if (!cg || !cg->builder || cg->comptime || !sig || !sig->name ||
+      sig->is_extern || !sig->stmt_t || sig->stmt_t->kind != NY_S_FUNC ||
+      ny_is_stdlib_tok(tok) || !ny_pgo_gen_enabled())
+    return;
+  fun_sig *site_fn = lookup_fun(cg, "__pgo_site", 0);
+  fun_sig *arg_fn = lookup_fun(cg, "__pgo_arg", 0);
+  if (!site_fn || !arg_fn)
+    return;
+  uint64_t site = ny_pgo_site_id(tok, sig->name);
+  LLVMValueRef site_v = LLVMConstInt(cg->type_i64, site, false);
+  LLVMValueRef callee_v =
+      LLVMConstInt(cg->type_i64, ny_pgo_callee_id(sig->name), false);
+  LLVMBuildCall2(cg->builder, site_fn->type, site_fn->value,
+                 (LLVMValueRef[]){site_v, callee_v}, 2, "");
+  ny_param_list *params = &sig->stmt_t->as.fn.params;
+  for (size_t i = 0; i < argc && i < params->len && i < NY_PGO_MAX_ARGS;
+       i++) {
+    if (params->data[i].type || !args[i] ||
+        LLVMTypeOf(args[i]) != cg->type_i64)
+      continue;
+    LLVMValueRef idx_v = LLVMConstInt(cg->type_i64, i, false);
+    LLVMBuildCall2(cg->builder, arg_fn->type, arg_fn->value,
+                   (LLVMValueRef[]){site_v, idx_v, args[i]}, 3, "");
+  }
+}
+
+static uint64_t ny_pgo_callee_calls(const char *name, bool *found) {
+  ny_pgo_callee_t key = {.callee = ny_pgo_callee_id(name)};
+  const ny_pgo_callee_t *c =
+      ny_pgo.callees ? bsearch(&key, ny_pgo.callees, ny_pgo.ncallees,
+                               sizeof(*ny_pgo.callees), ny_pgo_cmp_callee)
+                     : NULL;
+  if (found)
+    *found = c != NULL;
+  return c ? c->calls : 0;
+}
+
+void ny_pgo_annotate_functions(codegen_t *cg) {
+  if (!cg || !cg->module || !ny_pgo_use_enabled())
+    return;
+  uint64_t min_calls = (uint64_t)ny_pgo_env_int("NYTRIX_PGO_MIN_CALLS", 32);
+  uint64_t ratio = (uint64_t)ny_pgo_env_int("NYTRIX_PGO_HOT_RATIO", 100);
+  uint64_t hot_floor = ratio ? ny_pgo.max_callee_calls / ratio : 0;
+  if (hot_floor < min_calls)
+    hot_floor = min_calls;
+  unsigned kind = LLVMGetMDKindIDInContext(cg->ctx, "prof", 4);
+  size_t annotated = 0, hot = 0;
+  for (size_t i = 0; i < cg->fun_sigs.len; i++) {
+    fun_sig *sig = &cg->fun_sigs.data[i];
+    if (!sig->name || !sig->value || sig->is_extern ||
+        LLVMCountBasicBlocks(sig->value) == 0)
+      continue;
+    bool found = false;
+    uint64_t calls = ny_pgo_callee_calls(sig->name, &found);
+    if (!found)
+      continue;
+    LLVMMetadataRef ops[2] = {
+        LLVMMDStringInContext2(cg->ctx, "function_entry_count", 20),
+        LLVMValueAsMetadata(LLVMConstInt(cg->type_i64, calls, false)),
+    };
+    LLVMGlobalSetMetadata(sig->value, kind,
+                          LLVMMDNodeInContext2(cg->ctx, ops, 2));
+    annotated++;
+    if (calls >= hot_floor && !(sig->stmt_t && sig->stmt_t->kind == NY_S_FUNC &&
+                                sig->stmt_t->as.fn.attr_cold)) {
+      add_fn_enum_attr(cg, sig->value, "hot", 0);
+      hot++;
+    }
+  }
+  if (ny_env_enabled("NYTRIX_PGO_TRACE"))
+    fprintf(stderr, "[pgo] entry counts on %zu functions, %zu hot\n",
+            annotated, hot);
+}
+
+void ny_pgo_place_hot_functions(LLVMModuleRef module) {
+#if defined(__APPLE__) || defined(_WIN32)
+  (void)module;
+#else
+  if (!module || !ny_pgo_use_enabled())
+    return;
+  unsigned hot_kind = LLVMGetEnumAttributeKindForName("hot", 3);
+  for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn;
+       fn = LLVMGetNextFunction(fn)) {
+    if (LLVMIsDeclaration(fn))
+      continue;
+    const char *sec = LLVMGetSection(fn);
+    if (sec && *sec)
+      continue;
+    if (LLVMGetEnumAttributeAtIndex(fn, LLVMAttributeFunctionIndex,
+                                    hot_kind))
+      LLVMSetSection(fn, ".text.hot");
+  }
+#endif
+}
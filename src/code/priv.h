@@ -476,6 +476,10 @@ LLVMValueRef ny_untag_int(codegen_t *cg, LLVMValueRef v);
 LLVMValueRef ny_tag_int(codegen_t *cg, LLVMValueRef v);
 LLVMValueRef ny_is_float(codegen_t *cg, LLVMValueRef v);
 LLVMValueRef ny_unbox_float(codegen_t *cg, LLVMValueRef v);
+LLVMValueRef ny_flt_imm_pred(codegen_t *cg, LLVMValueRef v);
+LLVMValueRef ny_flt_payload(codegen_t *cg, LLVMValueRef v, const char *name);
+LLVMValueRef ny_box_f64_bits(codegen_t *cg, LLVMValueRef bits,
+                             fun_sig *box_sig);
 bool ny_module_target_is_apple_arm64(LLVMModuleRef module);
 bool ny_is_proven_int(codegen_t *cg, scope *scopes, size_t depth, expr_t *e, LLVMValueRef v);
 bool ny_is_proven_bool(codegen_t *cg, scope *scopes, size_t depth, expr_t *e, LLVMValueRef v);
@@ -523,6 +527,7 @@ LLVMValueRef gen_closure(codegen_t *cg, scope *scopes, size_t depth, ny_param_li
                          const char *name_hint);
 LLVMValueRef gen_comptime_eval(codegen_t *cg, stmt_t *body);
 bool ny_eval_comptime_if(codegen_t *cg, stmt_t *s, bool *truthy);
+void ny_comptime_session_free(void *session);
 LLVMValueRef gen_call_expr(codegen_t *cg, scope *scopes, size_t depth, expr_t *e);
 void ny_lazy_emit_prepare_reachable(codegen_t *cg);
 void ny_lazy_emit_demand_referenced(codegen_t *cg, scope *gsc, size_t gd,
@@ -537,6 +542,18 @@ void gen_func(codegen_t *cg, stmt_t *fn, const char *name, scope *scopes, size_t
               binding_list *captures);
 void collect_sigs(codegen_t *cg, stmt_t *s);
 void infer_pure_functions(codegen_t *cg);
+bool ny_comptime_memo_key(codegen_t *cg, stmt_t *body, uint64_t *out_key);
+bool ny_pgo_gen_enabled(void);
+bool ny_pgo_use_enabled(void);
+uint64_t ny_pgo_callee_id(const char *callee);
+uint64_t ny_pgo_site_id(token_t tok, const char *callee);
+bool ny_pgo_site_arg_int_counts(uint64_t site, int idx, uint64_t *out_int,
+                                uint64_t *out_calls);
+bool ny_pgo_site_arg_is_hot_int(uint64_t site, int idx);
+void ny_pgo_set_branch_weights(codegen_t *cg, LLVMValueRef br, uint64_t taken,
+                               uint64_t not_taken);
+void ny_pgo_emit_site(codegen_t *cg, token_t tok, fun_sig *sig,
+                      LLVMValueRef *args, size_t argc);
 
 void add_import_alias(codegen_t *cg, const char *alias, const char *full_name);
 void add_import_alias_from_full(codegen_t *cg, const char *full_name);
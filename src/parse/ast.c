@@ -1418,6 +1418,13 @@ char *ny_expr_to_json(expr_t *expr) {
   return json_writer_take(&jw);
 }
 
+char *ny_stmt_to_json(stmt_t *stmt) {
+  json_writer_t jw;
+  json_writer_init(&jw, 512);
+  dump_stmt(stmt, &jw);
+  return json_writer_take(&jw);
+}
+
 static bool ny_ast_token_in_file(token_t tok, const char *filename) {
   if (!filename || !*filename)
     return true;
@@ -5,6 +5,7 @@
 
 char *ny_ast_to_json(program_t *prog);
 char *ny_expr_to_json(expr_t *expr);
+char *ny_stmt_to_json(stmt_t *stmt);
 char *ny_ast_to_json_filtered(program_t *prog, const char *filename);
 char *ny_ast_symbols_to_json_filtered(program_t *prog, const char *filename);
 char *ny_ast_expand_report(program_t *prog, const char *source_name, const char *filter,
@@ -16,6 +16,7 @@
 #include "rt/runtime.h"
 #include "rt/shared.h"
 #include "wire/build.h"
+#include "wire/cache.h"
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
@@ -81,6 +82,7 @@ static int g_repl_exit_hook_registered = 0;
 
 static LLVMContextRef g_repl_ctx = NULL;
 static LLVMExecutionEngineRef g_repl_ee = NULL;
+static ny_orc_repl_t *g_repl_orc = NULL;
 static const ny_options *g_repl_options = NULL;
 
 static bool repl_native_only(void) {
@@ -1947,6 +1949,92 @@ static void map_rt_syms_persistent(LLVMModuleRef mod,
   }
 }
 
+static void repl_run_std_init(uint64_t init_addr) {
+  char *saved_trace = repl_dup_env_value("NYTRIX_TRACE");
+  char *saved_calls = repl_dup_env_value("NYTRIX_TRACE_CALLS");
+  char *saved_values = repl_dup_env_value("NYTRIX_TRACE_VALUES");
+  char *saved_verbose = repl_dup_env_value("NYTRIX_TRACE_VERBOSE");
+  char *saved_filter = repl_dup_env_value("NYTRIX_TRACE_FILTER");
+  int saved_trace_requested = g_trace_requested;
+  int saved_trace_suspended = g_trace_suspended;
+  repl_unsetenv_force("NYTRIX_TRACE");
+  repl_unsetenv_force("NYTRIX_TRACE_CALLS");
+  repl_unsetenv_force("NYTRIX_TRACE_VALUES");
+  repl_unsetenv_force("NYTRIX_TRACE_VERBOSE");
+  repl_unsetenv_force("NYTRIX_TRACE_FILTER");
+  g_trace_requested = 0;
+  g_trace_suspended = 1;
+  rt_trace_refresh_env();
+  ((int64_t (*)(void))init_addr)();
+  if (saved_trace)
+    repl_setenv_force("NYTRIX_TRACE", saved_trace);
+  if (saved_calls)
+    repl_setenv_force("NYTRIX_TRACE_CALLS", saved_calls);
+  if (saved_values)
+    repl_setenv_force("NYTRIX_TRACE_VALUES", saved_values);
+  if (saved_verbose)
+    repl_setenv_force("NYTRIX_TRACE_VERBOSE", saved_verbose);
+  if (saved_filter)
+    repl_setenv_force("NYTRIX_TRACE_FILTER", saved_filter);
+  if (!saved_trace)
+    repl_unsetenv_force("NYTRIX_TRACE");
+  if (!saved_calls)
+    repl_unsetenv_force("NYTRIX_TRACE_CALLS");
+  if (!saved_values)
+    repl_unsetenv_force("NYTRIX_TRACE_VALUES");
+  if (!saved_verbose)
+    repl_unsetenv_force("NYTRIX_TRACE_VERBOSE");
+  if (!saved_filter)
+    repl_unsetenv_force("NYTRIX_TRACE_FILTER");
+  g_trace_requested = saved_trace_requested;
+  g_trace_suspended = saved_trace_suspended;
+  rt_trace_refresh_env();
+  free(saved_trace);
+  free(saved_calls);
+  free(saved_values);
+  free(saved_verbose);
+  free(saved_filter);
+}
+
+static bool repl_orc_requested(void) {
+  if (repl_native_only())
+    return false;
+  const char *engine = g_repl_options ? g_repl_options->jit_engine : NULL;
+  if (!engine)
+    engine = getenv("NYTRIX_JIT_ENGINE");
+  return engine && strcmp(engine, "orc") == 0;
+}
+
+/* Object file for the std prelude, cached by source, target and opt level. */
+static char *repl_orc_std_object(LLVMModuleRef mod, bool *out_temp) {
+  *out_temp = false;
+  uint64_t key = ny_fnv1a64_cstr(
+      g_std_src_cached_persistent ? g_std_src_cached_persistent : "",
+      NY_FNV1A64_OFFSET_BASIS);
+  key = ny_hash64_u64(key, (uint64_t)g_repl_opt_level);
+  key = ny_fnv1a64_cstr(LLVMGetTarget(mod), key);
+  char *cpu = LLVMGetHostCPUName();
+  key = ny_fnv1a64_cstr(cpu ? cpu : "", key);
+  if (cpu)
+    LLVMDisposeMessage(cpu);
+  char *path = ny_repl_std_object_cache_path(key);
+  if (path && ny_access(path, R_OK) == 0)
+    return path;
+  if (!path) {
+    char buf[4096];
+    snprintf(buf, sizeof(buf), "%s/nytrix-repl-std-%016llx.o",
+             ny_get_temp_dir(), (unsigned long long)key);
+    path = ny_strdup(buf);
+    *out_temp = true;
+  }
+  if (!ny_repl_std_object_cache_save(path, mod, g_repl_opt_level)) {
+    free(path);
+    *out_temp = false;
+    return NULL;
+  }
+  return path;
+}
+
 static void repl_init_engine(std_mode_t mode, doc_list_t *docs) {
   if (g_repl_ctx)
     return;
@@ -2046,6 +2134,39 @@ static void repl_init_engine(std_mode_t mode, doc_list_t *docs) {
     else if (!ny_module_target_is_apple_arm64(mod))
       options.EnableFastISel = 1;
   }
+  if (repl_orc_requested()) {
+    bool object_temp = false;
+    char *object_path =
+        std_init_fn_name ? repl_orc_std_object(mod, &object_temp) : NULL;
+    char *orc_err = NULL;
+    if (!std_init_fn_name || object_path)
+      g_repl_orc = ny_orc_repl_create(g_repl_ctx, mod, &g_repl_cg, object_path,
+                                      &orc_err);
+    if (object_temp)
+      remove(object_path);
+    free(object_path);
+    if (!g_repl_orc)
+      fprintf(stderr, "ORC JIT unavailable (%s); using MCJIT\n",
+              orc_err ? orc_err : "could not build std object");
+    free(orc_err);
+  }
+  if (g_repl_orc) {
+    uint64_t init_addr = 0;
+    char *orc_err = NULL;
+    if (std_init_fn_name &&
+        !ny_orc_repl_lookup(g_repl_orc, std_init_fn_name, &init_addr, &orc_err)) {
+      fprintf(stderr, "JIT Error: %s\n", orc_err ? orc_err : "std init missing");
+      init_addr = 0;
+    }
+    free(orc_err);
+    if (init_addr && !ny_jit_prepare_execution(init_addr)) {
+      fprintf(stderr, "JIT code memory is not executable\n");
+      init_addr = 0;
+    }
+    if (init_addr)
+      repl_run_std_init(init_addr);
+    return;
+  }
   char *err = NULL;
   if (LLVMCreateMCJITCompilerForModule(&g_repl_ee, mod, &options,
                                        sizeof(options), &err) != 0) {
@@ -2060,62 +2181,20 @@ static void repl_init_engine(std_mode_t mode, doc_list_t *docs) {
         fprintf(stderr, "JIT code memory is not executable\n");
         init_addr = 0;
       }
-      if (init_addr) {
-        char *saved_trace = repl_dup_env_value("NYTRIX_TRACE");
-        char *saved_calls = repl_dup_env_value("NYTRIX_TRACE_CALLS");
-        char *saved_values = repl_dup_env_value("NYTRIX_TRACE_VALUES");
-        char *saved_verbose = repl_dup_env_value("NYTRIX_TRACE_VERBOSE");
-        char *saved_filter = repl_dup_env_value("NYTRIX_TRACE_FILTER");
-        int saved_trace_requested = g_trace_requested;
-        int saved_trace_suspended = g_trace_suspended;
-        repl_unsetenv_force("NYTRIX_TRACE");
-        repl_unsetenv_force("NYTRIX_TRACE_CALLS");
-        repl_unsetenv_force("NYTRIX_TRACE_VALUES");
-        repl_unsetenv_force("NYTRIX_TRACE_VERBOSE");
-        repl_unsetenv_force("NYTRIX_TRACE_FILTER");
-        g_trace_requested = 0;
-        g_trace_suspended = 1;
-        rt_trace_refresh_env();
-        ((int64_t (*)(void))init_addr)();
-        if (saved_trace)
-          repl_setenv_force("NYTRIX_TRACE", saved_trace);
-        if (saved_calls)
-          repl_setenv_force("NYTRIX_TRACE_CALLS", saved_calls);
-        if (saved_values)
-          repl_setenv_force("NYTRIX_TRACE_VALUES", saved_values);
-        if (saved_verbose)
-          repl_setenv_force("NYTRIX_TRACE_VERBOSE", saved_verbose);
-        if (saved_filter)
-          repl_setenv_force("NYTRIX_TRACE_FILTER", saved_filter);
-        if (!saved_trace)
-          repl_unsetenv_force("NYTRIX_TRACE");
-        if (!saved_calls)
-          repl_unsetenv_force("NYTRIX_TRACE_CALLS");
-        if (!saved_values)
-          repl_unsetenv_force("NYTRIX_TRACE_VALUES");
-        if (!saved_verbose)
-          repl_unsetenv_force("NYTRIX_TRACE_VERBOSE");
-        if (!saved_filter)
-          repl_unsetenv_force("NYTRIX_TRACE_FILTER");
-        g_trace_requested = saved_trace_requested;
-        g_trace_suspended = saved_trace_suspended;
-        rt_trace_refresh_env();
-        free(saved_trace);
-        free(saved_calls);
-        free(saved_values);
-        free(saved_verbose);
-        free(saved_filter);
-      }
+      if (init_addr)
+        repl_run_std_init(init_addr);
     }
   }
 }
 
 static void repl_shutdown_engine(void) {
   LLVMExecutionEngineRef ee = g_repl_ee;
+  ny_orc_repl_t *orc = g_repl_orc;
   LLVMModuleRef module = g_repl_cg.module;
   LLVMContextRef ctx = g_repl_ctx;
 
   g_repl_ee = NULL;
+  g_repl_orc = NULL;
   g_repl_builder = NULL;
   g_repl_ctx = NULL;
   g_repl_cg.ee = NULL;
@@ -2139,7 +2218,9 @@ static void repl_shutdown_engine(void) {
   codegen_dispose(&g_repl_cg);
   memset(&g_repl_cg, 0, sizeof(codegen_t));
 
-  if (ctx) {
+  if (orc) {
+    ny_orc_repl_dispose(orc);
+  } else if (ctx) {
     LLVMContextDispose(ctx);
   }
   g_eval_count = 0;
@@ -2153,6 +2234,7 @@ static void repl_shutdown_engine(void) {
 
 static void repl_drop_engine_refs_on_exit(void) {
   g_repl_ee = NULL;
+  g_repl_orc = NULL;
   g_repl_builder = NULL;
   g_repl_ctx = NULL;
   memset(&g_repl_cg, 0, sizeof(codegen_t));
@@ -2218,6 +2300,43 @@ static bool repl_source_wants_auto_main(const char *src, int from_init) {
   return wants;
 }
 
+/* Rebuild the engine and re-run every persistent definition plus `input`. */
+static int repl_eval_replay(const char *full_input, int is_stmt, char *an,
+                            std_mode_t std_mode, int tty_in, doc_list_t *docs,
+                            bool auto_main_after_rebuild) {
+  char *persistent_src = NULL;
+  if (is_persistent_def(full_input))
+    persistent_src = repl_extract_persistent_source(full_input);
+  size_t prior_len = g_repl_user_source ? strlen(g_repl_user_source) : 0;
+  size_t input_len = strlen(full_input);
+  size_t combined_len = prior_len + input_len + 2;
+  char *combined = malloc(combined_len);
+  if (!combined) {
+    free(persistent_src);
+    return 1;
+  }
+  if (prior_len)
+    memcpy(combined, g_repl_user_source, prior_len);
+  combined[prior_len] = '\n';
+  memcpy(combined + prior_len + 1, full_input, input_len + 1);
+  if (!repl_native_only()) {
+    repl_shutdown_engine();
+    repl_init_engine(std_mode, docs);
+  }
+  int status =
+      repl_eval_snippet(combined, is_stmt, an, std_mode, tty_in, docs, 1);
+  if (status == 0 && persistent_src && *persistent_src) {
+    repl_append_user_source(persistent_src);
+    repl_update_docs(docs, full_input);
+  }
+  if (status == 0 && auto_main_after_rebuild)
+    status = repl_eval_snippet("if(true){\n   main()\n}", 1, NULL, std_mode,
+                               0, docs, 1);
+  free(combined);
+  free(persistent_src);
+  return status;
+}
+
 static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
                              std_mode_t std_mode, int tty_in, doc_list_t *docs,
                              int from_init) {
@@ -2236,39 +2355,10 @@ static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
   }
   bool auto_main_after_rebuild =
       repl_source_wants_auto_main(eval_input, from_init);
-  if (!from_init && g_repl_user_source && *g_repl_user_source) {
-    char *persistent_src = NULL;
-    if (is_persistent_def(full_input))
-      persistent_src = repl_extract_persistent_source(full_input);
-    size_t prior_len = strlen(g_repl_user_source);
-    size_t input_len = strlen(full_input);
-    size_t combined_len = prior_len + input_len + 2;
-    char *combined = malloc(combined_len);
-    if (!combined) {
-      free(persistent_src);
-      free(eval_input_owned);
-      return 1;
-    }
-    memcpy(combined, g_repl_user_source, prior_len);
-    combined[prior_len] = '\n';
-    memcpy(combined + prior_len + 1, full_input, input_len + 1);
-    if (!repl_native_only()) {
-      repl_shutdown_engine();
-      repl_init_engine(std_mode, docs);
-    }
-    int status =
-        repl_eval_snippet(combined, is_stmt, an, std_mode, tty_in, docs, 1);
-    if (status == 0 && persistent_src && *persistent_src) {
-      repl_append_user_source(persistent_src);
-      repl_update_docs(docs, full_input);
-    }
-    if (status == 0 && auto_main_after_rebuild)
-      status = repl_eval_snippet("if(true){\n   main()\n}", 1, NULL, std_mode,
-                                 0, docs, 1);
-    free(combined);
-    free(persistent_src);
+  if (!from_init && !g_repl_orc && g_repl_user_source && *g_repl_user_source) {
     free(eval_input_owned);
-    return status;
+    return repl_eval_replay(full_input, is_stmt, an, std_mode, tty_in, docs,
+                            auto_main_after_rebuild);
   }
   int show_an = (an && std_mode != STD_MODE_NONE && tty_in);
   if (repl_native_only())
@@ -2371,6 +2461,7 @@ static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
   int last_status = 0;
   bool persistent = false;
   bool rebuild_persistent = false;
+  bool orc_rebuild = false;
   if (!ps.had_error) {
     repl_debug_stage("parsed");
     if (repl_program_has_bare_std_use(pr))
@@ -2550,39 +2641,69 @@ static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
       if (!from_init)
         fprintf(stderr, "REPL input failed during compilation.\n");
       last_status = 1;
-    } else if (g_repl_ee) {
-      ny_tick_t t_jit0 = ny_ticks_now();
-      size_t existing_map_len = 0;
-      repl_pending_fn_mapping_t *existing_maps =
-          repl_collect_existing_jit_function_mappings(g_repl_ee, eval_mod,
-                                                      &cg, &existing_map_len);
-      repl_define_existing_jit_function_trampolines(existing_maps,
-                                                    existing_map_len);
-      repl_debug_ir(eval_mod);
-      repl_debug_stage("jit-apply-maps-pre");
-      repl_apply_existing_jit_function_mappings(g_repl_ee, existing_maps,
-                                                existing_map_len);
-      repl_debug_stage("jit-add-module");
-      LLVMAddModule(g_repl_ee, eval_mod);
-      repl_debug_stage("jit-apply-maps");
-      repl_apply_existing_jit_function_mappings(g_repl_ee, existing_maps,
-                                                existing_map_len);
-      free(existing_maps);
-      repl_debug_stage("jit-map-rt");
-      map_rt_syms_persistent(eval_mod, g_repl_ee);
-      repl_debug_stage("jit-register-symbols");
-      register_jit_symbols(g_repl_ee, eval_mod, &cg);
-      for (size_t i = 0; i < cg.interns.len; i++) {
-        if (cg.interns.data[i].gv)
-          LLVMAddGlobalMapping(g_repl_ee, cg.interns.data[i].gv,
-                               (void *)((char *)cg.interns.data[i].data - 64));
-        if (cg.interns.data[i].val)
-          LLVMAddGlobalMapping(g_repl_ee, cg.interns.data[i].val,
-                               &cg.interns.data[i].data);
+    } else if (g_repl_ee || g_repl_orc) {
+      /* Read again after the panic setjmp below; volatile keeps it intact. */
+      volatile ny_tick_t t_jit0 = ny_ticks_now();
+      uint64_t addr = 0;
+      if (g_repl_orc) {
+        if (is_persistent_def(eval_input)) {
+          for (size_t i = g_repl_cg.global_vars.len; i < cg.global_vars.len;
+               i++) {
+            if (cg.global_vars.data[i].value)
+              LLVMSetLinkage(cg.global_vars.data[i].value,
+                             LLVMExternalLinkage);
+          }
+        }
+        repl_debug_ir(eval_mod);
+        repl_debug_stage("orc-add-chunk");
+        bool consumed = false;
+        char *orc_err = NULL;
+        ny_orc_repl_status st = ny_orc_repl_add_chunk(
+            g_repl_orc, eval_mod, &cg, fn_name, &addr, &consumed, &orc_err);
+        if (!consumed)
+          LLVMDisposeModule(eval_mod);
+        cg.module = NULL;
+        if (st == NY_ORC_REPL_REBUILD && !from_init) {
+          orc_rebuild = true;
+        } else if (st != NY_ORC_REPL_OK) {
+          fprintf(stderr, "JIT Error: %s\n",
+                  orc_err ? orc_err : "cannot redefine a prelude symbol");
+          last_status = 1;
+        }
+        free(orc_err);
+      } else {
+        size_t existing_map_len = 0;
+        repl_pending_fn_mapping_t *existing_maps =
+            repl_collect_existing_jit_function_mappings(g_repl_ee, eval_mod,
+                                                        &cg, &existing_map_len);
+        repl_define_existing_jit_function_trampolines(existing_maps,
+                                                      existing_map_len);
+        repl_debug_ir(eval_mod);
+        repl_debug_stage("jit-apply-maps-pre");
+        repl_apply_existing_jit_function_mappings(g_repl_ee, existing_maps,
+                                                  existing_map_len);
+        repl_debug_stage("jit-add-module");
+        LLVMAddModule(g_repl_ee, eval_mod);
+        repl_debug_stage("jit-apply-maps");
+        repl_apply_existing_jit_function_mappings(g_repl_ee, existing_maps,
+                                                  existing_map_len);
+        free(existing_maps);
+        repl_debug_stage("jit-map-rt");
+        map_rt_syms_persistent(eval_mod, g_repl_ee);
+        repl_debug_stage("jit-register-symbols");
+        register_jit_symbols(g_repl_ee, eval_mod, &cg);
+        for (size_t i = 0; i < cg.interns.len; i++) {
+          if (cg.interns.data[i].gv)
+            LLVMAddGlobalMapping(g_repl_ee, cg.interns.data[i].gv,
+                                 (void *)((char *)cg.interns.data[i].data - 64));
+          if (cg.interns.data[i].val)
+            LLVMAddGlobalMapping(g_repl_ee, cg.interns.data[i].val,
+                                 &cg.interns.data[i].data);
+        }
+        (void)cg.global_vars;
+        repl_debug_stage("jit-get-address");
+        addr = LLVMGetFunctionAddress(g_repl_ee, fn_name);
       }
-      (void)cg.global_vars;
-      repl_debug_stage("jit-get-address");
-      uint64_t addr = LLVMGetFunctionAddress(g_repl_ee, fn_name);
       if (addr && !ny_jit_prepare_execution(addr)) {
         fprintf(stderr, "JIT code memory is not executable\n");
         last_status = 1;
@@ -2671,7 +2792,7 @@ static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
           for (size_t i = 0; i < cg.global_vars.len; i++) {
             if (i >= g_repl_cg.global_vars.len) {
               binding b = cg.global_vars.data[i];
-              if (b.value)
+              if (b.value && !g_repl_orc)
                 LLVMSetLinkage(b.value, LLVMExternalLinkage);
               b.name = ny_strdup(b.name);
               b.owned = true;
@@ -2859,6 +2980,9 @@ static int repl_eval_snippet(const char *full_input, int is_stmt, char *an,
   if (eval_input_owned)
     free(eval_input_owned);
   (void)rebuild_persistent;
+  if (orc_rebuild)
+    return repl_eval_replay(full_input, is_stmt, an, std_mode, tty_in, docs,
+                            repl_source_wants_auto_main(full_input, 0));
   return last_status;
 }
 
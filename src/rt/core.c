@@ -1267,7 +1267,7 @@ int64_t rt_mat4_to_buffer(int64_t m_lst, int64_t buf_ptr) {
     if (is_int(v)) {
       dv = (double)(v >> 1);
     } else if (is_v_flt(v)) {
-      memcpy(&dv, (void *)(uintptr_t)v, 8);
+      dv = rt_flt_payload(v);
     } else {
       dv = 0.0;
     }
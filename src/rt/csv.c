@@ -0,0 +1,865 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Streaming CSV reader for std.math.parse.data.csv.
+ *
+ * The input is a string, a read-only mapping of a file, or (when a file
+ * cannot be mapped) a window refilled with fread. It is indexed one region
+ * at a time: 64-byte blocks are classified into quote, separator and line
+ * break masks (AVX2, SSE2 or NEON where available), the running quote parity
+ * turns quotes into an in-field mask, and every separator or line break
+ * outside quotes lands in the index with its row-end flag. A region always
+ * starts at a row boundary and is cut after its last complete row.
+ *
+ * Large regions are split across threads. Each chunk first counts its quotes;
+ * the prefix parity of those counts tells every chunk whether it starts inside
+ * a quoted field, after which the chunks index independently and their
+ * entries are concatenated.
+ *
+ * Rows come out as lists of strings, or as typed columns: each column is
+ * sniffed as int, float or str over the batch and only ever widens across
+ * batches, unless the caller pins its type.
+ */
+
+extern int64_t rt_list_new(int64_t n);
+extern int64_t rt_append(int64_t lst, int64_t val);
+
+#define RT_CSV_MAGIC UINT64_C(0x4e59435356524452)
+#define RT_CSV_CHUNK ((size_t)4 << 20)
+#define RT_CSV_MAX_REGION ((size_t)1 << 30)
+#define RT_CSV_END UINT32_C(0x80000000)
+#define RT_CSV_POS(e) ((size_t)((e) & ~RT_CSV_END))
+#define RT_CSV_MAX_THREADS RT_MAX_THREADS
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) &&           \
+    (defined(__GNUC__) || defined(__clang__))
+#define RT_CSV_X86_DISPATCH 1
+#endif
+
+enum { RT_CSV_Q, RT_CSV_SEP, RT_CSV_NL, RT_CSV_CR, RT_CSV_NCLASS };
+
+/* Column types, ordered so that widening is max(). */
+enum { RT_CSV_T_NONE = 0, RT_CSV_T_INT = 1, RT_CSV_T_FLOAT = 2, RT_CSV_T_STR = 3 };
+
+typedef struct rt_csv {
+  uint64_t magic;
+  const char *data; /* the source string, the mapping or buf */
+  size_t dlen;
+  bool eof; /* data holds the rest of the input */
+  size_t pos; /* first byte of the next unindexed row */
+  uint8_t sep;
+  /* Index of data[ibase, ibase + ilen) */
+  uint32_t *idx;
+  size_t nidx;
+  size_t idx_cap;
+  size_t cursor;
+  size_t ibase;
+  size_t ilen;
+  size_t row_start; /* relative to ibase */
+  /* Sources */
+  FILE *fp;
+  char *buf;
+  size_t cap;
+  void *map;
+  size_t map_len;
+  /* Typed columns */
+  uint8_t *types;
+  uint8_t *pinned;
+  size_t ncols;
+  size_t types_cap;
+  char *scratch;
+  size_t scratch_cap;
+  uint32_t *cells; /* per batch: offset and length pairs */
+  size_t cells_cap;
+  uint32_t *rows_at; /* per batch: first cell of each row */
+  size_t rows_cap;
+  /* Per-thread index chunks */
+  uint32_t *tout[RT_CSV_MAX_THREADS];
+  size_t tcap[RT_CSV_MAX_THREADS];
+  int64_t rows;
+  bool oom;
+} rt_csv_t;
+
+static int g_rt_csv_threads = -1;
+
+static rt_csv_t *rt_csv_handle(int64_t v) {
+  if (!is_ptr(v))
+    return NULL;
+  uintptr_t p = (uintptr_t)v;
+  if (!rt_addr_readable_safe(p, sizeof(uint64_t)))
+    return NULL;
+  rt_csv_t *r = (rt_csv_t *)p;
+  return r->magic == RT_CSV_MAGIC ? r : NULL;
+}
+
+static inline int64_t rt_csv_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static int64_t rt_csv_list(int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (lst)
+    *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+static inline void rt_csv_list_set(int64_t lst, int64_t i, int64_t v) {
+  *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = v;
+}
+
+static bool rt_csv_reserve(void **p, size_t *cap, size_t want, size_t elem) {
+  if (want <= *cap)
+    return true;
+  size_t nc = *cap ? *cap : 256;
+  while (nc < want)
+    nc *= 2;
+  void *np = realloc(*p, nc * elem);
+  if (!np)
+    return false;
+  *p = np;
+  *cap = nc;
+  return true;
+}
+
+static int rt_csv_thread_count(void) {
+  return rt_thread_count(&g_rt_csv_threads, "NYTRIX_CSV_THREADS", 0, RT_CSV_MAX_THREADS);
+}
+
+/* ---- Block classification ------------------------------------------------ */
+
+static void rt_csv_classify_scalar(const uint8_t *p, uint8_t sep, uint64_t m[RT_CSV_NCLASS]) {
+  uint64_t q = 0, s = 0, nl = 0, cr = 0;
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = UINT64_C(1) << i;
+    uint8_t c = p[i];
+    if (c == '"')
+      q |= bit;
+    else if (c == sep)
+      s |= bit;
+    else if (c == '\n')
+      nl |= bit;
+    else if (c == '\r')
+      cr |= bit;
+  }
+  m[RT_CSV_Q] = q;
+  m[RT_CSV_SEP] = s;
+  m[RT_CSV_NL] = nl;
+  m[RT_CSV_CR] = cr;
+}
+
+#if defined(RT_CSV_X86_DISPATCH)
+__attribute__((target("avx2"))) static void rt_csv_classify_avx2(const uint8_t *p, uint8_t sep,
+                                                                 uint64_t m[RT_CSV_NCLASS]) {
+  const __m256i quote = _mm256_set1_epi8('"'), sv = _mm256_set1_epi8((char)sep);
+  const __m256i nl = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+  uint64_t out[RT_CSV_NCLASS] = {0};
+  for (int h = 0; h < 2; h++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + h * 32));
+    int sh = h * 32;
+    out[RT_CSV_Q] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << sh;
+    out[RT_CSV_SEP] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, sv)) << sh;
+    out[RT_CSV_NL] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)) << sh;
+    out[RT_CSV_CR] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr)) << sh;
+  }
+  memcpy(m, out, sizeof(out));
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+static void rt_csv_classify_sse2(const uint8_t *p, uint8_t sep, uint64_t m[RT_CSV_NCLASS]) {
+  const __m128i quote = _mm_set1_epi8('"'), sv = _mm_set1_epi8((char)sep);
+  const __m128i nl = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+  uint64_t out[RT_CSV_NCLASS] = {0};
+  for (int h = 0; h < 4; h++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + h * 16));
+    int sh = h * 16;
+    out[RT_CSV_Q] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << sh;
+    out[RT_CSV_SEP] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, sv)) << sh;
+    out[RT_CSV_NL] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << sh;
+    out[RT_CSV_CR] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr)) << sh;
+  }
+  memcpy(m, out, sizeof(out));
+}
+#endif
+#elif defined(__aarch64__)
+static inline uint64_t rt_csv_neon_mask(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+  const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t s0 = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+  uint8x16_t s1 = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+  s0 = vpaddq_u8(s0, s1);
+  s0 = vpaddq_u8(s0, s0);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+
+static void rt_csv_classify_neon(const uint8_t *p, uint8_t sep, uint64_t m[RT_CSV_NCLASS]) {
+  uint8x16_t q[4], s[4], nl[4], cr[4];
+  for (int h = 0; h < 4; h++) {
+    uint8x16_t v = vld1q_u8(p + h * 16);
+    q[h] = vceqq_u8(v, vdupq_n_u8('"'));
+    s[h] = vceqq_u8(v, vdupq_n_u8(sep));
+    nl[h] = vceqq_u8(v, vdupq_n_u8('\n'));
+    cr[h] = vceqq_u8(v, vdupq_n_u8('\r'));
+  }
+  m[RT_CSV_Q] = rt_csv_neon_mask(q[0], q[1], q[2], q[3]);
+  m[RT_CSV_SEP] = rt_csv_neon_mask(s[0], s[1], s[2], s[3]);
+  m[RT_CSV_NL] = rt_csv_neon_mask(nl[0], nl[1], nl[2], nl[3]);
+  m[RT_CSV_CR] = rt_csv_neon_mask(cr[0], cr[1], cr[2], cr[3]);
+}
+#endif
+
+typedef void (*rt_csv_classify_fn)(const uint8_t *, uint8_t, uint64_t *);
+
+static rt_csv_classify_fn rt_csv_classifier(void) {
+  static rt_csv_classify_fn fn = NULL;
+  if (fn)
+    return fn;
+  rt_csv_classify_fn pick = rt_csv_classify_scalar;
+#if defined(RT_CSV_X86_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    pick = rt_csv_classify_avx2;
+#if defined(__SSE2__) || defined(_M_X64)
+  else
+    pick = rt_csv_classify_sse2;
+#endif
+#elif defined(__aarch64__)
+  pick = rt_csv_classify_neon;
+#endif
+  if (getenv("NYTRIX_CSV_SCALAR"))
+    pick = rt_csv_classify_scalar;
+  fn = pick;
+  return fn;
+}
+
+static inline uint64_t rt_csv_prefix_xor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/* Classifies the block at p[b]; the last partial block is read through a copy. */
+static inline void rt_csv_block(rt_csv_classify_fn classify, const uint8_t *p, size_t b, size_t len,
+                                uint8_t sep, uint64_t m[RT_CSV_NCLASS]) {
+  if (b + 64 <= len) {
+    classify(p + b, sep, m);
+    return;
+  }
+  uint8_t tmp[64];
+  memset(tmp, 0, sizeof(tmp));
+  memcpy(tmp, p + b, len - b);
+  classify(tmp, sep, m);
+  uint64_t keep = (UINT64_C(1) << (len - b)) - 1;
+  for (int k = 0; k < RT_CSV_NCLASS; k++)
+    m[k] &= keep;
+}
+
+/* ---- Chunk indexing -------------------------------------------------------- */
+
+typedef struct {
+  const uint8_t *p; /* chunk start */
+  size_t len;
+  size_t base; /* chunk offset inside the region */
+  uint8_t sep;
+  int pass; /* 0: quote parity, 1: index */
+  bool odd; /* pass 0 result */
+  uint64_t in_quote; /* pass 1 input: all ones when the chunk starts in a field */
+  uint32_t **out;
+  size_t *cap;
+  size_t n;
+  bool ok;
+} rt_csv_task_t;
+
+static void rt_csv_task_run(void *arg) {
+  rt_csv_task_t *t = (rt_csv_task_t *)arg;
+  rt_csv_classify_fn classify = rt_csv_classifier();
+  uint64_t m[RT_CSV_NCLASS];
+  if (t->pass == 0) {
+    uint64_t odd = 0;
+    for (size_t b = 0; b < t->len; b += 64) {
+      rt_csv_block(classify, t->p, b, t->len, t->sep, m);
+      odd ^= (uint64_t)__builtin_popcountll(m[RT_CSV_Q]);
+    }
+    t->odd = odd & 1;
+    return;
+  }
+  uint64_t in_prev = t->in_quote;
+  t->n = 0;
+  t->ok = true;
+  for (size_t b = 0; b < t->len; b += 64) {
+    if (!rt_csv_reserve((void **)t->out, t->cap, t->n + 64, sizeof(uint32_t))) {
+      t->ok = false;
+      return;
+    }
+    rt_csv_block(classify, t->p, b, t->len, t->sep, m);
+    uint64_t in_field = rt_csv_prefix_xor(m[RT_CSV_Q]) ^ in_prev;
+    in_prev = (uint64_t)((int64_t)in_field >> 63);
+    uint64_t end = (m[RT_CSV_NL] | m[RT_CSV_CR]) & ~in_field;
+    uint64_t s = (m[RT_CSV_SEP] & ~in_field) | end;
+    uint32_t *out = *t->out + t->n;
+    size_t n = 0;
+    uint32_t at = (uint32_t)(t->base + b);
+    while (s) {
+      int tz = __builtin_ctzll(s);
+      out[n++] = (at + (uint32_t)tz) | ((end >> tz) & 1 ? RT_CSV_END : 0);
+      s &= s - 1;
+    }
+    t->n += n;
+  }
+}
+
+/* Indexes data[base, base + len), which starts at a row boundary. */
+static bool rt_csv_index(rt_csv_t *r, size_t base, size_t len) {
+  const uint8_t *p = (const uint8_t *)r->data + base;
+  int threads = rt_csv_thread_count();
+  if ((size_t)threads > len / RT_CSV_CHUNK)
+    threads = (int)(len / RT_CSV_CHUNK);
+  if (threads < 1)
+    threads = 1;
+  rt_csv_task_t tasks[RT_CSV_MAX_THREADS];
+  if (threads == 1) {
+    memset(&tasks[0], 0, sizeof(tasks[0]));
+    tasks[0] = (rt_csv_task_t){.p = p, .len = len, .sep = r->sep, .pass = 1,
+                               .out = &r->idx, .cap = &r->idx_cap};
+    rt_csv_task_run(&tasks[0]);
+    r->nidx = tasks[0].n;
+    return tasks[0].ok;
+  }
+  size_t step = (len / (size_t)threads + 63) & ~(size_t)63;
+  for (int i = 0; i < threads; i++) {
+    size_t off = step * (size_t)i < len ? step * (size_t)i : len;
+    size_t n = i == threads - 1 ? len - off : (len - off < step ? len - off : step);
+    tasks[i] = (rt_csv_task_t){.p = p + off, .len = n, .base = off, .sep = r->sep,
+                               .out = &r->tout[i], .cap = &r->tcap[i]};
+  }
+  rt_parallel_run(rt_csv_task_run, tasks, sizeof(tasks[0]), threads);
+  uint64_t in_quote = 0;
+  for (int i = 0; i < threads; i++) {
+    tasks[i].pass = 1;
+    tasks[i].in_quote = in_quote;
+    if (tasks[i].odd)
+      in_quote = ~in_quote;
+  }
+  rt_parallel_run(rt_csv_task_run, tasks, sizeof(tasks[0]), threads);
+  size_t total = 0;
+  for (int i = 0; i < threads; i++) {
+    if (!tasks[i].ok)
+      return false;
+    total += tasks[i].n;
+  }
+  if (!rt_csv_reserve((void **)&r->idx, &r->idx_cap, total, sizeof(uint32_t)))
+    return false;
+  r->nidx = 0;
+  for (int i = 0; i < threads; i++) {
+    memcpy(r->idx + r->nidx, *tasks[i].out, tasks[i].n * sizeof(uint32_t));
+    r->nidx += tasks[i].n;
+  }
+  return true;
+}
+
+/* ---- Regions ----------------------------------------------------------------- */
+
+/* Moves the unconsumed input to the front of the window and reads up to want bytes. */
+static bool rt_csv_refill(rt_csv_t *r, size_t want) {
+  size_t keep = r->dlen - r->pos;
+  if (keep && r->pos)
+    memmove(r->buf, r->buf + r->pos, keep);
+  r->pos = 0;
+  r->dlen = keep;
+  if (!rt_csv_reserve((void **)&r->buf, &r->cap, want, 1))
+    return false;
+  r->data = r->buf;
+  while (r->dlen < want && !r->eof) {
+    size_t got = fread(r->buf + r->dlen, 1, want - r->dlen, r->fp);
+    r->dlen += got;
+    if (got == 0)
+      r->eof = true;
+  }
+  return true;
+}
+
+/* Indexes the next region; returns 1 when it holds at least one row, 0 at the
+   end of the input and -1 when memory runs out. */
+static int rt_csv_load(rt_csv_t *r) {
+  if (r->ilen) {
+    r->pos = r->ibase + (r->row_start < r->ilen ? r->row_start : r->ilen);
+    r->ilen = 0;
+  }
+  r->nidx = r->cursor = r->row_start = 0;
+  size_t want = RT_CSV_CHUNK * (size_t)rt_csv_thread_count();
+  for (;;) {
+    if (r->fp && !r->eof && r->dlen - r->pos < want && !rt_csv_refill(r, want))
+      return -1;
+    size_t avail = r->dlen - r->pos;
+    if (!avail && r->eof)
+      return 0;
+    size_t n = avail < want ? avail : want;
+    bool last = r->eof && n == avail;
+    if (!rt_csv_index(r, r->pos, n))
+      return -1;
+    const uint8_t *p = (const uint8_t *)r->data + r->pos;
+    size_t k = r->nidx;
+    while (k && !(r->idx[k - 1] & RT_CSV_END))
+      k--;
+    if (last) {
+      size_t tail = k ? RT_CSV_POS(r->idx[k - 1]) + 1 : 0;
+      if (r->nidx > k || tail < n) {
+        if (!rt_csv_reserve((void **)&r->idx, &r->idx_cap, r->nidx + 1, sizeof(uint32_t)))
+          return -1;
+        r->idx[r->nidx++] = (uint32_t)n | RT_CSV_END;
+      }
+      r->ibase = r->pos;
+      r->ilen = n;
+      return r->nidx ? 1 : 0;
+    }
+    /* A trailing CR may pair with an LF in the next region. */
+    if (k && RT_CSV_POS(r->idx[k - 1]) == n - 1 && p[n - 1] == '\r') {
+      k--;
+      while (k && !(r->idx[k - 1] & RT_CSV_END))
+        k--;
+    }
+    if (k) {
+      r->nidx = k;
+      r->ibase = r->pos;
+      r->ilen = RT_CSV_POS(r->idx[k - 1]) + 1;
+      return 1;
+    }
+    if (want >= RT_CSV_MAX_REGION)
+      return -1;
+    want *= 2;
+  }
+}
+
+/* Makes sure the index holds another row; false at the end or on failure. */
+static bool rt_csv_ready(rt_csv_t *r) {
+  if (r->cursor < r->nidx)
+    return true;
+  int rc = rt_csv_load(r);
+  if (rc < 0)
+    r->oom = true;
+  return rc > 0;
+}
+
+/* Walks one row from the cursor, writing offset/length pairs to r->cells from
+   pair `at` on. Returns the number of cells, or -1 when memory runs out. */
+static int64_t rt_csv_row_cells(rt_csv_t *r, size_t at) {
+  const char *base = r->data + r->ibase;
+  size_t cs = r->row_start;
+  int64_t n = 0;
+  at *= 2;
+  for (size_t k = r->cursor; k < r->nidx; k++) {
+    if (!rt_csv_reserve((void **)&r->cells, &r->cells_cap, at + 2, sizeof(uint32_t)))
+      return -1;
+    uint32_t e = r->idx[k];
+    size_t p = RT_CSV_POS(e);
+    r->cells[at++] = (uint32_t)cs;
+    r->cells[at++] = (uint32_t)(p - cs);
+    n++;
+    cs = p + 1;
+    if (e & RT_CSV_END) {
+      if (p < r->ilen && base[p] == '\r' && k + 1 < r->nidx &&
+          r->idx[k + 1] == ((uint32_t)(p + 1) | RT_CSV_END) && base[p + 1] == '\n') {
+        k++;
+        cs++;
+      }
+      r->cursor = k + 1;
+      r->row_start = cs;
+      r->rows++;
+      return n;
+    }
+  }
+  r->cursor = r->nidx;
+  return n;
+}
+
+/* ---- Cells --------------------------------------------------------------------- */
+
+/* Removes field quoting: quotes toggle quoted mode and "" inside it is a quote. */
+static size_t rt_csv_unquote(const char *s, size_t n, char *out) {
+  bool in_q = false;
+  size_t o = 0;
+  for (size_t i = 0; i < n; i++) {
+    char c = s[i];
+    if (c != '"') {
+      out[o++] = c;
+    } else if (in_q && i + 1 < n && s[i + 1] == '"') {
+      out[o++] = '"';
+      i++;
+    } else {
+      in_q = !in_q;
+    }
+  }
+  return o;
+}
+
+/* Returns the cell bytes with quoting removed; quoted cells go through scratch. */
+static const char *rt_csv_cell(rt_csv_t *r, const uint32_t *cell, char *scratch, size_t *len) {
+  const char *s = r->data + r->ibase + cell[0];
+  size_t n = cell[1];
+  if (!memchr(s, '"', n)) {
+    *len = n;
+    return s;
+  }
+  *len = rt_csv_unquote(s, n, scratch);
+  return scratch;
+}
+
+static int64_t rt_csv_str(rt_csv_t *r, const uint32_t *cell) {
+  size_t n;
+  const char *s = rt_csv_cell(r, cell, r->scratch, &n);
+  return rt_alloc_string_len(s, n);
+}
+
+/* Classifies a cell as RT_CSV_T_NONE (empty), INT, FLOAT or STR. */
+static int rt_csv_sniff(const char *s, size_t n, int64_t *iv, double *dv, char *tmp) {
+  if (!n)
+    return RT_CSV_T_NONE;
+  size_t i = 0;
+  bool neg = false;
+  if (s[0] == '-' || s[0] == '+') {
+    neg = s[0] == '-';
+    i++;
+  }
+  size_t int_start = i;
+  uint64_t v = 0;
+  while (i < n && s[i] >= '0' && s[i] <= '9') {
+    if (i - int_start < 19)
+      v = v * 10 + (uint64_t)(s[i] - '0');
+    i++;
+  }
+  size_t int_digits = i - int_start;
+  if (i == n && int_digits) {
+    if (int_digits < 19 && v < (UINT64_C(1) << 62)) {
+      *iv = neg ? -(int64_t)v : (int64_t)v;
+      return RT_CSV_T_INT;
+    }
+  } else {
+    size_t frac_digits = 0;
+    if (i < n && s[i] == '.') {
+      i++;
+      while (i < n && s[i] >= '0' && s[i] <= '9') {
+        i++;
+        frac_digits++;
+      }
+    }
+    if (!int_digits && !frac_digits)
+      return RT_CSV_T_STR;
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+      i++;
+      if (i < n && (s[i] == '-' || s[i] == '+'))
+        i++;
+      size_t exp_start = i;
+      while (i < n && s[i] >= '0' && s[i] <= '9')
+        i++;
+      if (i == exp_start)
+        return RT_CSV_T_STR;
+    }
+    if (i != n)
+      return RT_CSV_T_STR;
+  }
+  memmove(tmp, s, n);
+  tmp[n] = '\0';
+  *dv = strtod(tmp, NULL);
+  return RT_CSV_T_FLOAT;
+}
+
+static int64_t rt_csv_float(double d) {
+  int64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return rt_flt_box_val(bits);
+}
+
+static bool rt_csv_grow_types(rt_csv_t *r, size_t ncols) {
+  if (ncols <= r->ncols)
+    return true;
+  size_t old = r->types_cap;
+  if (ncols > r->types_cap) {
+    size_t nc = r->types_cap ? r->types_cap : 16;
+    while (nc < ncols)
+      nc *= 2;
+    uint8_t *t = (uint8_t *)realloc(r->types, nc);
+    if (!t)
+      return false;
+    r->types = t;
+    uint8_t *pn = (uint8_t *)realloc(r->pinned, nc);
+    if (!pn)
+      return false;
+    r->pinned = pn;
+    memset(r->types + old, 0, nc - old);
+    memset(r->pinned + old, 0, nc - old);
+    r->types_cap = nc;
+  }
+  r->ncols = ncols;
+  return true;
+}
+
+/* ---- Handles --------------------------------------------------------------------- */
+
+static void rt_csv_release(rt_csv_t *r) {
+  if (!r)
+    return;
+  r->magic = 0;
+  if (r->fp)
+    fclose(r->fp);
+#if !defined(_WIN32)
+  if (r->map)
+    munmap(r->map, r->map_len);
+#endif
+  free(r->buf);
+  free(r->idx);
+  free(r->types);
+  free(r->pinned);
+  free(r->scratch);
+  free(r->cells);
+  free(r->rows_at);
+  for (int i = 0; i < RT_CSV_MAX_THREADS; i++)
+    free(r->tout[i]);
+  free(r);
+}
+
+/* Maps a regular file read-only; false leaves the reader on buffered reads. */
+static bool rt_csv_map(rt_csv_t *r, FILE *fp) {
+#if defined(_WIN32)
+  (void)r;
+  (void)fp;
+  return false;
+#else
+  struct stat st;
+  int fd = fileno(fp);
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    return false;
+  size_t n = (size_t)st.st_size;
+  void *m = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (m == MAP_FAILED)
+    return false;
+#if defined(MADV_SEQUENTIAL)
+  madvise(m, n, MADV_SEQUENTIAL);
+#endif
+  r->map = m;
+  r->map_len = n;
+  r->data = (const char *)m;
+  r->dlen = n;
+  r->eof = true;
+  return true;
+#endif
+}
+
+/* Reserves scratch space for unquoting any cell of the current region. */
+static bool rt_csv_scratch(rt_csv_t *r) {
+  return rt_csv_reserve((void **)&r->scratch, &r->scratch_cap, r->ilen + 1, 1);
+}
+
+/* ---- Builtins ---------------------------------------------------------------------- */
+
+int64_t rt_csv_open(int64_t src_v, int64_t is_path_v, int64_t sep_v) {
+  if (!is_v_str(src_v))
+    return 0;
+  uint8_t sep = ',';
+  if (is_v_str(sep_v) && rt_tagged_str_len(sep_v) > 0)
+    sep = *(const uint8_t *)(uintptr_t)sep_v;
+  if (sep == '"' || sep == '\n' || sep == '\r' || sep == 0)
+    return 0;
+  rt_csv_t *r = (rt_csv_t *)calloc(1, sizeof(rt_csv_t));
+  if (!r)
+    return 0;
+  r->magic = RT_CSV_MAGIC;
+  r->sep = sep;
+  if (rt_is_truthy(is_path_v)) {
+    FILE *fp = fopen((const char *)(uintptr_t)src_v, "rb");
+    if (!fp) {
+      rt_csv_release(r);
+      return 0;
+    }
+    if (rt_csv_map(r, fp))
+      fclose(fp);
+    else
+      r->fp = fp;
+  } else {
+    r->data = (const char *)(uintptr_t)src_v;
+    r->dlen = rt_tagged_str_len(src_v);
+    r->eof = true;
+  }
+  return (int64_t)(uintptr_t)r;
+}
+
+int64_t rt_csv_close(int64_t h_v) {
+  rt_csv_release(rt_csv_handle(h_v));
+  return 0;
+}
+
+int64_t rt_csv_rows(int64_t h_v, int64_t n_v) {
+  rt_csv_t *r = rt_csv_handle(h_v);
+  int64_t want = rt_csv_int_arg(n_v);
+  if (!r)
+    return 0;
+  int64_t out = rt_list_new(rt_tag_v(want > 0 && want < 4096 ? want : 4096));
+  if (!out)
+    return 0;
+  for (int64_t got = 0; want <= 0 || got < want; got++) {
+    if (!rt_csv_ready(r) || !rt_csv_scratch(r))
+      break;
+    int64_t n = rt_csv_row_cells(r, 0);
+    if (n < 0) {
+      r->oom = true;
+      break;
+    }
+    int64_t row = rt_csv_list(n);
+    if (!row)
+      break;
+    for (int64_t c = 0; c < n; c++)
+      rt_csv_list_set(row, c, rt_csv_str(r, r->cells + c * 2));
+    out = rt_append(out, row);
+  }
+  return out;
+}
+
+int64_t rt_csv_columns(int64_t h_v, int64_t n_v) {
+  rt_csv_t *r = rt_csv_handle(h_v);
+  int64_t want = rt_csv_int_arg(n_v);
+  if (!r || !rt_csv_ready(r) || !rt_csv_scratch(r))
+    return 0;
+  /* Gather the batch from the current region so cell offsets stay valid. */
+  size_t nrows = 0, ncells = 0, width = r->ncols;
+  while ((want <= 0 || (int64_t)nrows < want) && r->cursor < r->nidx) {
+    if (!rt_csv_reserve((void **)&r->rows_at, &r->rows_cap, nrows + 2, sizeof(uint32_t)))
+      return 0;
+    int64_t n = rt_csv_row_cells(r, ncells);
+    if (n < 0)
+      return 0;
+    r->rows_at[nrows++] = (uint32_t)ncells;
+    ncells += (size_t)n;
+    if ((size_t)n > width)
+      width = (size_t)n;
+  }
+  r->rows_at[nrows] = (uint32_t)ncells;
+  if (!rt_csv_grow_types(r, width))
+    return 0;
+  char *tmp = r->scratch;
+  for (size_t c = 0; c < width; c++) {
+    int t = r->pinned[c] ? r->pinned[c] : r->types[c];
+    if (!r->pinned[c]) {
+      for (size_t i = 0; i < nrows && t < RT_CSV_T_STR; i++) {
+        if (c >= r->rows_at[i + 1] - r->rows_at[i])
+          continue;
+        size_t len;
+        const char *s = rt_csv_cell(r, r->cells + (r->rows_at[i] + c) * 2, tmp, &len);
+        int64_t iv;
+        double dv;
+        int k = rt_csv_sniff(s, len, &iv, &dv, tmp);
+        if (k > t)
+          t = k;
+      }
+      r->types[c] = (uint8_t)t;
+    }
+  }
+  int64_t cols = rt_csv_list((int64_t)width);
+  if (!cols)
+    return 0;
+  for (size_t c = 0; c < width; c++) {
+    int t = r->pinned[c] ? r->pinned[c] : r->types[c];
+    int64_t col = rt_csv_list((int64_t)nrows);
+    if (!col)
+      return 0;
+    rt_csv_list_set(cols, (int64_t)c, col);
+    for (size_t i = 0; i < nrows; i++) {
+      int64_t v = 0;
+      if (c < r->rows_at[i + 1] - r->rows_at[i]) {
+        const uint32_t *cell = r->cells + (r->rows_at[i] + c) * 2;
+        if (t == RT_CSV_T_STR || t == RT_CSV_T_NONE) {
+          v = rt_csv_str(r, cell);
+        } else {
+          size_t len;
+          const char *s = rt_csv_cell(r, cell, tmp, &len);
+          int64_t iv = 0;
+          double dv = 0;
+          int k = rt_csv_sniff(s, len, &iv, &dv, tmp);
+          if (k == RT_CSV_T_INT)
+            v = t == RT_CSV_T_INT ? rt_tag_v(iv) : rt_csv_float((double)iv);
+          else if (k == RT_CSV_T_FLOAT)
+            v = t == RT_CSV_T_FLOAT ? rt_csv_float(dv) : 0;
+        }
+      } else if (t == RT_CSV_T_STR || t == RT_CSV_T_NONE) {
+        v = rt_alloc_string_len("", 0);
+      }
+      rt_csv_list_set(col, (int64_t)i, v);
+    }
+  }
+  return cols;
+}
+
+int64_t rt_csv_schema(int64_t h_v, int64_t spec_v) {
+  rt_csv_t *r = rt_csv_handle(h_v);
+  if (!r)
+    return 0;
+  if (is_v_str(spec_v) && rt_tagged_str_len(spec_v) > 0) {
+    const char *spec = (const char *)(uintptr_t)spec_v;
+    size_t n = rt_tagged_str_len(spec_v);
+    if (!rt_csv_grow_types(r, n))
+      return 0;
+    for (size_t i = 0; i < n; i++)
+      r->pinned[i] = spec[i] == 'i'   ? RT_CSV_T_INT
+                     : spec[i] == 'f' ? RT_CSV_T_FLOAT
+                     : spec[i] == 's' ? RT_CSV_T_STR
+                                      : RT_CSV_T_NONE;
+  }
+  char tmp[256];
+  size_t n = r->ncols < sizeof(tmp) ? r->ncols : sizeof(tmp);
+  for (size_t i = 0; i < n; i++) {
+    int t = r->pinned[i] ? r->pinned[i] : r->types[i];
+    tmp[i] = "?ifs"[t];
+  }
+  return rt_alloc_string_len(tmp, n);
+}
+
+int64_t rt_csv_status(int64_t h_v) {
+  rt_csv_t *r = rt_csv_handle(h_v);
+  if (!r)
+    return 0;
+  int64_t out = rt_csv_list(4);
+  if (!out)
+    return 0;
+  size_t done = r->ilen ? r->ibase + r->row_start : r->pos;
+  if (r->fp)
+    done = (size_t)ftell(r->fp) - (r->dlen - done);
+  rt_csv_list_set(out, 0, rt_tag_v(r->rows));
+  rt_csv_list_set(out, 1, rt_tag_v((int64_t)done));
+  rt_csv_list_set(out, 2, r->oom ? NY_IMM_TRUE : NY_IMM_FALSE);
+  rt_csv_list_set(out, 3, rt_tag_v(rt_csv_thread_count()));
+  return out;
+}
+
+int64_t rt_csv_decode(int64_t s_v, int64_t sep_v) {
+  int64_t h = rt_csv_open(s_v, NY_IMM_FALSE, sep_v);
+  if (!h)
+    return rt_csv_list(0);
+  int64_t rows = rt_csv_rows(h, rt_tag_v(0));
+  rt_csv_close(h);
+  return rows ? rows : rt_csv_list(0);
+}
+
+int64_t rt_csv_set_threads(int64_t n_v) {
+  int64_t n = rt_csv_int_arg(n_v);
+  g_rt_csv_threads = n < 0 ? 1 : (n > RT_CSV_MAX_THREADS ? RT_CSV_MAX_THREADS : (int)n);
+  return rt_tag_v(rt_csv_thread_count());
+}
@@ -112,10 +112,16 @@ RT_DEF("__tty_pending", rt_tty_pending, 0, "fn __tty_pending()",
 RT_DEF("__tty_size", rt_tty_size, 1, "fn __tty_size(out_ptr)",
        "Writes tty cols/rows (int32,int32) to out_ptr; returns 0 on success.")
 RT_DEF("__is_dir", rt_is_dir, 1, "fn __is_dir(path)", "Portable directory check.")
+RT_DEF("__file_size", rt_file_size, 1, "fn __file_size(path)", "Returns the size of a regular file, or -1.")
 
 RT_DEF("__dir_open", rt_dir_open, 1, "fn __dir_open(path)", "Open directory handle.")
 RT_DEF("__dir_read", rt_dir_read, 1, "fn __dir_read(handle)", "Read next directory entry.")
 RT_DEF("__dir_close", rt_dir_close, 1, "fn __dir_close(handle)", "Close directory handle.")
+RT_DEF("__fs_map", rt_fs_map, 4, "fn __fs_map(path, off, len, advice)",
+       "Returns a read-only string view of a file range (len -1 = to EOF), mapped when large; 0 on failure.")
+RT_DEF("__fs_map_advise", rt_fs_map_advise, 2, "fn __fs_map_advise(view, advice)",
+       "Applies an access hint (0 normal, 1 sequential, 2 random, 3 willneed, 4 dontneed) to a file view.")
+RT_DEF("__fs_unmap", rt_fs_unmap, 1, "fn __fs_unmap(view)", "Releases a file view; -1 if it is not one.")
 
 RT_DEF("__inotify_init", rt_inotify_init, 1, "fn __inotify_init(flags)", "inotify_init1 or inotify_init wrapper for file watching.")
 RT_DEF("__inotify_add_watch", rt_inotify_add_watch, 3, "fn __inotify_add_watch(fd, path, mask)", "Add inotify watch for path with mask.")
@@ -149,6 +155,76 @@ RT_DEF("__bigint_row_submul", rt_bigint_row_submul, 4, "fn __bigint_row_submul(r
 RT_DEF("__bigint_row_submul_auto", rt_bigint_row_submul_auto, 3,
        "fn __bigint_row_submul_auto(row_k, row_j, q)",
        "Applies row_k -= q*row_j after scanning row_j's active tail.")
+RT_DEF("__lll_fp", rt_lll_fp, 5, "fn __lll_fp(rows, delta, eta, depth, flags)",
+       "Floating-point LLL on integer rows with exact Gram tracking and integral fallback; flags bit0 tracks the transform, bit1 forces the exact tier.")
+RT_DEF("__bkz_fp", rt_bkz_fp, 5, "fn __bkz_fp(rows, block_size, delta, max_tours, max_nodes)",
+       "BKZ on integer rows using floating-point LLL and Schnorr-Euchner block enumeration.")
+RT_DEF("__lll_gso_check", rt_lll_gso_check, 3, "fn __lll_gso_check(rows, delta, eta)",
+       "Returns [profile, mu, max_mu, size_reduced, lovasz, zero_rows] from the exact Gram matrix of integer rows.")
+RT_DEF("__ecm_factor", rt_ecm_factor, 6, "fn __ecm_factor(n, B1, B2, curves, sigma_start, threads)",
+       "Multi-curve ECM with Montgomery-form residues, baby-step/giant-step stage 2 and threaded early exit; returns [factor|nil, curve, sigma, stage, curves_done, threads].")
+RT_DEF("__modctx_new", rt_modctx_new, 1, "fn __modctx_new(m)",
+       "Creates a fixed-width modular context (Montgomery for odd, Barrett for even m, up to 4096 bits); nil when m is out of range.")
+RT_DEF("__modctx_free", rt_modctx_free, 1, "fn __modctx_free(ctx)", "Releases a modular context.")
+RT_DEF("__modctx_info", rt_modctx_info, 1, "fn __modctx_info(ctx)",
+       "Returns [bits, limbs, kind] for a modular context; kind 0 is Montgomery, 1 is Barrett.")
+RT_DEF("__modctx_mul", rt_modctx_mul, 3, "fn __modctx_mul(ctx, a, b)", "Returns a * b mod m.")
+RT_DEF("__modctx_pow", rt_modctx_pow, 4, "fn __modctx_pow(ctx, base, exp, flags)",
+       "Sliding-window base^exp mod m; flags bit0 selects the constant-time fixed window (odd m only).")
+RT_DEF("__modctx_batch", rt_modctx_batch, 5, "fn __modctx_batch(ctx, op, xs, ys, flags)",
+       "Batch mul (op 0), pow (op 1) or inverse (op 2) of many operands under one modulus; ys may be a shared scalar.")
+RT_DEF("__modctx_ec_mul", rt_modctx_ec_mul, 4, "fn __modctx_ec_mul(ctx, k, point, a)",
+       "Jacobian sliding-window k * point on y^2 = x^3 + a x + b over the context modulus; nil for infinity, [X, Y, Z] for a non-unit Z.")
+RT_DEF("__poly_mul", rt_poly_mul, 4, "fn __poly_mul(a, b, modulus, wrap)",
+       "Integer polynomial product (schoolbook, Karatsuba or multi-prime NTT by size); mod modulus unless nil, wrap n folds mod x^n - 1, -n mod x^n + 1; nil for non-integer entries.")
+RT_DEF("__ntt_transform", rt_ntt_transform, 4, "fn __ntt_transform(a, p, w, inverse)",
+       "Natural-order NTT of a power-of-two list mod an odd prime p < 2^62 with root w; inverse uses w^-1 and scales by 1/n.")
+RT_DEF("__ntt_root", rt_ntt_root, 2, "fn __ntt_root(n, p)",
+       "Primitive n-th root of unity mod a prime p < 2^62 from the smallest working generator; nil when n does not divide p - 1.")
+RT_DEF("__json_decode", rt_json_decode, 1, "fn __json_decode(s)",
+       "Decodes a JSON string through the structural index and tape; returns [ok, value, error, pos].")
+RT_DEF("__json_doc_new", rt_json_doc_new, 1, "fn __json_doc_new(s)",
+       "Indexes a JSON string for lazy access; the root node is 0. Check __json_doc_status for errors.")
+RT_DEF("__json_doc_free", rt_json_doc_free, 1, "fn __json_doc_free(doc)", "Releases a JSON document or stream.")
+RT_DEF("__json_doc_status", rt_json_doc_status, 1, "fn __json_doc_status(doc)",
+       "Returns [error, pos, documents, errors] for a JSON document or stream.")
+RT_DEF("__json_stream_new", rt_json_stream_new, 2, "fn __json_stream_new(src, is_path)",
+       "Opens a newline-delimited JSON stream over a string, or over a file when is_path is true.")
+RT_DEF("__json_stream_next", rt_json_stream_next, 1, "fn __json_stream_next(stream)",
+       "Parses the next document of a stream: 0 is its root node, -1 the end of input, -2 a skipped malformed line.")
+RT_DEF("__json_node_kind", rt_json_node_kind, 2, "fn __json_node_kind(doc, node)",
+       "Kind code of a node: 0 null, 1 false, 2 true, 3 int, 4 float, 5 string, 6 array, 7 object; -1 if invalid.")
+RT_DEF("__json_node_len", rt_json_node_len, 2, "fn __json_node_len(doc, node)",
+       "Element count of an array or object node, byte length of a string node.")
+RT_DEF("__json_node_get", rt_json_node_get, 3, "fn __json_node_get(doc, node, key)",
+       "Child node of an object by string key or of an array by index; -1 when absent.")
+RT_DEF("__json_node_keys", rt_json_node_keys, 2, "fn __json_node_keys(doc, node)", "Keys of an object node in document order.")
+RT_DEF("__json_node_value", rt_json_node_value, 2, "fn __json_node_value(doc, node)",
+       "Materializes a node and everything below it as Nytrix values.")
+RT_DEF("__csv_open", rt_csv_open, 3, "fn __csv_open(src, is_path, sep)",
+       "Opens a CSV reader over a string, or over a file (mapped when possible) when is_path is true.")
+RT_DEF("__csv_close", rt_csv_close, 1, "fn __csv_close(reader)", "Releases a CSV reader.")
+RT_DEF("__csv_rows", rt_csv_rows, 2, "fn __csv_rows(reader, n)",
+       "Reads up to n rows (all when n <= 0) as lists of strings; an empty list at the end.")
+RT_DEF("__csv_columns", rt_csv_columns, 2, "fn __csv_columns(reader, n)",
+       "Reads up to n rows as typed columns; a batch stops at an index region, nil at the end.")
+RT_DEF("__csv_schema", rt_csv_schema, 2, "fn __csv_schema(reader, spec)",
+       "Pins column types from a spec of i/f/s/? characters when non-empty; returns the current types.")
+RT_DEF("__csv_status", rt_csv_status, 1, "fn __csv_status(reader)",
+       "Returns [rows, bytes consumed, out of memory, threads] for a CSV reader.")
+RT_DEF("__csv_decode", rt_csv_decode, 2, "fn __csv_decode(s, sep)", "Decodes a whole CSV string into rows of strings.")
+RT_DEF("__csv_set_threads", rt_csv_set_threads, 1, "fn __csv_set_threads(n)",
+       "Sets the CSV indexing thread count (0 = one per CPU) and returns the effective count.")
+RT_DEF("__png_inflate_unfilter", rt_png_inflate_unfilter, 7,
+       "fn __png_inflate_unfilter(idat_list, raw, raw_len, w, h, bits_per_pixel, interlace)",
+       "Inflates IDAT chunks into raw and unfilters each row as it completes; returns bytes produced, -1 on a zlib error or -2 on a bad filter.")
+RT_DEF("__png_expand8", rt_png_expand8, 7, "fn __png_expand8(raw, pixels, w, h, color_type, lut, trns)",
+       "Expands unfiltered 8-bit PNG rows to RGBA through a gray/palette lookup or an RGB transparency key.")
+RT_DEF("__png_encode_idat", rt_png_encode_idat, 5, "fn __png_encode_idat(pixels, w, h, channels, level)",
+       "Filters RGB/RGBA rows adaptively and deflates them in parallel bands into one zlib stream.")
+RT_DEF("__png_crc", rt_png_crc, 3, "fn __png_crc(buf, start, len)", "Returns the CRC-32 of a byte range.")
+RT_DEF("__jpeg_decode", rt_jpeg_decode, 2, "fn __jpeg_decode(data, scale)",
+       "Decodes a baseline JPEG to RGBA; scale 8 keeps DC only. Returns [pixels, w, h] or 0.")
 RT_DEF("__bigint_cmp", rt_bigint_cmp, 2, "fn __bigint_cmp(a, b)",
        "Compares two BigInt values using the runtime bigint implementation.")
 RT_DEF("__bigint_div", rt_bigint_div, 2, "fn __bigint_div(a, b)",
@@ -239,6 +315,12 @@ RT_DEF("__setsockopt", rt_setsockopt, 5, "fn __setsockopt(fd, level, optname, op
 RT_DEF("__recv", rt_recv, 4, "fn __recv(fd, buf, len, flags)", "Portable recv wrapper.")
 RT_DEF("__send", rt_send, 4, "fn __send(fd, buf, len, flags)", "Portable send wrapper.")
 RT_DEF("__closesocket", rt_closesocket, 1, "fn __closesocket(fd)", "Portable socket close wrapper.")
+RT_DEF("__sock_sendv", rt_sock_sendv, 3, "fn __sock_sendv(fd, parts, flags)",
+       "Sends a list of strings with scatter/gather writes (flags 1 = MSG_ZEROCOPY for large sends); returns bytes sent or -1.")
+RT_DEF("__sock_recv_into", rt_sock_recv_into, 5, "fn __sock_recv_into(fd, buf, off, len, wrap)",
+       "Receives up to len bytes into caller memory at buf+off, wrapping at `wrap` bytes for ring buffers (0 = no wrap).")
+RT_DEF("__sock_sendfile", rt_sock_sendfile, 4, "fn __sock_sendfile(fd, file, off, len)",
+       "Sends a file range (path or descriptor, len -1 = to EOF) with sendfile where available; returns bytes sent or -1.")
 RT_DEF("__async_task_new", rt_async_task_new, 3, "fn __async_task_new(fn, argc, argv)",
        "Creates a stackless async task from a callable and copied argument vector.")
 RT_DEF("__async_value", rt_async_value, 1, "fn __async_value(value)",
@@ -424,6 +506,17 @@ RT_DEF("__zlib_compress_str", rt_zlib_compress_str, 3,
        "fn __zlib_compress_str(src, srcLen, level)", "Compresses data to a Nytrix string.")
 RT_DEF("__zlib_bound", rt_zlib_bound, 1, "fn __zlib_bound(n)",
        "Returns upper bound for compressed size.")
+RT_DEF("__zstream_new", rt_zstream_new, 3, "fn __zstream_new(deflate, level, wbits)",
+       "Opens a streaming inflate (0) or deflate (1) context; wbits 0 picks zlib for deflate and zlib/gzip detection for inflate.")
+RT_DEF("__zstream_run", rt_zstream_run, 6, "fn __zstream_run(z, src, src_len, dst, dst_cap, finish)",
+       "Runs one step from src into a caller buffer; returns [status, consumed, produced], status 1 at the end of the stream.")
+RT_DEF("__zstream_feed", rt_zstream_feed, 4, "fn __zstream_feed(z, src, src_len, finish)",
+       "Feeds src through the stream and returns the output it produced as a string.")
+RT_DEF("__zstream_feed_fd", rt_zstream_feed_fd, 5, "fn __zstream_feed_fd(z, src, src_len, fd, finish)",
+       "Feeds src through the stream, writing output to fd in bounded blocks; returns bytes written or -1.")
+RT_DEF("__zstream_status", rt_zstream_status, 1, "fn __zstream_status(z)",
+       "Returns [status, total_in, total_out] for a stream.")
+RT_DEF("__zstream_free", rt_zstream_free, 1, "fn __zstream_free(z)", "Releases a zlib stream.")
 RT_DEF("__tag_native", rt_tag_native, 1, "fn __tag_native(addr)",
        "Tags a raw function pointer as a native callable.")
 
@@ -565,6 +658,12 @@ RT_DEF("__trace_ret_f64_bits", rt_trace_ret_f64_bits, 1, "fn __trace_ret_f64_bit
        "Internal: trace an f64 return value encoded as IEEE bits.")
 RT_DEF("__trace_dump", rt_trace_dump, 1, "fn __trace_dump(n)",
        "Internal: dump recent trace entries.")
+RT_DEF("__pgo_site", rt_pgo_site, 2, "fn __pgo_site(site, callee)",
+       "Internal: count one call at a profiled call site (--pgo-gen).")
+RT_DEF("__pgo_arg", rt_pgo_arg, 3, "fn __pgo_arg(site, idx, v)",
+       "Internal: record the runtime class of argument idx at a profiled call site.")
+RT_DEF("__ic_count", rt_ic_count, 3, "fn __ic_count(site, way, label)",
+       "Internal: count a hit (way >= 0) or miss (-1) at a member-call inline cache.")
 RT_DEF("__get_backtrace", rt_get_backtrace, 1, "fn __get_backtrace(n)",
        "Returns the current Nytrix backtrace as a list of [file, line, col, "
        "func] frames.")
@@ -796,6 +895,55 @@ RT_DEF("__simmd_i32_hash_probe_sum_ptr", rt_simmd_i32_hash_probe_sum_ptr, 8,
 RT_DEF("__simmd_i32_sqlscan_sum_ptr", rt_simmd_i32_sqlscan_sum_ptr, 6,
        "fn __simmd_i32_sqlscan_sum_ptr(region, tier, amount, flags, n, rounds)",
        "Runs a raw i32 column filter/aggregate checksum kernel.")
+RT_DEF("__nd_new", rt_nd_new, 2, "fn __nd_new(shape, dtype)",
+       "Allocates a zero-filled contiguous ndarray of dtype f64, f32, i64 or i32.")
+RT_DEF("__nd_from_list", rt_nd_from_list, 2, "fn __nd_from_list(data, dtype)",
+       "Builds a contiguous ndarray from rectangular nested lists.")
+RT_DEF("__nd_to_list", rt_nd_to_list, 1, "fn __nd_to_list(a)",
+       "Converts an ndarray view into nested lists.")
+RT_DEF("__nd_free", rt_nd_free, 1, "fn __nd_free(a)",
+       "Releases an ndarray handle; the buffer is freed with its last view.")
+RT_DEF("__nd_is", rt_nd_is, 1, "fn __nd_is(v)", "Returns true when v is a live ndarray handle.")
+RT_DEF("__nd_dtype", rt_nd_dtype, 1, "fn __nd_dtype(a)", "Returns the ndarray dtype code.")
+RT_DEF("__nd_ndim", rt_nd_ndim, 1, "fn __nd_ndim(a)", "Returns the number of ndarray dimensions.")
+RT_DEF("__nd_size", rt_nd_size, 1, "fn __nd_size(a)", "Returns the ndarray element count.")
+RT_DEF("__nd_shape", rt_nd_shape, 1, "fn __nd_shape(a)", "Returns the ndarray shape as a list.")
+RT_DEF("__nd_strides", rt_nd_strides, 1, "fn __nd_strides(a)",
+       "Returns the ndarray strides, in elements, as a list.")
+RT_DEF("__nd_data_ptr", rt_nd_data_ptr, 1, "fn __nd_data_ptr(a)",
+       "Returns a raw pointer to the first element of an ndarray view.")
+RT_DEF("__nd_is_contiguous", rt_nd_is_contig, 1, "fn __nd_is_contiguous(a)",
+       "Returns true when an ndarray view is row-major contiguous.")
+RT_DEF("__nd_get", rt_nd_get, 2, "fn __nd_get(a, idx)",
+       "Reads an element by flat position or index list.")
+RT_DEF("__nd_set", rt_nd_set, 3, "fn __nd_set(a, idx, v)",
+       "Writes an element by flat position or index list.")
+RT_DEF("__nd_fill", rt_nd_fill, 2, "fn __nd_fill(a, v)", "Fills every element of an ndarray view.")
+RT_DEF("__nd_slice", rt_nd_slice, 5, "fn __nd_slice(a, axis, start, stop, step)",
+       "Returns a zero-copy view sliced along one axis.")
+RT_DEF("__nd_transpose", rt_nd_transpose, 2, "fn __nd_transpose(a, axes)",
+       "Returns a zero-copy view with permuted axes; nil reverses them.")
+RT_DEF("__nd_reshape", rt_nd_reshape, 2, "fn __nd_reshape(a, shape)",
+       "Returns a reshaped view, copying only when the source is not contiguous.")
+RT_DEF("__nd_copy", rt_nd_copy, 2, "fn __nd_copy(a, dtype)",
+       "Copies an ndarray view into a new contiguous array, optionally casting.")
+RT_DEF("__nd_binop", rt_nd_binop, 3, "fn __nd_binop(a, b, op)",
+       "Applies a broadcasting elementwise add/sub/mul/div/min/max.")
+RT_DEF("__nd_binop_into", rt_nd_binop_into, 4, "fn __nd_binop_into(out, a, b, op)",
+       "Applies a broadcasting elementwise operation into an existing array.")
+RT_DEF("__nd_unop", rt_nd_unop, 2, "fn __nd_unop(a, op)",
+       "Applies an elementwise neg/abs/sqrt/exp/log.")
+RT_DEF("__nd_reduce", rt_nd_reduce, 3, "fn __nd_reduce(a, op, axis)",
+       "Reduces with sum/prod/min/max over all elements or one axis.")
+RT_DEF("__nd_dot", rt_nd_dot, 2, "fn __nd_dot(a, b)", "Returns the inner product of two arrays.")
+RT_DEF("__nd_matmul", rt_nd_matmul, 2, "fn __nd_matmul(a, b)",
+       "Multiplies 1-D/2-D arrays using blocked SIMD GEMM for float dtypes.")
+RT_DEF("__nd_gemm", rt_nd_gemm, 5, "fn __nd_gemm(alpha, a, b, beta, c)",
+       "Computes c = alpha*a*b + beta*c in place for float arrays.")
+RT_DEF("__nd_set_threads", rt_nd_set_threads, 1, "fn __nd_set_threads(n)",
+       "Sets ndarray GEMM worker threads; 0 uses every CPU.")
+RT_DEF("__nd_threads", rt_nd_threads, 0, "fn __nd_threads()",
+       "Returns the effective ndarray GEMM thread count.")
 RT_DEF("__mat4_to_buffer", rt_mat4_to_buffer, 2, "fn __mat4_to_buffer(m, buf)",
        "Optimized conversion of 4x4 matrix object to raw float buffer.")
 RT_DEF("__mat4_from_buffer", rt_mat4_from_buffer, 2, "fn __mat4_from_buffer(m, buf)",
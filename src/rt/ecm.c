@@ -0,0 +1,612 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <gmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+ * Multi-curve ECM for std.math.crypto.factorization.ecm.
+ *
+ * Residues live in fixed-width Montgomery form (mpn limbs, REDC after every
+ * product), so the x-only ladder never allocates. Curve setup uses Suyama's
+ * parametrisation for a whole batch with one shared inversion. Stage 1 is a
+ * prime-power ladder up to B1, stage 2 a baby-step/giant-step continuation up
+ * to B2 with a single accumulated product per curve. Curves are handed out to
+ * worker threads through an atomic counter and every worker stops as soon as
+ * one of them publishes a factor.
+ */
+
+extern void _bi_val_to_mpz(int64_t v, mpz_t result);
+extern int64_t _bi_from_mpz(const mpz_t val);
+extern bool _bi_mpz_fits_small_int(const mpz_t v);
+extern int64_t _bi_mpz_get_i64(const mpz_t v);
+extern int64_t rt_list_new(int64_t n);
+
+#define RT_ECM_MAX_LIMBS 64
+#define RT_ECM_MAX_THREADS RT_MAX_THREADS
+#define RT_ECM_CANCEL_POLL 32
+
+typedef struct {
+  int nl;
+  mp_limb_t ninv; /* -n^-1 mod 2^GMP_NUMB_BITS */
+  mp_limb_t n[RT_ECM_MAX_LIMBS];
+} rt_ecm_mod_t;
+
+typedef struct {
+  mp_limb_t x[RT_ECM_MAX_LIMBS];
+  mp_limb_t z[RT_ECM_MAX_LIMBS];
+} rt_ecm_pt_t;
+
+typedef struct {
+  const rt_ecm_mod_t *m;
+  mp_limb_t t[2 * RT_ECM_MAX_LIMBS];
+  mp_limb_t a[RT_ECM_MAX_LIMBS];
+  mp_limb_t b[RT_ECM_MAX_LIMBS];
+  mp_limb_t c[RT_ECM_MAX_LIMBS];
+  mp_limb_t d[RT_ECM_MAX_LIMBS];
+} rt_ecm_ws_t;
+
+typedef struct {
+  mp_limb_t a24[RT_ECM_MAX_LIMBS];
+  rt_ecm_pt_t p;
+  int64_t sigma;
+  bool ready;
+} rt_ecm_curve_t;
+
+typedef struct {
+  rt_ecm_mod_t mod;
+  mpz_t n;
+  rt_ecm_curve_t *curves;
+  int64_t curve_count;
+  uint64_t b1;
+  uint64_t b2;
+  const uint8_t *composite; /* sieve up to b2 + d, 1 = composite */
+  uint64_t d;
+  volatile int64_t next;
+  volatile int found;
+  int64_t done;
+  mpz_t factor;
+  int64_t factor_curve;
+  int factor_stage;
+#if defined(_WIN32)
+  CRITICAL_SECTION lock;
+#else
+  pthread_mutex_t lock;
+#endif
+} rt_ecm_job_t;
+
+/* ---- fixed-width Montgomery arithmetic ---------------------------------- */
+
+static bool rt_ecm_mod_init(rt_ecm_mod_t *m, const mpz_t n) {
+  size_t nl = mpz_size(n);
+  if (nl == 0 || nl > RT_ECM_MAX_LIMBS || mpz_even_p(n))
+    return false;
+  memset(m, 0, sizeof(*m));
+  m->nl = (int)nl;
+  for (size_t i = 0; i < nl; i++)
+    m->n[i] = mpz_getlimbn(n, (mp_size_t)i);
+  mp_limb_t n0 = m->n[0];
+  mp_limb_t inv = n0; /* correct to 3 bits for odd n0 */
+  for (int i = 0; i < 6; i++)
+    inv *= 2 - n0 * inv;
+  m->ninv = (mp_limb_t)0 - inv;
+  return true;
+}
+
+static void rt_ecm_redc(mp_limb_t *r, mp_limb_t *t, const rt_ecm_mod_t *m) {
+  int nl = m->nl;
+  mp_limb_t *up = t;
+  for (int i = 0; i < nl; i++) {
+    mp_limb_t q = up[0] * m->ninv;
+    up[0] = mpn_addmul_1(up, m->n, nl, q);
+    up++;
+  }
+  mp_limb_t cy = mpn_add_n(r, up, t, nl);
+  if (cy || mpn_cmp(r, m->n, nl) >= 0)
+    mpn_sub_n(r, r, m->n, nl);
+}
+
+static inline void rt_ecm_mul(rt_ecm_ws_t *w, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  if (a == b)
+    mpn_sqr(w->t, a, w->m->nl);
+  else
+    mpn_mul_n(w->t, a, b, w->m->nl);
+  rt_ecm_redc(r, w->t, w->m);
+}
+
+static inline void rt_ecm_add(const rt_ecm_mod_t *m, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  mp_limb_t cy = mpn_add_n(r, a, b, m->nl);
+  if (cy || mpn_cmp(r, m->n, m->nl) >= 0)
+    mpn_sub_n(r, r, m->n, m->nl);
+}
+
+static inline void rt_ecm_sub(const rt_ecm_mod_t *m, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  if (mpn_sub_n(r, a, b, m->nl))
+    mpn_add_n(r, r, m->n, m->nl);
+}
+
+/* a * R mod n into fixed-width limbs. */
+static void rt_ecm_to_mont(const rt_ecm_mod_t *m, const mpz_t n, mp_limb_t *out, const mpz_t a) {
+  mpz_t t;
+  mpz_init(t);
+  mpz_mod(t, a, n);
+  mpz_mul_2exp(t, t, (mp_bitcnt_t)m->nl * GMP_NUMB_BITS);
+  mpz_mod(t, t, n);
+  memset(out, 0, (size_t)m->nl * sizeof(mp_limb_t));
+  for (size_t i = 0; i < mpz_size(t); i++)
+    out[i] = mpz_getlimbn(t, (mp_size_t)i);
+  mpz_clear(t);
+}
+
+static void rt_ecm_limbs_mpz(mpz_t out, const mp_limb_t *a, int nl) {
+  mpz_import(out, (size_t)nl, -1, sizeof(mp_limb_t), 0, 0, a);
+}
+
+/* ---- x-only Montgomery curve -------------------------------------------- */
+
+/* r = 2p */
+static void rt_ecm_xdbl(rt_ecm_ws_t *w, rt_ecm_pt_t *r, const rt_ecm_pt_t *p, const mp_limb_t *a24) {
+  const rt_ecm_mod_t *m = w->m;
+  rt_ecm_add(m, w->a, p->x, p->z);
+  rt_ecm_mul(w, w->a, w->a, w->a);
+  rt_ecm_sub(m, w->b, p->x, p->z);
+  rt_ecm_mul(w, w->b, w->b, w->b);
+  rt_ecm_sub(m, w->c, w->a, w->b);
+  rt_ecm_mul(w, r->x, w->a, w->b);
+  rt_ecm_mul(w, w->d, a24, w->c);
+  rt_ecm_add(m, w->d, w->d, w->b);
+  rt_ecm_mul(w, r->z, w->c, w->d);
+}
+
+/* r = p + q given diff = p - q; r may alias p or q but not diff. */
+static void rt_ecm_xadd(rt_ecm_ws_t *w, rt_ecm_pt_t *r, const rt_ecm_pt_t *p, const rt_ecm_pt_t *q,
+                        const rt_ecm_pt_t *diff) {
+  const rt_ecm_mod_t *m = w->m;
+  rt_ecm_sub(m, w->a, p->x, p->z);
+  rt_ecm_add(m, w->b, q->x, q->z);
+  rt_ecm_mul(w, w->a, w->a, w->b);
+  rt_ecm_add(m, w->c, p->x, p->z);
+  rt_ecm_sub(m, w->d, q->x, q->z);
+  rt_ecm_mul(w, w->c, w->c, w->d);
+  rt_ecm_add(m, w->b, w->a, w->c);
+  rt_ecm_sub(m, w->d, w->a, w->c);
+  rt_ecm_mul(w, w->b, w->b, w->b);
+  rt_ecm_mul(w, w->d, w->d, w->d);
+  rt_ecm_mul(w, r->x, diff->z, w->b);
+  rt_ecm_mul(w, r->z, diff->x, w->d);
+}
+
+/* p = k * p with the Montgomery ladder. */
+static void rt_ecm_ladder(rt_ecm_ws_t *w, rt_ecm_pt_t *p, uint64_t k, const mp_limb_t *a24) {
+  if (k <= 1)
+    return;
+  rt_ecm_pt_t base = *p;
+  rt_ecm_pt_t r0 = *p;
+  rt_ecm_pt_t r1;
+  rt_ecm_xdbl(w, &r1, p, a24);
+  int bit = 63;
+  while (!((k >> bit) & 1))
+    bit--;
+  for (bit--; bit >= 0; bit--) {
+    if ((k >> bit) & 1) {
+      rt_ecm_xadd(w, &r0, &r0, &r1, &base);
+      rt_ecm_xdbl(w, &r1, &r1, a24);
+    } else {
+      rt_ecm_xadd(w, &r1, &r0, &r1, &base);
+      rt_ecm_xdbl(w, &r0, &r0, a24);
+    }
+  }
+  *p = r0;
+}
+
+/* ---- curve setup -------------------------------------------------------- */
+
+/*
+ * Suyama: u = s^2 - 5, v = 4s, P = (u^3 : v^3),
+ * (A + 2) / 4 = (v - u)^3 (3u + v) / (16 u^3 v).
+ * The denominators of all curves share one inversion (Montgomery's trick).
+ * Returns false with job->factor set when an inversion exposes a factor.
+ */
+static bool rt_ecm_setup(rt_ecm_job_t *job, int64_t sigma0) {
+  int64_t count = job->curve_count;
+  mpz_t *num = (mpz_t *)calloc((size_t)count, sizeof(mpz_t));
+  mpz_t *den = (mpz_t *)calloc((size_t)count, sizeof(mpz_t));
+  mpz_t *pre = (mpz_t *)calloc((size_t)count + 1, sizeof(mpz_t));
+  mpz_t u, v, x, z, t, inv;
+  bool ok = num && den && pre;
+  mpz_inits(u, v, x, z, t, inv, NULL);
+  for (int64_t i = 0; ok && i < count; i++) {
+    mpz_inits(num[i], den[i], pre[i], NULL);
+    int64_t s = sigma0 + i;
+    job->curves[i].sigma = s;
+    mpz_set_si(u, s);
+    mpz_mul(u, u, u);
+    mpz_sub_ui(u, u, 5);
+    mpz_mod(u, u, job->n);
+    mpz_set_si(v, s);
+    mpz_mul_ui(v, v, 4);
+    mpz_mod(v, v, job->n);
+    mpz_powm_ui(x, u, 3, job->n);
+    mpz_powm_ui(z, v, 3, job->n);
+    rt_ecm_to_mont(&job->mod, job->n, job->curves[i].p.x, x);
+    rt_ecm_to_mont(&job->mod, job->n, job->curves[i].p.z, z);
+    mpz_sub(t, v, u);
+    mpz_powm_ui(num[i], t, 3, job->n);
+    mpz_mul_ui(t, u, 3);
+    mpz_add(t, t, v);
+    mpz_mul(num[i], num[i], t);
+    mpz_mod(num[i], num[i], job->n);
+    mpz_mul_ui(den[i], x, 16);
+    mpz_mul(den[i], den[i], v);
+    mpz_mod(den[i], den[i], job->n);
+  }
+  if (ok) {
+    mpz_init_set_ui(pre[count], 1);
+    mpz_set_ui(pre[0], 1);
+    for (int64_t i = 0; i < count; i++) {
+      mpz_mul(pre[i + 1], pre[i], den[i]);
+      mpz_mod(pre[i + 1], pre[i + 1], job->n);
+    }
+    if (!mpz_invert(inv, pre[count], job->n)) {
+      /* Some denominator shares a factor with n; find it per curve. */
+      for (int64_t i = 0; i < count; i++) {
+        mpz_gcd(t, den[i], job->n);
+        if (mpz_cmp_ui(t, 1) > 0 && mpz_cmp(t, job->n) < 0) {
+          mpz_set(job->factor, t);
+          job->factor_curve = i;
+          job->factor_stage = 0;
+          job->found = 1;
+          break;
+        }
+      }
+      /* Singular curves (den == 0 mod n) are skipped. */
+      for (int64_t i = 0; i < count; i++) {
+        if (!mpz_invert(inv, den[i], job->n))
+          continue;
+        mpz_mul(t, num[i], inv);
+        mpz_mod(t, t, job->n);
+        rt_ecm_to_mont(&job->mod, job->n, job->curves[i].a24, t);
+        job->curves[i].ready = true;
+      }
+    } else {
+      for (int64_t i = count - 1; i >= 0; i--) {
+        /* inv = 1 / (den_0 ... den_i); 1 / den_i = inv * pre_i */
+        mpz_mul(t, inv, pre[i]);
+        mpz_mul(t, t, num[i]);
+        mpz_mod(t, t, job->n);
+        rt_ecm_to_mont(&job->mod, job->n, job->curves[i].a24, t);
+        job->curves[i].ready = true;
+        mpz_mul(inv, inv, den[i]);
+        mpz_mod(inv, inv, job->n);
+      }
+    }
+  }
+  for (int64_t i = 0; ok && i <= count; i++) {
+    if (i < count)
+      mpz_clears(num[i], den[i], NULL);
+    mpz_clear(pre[i]);
+  }
+  mpz_clears(u, v, x, z, t, inv, NULL);
+  free(num);
+  free(den);
+  free(pre);
+  return ok;
+}
+
+/* ---- stages ------------------------------------------------------------- */
+
+static inline bool rt_ecm_is_prime(const rt_ecm_job_t *job, uint64_t q) {
+  return q >= 2 && !job->composite[q];
+}
+
+static bool rt_ecm_publish(rt_ecm_job_t *job, const mpz_t g, int64_t curve, int stage) {
+  bool won = false;
+#if defined(_WIN32)
+  EnterCriticalSection(&job->lock);
+#else
+  pthread_mutex_lock(&job->lock);
+#endif
+  if (!job->found) {
+    mpz_set(job->factor, g);
+    job->factor_curve = curve;
+    job->factor_stage = stage;
+    __atomic_store_n(&job->found, 1, __ATOMIC_RELEASE);
+    won = true;
+  }
+#if defined(_WIN32)
+  LeaveCriticalSection(&job->lock);
+#else
+  pthread_mutex_unlock(&job->lock);
+#endif
+  return won;
+}
+
+static inline bool rt_ecm_cancelled(rt_ecm_job_t *job) {
+  return __atomic_load_n(&job->found, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Returns 1 for a factor, 0 for none, -1 when cancelled. */
+static int rt_ecm_gcd_check(rt_ecm_job_t *job, const mp_limb_t *v, mpz_t g, int64_t curve, int stage) {
+  rt_ecm_limbs_mpz(g, v, job->mod.nl);
+  mpz_gcd(g, g, job->n);
+  if (mpz_cmp_ui(g, 1) > 0 && mpz_cmp(g, job->n) < 0) {
+    rt_ecm_publish(job, g, curve, stage);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Ends a stage 1 chunk covering primes [lo, hi]. Returns 1 for a factor, 2
+ * when the point died on every prime of n at once, 0 to go on. A gcd equal to
+ * n replays the chunk one prime at a time from the last good point.
+ */
+static int rt_ecm_stage1_chunk(rt_ecm_job_t *job, rt_ecm_ws_t *w, rt_ecm_curve_t *cv, rt_ecm_pt_t *saved,
+                               uint64_t lo, uint64_t hi, mpz_t g, int64_t curve) {
+  rt_ecm_limbs_mpz(g, cv->p.z, job->mod.nl);
+  mpz_gcd(g, g, job->n);
+  if (mpz_cmp_ui(g, 1) == 0) {
+    *saved = cv->p;
+    return 0;
+  }
+  if (mpz_cmp(g, job->n) < 0) {
+    rt_ecm_publish(job, g, curve, 1);
+    return 1;
+  }
+  cv->p = *saved;
+  for (uint64_t r = lo; r <= hi; r++) {
+    if (!rt_ecm_is_prime(job, r))
+      continue;
+    for (uint64_t e = r; e <= job->b1; e *= r) {
+      rt_ecm_ladder(w, &cv->p, r, cv->a24);
+      rt_ecm_limbs_mpz(g, cv->p.z, job->mod.nl);
+      mpz_gcd(g, g, job->n);
+      if (mpz_cmp_ui(g, 1) == 0)
+        continue;
+      if (mpz_cmp(g, job->n) < 0) {
+        rt_ecm_publish(job, g, curve, 1);
+        return 1;
+      }
+      return 2;
+    }
+  }
+  return 2;
+}
+
+/* Prime-power ladder up to B1; returns -1 when cancelled, else as above. */
+static int rt_ecm_stage1(rt_ecm_job_t *job, rt_ecm_ws_t *w, rt_ecm_curve_t *cv, mpz_t g, int64_t curve) {
+  uint64_t b1 = job->b1;
+  rt_ecm_pt_t saved = cv->p;
+  uint64_t lo = 2;
+  int polls = 0;
+  for (uint64_t p = 2; p <= b1; p++) {
+    if (!rt_ecm_is_prime(job, p))
+      continue;
+    uint64_t q = p;
+    while (q <= b1 / p)
+      q *= p;
+    rt_ecm_ladder(w, &cv->p, q, cv->a24);
+    if (++polls < RT_ECM_CANCEL_POLL)
+      continue;
+    polls = 0;
+    if (rt_ecm_cancelled(job))
+      return -1;
+    int rc = rt_ecm_stage1_chunk(job, w, cv, &saved, lo, p, g, curve);
+    if (rc)
+      return rc;
+    lo = p + 1;
+  }
+  return polls ? rt_ecm_stage1_chunk(job, w, cv, &saved, lo, b1, g, curve) : 0;
+}
+
+/*
+ * Baby-step/giant-step continuation: with Q the stage 1 point, every prime
+ * q = mD +- j in (B1, B2] contributes X(mDQ) Z(jQ) - X(jQ) Z(mDQ), which
+ * vanishes mod p exactly when q * Q = O on the curve mod p.
+ */
+static int rt_ecm_stage2(rt_ecm_job_t *job, rt_ecm_ws_t *w, rt_ecm_curve_t *cv, mp_limb_t *acc) {
+  const rt_ecm_mod_t *m = w->m;
+  uint64_t d = job->d;
+  uint64_t half = d / 2;
+  rt_ecm_pt_t *baby = (rt_ecm_pt_t *)calloc((size_t)half + 1, sizeof(rt_ecm_pt_t));
+  if (!baby)
+    return 0;
+  /* jQ for odd j <= d/2: (j + 2)Q = jQ + 2Q, difference (j - 2)Q. */
+  rt_ecm_pt_t q2;
+  rt_ecm_xdbl(w, &q2, &cv->p, cv->a24);
+  baby[1] = cv->p;
+  if (half >= 3)
+    rt_ecm_xadd(w, &baby[3], &q2, &cv->p, &cv->p);
+  for (uint64_t j = 5; j <= half; j += 2)
+    rt_ecm_xadd(w, &baby[j], &baby[j - 2], &q2, &baby[j - 4]);
+  uint64_t m_lo = job->b1 / d;
+  if (m_lo == 0)
+    m_lo = 1;
+  uint64_t m_hi = job->b2 / d + 1;
+  rt_ecm_pt_t step = cv->p;
+  rt_ecm_ladder(w, &step, d, cv->a24);
+  rt_ecm_pt_t prev = cv->p;
+  rt_ecm_pt_t cur = cv->p;
+  rt_ecm_ladder(w, &prev, (m_lo - 1) * d, cv->a24);
+  rt_ecm_ladder(w, &cur, m_lo * d, cv->a24);
+  if (m_lo == 1)
+    cur = step;
+  int rc = 0;
+  for (uint64_t mm = m_lo; mm <= m_hi; mm++) {
+    uint64_t base = mm * d;
+    for (uint64_t j = 1; j <= half; j += 2) {
+      uint64_t hi = base + j;
+      uint64_t lo = base - j;
+      bool use = (hi > job->b1 && hi <= job->b2 && rt_ecm_is_prime(job, hi)) ||
+                 (lo > job->b1 && lo <= job->b2 && rt_ecm_is_prime(job, lo));
+      if (!use)
+        continue;
+      rt_ecm_mul(w, w->c, cur.x, baby[j].z);
+      rt_ecm_mul(w, w->d, baby[j].x, cur.z);
+      rt_ecm_sub(m, w->c, w->c, w->d);
+      rt_ecm_mul(w, acc, acc, w->c);
+    }
+    if (rt_ecm_cancelled(job)) {
+      rc = -1;
+      break;
+    }
+    /* (m + 1)DQ = mDQ + DQ with difference (m - 1)DQ; m_lo == 1 starts from O. */
+    rt_ecm_pt_t next;
+    if (mm == 1)
+      rt_ecm_xdbl(w, &next, &cur, cv->a24);
+    else
+      rt_ecm_xadd(w, &next, &cur, &step, &prev);
+    prev = cur;
+    cur = next;
+  }
+  free(baby);
+  return rc;
+}
+
+static void rt_ecm_worker(void *arg) {
+  rt_ecm_job_t *job = (rt_ecm_job_t *)arg;
+  rt_ecm_ws_t *w = (rt_ecm_ws_t *)calloc(1, sizeof(rt_ecm_ws_t));
+  mp_limb_t *acc = (mp_limb_t *)calloc(RT_ECM_MAX_LIMBS, sizeof(mp_limb_t));
+  mpz_t g, one;
+  mpz_inits(g, one, NULL);
+  if (!w || !acc)
+    goto done;
+  w->m = &job->mod;
+  mpz_set_ui(one, 1);
+  while (!rt_ecm_cancelled(job)) {
+    int64_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (i >= job->curve_count)
+      break;
+    rt_ecm_curve_t *cv = &job->curves[i];
+    if (!cv->ready)
+      continue;
+    int rc = rt_ecm_stage1(job, w, cv, g, i);
+    if (rc < 0 || rc == 1)
+      break;
+    if (rc == 2) {
+      __atomic_fetch_add(&job->done, 1, __ATOMIC_RELAXED);
+      continue;
+    }
+    if (job->b2 > job->b1) {
+      rt_ecm_to_mont(&job->mod, job->n, acc, one);
+      if (rt_ecm_stage2(job, w, cv, acc) < 0)
+        break;
+      if (rt_ecm_gcd_check(job, acc, g, i, 2))
+        break;
+    }
+    __atomic_fetch_add(&job->done, 1, __ATOMIC_RELAXED);
+  }
+done:
+  mpz_clears(g, one, NULL);
+  free(acc);
+  free(w);
+}
+
+static uint8_t *rt_ecm_sieve(uint64_t limit) {
+  uint8_t *c = (uint8_t *)calloc((size_t)limit + 1, 1);
+  if (!c)
+    return NULL;
+  c[0] = c[1] = 1;
+  for (uint64_t p = 2; p * p <= limit; p++)
+    if (!c[p])
+      for (uint64_t q = p * p; q <= limit; q += p)
+        c[q] = 1;
+  return c;
+}
+
+static inline int64_t rt_ecm_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static int64_t rt_ecm_box_mpz(const mpz_t v) {
+  if (_bi_mpz_fits_small_int(v))
+    return rt_tag_v(_bi_mpz_get_i64(v));
+  return _bi_from_mpz(v);
+}
+
+/*
+ * Runs up to `curves` Suyama curves (sigma_start, sigma_start + 1, ...) on n.
+ * Returns [factor|nil, curve, sigma, stage, curves_done, threads] or nil when
+ * n is not an odd integer > 3 within the fixed-width limit.
+ */
+int64_t rt_ecm_factor(int64_t n_v, int64_t b1_v, int64_t b2_v, int64_t curves_v,
+                      int64_t sigma_v, int64_t threads_v) {
+  int64_t b1 = rt_ecm_int_arg(b1_v);
+  int64_t b2 = rt_ecm_int_arg(b2_v);
+  int64_t curves = rt_ecm_int_arg(curves_v);
+  int64_t sigma0 = rt_ecm_int_arg(sigma_v);
+  int64_t threads = rt_ecm_int_arg(threads_v);
+  if (!is_int(n_v) && !(is_ptr(n_v) && is_heap_ptr(n_v) &&
+                        *(int64_t *)((char *)(uintptr_t)n_v - 8) == TAG_BIGINT))
+    return 0;
+  if (b1 < 2 || curves <= 0 || b1 > (INT64_C(1) << 32))
+    return 0;
+  if (b2 < b1)
+    b2 = b1;
+  if (b2 > (INT64_C(1) << 34))
+    b2 = INT64_C(1) << 34;
+  if (sigma0 < 6)
+    sigma0 = 6;
+  rt_ecm_job_t job;
+  memset(&job, 0, sizeof(job));
+  _bi_val_to_mpz(n_v, job.n);
+  mpz_abs(job.n, job.n);
+  mpz_init(job.factor);
+  int64_t out = 0;
+  if (mpz_cmp_ui(job.n, 3) <= 0 || !rt_ecm_mod_init(&job.mod, job.n))
+    goto cleanup;
+  job.b1 = (uint64_t)b1;
+  job.b2 = (uint64_t)b2;
+  job.d = job.b2 - job.b1 > 2310 * 2310 / 4 ? 2310 : 210;
+  job.curve_count = curves;
+  job.factor_curve = -1;
+  job.curves = (rt_ecm_curve_t *)calloc((size_t)curves, sizeof(rt_ecm_curve_t));
+  uint8_t *composite = rt_ecm_sieve(job.b2 + job.d + 1);
+  job.composite = composite;
+  if (!job.curves || !composite) {
+    free(composite);
+    goto cleanup;
+  }
+  if (threads <= 0)
+    threads = ny_cpu_count();
+  if (threads > RT_ECM_MAX_THREADS)
+    threads = RT_ECM_MAX_THREADS;
+  if (threads > curves)
+    threads = curves;
+#if defined(_WIN32)
+  InitializeCriticalSection(&job.lock);
+#else
+  pthread_mutex_init(&job.lock, NULL);
+#endif
+  if (rt_ecm_setup(&job, sigma0) && !job.found)
+    rt_parallel_run(rt_ecm_worker, &job, 0, (int)threads);
+#if defined(_WIN32)
+  DeleteCriticalSection(&job.lock);
+#else
+  pthread_mutex_destroy(&job.lock);
+#endif
+  free(composite);
+  int64_t items[6];
+  items[0] = job.found ? rt_ecm_box_mpz(job.factor) : 0;
+  items[1] = rt_tag_v(job.factor_curve);
+  items[2] = rt_tag_v(job.factor_curve >= 0 ? sigma0 + job.factor_curve : -1);
+  items[3] = rt_tag_v(job.factor_stage);
+  items[4] = rt_tag_v(job.done + (job.found ? 1 : 0));
+  items[5] = rt_tag_v(threads);
+  out = rt_list_new(rt_tag_v(6));
+  if (out) {
+    for (int i = 0; i < 6; i++)
+      *(int64_t *)((char *)(uintptr_t)out + 16 + i * 8) = items[i];
+    *(int64_t *)(uintptr_t)out = rt_tag_v(6);
+  }
+cleanup:
+  free(job.curves);
+  mpz_clear(job.factor);
+  mpz_clear(job.n);
+  return out;
+}
@@ -1125,6 +1125,7 @@ int64_t rt_call4_f32_void(int64_t f, int64_t a, int64_t b, int64_t c, int64_t d)
   return 1;
 }
 
+#include <errno.h>
 #include <zlib.h>
 
 int64_t rt_zlib_uncompress(int64_t dest, int64_t destLen_p, int64_t src, int64_t srcLen) {
@@ -1162,3 +1163,221 @@ int64_t rt_zlib_compress_str(int64_t src, int64_t srcLen, int64_t level) {
 }
 
 int64_t rt_zlib_bound(int64_t n) { return rt_tag_v((int64_t)compressBound((uLong)rt_untag_v(n))); }
+
+/* ---- Streaming inflate/deflate ------------------------------------------- */
+
+/* A stream keeps one z_stream alive across calls so input can arrive in
+   chunks and output can be drained into bounded buffers: every input byte
+   goes through zlib exactly once, however large the payload. */
+
+#define RT_ZSTREAM_MAGIC UINT64_C(0x4e595a5354524d31)
+#define RT_ZSTREAM_DRAIN ((size_t)64 << 10)
+
+typedef struct {
+  uint64_t magic;
+  z_stream z;
+  bool deflate;
+  bool done; /* Z_STREAM_END seen */
+  int status; /* last zlib result: 0, 1 at the end, or a negative error */
+  unsigned char *drain;
+} rt_zstream_t;
+
+static rt_zstream_t *rt_zstream_handle(int64_t v) {
+  if (!is_ptr(v))
+    return NULL;
+  uintptr_t p = (uintptr_t)v;
+  if (!rt_addr_readable_safe(p, sizeof(uint64_t)))
+    return NULL;
+  rt_zstream_t *s = (rt_zstream_t *)p;
+  return s->magic == RT_ZSTREAM_MAGIC ? s : NULL;
+}
+
+int64_t rt_zstream_new(int64_t mode_v, int64_t level_v, int64_t wbits_v) {
+  int64_t level = rt_untag_v(level_v), wbits = rt_untag_v(wbits_v);
+  rt_zstream_t *s = (rt_zstream_t *)calloc(1, sizeof(rt_zstream_t));
+  if (!s)
+    return 0;
+  s->deflate = rt_untag_v(mode_v) != 0;
+  int rc;
+  if (s->deflate) {
+    if (level < -1 || level > 9)
+      level = Z_DEFAULT_COMPRESSION;
+    /* 15 = zlib, 31 = gzip, -15 = raw deflate. */
+    rc = deflateInit2(&s->z, (int)level, Z_DEFLATED, wbits ? (int)wbits : 15, 8,
+                      Z_DEFAULT_STRATEGY);
+  } else {
+    /* 47 detects zlib or gzip headers. */
+    rc = inflateInit2(&s->z, wbits ? (int)wbits : 47);
+  }
+  if (rc != Z_OK) {
+    free(s);
+    return 0;
+  }
+  s->magic = RT_ZSTREAM_MAGIC;
+  return (int64_t)(uintptr_t)s;
+}
+
+/* One zlib call over the current next_in/next_out. */
+static int rt_zstream_step(rt_zstream_t *s, bool finish) {
+  if (s->done)
+    return 1;
+  int rc = s->deflate ? deflate(&s->z, finish ? Z_FINISH : Z_NO_FLUSH) : inflate(&s->z, Z_NO_FLUSH);
+  if (rc == Z_STREAM_END) {
+    s->done = true;
+    s->status = 1;
+  } else if (rc == Z_OK || rc == Z_BUF_ERROR) {
+    s->status = 0; /* needs more input or more output space */
+  } else {
+    s->status = rc == Z_NEED_DICT ? Z_DATA_ERROR : rc;
+  }
+  return s->status;
+}
+
+int64_t rt_zstream_run(int64_t h_v, int64_t src_v, int64_t src_len_v, int64_t dst_v,
+                       int64_t dst_cap_v, int64_t finish_v) {
+  rt_zstream_t *s = rt_zstream_handle(h_v);
+  int64_t out = rt_list_new(rt_tag_v(3));
+  if (!out)
+    return 0;
+  *(int64_t *)(uintptr_t)out = rt_tag_v(3);
+  int64_t *items = (int64_t *)((char *)(uintptr_t)out + 16);
+  if (!s) {
+    items[0] = rt_tag_v(Z_STREAM_ERROR);
+    items[1] = items[2] = rt_tag_v(0);
+    return out;
+  }
+  size_t src_len = (size_t)rt_untag_v(src_len_v), dst_cap = (size_t)rt_untag_v(dst_cap_v);
+  s->z.next_in = (Bytef *)(uintptr_t)rt_untag_v(src_v);
+  s->z.avail_in = (uInt)(src_len > UINT_MAX ? UINT_MAX : src_len);
+  s->z.next_out = (Bytef *)(uintptr_t)rt_untag_v(dst_v);
+  s->z.avail_out = (uInt)(dst_cap > UINT_MAX ? UINT_MAX : dst_cap);
+  uInt in0 = s->z.avail_in, out0 = s->z.avail_out;
+  int st = s->status < 0 ? s->status : rt_zstream_step(s, rt_is_truthy(finish_v));
+  items[0] = rt_tag_v(st);
+  items[1] = rt_tag_v((int64_t)(in0 - s->z.avail_in));
+  items[2] = rt_tag_v((int64_t)(out0 - s->z.avail_out));
+  s->z.next_in = s->z.next_out = NULL;
+  return out;
+}
+
+/* Feeds src and hands every drained block to sink; returns false when the
+   sink fails. Stops at the end of the stream or on a zlib error. */
+static bool rt_zstream_pump(rt_zstream_t *s, const unsigned char *src, size_t len, bool finish,
+                            bool (*sink)(void *, const unsigned char *, size_t), void *ctx) {
+  if (!s->drain && !(s->drain = (unsigned char *)malloc(RT_ZSTREAM_DRAIN))) {
+    s->status = Z_MEM_ERROR;
+    return true;
+  }
+  s->z.next_in = (Bytef *)src;
+  while (s->status >= 0 && !s->done) {
+    if (!s->z.avail_in && len) {
+      uInt take = len > UINT_MAX ? UINT_MAX : (uInt)len;
+      s->z.avail_in = take;
+      len -= take;
+    }
+    s->z.next_out = s->drain;
+    s->z.avail_out = (uInt)RT_ZSTREAM_DRAIN;
+    rt_zstream_step(s, finish && !len);
+    size_t got = RT_ZSTREAM_DRAIN - s->z.avail_out;
+    if (got && !sink(ctx, s->drain, got))
+      return false;
+    /* Done once the input is gone and zlib had room to spare. */
+    if (!s->z.avail_in && !len && s->z.avail_out && (!finish || !s->deflate))
+      break;
+  }
+  s->z.next_in = s->z.next_out = NULL;
+  s->z.avail_in = 0;
+  return true;
+}
+
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t cap;
+} rt_zstream_bytes_t;
+
+static bool rt_zstream_to_bytes(void *ctx, const unsigned char *p, size_t n) {
+  rt_zstream_bytes_t *b = (rt_zstream_bytes_t *)ctx;
+  if (b->len + n > b->cap) {
+    size_t nc = b->cap ? b->cap : RT_ZSTREAM_DRAIN;
+    while (nc < b->len + n)
+      nc *= 2;
+    char *nb = (char *)realloc(b->buf, nc);
+    if (!nb)
+      return false;
+    b->buf = nb;
+    b->cap = nc;
+  }
+  memcpy(b->buf + b->len, p, n);
+  b->len += n;
+  return true;
+}
+
+static bool rt_zstream_to_fd(void *ctx, const unsigned char *p, size_t n) {
+  int fd = *(int *)ctx;
+  while (n) {
+    ssize_t w = write(fd, p, n);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      return false;
+    p += w;
+    n -= (size_t)w;
+  }
+  return true;
+}
+
+int64_t rt_zstream_feed(int64_t h_v, int64_t src_v, int64_t src_len_v, int64_t finish_v) {
+  rt_zstream_t *s = rt_zstream_handle(h_v);
+  if (!s)
+    return 0;
+  rt_zstream_bytes_t b = {0};
+  if (!rt_zstream_pump(s, (const unsigned char *)(uintptr_t)rt_untag_v(src_v),
+                       (size_t)rt_untag_v(src_len_v), rt_is_truthy(finish_v), rt_zstream_to_bytes,
+                       &b))
+    s->status = Z_MEM_ERROR;
+  int64_t out = rt_alloc_string_len(b.buf ? b.buf : "", b.len);
+  free(b.buf);
+  return out;
+}
+
+int64_t rt_zstream_feed_fd(int64_t h_v, int64_t src_v, int64_t src_len_v, int64_t fd_v,
+                           int64_t finish_v) {
+  rt_zstream_t *s = rt_zstream_handle(h_v);
+  if (!s)
+    return rt_tag_v(-1);
+  int fd = (int)rt_untag_v(fd_v);
+  uLong out0 = s->z.total_out;
+  if (!rt_zstream_pump(s, (const unsigned char *)(uintptr_t)rt_untag_v(src_v),
+                       (size_t)rt_untag_v(src_len_v), rt_is_truthy(finish_v), rt_zstream_to_fd,
+                       &fd))
+    return rt_tag_v(-1);
+  return rt_tag_v((int64_t)(s->z.total_out - out0));
+}
+
+int64_t rt_zstream_status(int64_t h_v) {
+  rt_zstream_t *s = rt_zstream_handle(h_v);
+  int64_t out = rt_list_new(rt_tag_v(3));
+  if (!out)
+    return 0;
+  *(int64_t *)(uintptr_t)out = rt_tag_v(3);
+  int64_t *items = (int64_t *)((char *)(uintptr_t)out + 16);
+  items[0] = rt_tag_v(s ? s->status : Z_STREAM_ERROR);
+  items[1] = rt_tag_v(s ? (int64_t)s->z.total_in : 0);
+  items[2] = rt_tag_v(s ? (int64_t)s->z.total_out : 0);
+  return out;
+}
+
+int64_t rt_zstream_free(int64_t h_v) {
+  rt_zstream_t *s = rt_zstream_handle(h_v);
+  if (!s)
+    return 0;
+  if (s->deflate)
+    deflateEnd(&s->z);
+  else
+    inflateEnd(&s->z);
+  s->magic = 0;
+  free(s->drain);
+  free(s);
+  return 0;
+}
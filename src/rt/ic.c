@@ -0,0 +1,120 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Inline-cache counters.
+ *
+ * Member-call inline caches compiled with NYTRIX_IC_STATS report each
+ * dispatch through __ic_count: way >= 0 is a hit on that cache entry,
+ * way == -1 is a miss that took the generic method. Sites share the
+ * lock-free open-addressed layout of rt/pgo.c. At exit the table is
+ * written to NYTRIX_IC_STATS (stderr when it is just "1"), one site per
+ * line:
+ *
+ *   <site-hex> <calls> <misses> <hits per way>... # <file:line:col .name ways>
+ */
+
+#define RT_IC_MAX_SITES 4096u
+#define RT_IC_MAX_WAYS 4u
+
+typedef struct {
+  uint64_t site;
+  const char *label;
+  uint64_t misses;
+  uint64_t hits[RT_IC_MAX_WAYS];
+} rt_ic_site_t;
+
+static rt_ic_site_t *rt_ic_sites;
+static int rt_ic_state; /* 0 idle, 1 initialising, 2 ready, -1 failed */
+
+static void rt_ic_dump(void);
+
+static bool rt_ic_ready(void) {
+  int st = __atomic_load_n(&rt_ic_state, __ATOMIC_ACQUIRE);
+  if (st == 2)
+    return true;
+  if (st < 0)
+    return false;
+  int expected = 0;
+  if (__atomic_compare_exchange_n(&rt_ic_state, &expected, 1, false,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    rt_ic_sites = calloc(RT_IC_MAX_SITES, sizeof(rt_ic_site_t));
+    if (rt_ic_sites)
+      atexit(rt_ic_dump);
+    __atomic_store_n(&rt_ic_state, rt_ic_sites ? 2 : -1, __ATOMIC_RELEASE);
+    return rt_ic_sites != NULL;
+  }
+  while ((st = __atomic_load_n(&rt_ic_state, __ATOMIC_ACQUIRE)) == 1) {
+  }
+  return st == 2;
+}
+
+static rt_ic_site_t *rt_ic_slot(uint64_t site, int64_t label) {
+  if (site == 0)
+    site = 1;
+  uint32_t mask = RT_IC_MAX_SITES - 1u;
+  uint32_t i = (uint32_t)(site ^ (site >> 29)) & mask;
+  for (uint32_t probe = 0; probe < RT_IC_MAX_SITES; probe++) {
+    rt_ic_site_t *s = &rt_ic_sites[(i + probe) & mask];
+    uint64_t cur = __atomic_load_n(&s->site, __ATOMIC_ACQUIRE);
+    if (cur == site)
+      return s;
+    if (cur != 0)
+      continue;
+    uint64_t expected = 0;
+    if (__atomic_compare_exchange_n(&s->site, &expected, site, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      /* Copy the label: JIT string constants are gone by the atexit dump. */
+      const char *src = is_v_str(label) ? (const char *)(uintptr_t)label : "";
+      __atomic_store_n(&s->label, strdup(src), __ATOMIC_RELEASE);
+      return s;
+    }
+    if (expected == site)
+      return s;
+  }
+  return NULL;
+}
+
+int64_t rt_ic_count(int64_t site, int64_t way, int64_t label) {
+  if (!rt_ic_ready())
+    return 0;
+  rt_ic_site_t *s = rt_ic_slot((uint64_t)site, label);
+  if (!s)
+    return 0;
+  if (way < 0)
+    __atomic_fetch_add(&s->misses, 1, __ATOMIC_RELAXED);
+  else if ((uint64_t)way < RT_IC_MAX_WAYS)
+    __atomic_fetch_add(&s->hits[way], 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+static void rt_ic_dump(void) {
+  if (__atomic_load_n(&rt_ic_state, __ATOMIC_ACQUIRE) != 2)
+    return;
+  const char *path = getenv("NYTRIX_IC_STATS");
+  bool to_stderr = !path || !*path || strcmp(path, "1") == 0;
+  FILE *f = to_stderr ? stderr : fopen(path, "w");
+  if (!f)
+    return;
+  for (uint32_t i = 0; i < RT_IC_MAX_SITES; i++) {
+    rt_ic_site_t *s = &rt_ic_sites[i];
+    if (!s->site)
+      continue;
+    uint64_t calls = s->misses;
+    for (uint32_t w = 0; w < RT_IC_MAX_WAYS; w++)
+      calls += s->hits[w];
+    fprintf(f, "%016llx %llu %llu", (unsigned long long)s->site,
+            (unsigned long long)calls, (unsigned long long)s->misses);
+    for (uint32_t w = 0; w < RT_IC_MAX_WAYS; w++)
+      fprintf(f, " %llu", (unsigned long long)s->hits[w]);
+    fprintf(f, " # %s\n", s->label ? s->label : "");
+  }
+  if (!to_stderr)
+    fclose(f);
+}
@@ -2,12 +2,23 @@
 
 #include "bigint.c"
 #include "core.c"
+#include "csv.c"
 #include "simmd.c"
+#include "ecm.c"
 #include "ffi.c"
 #include "ffigates.c"
 #include "gc.c"
+#include "ic.c"
+#include "jpeg.c"
+#include "json.c"
+#include "lattice.c"
 #include "math.c"
 #include "memory.c"
+#include "modarith.c"
+#include "ntt.c"
+#include "ndarray.c"
 #include "os.c"
+#include "pgo.c"
+#include "png.c"
 #include "proof.c"
 #include "string.c"
@@ -0,0 +1,934 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define RT_JPEG_SSE2 1
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RT_JPEG_NEON 1
+#endif
+
+#if defined(RT_JPEG_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define RT_JPEG_X86_DISPATCH 1
+#endif
+
+/*
+ * Baseline JPEG decoder for std.math.parse.img.jpeg.
+ *
+ * Huffman codes up to 9 bits resolve through a lookahead table indexed by
+ * the next bits of a 64-bit accumulator; longer codes fall back to the
+ * canonical per-length limits. Blocks whose AC coefficients are all zero
+ * skip the IDCT. The others go through the accurate integer IDCT (libjpeg's
+ * islow constants), eight lanes at a time with AVX2 or NEON.
+ *
+ * Restart markers split the entropy-coded data into segments that reset the
+ * DC predictors, so a quick scan for RSTn markers lets worker threads decode
+ * disjoint runs of MCUs into the component planes at once. Colour
+ * conversion then runs per output row, with nearest-sample chroma
+ * upsampling and a 14-bit fixed-point YCbCr to RGBA kernel (SSE2 or NEON).
+ *
+ * With scale 8 only DC coefficients are kept: every block becomes one
+ * pixel, which is what thumbnails need and costs no IDCT at all.
+ *
+ * Progressive, arithmetic-coded, 12-bit and CMYK files are declined (0) so
+ * the caller can fall back to its own decoder.
+ */
+
+extern int64_t rt_list_new(int64_t n);
+extern int64_t rt_append(int64_t lst, int64_t val);
+
+#define RT_JPEG_FAST_BITS 9
+#define RT_JPEG_MAX_THREADS RT_MAX_THREADS
+#define RT_JPEG_MAX_DIM 16384
+
+static const uint8_t rt_jpeg_zigzag[64 + 16] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33,
+    40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54,
+    47, 55, 62, 63,
+    /* run lengths past the end land here harmlessly */
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63};
+
+typedef struct {
+  uint16_t fast[1 << RT_JPEG_FAST_BITS]; /* (length << 8) | symbol, 0 = slow path */
+  uint32_t maxcode[18];                  /* per length, left-justified to 16 bits */
+  int32_t delta[17];                     /* symbol index minus code, per length */
+  uint8_t vals[256];
+  bool present;
+} rt_jpeg_huff_t;
+
+typedef struct {
+  int id, hs, vs, tq, td, ta;
+  uint8_t *plane;
+  size_t pw, ph; /* plane size in samples at the decode scale */
+} rt_jpeg_comp_t;
+
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+  int w, h, ncomp;
+  rt_jpeg_comp_t comp[3];
+  uint16_t q[4][64]; /* zigzag order, as stored */
+  rt_jpeg_huff_t dc[4], ac[4];
+  int ri;
+  int mh, mv;
+  size_t mcux, mcuy;
+  size_t scan; /* first byte of entropy-coded data */
+  int bsz;     /* samples per block side: 8, or 1 for DC-only */
+} rt_jpeg_t;
+
+static int g_rt_jpeg_threads = -1;
+
+static int rt_jpeg_thread_count(void) {
+  return rt_thread_count(&g_rt_jpeg_threads, "NYTRIX_JPEG_THREADS", 0, RT_JPEG_MAX_THREADS);
+}
+
+static inline uint8_t rt_jpeg_clamp(int v) { return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v); }
+
+/* ---- Huffman tables ------------------------------------------------------ */
+
+static bool rt_jpeg_huff_build(rt_jpeg_huff_t *h, const uint8_t counts[16], const uint8_t *vals,
+                               int nvals) {
+  uint8_t sizes[257];
+  uint16_t codes[256];
+  int k = 0;
+  for (int i = 0; i < 16; i++)
+    for (int j = 0; j < counts[i]; j++)
+      sizes[k++] = (uint8_t)(i + 1);
+  sizes[k] = 0;
+  memset(h, 0, sizeof(*h));
+  memcpy(h->vals, vals, (size_t)nvals);
+  uint32_t code = 0;
+  k = 0;
+  for (int j = 1; j <= 16; j++) {
+    h->delta[j] = k - (int32_t)code;
+    while (sizes[k] == j)
+      codes[k++] = (uint16_t)code++;
+    if (code - 1 >= (1u << j) && code)
+      return false;
+    h->maxcode[j] = code << (16 - j);
+    code <<= 1;
+  }
+  h->maxcode[17] = UINT32_MAX;
+  for (int i = 0; i < k; i++) {
+    int s = sizes[i];
+    if (s > RT_JPEG_FAST_BITS)
+      continue;
+    int c = codes[i] << (RT_JPEG_FAST_BITS - s), m = 1 << (RT_JPEG_FAST_BITS - s);
+    for (int j = 0; j < m; j++)
+      h->fast[c + j] = (uint16_t)((s << 8) | h->vals[i]);
+  }
+  h->present = true;
+  return true;
+}
+
+/* ---- Bit reader ---------------------------------------------------------- */
+
+/* The next bits sit at the top of acc. At a marker the reader stops and
+   feeds zeros, so a damaged segment decodes to grey instead of running on. */
+typedef struct {
+  const uint8_t *p, *end;
+  uint64_t acc;
+  int nbits;
+  bool marker;
+} rt_jpeg_bits_t;
+
+static inline void rt_jpeg_refill(rt_jpeg_bits_t *b) {
+  while (b->nbits <= 56) {
+    uint32_t c = 0;
+    if (!b->marker && b->p < b->end) {
+      c = *b->p;
+      if (c == 0xFF) {
+        if (b->p + 1 < b->end && b->p[1] == 0) {
+          b->p += 2;
+        } else {
+          b->marker = true;
+          c = 0;
+        }
+      } else {
+        b->p++;
+      }
+    }
+    b->acc |= (uint64_t)c << (56 - b->nbits);
+    b->nbits += 8;
+  }
+}
+
+static inline int rt_jpeg_huff_decode(rt_jpeg_bits_t *b, const rt_jpeg_huff_t *h) {
+  if (b->nbits < 32)
+    rt_jpeg_refill(b);
+  int e = h->fast[b->acc >> (64 - RT_JPEG_FAST_BITS)];
+  if (e) {
+    b->acc <<= e >> 8;
+    b->nbits -= e >> 8;
+    return e & 0xff;
+  }
+  uint32_t top = (uint32_t)(b->acc >> 48);
+  int k = RT_JPEG_FAST_BITS + 1;
+  while (top >= h->maxcode[k])
+    k++;
+  if (k > 16)
+    return -1;
+  int idx = (int)(b->acc >> (64 - k)) + h->delta[k];
+  if (idx < 0 || idx > 255)
+    return -1;
+  b->acc <<= k;
+  b->nbits -= k;
+  return h->vals[idx];
+}
+
+/* Reads an s-bit magnitude and sign-extends it (F.2.2.1 EXTEND). */
+static inline int rt_jpeg_receive(rt_jpeg_bits_t *b, int s) {
+  if (!s)
+    return 0;
+  if (b->nbits < s)
+    rt_jpeg_refill(b);
+  int v = (int)(b->acc >> (64 - s));
+  b->acc <<= s;
+  b->nbits -= s;
+  return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+/* Decodes one block into natural order, dequantized. Returns -1 on a bad
+   code, otherwise 1 if any AC coefficient was set. With blk NULL the AC
+   coefficients are only skipped. */
+static int rt_jpeg_block(rt_jpeg_bits_t *b, const rt_jpeg_huff_t *dc, const rt_jpeg_huff_t *ac,
+                         const uint16_t *q, int *pred, int32_t *blk) {
+  int t = rt_jpeg_huff_decode(b, dc);
+  if (t < 0 || t > 11)
+    return -1;
+  *pred += rt_jpeg_receive(b, t);
+  int any = 0;
+  if (blk) {
+    memset(blk, 0, 64 * sizeof(int32_t));
+    blk[0] = *pred * q[0];
+  }
+  for (int k = 1; k < 64;) {
+    int rs = rt_jpeg_huff_decode(b, ac);
+    if (rs < 0)
+      return -1;
+    int r = rs >> 4, s = rs & 15;
+    if (!s) {
+      if (r != 15)
+        break;
+      k += 16;
+      continue;
+    }
+    k += r;
+    int v = rt_jpeg_receive(b, s);
+    if (k > 63)
+      return -1;
+    if (blk) {
+      blk[rt_jpeg_zigzag[k]] = v * q[k];
+      any = 1;
+    }
+    k++;
+  }
+  return any;
+}
+
+/* ---- IDCT ---------------------------------------------------------------- */
+
+#define RT_JPEG_FIX_0_298631336 2446
+#define RT_JPEG_FIX_0_390180644 3196
+#define RT_JPEG_FIX_0_541196100 4433
+#define RT_JPEG_FIX_0_765366865 6270
+#define RT_JPEG_FIX_0_899976223 7373
+#define RT_JPEG_FIX_1_175875602 9633
+#define RT_JPEG_FIX_1_501321110 12299
+#define RT_JPEG_FIX_1_847759065 15137
+#define RT_JPEG_FIX_1_961570560 16069
+#define RT_JPEG_FIX_2_053119869 16819
+#define RT_JPEG_FIX_2_562915447 20995
+#define RT_JPEG_FIX_3_072711026 25172
+#define RT_JPEG_CONST_BITS 13
+#define RT_JPEG_PASS1_BITS 2
+
+/* One 8-point islow IDCT; `s` is the input stride, outputs are undescaled. */
+static inline void rt_jpeg_idct_1d(const int32_t *in, size_t s, int64_t out[8]) {
+  int64_t z2 = in[2 * s], z3 = in[6 * s];
+  int64_t z1 = (z2 + z3) * RT_JPEG_FIX_0_541196100;
+  int64_t t2 = z1 - z3 * RT_JPEG_FIX_1_847759065, t3 = z1 + z2 * RT_JPEG_FIX_0_765366865;
+  int64_t t0 = ((int64_t)in[0] + in[4 * s]) * (1 << RT_JPEG_CONST_BITS);
+  int64_t t1 = ((int64_t)in[0] - in[4 * s]) * (1 << RT_JPEG_CONST_BITS);
+  int64_t e10 = t0 + t3, e13 = t0 - t3, e11 = t1 + t2, e12 = t1 - t2;
+  int64_t o0 = in[7 * s], o1 = in[5 * s], o2 = in[3 * s], o3 = in[1 * s];
+  z1 = o0 + o3;
+  z2 = o1 + o2;
+  z3 = o0 + o2;
+  int64_t z4 = o1 + o3, z5 = (z3 + z4) * RT_JPEG_FIX_1_175875602;
+  o0 *= RT_JPEG_FIX_0_298631336;
+  o1 *= RT_JPEG_FIX_2_053119869;
+  o2 *= RT_JPEG_FIX_3_072711026;
+  o3 *= RT_JPEG_FIX_1_501321110;
+  z1 *= -RT_JPEG_FIX_0_899976223;
+  z2 *= -RT_JPEG_FIX_2_562915447;
+  z3 = z3 * -RT_JPEG_FIX_1_961570560 + z5;
+  z4 = z4 * -RT_JPEG_FIX_0_390180644 + z5;
+  o0 += z1 + z3;
+  o1 += z2 + z4;
+  o2 += z2 + z3;
+  o3 += z1 + z4;
+  out[0] = e10 + o3;
+  out[7] = e10 - o3;
+  out[1] = e11 + o2;
+  out[6] = e11 - o2;
+  out[2] = e12 + o1;
+  out[5] = e12 - o1;
+  out[3] = e13 + o0;
+  out[4] = e13 - o0;
+}
+
+static void rt_jpeg_idct_scalar(const int32_t *blk, uint8_t *dst, size_t stride) {
+  int32_t ws[64];
+  int64_t o[8];
+  const int sh1 = RT_JPEG_CONST_BITS - RT_JPEG_PASS1_BITS;
+  const int sh2 = RT_JPEG_CONST_BITS + RT_JPEG_PASS1_BITS + 3;
+  for (int c = 0; c < 8; c++) {
+    rt_jpeg_idct_1d(blk + c, 8, o);
+    for (int r = 0; r < 8; r++)
+      ws[r * 8 + c] = (int32_t)((o[r] + ((int64_t)1 << (sh1 - 1))) >> sh1);
+  }
+  for (int r = 0; r < 8; r++) {
+    rt_jpeg_idct_1d(ws + r * 8, 1, o);
+    for (int c = 0; c < 8; c++)
+      dst[r * stride + c] = rt_jpeg_clamp((int)((o[c] + ((int64_t)1 << (sh2 - 1))) >> sh2) + 128);
+  }
+}
+
+#if defined(RT_JPEG_X86_DISPATCH)
+
+#define RT_JPEG_ADD _mm256_add_epi32
+#define RT_JPEG_SUB _mm256_sub_epi32
+#define RT_JPEG_MUL(a, k) _mm256_mullo_epi32((a), _mm256_set1_epi32(k))
+#define RT_JPEG_SHL(a, n) _mm256_slli_epi32((a), (n))
+
+/* The islow 1-D IDCT over eight lanes, one row of the block per vector. */
+__attribute__((target("avx2"))) static inline void rt_jpeg_idct_avx2_1d(__m256i v[8]) {
+  __m256i z1 = RT_JPEG_MUL(RT_JPEG_ADD(v[2], v[6]), RT_JPEG_FIX_0_541196100);
+  __m256i t2 = RT_JPEG_SUB(z1, RT_JPEG_MUL(v[6], RT_JPEG_FIX_1_847759065));
+  __m256i t3 = RT_JPEG_ADD(z1, RT_JPEG_MUL(v[2], RT_JPEG_FIX_0_765366865));
+  __m256i t0 = RT_JPEG_SHL(RT_JPEG_ADD(v[0], v[4]), RT_JPEG_CONST_BITS);
+  __m256i t1 = RT_JPEG_SHL(RT_JPEG_SUB(v[0], v[4]), RT_JPEG_CONST_BITS);
+  __m256i e10 = RT_JPEG_ADD(t0, t3), e13 = RT_JPEG_SUB(t0, t3);
+  __m256i e11 = RT_JPEG_ADD(t1, t2), e12 = RT_JPEG_SUB(t1, t2);
+  __m256i o0 = v[7], o1 = v[5], o2 = v[3], o3 = v[1];
+  z1 = RT_JPEG_ADD(o0, o3);
+  __m256i z2 = RT_JPEG_ADD(o1, o2), z3 = RT_JPEG_ADD(o0, o2), z4 = RT_JPEG_ADD(o1, o3);
+  __m256i z5 = RT_JPEG_MUL(RT_JPEG_ADD(z3, z4), RT_JPEG_FIX_1_175875602);
+  o0 = RT_JPEG_MUL(o0, RT_JPEG_FIX_0_298631336);
+  o1 = RT_JPEG_MUL(o1, RT_JPEG_FIX_2_053119869);
+  o2 = RT_JPEG_MUL(o2, RT_JPEG_FIX_3_072711026);
+  o3 = RT_JPEG_MUL(o3, RT_JPEG_FIX_1_501321110);
+  z1 = RT_JPEG_MUL(z1, -RT_JPEG_FIX_0_899976223);
+  z2 = RT_JPEG_MUL(z2, -RT_JPEG_FIX_2_562915447);
+  z3 = RT_JPEG_ADD(RT_JPEG_MUL(z3, -RT_JPEG_FIX_1_961570560), z5);
+  z4 = RT_JPEG_ADD(RT_JPEG_MUL(z4, -RT_JPEG_FIX_0_390180644), z5);
+  o0 = RT_JPEG_ADD(o0, RT_JPEG_ADD(z1, z3));
+  o1 = RT_JPEG_ADD(o1, RT_JPEG_ADD(z2, z4));
+  o2 = RT_JPEG_ADD(o2, RT_JPEG_ADD(z2, z3));
+  o3 = RT_JPEG_ADD(o3, RT_JPEG_ADD(z1, z4));
+  v[0] = RT_JPEG_ADD(e10, o3);
+  v[7] = RT_JPEG_SUB(e10, o3);
+  v[1] = RT_JPEG_ADD(e11, o2);
+  v[6] = RT_JPEG_SUB(e11, o2);
+  v[2] = RT_JPEG_ADD(e12, o1);
+  v[5] = RT_JPEG_SUB(e12, o1);
+  v[3] = RT_JPEG_ADD(e13, o0);
+  v[4] = RT_JPEG_SUB(e13, o0);
+}
+
+__attribute__((target("avx2"))) static inline void rt_jpeg_transpose_avx2(__m256i v[8]) {
+  __m256i a0 = _mm256_unpacklo_epi32(v[0], v[1]), a1 = _mm256_unpackhi_epi32(v[0], v[1]);
+  __m256i a2 = _mm256_unpacklo_epi32(v[2], v[3]), a3 = _mm256_unpackhi_epi32(v[2], v[3]);
+  __m256i a4 = _mm256_unpacklo_epi32(v[4], v[5]), a5 = _mm256_unpackhi_epi32(v[4], v[5]);
+  __m256i a6 = _mm256_unpacklo_epi32(v[6], v[7]), a7 = _mm256_unpackhi_epi32(v[6], v[7]);
+  __m256i b0 = _mm256_unpacklo_epi64(a0, a2), b1 = _mm256_unpackhi_epi64(a0, a2);
+  __m256i b2 = _mm256_unpacklo_epi64(a1, a3), b3 = _mm256_unpackhi_epi64(a1, a3);
+  __m256i b4 = _mm256_unpacklo_epi64(a4, a6), b5 = _mm256_unpackhi_epi64(a4, a6);
+  __m256i b6 = _mm256_unpacklo_epi64(a5, a7), b7 = _mm256_unpackhi_epi64(a5, a7);
+  v[0] = _mm256_permute2x128_si256(b0, b4, 0x20);
+  v[1] = _mm256_permute2x128_si256(b1, b5, 0x20);
+  v[2] = _mm256_permute2x128_si256(b2, b6, 0x20);
+  v[3] = _mm256_permute2x128_si256(b3, b7, 0x20);
+  v[4] = _mm256_permute2x128_si256(b0, b4, 0x31);
+  v[5] = _mm256_permute2x128_si256(b1, b5, 0x31);
+  v[6] = _mm256_permute2x128_si256(b2, b6, 0x31);
+  v[7] = _mm256_permute2x128_si256(b3, b7, 0x31);
+}
+
+__attribute__((target("avx2"))) static void rt_jpeg_idct_avx2(const int32_t *blk, uint8_t *dst,
+                                                              size_t stride) {
+  const int sh1 = RT_JPEG_CONST_BITS - RT_JPEG_PASS1_BITS;
+  const int sh2 = RT_JPEG_CONST_BITS + RT_JPEG_PASS1_BITS + 3;
+  const __m256i r1 = _mm256_set1_epi32(1 << (sh1 - 1));
+  const __m256i r2 = _mm256_set1_epi32((1 << (sh2 - 1)) + (128 << sh2));
+  __m256i v[8];
+  for (int r = 0; r < 8; r++)
+    v[r] = _mm256_loadu_si256((const __m256i *)(const void *)(blk + r * 8));
+  rt_jpeg_idct_avx2_1d(v);
+  for (int r = 0; r < 8; r++)
+    v[r] = _mm256_srai_epi32(_mm256_add_epi32(v[r], r1), sh1);
+  rt_jpeg_transpose_avx2(v);
+  rt_jpeg_idct_avx2_1d(v);
+  for (int r = 0; r < 8; r++)
+    v[r] = _mm256_srai_epi32(_mm256_add_epi32(v[r], r2), sh2);
+  rt_jpeg_transpose_avx2(v);
+  for (int r = 0; r < 8; r += 4) {
+    __m256i p01 = _mm256_permute4x64_epi64(_mm256_packs_epi32(v[r], v[r + 1]), 0xD8);
+    __m256i p23 = _mm256_permute4x64_epi64(_mm256_packs_epi32(v[r + 2], v[r + 3]), 0xD8);
+    __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(p01, p23), 0xD8);
+    __m128i lo = _mm256_castsi256_si128(b), hi = _mm256_extracti128_si256(b, 1);
+    _mm_storel_epi64((__m128i *)(void *)(dst + (size_t)r * stride), lo);
+    _mm_storel_epi64((__m128i *)(void *)(dst + (size_t)(r + 1) * stride), _mm_srli_si128(lo, 8));
+    _mm_storel_epi64((__m128i *)(void *)(dst + (size_t)(r + 2) * stride), hi);
+    _mm_storel_epi64((__m128i *)(void *)(dst + (size_t)(r + 3) * stride), _mm_srli_si128(hi, 8));
+  }
+}
+
+#undef RT_JPEG_ADD
+#undef RT_JPEG_SUB
+#undef RT_JPEG_MUL
+#undef RT_JPEG_SHL
+
+#elif defined(RT_JPEG_NEON)
+
+/* The islow 1-D IDCT over four lanes; v holds eight rows of half a block. */
+static inline void rt_jpeg_idct_neon_1d(int32x4_t v[8]) {
+  int32x4_t z1 = vmulq_n_s32(vaddq_s32(v[2], v[6]), RT_JPEG_FIX_0_541196100);
+  int32x4_t t2 = vmlsq_n_s32(z1, v[6], RT_JPEG_FIX_1_847759065);
+  int32x4_t t3 = vmlaq_n_s32(z1, v[2], RT_JPEG_FIX_0_765366865);
+  int32x4_t t0 = vshlq_n_s32(vaddq_s32(v[0], v[4]), RT_JPEG_CONST_BITS);
+  int32x4_t t1 = vshlq_n_s32(vsubq_s32(v[0], v[4]), RT_JPEG_CONST_BITS);
+  int32x4_t e10 = vaddq_s32(t0, t3), e13 = vsubq_s32(t0, t3);
+  int32x4_t e11 = vaddq_s32(t1, t2), e12 = vsubq_s32(t1, t2);
+  int32x4_t o0 = v[7], o1 = v[5], o2 = v[3], o3 = v[1];
+  z1 = vaddq_s32(o0, o3);
+  int32x4_t z2 = vaddq_s32(o1, o2), z3 = vaddq_s32(o0, o2), z4 = vaddq_s32(o1, o3);
+  int32x4_t z5 = vmulq_n_s32(vaddq_s32(z3, z4), RT_JPEG_FIX_1_175875602);
+  o0 = vmulq_n_s32(o0, RT_JPEG_FIX_0_298631336);
+  o1 = vmulq_n_s32(o1, RT_JPEG_FIX_2_053119869);
+  o2 = vmulq_n_s32(o2, RT_JPEG_FIX_3_072711026);
+  o3 = vmulq_n_s32(o3, RT_JPEG_FIX_1_501321110);
+  z1 = vmulq_n_s32(z1, -RT_JPEG_FIX_0_899976223);
+  z2 = vmulq_n_s32(z2, -RT_JPEG_FIX_2_562915447);
+  z3 = vmlaq_n_s32(z5, z3, -RT_JPEG_FIX_1_961570560);
+  z4 = vmlaq_n_s32(z5, z4, -RT_JPEG_FIX_0_390180644);
+  o0 = vaddq_s32(o0, vaddq_s32(z1, z3));
+  o1 = vaddq_s32(o1, vaddq_s32(z2, z4));
+  o2 = vaddq_s32(o2, vaddq_s32(z2, z3));
+  o3 = vaddq_s32(o3, vaddq_s32(z1, z4));
+  v[0] = vaddq_s32(e10, o3);
+  v[7] = vsubq_s32(e10, o3);
+  v[1] = vaddq_s32(e11, o2);
+  v[6] = vsubq_s32(e11, o2);
+  v[2] = vaddq_s32(e12, o1);
+  v[5] = vsubq_s32(e12, o1);
+  v[3] = vaddq_s32(e13, o0);
+  v[4] = vsubq_s32(e13, o0);
+}
+
+/* Column pass over both halves of the block, then the same over its
+   transpose; ws carries the transposes. */
+static void rt_jpeg_idct_neon(const int32_t *blk, uint8_t *dst, size_t stride) {
+  int32_t ws[64], out[64];
+  for (int half = 0; half < 2; half++) {
+    int32x4_t v[8];
+    for (int r = 0; r < 8; r++)
+      v[r] = vld1q_s32(blk + r * 8 + half * 4);
+    rt_jpeg_idct_neon_1d(v);
+    for (int r = 0; r < 8; r++) {
+      int32_t t[4];
+      vst1q_s32(t, vrshrq_n_s32(v[r], RT_JPEG_CONST_BITS - RT_JPEG_PASS1_BITS));
+      for (int c = 0; c < 4; c++)
+        ws[(half * 4 + c) * 8 + r] = t[c];
+    }
+  }
+  for (int half = 0; half < 2; half++) {
+    int32x4_t v[8];
+    for (int r = 0; r < 8; r++)
+      v[r] = vld1q_s32(ws + r * 8 + half * 4);
+    rt_jpeg_idct_neon_1d(v);
+    for (int k = 0; k < 8; k++) {
+      int32_t t[4];
+      int32x4_t x = vaddq_s32(vrshrq_n_s32(v[k], RT_JPEG_CONST_BITS + RT_JPEG_PASS1_BITS + 3),
+                              vdupq_n_s32(128));
+      vst1q_s32(t, x);
+      for (int c = 0; c < 4; c++)
+        out[(half * 4 + c) * 8 + k] = t[c];
+    }
+  }
+  for (int r = 0; r < 8; r++) {
+    int16x8_t s = vcombine_s16(vqmovn_s32(vld1q_s32(out + r * 8)), vqmovn_s32(vld1q_s32(out + r * 8 + 4)));
+    vst1_u8(dst + (size_t)r * stride, vqmovun_s16(s));
+  }
+}
+
+#endif
+
+typedef void (*rt_jpeg_idct_fn)(const int32_t *, uint8_t *, size_t);
+
+static rt_jpeg_idct_fn rt_jpeg_idct(void) {
+  static rt_jpeg_idct_fn fn = NULL;
+  if (fn)
+    return fn;
+  rt_jpeg_idct_fn pick = rt_jpeg_idct_scalar;
+#if defined(RT_JPEG_X86_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    pick = rt_jpeg_idct_avx2;
+#elif defined(RT_JPEG_NEON)
+  pick = rt_jpeg_idct_neon;
+#endif
+  if (getenv("NYTRIX_JPEG_SCALAR"))
+    pick = rt_jpeg_idct_scalar;
+  fn = pick;
+  return fn;
+}
+
+/* ---- Colour conversion --------------------------------------------------- */
+
+/* 14-bit fixed-point JFIF coefficients. */
+#define RT_JPEG_CR_R 22970
+#define RT_JPEG_CB_G 5638
+#define RT_JPEG_CR_G 11700
+#define RT_JPEG_CB_B 29032
+
+static void rt_jpeg_ycc_scalar(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                               uint8_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    int yy = y[i], b = cb[i] - 128, r = cr[i] - 128;
+    out[i * 4 + 0] = rt_jpeg_clamp(yy + ((RT_JPEG_CR_R * r + 8192) >> 14));
+    out[i * 4 + 1] = rt_jpeg_clamp(yy + ((-RT_JPEG_CB_G * b - RT_JPEG_CR_G * r + 8192) >> 14));
+    out[i * 4 + 2] = rt_jpeg_clamp(yy + ((RT_JPEG_CB_B * b + 8192) >> 14));
+    out[i * 4 + 3] = 255;
+  }
+}
+
+#if defined(RT_JPEG_SSE2)
+
+static void rt_jpeg_ycc_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *out,
+                            size_t n) {
+  const __m128i zero = _mm_setzero_si128(), c128 = _mm_set1_epi16(128);
+  const __m128i kr = _mm_set_epi16(RT_JPEG_CR_R, 0, RT_JPEG_CR_R, 0, RT_JPEG_CR_R, 0, RT_JPEG_CR_R, 0);
+  const __m128i kg = _mm_set_epi16(-RT_JPEG_CR_G, -RT_JPEG_CB_G, -RT_JPEG_CR_G, -RT_JPEG_CB_G,
+                                   -RT_JPEG_CR_G, -RT_JPEG_CB_G, -RT_JPEG_CR_G, -RT_JPEG_CB_G);
+  const __m128i kb = _mm_set_epi16(0, RT_JPEG_CB_B, 0, RT_JPEG_CB_B, 0, RT_JPEG_CB_B, 0, RT_JPEG_CB_B);
+  const __m128i rnd = _mm_set1_epi32(8192), alpha = _mm_set1_epi8((char)0xff);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i yv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(const void *)(y + i)), zero);
+    __m128i bv = _mm_sub_epi16(
+        _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(const void *)(cb + i)), zero), c128);
+    __m128i rv = _mm_sub_epi16(
+        _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(const void *)(cr + i)), zero), c128);
+    /* (cb, cr) pairs so one madd yields a whole term per pixel */
+    __m128i lo = _mm_unpacklo_epi16(bv, rv), hi = _mm_unpackhi_epi16(bv, rv);
+#define RT_JPEG_TERM(k)                                                                            \
+  _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(lo, k), rnd), 14),                  \
+                  _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(hi, k), rnd), 14))
+    __m128i r = _mm_add_epi16(yv, RT_JPEG_TERM(kr));
+    __m128i g = _mm_add_epi16(yv, RT_JPEG_TERM(kg));
+    __m128i b = _mm_add_epi16(yv, RT_JPEG_TERM(kb));
+#undef RT_JPEG_TERM
+    __m128i rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+    __m128i ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), alpha);
+    _mm_storeu_si128((__m128i *)(void *)(out + i * 4), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128((__m128i *)(void *)(out + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+  }
+  rt_jpeg_ycc_scalar(y + i, cb + i, cr + i, out + i * 4, n - i);
+}
+
+#elif defined(RT_JPEG_NEON)
+
+static void rt_jpeg_ycc_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *out,
+                            size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t yv = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i)));
+    int16x8_t bv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(cb + i))), vdupq_n_s16(128));
+    int16x8_t rv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(cr + i))), vdupq_n_s16(128));
+    int32x4_t rl = vmull_n_s16(vget_low_s16(rv), RT_JPEG_CR_R);
+    int32x4_t rh = vmull_n_s16(vget_high_s16(rv), RT_JPEG_CR_R);
+    int32x4_t gl = vmlal_n_s16(vmull_n_s16(vget_low_s16(bv), -RT_JPEG_CB_G), vget_low_s16(rv),
+                               -RT_JPEG_CR_G);
+    int32x4_t gh = vmlal_n_s16(vmull_n_s16(vget_high_s16(bv), -RT_JPEG_CB_G), vget_high_s16(rv),
+                               -RT_JPEG_CR_G);
+    int32x4_t bl = vmull_n_s16(vget_low_s16(bv), RT_JPEG_CB_B);
+    int32x4_t bh = vmull_n_s16(vget_high_s16(bv), RT_JPEG_CB_B);
+    uint8x8x4_t px;
+    px.val[0] = vqmovun_s16(vaddq_s16(yv, vcombine_s16(vrshrn_n_s32(rl, 14), vrshrn_n_s32(rh, 14))));
+    px.val[1] = vqmovun_s16(vaddq_s16(yv, vcombine_s16(vrshrn_n_s32(gl, 14), vrshrn_n_s32(gh, 14))));
+    px.val[2] = vqmovun_s16(vaddq_s16(yv, vcombine_s16(vrshrn_n_s32(bl, 14), vrshrn_n_s32(bh, 14))));
+    px.val[3] = vdup_n_u8(255);
+    vst4_u8(out + i * 4, px);
+  }
+  rt_jpeg_ycc_scalar(y + i, cb + i, cr + i, out + i * 4, n - i);
+}
+
+#else
+
+static void rt_jpeg_ycc_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *out,
+                            size_t n) {
+  rt_jpeg_ycc_scalar(y, cb, cr, out, n);
+}
+
+#endif
+
+/* ---- Headers ------------------------------------------------------------- */
+
+/* Parses up to the first SOS. Returns 1 when the scan is one this decoder
+   handles, 0 to decline and -1 for a malformed file. */
+static int rt_jpeg_parse(rt_jpeg_t *j) {
+  const uint8_t *d = j->data;
+  size_t n = j->len, p = 2;
+  bool sof = false;
+  while (p + 4 <= n) {
+    if (d[p] != 0xFF) {
+      p++;
+      continue;
+    }
+    int mark = d[p + 1];
+    if (mark == 0xFF) {
+      p++;
+      continue;
+    }
+    p += 2;
+    if (mark == 0xD8 || (mark >= 0xD0 && mark <= 0xD7) || mark == 0x01)
+      continue;
+    if (mark == 0xD9)
+      return -1;
+    size_t sl = ((size_t)d[p] << 8) | d[p + 1];
+    if (sl < 2 || p + sl > n)
+      return -1;
+    const uint8_t *s = d + p + 2;
+    size_t len = sl - 2;
+    switch (mark) {
+    case 0xC0:
+    case 0xC1: {
+      if (len < 6 || s[0] != 8)
+        return 0;
+      j->h = (s[1] << 8) | s[2];
+      j->w = (s[3] << 8) | s[4];
+      j->ncomp = s[5];
+      if (j->w <= 0 || j->h <= 0 || j->w > RT_JPEG_MAX_DIM || j->h > RT_JPEG_MAX_DIM)
+        return -1;
+      if ((j->ncomp != 1 && j->ncomp != 3) || len < 6 + (size_t)j->ncomp * 3)
+        return 0;
+      j->mh = j->mv = 1;
+      for (int c = 0; c < j->ncomp; c++) {
+        rt_jpeg_comp_t *k = &j->comp[c];
+        k->id = s[6 + c * 3];
+        k->hs = s[7 + c * 3] >> 4;
+        k->vs = s[7 + c * 3] & 15;
+        k->tq = s[8 + c * 3] & 3;
+        if (k->hs < 1 || k->hs > 4 || k->vs < 1 || k->vs > 4)
+          return -1;
+        j->mh = k->hs > j->mh ? k->hs : j->mh;
+        j->mv = k->vs > j->mv ? k->vs : j->mv;
+      }
+      if (j->ncomp == 1)
+        j->comp[0].hs = j->comp[0].vs = j->mh = j->mv = 1;
+      sof = true;
+      break;
+    }
+    case 0xC2:
+    case 0xC3:
+    case 0xC5:
+    case 0xC6:
+    case 0xC7:
+    case 0xC9:
+    case 0xCA:
+    case 0xCB:
+    case 0xCD:
+    case 0xCE:
+    case 0xCF:
+      return 0;
+    case 0xDB:
+      for (size_t o = 0; o < len;) {
+        int pq = s[o] >> 4, tq = s[o] & 3;
+        o++;
+        if (pq != 0 || o + 64 > len)
+          return pq ? 0 : -1;
+        for (int k = 0; k < 64; k++)
+          j->q[tq][k] = s[o + k];
+        o += 64;
+      }
+      break;
+    case 0xC4:
+      for (size_t o = 0; o < len;) {
+        if (o + 17 > len)
+          return -1;
+        int tc = s[o] >> 4, th = s[o] & 3;
+        int total = 0;
+        for (int k = 0; k < 16; k++)
+          total += s[o + 1 + k];
+        if (tc > 1 || total > 256 || o + 17 + (size_t)total > len)
+          return -1;
+        if (!rt_jpeg_huff_build(tc ? &j->ac[th] : &j->dc[th], s + o + 1, s + o + 17, total))
+          return -1;
+        o += 17 + (size_t)total;
+      }
+      break;
+    case 0xDD:
+      if (len >= 2)
+        j->ri = (s[0] << 8) | s[1];
+      break;
+    case 0xDA: {
+      if (!sof || len < 1)
+        return -1;
+      int ns = s[0];
+      if (ns != j->ncomp || len < 1 + (size_t)ns * 2 + 3)
+        return 0;
+      for (int i = 0; i < ns; i++) {
+        rt_jpeg_comp_t *k = &j->comp[i];
+        if (k->id != s[1 + i * 2])
+          return 0;
+        k->td = s[2 + i * 2] >> 4 & 3;
+        k->ta = s[2 + i * 2] & 3;
+        if (!j->dc[k->td].present || !j->ac[k->ta].present)
+          return -1;
+      }
+      j->scan = p + sl;
+      return 1;
+    }
+    default:
+      break;
+    }
+    p += sl;
+  }
+  return -1;
+}
+
+/* ---- Scan decoding ------------------------------------------------------- */
+
+typedef struct {
+  size_t start; /* first entropy byte of the segment */
+  size_t mcu;   /* first MCU */
+} rt_jpeg_seg_t;
+
+typedef struct {
+  rt_jpeg_t *j;
+  const rt_jpeg_seg_t *segs;
+  size_t nseg, total_seg;
+  size_t total_mcu;
+  size_t row0, row1; /* output rows for the colour pass */
+  uint8_t *out;
+  size_t ow, oh;
+  int phase;
+  bool ok;
+} rt_jpeg_task_t;
+
+static bool rt_jpeg_decode_segment(rt_jpeg_t *j, size_t start, size_t end, size_t mcu0,
+                                   size_t mcu1) {
+  rt_jpeg_bits_t b = {j->data + start, j->data + end, 0, 0, false};
+  int pred[3] = {0, 0, 0};
+  int32_t blk[64] __attribute__((aligned(32)));
+  rt_jpeg_idct_fn idct = rt_jpeg_idct();
+  const int bsz = j->bsz;
+  for (size_t m = mcu0; m < mcu1; m++) {
+    size_t mx = m % j->mcux, my = m / j->mcux;
+    for (int c = 0; c < j->ncomp; c++) {
+      rt_jpeg_comp_t *k = &j->comp[c];
+      const uint16_t *q = j->q[k->tq];
+      for (int vb = 0; vb < k->vs; vb++) {
+        for (int hb = 0; hb < k->hs; hb++) {
+          int any = rt_jpeg_block(&b, &j->dc[k->td], &j->ac[k->ta], q, &pred[c], bsz == 8 ? blk : NULL);
+          if (any < 0)
+            return false;
+          size_t bx = mx * (size_t)k->hs + (size_t)hb, by = my * (size_t)k->vs + (size_t)vb;
+          uint8_t *dst = k->plane + by * (size_t)bsz * k->pw + bx * (size_t)bsz;
+          if (bsz == 1) {
+            *dst = rt_jpeg_clamp(((pred[c] * q[0] + 4) >> 3) + 128);
+          } else if (!any) {
+            uint8_t v = rt_jpeg_clamp(((blk[0] + 4) >> 3) + 128);
+            for (int r = 0; r < 8; r++)
+              memset(dst + (size_t)r * k->pw, v, 8);
+          } else {
+            idct(blk, dst, k->pw);
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static void rt_jpeg_colour_rows(rt_jpeg_t *j, uint8_t *out, size_t ow, size_t y0, size_t y1) {
+  const rt_jpeg_comp_t *ky = &j->comp[0];
+  if (j->ncomp == 1) {
+    for (size_t y = y0; y < y1; y++) {
+      const uint8_t *s = ky->plane + y * ky->pw;
+      uint8_t *d = out + y * ow * 4;
+      for (size_t x = 0; x < ow; x++) {
+        uint32_t v = s[x] * 0x010101u | 0xff000000u;
+        memcpy(d + x * 4, &v, 4);
+      }
+    }
+    return;
+  }
+  /* Any component, luma included, may be sampled below the frame maxima;
+     such rows are widened to ow samples before conversion. */
+  uint8_t *tmp = malloc(ow * 3 + 16);
+  if (!tmp)
+    return;
+  uint8_t *up[3] = {tmp, tmp + ow, tmp + ow * 2};
+  for (size_t y = y0; y < y1; y++) {
+    const uint8_t *row[3];
+    for (int c = 0; c < 3; c++) {
+      const rt_jpeg_comp_t *k = &j->comp[c];
+      const uint8_t *s = k->plane + (y * (size_t)k->vs / (size_t)j->mv) * k->pw;
+      if (k->hs == j->mh) {
+        row[c] = s;
+        continue;
+      }
+      uint8_t *u = up[c];
+      if (j->mh == 2 * k->hs) {
+        for (size_t x = 0; x < ow; x++)
+          u[x] = s[x >> 1];
+      } else {
+        for (size_t x = 0; x < ow; x++)
+          u[x] = s[x * (size_t)k->hs / (size_t)j->mh];
+      }
+      row[c] = u;
+    }
+    rt_jpeg_ycc_row(row[0], row[1], row[2], out + y * ow * 4, ow);
+  }
+  free(tmp);
+}
+
+static void rt_jpeg_task_run(void *arg) {
+  rt_jpeg_task_t *t = (rt_jpeg_task_t *)arg;
+  rt_jpeg_t *j = t->j;
+  if (t->phase == 1) {
+    rt_jpeg_colour_rows(j, t->out, t->ow, t->row0, t->row1);
+    return;
+  }
+  for (size_t i = 0; i < t->nseg; i++) {
+    const rt_jpeg_seg_t *s = &t->segs[i];
+    size_t next_mcu = s->mcu + (j->ri ? (size_t)j->ri : t->total_mcu);
+    if (next_mcu > t->total_mcu)
+      next_mcu = t->total_mcu;
+    if (!rt_jpeg_decode_segment(j, s->start, j->len, s->mcu, next_mcu))
+      t->ok = false;
+  }
+}
+
+/* Finds the restart segments of the scan; the last one runs to EOI. */
+static size_t rt_jpeg_segments(const rt_jpeg_t *j, rt_jpeg_seg_t *segs, size_t max) {
+  size_t n = 0, p = j->scan;
+  segs[n].start = p;
+  segs[n++].mcu = 0;
+  if (!j->ri)
+    return n;
+  const uint8_t *d = j->data;
+  while (n < max) {
+    const uint8_t *f = memchr(d + p, 0xFF, j->len - p);
+    if (!f || (size_t)(f - d) + 1 >= j->len)
+      break;
+    p = (size_t)(f - d) + 1;
+    uint8_t m = d[p];
+    if (m == 0x00 || m == 0xFF)
+      continue;
+    if (m < 0xD0 || m > 0xD7)
+      break;
+    p++;
+    segs[n].start = p;
+    segs[n].mcu = n * (size_t)j->ri;
+    n++;
+  }
+  return n;
+}
+
+/* Decodes a baseline JPEG; scale 8 keeps DC only. Returns [pixels, w, h],
+   or 0 when the file is not one this decoder handles. */
+int64_t rt_jpeg_decode(int64_t data_v, int64_t scale_v) {
+  if (!is_v_str(data_v))
+    return 0;
+  rt_jpeg_t j;
+  memset(&j, 0, sizeof(j));
+  j.data = (const uint8_t *)(uintptr_t)data_v;
+  j.len = rt_tagged_str_len(data_v);
+  j.bsz = rt_untag_v(scale_v) == 8 ? 1 : 8;
+  if (j.len < 4 || j.data[0] != 0xFF || j.data[1] != 0xD8 || rt_jpeg_parse(&j) != 1)
+    return 0;
+  j.mcux = ((size_t)j.w + 8 * (size_t)j.mh - 1) / (8 * (size_t)j.mh);
+  j.mcuy = ((size_t)j.h + 8 * (size_t)j.mv - 1) / (8 * (size_t)j.mv);
+  size_t total_mcu = j.mcux * j.mcuy;
+  bool ok = true;
+  for (int c = 0; c < j.ncomp && ok; c++) {
+    rt_jpeg_comp_t *k = &j.comp[c];
+    k->pw = j.mcux * (size_t)k->hs * (size_t)j.bsz;
+    k->ph = j.mcuy * (size_t)k->vs * (size_t)j.bsz;
+    k->plane = malloc(k->pw * k->ph);
+    ok = k->plane != NULL;
+    if (ok)
+      memset(k->plane, 128, k->pw * k->ph);
+  }
+  size_t max_seg = j.ri ? (total_mcu + (size_t)j.ri - 1) / (size_t)j.ri : 1;
+  rt_jpeg_seg_t *segs = ok ? malloc(max_seg * sizeof(*segs)) : NULL;
+  int64_t res = 0;
+  if (segs) {
+    size_t nseg = rt_jpeg_segments(&j, segs, max_seg);
+    int threads = rt_jpeg_thread_count();
+    if ((size_t)threads > nseg)
+      threads = (int)nseg;
+    if (threads < 1)
+      threads = 1;
+    rt_jpeg_task_t tasks[RT_JPEG_MAX_THREADS];
+    memset(tasks, 0, sizeof(tasks));
+    for (int i = 0; i < threads; i++) {
+      size_t s0 = nseg * (size_t)i / (size_t)threads, s1 = nseg * (size_t)(i + 1) / (size_t)threads;
+      tasks[i].j = &j;
+      tasks[i].segs = segs + s0;
+      tasks[i].nseg = s1 - s0;
+      tasks[i].total_mcu = total_mcu;
+      tasks[i].ok = true;
+    }
+    rt_parallel_run(rt_jpeg_task_run, tasks, sizeof(tasks[0]), threads);
+    bool decoded = true;
+    for (int i = 0; i < threads; i++)
+      decoded = decoded && tasks[i].ok;
+    size_t ow = j.bsz == 8 ? (size_t)j.w : ((size_t)j.w + 7) / 8;
+    size_t oh = j.bsz == 8 ? (size_t)j.h : ((size_t)j.h + 7) / 8;
+    int64_t pix = decoded ? rt_malloc((int64_t)(((uint64_t)(ow * oh * 4) + 1u) << 1) | 1) : 0;
+    if (pix) {
+      uint8_t *out = (uint8_t *)(uintptr_t)pix;
+      int ct = rt_jpeg_thread_count();
+      if ((size_t)ct > oh / 16 + 1)
+        ct = (int)(oh / 16 + 1);
+      for (int i = 0; i < ct; i++) {
+        tasks[i].phase = 1;
+        tasks[i].j = &j;
+        tasks[i].out = out;
+        tasks[i].ow = ow;
+        tasks[i].row0 = oh * (size_t)i / (size_t)ct;
+        tasks[i].row1 = oh * (size_t)(i + 1) / (size_t)ct;
+      }
+      rt_parallel_run(rt_jpeg_task_run, tasks, sizeof(tasks[0]), ct);
+      *(int64_t *)((char *)(uintptr_t)pix - 8) = TAG_STR;
+      *(int64_t *)((char *)(uintptr_t)pix - 16) = ((int64_t)(ow * oh * 4) << 1) | 1;
+      out[ow * oh * 4] = '\0';
+      res = rt_list_new(rt_tag_v(3));
+      if (res) {
+        res = rt_append(res, pix);
+        res = rt_append(res, rt_tag_v((int64_t)ow));
+        res = rt_append(res, rt_tag_v((int64_t)oh));
+      }
+    }
+  }
+  free(segs);
+  for (int c = 0; c < j.ncomp; c++)
+    free(j.comp[c].plane);
+  return res;
+}
@@ -0,0 +1,1189 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Two-stage JSON decoder for std.math.parse.data.json.
+ *
+ * Stage 1 classifies the input 64 bytes at a time (AVX2, SSE2 or NEON where
+ * available) into quote, backslash, operator, whitespace and control masks,
+ * resolves escaped quotes and string spans with carry-less bit tricks, and
+ * flattens the positions of every structural character, every quote and the
+ * first byte of every bare scalar into an index. Stage 2 walks that index
+ * with an explicit stack and writes a tape: containers record their end and
+ * element count, strings point back into the input, numbers are stored
+ * decoded. Values are only materialized as Nytrix objects when asked for, so
+ * a field lookup on a large document never builds the rest of it.
+ *
+ * A stream reads newline-delimited JSON from a string or a file through a
+ * fixed window: stage 1 runs once per window, stage 2 once per document, and
+ * a malformed line is skipped after re-indexing from the next newline.
+ */
+
+extern int64_t rt_list_new(int64_t n);
+
+#define RT_JSON_MAGIC UINT64_C(0x4e594a534f4e4443)
+#define RT_JSON_PAD 64
+#define RT_JSON_MAX_DEPTH 1024
+#define RT_JSON_WINDOW ((size_t)1 << 20)
+#define RT_JSON_MAX_LEN ((size_t)UINT32_MAX - RT_JSON_PAD)
+#define RT_JSON_NO_POS SIZE_MAX
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) &&           \
+    (defined(__GNUC__) || defined(__clang__))
+#define RT_JSON_X86_DISPATCH 1
+#endif
+
+/* Tape word: kind in the top byte, payload below. Kinds are also the codes
+   __json_node_kind reports. */
+enum {
+  RT_JSON_NULL = 0,
+  RT_JSON_FALSE = 1,
+  RT_JSON_TRUE = 2,
+  RT_JSON_INT = 3,
+  RT_JSON_FLOAT = 4,
+  RT_JSON_STR = 5,
+  RT_JSON_ARR = 6,
+  RT_JSON_OBJ = 7,
+  RT_JSON_END = 8,
+};
+
+#define RT_JSON_WORD(kind, payload) (((uint64_t)(kind) << 56) | (uint64_t)(payload))
+#define RT_JSON_KIND(w) ((int)((w) >> 56))
+#define RT_JSON_PAYLOAD(w) ((w) & ((UINT64_C(1) << 56) - 1))
+#define RT_JSON_STR_ESC (UINT64_C(1) << 63)
+
+enum { RT_JSON_Q, RT_JSON_BS, RT_JSON_OP, RT_JSON_WS, RT_JSON_CTRL, RT_JSON_NCLASS };
+
+typedef struct rt_json_doc {
+  uint64_t magic;
+  char *buf; /* input copy, followed by RT_JSON_PAD spaces */
+  size_t len;
+  size_t cap;
+  uint32_t *idx;
+  size_t nidx;
+  size_t idx_cap;
+  size_t cursor; /* next index entry a stream document starts at */
+  uint64_t *tape;
+  size_t ntape;
+  size_t tape_cap;
+  size_t ctrl_pos; /* first control byte inside a string, from stage 1 */
+  const char *err;
+  size_t err_pos;
+  /* Streaming */
+  bool stream;
+  bool eof;
+  const char *src;
+  size_t src_len;
+  size_t src_pos;
+  FILE *fp;
+  char *tail; /* input read past the last newline of the window */
+  size_t tail_len;
+  size_t tail_cap;
+  int64_t errors;
+  int64_t docs;
+} rt_json_doc_t;
+
+static rt_json_doc_t *rt_json_handle(int64_t v) {
+  if (!is_ptr(v))
+    return NULL;
+  uintptr_t p = (uintptr_t)v;
+  if (!rt_addr_readable_safe(p, sizeof(uint64_t)))
+    return NULL;
+  rt_json_doc_t *d = (rt_json_doc_t *)p;
+  return d->magic == RT_JSON_MAGIC ? d : NULL;
+}
+
+static inline int64_t rt_json_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static int64_t rt_json_list(int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (lst)
+    *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+static inline void rt_json_list_set(int64_t lst, int64_t i, int64_t v) {
+  *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = v;
+}
+
+static int64_t rt_json_dict(int64_t count) {
+  int64_t cap = 8;
+  while (cap < count * 2)
+    cap *= 2;
+  int64_t d = rt_malloc(16 + cap * 24);
+  if (!d)
+    return 0;
+  *(int64_t *)((char *)(uintptr_t)d - 8) = TAG_DICT;
+  *(int64_t *)((char *)(uintptr_t)d + 0) = rt_tag_v(0);
+  *(int64_t *)((char *)(uintptr_t)d + 8) = rt_tag_v(cap);
+  return d;
+}
+
+static bool rt_json_fail(rt_json_doc_t *d, const char *msg, size_t pos) {
+  if (!d->err) {
+    d->err = msg;
+    d->err_pos = pos;
+  }
+  return false;
+}
+
+/* ---- Stage 1: structural index ----------------------------------------- */
+
+static void rt_json_classify_scalar(const uint8_t *p, uint64_t m[RT_JSON_NCLASS]) {
+  uint64_t q = 0, bs = 0, op = 0, ws = 0, ctrl = 0;
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = UINT64_C(1) << i;
+    uint8_t c = p[i];
+    if (c == '"')
+      q |= bit;
+    else if (c == '\\')
+      bs |= bit;
+    else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+      op |= bit;
+    else if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+      ws |= bit;
+    if (c < 0x20)
+      ctrl |= bit;
+  }
+  m[RT_JSON_Q] = q;
+  m[RT_JSON_BS] = bs;
+  m[RT_JSON_OP] = op;
+  m[RT_JSON_WS] = ws;
+  m[RT_JSON_CTRL] = ctrl;
+}
+
+#if defined(RT_JSON_X86_DISPATCH)
+__attribute__((target("avx2"))) static void rt_json_classify_avx2(const uint8_t *p,
+                                                                  uint64_t m[RT_JSON_NCLASS]) {
+  const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+  const __m256i brace = _mm256_set1_epi8(0x7b), close = _mm256_set1_epi8(0x7d);
+  const __m256i colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+  const __m256i sp = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+  const __m256i nl = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+  const __m256i low = _mm256_set1_epi8(0x20), ctl = _mm256_set1_epi8(0x1f);
+  uint64_t out[RT_JSON_NCLASS] = {0};
+  for (int h = 0; h < 2; h++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + h * 32));
+    /* '[' | 0x20 == '{' and ']' | 0x20 == '}': two compares cover all brackets. */
+    __m256i v20 = _mm256_or_si256(v, low);
+    __m256i op = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v20, brace), _mm256_cmpeq_epi8(v20, close)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+    __m256i ws =
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cr)));
+    __m256i cc = _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctl), v);
+    int sh = h * 32;
+    out[RT_JSON_Q] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << sh;
+    out[RT_JSON_BS] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bslash)) << sh;
+    out[RT_JSON_OP] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << sh;
+    out[RT_JSON_WS] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << sh;
+    out[RT_JSON_CTRL] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(cc) << sh;
+  }
+  memcpy(m, out, sizeof(out));
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+static void rt_json_classify_sse2(const uint8_t *p, uint64_t m[RT_JSON_NCLASS]) {
+  const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\');
+  const __m128i brace = _mm_set1_epi8(0x7b), close = _mm_set1_epi8(0x7d);
+  const __m128i colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(',');
+  const __m128i sp = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+  const __m128i nl = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+  const __m128i low = _mm_set1_epi8(0x20), ctl = _mm_set1_epi8(0x1f);
+  uint64_t out[RT_JSON_NCLASS] = {0};
+  for (int h = 0; h < 4; h++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + h * 16));
+    __m128i v20 = _mm_or_si128(v, low);
+    __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v20, brace), _mm_cmpeq_epi8(v20, close)),
+                              _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+    __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+                              _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+    __m128i cc = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v);
+    int sh = h * 16;
+    out[RT_JSON_Q] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << sh;
+    out[RT_JSON_BS] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, bslash)) << sh;
+    out[RT_JSON_OP] |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << sh;
+    out[RT_JSON_WS] |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws) << sh;
+    out[RT_JSON_CTRL] |= (uint64_t)(uint16_t)_mm_movemask_epi8(cc) << sh;
+  }
+  memcpy(m, out, sizeof(out));
+}
+#endif
+#elif defined(__aarch64__)
+static inline uint64_t rt_json_neon_mask(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+  const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t s0 = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+  uint8x16_t s1 = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+  s0 = vpaddq_u8(s0, s1);
+  s0 = vpaddq_u8(s0, s0);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+
+static void rt_json_classify_neon(const uint8_t *p, uint64_t m[RT_JSON_NCLASS]) {
+  uint8x16_t v[4], q[4], bs[4], op[4], ws[4], cc[4];
+  for (int h = 0; h < 4; h++) {
+    v[h] = vld1q_u8(p + h * 16);
+    uint8x16_t v20 = vorrq_u8(v[h], vdupq_n_u8(0x20));
+    q[h] = vceqq_u8(v[h], vdupq_n_u8('"'));
+    bs[h] = vceqq_u8(v[h], vdupq_n_u8('\\'));
+    op[h] = vorrq_u8(vorrq_u8(vceqq_u8(v20, vdupq_n_u8(0x7b)), vceqq_u8(v20, vdupq_n_u8(0x7d))),
+                     vorrq_u8(vceqq_u8(v[h], vdupq_n_u8(':')), vceqq_u8(v[h], vdupq_n_u8(','))));
+    ws[h] = vorrq_u8(vorrq_u8(vceqq_u8(v[h], vdupq_n_u8(' ')), vceqq_u8(v[h], vdupq_n_u8('\t'))),
+                     vorrq_u8(vceqq_u8(v[h], vdupq_n_u8('\n')), vceqq_u8(v[h], vdupq_n_u8('\r'))));
+    cc[h] = vcltq_u8(v[h], vdupq_n_u8(0x20));
+  }
+  m[RT_JSON_Q] = rt_json_neon_mask(q[0], q[1], q[2], q[3]);
+  m[RT_JSON_BS] = rt_json_neon_mask(bs[0], bs[1], bs[2], bs[3]);
+  m[RT_JSON_OP] = rt_json_neon_mask(op[0], op[1], op[2], op[3]);
+  m[RT_JSON_WS] = rt_json_neon_mask(ws[0], ws[1], ws[2], ws[3]);
+  m[RT_JSON_CTRL] = rt_json_neon_mask(cc[0], cc[1], cc[2], cc[3]);
+}
+#endif
+
+typedef void (*rt_json_classify_fn)(const uint8_t *, uint64_t *);
+
+static rt_json_classify_fn rt_json_classifier(void) {
+  static rt_json_classify_fn fn = NULL;
+  if (fn)
+    return fn;
+  rt_json_classify_fn pick = rt_json_classify_scalar;
+#if defined(RT_JSON_X86_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    pick = rt_json_classify_avx2;
+#if defined(__SSE2__) || defined(_M_X64)
+  else
+    pick = rt_json_classify_sse2;
+#endif
+#elif defined(__aarch64__)
+  pick = rt_json_classify_neon;
+#endif
+  if (getenv("NYTRIX_JSON_SCALAR"))
+    pick = rt_json_classify_scalar;
+  fn = pick;
+  return fn;
+}
+
+static inline uint64_t rt_json_prefix_xor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/* Bytes that end an odd-length run of backslashes, i.e. escaped bytes.
+   *carry is 1 when the block ended inside a run that started at odd parity. */
+static inline uint64_t rt_json_escaped(uint64_t bs, uint64_t *carry) {
+  const uint64_t even = UINT64_C(0x5555555555555555), odd = ~even;
+  uint64_t edges = bs & ~(bs << 1);
+  uint64_t even_start_mask = even ^ *carry;
+  uint64_t even_starts = edges & even_start_mask;
+  uint64_t odd_starts = edges & ~even_start_mask;
+  uint64_t even_carries = bs + even_starts;
+  uint64_t odd_carries = bs + odd_starts;
+  uint64_t ends_odd = odd_carries < bs ? 1 : 0;
+  odd_carries |= *carry;
+  *carry = ends_odd;
+  uint64_t even_ends = even_carries & ~bs;
+  uint64_t odd_ends = odd_carries & ~bs;
+  return (even_ends & odd) | (odd_ends & even);
+}
+
+static bool rt_json_reserve(void **p, size_t *cap, size_t want, size_t elem) {
+  if (want <= *cap)
+    return true;
+  size_t nc = *cap ? *cap : 256;
+  while (nc < want)
+    nc *= 2;
+  void *np = realloc(*p, nc * elem);
+  if (!np)
+    return false;
+  *p = np;
+  *cap = nc;
+  return true;
+}
+
+/* Indexes buf[start, len); buf must carry RT_JSON_PAD bytes of spaces past len. */
+static bool rt_json_index(rt_json_doc_t *d, size_t start) {
+  rt_json_classify_fn classify = rt_json_classifier();
+  const uint8_t *buf = (const uint8_t *)d->buf;
+  uint64_t in_prev = 0, esc_carry = 0, sc_prev = 0;
+  d->nidx = 0;
+  d->cursor = 0;
+  d->ctrl_pos = RT_JSON_NO_POS;
+  for (size_t b = start; b < d->len; b += 64) {
+    if (!rt_json_reserve((void **)&d->idx, &d->idx_cap, d->nidx + 64, sizeof(uint32_t)))
+      return rt_json_fail(d, "out of memory", b);
+    uint64_t m[RT_JSON_NCLASS];
+    classify(buf + b, m);
+    uint64_t escaped = (m[RT_JSON_BS] | esc_carry) ? rt_json_escaped(m[RT_JSON_BS], &esc_carry) : 0;
+    uint64_t quote = m[RT_JSON_Q] & ~escaped;
+    uint64_t in_str = rt_json_prefix_xor(quote) ^ in_prev;
+    in_prev = (uint64_t)((int64_t)in_str >> 63);
+    uint64_t bad = m[RT_JSON_CTRL] & in_str;
+    if (bad && d->ctrl_pos == RT_JSON_NO_POS)
+      d->ctrl_pos = b + (size_t)__builtin_ctzll(bad);
+    uint64_t scalar = ~(m[RT_JSON_OP] | m[RT_JSON_WS] | m[RT_JSON_Q]);
+    uint64_t scalar_start = scalar & ~((scalar << 1) | sc_prev);
+    sc_prev = scalar >> 63;
+    uint64_t s = ((m[RT_JSON_OP] | scalar_start) & ~in_str) | quote;
+    if (b + 64 > d->len)
+      s &= (UINT64_C(1) << (d->len - b)) - 1;
+    uint32_t *out = d->idx + d->nidx;
+    size_t n = 0;
+    while (s) {
+      out[n++] = (uint32_t)(b + (size_t)__builtin_ctzll(s));
+      s &= s - 1;
+    }
+    d->nidx += n;
+  }
+  return true;
+}
+
+/* ---- Stage 2: tape ------------------------------------------------------ */
+
+static inline bool rt_json_is_ws(uint8_t c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+static inline bool rt_json_is_term(uint8_t c) {
+  return rt_json_is_ws(c) || c == ',' || c == ':' || c == '}' || c == ']' || c == '{' ||
+         c == '[' || c == '"';
+}
+
+static inline int rt_json_hex(uint8_t c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+static int32_t rt_json_hex4(const uint8_t *p) {
+  int32_t v = 0;
+  for (int i = 0; i < 4; i++) {
+    int h = rt_json_hex(p[i]);
+    if (h < 0)
+      return -1;
+    v = v * 16 + h;
+  }
+  return v;
+}
+
+/* Decodes the escapes of s[0, n) into out (which may be NULL to only validate).
+   Returns the decoded length, or -1 with *bad set to the failing offset. */
+static int64_t rt_json_unescape(const uint8_t *s, size_t n, char *out, const char **msg,
+                                size_t *bad) {
+  size_t o = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint8_t c = s[i];
+    if (c != '\\') {
+      if (out)
+        out[o] = (char)c;
+      o++;
+      continue;
+    }
+    *bad = i;
+    if (++i >= n) {
+      *msg = "unterminated escape sequence";
+      return -1;
+    }
+    uint8_t e = s[i];
+    char r = 0;
+    switch (e) {
+    case '"':
+      r = '"';
+      break;
+    case '\\':
+      r = '\\';
+      break;
+    case '/':
+      r = '/';
+      break;
+    case 'b':
+      r = '\b';
+      break;
+    case 'f':
+      r = '\f';
+      break;
+    case 'n':
+      r = '\n';
+      break;
+    case 'r':
+      r = '\r';
+      break;
+    case 't':
+      r = '\t';
+      break;
+    case 'u': {
+      if (i + 4 >= n) {
+        *msg = "invalid unicode escape";
+        return -1;
+      }
+      int32_t cp = rt_json_hex4(s + i + 1);
+      if (cp < 0) {
+        *msg = "invalid unicode escape";
+        return -1;
+      }
+      i += 4;
+      if (cp >= 0xD800 && cp <= 0xDBFF) {
+        if (i + 6 >= n || s[i + 1] != '\\' || s[i + 2] != 'u') {
+          *msg = "invalid unicode surrogate pair";
+          return -1;
+        }
+        int32_t lo = rt_json_hex4(s + i + 3);
+        if (lo < 0xDC00 || lo > 0xDFFF) {
+          *msg = "invalid unicode surrogate pair";
+          return -1;
+        }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        i += 6;
+      } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        *msg = "invalid unicode surrogate pair";
+        return -1;
+      }
+      uint8_t u[4];
+      int k;
+      if (cp < 0x80) {
+        u[0] = (uint8_t)cp;
+        k = 1;
+      } else if (cp < 0x800) {
+        u[0] = (uint8_t)(0xC0 | (cp >> 6));
+        u[1] = (uint8_t)(0x80 | (cp & 63));
+        k = 2;
+      } else if (cp < 0x10000) {
+        u[0] = (uint8_t)(0xE0 | (cp >> 12));
+        u[1] = (uint8_t)(0x80 | ((cp >> 6) & 63));
+        u[2] = (uint8_t)(0x80 | (cp & 63));
+        k = 3;
+      } else {
+        u[0] = (uint8_t)(0xF0 | (cp >> 18));
+        u[1] = (uint8_t)(0x80 | ((cp >> 12) & 63));
+        u[2] = (uint8_t)(0x80 | ((cp >> 6) & 63));
+        u[3] = (uint8_t)(0x80 | (cp & 63));
+        k = 4;
+      }
+      if (out)
+        memcpy(out + o, u, (size_t)k);
+      o += (size_t)k;
+      continue;
+    }
+    default:
+      *msg = "invalid escape sequence";
+      return -1;
+    }
+    if (out)
+      out[o] = r;
+    o++;
+  }
+  return (int64_t)o;
+}
+
+static const double rt_json_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                       1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                       1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* Parses the number at s[p]; returns RT_JSON_INT / RT_JSON_FLOAT, or -1. */
+static int rt_json_number(rt_json_doc_t *d, size_t p, size_t *end, uint64_t *out) {
+  const uint8_t *s = (const uint8_t *)d->buf;
+  size_t i = p;
+  bool neg = s[i] == '-';
+  if (neg)
+    i++;
+  size_t digits_at = i;
+  uint64_t mant = 0;
+  if (s[i] == '0') {
+    i++;
+    if (s[i] >= '0' && s[i] <= '9')
+      return rt_json_fail(d, "leading zero in number", i), -1;
+  } else if (s[i] >= '1' && s[i] <= '9') {
+    while (s[i] >= '0' && s[i] <= '9') {
+      mant = mant * 10 + (uint64_t)(s[i] - '0');
+      i++;
+    }
+  } else {
+    return rt_json_fail(d, "invalid number", i), -1;
+  }
+  size_t int_digits = i - digits_at;
+  int64_t exp10 = 0;
+  size_t frac_digits = 0;
+  bool is_float = false;
+  if (s[i] == '.') {
+    is_float = true;
+    i++;
+    if (!(s[i] >= '0' && s[i] <= '9'))
+      return rt_json_fail(d, "invalid fraction in number", i), -1;
+    while (s[i] >= '0' && s[i] <= '9') {
+      mant = mant * 10 + (uint64_t)(s[i] - '0');
+      frac_digits++;
+      i++;
+    }
+    exp10 = -(int64_t)frac_digits;
+  }
+  if (s[i] == 'e' || s[i] == 'E') {
+    is_float = true;
+    i++;
+    bool eneg = false;
+    if (s[i] == '+' || s[i] == '-')
+      eneg = s[i++] == '-';
+    if (!(s[i] >= '0' && s[i] <= '9'))
+      return rt_json_fail(d, "invalid exponent in number", i), -1;
+    int64_t e = 0;
+    while (s[i] >= '0' && s[i] <= '9') {
+      if (e < 100000)
+        e = e * 10 + (s[i] - '0');
+      i++;
+    }
+    exp10 += eneg ? -e : e;
+  }
+  *end = i;
+  size_t sig = int_digits + frac_digits;
+  /* Nytrix ints carry 63 bits; wider literals become floats. Up to 19 digits
+     the accumulator cannot have wrapped. */
+  uint64_t lim = neg ? (UINT64_C(1) << 62) : (UINT64_C(1) << 62) - 1;
+  if (!is_float && sig <= 19 && mant <= lim) {
+    int64_t v = neg ? -(int64_t)mant : (int64_t)mant;
+    memcpy(out, &v, sizeof(v));
+    return RT_JSON_INT;
+  }
+  double v;
+  if (sig <= 15 && exp10 >= -22 && exp10 <= 22) {
+    /* Clinger's fast path: both operands are exact doubles. */
+    v = (double)mant;
+    v = exp10 < 0 ? v / rt_json_pow10[-exp10] : v * rt_json_pow10[exp10];
+    if (neg)
+      v = -v;
+  } else {
+    char small[64];
+    size_t n = i - p;
+    char *tmp = n < sizeof(small) ? small : (char *)malloc(n + 1);
+    if (!tmp)
+      return rt_json_fail(d, "number allocation failed", p), -1;
+    memcpy(tmp, s + p, n);
+    tmp[n] = '\0';
+    v = strtod(tmp, NULL);
+    if (tmp != small)
+      free(tmp);
+  }
+  memcpy(out, &v, sizeof(v));
+  return RT_JSON_FLOAT;
+}
+
+static inline void rt_json_emit(rt_json_doc_t *d, uint64_t w) { d->tape[d->ntape++] = w; }
+
+static bool rt_json_string(rt_json_doc_t *d, size_t open, size_t *cur) {
+  if (*cur >= d->nidx)
+    return rt_json_fail(d, "unterminated string", d->len);
+  size_t close = d->idx[(*cur)++];
+  if (d->ctrl_pos != RT_JSON_NO_POS && d->ctrl_pos > open && d->ctrl_pos < close)
+    return rt_json_fail(d, "invalid control character in string", d->ctrl_pos);
+  const uint8_t *body = (const uint8_t *)d->buf + open + 1;
+  size_t n = close - open - 1;
+  uint64_t esc = 0;
+  if (memchr(body, '\\', n)) {
+    const char *msg = NULL;
+    size_t bad = 0;
+    if (rt_json_unescape(body, n, NULL, &msg, &bad) < 0)
+      return rt_json_fail(d, msg, open + 1 + bad);
+    esc = RT_JSON_STR_ESC;
+  }
+  rt_json_emit(d, RT_JSON_WORD(RT_JSON_STR, open + 1));
+  rt_json_emit(d, (uint64_t)n | esc);
+  return true;
+}
+
+static bool rt_json_literal(rt_json_doc_t *d, size_t p, const char *lit, size_t n, int kind) {
+  if (memcmp(d->buf + p, lit, n) != 0)
+    return rt_json_fail(d, "invalid literal", p);
+  rt_json_emit(d, RT_JSON_WORD(kind, 0));
+  return true;
+}
+
+static const char *rt_json_after_msg(int kind) {
+  if (kind == RT_JSON_OBJ)
+    return "expected ',' or '}' in object";
+  if (kind == RT_JSON_ARR)
+    return "expected ',' or ']' in array";
+  return "trailing characters after JSON value";
+}
+
+/* Builds the tape of the value starting at index entry d->cursor. */
+static bool rt_json_build(rt_json_doc_t *d) {
+  const uint8_t *s = (const uint8_t *)d->buf;
+  size_t cur = d->cursor;
+  size_t n = d->nidx;
+  uint32_t open[RT_JSON_MAX_DEPTH];
+  uint32_t count[RT_JSON_MAX_DEPTH];
+  uint8_t kind[RT_JSON_MAX_DEPTH];
+  int depth = 0;
+  d->ntape = 0;
+  d->err = NULL;
+  if (!rt_json_reserve((void **)&d->tape, &d->tape_cap, 2 * (n - cur) + 4, sizeof(uint64_t)))
+    return rt_json_fail(d, "out of memory", 0);
+  if (cur >= n)
+    return rt_json_fail(d, "unexpected end of input", d->len);
+
+value:
+  if (cur >= n)
+    return rt_json_fail(d, "unexpected end of input", d->len);
+  {
+    size_t p = d->idx[cur++];
+    uint8_t c = s[p];
+    switch (c) {
+    case '{':
+    case '[': {
+      if (depth == RT_JSON_MAX_DEPTH)
+        return rt_json_fail(d, "nesting too deep", p);
+      int k = c == '{' ? RT_JSON_OBJ : RT_JSON_ARR;
+      open[depth] = (uint32_t)d->ntape;
+      count[depth] = 0;
+      kind[depth] = (uint8_t)k;
+      depth++;
+      rt_json_emit(d, RT_JSON_WORD(k, 0));
+      rt_json_emit(d, 0);
+      if (cur < n && s[d->idx[cur]] == (c == '{' ? '}' : ']')) {
+        cur++;
+        goto close;
+      }
+      if (k == RT_JSON_OBJ)
+        goto key;
+      goto value;
+    }
+    case '"':
+      if (!rt_json_string(d, p, &cur))
+        return false;
+      break;
+    case 't':
+      if (!rt_json_literal(d, p, "true", 4, RT_JSON_TRUE))
+        return false;
+      p += 4;
+      goto scalar_end;
+    case 'f':
+      if (!rt_json_literal(d, p, "false", 5, RT_JSON_FALSE))
+        return false;
+      p += 5;
+      goto scalar_end;
+    case 'n':
+      if (!rt_json_literal(d, p, "null", 4, RT_JSON_NULL))
+        return false;
+      p += 4;
+      goto scalar_end;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+      uint64_t bits = 0;
+      size_t end = p;
+      int k = rt_json_number(d, p, &end, &bits);
+      if (k < 0)
+        return false;
+      rt_json_emit(d, RT_JSON_WORD(k, 0));
+      rt_json_emit(d, bits);
+      p = end;
+      goto scalar_end;
+    }
+    default:
+      return rt_json_fail(d, "unexpected token", p);
+    }
+    goto next;
+  scalar_end:
+    /* A bare scalar is one index entry; anything glued to it is garbage. */
+    if (p < d->len && !rt_json_is_term(s[p]))
+      return rt_json_fail(d, rt_json_after_msg(depth ? kind[depth - 1] : -1), p);
+    goto next;
+  }
+
+key:
+  if (cur >= n || s[d->idx[cur]] != '"')
+    return rt_json_fail(d, "expected string key", cur < n ? d->idx[cur] : d->len);
+  {
+    size_t p = d->idx[cur++];
+    if (!rt_json_string(d, p, &cur))
+      return false;
+  }
+  if (cur >= n || s[d->idx[cur]] != ':')
+    return rt_json_fail(d, "expected ':' after object key", cur < n ? d->idx[cur] : d->len);
+  cur++;
+  goto value;
+
+close:
+  depth--;
+  d->tape[open[depth]] = RT_JSON_WORD(kind[depth], d->ntape);
+  d->tape[open[depth] + 1] = count[depth];
+  rt_json_emit(d, RT_JSON_WORD(RT_JSON_END, open[depth]));
+
+next:
+  if (depth == 0) {
+    d->cursor = cur;
+    return true;
+  }
+  count[depth - 1]++;
+  {
+    const char *msg = rt_json_after_msg(kind[depth - 1]);
+    if (cur >= n)
+      return rt_json_fail(d, msg, d->len);
+    uint8_t c = s[d->idx[cur]];
+    if (c == ',') {
+      cur++;
+      if (kind[depth - 1] == RT_JSON_OBJ)
+        goto key;
+      goto value;
+    }
+    if (c == (kind[depth - 1] == RT_JSON_OBJ ? '}' : ']')) {
+      cur++;
+      goto close;
+    }
+    return rt_json_fail(d, msg, d->idx[cur]);
+  }
+}
+
+/* ---- Tape access -------------------------------------------------------- */
+
+static inline size_t rt_json_skip(const rt_json_doc_t *d, size_t i) {
+  int k = RT_JSON_KIND(d->tape[i]);
+  if (k == RT_JSON_OBJ || k == RT_JSON_ARR)
+    return (size_t)RT_JSON_PAYLOAD(d->tape[i]) + 1;
+  if (k == RT_JSON_INT || k == RT_JSON_FLOAT || k == RT_JSON_STR)
+    return i + 2;
+  return i + 1;
+}
+
+static inline bool rt_json_node_ok(const rt_json_doc_t *d, int64_t i) {
+  return d && i >= 0 && (size_t)i < d->ntape && RT_JSON_KIND(d->tape[i]) != RT_JSON_END;
+}
+
+static int64_t rt_json_str_value(const rt_json_doc_t *d, size_t i) {
+  size_t off = (size_t)RT_JSON_PAYLOAD(d->tape[i]);
+  uint64_t w = d->tape[i + 1];
+  size_t n = (size_t)(w & ~RT_JSON_STR_ESC);
+  const uint8_t *body = (const uint8_t *)d->buf + off;
+  if (!(w & RT_JSON_STR_ESC))
+    return rt_alloc_string_len((const char *)body, n);
+  char small[256];
+  char *tmp = n <= sizeof(small) ? small : (char *)malloc(n);
+  if (!tmp)
+    return 0;
+  const char *msg = NULL;
+  size_t bad = 0;
+  int64_t m = rt_json_unescape(body, n, tmp, &msg, &bad);
+  int64_t out = m >= 0 ? rt_alloc_string_len(tmp, (size_t)m) : 0;
+  if (tmp != small)
+    free(tmp);
+  return out;
+}
+
+static bool rt_json_key_eq(const rt_json_doc_t *d, size_t i, const char *key, size_t klen) {
+  size_t off = (size_t)RT_JSON_PAYLOAD(d->tape[i]);
+  uint64_t w = d->tape[i + 1];
+  size_t n = (size_t)(w & ~RT_JSON_STR_ESC);
+  const uint8_t *body = (const uint8_t *)d->buf + off;
+  if (!(w & RT_JSON_STR_ESC))
+    return n == klen && memcmp(body, key, n) == 0;
+  if (klen > n)
+    return false;
+  char small[256];
+  char *tmp = n <= sizeof(small) ? small : (char *)malloc(n);
+  if (!tmp)
+    return false;
+  const char *msg = NULL;
+  size_t bad = 0;
+  int64_t m = rt_json_unescape(body, n, tmp, &msg, &bad);
+  bool eq = m == (int64_t)klen && memcmp(tmp, key, klen) == 0;
+  if (tmp != small)
+    free(tmp);
+  return eq;
+}
+
+static int64_t rt_json_value(const rt_json_doc_t *d, size_t i) {
+  uint64_t w = d->tape[i];
+  switch (RT_JSON_KIND(w)) {
+  case RT_JSON_NULL:
+    return 0;
+  case RT_JSON_FALSE:
+    return NY_IMM_FALSE;
+  case RT_JSON_TRUE:
+    return NY_IMM_TRUE;
+  case RT_JSON_INT: {
+    int64_t v;
+    memcpy(&v, &d->tape[i + 1], sizeof(v));
+    return rt_tag_v(v);
+  }
+  case RT_JSON_FLOAT:
+    return rt_flt_box_val((int64_t)d->tape[i + 1]);
+  case RT_JSON_STR:
+    return rt_json_str_value(d, i);
+  case RT_JSON_ARR: {
+    int64_t n = (int64_t)d->tape[i + 1];
+    int64_t lst = rt_json_list(n);
+    if (!lst)
+      return 0;
+    size_t j = i + 2;
+    for (int64_t k = 0; k < n; k++) {
+      rt_json_list_set(lst, k, rt_json_value(d, j));
+      j = rt_json_skip(d, j);
+    }
+    return lst;
+  }
+  case RT_JSON_OBJ: {
+    int64_t n = (int64_t)d->tape[i + 1];
+    int64_t dict = rt_json_dict(n);
+    if (!dict)
+      return 0;
+    size_t j = i + 2;
+    for (int64_t k = 0; k < n; k++) {
+      int64_t key = rt_json_str_value(d, j);
+      j += 2;
+      dict = rt_dict_write_fast(dict, key, rt_json_value(d, j));
+      j = rt_json_skip(d, j);
+    }
+    return dict;
+  }
+  default:
+    return 0;
+  }
+}
+
+/* ---- Documents and streams ---------------------------------------------- */
+
+static rt_json_doc_t *rt_json_doc_alloc(void) {
+  rt_json_doc_t *d = (rt_json_doc_t *)calloc(1, sizeof(rt_json_doc_t));
+  if (!d)
+    return NULL;
+  d->magic = RT_JSON_MAGIC;
+  d->ctrl_pos = RT_JSON_NO_POS;
+  return d;
+}
+
+static void rt_json_doc_release(rt_json_doc_t *d) {
+  if (!d)
+    return;
+  d->magic = 0;
+  if (d->fp)
+    fclose(d->fp);
+  free(d->buf);
+  free(d->idx);
+  free(d->tape);
+  free(d->tail);
+  free(d);
+}
+
+static bool rt_json_buf_reserve(rt_json_doc_t *d, size_t n) {
+  if (n > RT_JSON_MAX_LEN)
+    return false;
+  if (n + RT_JSON_PAD <= d->cap)
+    return true;
+  size_t nc = d->cap ? d->cap : 4096;
+  while (nc < n + RT_JSON_PAD)
+    nc *= 2;
+  char *nb = (char *)realloc(d->buf, nc);
+  if (!nb)
+    return false;
+  d->buf = nb;
+  d->cap = nc;
+  return true;
+}
+
+static inline void rt_json_pad(rt_json_doc_t *d) { memset(d->buf + d->len, ' ', RT_JSON_PAD); }
+
+/* Loads the input and runs both stages over a single document. */
+static bool rt_json_parse_one(rt_json_doc_t *d, const char *s, size_t n) {
+  if (!rt_json_buf_reserve(d, n))
+    return rt_json_fail(d, n > RT_JSON_MAX_LEN ? "document too large" : "out of memory", 0);
+  memcpy(d->buf, s, n);
+  d->len = n;
+  rt_json_pad(d);
+  if (!rt_json_index(d, 0) || !rt_json_build(d))
+    return false;
+  if (d->cursor != d->nidx)
+    return rt_json_fail(d, "trailing characters after JSON value", d->idx[d->cursor]);
+  return true;
+}
+
+static inline bool rt_json_is_str(int64_t v) { return is_v_str(v); }
+
+/* Rebuilds the stream window from buf[keep_from, len), the stashed tail and
+   fresh input, cut after its last newline so no document straddles two
+   windows unless a single line outgrows the window, which then doubles. */
+static bool rt_json_stream_fill(rt_json_doc_t *d, size_t keep_from) {
+  size_t keep = d->len - keep_from;
+  if (keep)
+    memmove(d->buf, d->buf + keep_from, keep);
+  d->len = keep;
+  size_t want = RT_JSON_WINDOW > keep * 2 ? RT_JSON_WINDOW : keep * 2;
+  if (want < d->tail_len + keep)
+    want = (d->tail_len + keep) * 2;
+  if (!rt_json_buf_reserve(d, want))
+    return rt_json_fail(d, "out of memory", 0);
+  if (d->tail_len)
+    memcpy(d->buf + d->len, d->tail, d->tail_len);
+  d->len += d->tail_len;
+  d->tail_len = 0;
+  size_t scanned = keep;
+  for (;;) {
+    size_t room = want - d->len;
+    size_t got = 0;
+    if (d->fp && !d->eof) {
+      got = fread(d->buf + d->len, 1, room, d->fp);
+      if (got < room)
+        d->eof = true;
+    } else if (!d->fp) {
+      got = d->src_len - d->src_pos < room ? d->src_len - d->src_pos : room;
+      memcpy(d->buf + d->len, d->src + d->src_pos, got);
+      d->src_pos += got;
+      if (d->src_pos >= d->src_len)
+        d->eof = true;
+    }
+    d->len += got;
+    if (d->eof)
+      break;
+    size_t cut = d->len;
+    while (cut > scanned && d->buf[cut - 1] != '\n')
+      cut--;
+    if (cut > scanned) {
+      size_t tail = d->len - cut;
+      if (!rt_json_reserve((void **)&d->tail, &d->tail_cap, tail, 1))
+        return rt_json_fail(d, "out of memory", 0);
+      memcpy(d->tail, d->buf + cut, tail);
+      d->tail_len = tail;
+      d->len = cut;
+      break;
+    }
+    scanned = d->len;
+    want *= 2;
+    if (!rt_json_buf_reserve(d, want))
+      return rt_json_fail(d, "out of memory", 0);
+  }
+  rt_json_pad(d);
+  return rt_json_index(d, 0);
+}
+
+static inline bool rt_json_stream_done(const rt_json_doc_t *d) { return d->eof && !d->tail_len; }
+
+/* Drops the window up to the line after a malformed document and re-indexes. */
+static bool rt_json_stream_resync(rt_json_doc_t *d, size_t start) {
+  const char *nl = memchr(d->buf + start, '\n', d->len - start);
+  size_t from = nl ? (size_t)(nl - d->buf) + 1 : d->len;
+  memmove(d->buf, d->buf + from, d->len - from);
+  d->len -= from;
+  rt_json_pad(d);
+  return rt_json_index(d, 0);
+}
+
+/* ---- Builtins ----------------------------------------------------------- */
+
+int64_t rt_json_decode(int64_t s_v) {
+  int64_t out = rt_json_list(4);
+  if (!out)
+    return 0;
+  if (!rt_json_is_str(s_v)) {
+    rt_json_list_set(out, 0, NY_IMM_FALSE);
+    rt_json_list_set(out, 1, 0);
+    rt_json_list_set(out, 2, rt_alloc_string("json input must be a string"));
+    rt_json_list_set(out, 3, rt_tag_v(0));
+    return out;
+  }
+  size_t n = rt_tagged_str_len(s_v);
+  rt_json_doc_t d;
+  memset(&d, 0, sizeof(d));
+  d.magic = RT_JSON_MAGIC;
+  bool ok = rt_json_parse_one(&d, (const char *)(uintptr_t)s_v, n);
+  rt_json_list_set(out, 0, ok ? NY_IMM_TRUE : NY_IMM_FALSE);
+  rt_json_list_set(out, 1, ok ? rt_json_value(&d, 0) : 0);
+  rt_json_list_set(out, 2, rt_alloc_string(ok ? "" : d.err));
+  rt_json_list_set(out, 3, rt_tag_v((int64_t)(ok ? n : d.err_pos)));
+  free(d.buf);
+  free(d.idx);
+  free(d.tape);
+  return out;
+}
+
+int64_t rt_json_doc_new(int64_t s_v) {
+  if (!rt_json_is_str(s_v))
+    return 0;
+  rt_json_doc_t *d = rt_json_doc_alloc();
+  if (!d)
+    return 0;
+  if (!rt_json_parse_one(d, (const char *)(uintptr_t)s_v, rt_tagged_str_len(s_v)))
+    d->ntape = 0;
+  return (int64_t)(uintptr_t)d;
+}
+
+int64_t rt_json_stream_new(int64_t src_v, int64_t is_path_v) {
+  if (!rt_json_is_str(src_v))
+    return 0;
+  rt_json_doc_t *d = rt_json_doc_alloc();
+  if (!d)
+    return 0;
+  d->stream = true;
+  if (rt_is_truthy(is_path_v)) {
+    d->fp = fopen((const char *)(uintptr_t)src_v, "rb");
+    if (!d->fp) {
+      rt_json_doc_release(d);
+      return 0;
+    }
+  } else {
+    d->src = (const char *)(uintptr_t)src_v;
+    d->src_len = rt_tagged_str_len(src_v);
+  }
+  return (int64_t)(uintptr_t)d;
+}
+
+int64_t rt_json_stream_next(int64_t doc_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  if (!d || !d->stream)
+    return rt_tag_v(-1);
+  d->ntape = 0;
+  for (;;) {
+    if (d->cursor >= d->nidx) {
+      if (rt_json_stream_done(d)) {
+        d->len = 0;
+        d->nidx = 0;
+        return rt_tag_v(-1);
+      }
+      d->err = NULL;
+      if (!rt_json_stream_fill(d, d->len))
+        return rt_tag_v(-2);
+      continue;
+    }
+    size_t start = d->idx[d->cursor];
+    if (rt_json_build(d)) {
+      d->docs++;
+      return rt_tag_v(0);
+    }
+    if (d->err_pos >= d->len && !rt_json_stream_done(d)) {
+      /* The document runs past the window: carry it into the next one. */
+      d->err = NULL;
+      if (!rt_json_stream_fill(d, start))
+        return rt_tag_v(-2);
+      continue;
+    }
+    d->errors++;
+    d->ntape = 0;
+    const char *err = d->err;
+    size_t err_pos = d->err_pos;
+    if (!rt_json_stream_resync(d, start))
+      return rt_tag_v(-2);
+    d->err = err;
+    d->err_pos = err_pos;
+    return rt_tag_v(-2);
+  }
+}
+
+int64_t rt_json_doc_free(int64_t doc_v) {
+  rt_json_doc_release(rt_json_handle(doc_v));
+  return 0;
+}
+
+int64_t rt_json_doc_status(int64_t doc_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  if (!d)
+    return 0;
+  int64_t out = rt_json_list(4);
+  if (!out)
+    return 0;
+  rt_json_list_set(out, 0, rt_alloc_string(d->err ? d->err : ""));
+  rt_json_list_set(out, 1, rt_tag_v((int64_t)(d->err ? d->err_pos : 0)));
+  rt_json_list_set(out, 2, rt_tag_v(d->docs));
+  rt_json_list_set(out, 3, rt_tag_v(d->errors));
+  return out;
+}
+
+int64_t rt_json_node_kind(int64_t doc_v, int64_t node_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  int64_t i = rt_json_int_arg(node_v);
+  if (!rt_json_node_ok(d, i))
+    return rt_tag_v(-1);
+  return rt_tag_v(RT_JSON_KIND(d->tape[i]));
+}
+
+int64_t rt_json_node_len(int64_t doc_v, int64_t node_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  int64_t i = rt_json_int_arg(node_v);
+  if (!rt_json_node_ok(d, i))
+    return rt_tag_v(0);
+  int k = RT_JSON_KIND(d->tape[i]);
+  if (k == RT_JSON_OBJ || k == RT_JSON_ARR)
+    return rt_tag_v((int64_t)d->tape[i + 1]);
+  if (k == RT_JSON_STR)
+    return rt_tag_v((int64_t)(d->tape[i + 1] & ~RT_JSON_STR_ESC));
+  return rt_tag_v(0);
+}
+
+int64_t rt_json_node_get(int64_t doc_v, int64_t node_v, int64_t key_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  int64_t i = rt_json_int_arg(node_v);
+  if (!rt_json_node_ok(d, i))
+    return rt_tag_v(-1);
+  int k = RT_JSON_KIND(d->tape[i]);
+  int64_t n = (int64_t)d->tape[i + 1];
+  size_t j = (size_t)i + 2;
+  if (k == RT_JSON_OBJ && rt_json_is_str(key_v)) {
+    const char *key = (const char *)(uintptr_t)key_v;
+    size_t klen = rt_tagged_str_len(key_v);
+    /* Duplicate keys resolve to the last one, as the decoded dict would. */
+    int64_t hit = -1;
+    for (int64_t e = 0; e < n; e++) {
+      if (rt_json_key_eq(d, j, key, klen))
+        hit = (int64_t)j + 2;
+      j = rt_json_skip(d, j + 2);
+    }
+    return rt_tag_v(hit);
+  }
+  if (k == RT_JSON_ARR && is_int(key_v)) {
+    int64_t want = rt_untag_v(key_v);
+    if (want < 0)
+      want += n;
+    if (want < 0 || want >= n)
+      return rt_tag_v(-1);
+    for (int64_t e = 0; e < want; e++)
+      j = rt_json_skip(d, j);
+    return rt_tag_v((int64_t)j);
+  }
+  return rt_tag_v(-1);
+}
+
+int64_t rt_json_node_keys(int64_t doc_v, int64_t node_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  int64_t i = rt_json_int_arg(node_v);
+  if (!rt_json_node_ok(d, i) || RT_JSON_KIND(d->tape[i]) != RT_JSON_OBJ)
+    return rt_json_list(0);
+  int64_t n = (int64_t)d->tape[i + 1];
+  int64_t out = rt_json_list(n);
+  if (!out)
+    return 0;
+  size_t j = (size_t)i + 2;
+  for (int64_t e = 0; e < n; e++) {
+    rt_json_list_set(out, e, rt_json_str_value(d, j));
+    j = rt_json_skip(d, j + 2);
+  }
+  return out;
+}
+
+int64_t rt_json_node_value(int64_t doc_v, int64_t node_v) {
+  rt_json_doc_t *d = rt_json_handle(doc_v);
+  int64_t i = rt_json_int_arg(node_v);
+  if (!rt_json_node_ok(d, i))
+    return 0;
+  return rt_json_value(d, (size_t)i);
+}
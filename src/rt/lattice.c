@@ -0,0 +1,897 @@
+#include "rt/shared.h"
+#include <float.h>
+#include <gmp.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Floating-point LLL for std.math.crypto.lattice.
+ *
+ * L^2-style reduction: basis and transform rows stay exact (GMP) and the Gram
+ * matrix is updated exactly with every row operation, so the long double
+ * Gram-Schmidt data (r, mu) is always recomputed from exact inner products
+ * instead of being accumulated. Size reduction is lazy and repeated until the
+ * recomputed coefficients are below eta; when that stops making progress, or
+ * a value leaves the long double range, the run escalates to integral LLL
+ * (Cohen, Alg. 2.6.7), which is exact but slower. Rows are addressed through a
+ * position -> id table so swaps and deep insertions only move indices.
+ *
+ * The same state drives BKZ: Schnorr-Euchner enumeration on each block
+ * projected by the current GSO, insertion of the found vector and an LLL pass
+ * that removes the resulting linear dependency.
+ */
+
+extern int64_t rt_list_new(int64_t n);
+extern void _bi_val_to_mpz(int64_t v, mpz_t result);
+extern int64_t _bi_from_mpz(const mpz_t val);
+extern bool _bi_mpz_fits_small_int(const mpz_t v);
+extern int64_t _bi_mpz_get_i64(const mpz_t v);
+extern void _bi_mpz_set_i64(mpz_t out, int64_t v);
+
+typedef long double rt_lll_real;
+
+#define RT_LLL_DELTA_BITS 30
+#define RT_LLL_SIZE_PASSES 256
+#define RT_LLL_SIZE_STALLS 6
+#define RT_LLL_ENUM_COEFF_MAX 1.0e12L
+#define RT_LLL_BKZ_GAIN 0.99L
+
+enum { RT_LLL_CORE_FP = 0, RT_LLL_CORE_EXACT = 1 };
+
+typedef struct {
+  int n;     /* active (non-zero) rows, positions [0, n) */
+  int rows;  /* tracked rows; zero rows sit at positions [n, rows) */
+  int cap;   /* row ids available */
+  int m;     /* basis columns */
+  int tc;    /* transform columns, 0 when not tracked */
+  int depth; /* deep-insertion window, 0 = adjacent swaps only */
+  int *pos;  /* position -> row id */
+  mpz_t *b;  /* cap * m */
+  mpz_t *u;  /* cap * tc */
+  mpz_t *g;  /* cap * cap, only g[a * cap + c] with a >= c is used */
+  rt_lll_real *mu;
+  rt_lll_real *r;
+  rt_lll_real *s;
+  rt_lll_real delta;
+  rt_lll_real eta;
+  mpz_t x;
+  mpz_t t;
+  int64_t steps;
+  int64_t swaps;
+  int64_t swap_cap;
+  int64_t deep;
+  int64_t deep_distance;
+  int64_t scale; /* Gram entries are read as G * 2^-scale */
+  int core;
+} rt_lll_t;
+
+#define RT_LLL_B(c, id, j) ((c)->b[(size_t)(id) * (size_t)(c)->m + (size_t)(j)])
+#define RT_LLL_U(c, id, j) ((c)->u[(size_t)(id) * (size_t)(c)->tc + (size_t)(j)])
+#define RT_LLL_MU(c, i, j) ((c)->mu[(size_t)(i) * (size_t)(c)->cap + (size_t)(j)])
+#define RT_LLL_R(c, i, j) ((c)->r[(size_t)(i) * (size_t)(c)->cap + (size_t)(j)])
+
+static inline mpz_ptr rt_lll_g(rt_lll_t *c, int a, int b) {
+  return a >= b ? c->g[(size_t)a * (size_t)c->cap + (size_t)b]
+                : c->g[(size_t)b * (size_t)c->cap + (size_t)a];
+}
+
+static inline int64_t rt_lll_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static double rt_lll_num_arg(int64_t v, double dflt) {
+  if (is_int(v))
+    return (double)rt_untag_v(v);
+  if (is_v_flt(v))
+    return rt_flt_payload(v);
+  return dflt;
+}
+
+static bool rt_lll_is_seq(int64_t v) {
+  if (!is_ptr(v) || !is_heap_ptr(v))
+    return false;
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)v - 8);
+  return tag == TAG_LIST || tag == TAG_TUPLE;
+}
+
+static inline int64_t rt_lll_seq_len(int64_t v) {
+  return rt_lll_int_arg(*(int64_t *)(uintptr_t)v);
+}
+
+static inline int64_t rt_lll_seq_at(int64_t v, int64_t i) {
+  return *(int64_t *)((char *)(uintptr_t)v + 16 + i * 8);
+}
+
+static int64_t rt_lll_list_of(const int64_t *items, int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (!lst)
+    return 0;
+  for (int64_t i = 0; i < n; i++)
+    *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = items[i];
+  *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+static int64_t rt_lll_box_f64(double d) {
+  int64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return rt_flt_box_val(bits);
+}
+
+static int64_t rt_lll_box_mpz(const mpz_t v) {
+  if (_bi_mpz_fits_small_int(v))
+    return rt_tag_v(_bi_mpz_get_i64(v));
+  return _bi_from_mpz(v);
+}
+
+static bool rt_lll_entry(int64_t v, mpz_t out) {
+  if (is_int(v)) {
+    _bi_mpz_set_i64(out, rt_untag_v(v));
+    return true;
+  }
+  if (!is_ptr(v) || !is_heap_ptr(v) || *(int64_t *)((char *)(uintptr_t)v - 8) != TAG_BIGINT)
+    return false;
+  mpz_t tmp;
+  _bi_val_to_mpz(v, tmp);
+  mpz_swap(out, tmp);
+  mpz_clear(tmp);
+  return true;
+}
+
+/*
+ * Long double from the two leading limbs, times 2^-scale. Gram entries of
+ * Coppersmith-style bases overflow the long double exponent, so the whole
+ * Gram matrix is read with one shift; r scales with it and mu is unaffected.
+ */
+static rt_lll_real rt_lll_mpz_fp(const mpz_t v, int64_t scale) {
+  size_t n = mpz_size(v);
+  if (n == 0)
+    return 0.0L;
+  rt_lll_real out = (rt_lll_real)mpz_getlimbn(v, n - 1);
+  int64_t shift = -scale;
+  if (n > 1) {
+    out = ldexpl(out, GMP_NUMB_BITS) + (rt_lll_real)mpz_getlimbn(v, n - 2);
+    shift += (int64_t)GMP_NUMB_BITS * (int64_t)(n - 2);
+  }
+  if (shift > LDBL_MAX_EXP)
+    out = (rt_lll_real)INFINITY;
+  else if (shift < LDBL_MIN_EXP - LDBL_MANT_DIG - 2 * GMP_NUMB_BITS)
+    out = 0.0L;
+  else if (shift != 0)
+    out = ldexpl(out, (int)shift);
+  return mpz_sgn(v) < 0 ? -out : out;
+}
+
+/* Exact conversion of an integral long double. */
+static void rt_lll_fp_mpz(mpz_t out, rt_lll_real v) {
+  if (fabsl(v) < 2147483647.0L) {
+    mpz_set_si(out, (long)v);
+    return;
+  }
+  int e = 0;
+  rt_lll_real f = frexpl(fabsl(v), &e);
+  uint64_t mant = (uint64_t)ldexpl(f, 64);
+  mpz_import(out, 1, -1, sizeof(mant), 0, 0, &mant);
+  if (e >= 64)
+    mpz_mul_2exp(out, out, (mp_bitcnt_t)(e - 64));
+  else
+    mpz_tdiv_q_2exp(out, out, (mp_bitcnt_t)(64 - e));
+  if (v < 0)
+    mpz_neg(out, out);
+}
+
+static void rt_lll_free(rt_lll_t *c) {
+  if (!c)
+    return;
+  size_t cap = (size_t)c->cap;
+  if (c->b) {
+    for (size_t i = 0; i < cap * (size_t)c->m; i++)
+      mpz_clear(c->b[i]);
+    free(c->b);
+  }
+  if (c->u) {
+    for (size_t i = 0; i < cap * (size_t)c->tc; i++)
+      mpz_clear(c->u[i]);
+    free(c->u);
+  }
+  if (c->g) {
+    for (size_t i = 0; i < cap * cap; i++)
+      mpz_clear(c->g[i]);
+    free(c->g);
+  }
+  mpz_clear(c->x);
+  mpz_clear(c->t);
+  free(c->pos);
+  free(c->mu);
+  free(c->r);
+  free(c->s);
+  memset(c, 0, sizeof(*c));
+}
+
+/* Loads a list of integer rows; spare ids beyond the input are left zero. */
+static bool rt_lll_load(rt_lll_t *c, int64_t rows_v, bool track, int spare) {
+  memset(c, 0, sizeof(*c));
+  mpz_init(c->x);
+  mpz_init(c->t);
+  if (!rt_lll_is_seq(rows_v))
+    return false;
+  int64_t n = rt_lll_seq_len(rows_v);
+  if (n <= 0 || n > 4096)
+    return false;
+  int64_t first = rt_lll_seq_at(rows_v, 0);
+  if (!rt_lll_is_seq(first))
+    return false;
+  int64_t m = rt_lll_seq_len(first);
+  if (m <= 0 || m > 1 << 20)
+    return false;
+  c->rows = c->n = (int)n;
+  c->cap = (int)n + spare;
+  c->m = (int)m;
+  c->tc = track ? (int)n : 0;
+  size_t cap = (size_t)c->cap;
+  c->pos = (int *)calloc(cap, sizeof(int));
+  c->b = (mpz_t *)calloc(cap * (size_t)m, sizeof(mpz_t));
+  c->u = c->tc ? (mpz_t *)calloc(cap * (size_t)c->tc, sizeof(mpz_t)) : NULL;
+  c->g = (mpz_t *)calloc(cap * cap, sizeof(mpz_t));
+  c->mu = (rt_lll_real *)calloc(cap * cap, sizeof(rt_lll_real));
+  c->r = (rt_lll_real *)calloc(cap * cap, sizeof(rt_lll_real));
+  c->s = (rt_lll_real *)calloc(cap + 1, sizeof(rt_lll_real));
+  if (!c->pos || !c->b || (c->tc && !c->u) || !c->g || !c->mu || !c->r || !c->s) {
+    /* Keep rt_lll_free from clearing uninitialised limbs. */
+    free(c->b);
+    free(c->u);
+    free(c->g);
+    c->b = c->u = c->g = NULL;
+    return false;
+  }
+  for (size_t i = 0; i < cap * (size_t)m; i++)
+    mpz_init(c->b[i]);
+  for (size_t i = 0; i < cap * (size_t)c->tc; i++)
+    mpz_init(c->u[i]);
+  for (size_t i = 0; i < cap * cap; i++)
+    mpz_init(c->g[i]);
+  for (int i = 0; i < (int)n; i++) {
+    c->pos[i] = i;
+    int64_t row = rt_lll_seq_at(rows_v, i);
+    if (!rt_lll_is_seq(row) || rt_lll_seq_len(row) != m)
+      return false;
+    for (int j = 0; j < (int)m; j++)
+      if (!rt_lll_entry(rt_lll_seq_at(row, j), RT_LLL_B(c, i, j)))
+        return false;
+    if (c->tc)
+      mpz_set_ui(RT_LLL_U(c, i, i), 1);
+  }
+  for (int a = 0; a < (int)n; a++) {
+    for (int b = 0; b <= a; b++) {
+      mpz_ptr gab = rt_lll_g(c, a, b);
+      for (int j = 0; j < (int)m; j++)
+        mpz_addmul(gab, RT_LLL_B(c, a, j), RT_LLL_B(c, b, j));
+    }
+  }
+  int64_t gbits = 0;
+  for (int a = 0; a < (int)n; a++) {
+    int64_t bits = (int64_t)mpz_sizeinbase(rt_lll_g(c, a, a), 2);
+    if (bits > gbits)
+      gbits = bits;
+  }
+  c->scale = gbits > LDBL_MAX_EXP - 512 ? gbits - (LDBL_MAX_EXP - 512) : 0;
+  return true;
+}
+
+static void rt_lll_params(rt_lll_t *c, int64_t delta_v, int64_t eta_v) {
+  double delta = rt_lll_num_arg(delta_v, 0.99);
+  double eta = rt_lll_num_arg(eta_v, 0.51);
+  if (!(delta > 0.25))
+    delta = 0.25;
+  if (!(delta < 1.0))
+    delta = 0.999;
+  if (!(eta >= 0.5))
+    eta = 0.5;
+  /* Reduce slightly inside the requested bounds so an independent f64
+   * quality check of the output does not trip over rounding at the edge. */
+  c->delta = (rt_lll_real)delta + (1.0L - (rt_lll_real)delta) * 0.01L;
+  c->eta = 0.5L + ((rt_lll_real)eta - 0.5L) * 0.9L;
+}
+
+static int64_t rt_lll_max_bits(rt_lll_t *c) {
+  size_t best = 0;
+  for (int p = 0; p < c->rows; p++) {
+    int id = c->pos[p];
+    for (int j = 0; j < c->m; j++) {
+      size_t bits = mpz_sizeinbase(RT_LLL_B(c, id, j), 2);
+      if (bits > best)
+        best = bits;
+    }
+  }
+  return (int64_t)best;
+}
+
+static inline void rt_lll_submul(mpz_t dst, const mpz_t src, const mpz_t q, long qs, bool small) {
+  if (!mpz_sgn(src))
+    return;
+  if (!small)
+    mpz_submul(dst, src, q);
+  else if (qs >= 0)
+    mpz_submul_ui(dst, src, (unsigned long)qs);
+  else
+    mpz_addmul_ui(dst, src, (unsigned long)-qs);
+}
+
+/* Row operation b[pk] -= q * b[pj] on positions, keeping the Gram matrix exact. */
+static void rt_lll_row_op(rt_lll_t *c, int pk, int pj, const mpz_t q) {
+  int a = c->pos[pk];
+  int src = c->pos[pj];
+  bool small = mpz_fits_slong_p(q) && mpz_cmpabs_ui(q, LONG_MAX / 2) < 0;
+  long qs = small ? mpz_get_si(q) : 0;
+  for (int j = 0; j < c->m; j++)
+    rt_lll_submul(RT_LLL_B(c, a, j), RT_LLL_B(c, src, j), q, qs, small);
+  for (int j = 0; j < c->tc; j++)
+    rt_lll_submul(RT_LLL_U(c, a, j), RT_LLL_U(c, src, j), q, qs, small);
+  /* G(a,a) -= q * (2 G(a,src) - q G(src,src)), then G(a,y) -= q G(src,y). */
+  mpz_mul_2exp(c->t, rt_lll_g(c, a, src), 1);
+  rt_lll_submul(c->t, rt_lll_g(c, src, src), q, qs, small);
+  rt_lll_submul(rt_lll_g(c, a, a), c->t, q, qs, small);
+  for (int p = 0; p < c->rows; p++) {
+    int y = c->pos[p];
+    if (y != a)
+      rt_lll_submul(rt_lll_g(c, a, y), rt_lll_g(c, src, y), q, qs, small);
+  }
+  c->steps++;
+}
+
+/* Moves the row at position from to position to, shifting the rows between. */
+static void rt_lll_move(rt_lll_t *c, int from, int to) {
+  if (from == to)
+    return;
+  int id = c->pos[from];
+  if (from > to)
+    memmove(c->pos + to + 1, c->pos + to, (size_t)(from - to) * sizeof(int));
+  else
+    memmove(c->pos + from, c->pos + from + 1, (size_t)(to - from) * sizeof(int));
+  c->pos[to] = id;
+}
+
+/* Recomputes r/mu for position k from the exact Gram row and the s prefix sums. */
+static bool rt_lll_gso_row(rt_lll_t *c, int k) {
+  int id = c->pos[k];
+  for (int j = 0; j < k; j++) {
+    rt_lll_real acc = rt_lll_mpz_fp(rt_lll_g(c, id, c->pos[j]), c->scale);
+    for (int i = 0; i < j; i++)
+      acc -= RT_LLL_MU(c, j, i) * RT_LLL_R(c, k, i);
+    RT_LLL_R(c, k, j) = acc;
+    RT_LLL_MU(c, k, j) = RT_LLL_R(c, j, j) > 0.0L ? acc / RT_LLL_R(c, j, j) : 0.0L;
+  }
+  rt_lll_real s = rt_lll_mpz_fp(rt_lll_g(c, id, id), c->scale);
+  if (!isfinite(s))
+    return false;
+  c->s[0] = s;
+  for (int j = 0; j < k; j++) {
+    s -= RT_LLL_MU(c, k, j) * RT_LLL_R(c, k, j);
+    c->s[j + 1] = s;
+  }
+  RT_LLL_R(c, k, k) = s;
+  RT_LLL_MU(c, k, k) = 1.0L;
+  return isfinite(s);
+}
+
+/* Lazy size reduction of position k; false when precision is insufficient. */
+static bool rt_lll_size_reduce(rt_lll_t *c, int k) {
+  rt_lll_real best = (rt_lll_real)INFINITY;
+  int stalls = 0;
+  for (int pass = 0; pass < RT_LLL_SIZE_PASSES; pass++) {
+    if (!rt_lll_gso_row(c, k))
+      return false;
+    rt_lll_real worst = 0.0L;
+    for (int j = 0; j < k; j++) {
+      rt_lll_real a = fabsl(RT_LLL_MU(c, k, j));
+      if (!isfinite(a))
+        return false;
+      if (a > worst)
+        worst = a;
+    }
+    if (worst <= c->eta)
+      return true;
+    if (worst < best) {
+      best = worst;
+      stalls = 0;
+    } else if (++stalls > RT_LLL_SIZE_STALLS) {
+      return false;
+    }
+    for (int j = k - 1; j >= 0; j--) {
+      rt_lll_real q = rintl(RT_LLL_MU(c, k, j));
+      if (q == 0.0L)
+        continue;
+      for (int i = 0; i < j; i++)
+        RT_LLL_MU(c, k, i) -= q * RT_LLL_MU(c, j, i);
+      RT_LLL_MU(c, k, j) -= q;
+      rt_lll_fp_mpz(c->x, q);
+      rt_lll_row_op(c, k, j, c->x);
+    }
+  }
+  return false;
+}
+
+/*
+ * Runs L^2 from position start (rows before start must carry valid GSO data).
+ * Returns 1 when reduced, 0 when the swap budget ran out and -1 when long
+ * double precision was not enough.
+ */
+static int rt_lll_run(rt_lll_t *c, int start) {
+  int k = start;
+  while (k < c->n) {
+    if (c->swaps > c->swap_cap)
+      return 0;
+    int id = c->pos[k];
+    if (k > 0 && !rt_lll_size_reduce(c, k))
+      return -1;
+    if (mpz_sgn(rt_lll_g(c, id, id)) == 0) {
+      /* Dependent input: park the zero row behind the active rows. */
+      rt_lll_move(c, k, c->rows - 1);
+      c->n--;
+      continue;
+    }
+    if (k == 0) {
+      if (!rt_lll_gso_row(c, 0))
+        return -1;
+      k = 1;
+      continue;
+    }
+    int ins = k;
+    if (c->depth > 0) {
+      for (int i = 0; i < k; i++) {
+        if ((i < c->depth || k - i <= c->depth) && c->s[i] < c->delta * RT_LLL_R(c, i, i)) {
+          ins = i;
+          break;
+        }
+      }
+    } else if (c->s[k - 1] < c->delta * RT_LLL_R(c, k - 1, k - 1)) {
+      ins = k - 1;
+    }
+    if (ins == k && !(RT_LLL_R(c, k, k) > 0.0L))
+      ins = k - 1;
+    if (ins == k) {
+      k++;
+      continue;
+    }
+    rt_lll_move(c, k, ins);
+    c->swaps++;
+    if (k - ins > 1) {
+      c->deep++;
+      c->deep_distance += k - ins;
+    }
+    k = ins;
+  }
+  return 1;
+}
+
+/* Exact division helper for the integral recurrences. */
+static inline void rt_lll_exact_div(mpz_t out, const mpz_t num, const mpz_t den) {
+  mpz_divexact(out, num, den);
+}
+
+/*
+ * Integral LLL on the active rows (Cohen, Alg. 2.6.7) with delta rounded up
+ * to a multiple of 2^-30. Requires linearly independent active rows.
+ */
+static bool rt_lll_exact(rt_lll_t *c) {
+  int n = c->n;
+  if (n <= 1)
+    return n == 1 ? mpz_sgn(rt_lll_g(c, c->pos[0], c->pos[0])) != 0 : true;
+  size_t nn = (size_t)n;
+  mpz_t *lam = (mpz_t *)calloc(nn * nn, sizeof(mpz_t));
+  mpz_t *d = (mpz_t *)calloc(nn + 1, sizeof(mpz_t));
+  if (!lam || !d) {
+    free(lam);
+    free(d);
+    return false;
+  }
+  for (size_t i = 0; i < nn * nn; i++)
+    mpz_init(lam[i]);
+  for (size_t i = 0; i <= nn; i++)
+    mpz_init(d[i]);
+  mpz_t u, lhs, rhs, q, tmp, bn;
+  mpz_inits(u, lhs, rhs, q, tmp, bn, NULL);
+  unsigned long dnum = (unsigned long)ceill(c->delta * (rt_lll_real)(1UL << RT_LLL_DELTA_BITS));
+  if (dnum >= (1UL << RT_LLL_DELTA_BITS))
+    dnum = (1UL << RT_LLL_DELTA_BITS) - 1;
+#define LAM(i, j) lam[(size_t)(i) * nn + (size_t)(j)]
+  bool ok = true;
+  mpz_set_ui(d[0], 1);
+  int k = 0;
+  int kmax = -1;
+  while (k < n && ok) {
+    if (k > kmax) {
+      kmax = k;
+      for (int j = 0; j <= k; j++) {
+        mpz_set(u, rt_lll_g(c, c->pos[k], c->pos[j]));
+        for (int i = 0; i < j; i++) {
+          mpz_mul(u, u, d[i + 1]);
+          mpz_submul(u, LAM(k, i), LAM(j, i));
+          rt_lll_exact_div(u, u, d[i]);
+        }
+        if (j < k)
+          mpz_set(LAM(k, j), u);
+        else
+          mpz_set(d[k + 1], u);
+      }
+      if (mpz_sgn(d[k + 1]) <= 0) {
+        ok = false;
+        break;
+      }
+      if (k == 0) {
+        k = 1;
+        continue;
+      }
+    }
+    /* REDI(k, l): |2 lambda| > d_l means |mu| > 1/2. */
+    for (int pass = 0; pass < 2; pass++) {
+      int lo = pass == 0 ? k - 1 : k - 2;
+      int hi = pass == 0 ? k - 1 : 0;
+      if (pass == 1) {
+        /* Lovasz with delta = dnum / 2^30:
+         * swap when 2^30 d_k d_{k-2} < dnum d_{k-1}^2 - 2^30 lambda^2. */
+        mpz_mul(lhs, d[k + 1], d[k - 1]);
+        mpz_mul_2exp(lhs, lhs, RT_LLL_DELTA_BITS);
+        mpz_mul(rhs, d[k], d[k]);
+        mpz_mul_ui(rhs, rhs, dnum);
+        mpz_mul(tmp, LAM(k, k - 1), LAM(k, k - 1));
+        mpz_mul_2exp(tmp, tmp, RT_LLL_DELTA_BITS);
+        mpz_sub(rhs, rhs, tmp);
+        if (mpz_cmp(lhs, rhs) < 0)
+          break;
+      }
+      for (int l = lo; l >= hi; l--) {
+        mpz_mul_2exp(tmp, LAM(k, l), 1);
+        if (mpz_cmpabs(tmp, d[l + 1]) <= 0)
+          continue;
+        /* q = floor((2 lambda + d) / (2 d)) */
+        mpz_add(tmp, tmp, d[l + 1]);
+        mpz_mul_2exp(q, d[l + 1], 1);
+        mpz_fdiv_q(q, tmp, q);
+        rt_lll_row_op(c, k, l, q);
+        mpz_submul(LAM(k, l), q, d[l + 1]);
+        for (int i = 0; i < l; i++)
+          mpz_submul(LAM(k, i), q, LAM(l, i));
+      }
+      if (pass == 1) {
+        k++;
+        goto next;
+      }
+    }
+    /* SWAPI(k) */
+    rt_lll_move(c, k, k - 1);
+    c->swaps++;
+    for (int j = 0; j < k - 1; j++)
+      mpz_swap(LAM(k, j), LAM(k - 1, j));
+    mpz_set(tmp, LAM(k, k - 1));
+    mpz_mul(bn, d[k - 1], d[k + 1]);
+    mpz_addmul(bn, tmp, tmp);
+    rt_lll_exact_div(bn, bn, d[k]);
+    for (int i = k + 1; i <= kmax; i++) {
+      mpz_set(q, LAM(i, k));
+      mpz_mul(u, d[k + 1], LAM(i, k - 1));
+      mpz_submul(u, tmp, q);
+      rt_lll_exact_div(LAM(i, k), u, d[k]);
+      mpz_mul(u, bn, q);
+      mpz_addmul(u, tmp, LAM(i, k));
+      rt_lll_exact_div(LAM(i, k - 1), u, d[k + 1]);
+    }
+    mpz_set(d[k], bn);
+    if (k > 1)
+      k--;
+  next:;
+  }
+#undef LAM
+  mpz_clears(u, lhs, rhs, q, tmp, bn, NULL);
+  for (size_t i = 0; i < nn * nn; i++)
+    mpz_clear(lam[i]);
+  for (size_t i = 0; i <= nn; i++)
+    mpz_clear(d[i]);
+  free(lam);
+  free(d);
+  return ok;
+}
+
+/* Full reduction: L^2 first, integral LLL when long double runs out. */
+static bool rt_lll_reduce(rt_lll_t *c, bool exact_only) {
+  int64_t bits = rt_lll_max_bits(c);
+  c->swap_cap = INT64_C(16) * c->n * c->n * (bits + 16) + 1024;
+  int rc = exact_only ? -1 : rt_lll_run(c, 0);
+  if (rc == 1)
+    return true;
+  c->core = RT_LLL_CORE_EXACT;
+  return rt_lll_exact(c);
+}
+
+static int64_t rt_lll_rows_out(rt_lll_t *c, bool transform) {
+  int cols = transform ? c->tc : c->m;
+  int64_t *rows = (int64_t *)calloc((size_t)c->rows, sizeof(int64_t));
+  int64_t *vals = (int64_t *)calloc((size_t)cols, sizeof(int64_t));
+  int64_t out = 0;
+  if (!rows || !vals)
+    goto done;
+  for (int p = 0; p < c->rows; p++) {
+    int id = c->pos[p];
+    for (int j = 0; j < cols; j++)
+      vals[j] = rt_lll_box_mpz(transform ? RT_LLL_U(c, id, j) : RT_LLL_B(c, id, j));
+    rows[p] = rt_lll_list_of(vals, cols);
+    if (!rows[p])
+      goto done;
+  }
+  out = rt_lll_list_of(rows, c->rows);
+done:
+  free(rows);
+  free(vals);
+  return out;
+}
+
+static int64_t rt_lll_state_out(rt_lll_t *c, bool ok, int64_t extra_a, int64_t extra_b) {
+  int64_t items[9];
+  items[0] = rt_lll_rows_out(c, false);
+  items[1] = c->tc ? rt_lll_rows_out(c, true) : 0;
+  if (!items[0])
+    return 0;
+  items[2] = rt_tag_v(c->steps + c->swaps);
+  items[3] = ok ? NY_IMM_TRUE : NY_IMM_FALSE;
+  items[4] = rt_tag_v(c->core);
+  items[5] = rt_tag_v(c->core == RT_LLL_CORE_FP ? LDBL_DIG : 0);
+  items[6] = rt_tag_v(extra_a);
+  items[7] = rt_tag_v(extra_b);
+  items[8] = rt_tag_v(c->rows - c->n);
+  return rt_lll_list_of(items, 9);
+}
+
+/*
+ * Returns [rows, transform|nil, steps, ok, core, precision_digits,
+ * deep_insertions, insertion_distance, zero_rows] or nil when the input is not
+ * a rectangular list of integer rows.
+ */
+int64_t rt_lll_fp(int64_t rows_v, int64_t delta_v, int64_t eta_v, int64_t depth_v,
+                  int64_t flags_v) {
+  int64_t flags = rt_lll_int_arg(flags_v);
+  rt_lll_t c;
+  if (!rt_lll_load(&c, rows_v, (flags & 1) != 0, 0)) {
+    rt_lll_free(&c);
+    return 0;
+  }
+  rt_lll_params(&c, delta_v, eta_v);
+  int64_t depth = rt_lll_int_arg(depth_v);
+  c.depth = depth < 0 ? 0 : (depth > c.n ? c.n : (int)depth);
+  bool ok = rt_lll_reduce(&c, (flags & 2) != 0);
+  int64_t out = ok ? rt_lll_state_out(&c, true, c.deep, c.deep_distance) : 0;
+  rt_lll_free(&c);
+  return out;
+}
+
+/*
+ * Schnorr-Euchner enumeration over positions [k, k + d). On success writes the
+ * integer coefficients of a vector whose projection is shorter than
+ * max(delta, 0.99) * r_kk and returns true.
+ */
+static bool rt_lll_enum(rt_lll_t *c, int k, int d, int64_t max_nodes, int64_t *nodes_used,
+                        int64_t *best) {
+  rt_lll_real *ctr = (rt_lll_real *)calloc((size_t)d, sizeof(rt_lll_real));
+  rt_lll_real *rho = (rt_lll_real *)calloc((size_t)d + 1, sizeof(rt_lll_real));
+  int64_t *x = (int64_t *)calloc((size_t)d, sizeof(int64_t));
+  int64_t *w = (int64_t *)calloc((size_t)d, sizeof(int64_t));
+  bool found = false;
+  if (!ctr || !rho || !x || !w)
+    goto done;
+  rt_lll_real radius = (c->delta > RT_LLL_BKZ_GAIN ? c->delta : RT_LLL_BKZ_GAIN) * RT_LLL_R(c, k, k);
+  int last_nonzero = 0;
+  int lvl = 0;
+  int64_t nodes = 0;
+  x[0] = 1;
+  for (;;) {
+    rt_lll_real diff = (rt_lll_real)x[lvl] - ctr[lvl];
+    rho[lvl] = rho[lvl + 1] + diff * diff * RT_LLL_R(c, k + lvl, k + lvl);
+    if (++nodes > max_nodes)
+      break;
+    if (rho[lvl] < radius) {
+      if (lvl == 0) {
+        radius = rho[0];
+        memcpy(best, x, (size_t)d * sizeof(int64_t));
+        found = true;
+      } else {
+        lvl--;
+        rt_lll_real cc = 0.0L;
+        for (int i = lvl + 1; i < d; i++)
+          cc -= (rt_lll_real)x[i] * RT_LLL_MU(c, k + i, k + lvl);
+        if (!(fabsl(cc) < RT_LLL_ENUM_COEFF_MAX))
+          break;
+        ctr[lvl] = cc;
+        x[lvl] = (int64_t)rintl(cc);
+        w[lvl] = 1;
+        continue;
+      }
+    } else {
+      if (++lvl >= d)
+        break;
+    }
+    /* Next sibling: zig-zag around the center, one direction on the top row. */
+    if (lvl >= last_nonzero) {
+      last_nonzero = lvl;
+      x[lvl]++;
+    } else {
+      if ((rt_lll_real)x[lvl] > ctr[lvl])
+        x[lvl] -= w[lvl];
+      else
+        x[lvl] += w[lvl];
+      w[lvl]++;
+    }
+  }
+  *nodes_used += nodes;
+done:
+  free(ctr);
+  free(rho);
+  free(x);
+  free(w);
+  return found;
+}
+
+/* Inserts sum(v_i * b[k + i]) at position k using the spare id. */
+static void rt_lll_insert(rt_lll_t *c, int k, int d, const int64_t *v) {
+  int spare = c->pos[c->rows];
+  for (int j = 0; j < c->m; j++)
+    mpz_set_ui(RT_LLL_B(c, spare, j), 0);
+  for (int j = 0; j < c->tc; j++)
+    mpz_set_ui(RT_LLL_U(c, spare, j), 0);
+  for (int p = 0; p < c->rows; p++)
+    mpz_set_ui(rt_lll_g(c, spare, c->pos[p]), 0);
+  mpz_set_ui(rt_lll_g(c, spare, spare), 0);
+  for (int i = 0; i < d; i++) {
+    if (!v[i])
+      continue;
+    int id = c->pos[k + i];
+    _bi_mpz_set_i64(c->x, v[i]);
+    for (int j = 0; j < c->m; j++)
+      mpz_addmul(RT_LLL_B(c, spare, j), RT_LLL_B(c, id, j), c->x);
+    for (int j = 0; j < c->tc; j++)
+      mpz_addmul(RT_LLL_U(c, spare, j), RT_LLL_U(c, id, j), c->x);
+    for (int p = 0; p < c->rows; p++)
+      mpz_addmul(rt_lll_g(c, spare, c->pos[p]), rt_lll_g(c, id, c->pos[p]), c->x);
+  }
+  for (int i = 0; i < d; i++)
+    if (v[i]) {
+      _bi_mpz_set_i64(c->x, v[i]);
+      mpz_addmul(rt_lll_g(c, spare, spare), rt_lll_g(c, spare, c->pos[k + i]), c->x);
+    }
+  /* Shift active and zero rows up by one and place the new row at k. */
+  rt_lll_move(c, c->rows, k);
+  c->rows++;
+  c->n++;
+}
+
+/*
+ * BKZ with Schnorr-Euchner enumeration. Returns the same state layout as
+ * __lll_fp with [tours, enumeration nodes] in the deep-insertion slots, or nil
+ * when the basis is not an integer matrix of independent rows.
+ */
+int64_t rt_bkz_fp(int64_t rows_v, int64_t block_v, int64_t delta_v, int64_t tours_v,
+                  int64_t nodes_v) {
+  rt_lll_t c;
+  if (!rt_lll_load(&c, rows_v, false, 1)) {
+    rt_lll_free(&c);
+    return 0;
+  }
+  c.pos[c.rows] = c.rows;
+  rt_lll_params(&c, delta_v, rt_lll_box_f64(0.51));
+  int64_t block = rt_lll_int_arg(block_v);
+  int64_t max_tours = rt_lll_int_arg(tours_v);
+  int64_t max_nodes = rt_lll_int_arg(nodes_v);
+  if (block < 2)
+    block = 2;
+  if (max_tours <= 0)
+    max_tours = 64;
+  if (max_nodes <= 0)
+    max_nodes = INT64_C(1) << 22;
+  int64_t bits = rt_lll_max_bits(&c);
+  c.swap_cap = INT64_C(16) * c.n * c.n * (bits + 16) + 1024;
+  if (rt_lll_run(&c, 0) != 1 || c.n != c.rows) {
+    rt_lll_free(&c);
+    return 0;
+  }
+  int n = c.n;
+  int64_t *coeffs = (int64_t *)calloc((size_t)n, sizeof(int64_t));
+  int64_t tours = 0;
+  int64_t nodes = 0;
+  bool ok = coeffs != NULL;
+  while (ok && tours < max_tours) {
+    bool changed = false;
+    tours++;
+    for (int k = 0; k + 1 < n && ok; k++) {
+      int d = (int)(k + block < n ? block : n - k);
+      if (!rt_lll_enum(&c, k, d, max_nodes, &nodes, coeffs))
+        continue;
+      int nonzero = 0;
+      for (int i = 0; i < d; i++)
+        nonzero += coeffs[i] != 0;
+      if (nonzero == 1 && (coeffs[0] == 1 || coeffs[0] == -1))
+        continue;
+      rt_lll_insert(&c, k, d, coeffs);
+      c.swap_cap = c.swaps + INT64_C(16) * n * n * (bits + 16) + 1024;
+      if (rt_lll_run(&c, k) != 1 || c.n != n) {
+        ok = false;
+        break;
+      }
+      /* The dependency left exactly one zero row behind the active ones. */
+      c.rows--;
+      changed = true;
+    }
+    if (!changed)
+      break;
+  }
+  free(coeffs);
+  int64_t out = ok ? rt_lll_state_out(&c, true, tours, nodes) : 0;
+  rt_lll_free(&c);
+  return out;
+}
+
+/*
+ * Quality check for integer bases of any size: GSO in long double from the
+ * exact Gram matrix. Returns [profile, mu rows, max_mu, size_reduced, lovasz,
+ * zero_rows] or nil for non-integer input.
+ */
+int64_t rt_lll_gso_check(int64_t rows_v, int64_t delta_v, int64_t eta_v) {
+  rt_lll_t c;
+  if (!rt_lll_load(&c, rows_v, false, 0)) {
+    rt_lll_free(&c);
+    return 0;
+  }
+  double delta = rt_lll_num_arg(delta_v, 0.75);
+  double eta = rt_lll_num_arg(eta_v, 0.51);
+  int n = c.n;
+  int64_t *prof = (int64_t *)calloc((size_t)n, sizeof(int64_t));
+  int64_t *mus = (int64_t *)calloc((size_t)n, sizeof(int64_t));
+  int64_t *vals = (int64_t *)calloc((size_t)n, sizeof(int64_t));
+  int64_t out = 0;
+  if (!prof || !mus || !vals)
+    goto done;
+  double max_mu = 0.0;
+  bool size_reduced = true;
+  bool lovasz = true;
+  int zero_rows = 0;
+  for (int i = 0; i < n; i++) {
+    if (!rt_lll_gso_row(&c, i))
+      goto done;
+    rt_lll_real ri = RT_LLL_R(&c, i, i);
+    if (!(ri > 0.0L)) {
+      /* Dependent row: keep the later divisions finite. */
+      zero_rows++;
+      RT_LLL_R(&c, i, i) = ri = 0.0L;
+    }
+    for (int j = 0; j < i; j++) {
+      rt_lll_real mu = RT_LLL_MU(&c, i, j);
+      double a = fabs((double)mu);
+      if (a > max_mu)
+        max_mu = a;
+      if (a > eta)
+        size_reduced = false;
+      vals[j] = rt_lll_box_f64((double)mu);
+    }
+    vals[i] = rt_lll_box_f64(1.0);
+    mus[i] = rt_lll_list_of(vals, i + 1);
+    prof[i] = rt_lll_box_f64((double)ldexpl(ri, (int)c.scale));
+    if (i > 0) {
+      rt_lll_real mp = RT_LLL_MU(&c, i, i - 1);
+      if (ri < ((rt_lll_real)delta - mp * mp) * RT_LLL_R(&c, i - 1, i - 1))
+        lovasz = false;
+    }
+  }
+  int64_t items[6];
+  items[0] = rt_lll_list_of(prof, n);
+  items[1] = rt_lll_list_of(mus, n);
+  items[2] = rt_lll_box_f64(max_mu);
+  items[3] = size_reduced ? NY_IMM_TRUE : NY_IMM_FALSE;
+  items[4] = lovasz ? NY_IMM_TRUE : NY_IMM_FALSE;
+  items[5] = rt_tag_v(zero_rows);
+  out = rt_lll_list_of(items, 6);
+done:
+  free(prof);
+  free(mus);
+  free(vals);
+  rt_lll_free(&c);
+  return out;
+}
@@ -18,11 +18,8 @@ static inline double get_flt(int64_t v) {
   if (v == 0)
     return 0.0;
 
-  if (is_v_flt(v)) {
-    double d;
-    memcpy(&d, (const void *)(uintptr_t)v, 8);
-    return d;
-  }
+  if (is_v_flt(v))
+    return rt_flt_payload(v);
 
   if (!is_ptr(v)) {
     double d;
@@ -362,7 +359,7 @@ static void *rt_flt_alloc_slot(void) {
 }
 
 void rt_flt_free(int64_t v) {
-  if (!v)
+  if (!v || ny_value_is_flt_imm((uint64_t)v))
     return;
   rt_float_cache_forget((uintptr_t)v);
   void *slot = (void *)((char *)(uintptr_t)v - 8);
@@ -371,6 +368,9 @@ void rt_flt_free(int64_t v) {
 }
 
 int64_t rt_flt_box_val(int64_t bits) {
+  uint64_t imm = 0;
+  if (ny_value_flt_imm_encode((uint64_t)bits, &imm))
+    return (int64_t)imm;
   void *slot = rt_flt_alloc_slot();
   if (!slot)
     return 0;
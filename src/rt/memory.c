@@ -292,6 +292,8 @@ static int64_t rt_free_direct(int64_t ptr) {
   } else if (is_v_flt(ptr)) {
     rt_flt_free(ptr);
     return 1;
+  } else if (rt_fs_view_release(ptr)) {
+    return 1;
   }
   return 0;
 }
@@ -338,7 +340,7 @@ int64_t rt_release_owned(int64_t ptr) {
   if (!is_heap_ptr(ptr)) {
     if (is_v_flt(ptr))
       return rt_free(ptr);
-    return 0;
+    return rt_fs_view_release(ptr) ? 1 : 0;
   }
   uintptr_t p = (uintptr_t)ptr;
   bool should_free = false;
@@ -0,0 +1,849 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <gmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Fixed-width modular contexts for std.math.nt (mod_ctx_new(..., "native")).
+ *
+ * A context owns a modulus of up to RT_MOD_MAX_LIMBS limbs together with its
+ * reduction constants: -m^-1 mod 2^64 and R^2 mod m for odd moduli
+ * (Montgomery), floor(B^2k / m) for even ones (Barrett). Operands are kept as
+ * limb arrays on the stack for the whole operation, so a batch, a
+ * constant-time powmod or an elliptic-curve scalar multiplication allocates
+ * only its boxed results. Variable-time powmod goes to mpz_powm, whose
+ * sliding-window Montgomery loop is already faster than a per-call kernel.
+ */
+
+extern void _bi_val_to_mpz(int64_t v, mpz_t result);
+extern int64_t _bi_from_mpz(const mpz_t val);
+extern int64_t rt_list_new(int64_t n);
+
+#define RT_MOD_MAGIC UINT64_C(0x4e594d4f44435458)
+#define RT_MOD_MAX_LIMBS 64
+#define RT_MOD_CT_WINDOW 4
+#define RT_MOD_CIOS_LIMBS 8
+
+enum {
+  RT_MOD_MONT = 0,
+  RT_MOD_BARRETT = 1,
+};
+
+enum {
+  RT_MOD_BATCH_MUL = 0,
+  RT_MOD_BATCH_POW = 1,
+  RT_MOD_BATCH_INV = 2,
+};
+
+enum {
+  RT_MOD_FLAG_CT = 1,
+};
+
+typedef struct rt_mod {
+  uint64_t magic;
+  int32_t nl;
+  int32_t kind;
+  mp_limb_t ninv;
+  mp_bitcnt_t bits;
+  mp_limb_t m[RT_MOD_MAX_LIMBS];
+  mp_limb_t one[RT_MOD_MAX_LIMBS]; /* 1 in the working domain */
+  mp_limb_t r2[RT_MOD_MAX_LIMBS];  /* R^2 mod m (Montgomery) */
+  mp_limb_t mu[RT_MOD_MAX_LIMBS + 2];
+  int32_t mu_n;
+  mpz_t mz;
+} rt_mod_t;
+
+typedef mp_limb_t rt_mod_el[RT_MOD_MAX_LIMBS];
+
+static inline int64_t rt_mod_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static rt_mod_t *rt_mod_handle(int64_t v) {
+  if (!is_ptr(v))
+    return NULL;
+  uintptr_t p = (uintptr_t)v;
+  if (!rt_addr_readable_safe(p, sizeof(uint64_t)))
+    return NULL;
+  rt_mod_t *c = (rt_mod_t *)p;
+  return c->magic == RT_MOD_MAGIC ? c : NULL;
+}
+
+static bool rt_mod_is_num(int64_t v) {
+  if (is_int(v))
+    return true;
+  return is_ptr(v) && is_heap_ptr(v) && *(int64_t *)((char *)(uintptr_t)v - 8) == TAG_BIGINT;
+}
+
+static inline bool rt_mod_is_seq(int64_t v) {
+  if (!is_ptr(v) || !is_heap_ptr(v))
+    return false;
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)v - 8);
+  return tag == TAG_LIST || tag == TAG_TUPLE;
+}
+
+static inline int64_t rt_mod_seq_len(int64_t v) { return rt_untag_v(*(int64_t *)(uintptr_t)v); }
+
+static inline int64_t rt_mod_seq_at(int64_t v, int64_t i) {
+  return *(int64_t *)((char *)(uintptr_t)v + 16 + i * 8);
+}
+
+static int64_t rt_mod_list(int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (lst)
+    *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+static inline void rt_mod_list_set(int64_t lst, int64_t i, int64_t v) {
+  *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = v;
+}
+
+/* ---- reduction kernels -------------------------------------------------- */
+
+/* r = t * R^-1 mod m for t < m * R; t (2nl limbs) is clobbered. */
+static void rt_mod_redc(const rt_mod_t *c, mp_limb_t *r, mp_limb_t *t) {
+  int nl = c->nl;
+  mp_limb_t *up = t;
+  for (int i = 0; i < nl; i++) {
+    mp_limb_t q = up[0] * c->ninv;
+    up[0] = mpn_addmul_1(up, c->m, nl, q);
+    up++;
+  }
+  mp_limb_t cy = mpn_add_n(r, up, t, nl);
+  if (cy || mpn_cmp(r, c->m, nl) >= 0)
+    mpn_sub_n(r, r, c->m, nl);
+}
+
+/* Same as rt_mod_redc without a data-dependent final subtraction. */
+static void rt_mod_redc_ct(const rt_mod_t *c, mp_limb_t *r, mp_limb_t *t) {
+  int nl = c->nl;
+  mp_limb_t *up = t;
+  for (int i = 0; i < nl; i++) {
+    mp_limb_t q = up[0] * c->ninv;
+    up[0] = mpn_addmul_1(up, c->m, nl, q);
+    up++;
+  }
+  mp_limb_t cy = mpn_add_n(r, up, t, nl);
+  mp_limb_t s[RT_MOD_MAX_LIMBS];
+  mp_limb_t bw = mpn_sub_n(s, r, c->m, nl);
+  mpn_cnd_swap(cy | (bw ^ 1), r, s, nl);
+}
+
+/* r = t mod m for t < m^2 (2nl limbs), HAC 14.42 with base 2^64. */
+static void rt_mod_barrett(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *t) {
+  int k = c->nl;
+  mp_limb_t q2[2 * RT_MOD_MAX_LIMBS + 4];
+  mp_limb_t qm[2 * RT_MOD_MAX_LIMBS + 4];
+  mp_limb_t rr[RT_MOD_MAX_LIMBS + 1];
+  const mp_limb_t *q1 = t + (k - 1); /* k + 1 limbs */
+  if (c->mu_n >= k + 1)
+    mpn_mul(q2, c->mu, c->mu_n, q1, k + 1);
+  else
+    mpn_mul(q2, q1, k + 1, c->mu, c->mu_n);
+  const mp_limb_t *q3 = q2 + (k + 1);
+  int q3n = c->mu_n;
+  while (q3n > 0 && q3[q3n - 1] == 0)
+    q3n--;
+  memset(qm, 0, (size_t)(k + 1) * sizeof(mp_limb_t));
+  if (q3n > 0) {
+    if (q3n >= k)
+      mpn_mul(qm, q3, q3n, c->m, k);
+    else
+      mpn_mul(qm, c->m, k, q3, q3n);
+  }
+  mpn_sub_n(rr, t, qm, k + 1);
+  while (rr[k] != 0 || mpn_cmp(rr, c->m, k) >= 0)
+    rr[k] -= mpn_sub_n(rr, rr, c->m, k);
+  memcpy(r, rr, (size_t)k * sizeof(mp_limb_t));
+}
+
+/*
+ * Interleaved Montgomery product (CIOS) for moduli of at most
+ * RT_MOD_CIOS_LIMBS limbs: no library calls, and with `ct` the final
+ * subtraction is a mask instead of a branch.
+ */
+static inline void rt_mod_cios_n(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b,
+                                 bool ct, const int nl) {
+  typedef unsigned __int128 u128;
+  const mp_limb_t *m = c->m;
+  mp_limb_t t[RT_MOD_CIOS_LIMBS + 2] = {0};
+  for (int i = 0; i < nl; i++) {
+    mp_limb_t bi = b[i];
+    u128 acc = 0;
+    for (int j = 0; j < nl; j++) {
+      acc = (u128)a[j] * bi + t[j] + (mp_limb_t)(acc >> 64);
+      t[j] = (mp_limb_t)acc;
+    }
+    acc = (u128)t[nl] + (mp_limb_t)(acc >> 64);
+    t[nl] = (mp_limb_t)acc;
+    t[nl + 1] = (mp_limb_t)(acc >> 64);
+    mp_limb_t q = t[0] * c->ninv;
+    acc = (u128)q * m[0] + t[0];
+    for (int j = 1; j < nl; j++) {
+      acc = (u128)q * m[j] + t[j] + (mp_limb_t)(acc >> 64);
+      t[j - 1] = (mp_limb_t)acc;
+    }
+    acc = (u128)t[nl] + (mp_limb_t)(acc >> 64);
+    t[nl - 1] = (mp_limb_t)acc;
+    t[nl] = t[nl + 1] + (mp_limb_t)(acc >> 64);
+  }
+  mp_limb_t s[RT_MOD_CIOS_LIMBS];
+  mp_limb_t bw = 0;
+  for (int j = 0; j < nl; j++) {
+    u128 d = (u128)t[j] - m[j] - bw;
+    s[j] = (mp_limb_t)d;
+    bw = (mp_limb_t)(d >> 64) & 1;
+  }
+  /* t < 2m: keep t - m unless it borrowed past the extra limb. */
+  mp_limb_t keep_t = bw & (t[nl] ^ 1);
+  if (ct) {
+    mp_limb_t mask = (mp_limb_t)0 - keep_t;
+    for (int j = 0; j < nl; j++)
+      r[j] = (t[j] & mask) | (s[j] & ~mask);
+  } else {
+    memcpy(r, keep_t ? t : s, (size_t)nl * sizeof(mp_limb_t));
+  }
+}
+
+/* Constant limb counts let the compiler unroll the CIOS loops. */
+static void rt_mod_cios(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b, bool ct) {
+  switch (c->nl) {
+  case 1:
+    rt_mod_cios_n(c, r, a, b, ct, 1);
+    break;
+  case 2:
+    rt_mod_cios_n(c, r, a, b, ct, 2);
+    break;
+  case 3:
+    rt_mod_cios_n(c, r, a, b, ct, 3);
+    break;
+  case 4:
+    rt_mod_cios_n(c, r, a, b, ct, 4);
+    break;
+  case 5:
+    rt_mod_cios_n(c, r, a, b, ct, 5);
+    break;
+  case 6:
+    rt_mod_cios_n(c, r, a, b, ct, 6);
+    break;
+  case 7:
+    rt_mod_cios_n(c, r, a, b, ct, 7);
+    break;
+  default:
+    rt_mod_cios_n(c, r, a, b, ct, RT_MOD_CIOS_LIMBS);
+    break;
+  }
+}
+
+static inline void rt_mod_mul(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  mp_limb_t t[2 * RT_MOD_MAX_LIMBS];
+  if (c->kind == RT_MOD_MONT && c->nl <= RT_MOD_CIOS_LIMBS) {
+    rt_mod_cios(c, r, a, b, false);
+    return;
+  }
+  if (a == b)
+    mpn_sqr(t, a, c->nl);
+  else
+    mpn_mul_n(t, a, b, c->nl);
+  if (c->kind == RT_MOD_MONT)
+    rt_mod_redc(c, r, t);
+  else
+    rt_mod_barrett(c, r, t);
+}
+
+static inline void rt_mod_mul_ct(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  mp_limb_t t[2 * RT_MOD_MAX_LIMBS];
+  if (c->nl <= RT_MOD_CIOS_LIMBS) {
+    rt_mod_cios(c, r, a, b, true);
+    return;
+  }
+  mpn_mul_n(t, a, b, c->nl);
+  rt_mod_redc_ct(c, r, t);
+}
+
+static inline void rt_mod_add(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  mp_limb_t cy = mpn_add_n(r, a, b, c->nl);
+  if (cy || mpn_cmp(r, c->m, c->nl) >= 0)
+    mpn_sub_n(r, r, c->m, c->nl);
+}
+
+static inline void rt_mod_sub(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b) {
+  if (mpn_sub_n(r, a, b, c->nl))
+    mpn_add_n(r, r, c->m, c->nl);
+}
+
+static inline bool rt_mod_is_zero(const rt_mod_t *c, const mp_limb_t *a) {
+  return mpn_zero_p(a, c->nl);
+}
+
+/* ---- domain conversion -------------------------------------------------- */
+
+static void rt_mod_limbs(const rt_mod_t *c, mp_limb_t *out, const mpz_t a) {
+  memset(out, 0, (size_t)c->nl * sizeof(mp_limb_t));
+  size_t n = mpz_size(a);
+  for (size_t i = 0; i < n; i++)
+    out[i] = mpz_getlimbn(a, (mp_size_t)i);
+}
+
+/* out = a in the working domain (a R mod m for Montgomery). */
+static void rt_mod_to(const rt_mod_t *c, mp_limb_t *out, const mpz_t a) {
+  mpz_t t;
+  mpz_init(t);
+  mpz_mod(t, a, c->mz);
+  rt_mod_limbs(c, out, t);
+  mpz_clear(t);
+  if (c->kind == RT_MOD_MONT)
+    rt_mod_mul(c, out, out, c->r2);
+}
+
+static void rt_mod_from(const rt_mod_t *c, mpz_t out, const mp_limb_t *a) {
+  mp_limb_t r[RT_MOD_MAX_LIMBS];
+  if (c->kind == RT_MOD_MONT) {
+    mp_limb_t t[2 * RT_MOD_MAX_LIMBS];
+    memcpy(t, a, (size_t)c->nl * sizeof(mp_limb_t));
+    memset(t + c->nl, 0, (size_t)c->nl * sizeof(mp_limb_t));
+    rt_mod_redc(c, r, t);
+    a = r;
+  }
+  mpz_import(out, (size_t)c->nl, -1, sizeof(mp_limb_t), 0, 0, a);
+}
+
+static int64_t rt_mod_box(const rt_mod_t *c, const mp_limb_t *a) {
+  mpz_t z;
+  mpz_init(z);
+  rt_mod_from(c, z, a);
+  int64_t r = _bi_from_mpz(z);
+  mpz_clear(z);
+  return r;
+}
+
+static bool rt_mod_init(rt_mod_t *c, const mpz_t m) {
+  size_t nl = mpz_size(m);
+  if (mpz_cmp_ui(m, 2) < 0 || nl > RT_MOD_MAX_LIMBS)
+    return false;
+  memset(c, 0, sizeof(*c));
+  c->nl = (int32_t)nl;
+  c->bits = mpz_sizeinbase(m, 2);
+  mpz_init_set(c->mz, m);
+  rt_mod_limbs(c, c->m, m);
+  mpz_t t;
+  mpz_init(t);
+  if (mpz_odd_p(m)) {
+    c->kind = RT_MOD_MONT;
+    mp_limb_t m0 = c->m[0];
+    mp_limb_t inv = m0; /* correct to 3 bits for odd m0 */
+    for (int i = 0; i < 6; i++)
+      inv *= 2 - m0 * inv;
+    c->ninv = (mp_limb_t)0 - inv;
+    mpz_set_ui(t, 1);
+    mpz_mul_2exp(t, t, (mp_bitcnt_t)nl * GMP_NUMB_BITS);
+    mpz_mod(t, t, m);
+    rt_mod_limbs(c, c->one, t);
+    mpz_set_ui(t, 1);
+    mpz_mul_2exp(t, t, (mp_bitcnt_t)nl * GMP_NUMB_BITS * 2);
+    mpz_mod(t, t, m);
+    rt_mod_limbs(c, c->r2, t);
+  } else {
+    c->kind = RT_MOD_BARRETT;
+    c->one[0] = 1;
+    mpz_set_ui(t, 1);
+    mpz_mul_2exp(t, t, (mp_bitcnt_t)nl * GMP_NUMB_BITS * 2);
+    mpz_fdiv_q(t, t, m);
+    c->mu_n = (int32_t)mpz_size(t);
+    for (size_t i = 0; i < mpz_size(t); i++)
+      c->mu[i] = mpz_getlimbn(t, (mp_size_t)i);
+  }
+  mpz_clear(t);
+  c->magic = RT_MOD_MAGIC;
+  return true;
+}
+
+/* ---- exponentiation ----------------------------------------------------- */
+
+/*
+ * r = b^e for odd moduli with a fixed 4-bit window: the exponent is padded to
+ * max(bits(e), bits(m)) rounded to the window, every window squares four
+ * times and multiplies by a table entry fetched with mpn_sec_tabselect, and
+ * REDC never branches on the data. Only the padded exponent length leaks.
+ */
+static bool rt_mod_pow_ct(const rt_mod_t *c, mp_limb_t *r, const mp_limb_t *b, const mpz_t e) {
+  int nl = c->nl;
+  enum { TN = 1 << RT_MOD_CT_WINDOW };
+  mp_limb_t *tab = (mp_limb_t *)malloc((size_t)TN * (size_t)nl * sizeof(mp_limb_t));
+  if (!tab)
+    return false;
+  memcpy(tab, c->one, (size_t)nl * sizeof(mp_limb_t));
+  memcpy(tab + nl, b, (size_t)nl * sizeof(mp_limb_t));
+  for (int i = 2; i < TN; i++)
+    rt_mod_mul_ct(c, tab + (size_t)i * nl, tab + (size_t)(i - 1) * nl, b);
+  mp_bitcnt_t ebits = mpz_sizeinbase(e, 2);
+  if (ebits < c->bits)
+    ebits = c->bits;
+  mp_bitcnt_t windows = (ebits + RT_MOD_CT_WINDOW - 1) / RT_MOD_CT_WINDOW;
+  size_t el = (size_t)((windows * RT_MOD_CT_WINDOW + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS) + 1;
+  mp_limb_t *ep = (mp_limb_t *)calloc(el, sizeof(mp_limb_t));
+  if (!ep) {
+    free(tab);
+    return false;
+  }
+  mpz_export(ep, NULL, -1, sizeof(mp_limb_t), 0, 0, e);
+  rt_mod_el acc, sel;
+  memcpy(acc, c->one, (size_t)nl * sizeof(mp_limb_t));
+  for (mp_bitcnt_t wi = windows; wi-- > 0;) {
+    for (int k = 0; k < RT_MOD_CT_WINDOW; k++)
+      rt_mod_mul_ct(c, acc, acc, acc);
+    mp_bitcnt_t pos = wi * RT_MOD_CT_WINDOW;
+    size_t li = (size_t)(pos / GMP_NUMB_BITS);
+    unsigned sh = (unsigned)(pos % GMP_NUMB_BITS);
+    mp_limb_t v = ep[li] >> sh;
+    if (sh + RT_MOD_CT_WINDOW > GMP_NUMB_BITS)
+      v |= ep[li + 1] << (GMP_NUMB_BITS - sh);
+    mpn_sec_tabselect(sel, tab, nl, TN, (mp_size_t)(v & (TN - 1)));
+    rt_mod_mul_ct(c, acc, acc, sel);
+  }
+  memcpy(r, acc, (size_t)nl * sizeof(mp_limb_t));
+  memset(ep, 0, el * sizeof(mp_limb_t));
+  free(ep);
+  free(tab);
+  return true;
+}
+
+/*
+ * out = b^e; a negative e inverts b first. The variable-time path is GMP's
+ * sliding-window Montgomery mpz_powm on the cached modulus, which measured
+ * ahead of the hand kernels at every width; `ct` runs rt_mod_pow_ct.
+ * Returns false if b is not a unit.
+ */
+static bool rt_mod_pow_val(const rt_mod_t *c, mpz_t out, int64_t base_v, const mpz_t e, bool ct) {
+  mpz_t b, ee;
+  _bi_val_to_mpz(base_v, b);
+  mpz_init_set(ee, e);
+  bool ok = true;
+  if (mpz_sgn(ee) < 0) {
+    ok = mpz_invert(b, b, c->mz) != 0;
+    mpz_neg(ee, ee);
+  }
+  if (ok && ct) {
+    rt_mod_el bd, r;
+    rt_mod_to(c, bd, b);
+    ok = rt_mod_pow_ct(c, r, bd, ee);
+    if (ok)
+      rt_mod_from(c, out, r);
+  } else if (ok) {
+    mpz_powm(out, b, ee, c->mz);
+  }
+  mpz_clears(b, ee, NULL);
+  return ok;
+}
+
+/* r = a * b mod m for plain operands: two REDCs instead of two conversions. */
+static void rt_mod_mul_plain(const rt_mod_t *c, mp_limb_t *r, const mpz_t a, const mpz_t b) {
+  rt_mod_el ad, bd;
+  mpz_t t;
+  mpz_init(t);
+  mpz_mod(t, a, c->mz);
+  rt_mod_limbs(c, ad, t);
+  mpz_mod(t, b, c->mz);
+  rt_mod_limbs(c, bd, t);
+  mpz_clear(t);
+  rt_mod_mul(c, r, ad, bd);
+  if (c->kind == RT_MOD_MONT)
+    rt_mod_mul(c, r, r, c->r2);
+}
+
+static int64_t rt_mod_box_plain(const rt_mod_t *c, const mp_limb_t *a) {
+  mpz_t z;
+  mpz_init(z);
+  mpz_import(z, (size_t)c->nl, -1, sizeof(mp_limb_t), 0, 0, a);
+  int64_t r = _bi_from_mpz(z);
+  mpz_clear(z);
+  return r;
+}
+
+/* ---- short Weierstrass curves ------------------------------------------- */
+
+typedef struct {
+  rt_mod_el x, y, z;
+} rt_mod_jac_t;
+
+static void rt_mod_jac_dbl(const rt_mod_t *c, rt_mod_jac_t *r, const rt_mod_jac_t *p, const mp_limb_t *a,
+                           bool a_zero) {
+  if (rt_mod_is_zero(c, p->z) || rt_mod_is_zero(c, p->y)) {
+    memset(r, 0, sizeof(*r));
+    return;
+  }
+  rt_mod_el ysq, s, m, t, x3;
+  rt_mod_mul(c, ysq, p->y, p->y);
+  rt_mod_mul(c, s, p->x, ysq);
+  rt_mod_add(c, s, s, s);
+  rt_mod_add(c, s, s, s);
+  rt_mod_mul(c, t, p->x, p->x);
+  rt_mod_add(c, m, t, t);
+  rt_mod_add(c, m, m, t);
+  if (!a_zero) {
+    rt_mod_mul(c, t, p->z, p->z);
+    rt_mod_mul(c, t, t, t);
+    rt_mod_mul(c, t, t, a);
+    rt_mod_add(c, m, m, t);
+  }
+  rt_mod_mul(c, x3, m, m);
+  rt_mod_sub(c, x3, x3, s);
+  rt_mod_sub(c, x3, x3, s);
+  rt_mod_mul(c, r->z, p->y, p->z);
+  rt_mod_add(c, r->z, r->z, r->z);
+  rt_mod_sub(c, t, s, x3);
+  rt_mod_mul(c, r->y, m, t);
+  rt_mod_mul(c, t, ysq, ysq);
+  rt_mod_add(c, t, t, t);
+  rt_mod_add(c, t, t, t);
+  rt_mod_add(c, t, t, t);
+  rt_mod_sub(c, r->y, r->y, t);
+  memcpy(r->x, x3, sizeof(x3));
+}
+
+static void rt_mod_jac_add(const rt_mod_t *c, rt_mod_jac_t *r, const rt_mod_jac_t *p, const rt_mod_jac_t *q,
+                           const mp_limb_t *a, bool a_zero) {
+  if (rt_mod_is_zero(c, p->z)) {
+    *r = *q;
+    return;
+  }
+  if (rt_mod_is_zero(c, q->z)) {
+    *r = *p;
+    return;
+  }
+  rt_mod_el z1sq, z2sq, u1, u2, s1, s2, h, rr, hsq, hcub, t;
+  rt_mod_mul(c, z1sq, p->z, p->z);
+  rt_mod_mul(c, z2sq, q->z, q->z);
+  rt_mod_mul(c, u1, p->x, z2sq);
+  rt_mod_mul(c, u2, q->x, z1sq);
+  rt_mod_mul(c, s1, p->y, q->z);
+  rt_mod_mul(c, s1, s1, z2sq);
+  rt_mod_mul(c, s2, q->y, p->z);
+  rt_mod_mul(c, s2, s2, z1sq);
+  if (mpn_cmp(u1, u2, c->nl) == 0) {
+    if (mpn_cmp(s1, s2, c->nl) != 0) {
+      memset(r, 0, sizeof(*r));
+      return;
+    }
+    rt_mod_jac_dbl(c, r, p, a, a_zero);
+    return;
+  }
+  rt_mod_sub(c, h, u2, u1);
+  rt_mod_sub(c, rr, s2, s1);
+  rt_mod_mul(c, hsq, h, h);
+  rt_mod_mul(c, hcub, h, hsq);
+  rt_mod_mul(c, u1, u1, hsq); /* U1 H^2 */
+  rt_mod_el x3;
+  rt_mod_mul(c, x3, rr, rr);
+  rt_mod_sub(c, x3, x3, hcub);
+  rt_mod_sub(c, x3, x3, u1);
+  rt_mod_sub(c, x3, x3, u1);
+  rt_mod_sub(c, t, u1, x3);
+  rt_mod_mul(c, t, rr, t);
+  rt_mod_mul(c, s1, s1, hcub);
+  rt_mod_sub(c, r->y, t, s1);
+  rt_mod_mul(c, r->z, h, p->z);
+  rt_mod_mul(c, r->z, r->z, q->z);
+  memcpy(r->x, x3, sizeof(x3));
+}
+
+/* ---- Builtins ----------------------------------------------------------- */
+
+int64_t rt_modctx_new(int64_t m_v) {
+  if (!rt_mod_is_num(m_v))
+    return 0;
+  mpz_t m;
+  _bi_val_to_mpz(m_v, m);
+  rt_mod_t *c = (rt_mod_t *)malloc(sizeof(rt_mod_t));
+  bool ok = c && rt_mod_init(c, m);
+  mpz_clear(m);
+  if (!ok) {
+    free(c);
+    return 0;
+  }
+  return (int64_t)(uintptr_t)c;
+}
+
+int64_t rt_modctx_free(int64_t ctx_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  if (c) {
+    c->magic = 0;
+    mpz_clear(c->mz);
+    free(c);
+  }
+  return 0;
+}
+
+int64_t rt_modctx_info(int64_t ctx_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  if (!c)
+    return 0;
+  int64_t out = rt_mod_list(3);
+  if (!out)
+    return 0;
+  rt_mod_list_set(out, 0, rt_tag_v((int64_t)c->bits));
+  rt_mod_list_set(out, 1, rt_tag_v(c->nl));
+  rt_mod_list_set(out, 2, rt_tag_v(c->kind));
+  return out;
+}
+
+int64_t rt_modctx_mul(int64_t ctx_v, int64_t a_v, int64_t b_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  if (!c || !rt_mod_is_num(a_v) || !rt_mod_is_num(b_v))
+    return 0;
+  mpz_t a, b;
+  _bi_val_to_mpz(a_v, a);
+  _bi_val_to_mpz(b_v, b);
+  rt_mod_el r;
+  rt_mod_mul_plain(c, r, a, b);
+  mpz_clears(a, b, NULL);
+  return rt_mod_box_plain(c, r);
+}
+
+int64_t rt_modctx_pow(int64_t ctx_v, int64_t base_v, int64_t exp_v, int64_t flags_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  int64_t flags = rt_mod_int_arg(flags_v);
+  if (!c || !rt_mod_is_num(base_v) || !rt_mod_is_num(exp_v))
+    return 0;
+  bool ct = (flags & RT_MOD_FLAG_CT) != 0;
+  if (ct && c->kind != RT_MOD_MONT)
+    return 0;
+  mpz_t e, r;
+  _bi_val_to_mpz(exp_v, e);
+  mpz_init(r);
+  bool ok = rt_mod_pow_val(c, r, base_v, e, ct);
+  int64_t out = ok ? _bi_from_mpz(r) : 0;
+  mpz_clears(e, r, NULL);
+  return out;
+}
+
+static void rt_mod_batch_mul(const rt_mod_t *c, int64_t out, int64_t xs_v, int64_t ys_v, bool ys_seq) {
+  int64_t n = rt_mod_seq_len(xs_v);
+  rt_mod_el yd, r;
+  mpz_t x, y;
+  if (!ys_seq) {
+    /* One shared operand in the working domain: a single REDC per product. */
+    _bi_val_to_mpz(ys_v, y);
+    rt_mod_to(c, yd, y);
+    mpz_clear(y);
+  }
+  for (int64_t i = 0; i < n; i++) {
+    _bi_val_to_mpz(rt_mod_seq_at(xs_v, i), x);
+    if (ys_seq) {
+      _bi_val_to_mpz(rt_mod_seq_at(ys_v, i), y);
+      rt_mod_mul_plain(c, r, x, y);
+      mpz_clear(y);
+    } else {
+      rt_mod_el xd;
+      mpz_mod(x, x, c->mz);
+      rt_mod_limbs(c, xd, x);
+      rt_mod_mul(c, r, xd, yd);
+    }
+    mpz_clear(x);
+    rt_mod_list_set(out, i, rt_mod_box_plain(c, r));
+  }
+}
+
+static void rt_mod_batch_pow(const rt_mod_t *c, int64_t out, int64_t xs_v, int64_t ys_v, bool ys_seq, bool ct) {
+  int64_t n = rt_mod_seq_len(xs_v);
+  mpz_t e, r;
+  mpz_init(r);
+  if (!ys_seq)
+    _bi_val_to_mpz(ys_v, e);
+  for (int64_t i = 0; i < n; i++) {
+    if (ys_seq)
+      _bi_val_to_mpz(rt_mod_seq_at(ys_v, i), e);
+    bool ok = rt_mod_pow_val(c, r, rt_mod_seq_at(xs_v, i), e, ct);
+    if (ys_seq)
+      mpz_clear(e);
+    rt_mod_list_set(out, i, ok ? _bi_from_mpz(r) : 0);
+  }
+  if (!ys_seq)
+    mpz_clear(e);
+  mpz_clear(r);
+}
+
+/* Montgomery's trick: one inversion for the whole list; non-units map to nil. */
+static bool rt_mod_batch_inv(const rt_mod_t *c, int64_t out, int64_t xs_v) {
+  int64_t n = rt_mod_seq_len(xs_v);
+  size_t cnt = (size_t)(n > 0 ? n : 1);
+  rt_mod_el *pre = (rt_mod_el *)malloc((cnt + 1) * sizeof(rt_mod_el));
+  rt_mod_el *val = (rt_mod_el *)malloc(cnt * sizeof(rt_mod_el));
+  bool *unit = (bool *)calloc(cnt, sizeof(bool));
+  if (!pre || !val || !unit) {
+    free(pre);
+    free(val);
+    free(unit);
+    return false;
+  }
+  mpz_t x, g;
+  mpz_init(g);
+  memcpy(pre[0], c->one, sizeof(rt_mod_el));
+  for (int64_t i = 0; i < n; i++) {
+    _bi_val_to_mpz(rt_mod_seq_at(xs_v, i), x);
+    mpz_mod(x, x, c->mz);
+    mpz_gcd(g, x, c->mz);
+    unit[i] = mpz_cmp_ui(g, 1) == 0;
+    if (unit[i])
+      rt_mod_to(c, val[i], x);
+    else
+      memcpy(val[i], c->one, sizeof(rt_mod_el));
+    rt_mod_mul(c, pre[i + 1], pre[i], val[i]);
+    mpz_clear(x);
+  }
+  mpz_init(x);
+  rt_mod_from(c, x, pre[n]);
+  mpz_invert(x, x, c->mz);
+  rt_mod_el inv, t;
+  rt_mod_to(c, inv, x);
+  for (int64_t i = n - 1; i >= 0; i--) {
+    rt_mod_mul(c, t, inv, pre[i]);
+    rt_mod_mul(c, inv, inv, val[i]);
+    rt_mod_list_set(out, i, unit[i] ? rt_mod_box(c, t) : 0);
+  }
+  mpz_clears(x, g, NULL);
+  free(unit);
+  free(pre);
+  free(val);
+  return true;
+}
+
+/*
+ * op 0: xs[i] * ys[i] (ys may be one shared operand); op 1: xs[i] ^ ys[i]
+ * (ys may be one shared exponent), flags bit0 selects the constant-time
+ * window; op 2: inverses of xs. Failed entries are nil.
+ */
+int64_t rt_modctx_batch(int64_t ctx_v, int64_t op_v, int64_t xs_v, int64_t ys_v, int64_t flags_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  int64_t op = rt_mod_int_arg(op_v);
+  int64_t flags = rt_mod_int_arg(flags_v);
+  if (!c || !rt_mod_is_seq(xs_v) || op < RT_MOD_BATCH_MUL || op > RT_MOD_BATCH_INV)
+    return 0;
+  int64_t n = rt_mod_seq_len(xs_v);
+  for (int64_t i = 0; i < n; i++)
+    if (!rt_mod_is_num(rt_mod_seq_at(xs_v, i)))
+      return 0;
+  bool ys_seq = rt_mod_is_seq(ys_v);
+  if (op != RT_MOD_BATCH_INV) {
+    if (ys_seq ? rt_mod_seq_len(ys_v) != n : !rt_mod_is_num(ys_v))
+      return 0;
+    for (int64_t i = 0; ys_seq && i < n; i++)
+      if (!rt_mod_is_num(rt_mod_seq_at(ys_v, i)))
+        return 0;
+  }
+  bool ct = (flags & RT_MOD_FLAG_CT) != 0;
+  if (op == RT_MOD_BATCH_POW && ct && c->kind != RT_MOD_MONT)
+    return 0;
+  int64_t out = rt_mod_list(n);
+  if (!out)
+    return 0;
+  if (op == RT_MOD_BATCH_MUL)
+    rt_mod_batch_mul(c, out, xs_v, ys_v, ys_seq);
+  else if (op == RT_MOD_BATCH_POW)
+    rt_mod_batch_pow(c, out, xs_v, ys_v, ys_seq, ct);
+  else if (!rt_mod_batch_inv(c, out, xs_v))
+    return 0;
+  return out;
+}
+
+/*
+ * k * [x, y] on y^2 = x^3 + a x + b over the context modulus, Jacobian
+ * coordinates in the working domain with a sliding window over odd
+ * multiples. Returns [x, y], nil for the point at infinity, or the Jacobian
+ * [X, Y, Z] when Z is not a unit mod a composite modulus. Variable time.
+ */
+int64_t rt_modctx_ec_mul(int64_t ctx_v, int64_t k_v, int64_t p_v, int64_t a_v) {
+  rt_mod_t *c = rt_mod_handle(ctx_v);
+  if (!c || !rt_mod_is_num(k_v) || !rt_mod_is_num(a_v) || !rt_mod_is_seq(p_v) ||
+      rt_mod_seq_len(p_v) < 2)
+    return 0;
+  int64_t px_v = rt_mod_seq_at(p_v, 0), py_v = rt_mod_seq_at(p_v, 1);
+  if (!rt_mod_is_num(px_v) || !rt_mod_is_num(py_v))
+    return 0;
+  mpz_t k, t;
+  _bi_val_to_mpz(k_v, k);
+  rt_mod_el a;
+  _bi_val_to_mpz(a_v, t);
+  mpz_mod(t, t, c->mz);
+  bool a_zero = mpz_sgn(t) == 0;
+  rt_mod_to(c, a, t);
+  mpz_clear(t);
+  rt_mod_jac_t base;
+  _bi_val_to_mpz(px_v, t);
+  rt_mod_to(c, base.x, t);
+  mpz_clear(t);
+  _bi_val_to_mpz(py_v, t);
+  if (mpz_sgn(k) < 0) {
+    mpz_neg(k, k);
+    mpz_neg(t, t);
+  }
+  rt_mod_to(c, base.y, t);
+  mpz_clear(t);
+  memcpy(base.z, c->one, sizeof(rt_mod_el));
+  rt_mod_jac_t acc;
+  memset(&acc, 0, sizeof(acc));
+  if (mpz_sgn(k) != 0) {
+    mp_bitcnt_t kbits = mpz_sizeinbase(k, 2);
+    int w = kbits > 239 ? 5 : kbits > 79 ? 4 : kbits > 23 ? 3 : 1;
+    int tn = 1 << (w - 1);
+    rt_mod_jac_t tab[16], twice;
+    tab[0] = base;
+    if (tn > 1) {
+      rt_mod_jac_dbl(c, &twice, &base, a, a_zero);
+      for (int i = 1; i < tn; i++)
+        rt_mod_jac_add(c, &tab[i], &tab[i - 1], &twice, a, a_zero);
+    }
+    long bit = (long)kbits - 1;
+    while (bit >= 0) {
+      if (!mpz_tstbit(k, (mp_bitcnt_t)bit)) {
+        rt_mod_jac_dbl(c, &acc, &acc, a, a_zero);
+        bit--;
+        continue;
+      }
+      long lo = bit - w + 1;
+      if (lo < 0)
+        lo = 0;
+      while (!mpz_tstbit(k, (mp_bitcnt_t)lo))
+        lo++;
+      unsigned val = 0;
+      for (long j = bit; j >= lo; j--) {
+        val = (val << 1) | (unsigned)mpz_tstbit(k, (mp_bitcnt_t)j);
+        rt_mod_jac_dbl(c, &acc, &acc, a, a_zero);
+      }
+      rt_mod_jac_add(c, &acc, &acc, &tab[val >> 1], a, a_zero);
+      bit = lo - 1;
+    }
+  }
+  mpz_clear(k);
+  if (rt_mod_is_zero(c, acc.z))
+    return 0;
+  mpz_t zi;
+  mpz_init(zi);
+  rt_mod_from(c, zi, acc.z);
+  int64_t out = 0;
+  if (mpz_invert(zi, zi, c->mz)) {
+    rt_mod_el zinv, z2, z3, rx, ry;
+    rt_mod_to(c, zinv, zi);
+    rt_mod_mul(c, z2, zinv, zinv);
+    rt_mod_mul(c, z3, z2, zinv);
+    rt_mod_mul(c, rx, acc.x, z2);
+    rt_mod_mul(c, ry, acc.y, z3);
+    out = rt_mod_list(2);
+    if (out) {
+      rt_mod_list_set(out, 0, rt_mod_box(c, rx));
+      rt_mod_list_set(out, 1, rt_mod_box(c, ry));
+    }
+  } else {
+    /* Composite modulus: hand back [X, Y, Z] so the caller sees gcd(Z, m). */
+    out = rt_mod_list(3);
+    if (out) {
+      rt_mod_list_set(out, 0, rt_mod_box(c, acc.x));
+      rt_mod_list_set(out, 1, rt_mod_box(c, acc.y));
+      rt_mod_list_set(out, 2, rt_mod_box(c, acc.z));
+    }
+  }
+  mpz_clear(zi);
+  return out;
+}
@@ -0,0 +1,1742 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Dense numeric arrays for std.math.ndarray.
+ *
+ * A handle owns a shape/stride view over a reference-counted, 64-byte aligned
+ * buffer, so slices, transposes and reshapes of contiguous data are zero-copy.
+ * Strides are counted in elements. Float GEMM follows the usual packed
+ * MC/KC/NC blocking with a register-tiled micro-kernel (AVX2+FMA or NEON when
+ * available, scalar otherwise) and can split row blocks across threads.
+ */
+
+#define RT_ND_MAGIC UINT64_C(0x4e59414e44415252)
+#define RT_ND_MAX_DIMS 8
+#define RT_ND_ALIGN 64
+
+enum { RT_ND_F64 = 0, RT_ND_F32 = 1, RT_ND_I64 = 2, RT_ND_I32 = 3 };
+
+enum {
+  RT_ND_OP_ADD = 0,
+  RT_ND_OP_SUB = 1,
+  RT_ND_OP_MUL = 2,
+  RT_ND_OP_DIV = 3,
+  RT_ND_OP_MIN = 4,
+  RT_ND_OP_MAX = 5,
+};
+
+enum {
+  RT_ND_UOP_NEG = 0,
+  RT_ND_UOP_ABS = 1,
+  RT_ND_UOP_SQRT = 2,
+  RT_ND_UOP_EXP = 3,
+  RT_ND_UOP_LOG = 4,
+};
+
+enum {
+  RT_ND_RED_SUM = 0,
+  RT_ND_RED_PROD = 1,
+  RT_ND_RED_MIN = 2,
+  RT_ND_RED_MAX = 3,
+};
+
+typedef struct rt_nd_buf {
+  int64_t refs;
+  size_t bytes;
+  void *data;
+} rt_nd_buf_t;
+
+typedef struct rt_nd {
+  uint64_t magic;
+  int32_t dtype;
+  int32_t ndim;
+  int64_t size;
+  int64_t offset;
+  int64_t shape[RT_ND_MAX_DIMS];
+  int64_t strides[RT_ND_MAX_DIMS];
+  rt_nd_buf_t *buf;
+} rt_nd_t;
+
+static int g_rt_nd_threads = -1;
+
+static inline size_t rt_nd_elem_size(int dtype) {
+  return (dtype == RT_ND_F32 || dtype == RT_ND_I32) ? 4u : 8u;
+}
+
+static inline bool rt_nd_dtype_is_float(int dtype) {
+  return dtype == RT_ND_F64 || dtype == RT_ND_F32;
+}
+
+static inline int64_t rt_nd_int_arg(int64_t v) { return is_int(v) ? rt_untag_v(v) : v; }
+
+static rt_nd_t *rt_nd_handle(int64_t v) {
+  if (!is_ptr(v))
+    return NULL;
+  uintptr_t p = (uintptr_t)v;
+  if (!rt_addr_readable_safe(p, sizeof(rt_nd_t)))
+    return NULL;
+  rt_nd_t *a = (rt_nd_t *)p;
+  if (a->magic != RT_ND_MAGIC || !a->buf)
+    return NULL;
+  return a;
+}
+
+static bool rt_nd_str_is(int64_t v, const char *lit) {
+  size_t n = rt_tagged_str_len(v);
+  size_t m = strlen(lit);
+  return n == m && memcmp((const void *)(uintptr_t)v, lit, n) == 0;
+}
+
+/* Accepts a dtype code or name; nil selects f64. Returns -1 when unknown. */
+static int rt_nd_dtype_arg(int64_t v) {
+  if (v == 0 || v == 1)
+    return RT_ND_F64;
+  if (is_int(v)) {
+    int64_t d = rt_untag_v(v);
+    return (d >= RT_ND_F64 && d <= RT_ND_I32) ? (int)d : -1;
+  }
+  if (!is_v_str(v))
+    return -1;
+  if (rt_nd_str_is(v, "f64") || rt_nd_str_is(v, "float64") || rt_nd_str_is(v, "float"))
+    return RT_ND_F64;
+  if (rt_nd_str_is(v, "f32") || rt_nd_str_is(v, "float32"))
+    return RT_ND_F32;
+  if (rt_nd_str_is(v, "i64") || rt_nd_str_is(v, "int64") || rt_nd_str_is(v, "int"))
+    return RT_ND_I64;
+  if (rt_nd_str_is(v, "i32") || rt_nd_str_is(v, "int32"))
+    return RT_ND_I32;
+  return -1;
+}
+
+static int rt_nd_promote(int a, int b) {
+  if (a == b)
+    return a;
+  if (rt_nd_dtype_is_float(a) || rt_nd_dtype_is_float(b)) {
+    if (a == RT_ND_F64 || b == RT_ND_F64 || a == RT_ND_I64 || b == RT_ND_I64)
+      return RT_ND_F64;
+    return RT_ND_F32;
+  }
+  return RT_ND_I64;
+}
+
+static rt_nd_buf_t *rt_nd_buf_new(size_t bytes, bool zero) {
+  rt_nd_buf_t *b = (rt_nd_buf_t *)calloc(1, sizeof(*b));
+  if (!b)
+    return NULL;
+  size_t cap = bytes ? (bytes + RT_ND_ALIGN - 1) & ~(size_t)(RT_ND_ALIGN - 1) : RT_ND_ALIGN;
+  b->data = ny_aligned_alloc(RT_ND_ALIGN, cap);
+  if (!b->data) {
+    free(b);
+    return NULL;
+  }
+  if (zero)
+    memset(b->data, 0, cap);
+  b->bytes = bytes;
+  b->refs = 1;
+  return b;
+}
+
+static void rt_nd_buf_retain(rt_nd_buf_t *b) { __atomic_add_fetch(&b->refs, 1, __ATOMIC_RELAXED); }
+
+static void rt_nd_buf_release(rt_nd_buf_t *b) {
+  if (!b)
+    return;
+  if (__atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+  ny_aligned_free(b->data);
+  free(b);
+}
+
+static void rt_nd_set_contiguous_strides(rt_nd_t *a) {
+  int64_t s = 1;
+  for (int d = a->ndim - 1; d >= 0; d--) {
+    a->strides[d] = s;
+    s *= a->shape[d] > 0 ? a->shape[d] : 1;
+  }
+}
+
+static bool rt_nd_shape_size(int ndim, const int64_t *shape, int64_t *out) {
+  int64_t n = 1;
+  for (int d = 0; d < ndim; d++) {
+    if (shape[d] < 0)
+      return false;
+    if (shape[d] && n > INT64_MAX / 16 / shape[d])
+      return false;
+    n *= shape[d];
+  }
+  *out = n;
+  return true;
+}
+
+static rt_nd_t *rt_nd_alloc(int dtype, int ndim, const int64_t *shape, bool zero) {
+  if (ndim < 0 || ndim > RT_ND_MAX_DIMS)
+    return NULL;
+  int64_t size = 0;
+  if (!rt_nd_shape_size(ndim, shape, &size))
+    return NULL;
+  rt_nd_t *a = (rt_nd_t *)calloc(1, sizeof(*a));
+  if (!a)
+    return NULL;
+  a->buf = rt_nd_buf_new((size_t)size * rt_nd_elem_size(dtype), zero);
+  if (!a->buf) {
+    free(a);
+    return NULL;
+  }
+  a->magic = RT_ND_MAGIC;
+  a->dtype = dtype;
+  a->ndim = ndim;
+  a->size = size;
+  for (int d = 0; d < ndim; d++)
+    a->shape[d] = shape[d];
+  rt_nd_set_contiguous_strides(a);
+  return a;
+}
+
+static rt_nd_t *rt_nd_view_of(const rt_nd_t *src) {
+  rt_nd_t *a = (rt_nd_t *)calloc(1, sizeof(*a));
+  if (!a)
+    return NULL;
+  *a = *src;
+  rt_nd_buf_retain(a->buf);
+  return a;
+}
+
+static void rt_nd_release(rt_nd_t *a) {
+  if (!a)
+    return;
+  a->magic = 0;
+  rt_nd_buf_release(a->buf);
+  a->buf = NULL;
+  free(a);
+}
+
+static inline int64_t rt_nd_ret(rt_nd_t *a) { return a ? (int64_t)(uintptr_t)a : 0; }
+
+static bool rt_nd_is_contiguous(const rt_nd_t *a) {
+  int64_t s = 1;
+  for (int d = a->ndim - 1; d >= 0; d--) {
+    if (a->shape[d] != 1 && a->strides[d] != s)
+      return false;
+    s *= a->shape[d];
+  }
+  return true;
+}
+
+static inline void *rt_nd_ptr(const rt_nd_t *a) {
+  return (char *)a->buf->data + a->offset * (int64_t)rt_nd_elem_size(a->dtype);
+}
+
+static inline double rt_nd_ld_f(const rt_nd_t *a, int64_t off) {
+  const void *p = a->buf->data;
+  switch (a->dtype) {
+  case RT_ND_F64:
+    return ((const double *)p)[off];
+  case RT_ND_F32:
+    return (double)((const float *)p)[off];
+  case RT_ND_I64:
+    return (double)((const int64_t *)p)[off];
+  default:
+    return (double)((const int32_t *)p)[off];
+  }
+}
+
+static inline int64_t rt_nd_ld_i(const rt_nd_t *a, int64_t off) {
+  const void *p = a->buf->data;
+  switch (a->dtype) {
+  case RT_ND_F64:
+    return (int64_t)((const double *)p)[off];
+  case RT_ND_F32:
+    return (int64_t)((const float *)p)[off];
+  case RT_ND_I64:
+    return ((const int64_t *)p)[off];
+  default:
+    return (int64_t)((const int32_t *)p)[off];
+  }
+}
+
+static inline void rt_nd_st_f(rt_nd_t *a, int64_t off, double v) {
+  void *p = a->buf->data;
+  switch (a->dtype) {
+  case RT_ND_F64:
+    ((double *)p)[off] = v;
+    break;
+  case RT_ND_F32:
+    ((float *)p)[off] = (float)v;
+    break;
+  case RT_ND_I64:
+    ((int64_t *)p)[off] = (int64_t)v;
+    break;
+  default:
+    ((int32_t *)p)[off] = (int32_t)v;
+    break;
+  }
+}
+
+static inline void rt_nd_st_i(rt_nd_t *a, int64_t off, int64_t v) {
+  void *p = a->buf->data;
+  switch (a->dtype) {
+  case RT_ND_F64:
+    ((double *)p)[off] = (double)v;
+    break;
+  case RT_ND_F32:
+    ((float *)p)[off] = (float)v;
+    break;
+  case RT_ND_I64:
+    ((int64_t *)p)[off] = v;
+    break;
+  default:
+    ((int32_t *)p)[off] = (int32_t)v;
+    break;
+  }
+}
+
+/* Row-major walk over a strided view; `off` is the element offset into the buffer. */
+typedef struct {
+  int64_t idx[RT_ND_MAX_DIMS];
+  int64_t off;
+} rt_nd_iter_t;
+
+static inline void rt_nd_iter_init(rt_nd_iter_t *it, const rt_nd_t *a) {
+  memset(it->idx, 0, sizeof(it->idx));
+  it->off = a->offset;
+}
+
+static inline void rt_nd_iter_next(rt_nd_iter_t *it, const rt_nd_t *a) {
+  for (int d = a->ndim - 1; d >= 0; d--) {
+    it->off += a->strides[d];
+    if (++it->idx[d] < a->shape[d])
+      return;
+    it->off -= a->strides[d] * a->shape[d];
+    it->idx[d] = 0;
+  }
+}
+
+static double rt_nd_value_f64(int64_t v) {
+  if (is_int(v))
+    return (double)rt_untag_v(v);
+  if (v == NY_IMM_TRUE)
+    return 1.0;
+  if (v == 0 || v == NY_IMM_FALSE)
+    return 0.0;
+  if (is_v_flt(v))
+    return rt_flt_payload(v);
+  if (is_ptr(v) && is_heap_ptr(v) &&
+      *(int64_t *)((char *)(uintptr_t)v - 8) == TAG_BIGINT) {
+    int64_t f = rt_bigint_to_f64(v);
+    double d;
+    memcpy(&d, (const void *)(uintptr_t)f, sizeof(d));
+    return d;
+  }
+  return 0.0;
+}
+
+static int64_t rt_nd_value_i64(int64_t v) {
+  if (is_int(v))
+    return rt_untag_v(v);
+  if (v == NY_IMM_TRUE)
+    return 1;
+  if (is_v_flt(v))
+    return (int64_t)rt_nd_value_f64(v);
+  if (is_ptr(v) && is_heap_ptr(v) &&
+      *(int64_t *)((char *)(uintptr_t)v - 8) == TAG_BIGINT)
+    return rt_untag_v(rt_bigint_to_int(v));
+  return 0;
+}
+
+static int64_t rt_nd_box_f64(double d) {
+  int64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return rt_flt_box_val(bits);
+}
+
+static int64_t rt_nd_box_i64(int64_t v) {
+  if (v >= -(INT64_C(1) << 61) && v < (INT64_C(1) << 61))
+    return rt_tag_v(v);
+  return _bi_from_i64(v);
+}
+
+static int64_t rt_nd_box_at(const rt_nd_t *a, int64_t off) {
+  if (rt_nd_dtype_is_float(a->dtype))
+    return rt_nd_box_f64(rt_nd_ld_f(a, off));
+  return rt_nd_box_i64(rt_nd_ld_i(a, off));
+}
+
+static bool rt_nd_is_seq(int64_t v) {
+  if (!is_ptr(v) || !is_heap_ptr(v))
+    return false;
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)v - 8);
+  return tag == TAG_LIST || tag == TAG_TUPLE;
+}
+
+static inline int64_t rt_nd_seq_len(int64_t v) {
+  return rt_nd_int_arg(*(int64_t *)(uintptr_t)v);
+}
+
+static inline int64_t rt_nd_seq_at(int64_t v, int64_t i) {
+  return *(int64_t *)((char *)(uintptr_t)v + 16 + i * 8);
+}
+
+static int64_t rt_nd_list_of(const int64_t *items, int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (!lst)
+    return 0;
+  for (int64_t i = 0; i < n; i++)
+    *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = items[i];
+  *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+/* Reads a shape from a list/tuple of ints or a single int. */
+static int rt_nd_shape_arg(int64_t v, int64_t *shape) {
+  if (is_int(v)) {
+    shape[0] = rt_untag_v(v);
+    return shape[0] >= 0 ? 1 : -1;
+  }
+  if (!rt_nd_is_seq(v))
+    return -1;
+  int64_t n = rt_nd_seq_len(v);
+  if (n > RT_ND_MAX_DIMS)
+    return -1;
+  for (int64_t i = 0; i < n; i++) {
+    int64_t s = rt_nd_seq_at(v, i);
+    if (!is_int(s) || rt_untag_v(s) < 0)
+      return -1;
+    shape[i] = rt_untag_v(s);
+  }
+  return (int)n;
+}
+
+/* Materializes `src` as a fresh contiguous array of `dtype`. */
+static rt_nd_t *rt_nd_copy_as(const rt_nd_t *src, int dtype) {
+  rt_nd_t *dst = rt_nd_alloc(dtype, src->ndim, src->shape, false);
+  if (!dst || !src->size)
+    return dst;
+  size_t esz = rt_nd_elem_size(dtype);
+  if (dtype == src->dtype && rt_nd_is_contiguous(src)) {
+    memcpy(dst->buf->data, rt_nd_ptr(src), (size_t)src->size * esz);
+    return dst;
+  }
+  if (dtype == src->dtype && src->ndim == 2) {
+    /* Tiled copy keeps both sides cache-friendly for transposed views. */
+    const int64_t tile = 32;
+    const char *sp = (const char *)src->buf->data;
+    char *dp = (char *)dst->buf->data;
+    int64_t rows = src->shape[0], cols = src->shape[1];
+    int64_t rs = src->strides[0], cs = src->strides[1];
+    for (int64_t i0 = 0; i0 < rows; i0 += tile) {
+      int64_t i1 = i0 + tile < rows ? i0 + tile : rows;
+      for (int64_t j0 = 0; j0 < cols; j0 += tile) {
+        int64_t j1 = j0 + tile < cols ? j0 + tile : cols;
+        for (int64_t i = i0; i < i1; i++) {
+          for (int64_t j = j0; j < j1; j++) {
+            int64_t so = src->offset + i * rs + j * cs;
+            memcpy(dp + (size_t)(i * cols + j) * esz, sp + (size_t)so * esz, esz);
+          }
+        }
+      }
+    }
+    return dst;
+  }
+  rt_nd_iter_t it;
+  rt_nd_iter_init(&it, src);
+  bool as_float = rt_nd_dtype_is_float(dtype) || rt_nd_dtype_is_float(src->dtype);
+  for (int64_t i = 0; i < src->size; i++) {
+    if (as_float)
+      rt_nd_st_f(dst, i, rt_nd_ld_f(src, it.off));
+    else
+      rt_nd_st_i(dst, i, rt_nd_ld_i(src, it.off));
+    rt_nd_iter_next(&it, src);
+  }
+  return dst;
+}
+
+static int rt_nd_thread_count(void) {
+  return rt_thread_count(&g_rt_nd_threads, "NYTRIX_ND_THREADS", 1, RT_MAX_THREADS);
+}
+
+/* ---- GEMM --------------------------------------------------------------- */
+
+#define RT_ND_GEMM_MC 96
+#define RT_ND_GEMM_KC 256
+#define RT_ND_GEMM_NC 2048
+#define RT_ND_DGEMM_MR 4
+#define RT_ND_DGEMM_NR 8
+#define RT_ND_SGEMM_MR 4
+#define RT_ND_SGEMM_NR 16
+#define RT_ND_GEMM_PAR_MIN_FLOPS (INT64_C(1) << 21)
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) &&           \
+    (defined(__GNUC__) || defined(__clang__))
+#define RT_ND_X86_DISPATCH 1
+#endif
+
+typedef void (*rt_nd_dgemm_ukr_fn)(int64_t kc, const double *ap, const double *bp, double *ab);
+typedef void (*rt_nd_sgemm_ukr_fn)(int64_t kc, const float *ap, const float *bp, float *ab);
+
+static void rt_nd_dgemm_ukr_scalar(int64_t kc, const double *ap, const double *bp, double *ab) {
+  double acc[RT_ND_DGEMM_MR * RT_ND_DGEMM_NR] = {0};
+  for (int64_t p = 0; p < kc; p++) {
+    for (int i = 0; i < RT_ND_DGEMM_MR; i++) {
+      double a = ap[i];
+      for (int j = 0; j < RT_ND_DGEMM_NR; j++)
+        acc[i * RT_ND_DGEMM_NR + j] += a * bp[j];
+    }
+    ap += RT_ND_DGEMM_MR;
+    bp += RT_ND_DGEMM_NR;
+  }
+  memcpy(ab, acc, sizeof(acc));
+}
+
+static void rt_nd_sgemm_ukr_scalar(int64_t kc, const float *ap, const float *bp, float *ab) {
+  float acc[RT_ND_SGEMM_MR * RT_ND_SGEMM_NR] = {0};
+  for (int64_t p = 0; p < kc; p++) {
+    for (int i = 0; i < RT_ND_SGEMM_MR; i++) {
+      float a = ap[i];
+      for (int j = 0; j < RT_ND_SGEMM_NR; j++)
+        acc[i * RT_ND_SGEMM_NR + j] += a * bp[j];
+    }
+    ap += RT_ND_SGEMM_MR;
+    bp += RT_ND_SGEMM_NR;
+  }
+  memcpy(ab, acc, sizeof(acc));
+}
+
+#if defined(RT_ND_X86_DISPATCH)
+__attribute__((target("avx2,fma"))) static void
+rt_nd_dgemm_ukr_avx2(int64_t kc, const double *ap, const double *bp, double *ab) {
+  __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+  __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+  __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+  __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+  for (int64_t p = 0; p < kc; p++) {
+    __m256d b0 = _mm256_load_pd(bp);
+    __m256d b1 = _mm256_load_pd(bp + 4);
+    __m256d a = _mm256_broadcast_sd(ap + 0);
+    c00 = _mm256_fmadd_pd(a, b0, c00);
+    c01 = _mm256_fmadd_pd(a, b1, c01);
+    a = _mm256_broadcast_sd(ap + 1);
+    c10 = _mm256_fmadd_pd(a, b0, c10);
+    c11 = _mm256_fmadd_pd(a, b1, c11);
+    a = _mm256_broadcast_sd(ap + 2);
+    c20 = _mm256_fmadd_pd(a, b0, c20);
+    c21 = _mm256_fmadd_pd(a, b1, c21);
+    a = _mm256_broadcast_sd(ap + 3);
+    c30 = _mm256_fmadd_pd(a, b0, c30);
+    c31 = _mm256_fmadd_pd(a, b1, c31);
+    ap += RT_ND_DGEMM_MR;
+    bp += RT_ND_DGEMM_NR;
+  }
+  _mm256_storeu_pd(ab + 0, c00);
+  _mm256_storeu_pd(ab + 4, c01);
+  _mm256_storeu_pd(ab + 8, c10);
+  _mm256_storeu_pd(ab + 12, c11);
+  _mm256_storeu_pd(ab + 16, c20);
+  _mm256_storeu_pd(ab + 20, c21);
+  _mm256_storeu_pd(ab + 24, c30);
+  _mm256_storeu_pd(ab + 28, c31);
+}
+
+__attribute__((target("avx2,fma"))) static void
+rt_nd_sgemm_ukr_avx2(int64_t kc, const float *ap, const float *bp, float *ab) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  for (int64_t p = 0; p < kc; p++) {
+    __m256 b0 = _mm256_load_ps(bp);
+    __m256 b1 = _mm256_load_ps(bp + 8);
+    __m256 a = _mm256_broadcast_ss(ap + 0);
+    c00 = _mm256_fmadd_ps(a, b0, c00);
+    c01 = _mm256_fmadd_ps(a, b1, c01);
+    a = _mm256_broadcast_ss(ap + 1);
+    c10 = _mm256_fmadd_ps(a, b0, c10);
+    c11 = _mm256_fmadd_ps(a, b1, c11);
+    a = _mm256_broadcast_ss(ap + 2);
+    c20 = _mm256_fmadd_ps(a, b0, c20);
+    c21 = _mm256_fmadd_ps(a, b1, c21);
+    a = _mm256_broadcast_ss(ap + 3);
+    c30 = _mm256_fmadd_ps(a, b0, c30);
+    c31 = _mm256_fmadd_ps(a, b1, c31);
+    ap += RT_ND_SGEMM_MR;
+    bp += RT_ND_SGEMM_NR;
+  }
+  _mm256_storeu_ps(ab + 0, c00);
+  _mm256_storeu_ps(ab + 8, c01);
+  _mm256_storeu_ps(ab + 16, c10);
+  _mm256_storeu_ps(ab + 24, c11);
+  _mm256_storeu_ps(ab + 32, c20);
+  _mm256_storeu_ps(ab + 40, c21);
+  _mm256_storeu_ps(ab + 48, c30);
+  _mm256_storeu_ps(ab + 56, c31);
+}
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+static void rt_nd_dgemm_ukr_neon(int64_t kc, const double *ap, const double *bp, double *ab) {
+  float64x2_t c[RT_ND_DGEMM_MR][4];
+  for (int i = 0; i < RT_ND_DGEMM_MR; i++)
+    for (int j = 0; j < 4; j++)
+      c[i][j] = vdupq_n_f64(0.0);
+  for (int64_t p = 0; p < kc; p++) {
+    float64x2_t b0 = vld1q_f64(bp), b1 = vld1q_f64(bp + 2);
+    float64x2_t b2 = vld1q_f64(bp + 4), b3 = vld1q_f64(bp + 6);
+    for (int i = 0; i < RT_ND_DGEMM_MR; i++) {
+      float64x2_t a = vdupq_n_f64(ap[i]);
+      c[i][0] = vfmaq_f64(c[i][0], a, b0);
+      c[i][1] = vfmaq_f64(c[i][1], a, b1);
+      c[i][2] = vfmaq_f64(c[i][2], a, b2);
+      c[i][3] = vfmaq_f64(c[i][3], a, b3);
+    }
+    ap += RT_ND_DGEMM_MR;
+    bp += RT_ND_DGEMM_NR;
+  }
+  for (int i = 0; i < RT_ND_DGEMM_MR; i++)
+    for (int j = 0; j < 4; j++)
+      vst1q_f64(ab + i * RT_ND_DGEMM_NR + j * 2, c[i][j]);
+}
+
+static void rt_nd_sgemm_ukr_neon(int64_t kc, const float *ap, const float *bp, float *ab) {
+  float32x4_t c[RT_ND_SGEMM_MR][4];
+  for (int i = 0; i < RT_ND_SGEMM_MR; i++)
+    for (int j = 0; j < 4; j++)
+      c[i][j] = vdupq_n_f32(0.0f);
+  for (int64_t p = 0; p < kc; p++) {
+    float32x4_t b0 = vld1q_f32(bp), b1 = vld1q_f32(bp + 4);
+    float32x4_t b2 = vld1q_f32(bp + 8), b3 = vld1q_f32(bp + 12);
+    for (int i = 0; i < RT_ND_SGEMM_MR; i++) {
+      float32x4_t a = vdupq_n_f32(ap[i]);
+      c[i][0] = vfmaq_f32(c[i][0], a, b0);
+      c[i][1] = vfmaq_f32(c[i][1], a, b1);
+      c[i][2] = vfmaq_f32(c[i][2], a, b2);
+      c[i][3] = vfmaq_f32(c[i][3], a, b3);
+    }
+    ap += RT_ND_SGEMM_MR;
+    bp += RT_ND_SGEMM_NR;
+  }
+  for (int i = 0; i < RT_ND_SGEMM_MR; i++)
+    for (int j = 0; j < 4; j++)
+      vst1q_f32(ab + i * RT_ND_SGEMM_NR + j * 4, c[i][j]);
+}
+#endif
+
+static rt_nd_dgemm_ukr_fn rt_nd_dgemm_ukr(void) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return rt_nd_dgemm_ukr_neon;
+#elif defined(RT_ND_X86_DISPATCH)
+  static int have = -1;
+  if (have < 0) {
+    __builtin_cpu_init();
+    have = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }
+  return have ? rt_nd_dgemm_ukr_avx2 : rt_nd_dgemm_ukr_scalar;
+#else
+  return rt_nd_dgemm_ukr_scalar;
+#endif
+}
+
+static rt_nd_sgemm_ukr_fn rt_nd_sgemm_ukr(void) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return rt_nd_sgemm_ukr_neon;
+#elif defined(RT_ND_X86_DISPATCH)
+  static int have = -1;
+  if (have < 0) {
+    __builtin_cpu_init();
+    have = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }
+  return have ? rt_nd_sgemm_ukr_avx2 : rt_nd_sgemm_ukr_scalar;
+#else
+  return rt_nd_sgemm_ukr_scalar;
+#endif
+}
+
+/*
+ * Instantiates the packed GEMM driver for one float type: C = alpha*A*B + beta*C
+ * over rows [m0, m1) of C, with arbitrary element strides on every operand.
+ */
+#define RT_ND_DEFINE_GEMM(P, T, MR, NR, UKR)                                                       \
+  static void rt_nd_##P##gemm_pack_a(int64_t mc, int64_t kc, T alpha, const T *a, int64_t rsa,     \
+                                     int64_t csa, T *ap) {                                         \
+    for (int64_t ir = 0; ir < mc; ir += MR) {                                                      \
+      int64_t mr = mc - ir < MR ? mc - ir : MR;                                                    \
+      for (int64_t p = 0; p < kc; p++) {                                                           \
+        const T *src = a + ir * rsa + p * csa;                                                     \
+        int64_t i = 0;                                                                             \
+        for (; i < mr; i++)                                                                        \
+          ap[i] = alpha * src[i * rsa];                                                            \
+        for (; i < MR; i++)                                                                        \
+          ap[i] = (T)0;                                                                            \
+        ap += MR;                                                                                  \
+      }                                                                                            \
+    }                                                                                              \
+  }                                                                                                \
+                                                                                                   \
+  static void rt_nd_##P##gemm_pack_b(int64_t kc, int64_t nc, const T *b, int64_t rsb, int64_t csb, \
+                                     T *bp) {                                                      \
+    for (int64_t jr = 0; jr < nc; jr += NR) {                                                      \
+      int64_t nr = nc - jr < NR ? nc - jr : NR;                                                    \
+      for (int64_t p = 0; p < kc; p++) {                                                           \
+        const T *src = b + p * rsb + jr * csb;                                                     \
+        int64_t j = 0;                                                                             \
+        if (csb == 1 && nr == NR) {                                                                \
+          memcpy(bp, src, sizeof(T) * NR);                                                         \
+        } else {                                                                                   \
+          for (; j < nr; j++)                                                                      \
+            bp[j] = src[j * csb];                                                                  \
+          for (; j < NR; j++)                                                                      \
+            bp[j] = (T)0;                                                                          \
+        }                                                                                          \
+        bp += NR;                                                                                  \
+      }                                                                                            \
+    }                                                                                              \
+  }                                                                                                \
+                                                                                                   \
+  static void rt_nd_##P##gemm_update(T *c, int64_t rsc, int64_t csc, const T *ab, int64_t mr,      \
+                                     int64_t nr, T beta) {                                         \
+    for (int64_t i = 0; i < mr; i++) {                                                             \
+      T *row = c + i * rsc;                                                                        \
+      const T *src = ab + i * NR;                                                                  \
+      if (beta == (T)0) {                                                                          \
+        for (int64_t j = 0; j < nr; j++)                                                           \
+          row[j * csc] = src[j];                                                                   \
+      } else if (beta == (T)1) {                                                                   \
+        for (int64_t j = 0; j < nr; j++)                                                           \
+          row[j * csc] += src[j];                                                                  \
+      } else {                                                                                     \
+        for (int64_t j = 0; j < nr; j++)                                                           \
+          row[j * csc] = beta * row[j * csc] + src[j];                                             \
+      }                                                                                            \
+    }                                                                                              \
+  }                                                                                                \
+                                                                                                   \
+  static bool rt_nd_##P##gemm_rows(rt_nd_##P##gemm_ukr_fn ukr, int64_t m0, int64_t m1, int64_t n,  \
+                                   int64_t k, T alpha, const T *a, int64_t rsa, int64_t csa,       \
+                                   const T *b, int64_t rsb, int64_t csb, T beta, T *c, int64_t rsc, \
+                                   int64_t csc) {                                                  \
+    if (k == 0 || alpha == (T)0) {                                                                 \
+      for (int64_t i = m0; i < m1; i++)                                                            \
+        for (int64_t j = 0; j < n; j++)                                                            \
+          c[i * rsc + j * csc] = beta == (T)0 ? (T)0 : beta * c[i * rsc + j * csc];                \
+      return true;                                                                                 \
+    }                                                                                              \
+    int64_t kcap = k < RT_ND_GEMM_KC ? k : RT_ND_GEMM_KC;                                          \
+    int64_t ncap = n < RT_ND_GEMM_NC ? n : RT_ND_GEMM_NC;                                          \
+    ncap = (ncap + NR - 1) / NR * NR;                                                              \
+    T *ap = (T *)ny_aligned_alloc(RT_ND_ALIGN, sizeof(T) * RT_ND_GEMM_MC * (size_t)kcap);          \
+    T *bp = (T *)ny_aligned_alloc(RT_ND_ALIGN, sizeof(T) * (size_t)ncap * (size_t)kcap);           \
+    if (!ap || !bp) {                                                                              \
+      ny_aligned_free(ap);                                                                         \
+      ny_aligned_free(bp);                                                                         \
+      return false;                                                                                \
+    }                                                                                              \
+    T ab[MR * NR] __attribute__((aligned(RT_ND_ALIGN)));                                           \
+    for (int64_t jc = 0; jc < n; jc += RT_ND_GEMM_NC) {                                            \
+      int64_t nc = n - jc < RT_ND_GEMM_NC ? n - jc : RT_ND_GEMM_NC;                                \
+      for (int64_t pc = 0; pc < k; pc += RT_ND_GEMM_KC) {                                          \
+        int64_t kc = k - pc < RT_ND_GEMM_KC ? k - pc : RT_ND_GEMM_KC;                              \
+        T beta_eff = pc == 0 ? beta : (T)1;                                                        \
+        rt_nd_##P##gemm_pack_b(kc, nc, b + pc * rsb + jc * csb, rsb, csb, bp);                     \
+        for (int64_t ic = m0; ic < m1; ic += RT_ND_GEMM_MC) {                                      \
+          int64_t mc = m1 - ic < RT_ND_GEMM_MC ? m1 - ic : RT_ND_GEMM_MC;                          \
+          rt_nd_##P##gemm_pack_a(mc, kc, alpha, a + ic * rsa + pc * csa, rsa, csa, ap);            \
+          for (int64_t jr = 0; jr < nc; jr += NR) {                                                \
+            int64_t nr = nc - jr < NR ? nc - jr : NR;                                              \
+            for (int64_t ir = 0; ir < mc; ir += MR) {                                              \
+              int64_t mr = mc - ir < MR ? mc - ir : MR;                                            \
+              ukr(kc, ap + ir * kc, bp + jr * kc, ab);                                             \
+              rt_nd_##P##gemm_update(c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc, ab, mr, nr,  \
+                                     beta_eff);                                                    \
+            }                                                                                      \
+          }                                                                                        \
+        }                                                                                          \
+      }                                                                                            \
+    }                                                                                              \
+    ny_aligned_free(ap);                                                                           \
+    ny_aligned_free(bp);                                                                           \
+    return true;                                                                                   \
+  }                                                                                                \
+                                                                                                   \
+  typedef struct {                                                                                 \
+    rt_nd_##P##gemm_ukr_fn ukr;                                                                    \
+    int64_t m0, m1, n, k, rsa, csa, rsb, csb, rsc, csc;                                            \
+    T alpha, beta;                                                                                 \
+    const T *a;                                                                                    \
+    const T *b;                                                                                    \
+    T *c;                                                                                          \
+    bool ok;                                                                                       \
+  } rt_nd_##P##gemm_task_t;                                                                        \
+                                                                                                   \
+  static void rt_nd_##P##gemm_task(void *arg) {                                                    \
+    rt_nd_##P##gemm_task_t *t = (rt_nd_##P##gemm_task_t *)arg;                                     \
+    t->ok = rt_nd_##P##gemm_rows(t->ukr, t->m0, t->m1, t->n, t->k, t->alpha, t->a, t->rsa, t->csa, \
+                                 t->b, t->rsb, t->csb, t->beta, t->c, t->rsc, t->csc);             \
+  }                                                                                                \
+                                                                                                   \
+  static bool rt_nd_##P##gemm(int64_t m, int64_t n, int64_t k, T alpha, const T *a, int64_t rsa,   \
+                              int64_t csa, const T *b, int64_t rsb, int64_t csb, T beta, T *c,     \
+                              int64_t rsc, int64_t csc) {                                          \
+    rt_nd_##P##gemm_ukr_fn ukr = UKR;                                                              \
+    int threads = rt_nd_thread_count();                                                            \
+    int64_t blocks = (m + MR - 1) / MR;                                                            \
+    if (threads > blocks)                                                                          \
+      threads = (int)blocks;                                                                       \
+    if (threads <= 1 || m * n * k < RT_ND_GEMM_PAR_MIN_FLOPS)                                      \
+      return rt_nd_##P##gemm_rows(ukr, 0, m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc,  \
+                                  csc);                                                            \
+    rt_nd_##P##gemm_task_t tasks[RT_MAX_THREADS];                                                  \
+    int64_t per = (blocks + threads - 1) / threads;                                                \
+    int used = 0;                                                                                  \
+    for (int t = 0; t < threads; t++) {                                                            \
+      int64_t r0 = (int64_t)t * per * MR;                                                          \
+      int64_t r1 = r0 + per * MR < m ? r0 + per * MR : m;                                          \
+      if (r0 >= m)                                                                                 \
+        break;                                                                                     \
+      tasks[used] = (rt_nd_##P##gemm_task_t){ukr, r0,   r1, n, k, rsa, csa, rsb, csb, rsc,       \
+                                             csc, alpha, beta, a, b, c, false};                    \
+      used++;                                                                                      \
+    }                                                                                              \
+    rt_parallel_run(rt_nd_##P##gemm_task, tasks, sizeof(tasks[0]), used);                          \
+    for (int t = 0; t < used; t++)                                                                 \
+      if (!tasks[t].ok)                                                                            \
+        return false;                                                                              \
+    return true;                                                                                   \
+  }
+
+RT_ND_DEFINE_GEMM(d, double, RT_ND_DGEMM_MR, RT_ND_DGEMM_NR, rt_nd_dgemm_ukr())
+RT_ND_DEFINE_GEMM(s, float, RT_ND_SGEMM_MR, RT_ND_SGEMM_NR, rt_nd_sgemm_ukr())
+
+#undef RT_ND_DEFINE_GEMM
+
+/* Integer products wrap modulo 2^64 like machine integers; k is blocked for cache reuse. */
+static void rt_nd_igemm(int64_t m, int64_t n, int64_t k, const int64_t *a, const int64_t *b,
+                        int64_t *c) {
+  memset(c, 0, sizeof(int64_t) * (size_t)(m * n));
+  const int64_t kb = 256;
+  for (int64_t p0 = 0; p0 < k; p0 += kb) {
+    int64_t p1 = p0 + kb < k ? p0 + kb : k;
+    for (int64_t i = 0; i < m; i++) {
+      uint64_t *crow = (uint64_t *)(c + i * n);
+      for (int64_t p = p0; p < p1; p++) {
+        uint64_t av = (uint64_t)a[i * k + p];
+        if (!av)
+          continue;
+        const uint64_t *brow = (const uint64_t *)(b + p * n);
+        for (int64_t j = 0; j < n; j++)
+          crow[j] += av * brow[j];
+      }
+    }
+  }
+}
+
+/* View of a 1-D or 2-D operand as a matrix (vectors become a row or a column). */
+static bool rt_nd_as_matrix(const rt_nd_t *a, bool as_row, int64_t *rows, int64_t *cols,
+                            int64_t *rs, int64_t *cs) {
+  if (a->ndim == 2) {
+    *rows = a->shape[0];
+    *cols = a->shape[1];
+    *rs = a->strides[0];
+    *cs = a->strides[1];
+    return true;
+  }
+  if (a->ndim != 1)
+    return false;
+  if (as_row) {
+    *rows = 1;
+    *cols = a->shape[0];
+    *rs = a->shape[0] * a->strides[0];
+    *cs = a->strides[0];
+  } else {
+    *rows = a->shape[0];
+    *cols = 1;
+    *rs = a->strides[0];
+    *cs = 1;
+  }
+  return true;
+}
+
+static bool rt_nd_gemm_into(double alpha, const rt_nd_t *a, const rt_nd_t *b, double beta,
+                            rt_nd_t *c) {
+  int64_t m, ka, rsa, csa, kb, n, rsb, csb, cm, cn, rsc, csc;
+  if (!rt_nd_as_matrix(a, true, &m, &ka, &rsa, &csa) ||
+      !rt_nd_as_matrix(b, false, &kb, &n, &rsb, &csb))
+    return false;
+  if (ka != kb)
+    return false;
+  if (c->ndim == 2) {
+    cm = c->shape[0];
+    cn = c->shape[1];
+    rsc = c->strides[0];
+    csc = c->strides[1];
+  } else if (c->ndim == 1 && (m == 1 || n == 1)) {
+    cm = m;
+    cn = n;
+    rsc = m == 1 ? c->shape[0] * c->strides[0] : c->strides[0];
+    csc = m == 1 ? c->strides[0] : 1;
+  } else {
+    return false;
+  }
+  if (cm != m || cn != n)
+    return false;
+  if (!m || !n)
+    return true;
+  int dt = c->dtype;
+  if (!rt_nd_dtype_is_float(dt))
+    return false;
+  rt_nd_t *ac = NULL, *bc = NULL;
+  if (a->dtype != dt) {
+    ac = rt_nd_copy_as(a, dt);
+    if (!ac)
+      return false;
+    a = ac;
+    rt_nd_as_matrix(a, true, &m, &ka, &rsa, &csa);
+  }
+  if (b->dtype != dt) {
+    bc = rt_nd_copy_as(b, dt);
+    if (!bc) {
+      rt_nd_release(ac);
+      return false;
+    }
+    b = bc;
+    rt_nd_as_matrix(b, false, &kb, &n, &rsb, &csb);
+  }
+  bool ok;
+  if (dt == RT_ND_F64)
+    ok = rt_nd_dgemm(m, n, ka, alpha, (const double *)rt_nd_ptr(a), rsa, csa,
+                     (const double *)rt_nd_ptr(b), rsb, csb, beta, (double *)rt_nd_ptr(c), rsc,
+                     csc);
+  else
+    ok = rt_nd_sgemm(m, n, ka, (float)alpha, (const float *)rt_nd_ptr(a), rsa, csa,
+                     (const float *)rt_nd_ptr(b), rsb, csb, (float)beta, (float *)rt_nd_ptr(c),
+                     rsc, csc);
+  rt_nd_release(ac);
+  rt_nd_release(bc);
+  return ok;
+}
+
+/* ---- Builtins ----------------------------------------------------------- */
+
+int64_t rt_nd_new(int64_t shape_v, int64_t dtype_v) {
+  int64_t shape[RT_ND_MAX_DIMS];
+  int nd = rt_nd_shape_arg(shape_v, shape);
+  int dt = rt_nd_dtype_arg(dtype_v);
+  if (nd < 0 || dt < 0)
+    return 0;
+  return rt_nd_ret(rt_nd_alloc(dt, nd, shape, true));
+}
+
+int64_t rt_nd_free(int64_t a_v) {
+  rt_nd_release(rt_nd_handle(a_v));
+  return 0;
+}
+
+int64_t rt_nd_is(int64_t a_v) { return rt_nd_handle(a_v) ? NY_IMM_TRUE : NY_IMM_FALSE; }
+
+static int rt_nd_fill_from(rt_nd_t *a, int64_t v, int depth, int64_t *pos) {
+  if (depth == a->ndim) {
+    if (rt_nd_dtype_is_float(a->dtype))
+      rt_nd_st_f(a, *pos, rt_nd_value_f64(v));
+    else
+      rt_nd_st_i(a, *pos, rt_nd_value_i64(v));
+    (*pos)++;
+    return 1;
+  }
+  if (!rt_nd_is_seq(v) || rt_nd_seq_len(v) != a->shape[depth])
+    return 0;
+  for (int64_t i = 0; i < a->shape[depth]; i++)
+    if (!rt_nd_fill_from(a, rt_nd_seq_at(v, i), depth + 1, pos))
+      return 0;
+  return 1;
+}
+
+int64_t rt_nd_from_list(int64_t data, int64_t dtype_v) {
+  int dt = rt_nd_dtype_arg(dtype_v);
+  if (dt < 0 || !rt_nd_is_seq(data))
+    return 0;
+  int64_t shape[RT_ND_MAX_DIMS];
+  int nd = 0;
+  int64_t v = data;
+  while (rt_nd_is_seq(v)) {
+    if (nd == RT_ND_MAX_DIMS)
+      return 0;
+    int64_t n = rt_nd_seq_len(v);
+    shape[nd++] = n;
+    if (!n)
+      break;
+    v = rt_nd_seq_at(v, 0);
+  }
+  rt_nd_t *a = rt_nd_alloc(dt, nd, shape, true);
+  if (!a)
+    return 0;
+  int64_t pos = 0;
+  if (a->size && !rt_nd_fill_from(a, data, 0, &pos)) {
+    rt_nd_release(a);
+    return 0;
+  }
+  return rt_nd_ret(a);
+}
+
+static int64_t rt_nd_to_list_rec(const rt_nd_t *a, int depth, int64_t off) {
+  if (depth == a->ndim)
+    return rt_nd_box_at(a, off);
+  int64_t n = a->shape[depth];
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (!lst)
+    return 0;
+  for (int64_t i = 0; i < n; i++) {
+    int64_t item = rt_nd_to_list_rec(a, depth + 1, off + i * a->strides[depth]);
+    *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = item;
+    *(int64_t *)(uintptr_t)lst = rt_tag_v(i + 1);
+  }
+  return lst;
+}
+
+int64_t rt_nd_to_list(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  return rt_nd_to_list_rec(a, 0, a->offset);
+}
+
+int64_t rt_nd_dtype(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  return a ? rt_tag_v(a->dtype) : rt_tag_v(-1);
+}
+
+int64_t rt_nd_ndim(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  return rt_tag_v(a ? a->ndim : 0);
+}
+
+int64_t rt_nd_size(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  return rt_tag_v(a ? a->size : 0);
+}
+
+int64_t rt_nd_shape(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int64_t items[RT_ND_MAX_DIMS];
+  for (int d = 0; d < a->ndim; d++)
+    items[d] = rt_tag_v(a->shape[d]);
+  return rt_nd_list_of(items, a->ndim);
+}
+
+int64_t rt_nd_strides(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int64_t items[RT_ND_MAX_DIMS];
+  for (int d = 0; d < a->ndim; d++)
+    items[d] = rt_tag_v(a->strides[d]);
+  return rt_nd_list_of(items, a->ndim);
+}
+
+int64_t rt_nd_data_ptr(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  return a ? (int64_t)(uintptr_t)rt_nd_ptr(a) : 0;
+}
+
+int64_t rt_nd_is_contig(int64_t a_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  return (a && rt_nd_is_contiguous(a)) ? NY_IMM_TRUE : NY_IMM_FALSE;
+}
+
+/* Resolves an int (flat row-major position) or an index list to a buffer offset. */
+static bool rt_nd_index_off(const rt_nd_t *a, int64_t idx_v, int64_t *off) {
+  int64_t o = a->offset;
+  if (is_int(idx_v)) {
+    int64_t flat = rt_untag_v(idx_v);
+    if (flat < 0)
+      flat += a->size;
+    if (flat < 0 || flat >= a->size)
+      return false;
+    for (int d = a->ndim - 1; d >= 0; d--) {
+      o += (flat % a->shape[d]) * a->strides[d];
+      flat /= a->shape[d];
+    }
+    *off = o;
+    return true;
+  }
+  if (!rt_nd_is_seq(idx_v) || rt_nd_seq_len(idx_v) != a->ndim)
+    return false;
+  for (int d = 0; d < a->ndim; d++) {
+    int64_t iv = rt_nd_seq_at(idx_v, d);
+    if (!is_int(iv))
+      return false;
+    int64_t i = rt_untag_v(iv);
+    if (i < 0)
+      i += a->shape[d];
+    if (i < 0 || i >= a->shape[d])
+      return false;
+    o += i * a->strides[d];
+  }
+  *off = o;
+  return true;
+}
+
+int64_t rt_nd_get(int64_t a_v, int64_t idx_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int64_t off = 0;
+  if (!a || !rt_nd_index_off(a, idx_v, &off))
+    return 0;
+  return rt_nd_box_at(a, off);
+}
+
+int64_t rt_nd_set(int64_t a_v, int64_t idx_v, int64_t v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int64_t off = 0;
+  if (!a || !rt_nd_index_off(a, idx_v, &off))
+    return NY_IMM_FALSE;
+  if (rt_nd_dtype_is_float(a->dtype))
+    rt_nd_st_f(a, off, rt_nd_value_f64(v));
+  else
+    rt_nd_st_i(a, off, rt_nd_value_i64(v));
+  return NY_IMM_TRUE;
+}
+
+int64_t rt_nd_fill(int64_t a_v, int64_t v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  rt_nd_iter_t it;
+  rt_nd_iter_init(&it, a);
+  bool fl = rt_nd_dtype_is_float(a->dtype);
+  double fv = rt_nd_value_f64(v);
+  int64_t iv = rt_nd_value_i64(v);
+  for (int64_t i = 0; i < a->size; i++) {
+    if (fl)
+      rt_nd_st_f(a, it.off, fv);
+    else
+      rt_nd_st_i(a, it.off, iv);
+    rt_nd_iter_next(&it, a);
+  }
+  return a_v;
+}
+
+int64_t rt_nd_slice(int64_t a_v, int64_t axis_v, int64_t start_v, int64_t stop_v,
+                    int64_t step_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int64_t axis = rt_nd_int_arg(axis_v);
+  int64_t step = step_v == 0 ? 1 : rt_nd_int_arg(step_v);
+  if (axis < 0)
+    axis += a->ndim;
+  if (axis < 0 || axis >= a->ndim || step == 0)
+    return 0;
+  int64_t dim = a->shape[axis];
+  int64_t start = start_v == 0 ? (step > 0 ? 0 : dim - 1) : rt_nd_int_arg(start_v);
+  int64_t stop = stop_v == 0 ? (step > 0 ? dim : -dim - 1) : rt_nd_int_arg(stop_v);
+  if (start < 0)
+    start += dim;
+  if (stop < 0)
+    stop += dim;
+  if (step > 0) {
+    start = start < 0 ? 0 : (start > dim ? dim : start);
+    stop = stop < start ? start : (stop > dim ? dim : stop);
+  } else {
+    start = start < -1 ? -1 : (start > dim - 1 ? dim - 1 : start);
+    stop = stop < -1 ? -1 : (stop > start ? start : stop);
+  }
+  int64_t count = step > 0 ? (stop - start + step - 1) / step : (start - stop + (-step) - 1) / -step;
+  rt_nd_t *v = rt_nd_view_of(a);
+  if (!v)
+    return 0;
+  if (count > 0)
+    v->offset += start * a->strides[axis];
+  v->shape[axis] = count;
+  v->strides[axis] = a->strides[axis] * step;
+  rt_nd_shape_size(v->ndim, v->shape, &v->size);
+  return rt_nd_ret(v);
+}
+
+int64_t rt_nd_transpose(int64_t a_v, int64_t axes_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int64_t perm[RT_ND_MAX_DIMS];
+  if (axes_v == 0) {
+    for (int d = 0; d < a->ndim; d++)
+      perm[d] = a->ndim - 1 - d;
+  } else {
+    int n = rt_nd_shape_arg(axes_v, perm);
+    if (n != a->ndim)
+      return 0;
+    int seen = 0;
+    for (int d = 0; d < n; d++) {
+      if (perm[d] >= n || (seen & (1 << perm[d])))
+        return 0;
+      seen |= 1 << perm[d];
+    }
+  }
+  rt_nd_t *v = rt_nd_view_of(a);
+  if (!v)
+    return 0;
+  for (int d = 0; d < a->ndim; d++) {
+    v->shape[d] = a->shape[perm[d]];
+    v->strides[d] = a->strides[perm[d]];
+  }
+  return rt_nd_ret(v);
+}
+
+int64_t rt_nd_reshape(int64_t a_v, int64_t shape_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int64_t shape[RT_ND_MAX_DIMS];
+  int nd = a ? rt_nd_shape_arg(shape_v, shape) : -1;
+  int64_t size = 0;
+  if (nd < 0 || !rt_nd_shape_size(nd, shape, &size) || size != a->size)
+    return 0;
+  rt_nd_t *src = a;
+  rt_nd_t *tmp = NULL;
+  if (!rt_nd_is_contiguous(a)) {
+    tmp = rt_nd_copy_as(a, a->dtype);
+    if (!tmp)
+      return 0;
+    src = tmp;
+  }
+  rt_nd_t *v = rt_nd_view_of(src);
+  rt_nd_release(tmp);
+  if (!v)
+    return 0;
+  v->ndim = nd;
+  for (int d = 0; d < nd; d++)
+    v->shape[d] = shape[d];
+  rt_nd_set_contiguous_strides(v);
+  return rt_nd_ret(v);
+}
+
+int64_t rt_nd_copy(int64_t a_v, int64_t dtype_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int dt = dtype_v == 0 ? a->dtype : rt_nd_dtype_arg(dtype_v);
+  if (dt < 0)
+    return 0;
+  return rt_nd_ret(rt_nd_copy_as(a, dt));
+}
+
+/* Broadcasts `a` to `shape` as stride-0 dims; returns false when incompatible. */
+static bool rt_nd_broadcast_to(const rt_nd_t *a, int ndim, const int64_t *shape, rt_nd_t *out) {
+  *out = *a;
+  out->ndim = ndim;
+  int shift = ndim - a->ndim;
+  if (shift < 0)
+    return false;
+  for (int d = 0; d < ndim; d++) {
+    int sd = d - shift;
+    int64_t dim = sd >= 0 ? a->shape[sd] : 1;
+    if (dim != shape[d] && dim != 1)
+      return false;
+    out->shape[d] = shape[d];
+    out->strides[d] = (sd >= 0 && dim == shape[d]) ? a->strides[sd] : 0;
+  }
+  rt_nd_shape_size(ndim, shape, &out->size);
+  return true;
+}
+
+static bool rt_nd_broadcast_shape(const rt_nd_t *a, const rt_nd_t *b, int *ndim, int64_t *shape) {
+  int nd = a->ndim > b->ndim ? a->ndim : b->ndim;
+  for (int d = 0; d < nd; d++) {
+    int ad = d - (nd - a->ndim), bd = d - (nd - b->ndim);
+    int64_t x = ad >= 0 ? a->shape[ad] : 1;
+    int64_t y = bd >= 0 ? b->shape[bd] : 1;
+    if (x != y && x != 1 && y != 1)
+      return false;
+    shape[d] = x == 1 ? y : x;
+  }
+  *ndim = nd;
+  return true;
+}
+
+static inline double rt_nd_apply_f(int op, double x, double y) {
+  switch (op) {
+  case RT_ND_OP_ADD:
+    return x + y;
+  case RT_ND_OP_SUB:
+    return x - y;
+  case RT_ND_OP_MUL:
+    return x * y;
+  case RT_ND_OP_DIV:
+    return x / y;
+  case RT_ND_OP_MIN:
+    return y < x ? y : x;
+  default:
+    return y > x ? y : x;
+  }
+}
+
+static inline int64_t rt_nd_apply_i(int op, int64_t x, int64_t y) {
+  switch (op) {
+  case RT_ND_OP_ADD:
+    return (int64_t)((uint64_t)x + (uint64_t)y);
+  case RT_ND_OP_SUB:
+    return (int64_t)((uint64_t)x - (uint64_t)y);
+  case RT_ND_OP_MUL:
+    return (int64_t)((uint64_t)x * (uint64_t)y);
+  case RT_ND_OP_DIV:
+    if (y == 0) {
+      rt_division_by_zero();
+      return 0;
+    }
+    return (x == INT64_MIN && y == -1) ? x : x / y;
+  case RT_ND_OP_MIN:
+    return y < x ? y : x;
+  default:
+    return y > x ? y : x;
+  }
+}
+
+/* Contiguous same-dtype kernels; plain loops so -O3 vectorizes them for the host. */
+#define RT_ND_DEFINE_BINOP_KERNEL(NAME, T)                                                         \
+  static void NAME(int op, const T *x, const T *y, int64_t ys, T *o, int64_t n) {                  \
+    switch (op) {                                                                                  \
+    case RT_ND_OP_ADD:                                                                             \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = x[i] + y[i * ys];                                                                   \
+      break;                                                                                       \
+    case RT_ND_OP_SUB:                                                                             \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = x[i] - y[i * ys];                                                                   \
+      break;                                                                                       \
+    case RT_ND_OP_MUL:                                                                             \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = x[i] * y[i * ys];                                                                   \
+      break;                                                                                       \
+    case RT_ND_OP_DIV:                                                                             \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = x[i] / y[i * ys];                                                                   \
+      break;                                                                                       \
+    case RT_ND_OP_MIN:                                                                             \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = y[i * ys] < x[i] ? y[i * ys] : x[i];                                                \
+      break;                                                                                       \
+    default:                                                                                       \
+      for (int64_t i = 0; i < n; i++)                                                              \
+        o[i] = y[i * ys] > x[i] ? y[i * ys] : x[i];                                                \
+      break;                                                                                       \
+    }                                                                                              \
+  }
+
+RT_ND_DEFINE_BINOP_KERNEL(rt_nd_binop_f64, double)
+RT_ND_DEFINE_BINOP_KERNEL(rt_nd_binop_f32, float)
+
+#undef RT_ND_DEFINE_BINOP_KERNEL
+
+static bool rt_nd_binop_fast(int op, const rt_nd_t *a, const rt_nd_t *b, int64_t ys, rt_nd_t *out) {
+  if (a->dtype != out->dtype || b->dtype != out->dtype || !rt_nd_dtype_is_float(out->dtype))
+    return false;
+  if (!rt_nd_is_contiguous(a) || !rt_nd_is_contiguous(out) || a->size != out->size)
+    return false;
+  if (ys && (!rt_nd_is_contiguous(b) || b->size != out->size))
+    return false;
+  if (out->dtype == RT_ND_F64)
+    rt_nd_binop_f64(op, (const double *)rt_nd_ptr(a), (const double *)rt_nd_ptr(b), ys,
+                    (double *)rt_nd_ptr(out), out->size);
+  else
+    rt_nd_binop_f32(op, (const float *)rt_nd_ptr(a), (const float *)rt_nd_ptr(b), ys,
+                    (float *)rt_nd_ptr(out), out->size);
+  return true;
+}
+
+static bool rt_nd_binop_run(int op, const rt_nd_t *a, int64_t b_v, rt_nd_t *out) {
+  rt_nd_t *b = rt_nd_handle(b_v);
+  rt_nd_t av, bv;
+  if (!rt_nd_broadcast_to(a, out->ndim, out->shape, &av))
+    return false;
+  bool fl = rt_nd_dtype_is_float(out->dtype);
+  if (b) {
+    if (!rt_nd_broadcast_to(b, out->ndim, out->shape, &bv))
+      return false;
+    if (rt_nd_binop_fast(op, &av, &bv, 1, out))
+      return true;
+    rt_nd_iter_t ia, ib, io;
+    rt_nd_iter_init(&ia, &av);
+    rt_nd_iter_init(&ib, &bv);
+    rt_nd_iter_init(&io, out);
+    for (int64_t i = 0; i < out->size; i++) {
+      if (fl)
+        rt_nd_st_f(out, io.off, rt_nd_apply_f(op, rt_nd_ld_f(&av, ia.off), rt_nd_ld_f(&bv, ib.off)));
+      else
+        rt_nd_st_i(out, io.off, rt_nd_apply_i(op, rt_nd_ld_i(&av, ia.off), rt_nd_ld_i(&bv, ib.off)));
+      rt_nd_iter_next(&ia, &av);
+      rt_nd_iter_next(&ib, &bv);
+      rt_nd_iter_next(&io, out);
+    }
+    return true;
+  }
+  double fy = rt_nd_value_f64(b_v);
+  int64_t iy = rt_nd_value_i64(b_v);
+  if (fl && av.dtype == out->dtype && rt_nd_is_contiguous(&av) && rt_nd_is_contiguous(out)) {
+    if (out->dtype == RT_ND_F64) {
+      rt_nd_binop_f64(op, (const double *)rt_nd_ptr(&av), &fy, 0, (double *)rt_nd_ptr(out),
+                      out->size);
+    } else {
+      float y32 = (float)fy;
+      rt_nd_binop_f32(op, (const float *)rt_nd_ptr(&av), &y32, 0, (float *)rt_nd_ptr(out),
+                      out->size);
+    }
+    return true;
+  }
+  rt_nd_iter_t ia, io;
+  rt_nd_iter_init(&ia, &av);
+  rt_nd_iter_init(&io, out);
+  for (int64_t i = 0; i < out->size; i++) {
+    if (fl)
+      rt_nd_st_f(out, io.off, rt_nd_apply_f(op, rt_nd_ld_f(&av, ia.off), fy));
+    else
+      rt_nd_st_i(out, io.off, rt_nd_apply_i(op, rt_nd_ld_i(&av, ia.off), iy));
+    rt_nd_iter_next(&ia, &av);
+    rt_nd_iter_next(&io, out);
+  }
+  return true;
+}
+
+int64_t rt_nd_binop(int64_t a_v, int64_t b_v, int64_t op_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  if (!a)
+    return 0;
+  int op = (int)rt_nd_int_arg(op_v);
+  if (op < RT_ND_OP_ADD || op > RT_ND_OP_MAX)
+    return 0;
+  rt_nd_t *b = rt_nd_handle(b_v);
+  int ndim = a->ndim;
+  int64_t shape[RT_ND_MAX_DIMS];
+  int dt = a->dtype;
+  if (b) {
+    if (!rt_nd_broadcast_shape(a, b, &ndim, shape))
+      return 0;
+    dt = rt_nd_promote(a->dtype, b->dtype);
+  } else {
+    memcpy(shape, a->shape, sizeof(shape));
+    if (!rt_nd_dtype_is_float(dt) && is_v_flt(b_v))
+      dt = RT_ND_F64;
+  }
+  rt_nd_t *out = rt_nd_alloc(dt, ndim, shape, false);
+  if (!out)
+    return 0;
+  if (!rt_nd_binop_run(op, a, b_v, out)) {
+    rt_nd_release(out);
+    return 0;
+  }
+  return rt_nd_ret(out);
+}
+
+int64_t rt_nd_binop_into(int64_t out_v, int64_t a_v, int64_t b_v, int64_t op_v) {
+  rt_nd_t *out = rt_nd_handle(out_v);
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int op = (int)rt_nd_int_arg(op_v);
+  if (!out || !a || op < RT_ND_OP_ADD || op > RT_ND_OP_MAX)
+    return 0;
+  return rt_nd_binop_run(op, a, b_v, out) ? out_v : 0;
+}
+
+int64_t rt_nd_unop(int64_t a_v, int64_t op_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int op = (int)rt_nd_int_arg(op_v);
+  if (!a || op < RT_ND_UOP_NEG || op > RT_ND_UOP_LOG)
+    return 0;
+  int dt = a->dtype;
+  if (op >= RT_ND_UOP_SQRT && !rt_nd_dtype_is_float(dt))
+    dt = RT_ND_F64;
+  rt_nd_t *out = rt_nd_alloc(dt, a->ndim, a->shape, false);
+  if (!out)
+    return 0;
+  rt_nd_iter_t it;
+  rt_nd_iter_init(&it, a);
+  bool fl = rt_nd_dtype_is_float(dt);
+  for (int64_t i = 0; i < a->size; i++) {
+    if (fl) {
+      double x = rt_nd_ld_f(a, it.off);
+      switch (op) {
+      case RT_ND_UOP_NEG:
+        x = -x;
+        break;
+      case RT_ND_UOP_ABS:
+        x = fabs(x);
+        break;
+      case RT_ND_UOP_SQRT:
+        x = sqrt(x);
+        break;
+      case RT_ND_UOP_EXP:
+        x = exp(x);
+        break;
+      default:
+        x = log(x);
+        break;
+      }
+      rt_nd_st_f(out, i, x);
+    } else {
+      int64_t x = rt_nd_ld_i(a, it.off);
+      uint64_t ux = (uint64_t)x;
+      rt_nd_st_i(out, i, op == RT_ND_UOP_NEG || x < 0 ? (int64_t)(0 - ux) : x);
+    }
+    rt_nd_iter_next(&it, a);
+  }
+  return rt_nd_ret(out);
+}
+
+/* Sum of a contiguous f64 run with independent accumulators for ILP. */
+static double rt_nd_sum_f64(const double *x, int64_t n) {
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += x[i];
+    s1 += x[i + 1];
+    s2 += x[i + 2];
+    s3 += x[i + 3];
+  }
+  for (; i < n; i++)
+    s0 += x[i];
+  return (s0 + s1) + (s2 + s3);
+}
+
+typedef struct {
+  double f;
+  int64_t i;
+} rt_nd_acc_t;
+
+static inline void rt_nd_acc_init(rt_nd_acc_t *acc, int op, bool fl, const rt_nd_t *a,
+                                  int64_t first) {
+  if (op == RT_ND_RED_SUM) {
+    acc->f = 0.0;
+    acc->i = 0;
+  } else if (op == RT_ND_RED_PROD) {
+    acc->f = 1.0;
+    acc->i = 1;
+  } else if (fl) {
+    acc->f = rt_nd_ld_f(a, first);
+  } else {
+    acc->i = rt_nd_ld_i(a, first);
+  }
+}
+
+static inline void rt_nd_acc_step(rt_nd_acc_t *acc, int op, bool fl, const rt_nd_t *a,
+                                  int64_t off) {
+  if (fl) {
+    double x = rt_nd_ld_f(a, off);
+    switch (op) {
+    case RT_ND_RED_SUM:
+      acc->f += x;
+      break;
+    case RT_ND_RED_PROD:
+      acc->f *= x;
+      break;
+    case RT_ND_RED_MIN:
+      acc->f = x < acc->f ? x : acc->f;
+      break;
+    default:
+      acc->f = x > acc->f ? x : acc->f;
+      break;
+    }
+    return;
+  }
+  int64_t x = rt_nd_ld_i(a, off);
+  switch (op) {
+  case RT_ND_RED_SUM:
+    acc->i = (int64_t)((uint64_t)acc->i + (uint64_t)x);
+    break;
+  case RT_ND_RED_PROD:
+    acc->i = (int64_t)((uint64_t)acc->i * (uint64_t)x);
+    break;
+  case RT_ND_RED_MIN:
+    acc->i = x < acc->i ? x : acc->i;
+    break;
+  default:
+    acc->i = x > acc->i ? x : acc->i;
+    break;
+  }
+}
+
+int64_t rt_nd_reduce(int64_t a_v, int64_t op_v, int64_t axis_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  int op = (int)rt_nd_int_arg(op_v);
+  if (!a || op < RT_ND_RED_SUM || op > RT_ND_RED_MAX)
+    return 0;
+  bool fl = rt_nd_dtype_is_float(a->dtype);
+  int64_t axis = rt_nd_int_arg(axis_v);
+  if (axis < 0 || a->ndim <= 1) {
+    if (!a->size)
+      return (op == RT_ND_RED_SUM || op == RT_ND_RED_PROD)
+                 ? (fl ? rt_nd_box_f64(op == RT_ND_RED_SUM ? 0.0 : 1.0)
+                       : rt_tag_v(op == RT_ND_RED_SUM ? 0 : 1))
+                 : 0;
+    if (op == RT_ND_RED_SUM && a->dtype == RT_ND_F64 && rt_nd_is_contiguous(a))
+      return rt_nd_box_f64(rt_nd_sum_f64((const double *)rt_nd_ptr(a), a->size));
+    rt_nd_acc_t acc = {0};
+    rt_nd_acc_init(&acc, op, fl, a, a->offset);
+    rt_nd_iter_t it;
+    rt_nd_iter_init(&it, a);
+    for (int64_t i = 0; i < a->size; i++) {
+      rt_nd_acc_step(&acc, op, fl, a, it.off);
+      rt_nd_iter_next(&it, a);
+    }
+    return fl ? rt_nd_box_f64(acc.f) : rt_nd_box_i64(acc.i);
+  }
+  if (axis >= a->ndim)
+    return 0;
+  int64_t len = a->shape[axis];
+  int64_t stride = a->strides[axis];
+  if (!len && op >= RT_ND_RED_MIN)
+    return 0;
+  /* Iterate the output positions through a view with the reduced axis pinned to one element. */
+  rt_nd_t outer = *a;
+  outer.shape[axis] = 1;
+  rt_nd_shape_size(outer.ndim, outer.shape, &outer.size);
+  int64_t oshape[RT_ND_MAX_DIMS];
+  int ond = 0;
+  for (int d = 0; d < a->ndim; d++)
+    if (d != axis)
+      oshape[ond++] = a->shape[d];
+  rt_nd_t *out = rt_nd_alloc(a->dtype, ond, oshape, false);
+  if (!out)
+    return 0;
+  rt_nd_iter_t it;
+  rt_nd_iter_init(&it, &outer);
+  for (int64_t o = 0; o < outer.size; o++) {
+    rt_nd_acc_t acc = {0};
+    rt_nd_acc_init(&acc, op, fl, a, it.off);
+    for (int64_t k = 0; k < len; k++)
+      rt_nd_acc_step(&acc, op, fl, a, it.off + k * stride);
+    if (fl)
+      rt_nd_st_f(out, o, acc.f);
+    else
+      rt_nd_st_i(out, o, acc.i);
+    rt_nd_iter_next(&it, &outer);
+  }
+  return rt_nd_ret(out);
+}
+
+int64_t rt_nd_dot(int64_t a_v, int64_t b_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  rt_nd_t *b = rt_nd_handle(b_v);
+  if (!a || !b || a->size != b->size)
+    return 0;
+  bool fl = rt_nd_dtype_is_float(a->dtype) || rt_nd_dtype_is_float(b->dtype);
+  if (fl && a->dtype == RT_ND_F64 && b->dtype == RT_ND_F64 && a->ndim == 1 && b->ndim == 1) {
+    const double *x = (const double *)a->buf->data + a->offset;
+    const double *y = (const double *)b->buf->data + b->offset;
+    int64_t xs = a->strides[0], ys = b->strides[0];
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int64_t i = 0, n = a->size;
+    if (xs == 1 && ys == 1) {
+      for (; i + 4 <= n; i += 4) {
+        s0 += x[i] * y[i];
+        s1 += x[i + 1] * y[i + 1];
+        s2 += x[i + 2] * y[i + 2];
+        s3 += x[i + 3] * y[i + 3];
+      }
+    }
+    for (; i < n; i++)
+      s0 += x[i * xs] * y[i * ys];
+    return rt_nd_box_f64((s0 + s1) + (s2 + s3));
+  }
+  rt_nd_iter_t ia, ib;
+  rt_nd_iter_init(&ia, a);
+  rt_nd_iter_init(&ib, b);
+  double fs = 0.0;
+  uint64_t is = 0;
+  for (int64_t i = 0; i < a->size; i++) {
+    if (fl)
+      fs += rt_nd_ld_f(a, ia.off) * rt_nd_ld_f(b, ib.off);
+    else
+      is += (uint64_t)rt_nd_ld_i(a, ia.off) * (uint64_t)rt_nd_ld_i(b, ib.off);
+    rt_nd_iter_next(&ia, a);
+    rt_nd_iter_next(&ib, b);
+  }
+  return fl ? rt_nd_box_f64(fs) : rt_nd_box_i64((int64_t)is);
+}
+
+int64_t rt_nd_matmul(int64_t a_v, int64_t b_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  rt_nd_t *b = rt_nd_handle(b_v);
+  if (!a || !b || a->ndim < 1 || a->ndim > 2 || b->ndim < 1 || b->ndim > 2)
+    return 0;
+  int64_t m, ka, rsa, csa, kb, n, rsb, csb;
+  rt_nd_as_matrix(a, true, &m, &ka, &rsa, &csa);
+  rt_nd_as_matrix(b, false, &kb, &n, &rsb, &csb);
+  if (ka != kb)
+    return 0;
+  int dt = rt_nd_promote(a->dtype, b->dtype);
+  int64_t shape[2];
+  int nd = 0;
+  if (a->ndim == 2)
+    shape[nd++] = m;
+  if (b->ndim == 2)
+    shape[nd++] = n;
+  rt_nd_t *out = rt_nd_alloc(dt, nd, shape, true);
+  if (!out)
+    return 0;
+  if (!rt_nd_dtype_is_float(dt)) {
+    rt_nd_t *ai = rt_nd_copy_as(a, RT_ND_I64);
+    rt_nd_t *bi = rt_nd_copy_as(b, RT_ND_I64);
+    rt_nd_t *ci = dt == RT_ND_I64 ? out : rt_nd_alloc(RT_ND_I64, nd, shape, false);
+    bool ok = ai && bi && ci;
+    if (ok) {
+      rt_nd_igemm(m, n, ka, (const int64_t *)ai->buf->data, (const int64_t *)bi->buf->data,
+                  (int64_t *)ci->buf->data);
+      if (ci != out)
+        for (int64_t i = 0; i < out->size; i++)
+          rt_nd_st_i(out, i, ((const int64_t *)ci->buf->data)[i]);
+    }
+    rt_nd_release(ai);
+    rt_nd_release(bi);
+    if (ci != out)
+      rt_nd_release(ci);
+    if (!ok) {
+      rt_nd_release(out);
+      return 0;
+    }
+    return rt_nd_ret(out);
+  }
+  if (nd == 0) {
+    /* vector . vector: keep the 0-d result as a one-element buffer. */
+    out->ndim = 1;
+    out->shape[0] = 1;
+    out->strides[0] = 1;
+  }
+  if (!rt_nd_gemm_into(1.0, a, b, 0.0, out)) {
+    rt_nd_release(out);
+    return 0;
+  }
+  if (nd == 0) {
+    int64_t r = rt_nd_box_at(out, 0);
+    rt_nd_release(out);
+    return r;
+  }
+  return rt_nd_ret(out);
+}
+
+int64_t rt_nd_gemm(int64_t alpha_v, int64_t a_v, int64_t b_v, int64_t beta_v, int64_t c_v) {
+  rt_nd_t *a = rt_nd_handle(a_v);
+  rt_nd_t *b = rt_nd_handle(b_v);
+  rt_nd_t *c = rt_nd_handle(c_v);
+  if (!a || !b || !c)
+    return 0;
+  return rt_nd_gemm_into(rt_nd_value_f64(alpha_v), a, b, rt_nd_value_f64(beta_v), c) ? c_v : 0;
+}
+
+int64_t rt_nd_set_threads(int64_t n_v) {
+  int64_t n = rt_nd_int_arg(n_v);
+  g_rt_nd_threads = n < 0 ? 1 : (n > RT_MAX_THREADS ? RT_MAX_THREADS : (int)n);
+  return rt_tag_v(rt_nd_thread_count());
+}
+
+int64_t rt_nd_threads(void) { return rt_tag_v(rt_nd_thread_count()); }
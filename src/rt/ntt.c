@@ -0,0 +1,1335 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <gmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+/*
+ * Polynomial multiplication kernels for std.math.crypto.poly and .ntt.
+ *
+ * The algorithm follows the shorter operand: schoolbook up to RT_NTT_SCHOOL
+ * coefficients, Karatsuba up to RT_NTT_KARA when the modulus fits a word, and a
+ * multi-prime NTT above that. NTT primes are generated on first use:
+ * c * 2^32 + 1 just below 2^62 (scalar Shoup butterflies on 64-bit words) and
+ * c * 2^21 + 1 just below 2^30 (32-bit lanes, AVX2 when the CPU has it). A
+ * product takes as many primes as its exact coefficient bound needs and is
+ * rebuilt with Garner's CRT, directly modulo the caller's modulus when that
+ * fits a word. Each prime keeps twiddle tables with Shoup companions for the
+ * largest length seen so far; transforms run DIF forward / DIT inverse so no
+ * bit reversal is needed between them.
+ */
+
+extern void _bi_val_to_mpz(int64_t v, mpz_t result);
+extern int64_t _bi_from_mpz(const mpz_t val);
+extern int64_t _bi_mpz_get_i64(const mpz_t v);
+extern void _bi_mpz_set_i64(mpz_t out, int64_t v);
+extern int64_t rt_list_new(int64_t n);
+
+#define RT_NTT_SCHOOL 32
+#define RT_NTT_KARA 256
+#define RT_NTT_P62_SHIFT 32
+#define RT_NTT_P62_MAX 64
+#define RT_NTT_P62_BITS 61 /* every prime lies in (2^61, 2^62) */
+#define RT_NTT_P30_SHIFT 21
+#define RT_NTT_P30_MAX 30
+#define RT_NTT_P30_FAST 4
+#define RT_NTT_P30_BITS 29 /* every prime lies in (2^29, 2^30) */
+#define RT_NTT_WORD_BITS 62
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) &&           \
+    (defined(__GNUC__) || defined(__clang__))
+#define RT_NTT_X86_DISPATCH 1
+#endif
+
+typedef struct {
+  uint64_t p;
+  uint64_t nr; /* quadratic non-residue: nr^((p-1) / 2^k) has order exactly 2^k */
+  int log;     /* tables cover transforms of up to 2^log points */
+  void *tab;   /* w, w', w^-1, (w^-1)' with 2^log entries each */
+} rt_ntt_prime_t;
+
+typedef struct {
+  const void *tab;
+  int log;
+} rt_ntt_view_t;
+
+/* Integer coefficients as loaded from a Ny list. */
+typedef struct {
+  int64_t n;
+  int64_t *iv;   /* the value when it fits int64 */
+  mpz_t *bz;     /* the value otherwise; NULL when no entry needs it */
+  uint8_t *big;  /* per-entry: value lives in bz */
+  size_t maxbits; /* bit length of the largest |coefficient| */
+} rt_ntt_src_t;
+
+static rt_ntt_prime_t rt_ntt_p62[RT_NTT_P62_MAX];
+static rt_ntt_prime_t rt_ntt_p30[RT_NTT_P30_MAX];
+static int rt_ntt_n62, rt_ntt_n30;
+#if defined(_WIN32)
+static SRWLOCK rt_ntt_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t rt_ntt_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void rt_ntt_lock_acquire(void) {
+#if defined(_WIN32)
+  AcquireSRWLockExclusive(&rt_ntt_lock);
+#else
+  pthread_mutex_lock(&rt_ntt_lock);
+#endif
+}
+
+static void rt_ntt_lock_release(void) {
+#if defined(_WIN32)
+  ReleaseSRWLockExclusive(&rt_ntt_lock);
+#else
+  pthread_mutex_unlock(&rt_ntt_lock);
+#endif
+}
+
+/* ---- word arithmetic ------------------------------------------------------ */
+
+static inline uint64_t rt_ntt_mulmod(uint64_t a, uint64_t b, uint64_t p) {
+  return (uint64_t)((unsigned __int128)a * b % p);
+}
+
+static uint64_t rt_ntt_powmod(uint64_t b, uint64_t e, uint64_t p) {
+  uint64_t r = 1 % p;
+  b %= p;
+  while (e) {
+    if (e & 1)
+      r = rt_ntt_mulmod(r, b, p);
+    b = rt_ntt_mulmod(b, b, p);
+    e >>= 1;
+  }
+  return r;
+}
+
+/* a^-1 mod p, or 0 when a is not a unit. */
+static uint64_t rt_ntt_invmod(uint64_t a, uint64_t p) {
+  int64_t t = 0, nt = 1;
+  uint64_t r = p, nr = a % p;
+  while (nr) {
+    uint64_t q = r / nr, tr = r - q * nr;
+    int64_t tt = t - (int64_t)q * nt;
+    t = nt;
+    nt = tt;
+    r = nr;
+    nr = tr;
+  }
+  if (r != 1)
+    return 0;
+  return t < 0 ? (uint64_t)(t + (int64_t)p) : (uint64_t)t;
+}
+
+/* -p^-1 mod 2^64 for odd p. */
+static uint64_t rt_ntt_mont_inv(uint64_t p) {
+  uint64_t inv = p;
+  for (int i = 0; i < 5; i++)
+    inv *= 2 - p * inv;
+  return 0 - inv;
+}
+
+/* Deterministic Miller-Rabin for 64-bit n. */
+static bool rt_ntt_is_prime(uint64_t n) {
+  static const uint64_t small[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+  static const uint64_t bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+  if (n < 2)
+    return false;
+  for (size_t i = 0; i < sizeof(small) / sizeof(small[0]); i++)
+    if (n % small[i] == 0)
+      return n == small[i];
+  uint64_t d = n - 1;
+  int s = 0;
+  while (!(d & 1)) {
+    d >>= 1;
+    s++;
+  }
+  for (size_t i = 0; i < sizeof(bases) / sizeof(bases[0]); i++) {
+    uint64_t a = bases[i] % n;
+    if (a == 0)
+      continue;
+    uint64_t x = rt_ntt_powmod(a, d, n);
+    if (x == 1 || x == n - 1)
+      continue;
+    int r = 1;
+    for (; r < s; r++) {
+      x = rt_ntt_mulmod(x, x, n);
+      if (x == n - 1)
+        break;
+    }
+    if (r == s)
+      return false;
+  }
+  return true;
+}
+
+static uint64_t rt_ntt_nonresidue(uint64_t p) {
+  for (uint64_t x = 2;; x++)
+    if (rt_ntt_powmod(x, (p - 1) / 2, p) == p - 1)
+      return x;
+}
+
+static inline uint64_t rt_ntt_shoup64(uint64_t y, uint64_t w, uint64_t wp, uint64_t p) {
+  uint64_t q = (uint64_t)(((unsigned __int128)y * wp) >> 64);
+  return y * w - q * p;
+}
+
+static inline uint32_t rt_ntt_shoup32(uint32_t y, uint32_t w, uint32_t wp, uint32_t p) {
+  uint32_t q = (uint32_t)(((uint64_t)y * wp) >> 32);
+  return y * w - q * p;
+}
+
+static inline uint64_t rt_ntt_shoup_pre(uint64_t w, uint64_t p, bool wide) {
+  if (wide)
+    return (uint64_t)(((unsigned __int128)w << 64) / p);
+  return (w << 32) / p;
+}
+
+/* ---- primes and twiddle tables ------------------------------------------- */
+
+/*
+ * Tables for 2^log points over root (of order 2^log): entry h + j of the
+ * forward table is root^(2^log / 2h * j), the stage-h twiddles, so a table
+ * for a longer transform contains every shorter one as a prefix.
+ */
+static void *rt_ntt_build(uint64_t p, uint64_t root, int log, bool wide) {
+  size_t n = (size_t)1 << log;
+  size_t word = wide ? sizeof(uint64_t) : sizeof(uint32_t);
+  void *tab = malloc(4 * n * word);
+  uint64_t iroot = rt_ntt_invmod(root, p);
+  if (!tab || !iroot) {
+    free(tab);
+    return NULL;
+  }
+  for (int part = 0; part < 2; part++) {
+    uint64_t r = part ? iroot : root;
+    size_t base = part ? 2 * n : 0;
+    for (size_t h = 0; h < n; h = h ? 2 * h : 1) {
+      uint64_t wh = h ? rt_ntt_powmod(r, n / (2 * h), p) : 1, x = 1;
+      for (size_t j = 0; j < (h ? h : 1); j++) {
+        uint64_t xp = rt_ntt_shoup_pre(x, p, wide);
+        if (wide) {
+          ((uint64_t *)tab)[base + h + j] = x;
+          ((uint64_t *)tab)[base + n + h + j] = xp;
+        } else {
+          ((uint32_t *)tab)[base + h + j] = (uint32_t)x;
+          ((uint32_t *)tab)[base + n + h + j] = (uint32_t)xp;
+        }
+        x = rt_ntt_mulmod(x, wh, p);
+      }
+    }
+  }
+  return tab;
+}
+
+/* Caller holds rt_ntt_lock. */
+static bool rt_ntt_add_primes(bool wide, int k) {
+  rt_ntt_prime_t *set = wide ? rt_ntt_p62 : rt_ntt_p30;
+  int *have = wide ? &rt_ntt_n62 : &rt_ntt_n30;
+  int cap = wide ? RT_NTT_P62_MAX : RT_NTT_P30_MAX;
+  int shift = wide ? RT_NTT_P62_SHIFT : RT_NTT_P30_SHIFT;
+  uint64_t cmax = wide ? (UINT64_C(1) << 30) - 1 : (UINT64_C(1) << 9) - 1;
+  uint64_t cmin = (cmax + 1) / 2;
+  if (k > cap)
+    return false;
+  uint64_t c = *have ? (set[*have - 1].p >> shift) - 1 : cmax;
+  for (; *have < k && c >= cmin; c--) {
+    uint64_t p = (c << shift) | 1;
+    if (!rt_ntt_is_prime(p))
+      continue;
+    set[*have].p = p;
+    set[*have].nr = rt_ntt_nonresidue(p);
+    set[*have].log = 0;
+    set[*have].tab = NULL;
+    (*have)++;
+  }
+  return *have >= k;
+}
+
+/*
+ * The first k primes of a set with tables for 2^log points. Tables are only
+ * ever replaced by larger ones and the superseded ones stay allocated (at most
+ * the size of the current one), since a concurrent product may still read them.
+ */
+static bool rt_ntt_prepare(bool wide, int k, int log, uint64_t *ps, rt_ntt_view_t *views) {
+  rt_ntt_prime_t *set = wide ? rt_ntt_p62 : rt_ntt_p30;
+  rt_ntt_lock_acquire();
+  bool ok = rt_ntt_add_primes(wide, k);
+  for (int i = 0; ok && i < k; i++) {
+    rt_ntt_prime_t *pr = &set[i];
+    if (pr->log < log || !pr->tab) {
+      uint64_t root = rt_ntt_powmod(pr->nr, (pr->p - 1) >> log, pr->p);
+      void *tab = rt_ntt_build(pr->p, root, log, wide);
+      if (!tab) {
+        ok = false;
+        break;
+      }
+      pr->tab = tab;
+      pr->log = log;
+    }
+    ps[i] = pr->p;
+    views[i].tab = pr->tab;
+    views[i].log = pr->log;
+  }
+  rt_ntt_lock_release();
+  return ok;
+}
+
+/* ---- 62-bit transforms ---------------------------------------------------- */
+
+/* Natural order in, bit-reversed out; inputs and outputs in [0, 2p). */
+static void rt_ntt64_forward(uint64_t *a, int log, const uint64_t *w, const uint64_t *wp,
+                             uint64_t p) {
+  size_t n = (size_t)1 << log;
+  uint64_t p2 = 2 * p;
+  for (size_t h = n >> 1; h >= 1; h >>= 1) {
+    for (size_t s = 0; s < n; s += 2 * h) {
+      uint64_t *x = a + s, *y = a + s + h;
+      for (size_t j = 0; j < h; j++) {
+        uint64_t u = x[j], v = y[j], t = u + v;
+        x[j] = t >= p2 ? t - p2 : t;
+        y[j] = rt_ntt_shoup64(u - v + p2, w[h + j], wp[h + j], p);
+      }
+    }
+  }
+}
+
+/* Bit-reversed in, natural order out, unscaled; values in [0, 2p). */
+static void rt_ntt64_inverse(uint64_t *a, int log, const uint64_t *w, const uint64_t *wp,
+                             uint64_t p) {
+  size_t n = (size_t)1 << log;
+  uint64_t p2 = 2 * p;
+  for (size_t h = 1; h < n; h <<= 1) {
+    for (size_t s = 0; s < n; s += 2 * h) {
+      uint64_t *x = a + s, *y = a + s + h;
+      for (size_t j = 0; j < h; j++) {
+        uint64_t u = x[j], t = rt_ntt_shoup64(y[j], w[h + j], wp[h + j], p);
+        uint64_t sum = u + t, dif = u - t + p2;
+        x[j] = sum >= p2 ? sum - p2 : sum;
+        y[j] = dif >= p2 ? dif - p2 : dif;
+      }
+    }
+  }
+}
+
+/* a = a * b * 2^-64 mod p, fully reduced. */
+static void rt_ntt64_pointwise(uint64_t *a, const uint64_t *b, size_t n, uint64_t p) {
+  uint64_t pinv = rt_ntt_mont_inv(p);
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x = a[i] >= p ? a[i] - p : a[i], y = b[i] >= p ? b[i] - p : b[i];
+    unsigned __int128 t = (unsigned __int128)x * y;
+    uint64_t m = (uint64_t)t * pinv;
+    uint64_t u = (uint64_t)((t + (unsigned __int128)m * p) >> 64);
+    a[i] = u >= p ? u - p : u;
+  }
+}
+
+static void rt_ntt64_scale(uint64_t *a, size_t n, uint64_t c, uint64_t p) {
+  uint64_t cp = rt_ntt_shoup_pre(c, p, true);
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x = rt_ntt_shoup64(a[i], c, cp, p);
+    a[i] = x >= p ? x - p : x;
+  }
+}
+
+/* ---- 30-bit transforms ---------------------------------------------------- */
+
+static void rt_ntt32_forward_stage(uint32_t *a, size_t n, size_t h, const uint32_t *w,
+                                   const uint32_t *wp, uint32_t p) {
+  uint32_t p2 = 2 * p;
+  for (size_t s = 0; s < n; s += 2 * h) {
+    uint32_t *x = a + s, *y = a + s + h;
+    for (size_t j = 0; j < h; j++) {
+      uint32_t u = x[j], v = y[j], t = u + v;
+      x[j] = t >= p2 ? t - p2 : t;
+      y[j] = rt_ntt_shoup32(u - v + p2, w[h + j], wp[h + j], p);
+    }
+  }
+}
+
+static void rt_ntt32_inverse_stage(uint32_t *a, size_t n, size_t h, const uint32_t *w,
+                                   const uint32_t *wp, uint32_t p) {
+  uint32_t p2 = 2 * p;
+  for (size_t s = 0; s < n; s += 2 * h) {
+    uint32_t *x = a + s, *y = a + s + h;
+    for (size_t j = 0; j < h; j++) {
+      uint32_t u = x[j], t = rt_ntt_shoup32(y[j], w[h + j], wp[h + j], p);
+      uint32_t sum = u + t, dif = u - t + p2;
+      x[j] = sum >= p2 ? sum - p2 : sum;
+      y[j] = dif >= p2 ? dif - p2 : dif;
+    }
+  }
+}
+
+static void rt_ntt32_pointwise_scalar(uint32_t *a, const uint32_t *b, size_t n, uint32_t p,
+                                      uint32_t pinv) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = a[i] >= p ? a[i] - p : a[i], y = b[i] >= p ? b[i] - p : b[i];
+    uint64_t t = (uint64_t)x * y;
+    uint32_t m = (uint32_t)t * pinv;
+    uint32_t u = (uint32_t)((t + (uint64_t)m * p) >> 32);
+    a[i] = u >= p ? u - p : u;
+  }
+}
+
+static void rt_ntt32_scale_scalar(uint32_t *a, size_t n, uint32_t c, uint32_t cp, uint32_t p) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = rt_ntt_shoup32(a[i], c, cp, p);
+    a[i] = x >= p ? x - p : x;
+  }
+}
+
+#if defined(RT_NTT_X86_DISPATCH)
+/* Shoup products of eight 32-bit lanes; mul_epu32 covers even and odd lanes in turn. */
+__attribute__((target("avx2"))) static inline __m256i rt_ntt32_shoup_avx2(__m256i y, __m256i w,
+                                                                         __m256i wp, __m256i p) {
+  __m256i qe = _mm256_srli_epi64(_mm256_mul_epu32(y, wp), 32);
+  __m256i qo = _mm256_mul_epu32(_mm256_srli_epi64(y, 32), _mm256_srli_epi64(wp, 32));
+  __m256i q = _mm256_blend_epi32(qe, qo, 0xAA);
+  return _mm256_sub_epi32(_mm256_mullo_epi32(y, w), _mm256_mullo_epi32(q, p));
+}
+
+/* x - m when x >= m, for lanes below 2m < 2^32. */
+__attribute__((target("avx2"))) static inline __m256i rt_ntt32_reduce_avx2(__m256i x, __m256i m) {
+  return _mm256_min_epu32(x, _mm256_sub_epi32(x, m));
+}
+
+__attribute__((target("avx2"))) static void rt_ntt32_forward_avx2(uint32_t *a, int log,
+                                                                  const uint32_t *w,
+                                                                  const uint32_t *wp, uint32_t p) {
+  size_t n = (size_t)1 << log, h = n >> 1;
+  __m256i vp = _mm256_set1_epi32((int)p), vp2 = _mm256_set1_epi32((int)(2 * p));
+  for (; h >= 8; h >>= 1) {
+    for (size_t s = 0; s < n; s += 2 * h) {
+      uint32_t *x = a + s, *y = a + s + h;
+      for (size_t j = 0; j < h; j += 8) {
+        __m256i u = _mm256_loadu_si256((const __m256i *)(x + j));
+        __m256i v = _mm256_loadu_si256((const __m256i *)(y + j));
+        __m256i tw = _mm256_loadu_si256((const __m256i *)(w + h + j));
+        __m256i twp = _mm256_loadu_si256((const __m256i *)(wp + h + j));
+        __m256i d = _mm256_add_epi32(_mm256_sub_epi32(u, v), vp2);
+        _mm256_storeu_si256((__m256i *)(x + j), rt_ntt32_reduce_avx2(_mm256_add_epi32(u, v), vp2));
+        _mm256_storeu_si256((__m256i *)(y + j), rt_ntt32_shoup_avx2(d, tw, twp, vp));
+      }
+    }
+  }
+  for (; h >= 1; h >>= 1)
+    rt_ntt32_forward_stage(a, n, h, w, wp, p);
+}
+
+__attribute__((target("avx2"))) static void rt_ntt32_inverse_avx2(uint32_t *a, int log,
+                                                                  const uint32_t *w,
+                                                                  const uint32_t *wp, uint32_t p) {
+  size_t n = (size_t)1 << log, h = 1;
+  __m256i vp = _mm256_set1_epi32((int)p), vp2 = _mm256_set1_epi32((int)(2 * p));
+  for (; h < n && h < 8; h <<= 1)
+    rt_ntt32_inverse_stage(a, n, h, w, wp, p);
+  for (; h < n; h <<= 1) {
+    for (size_t s = 0; s < n; s += 2 * h) {
+      uint32_t *x = a + s, *y = a + s + h;
+      for (size_t j = 0; j < h; j += 8) {
+        __m256i u = _mm256_loadu_si256((const __m256i *)(x + j));
+        __m256i tw = _mm256_loadu_si256((const __m256i *)(w + h + j));
+        __m256i twp = _mm256_loadu_si256((const __m256i *)(wp + h + j));
+        __m256i t = rt_ntt32_shoup_avx2(_mm256_loadu_si256((const __m256i *)(y + j)), tw, twp, vp);
+        __m256i sum = _mm256_add_epi32(u, t);
+        __m256i dif = _mm256_add_epi32(_mm256_sub_epi32(u, t), vp2);
+        _mm256_storeu_si256((__m256i *)(x + j), rt_ntt32_reduce_avx2(sum, vp2));
+        _mm256_storeu_si256((__m256i *)(y + j), rt_ntt32_reduce_avx2(dif, vp2));
+      }
+    }
+  }
+}
+
+__attribute__((target("avx2"))) static void rt_ntt32_pointwise_avx2(uint32_t *a, const uint32_t *b,
+                                                                    size_t n, uint32_t p,
+                                                                    uint32_t pinv) {
+  __m256i vp = _mm256_set1_epi32((int)p), vi = _mm256_set1_epi32((int)pinv);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = rt_ntt32_reduce_avx2(_mm256_loadu_si256((const __m256i *)(a + i)), vp);
+    __m256i y = rt_ntt32_reduce_avx2(_mm256_loadu_si256((const __m256i *)(b + i)), vp);
+    __m256i te = _mm256_mul_epu32(x, y);
+    __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+    __m256i ue = _mm256_add_epi64(te, _mm256_mul_epu32(_mm256_mul_epu32(te, vi), vp));
+    __m256i uo = _mm256_add_epi64(to, _mm256_mul_epu32(_mm256_mul_epu32(to, vi), vp));
+    __m256i u = _mm256_blend_epi32(_mm256_srli_epi64(ue, 32), uo, 0xAA);
+    _mm256_storeu_si256((__m256i *)(a + i), rt_ntt32_reduce_avx2(u, vp));
+  }
+  rt_ntt32_pointwise_scalar(a + i, b + i, n - i, p, pinv);
+}
+
+__attribute__((target("avx2"))) static void rt_ntt32_scale_avx2(uint32_t *a, size_t n, uint32_t c,
+                                                                uint32_t cp, uint32_t p) {
+  __m256i vp = _mm256_set1_epi32((int)p), vc = _mm256_set1_epi32((int)c),
+          vcp = _mm256_set1_epi32((int)cp);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = rt_ntt32_shoup_avx2(_mm256_loadu_si256((const __m256i *)(a + i)), vc, vcp, vp);
+    _mm256_storeu_si256((__m256i *)(a + i), rt_ntt32_reduce_avx2(x, vp));
+  }
+  rt_ntt32_scale_scalar(a + i, n - i, c, cp, p);
+}
+#endif
+
+static bool rt_ntt_have_avx2(void) {
+#if defined(RT_NTT_X86_DISPATCH)
+  static int have = -1;
+  if (have < 0) {
+    __builtin_cpu_init();
+    have = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return have != 0;
+#else
+  return false;
+#endif
+}
+
+static void rt_ntt32_forward(uint32_t *a, int log, const uint32_t *w, const uint32_t *wp,
+                             uint32_t p) {
+#if defined(RT_NTT_X86_DISPATCH)
+  if (rt_ntt_have_avx2()) {
+    rt_ntt32_forward_avx2(a, log, w, wp, p);
+    return;
+  }
+#endif
+  size_t n = (size_t)1 << log;
+  for (size_t h = n >> 1; h >= 1; h >>= 1)
+    rt_ntt32_forward_stage(a, n, h, w, wp, p);
+}
+
+static void rt_ntt32_inverse(uint32_t *a, int log, const uint32_t *w, const uint32_t *wp,
+                             uint32_t p) {
+#if defined(RT_NTT_X86_DISPATCH)
+  if (rt_ntt_have_avx2()) {
+    rt_ntt32_inverse_avx2(a, log, w, wp, p);
+    return;
+  }
+#endif
+  size_t n = (size_t)1 << log;
+  for (size_t h = 1; h < n; h <<= 1)
+    rt_ntt32_inverse_stage(a, n, h, w, wp, p);
+}
+
+static void rt_ntt32_pointwise(uint32_t *a, const uint32_t *b, size_t n, uint32_t p) {
+  uint32_t pinv = (uint32_t)rt_ntt_mont_inv(p);
+#if defined(RT_NTT_X86_DISPATCH)
+  if (rt_ntt_have_avx2()) {
+    rt_ntt32_pointwise_avx2(a, b, n, p, pinv);
+    return;
+  }
+#endif
+  rt_ntt32_pointwise_scalar(a, b, n, p, pinv);
+}
+
+static void rt_ntt32_scale(uint32_t *a, size_t n, uint32_t c, uint32_t p) {
+  uint32_t cp = (uint32_t)rt_ntt_shoup_pre(c, p, false);
+#if defined(RT_NTT_X86_DISPATCH)
+  if (rt_ntt_have_avx2()) {
+    rt_ntt32_scale_avx2(a, n, c, cp, p);
+    return;
+  }
+#endif
+  rt_ntt32_scale_scalar(a, n, c, cp, p);
+}
+
+/* ---- coefficient lists ---------------------------------------------------- */
+
+static bool rt_ntt_is_num(int64_t v) {
+  if (is_int(v))
+    return true;
+  return is_ptr(v) && is_heap_ptr(v) && *(int64_t *)((char *)(uintptr_t)v - 8) == TAG_BIGINT;
+}
+
+static inline bool rt_ntt_is_seq(int64_t v) {
+  if (!is_ptr(v) || !is_heap_ptr(v))
+    return false;
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)v - 8);
+  return tag == TAG_LIST || tag == TAG_TUPLE;
+}
+
+static inline int64_t rt_ntt_seq_len(int64_t v) { return rt_untag_v(*(int64_t *)(uintptr_t)v); }
+
+static inline int64_t rt_ntt_seq_at(int64_t v, int64_t i) {
+  return *(int64_t *)((char *)(uintptr_t)v + 16 + i * 8);
+}
+
+static int64_t rt_ntt_list(int64_t n) {
+  int64_t lst = rt_list_new(rt_tag_v(n));
+  if (lst)
+    *(int64_t *)(uintptr_t)lst = rt_tag_v(n);
+  return lst;
+}
+
+static inline void rt_ntt_list_set(int64_t lst, int64_t i, int64_t v) {
+  *(int64_t *)((char *)(uintptr_t)lst + 16 + i * 8) = v;
+}
+
+static size_t rt_ntt_bitlen(uint64_t x) {
+  size_t b = 0;
+  while (x) {
+    b++;
+    x >>= 1;
+  }
+  return b;
+}
+
+static void rt_ntt_src_free(rt_ntt_src_t *s) {
+  if (s->bz)
+    for (int64_t i = 0; i < s->n; i++)
+      if (s->big[i])
+        mpz_clear(s->bz[i]);
+  free(s->bz);
+  free(s->big);
+  free(s->iv);
+  memset(s, 0, sizeof(*s));
+}
+
+static bool rt_ntt_src_load(rt_ntt_src_t *s, int64_t v) {
+  memset(s, 0, sizeof(*s));
+  s->n = rt_ntt_seq_len(v);
+  if (s->n < 0)
+    return false;
+  s->iv = (int64_t *)malloc((size_t)(s->n ? s->n : 1) * sizeof(int64_t));
+  if (!s->iv)
+    return false;
+  for (int64_t i = 0; i < s->n; i++) {
+    int64_t x = rt_ntt_seq_at(v, i);
+    if (!rt_ntt_is_num(x)) {
+      rt_ntt_src_free(s);
+      return false;
+    }
+    if (is_int(x)) {
+      int64_t y = rt_untag_v(x);
+      s->iv[i] = y;
+      size_t bits = rt_ntt_bitlen(y < 0 ? (uint64_t)0 - (uint64_t)y : (uint64_t)y);
+      if (bits > s->maxbits)
+        s->maxbits = bits;
+      continue;
+    }
+    mpz_t z;
+    _bi_val_to_mpz(x, z);
+    size_t bits = mpz_sgn(z) ? mpz_sizeinbase(z, 2) : 0;
+    if (bits > s->maxbits)
+      s->maxbits = bits;
+    if (bits <= 62) {
+      s->iv[i] = _bi_mpz_get_i64(z);
+      mpz_clear(z);
+      continue;
+    }
+    if (!s->bz) {
+      s->bz = (mpz_t *)malloc((size_t)s->n * sizeof(mpz_t));
+      s->big = (uint8_t *)calloc((size_t)s->n, 1);
+      if (!s->bz || !s->big) {
+        mpz_clear(z);
+        free(s->bz);
+        s->bz = NULL;
+        rt_ntt_src_free(s);
+        return false;
+      }
+    }
+    mpz_init_set(s->bz[i], z);
+    s->big[i] = 1;
+    s->iv[i] = 0;
+    mpz_clear(z);
+  }
+  return true;
+}
+
+static inline bool rt_ntt_src_is_big(const rt_ntt_src_t *s, int64_t i) {
+  return s->big && s->big[i];
+}
+
+static uint64_t rt_ntt_i64_mod(int64_t v, uint64_t p) {
+  if (v >= 0)
+    return (uint64_t)v < p ? (uint64_t)v : (uint64_t)v % p;
+  uint64_t r = ((uint64_t)0 - (uint64_t)v) % p;
+  return r ? p - r : 0;
+}
+
+static uint64_t rt_ntt_mpz_mod(mpz_srcptr z, uint64_t p) {
+  uint64_t r = mpn_mod_1(mpz_limbs_read(z), (mp_size_t)mpz_size(z), (mp_limb_t)p);
+  return mpz_sgn(z) < 0 && r ? p - r : r;
+}
+
+/* Entry i reduced into [0, p), p < 2^62. */
+static uint64_t rt_ntt_src_mod(const rt_ntt_src_t *s, int64_t i, uint64_t p) {
+  if (rt_ntt_src_is_big(s, i))
+    return rt_ntt_mpz_mod(s->bz[i], p);
+  return rt_ntt_i64_mod(s->iv[i], p);
+}
+
+static void rt_ntt_src_get(const rt_ntt_src_t *s, int64_t i, mpz_t out) {
+  if (rt_ntt_src_is_big(s, i))
+    mpz_set(out, s->bz[i]);
+  else
+    _bi_mpz_set_i64(out, s->iv[i]);
+}
+
+static int64_t rt_ntt_box_mpz(const mpz_t z) {
+  if (mpz_sgn(z) == 0 || mpz_sizeinbase(z, 2) <= 62)
+    return rt_tag_v(mpz_sgn(z) ? _bi_mpz_get_i64(z) : 0);
+  return _bi_from_mpz(z);
+}
+
+static int64_t rt_ntt_box_i128(__int128 v) {
+  const __int128 lim = (__int128)1 << 62;
+  if (v > -lim && v < lim)
+    return rt_tag_v((int64_t)v);
+  unsigned __int128 mag = v < 0 ? (unsigned __int128)0 - (unsigned __int128)v : (unsigned __int128)v;
+  uint64_t w[2] = {(uint64_t)mag, (uint64_t)(mag >> 64)};
+  mpz_t z;
+  mpz_init(z);
+  mpz_import(z, 2, -1, sizeof(uint64_t), 0, 0, w);
+  if (v < 0)
+    mpz_neg(z, z);
+  int64_t out = _bi_from_mpz(z);
+  mpz_clear(z);
+  return out;
+}
+
+/*
+ * Folds a product of plen coefficients (mod p) into out[len]: a plain copy when
+ * wrap is 0, mod x^n - 1 for wrap = n > 0 and mod x^n + 1 for wrap = -n.
+ */
+static void rt_ntt_fold(uint64_t *out, const void *prod, bool wide, int64_t plen, int64_t len,
+                        int64_t wrap, uint64_t p) {
+  if (wrap == 0) {
+    for (int64_t j = 0; j < len; j++)
+      out[j] = wide ? ((const uint64_t *)prod)[j] : ((const uint32_t *)prod)[j];
+    return;
+  }
+  int64_t n = wrap < 0 ? -wrap : wrap;
+  memset(out, 0, (size_t)len * sizeof(uint64_t));
+  for (int64_t j = 0; j < plen; j++) {
+    uint64_t v = wide ? ((const uint64_t *)prod)[j] : ((const uint32_t *)prod)[j];
+    if (wrap < 0 && ((j / n) & 1))
+      v = v ? p - v : 0;
+    uint64_t o = out[j % n] + v;
+    out[j % n] = o >= p ? o - p : o;
+  }
+}
+
+/* ---- schoolbook and Karatsuba over a word modulus -------------------------- */
+
+/* r[0 .. na+nb-2] = a * b mod q, inputs in [0, q), q < 2^62. */
+static void rt_ntt_school_word(uint64_t *r, const uint64_t *a, int64_t na, const uint64_t *b,
+                               int64_t nb, uint64_t q) {
+  for (int64_t k = 0; k < na + nb - 1; k++) {
+    int64_t lo = k - nb + 1 > 0 ? k - nb + 1 : 0, hi = k < na - 1 ? k : na - 1;
+    unsigned __int128 acc = 0;
+    int pending = 0;
+    for (int64_t i = lo; i <= hi; i++) {
+      acc += (unsigned __int128)a[i] * b[k - i];
+      /* products stay below 2^124, so fifteen of them cannot overflow */
+      if (++pending == 15) {
+        acc %= q;
+        pending = 0;
+      }
+    }
+    r[k] = (uint64_t)(acc % q);
+  }
+}
+
+/* r[0 .. 2n-2] = a * b mod q for equal lengths; tmp holds 8n words. */
+static void rt_ntt_kara_word(uint64_t *r, const uint64_t *a, const uint64_t *b, int64_t n,
+                             uint64_t q, uint64_t *tmp) {
+  if (n <= RT_NTT_SCHOOL) {
+    rt_ntt_school_word(r, a, n, b, n, q);
+    return;
+  }
+  int64_t h = (n + 1) / 2, l = n - h;
+  uint64_t *sa = tmp, *sb = tmp + h, *z1 = tmp + 2 * h, *rest = tmp + 4 * h;
+  rt_ntt_kara_word(r, a, b, h, q, rest);
+  r[2 * h - 1] = 0;
+  rt_ntt_kara_word(r + 2 * h, a + h, b + h, l, q, rest);
+  for (int64_t i = 0; i < h; i++) {
+    uint64_t x = a[i] + (i < l ? a[h + i] : 0), y = b[i] + (i < l ? b[h + i] : 0);
+    sa[i] = x >= q ? x - q : x;
+    sb[i] = y >= q ? y - q : y;
+  }
+  rt_ntt_kara_word(z1, sa, sb, h, q, rest);
+  /* z1 - z0 - z2 first: adding into r in the same pass would clobber z0 and z2 */
+  for (int64_t i = 0; i < 2 * h - 1; i++) {
+    uint64_t v = z1[i], z0 = r[i], z2 = i < 2 * l - 1 ? r[2 * h + i] : 0;
+    v = v >= z0 ? v - z0 : v + q - z0;
+    z1[i] = v >= z2 ? v - z2 : v + q - z2;
+  }
+  for (int64_t i = 0; i < 2 * h - 1; i++) {
+    uint64_t o = r[h + i] + z1[i];
+    r[h + i] = o >= q ? o - q : o;
+  }
+}
+
+/* Unbalanced operands: Karatsuba on chunks of the longer one. */
+static bool rt_ntt_kara_chunked(uint64_t *r, const uint64_t *a, int64_t na, const uint64_t *b,
+                                int64_t nb, uint64_t q) {
+  if (na < nb) {
+    const uint64_t *t = a;
+    a = b;
+    b = t;
+    int64_t tn = na;
+    na = nb;
+    nb = tn;
+  }
+  int64_t m = nb;
+  uint64_t *buf = (uint64_t *)malloc((size_t)(11 * m + 64) * sizeof(uint64_t));
+  if (!buf)
+    return false;
+  uint64_t *chunk = buf, *prod = buf + m, *tmp = buf + 3 * m;
+  memset(r, 0, (size_t)(na + nb - 1) * sizeof(uint64_t));
+  for (int64_t off = 0; off < na; off += m) {
+    int64_t c = na - off < m ? na - off : m;
+    memcpy(chunk, a + off, (size_t)c * sizeof(uint64_t));
+    memset(chunk + c, 0, (size_t)(m - c) * sizeof(uint64_t));
+    rt_ntt_kara_word(prod, chunk, b, m, q, tmp);
+    for (int64_t i = 0; i < 2 * m - 1 && off + i < na + nb - 1; i++) {
+      uint64_t o = r[off + i] + prod[i];
+      r[off + i] = o >= q ? o - q : o;
+    }
+  }
+  free(buf);
+  return true;
+}
+
+/* ---- multi-prime NTT and CRT ---------------------------------------------- */
+
+/*
+ * Residues of the folded product of a and b modulo k NTT primes of one width:
+ * res[i * len + j] for prime ps[i].
+ */
+static bool rt_ntt_residues(const rt_ntt_src_t *a, const rt_ntt_src_t *b, int64_t wrap,
+                            int64_t len, int k, bool wide, int log, uint64_t *ps, uint64_t *res) {
+  rt_ntt_view_t views[RT_NTT_P62_MAX];
+  if (!rt_ntt_prepare(wide, k, log, ps, views))
+    return false;
+  size_t n = (size_t)1 << log, word = wide ? sizeof(uint64_t) : sizeof(uint32_t);
+  bool square = a == b;
+  int64_t plen = a->n + b->n - 1;
+  void *fa = malloc(n * word), *fb = square ? NULL : malloc(n * word);
+  if (!fa || (!square && !fb)) {
+    free(fa);
+    free(fb);
+    return false;
+  }
+  for (int i = 0; i < k; i++) {
+    uint64_t p = ps[i];
+    size_t tn = (size_t)1 << views[i].log;
+    uint64_t c = rt_ntt_mulmod(rt_ntt_invmod(n % p, p),
+                               wide ? (uint64_t)(((unsigned __int128)1 << 64) % p)
+                                    : (UINT64_C(1) << 32) % p,
+                               p);
+    for (int side = 0; side < (square ? 1 : 2); side++) {
+      const rt_ntt_src_t *s = side ? b : a;
+      void *f = side ? fb : fa;
+      if (wide) {
+        uint64_t *x = (uint64_t *)f;
+        for (int64_t j = 0; j < s->n; j++)
+          x[j] = rt_ntt_src_mod(s, j, p);
+        memset(x + s->n, 0, (n - (size_t)s->n) * word);
+        const uint64_t *w = (const uint64_t *)views[i].tab;
+        rt_ntt64_forward(x, log, w, w + tn, p);
+      } else {
+        uint32_t *x = (uint32_t *)f;
+        for (int64_t j = 0; j < s->n; j++)
+          x[j] = (uint32_t)rt_ntt_src_mod(s, j, p);
+        memset(x + s->n, 0, (n - (size_t)s->n) * word);
+        const uint32_t *w = (const uint32_t *)views[i].tab;
+        rt_ntt32_forward(x, log, w, w + tn, (uint32_t)p);
+      }
+    }
+    if (wide) {
+      const uint64_t *iw = (const uint64_t *)views[i].tab + 2 * tn;
+      rt_ntt64_pointwise((uint64_t *)fa, (const uint64_t *)(square ? fa : fb), n, p);
+      rt_ntt64_inverse((uint64_t *)fa, log, iw, iw + tn, p);
+      rt_ntt64_scale((uint64_t *)fa, (size_t)plen, c, p);
+    } else {
+      const uint32_t *iw = (const uint32_t *)views[i].tab + 2 * tn;
+      rt_ntt32_pointwise((uint32_t *)fa, (const uint32_t *)(square ? fa : fb), n, (uint32_t)p);
+      rt_ntt32_inverse((uint32_t *)fa, log, iw, iw + tn, (uint32_t)p);
+      rt_ntt32_scale((uint32_t *)fa, (size_t)plen, (uint32_t)c, (uint32_t)p);
+    }
+    rt_ntt_fold(res + (size_t)i * (size_t)len, fa, wide, plen, len, wrap, p);
+  }
+  free(fa);
+  free(fb);
+  return true;
+}
+
+typedef struct {
+  int k;
+  const uint64_t *ps;
+  uint64_t *inv, *invp; /* [j * k + i] = ps[j]^-1 mod ps[i], j < i */
+} rt_ntt_crt_t;
+
+static bool rt_ntt_crt_init(rt_ntt_crt_t *c, const uint64_t *ps, int k) {
+  c->k = k;
+  c->ps = ps;
+  c->inv = (uint64_t *)calloc((size_t)(k * k) * 2, sizeof(uint64_t));
+  if (!c->inv)
+    return false;
+  c->invp = c->inv + k * k;
+  for (int i = 0; i < k; i++)
+    for (int j = 0; j < i; j++) {
+      uint64_t v = rt_ntt_invmod(ps[j] % ps[i], ps[i]);
+      c->inv[j * k + i] = v;
+      c->invp[j * k + i] = rt_ntt_shoup_pre(v, ps[i], true);
+    }
+  return true;
+}
+
+/* Mixed-radix digits v of the residues r: x = v0 + p0 (v1 + p1 (v2 + ...)). */
+static void rt_ntt_crt_digits(const rt_ntt_crt_t *c, const uint64_t *res, int64_t len, int64_t j,
+                              uint64_t *v) {
+  for (int i = 0; i < c->k; i++) {
+    uint64_t p = c->ps[i], t = res[(size_t)i * (size_t)len + (size_t)j];
+    for (int m = 0; m < i; m++) {
+      /* primes descend within a width and all share one bit length, so v[m] < 2p */
+      uint64_t vm = v[m] >= p ? v[m] - p : v[m];
+      t = t >= vm ? t - vm : t + p - vm;
+      t = rt_ntt_shoup64(t, c->inv[m * c->k + i], c->invp[m * c->k + i], p);
+      t = t >= p ? t - p : t;
+    }
+    v[i] = t;
+  }
+}
+
+/* ---- products ------------------------------------------------------------- */
+
+/* Picks width and prime count for a coefficient bound of `bits` bits, or fails. */
+static bool rt_ntt_plan(size_t bits, int log, bool *wide, int *k) {
+  int k30 = (int)(bits / RT_NTT_P30_BITS) + 1, k62 = (int)(bits / RT_NTT_P62_BITS) + 1;
+  /* Garner is quadratic in the prime count: wide coefficients go to 62-bit primes. */
+  if (rt_ntt_have_avx2() && log <= RT_NTT_P30_SHIFT && k30 <= RT_NTT_P30_FAST) {
+    *wide = false;
+    *k = k30;
+    return true;
+  }
+  if (log > RT_NTT_P62_SHIFT || k62 > RT_NTT_P62_MAX)
+    return false;
+  *wide = true;
+  *k = k62;
+  return true;
+}
+
+static int rt_ntt_log(int64_t n) {
+  int log = 0;
+  while (((int64_t)1 << log) < n)
+    log++;
+  return log;
+}
+
+/* Product modulo a word q: values in out[len], [0, q). */
+static bool rt_ntt_mul_word(const rt_ntt_src_t *a, const rt_ntt_src_t *b, uint64_t q, int64_t wrap,
+                            int64_t len, size_t fold_bits, uint64_t *out) {
+  int64_t na = a->n, nb = b->n, plen = na + nb - 1, m = na < nb ? na : nb;
+  bool square = a == b;
+  uint64_t *aq = (uint64_t *)malloc((size_t)(na + (square ? 0 : nb)) * sizeof(uint64_t));
+  if (!aq)
+    return false;
+  uint64_t *bq = square ? aq : aq + na;
+  for (int64_t i = 0; i < na; i++)
+    aq[i] = rt_ntt_src_mod(a, i, q);
+  if (!square)
+    for (int64_t i = 0; i < nb; i++)
+      bq[i] = rt_ntt_src_mod(b, i, q);
+  bool ok = false;
+  if (m <= RT_NTT_KARA) {
+    uint64_t *prod = (uint64_t *)malloc((size_t)plen * sizeof(uint64_t));
+    if (prod) {
+      if (m <= RT_NTT_SCHOOL) {
+        rt_ntt_school_word(prod, aq, na, bq, nb, q);
+        ok = true;
+      } else {
+        ok = rt_ntt_kara_chunked(prod, aq, na, bq, nb, q);
+      }
+      if (ok)
+        rt_ntt_fold(out, prod, true, plen, len, wrap, q);
+      free(prod);
+    }
+    free(aq);
+    return ok;
+  }
+  rt_ntt_src_t ra = {na, (int64_t *)aq, NULL, NULL, 0}, rb = {nb, (int64_t *)bq, NULL, NULL, 0};
+  size_t qbits = rt_ntt_bitlen(q);
+  size_t bits = 2 * qbits + rt_ntt_bitlen((uint64_t)m) + fold_bits;
+  /*
+   * Negacyclic folds can go negative, which Garner would map into [0, M) rather
+   * than onto the right class mod q. Add off = q * ceil(2^bits / q) to every
+   * coefficient first: it keeps the value non-negative and vanishes mod q.
+   */
+  mpz_t off;
+  mpz_init(off);
+  if (wrap < 0) {
+    mpz_t qz;
+    mpz_init(qz);
+    mpz_import(qz, 1, -1, sizeof(uint64_t), 0, 0, &q);
+    mpz_setbit(off, bits);
+    mpz_cdiv_q(off, off, qz);
+    mpz_mul(off, off, qz);
+    mpz_clear(qz);
+    bits += 2;
+  }
+  int log = rt_ntt_log(plen), k = 0;
+  bool wide = false;
+  uint64_t ps[RT_NTT_P62_MAX];
+  uint64_t *res = NULL;
+  rt_ntt_crt_t crt = {0};
+  if (rt_ntt_plan(bits, log, &wide, &k) &&
+      (res = (uint64_t *)malloc((size_t)k * (size_t)len * sizeof(uint64_t))) &&
+      rt_ntt_residues(&ra, square ? &ra : &rb, wrap, len, k, wide, log, ps, res) &&
+      rt_ntt_crt_init(&crt, ps, k)) {
+    uint64_t v[RT_NTT_P62_MAX], pq[RT_NTT_P62_MAX];
+    for (int i = 0; i < k; i++) {
+      pq[i] = ps[i] % q;
+      uint64_t o = mpz_sgn(off) ? rt_ntt_mpz_mod(off, ps[i]) : 0, *ri = res + (size_t)i * (size_t)len;
+      for (int64_t j = 0; o && j < len; j++) {
+        uint64_t t = ri[j] + o;
+        ri[j] = t >= ps[i] ? t - ps[i] : t;
+      }
+    }
+    for (int64_t j = 0; j < len; j++) {
+      rt_ntt_crt_digits(&crt, res, len, j, v);
+      uint64_t acc = v[k - 1] % q;
+      if (q >> 31 == 0) {
+        /* acc * pq + v stays below 2^63: plain 64-bit remainders */
+        for (int i = k - 2; i >= 0; i--)
+          acc = (acc * pq[i] + v[i]) % q;
+      } else {
+        for (int i = k - 2; i >= 0; i--)
+          acc = (uint64_t)(((unsigned __int128)acc * pq[i] + v[i]) % q);
+      }
+      out[j] = acc;
+    }
+    ok = true;
+  }
+  mpz_clear(off);
+  free(crt.inv);
+  free(res);
+  free(aq);
+  return ok;
+}
+
+/* Exact integer product (or modulo a big q): boxed values written to lst. */
+static bool rt_ntt_mul_big(const rt_ntt_src_t *a, const rt_ntt_src_t *b, const mpz_t q, bool has_q,
+                           int64_t wrap, int64_t len, size_t fold_bits, int64_t lst) {
+  int64_t na = a->n, nb = b->n, plen = na + nb - 1, m = na < nb ? na : nb;
+  int64_t n = wrap < 0 ? -wrap : wrap;
+  /* the +1 is the sign: results are rebuilt centered, then reduced mod q if any */
+  size_t bits = (has_q ? 2 * mpz_sizeinbase(q, 2) : a->maxbits + b->maxbits) + 1;
+  bits += rt_ntt_bitlen((uint64_t)m) + fold_bits;
+  if (m <= RT_NTT_SCHOOL && !has_q && bits <= 126 && !a->bz && !b->bz) {
+    __int128 *acc = (__int128 *)calloc((size_t)len, sizeof(__int128));
+    if (!acc)
+      return false;
+    for (int64_t i = 0; i < na; i++)
+      for (int64_t j = 0; j < nb; j++) {
+        __int128 t = (__int128)a->iv[i] * b->iv[j];
+        int64_t d = i + j;
+        if (wrap) {
+          if (wrap < 0 && ((d / n) & 1))
+            t = -t;
+          d %= n;
+        }
+        acc[d] += t;
+      }
+    for (int64_t j = 0; j < len; j++)
+      rt_ntt_list_set(lst, j, rt_ntt_box_i128(acc[j]));
+    free(acc);
+    return true;
+  }
+  mpz_t t, x, y;
+  mpz_inits(t, x, y, NULL);
+  bool ok = false;
+  if (m <= RT_NTT_SCHOOL) {
+    mpz_t *acc = (mpz_t *)malloc((size_t)len * sizeof(mpz_t));
+    if (acc) {
+      for (int64_t j = 0; j < len; j++)
+        mpz_init(acc[j]);
+      for (int64_t i = 0; i < na; i++) {
+        rt_ntt_src_get(a, i, x);
+        for (int64_t j = 0; j < nb; j++) {
+          int64_t d = i + j;
+          bool neg = false;
+          if (wrap) {
+            neg = wrap < 0 && ((d / n) & 1);
+            d %= n;
+          }
+          rt_ntt_src_get(b, j, y);
+          if (neg)
+            mpz_submul(acc[d], x, y);
+          else
+            mpz_addmul(acc[d], x, y);
+        }
+      }
+      for (int64_t j = 0; j < len; j++) {
+        if (has_q)
+          mpz_fdiv_r(acc[j], acc[j], q);
+        rt_ntt_list_set(lst, j, rt_ntt_box_mpz(acc[j]));
+        mpz_clear(acc[j]);
+      }
+      free(acc);
+      ok = true;
+    }
+    mpz_clears(t, x, y, NULL);
+    return ok;
+  }
+  rt_ntt_src_t ra = *a, rb = *b;
+  mpz_t *reduced = NULL;
+  if (has_q) {
+    /* work from residues in [0, q) so the bound depends on q alone */
+    int64_t total = na + (a == b ? 0 : nb);
+    reduced = (mpz_t *)malloc((size_t)total * sizeof(mpz_t));
+    uint8_t *flags = (uint8_t *)malloc((size_t)total);
+    int64_t *iv = (int64_t *)calloc((size_t)total, sizeof(int64_t));
+    if (!reduced || !flags || !iv) {
+      free(reduced);
+      free(flags);
+      free(iv);
+      mpz_clears(t, x, y, NULL);
+      return false;
+    }
+    memset(flags, 1, (size_t)total);
+    for (int64_t i = 0; i < total; i++) {
+      const rt_ntt_src_t *s = i < na ? a : b;
+      mpz_init(reduced[i]);
+      rt_ntt_src_get(s, i < na ? i : i - na, reduced[i]);
+      mpz_fdiv_r(reduced[i], reduced[i], q);
+    }
+    ra = (rt_ntt_src_t){na, iv, reduced, flags, mpz_sizeinbase(q, 2)};
+    rb = a == b ? ra : (rt_ntt_src_t){nb, iv + na, reduced + na, flags + na, ra.maxbits};
+  }
+  int log = rt_ntt_log(plen), k = 0;
+  bool wide = false;
+  uint64_t ps[RT_NTT_P62_MAX];
+  uint64_t *res = NULL;
+  rt_ntt_crt_t crt = {0};
+  if (rt_ntt_plan(bits, log, &wide, &k) &&
+      (res = (uint64_t *)malloc((size_t)k * (size_t)len * sizeof(uint64_t))) &&
+      rt_ntt_residues(&ra, a == b ? &ra : &rb, wrap, len, k, wide, log, ps, res) &&
+      rt_ntt_crt_init(&crt, ps, k)) {
+    mp_limb_t buf[RT_NTT_P62_MAX + 1];
+    uint64_t v[RT_NTT_P62_MAX];
+    mpz_t mod, half;
+    mpz_init_set_ui(mod, 1);
+    for (int i = 0; i < k; i++) {
+      mpz_import(x, 1, -1, sizeof(uint64_t), 0, 0, &ps[i]);
+      mpz_mul(mod, mod, x);
+    }
+    mpz_init(half);
+    mpz_fdiv_q_2exp(half, mod, 1);
+    for (int64_t j = 0; j < len; j++) {
+      rt_ntt_crt_digits(&crt, res, len, j, v);
+      mp_size_t sz = 1;
+      buf[0] = (mp_limb_t)v[k - 1];
+      for (int i = k - 2; i >= 0; i--) {
+        mp_limb_t carry = mpn_mul_1(buf, buf, sz, (mp_limb_t)ps[i]);
+        if (carry)
+          buf[sz++] = carry;
+        carry = mpn_add_1(buf, buf, sz, (mp_limb_t)v[i]);
+        if (carry)
+          buf[sz++] = carry;
+      }
+      while (sz > 0 && buf[sz - 1] == 0)
+        sz--;
+      mpz_t view;
+      mpz_roinit_n(view, buf, sz);
+      if (mpz_cmp(view, half) > 0)
+        mpz_sub(t, view, mod);
+      else
+        mpz_set(t, view);
+      if (has_q)
+        mpz_fdiv_r(t, t, q);
+      rt_ntt_list_set(lst, j, rt_ntt_box_mpz(t));
+    }
+    mpz_clears(mod, half, NULL);
+    ok = true;
+  }
+  free(crt.inv);
+  free(res);
+  if (reduced) {
+    int64_t total = na + (a == b ? 0 : nb);
+    for (int64_t i = 0; i < total; i++)
+      mpz_clear(reduced[i]);
+    free(reduced);
+    free(ra.big);
+    free(ra.iv);
+  }
+  mpz_clears(t, x, y, NULL);
+  return ok;
+}
+
+/*
+ * a * b for integer coefficient lists. modulus nil gives the exact product,
+ * otherwise coefficients in [0, modulus). wrap n > 0 reduces mod x^n - 1,
+ * wrap -n mod x^n + 1. nil when an entry is not an integer, the modulus is not
+ * positive, or the coefficient bound is beyond the NTT primes.
+ */
+int64_t rt_poly_mul(int64_t a_v, int64_t b_v, int64_t m_v, int64_t wrap_v) {
+  if (!rt_ntt_is_seq(a_v) || !rt_ntt_is_seq(b_v) || !is_int(wrap_v))
+    return 0;
+  if (m_v != 0 && !rt_ntt_is_num(m_v))
+    return 0;
+  int64_t wrap = rt_untag_v(wrap_v);
+  bool has_q = m_v != 0;
+  mpz_t q;
+  if (has_q)
+    _bi_val_to_mpz(m_v, q);
+  else
+    mpz_init(q);
+  if (has_q && mpz_sgn(q) <= 0) {
+    mpz_clear(q);
+    return 0;
+  }
+  rt_ntt_src_t a, b;
+  if (!rt_ntt_src_load(&a, a_v)) {
+    mpz_clear(q);
+    return 0;
+  }
+  bool square = a_v == b_v;
+  if (!square && !rt_ntt_src_load(&b, b_v)) {
+    rt_ntt_src_free(&a);
+    mpz_clear(q);
+    return 0;
+  }
+  const rt_ntt_src_t *bp = square ? &a : &b;
+  int64_t plen = a.n && bp->n ? a.n + bp->n - 1 : 0;
+  int64_t n = wrap < 0 ? -wrap : wrap;
+  int64_t len = wrap ? n : plen;
+  size_t fold_bits = wrap && plen > n ? rt_ntt_bitlen((uint64_t)((plen + n - 1) / n)) : 0;
+  int64_t out = rt_ntt_list(len);
+  bool ok = out != 0;
+  if (ok && plen == 0) {
+    for (int64_t j = 0; j < len; j++)
+      rt_ntt_list_set(out, j, rt_tag_v(0));
+  } else if (ok && has_q && mpz_sizeinbase(q, 2) <= RT_NTT_WORD_BITS) {
+    uint64_t qw = (uint64_t)_bi_mpz_get_i64(q);
+    uint64_t *vals = (uint64_t *)malloc((size_t)len * sizeof(uint64_t));
+    ok = vals && rt_ntt_mul_word(&a, bp, qw, wrap, len, fold_bits, vals);
+    for (int64_t j = 0; ok && j < len; j++)
+      rt_ntt_list_set(out, j, rt_tag_v((int64_t)vals[j]));
+    free(vals);
+  } else if (ok) {
+    ok = rt_ntt_mul_big(&a, bp, q, has_q, wrap, len, fold_bits, out);
+  }
+  rt_ntt_src_free(&a);
+  if (!square)
+    rt_ntt_src_free(&b);
+  mpz_clear(q);
+  return ok ? out : 0;
+}
+
+static bool rt_ntt_word_arg(int64_t v, uint64_t *out) {
+  if (!rt_ntt_is_num(v))
+    return false;
+  mpz_t z;
+  _bi_val_to_mpz(v, z);
+  bool ok = mpz_sgn(z) > 0 && mpz_sizeinbase(z, 2) <= RT_NTT_WORD_BITS;
+  if (ok)
+    *out = (uint64_t)_bi_mpz_get_i64(z);
+  mpz_clear(z);
+  return ok;
+}
+
+/*
+ * Natural-order transform A_k = sum a_j w^(jk) mod p for a power-of-two length,
+ * p an odd prime below 2^62 and w of order len(a); inverse runs with w^-1 and
+ * scales by len^-1. Twiddles are built per call since w is the caller's.
+ */
+int64_t rt_ntt_transform(int64_t a_v, int64_t p_v, int64_t w_v, int64_t inv_v) {
+  uint64_t p = 0, w = 0;
+  if (!rt_ntt_is_seq(a_v) || !rt_ntt_word_arg(p_v, &p) || p < 3 || !(p & 1) ||
+      !rt_ntt_is_num(w_v))
+    return 0;
+  int64_t n = rt_ntt_seq_len(a_v);
+  if (n < 1 || (n & (n - 1)))
+    return 0;
+  rt_ntt_src_t src;
+  if (!rt_ntt_src_load(&src, a_v))
+    return 0;
+  if (is_int(w_v)) {
+    w = rt_ntt_i64_mod(rt_untag_v(w_v), p);
+  } else {
+    mpz_t z;
+    _bi_val_to_mpz(w_v, z);
+    w = rt_ntt_mpz_mod(z, p);
+    mpz_clear(z);
+  }
+  bool inverse = rt_untag_v(inv_v) != 0;
+  if (inverse)
+    w = rt_ntt_invmod(w, p);
+  int log = rt_ntt_log(n);
+  uint64_t *x = (uint64_t *)malloc((size_t)n * sizeof(uint64_t));
+  void *tab = w ? rt_ntt_build(p, w, log, true) : NULL;
+  int64_t out = x && tab ? rt_ntt_list(n) : 0;
+  if (out) {
+    for (int64_t i = 0; i < n; i++)
+      x[i] = rt_ntt_src_mod(&src, i, p);
+    rt_ntt64_forward(x, log, (const uint64_t *)tab, (const uint64_t *)tab + n, p);
+    for (int64_t i = 0; i < n; i++) {
+      int64_t j = 0;
+      for (int b = 0; b < log; b++)
+        j |= ((i >> b) & 1) << (log - 1 - b);
+      if (i < j) {
+        uint64_t t = x[i];
+        x[i] = x[j];
+        x[j] = t;
+      }
+    }
+    uint64_t c = inverse ? rt_ntt_invmod((uint64_t)n % p, p) : 1;
+    rt_ntt64_scale(x, (size_t)n, c, p);
+    for (int64_t i = 0; i < n; i++)
+      rt_ntt_list_set(out, i, rt_tag_v((int64_t)x[i]));
+  }
+  free(tab);
+  free(x);
+  rt_ntt_src_free(&src);
+  return out;
+}
+
+/*
+ * Primitive n-th root of unity mod a prime p < 2^62: g^((p-1)/n) for the
+ * smallest g >= 2 whose power has order exactly n. nil when n does not divide
+ * p - 1.
+ */
+int64_t rt_ntt_root(int64_t n_v, int64_t p_v) {
+  uint64_t p = 0;
+  if (!is_int(n_v) || !rt_ntt_word_arg(p_v, &p) || p < 2)
+    return 0;
+  int64_t n = rt_untag_v(n_v);
+  if (n < 1 || (p - 1) % (uint64_t)n)
+    return 0;
+  uint64_t primes[64];
+  int np = 0;
+  uint64_t r = (uint64_t)n;
+  for (uint64_t d = 2; d * d <= r; d++)
+    if (r % d == 0) {
+      primes[np++] = d;
+      while (r % d == 0)
+        r /= d;
+    }
+  if (r > 1)
+    primes[np++] = r;
+  uint64_t k = (p - 1) / (uint64_t)n;
+  for (uint64_t g = 2; g < p; g++) {
+    uint64_t root = rt_ntt_powmod(g, k, p);
+    bool ok = true;
+    for (int i = 0; ok && i < np; i++)
+      ok = rt_ntt_powmod(root, (uint64_t)n / primes[i], p) != 1;
+    if (ok)
+      return rt_tag_v((int64_t)root);
+  }
+  return 0;
+}
@@ -20,14 +20,17 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <termios.h>
 #include <unistd.h>
 #endif
 #ifdef __linux__
+#include <linux/errqueue.h>
 #include <pty.h>
 #include <utmp.h>
 #include <sys/inotify.h>
+#include <sys/sendfile.h>
 #endif
 #ifdef __APPLE__
 #include <sys/event.h>
@@ -1084,6 +1087,21 @@ int64_t rt_tty_size(int64_t out_ptr) {
 #endif
 }
 
+int64_t rt_file_size(int64_t path) {
+  if (!is_v_str(path))
+    return rt_tag_v(-1);
+#ifdef _WIN32
+  struct _stat64 st;
+  if (_stat64((const char *)(uintptr_t)path, &st) != 0 || !(st.st_mode & _S_IFREG))
+    return rt_tag_v(-1);
+#else
+  struct stat st;
+  if (stat((const char *)(uintptr_t)path, &st) != 0 || !S_ISREG(st.st_mode))
+    return rt_tag_v(-1);
+#endif
+  return rt_tag_v((int64_t)st.st_size);
+}
+
 int64_t rt_is_dir(int64_t path) {
   intptr_t rpath = (intptr_t)((path & 1) ? (path >> 1) : path);
 #ifdef _WIN32
@@ -1190,6 +1208,117 @@ int64_t rt_dir_close(int64_t handle) {
 #endif
 }
 
+/*
+ * File views: a view is a Ny string whose bytes are the file's own pages, so
+ * str/JSON/CSV routines read it without a copy. Only the length and tag sit in
+ * front of the data; the pages are recorded in a registry keyed by the string
+ * pointer, so releasing a view never reads through memory that may already be
+ * unmapped. Views carry TAG_STR rather than TAG_STR_CONST: the per-thread
+ * constant-string caches must not remember an address that later goes away.
+ * A view is owned like a heap block; free() (or unmap) releases it.
+ */
+#define RT_FS_VIEW_HEAD 16
+#define RT_FS_VIEW_BUCKETS 64u
+
+typedef struct rt_fs_view_entry {
+  ny_file_view_t view;
+  struct rt_fs_view_entry *next;
+} rt_fs_view_entry_t;
+
+static atomic_flag g_fs_view_lock = ATOMIC_FLAG_INIT;
+static _Atomic size_t g_fs_view_live = 0;
+static rt_fs_view_entry_t *g_fs_views[RT_FS_VIEW_BUCKETS];
+
+static inline void rt_fs_view_lock(void) {
+  while (atomic_flag_test_and_set_explicit(&g_fs_view_lock, memory_order_acquire)) {
+  }
+}
+
+static inline void rt_fs_view_unlock(void) {
+  atomic_flag_clear_explicit(&g_fs_view_lock, memory_order_release);
+}
+
+static inline size_t rt_fs_view_bucket(uintptr_t p) {
+  return (p >> 4) & (RT_FS_VIEW_BUCKETS - 1u);
+}
+
+/* Finds the entry for a view pointer; with take set it is also unlinked. */
+static rt_fs_view_entry_t *rt_fs_view_find_locked(uintptr_t p, bool take) {
+  rt_fs_view_entry_t **slot = &g_fs_views[rt_fs_view_bucket(p)];
+  while (*slot && (uintptr_t)(*slot)->view.data != p)
+    slot = &(*slot)->next;
+  rt_fs_view_entry_t *e = *slot;
+  if (e && take)
+    *slot = e->next;
+  return e;
+}
+
+static bool rt_fs_view_of(int64_t view_v, ny_file_view_t *out) {
+  if (!view_v || (view_v & 7) || atomic_load_explicit(&g_fs_view_live, memory_order_relaxed) == 0)
+    return false;
+  rt_fs_view_lock();
+  rt_fs_view_entry_t *e = rt_fs_view_find_locked((uintptr_t)view_v, false);
+  if (e)
+    *out = e->view;
+  rt_fs_view_unlock();
+  return e != NULL;
+}
+
+bool rt_fs_view_release(int64_t view_v) {
+  if (!view_v || (view_v & 7) || atomic_load_explicit(&g_fs_view_live, memory_order_relaxed) == 0)
+    return false;
+  rt_fs_view_lock();
+  rt_fs_view_entry_t *e = rt_fs_view_find_locked((uintptr_t)view_v, true);
+  rt_fs_view_unlock();
+  if (!e)
+    return false;
+  atomic_fetch_sub_explicit(&g_fs_view_live, 1, memory_order_relaxed);
+  ny_file_view_close(&e->view);
+  free(e);
+  return true;
+}
+
+int64_t rt_fs_map(int64_t path_v, int64_t off_v, int64_t len_v, int64_t advice_v) {
+  if (!is_v_str(path_v))
+    return 0;
+  int64_t off = is_int(off_v) ? rt_untag_v(off_v) : 0, len = is_int(len_v) ? rt_untag_v(len_v) : -1;
+  if (off < 0)
+    return 0;
+  rt_fs_view_entry_t *e = malloc(sizeof(*e));
+  if (!e)
+    return 0;
+  ny_file_view_t *v = &e->view;
+  if (!ny_file_view_open(v, (const char *)(uintptr_t)path_v, (size_t)off,
+                         len < 0 ? SIZE_MAX : (size_t)len, RT_FS_VIEW_HEAD)) {
+    free(e);
+    return 0;
+  }
+  int64_t *h = (int64_t *)(void *)(v->data - RT_FS_VIEW_HEAD);
+  h[0] = ((int64_t)v->len << 1) | 1;
+  h[1] = TAG_STR;
+  ny_file_view_seal(v);
+  ny_file_view_advise(v, (ny_file_advice_t)(is_int(advice_v) ? rt_untag_v(advice_v) : 0));
+  rt_fs_view_lock();
+  size_t b = rt_fs_view_bucket((uintptr_t)v->data);
+  e->next = g_fs_views[b];
+  g_fs_views[b] = e;
+  rt_fs_view_unlock();
+  atomic_fetch_add_explicit(&g_fs_view_live, 1, memory_order_relaxed);
+  return (int64_t)(uintptr_t)v->data;
+}
+
+int64_t rt_fs_map_advise(int64_t view_v, int64_t advice_v) {
+  ny_file_view_t v;
+  if (!rt_fs_view_of(view_v, &v))
+    return rt_tag_v(-1);
+  ny_file_view_advise(&v, (ny_file_advice_t)rt_untag_v(advice_v));
+  return rt_tag_v(v.map_len ? 1 : 0);
+}
+
+int64_t rt_fs_unmap(int64_t view_v) {
+  return rt_tag_v(rt_fs_view_release(view_v) ? 0 : -1);
+}
+
 #ifdef _WIN32
 static int rt_ws_init_done = 0;
 static void rt_ws_init(void) {
@@ -1503,6 +1632,296 @@ int64_t rt_closesocket(int64_t fd) {
   return rt_tag_v((int64_t)r);
 }
 
+/* ---- Scatter/gather and file sends ------------------------------------------------- */
+
+#define RT_SOCK_IOV_MAX 64
+#define RT_SOCK_SEND_ZEROCOPY 1
+#define RT_SOCK_ZEROCOPY_MIN ((size_t)64 * 1024)
+
+#if defined(MSG_NOSIGNAL)
+#define RT_SOCK_NOSIGNAL MSG_NOSIGNAL
+#else
+#define RT_SOCK_NOSIGNAL 0
+#endif
+
+static bool rt_sock_part(int64_t v, const char **p, size_t *n) {
+  if (!is_v_str(v))
+    return false;
+  *p = (const char *)(uintptr_t)v;
+  *n = rt_tagged_str_len(v);
+  return true;
+}
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+/* Waits until the kernel has released every page of `sends` zero-copy
+   sendmsg calls, so the caller may reuse or free its buffers. There is no
+   timeout: the pages stay pinned until the stack lets go of them, which it
+   does once the data is acknowledged or the connection is torn down. */
+static void rt_sock_zerocopy_wait(int fd, uint32_t sends) {
+  uint32_t done = 0;
+  while (done < sends) {
+    char ctrl[128];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    if (recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        return;
+      struct pollfd pfd = {fd, 0, 0};
+      if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+        return;
+      continue;
+    }
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      const struct sock_extended_err *ee = (const struct sock_extended_err *)(void *)CMSG_DATA(cm);
+      if (ee->ee_errno == 0 && ee->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+        done += ee->ee_data - ee->ee_info + 1;
+    }
+  }
+}
+#endif
+
+/* Sends every string in `parts` in as few system calls as the socket
+   accepts. With RT_SOCK_SEND_ZEROCOPY, Linux sends of 64 KiB or more use
+   MSG_ZEROCOPY and return once the kernel is done with the buffers.
+   Returns bytes sent, or -1 when nothing could be sent. */
+int64_t rt_sock_sendv(int64_t fd_v, int64_t parts_v, int64_t flags_v) {
+  int64_t fd = rt_untag_v(fd_v), opts = is_int(flags_v) ? rt_untag_v(flags_v) : 0;
+  if (fd < 0 || !is_ptr(parts_v) || !rt_addr_readable_safe((uintptr_t)parts_v, 16))
+    return rt_tag_v(-1);
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)parts_v - 8);
+  if (tag != TAG_LIST && tag != TAG_TUPLE)
+    return rt_tag_v(-1);
+  int64_t count = rt_untag_v(*(int64_t *)(uintptr_t)parts_v);
+  const int64_t *items = (const int64_t *)(uintptr_t)(parts_v + 16);
+  size_t total = 0;
+  for (int64_t i = 0; i < count; i++) {
+    const char *p;
+    size_t n;
+    if (!rt_sock_part(items[i], &p, &n))
+      return rt_tag_v(-1);
+    total += n;
+  }
+  size_t sent = 0;
+#ifdef _WIN32
+  (void)opts;
+  for (int64_t i = 0; i < count; i++) {
+    const char *p = NULL;
+    size_t n = 0, off = 0;
+    rt_sock_part(items[i], &p, &n);
+    while (off < n) {
+      int chunk = n - off > (size_t)INT_MAX ? INT_MAX : (int)(n - off);
+      int r = send((SOCKET)fd, p + off, chunk, 0);
+      if (r <= 0)
+        return rt_tag_v(sent ? (int64_t)sent : -1);
+      off += (size_t)r;
+      sent += (size_t)r;
+    }
+  }
+#else
+  int send_flags = RT_SOCK_NOSIGNAL;
+  uint32_t zc_sends = 0;
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  if ((opts & RT_SOCK_SEND_ZEROCOPY) && total >= RT_SOCK_ZEROCOPY_MIN) {
+    int one = 1;
+    if (setsockopt((int)fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0)
+      send_flags |= MSG_ZEROCOPY;
+  }
+#else
+  (void)opts;
+#endif
+  int64_t idx = 0;
+  size_t skip = 0; /* bytes of items[idx] already sent */
+  while (idx < count) {
+    struct iovec iov[RT_SOCK_IOV_MAX];
+    int niov = 0;
+    for (int64_t i = idx; i < count && niov < RT_SOCK_IOV_MAX; i++) {
+      const char *p = NULL;
+      size_t n = 0;
+      rt_sock_part(items[i], &p, &n);
+      size_t from = i == idx ? skip : 0;
+      if (n > from) {
+        iov[niov].iov_base = (void *)(p + from);
+        iov[niov].iov_len = n - from;
+        niov++;
+      }
+    }
+    if (!niov)
+      break;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (size_t)niov;
+    ssize_t r = sendmsg((int)fd, &msg, send_flags);
+#if defined(__linux__) && defined(MSG_ZEROCOPY)
+    if (r < 0 && errno == ENOBUFS && (send_flags & MSG_ZEROCOPY)) {
+      send_flags &= ~MSG_ZEROCOPY;
+      continue;
+    }
+    if (r > 0 && (send_flags & MSG_ZEROCOPY))
+      zc_sends++;
+#endif
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      break;
+    sent += (size_t)r;
+    for (size_t left = (size_t)r; left && idx < count;) {
+      const char *p = NULL;
+      size_t n = 0;
+      rt_sock_part(items[idx], &p, &n);
+      size_t rest = n - skip;
+      if (left < rest) {
+        skip += left;
+        left = 0;
+      } else {
+        left -= rest;
+        idx++;
+        skip = 0;
+      }
+    }
+    while (idx < count) {
+      const char *p = NULL;
+      size_t n = 0;
+      rt_sock_part(items[idx], &p, &n);
+      if (n > skip)
+        break;
+      idx++;
+      skip = 0;
+    }
+  }
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  if (zc_sends)
+    rt_sock_zerocopy_wait((int)fd, zc_sends);
+#endif
+#endif
+  (void)total;
+  return rt_tag_v(sent || !total ? (int64_t)sent : -1);
+}
+
+/* Receives into caller-owned memory: up to `len` bytes at buf+off, or, when
+   `wrap` is positive, into the free span of a ring of that capacity that
+   starts at `off` and may wrap to the start of buf. */
+int64_t rt_sock_recv_into(int64_t fd_v, int64_t buf_v, int64_t off_v, int64_t len_v,
+                          int64_t wrap_v) {
+  int64_t fd = rt_untag_v(fd_v), off = rt_untag_v(off_v), len = rt_untag_v(len_v);
+  int64_t wrap = is_int(wrap_v) ? rt_untag_v(wrap_v) : 0;
+  char *buf = (char *)(uintptr_t)(is_int(buf_v) ? rt_untag_v(buf_v) : buf_v);
+  if (fd < 0 || !buf || off < 0 || len <= 0 || (wrap > 0 && (off >= wrap || len > wrap)))
+    return rt_tag_v(-1);
+#ifdef _WIN32
+  int64_t first = wrap > 0 && off + len > wrap ? wrap - off : len;
+  int r = recv((SOCKET)fd, buf + off, (int)(first > INT_MAX ? INT_MAX : first), 0);
+  return rt_tag_v((int64_t)r);
+#else
+  struct iovec iov[2];
+  int niov = 1;
+  iov[0].iov_base = buf + off;
+  iov[0].iov_len = (size_t)len;
+  if (wrap > 0 && off + len > wrap) {
+    iov[0].iov_len = (size_t)(wrap - off);
+    iov[1].iov_base = buf;
+    iov[1].iov_len = (size_t)(off + len - wrap);
+    niov = 2;
+  }
+  ssize_t r;
+  do {
+    r = readv((int)fd, iov, niov);
+  } while (r < 0 && errno == EINTR);
+  return rt_tag_v((int64_t)r);
+#endif
+}
+
+/* Sends `len` bytes of a file (a path or an open descriptor) from `off`
+   without staging them in user memory where the platform allows: sendfile
+   on Linux (which splices through the page cache) and the BSDs/macOS, a
+   pread/send loop elsewhere. len -1 sends to the end of the file. Returns
+   bytes sent, or -1 when nothing could be sent. */
+int64_t rt_sock_sendfile(int64_t fd_v, int64_t file_v, int64_t off_v, int64_t len_v) {
+  int64_t fd = rt_untag_v(fd_v), off = rt_untag_v(off_v), len = rt_untag_v(len_v);
+  if (fd < 0 || off < 0)
+    return rt_tag_v(-1);
+  bool owned = is_v_str(file_v);
+#ifdef _WIN32
+  FILE *f = owned ? fopen((const char *)(uintptr_t)file_v, "rb") : NULL;
+  if (!f)
+    return rt_tag_v(-1);
+  if (_fseeki64(f, off, SEEK_SET) != 0) {
+    fclose(f);
+    return rt_tag_v(-1);
+  }
+  char chunk[65536];
+  int64_t sent = 0;
+  while (len < 0 || sent < len) {
+    size_t want = len < 0 || len - sent > (int64_t)sizeof(chunk) ? sizeof(chunk) : (size_t)(len - sent);
+    size_t got = fread(chunk, 1, want, f), at = 0;
+    while (at < got) {
+      int r = send((SOCKET)fd, chunk + at, (int)(got - at), 0);
+      if (r <= 0) {
+        fclose(f);
+        return rt_tag_v(sent ? sent : -1);
+      }
+      at += (size_t)r;
+      sent += r;
+    }
+    if (got < want)
+      break;
+  }
+  fclose(f);
+  return rt_tag_v(sent);
+#else
+  int in = owned ? open((const char *)(uintptr_t)file_v, O_RDONLY | O_CLOEXEC) : (int)rt_untag_v(file_v);
+  if (in < 0)
+    return rt_tag_v(-1);
+  struct stat st;
+  if (fstat(in, &st) != 0 || off > st.st_size) {
+    if (owned)
+      close(in);
+    return rt_tag_v(-1);
+  }
+  if (len < 0 || off + len > st.st_size)
+    len = st.st_size - off;
+  int64_t sent = 0;
+  while (sent < len) {
+#if defined(__linux__)
+    off_t pos = (off_t)(off + sent);
+    ssize_t r = sendfile((int)fd, in, &pos, (size_t)(len - sent));
+#elif defined(__APPLE__)
+    off_t n = (off_t)(len - sent);
+    ssize_t r = sendfile(in, (int)fd, (off_t)(off + sent), &n, NULL, 0) == 0 || n > 0 ? (ssize_t)n : -1;
+#elif defined(__FreeBSD__)
+    off_t n = 0;
+    ssize_t r = sendfile(in, (int)fd, (off_t)(off + sent), (size_t)(len - sent), NULL, &n, 0) == 0 || n > 0
+                    ? (ssize_t)n
+                    : -1;
+#else
+    char chunk[65536];
+    size_t want = len - sent > (int64_t)sizeof(chunk) ? sizeof(chunk) : (size_t)(len - sent);
+    ssize_t got = pread(in, chunk, want, (off_t)(off + sent)), r = got;
+    for (ssize_t at = 0; got > 0 && at < got; at += r) {
+      r = send((int)fd, chunk + at, (size_t)(got - at), RT_SOCK_NOSIGNAL);
+      if (r <= 0) {
+        got = at;
+        break;
+      }
+    }
+    r = got;
+#endif
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      break;
+    sent += r;
+  }
+  if (owned)
+    close(in);
+  return rt_tag_v(sent || !len ? sent : -1);
+#endif
+}
+
 int64_t rt_spawn_wait(int64_t path, int64_t argv) {
   intptr_t rpath = (intptr_t)((path & 1) ? (path >> 1) : path);
   intptr_t rargv = (intptr_t)((argv & 1) ? (argv >> 1) : argv);
@@ -2149,6 +2568,28 @@ static bool rt_async_snapshot_send(rt_async_task *t, const void *src,
   return true;
 }
 
+/* Only compiled string literals live as long as the program and never
+ * change, so only those are sent in place. Everything else, file views and
+ * heap strings included, is snapshotted because the caller may free it
+ * while the send is pending. */
+static bool rt_async_str_is_literal(int64_t raw) {
+  int64_t tag = 0;
+  ny_file_view_t view;
+  return rt_try_read_i64((uintptr_t)raw - 8, &tag) && tag == TAG_STR_CONST &&
+         !is_heap_ptr(raw) && !rt_fs_view_of(raw, &view);
+}
+
+static bool rt_async_prepare_send(rt_async_task *t, int64_t str_v, int64_t off, int64_t len) {
+  const char *src = (const char *)(uintptr_t)rt_async_raw(str_v) + off;
+  if (t && len >= 0 && rt_async_str_is_literal(rt_async_raw(str_v))) {
+    t->send_buf = NULL;
+    t->buf = (int64_t)(uintptr_t)src;
+    t->len = len;
+    return true;
+  }
+  return rt_async_snapshot_send(t, src, len);
+}
+
 static rt_async_task *rt_async_task_alloc(rt_async_kind kind) {
   rt_async_task *t = (rt_async_task *)calloc(1, sizeof(rt_async_task));
   if (!t)
@@ -2711,8 +3152,7 @@ int64_t rt_async_write_socket_part(int64_t fd, int64_t data, int64_t off, int64_
   rt_async_task *t = rt_async_task_alloc(RT_ASYNC_SEND);
   if (!t)
     return 0;
-  if (!rt_async_snapshot_send(t, (const void *)(uintptr_t)(raw_data + raw_off),
-                              raw_size)) {
+  if (!rt_async_prepare_send(t, data, raw_off, raw_size)) {
     rt_async_all_remove(t);
     rt_async_task_free(t);
     return 0;
@@ -2729,8 +3169,7 @@ int64_t rt_async_write_socket_all(int64_t fd, int64_t data) {
   rt_async_task *t = rt_async_task_alloc(RT_ASYNC_WRITE_ALL);
   if (!t)
     return 0;
-  if (!rt_async_snapshot_send(t, (const void *)(uintptr_t)raw_data,
-                              (int64_t)rt_tagged_str_len(data))) {
+  if (!rt_async_prepare_send(t, data, 0, (int64_t)rt_tagged_str_len(data))) {
     rt_async_all_remove(t);
     rt_async_task_free(t);
     return 0;
@@ -0,0 +1,298 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Call-site feedback for profile-guided builds.
+ *
+ * Code compiled with --pgo-gen reports every direct call to a user function
+ * through __pgo_site (site and callee ids are hashes computed by the
+ * compiler) and the runtime class of each untyped argument through
+ * __pgo_arg. Sites live in a fixed open-addressed table claimed with a CAS
+ * on the site id, so worker threads can record without a lock. At exit the
+ * table is merged with any existing profile at NYTRIX_PGO_GEN (or
+ * nytrix.nypgo) and written back, so several training runs accumulate.
+ * Processes exiting together serialise the read-merge-rename on an advisory
+ * lock on <path>.lock, and each writes its own temp file before the rename.
+ *
+ * The file is plain text, one site per line:
+ *
+ *   NYPGO1
+ *   <site-hex> <callee-hex> <calls> <nargs> <int flt str list other>...
+ */
+
+#define RT_PGO_MAX_SITES 8192u
+#define RT_PGO_MAX_ARGS 6u
+
+enum {
+  RT_PGO_KIND_INT,
+  RT_PGO_KIND_FLOAT,
+  RT_PGO_KIND_STR,
+  RT_PGO_KIND_LIST,
+  RT_PGO_KIND_OTHER,
+  RT_PGO_KINDS
+};
+
+typedef struct {
+  uint64_t site;
+  uint64_t callee;
+  uint64_t calls;
+  uint64_t nargs;
+  uint64_t kinds[RT_PGO_MAX_ARGS][RT_PGO_KINDS];
+} rt_pgo_site_t;
+
+static rt_pgo_site_t *rt_pgo_sites;
+static int rt_pgo_state; /* 0 idle, 1 initialising, 2 ready, -1 failed */
+
+static void rt_pgo_dump(void);
+
+static bool rt_pgo_ready(void) {
+  int st = __atomic_load_n(&rt_pgo_state, __ATOMIC_ACQUIRE);
+  if (st == 2)
+    return true;
+  if (st < 0)
+    return false;
+  int expected = 0;
+  if (__atomic_compare_exchange_n(&rt_pgo_state, &expected, 1, false,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    rt_pgo_sites = calloc(RT_PGO_MAX_SITES, sizeof(rt_pgo_site_t));
+    if (rt_pgo_sites)
+      atexit(rt_pgo_dump);
+    __atomic_store_n(&rt_pgo_state, rt_pgo_sites ? 2 : -1, __ATOMIC_RELEASE);
+    return rt_pgo_sites != NULL;
+  }
+  while ((st = __atomic_load_n(&rt_pgo_state, __ATOMIC_ACQUIRE)) == 1) {
+  }
+  return st == 2;
+}
+
+static rt_pgo_site_t *rt_pgo_slot(uint64_t site, bool create) {
+  if (site == 0)
+    site = 1;
+  uint32_t mask = RT_PGO_MAX_SITES - 1u;
+  uint32_t i = (uint32_t)(site ^ (site >> 29)) & mask;
+  for (uint32_t probe = 0; probe < RT_PGO_MAX_SITES; probe++) {
+    rt_pgo_site_t *s = &rt_pgo_sites[(i + probe) & mask];
+    uint64_t cur = __atomic_load_n(&s->site, __ATOMIC_ACQUIRE);
+    if (cur == site)
+      return s;
+    if (cur != 0)
+      continue;
+    if (!create)
+      return NULL;
+    uint64_t expected = 0;
+    if (__atomic_compare_exchange_n(&s->site, &expected, site, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+        expected == site)
+      return s;
+  }
+  return NULL;
+}
+
+static int rt_pgo_kind_of(int64_t v) {
+  if (is_int(v))
+    return RT_PGO_KIND_INT;
+  if (is_v_flt(v))
+    return RT_PGO_KIND_FLOAT;
+  int64_t tag = rt_untag_v(rt_tagof(v));
+  switch (tag) {
+  case TAG_FLOAT:
+    return RT_PGO_KIND_FLOAT;
+  case TAG_STR:
+  case TAG_STR_CONST:
+    return RT_PGO_KIND_STR;
+  case TAG_LIST:
+    return RT_PGO_KIND_LIST;
+  default:
+    return RT_PGO_KIND_OTHER;
+  }
+}
+
+int64_t rt_pgo_site(int64_t site, int64_t callee) {
+  if (!rt_pgo_ready())
+    return 0;
+  rt_pgo_site_t *s = rt_pgo_slot((uint64_t)site, true);
+  if (!s)
+    return 0;
+  if (__atomic_load_n(&s->callee, __ATOMIC_RELAXED) == 0)
+    __atomic_store_n(&s->callee, (uint64_t)callee, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&s->calls, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+int64_t rt_pgo_arg(int64_t site, int64_t idx, int64_t v) {
+  if (idx < 0 || (uint64_t)idx >= RT_PGO_MAX_ARGS || !rt_pgo_ready())
+    return 0;
+  rt_pgo_site_t *s = rt_pgo_slot((uint64_t)site, true);
+  if (!s)
+    return 0;
+  uint64_t need = (uint64_t)idx + 1u;
+  uint64_t have = __atomic_load_n(&s->nargs, __ATOMIC_RELAXED);
+  while (have < need &&
+         !__atomic_compare_exchange_n(&s->nargs, &have, need, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+  __atomic_fetch_add(&s->kinds[idx][rt_pgo_kind_of(v)], 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+static const char *rt_pgo_path(void) {
+  const char *p = getenv("NYTRIX_PGO_GEN");
+  if (!p || !*p || strcmp(p, "1") == 0)
+    return "nytrix.nypgo";
+  return p;
+}
+
+static void rt_pgo_merge_existing(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return;
+  char line[1024];
+  if (!fgets(line, sizeof(line), f) || strncmp(line, "NYPGO1", 6) != 0) {
+    fclose(f);
+    return;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    char *p = line;
+    char *end = NULL;
+    uint64_t site = strtoull(p, &end, 16);
+    if (end == p)
+      continue;
+    p = end;
+    uint64_t callee = strtoull(p, &end, 16);
+    p = end;
+    uint64_t calls = strtoull(p, &end, 10);
+    p = end;
+    uint64_t nargs = strtoull(p, &end, 10);
+    p = end;
+    rt_pgo_site_t *s = rt_pgo_slot(site, true);
+    if (!s)
+      break;
+    if (!s->callee)
+      s->callee = callee;
+    s->calls += calls;
+    if (nargs > RT_PGO_MAX_ARGS)
+      nargs = RT_PGO_MAX_ARGS;
+    if (nargs > s->nargs)
+      s->nargs = nargs;
+    for (uint64_t a = 0; a < nargs; a++) {
+      for (int k = 0; k < RT_PGO_KINDS; k++) {
+        s->kinds[a][k] += strtoull(p, &end, 10);
+        p = end;
+      }
+    }
+  }
+  fclose(f);
+}
+
+/* Exclusive advisory lock on <path>.lock; -1 / NULL when unavailable, in
+ * which case the dump still goes ahead unserialised. */
+#ifdef _WIN32
+static HANDLE rt_pgo_lock(const char *lock_path) {
+  HANDLE h = CreateFileA(lock_path, GENERIC_READ | GENERIC_WRITE,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE)
+    return NULL;
+  OVERLAPPED ov;
+  memset(&ov, 0, sizeof(ov));
+  if (!LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov)) {
+    CloseHandle(h);
+    return NULL;
+  }
+  return h;
+}
+
+static void rt_pgo_unlock(HANDLE h) {
+  if (!h)
+    return;
+  OVERLAPPED ov;
+  memset(&ov, 0, sizeof(ov));
+  UnlockFileEx(h, 0, 1, 0, &ov);
+  CloseHandle(h);
+}
+#else
+static int rt_pgo_lock(const char *lock_path) {
+  int fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return -1;
+  while (flock(fd, LOCK_EX) != 0) {
+    if (errno != EINTR) {
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+static void rt_pgo_unlock(int fd) {
+  if (fd < 0)
+    return;
+  (void)flock(fd, LOCK_UN);
+  close(fd);
+}
+#endif
+
+static void rt_pgo_dump(void) {
+  if (__atomic_load_n(&rt_pgo_state, __ATOMIC_ACQUIRE) != 2)
+    return;
+  const char *path = rt_pgo_path();
+  size_t plen = strlen(path);
+  size_t cap = plen + 64;
+  char *tmp = malloc(cap);
+  char *lock_path = malloc(cap);
+  if (!tmp || !lock_path) {
+    free(tmp);
+    free(lock_path);
+    return;
+  }
+  snprintf(lock_path, cap, "%s.lock", path);
+  snprintf(tmp, cap, "%s.%ld_%llu.tmp", path, (long)getpid(),
+           (unsigned long long)ny_ticks_now());
+#ifdef _WIN32
+  HANDLE lock = rt_pgo_lock(lock_path);
+#else
+  int lock = rt_pgo_lock(lock_path);
+#endif
+  rt_pgo_merge_existing(path);
+  FILE *f = fopen(tmp, "w");
+  if (!f) {
+    rt_pgo_unlock(lock);
+    free(tmp);
+    free(lock_path);
+    return;
+  }
+  fputs("NYPGO1\n", f);
+  for (uint32_t i = 0; i < RT_PGO_MAX_SITES; i++) {
+    rt_pgo_site_t *s = &rt_pgo_sites[i];
+    if (!s->site || !s->calls)
+      continue;
+    fprintf(f, "%016llx %016llx %llu %llu", (unsigned long long)s->site,
+            (unsigned long long)s->callee, (unsigned long long)s->calls,
+            (unsigned long long)s->nargs);
+    for (uint64_t a = 0; a < s->nargs && a < RT_PGO_MAX_ARGS; a++)
+      for (int k = 0; k < RT_PGO_KINDS; k++)
+        fprintf(f, " %llu", (unsigned long long)s->kinds[a][k]);
+    fputc('\n', f);
+  }
+  bool ok = fclose(f) == 0;
+#if defined(_WIN32)
+  if (ok)
+    remove(path);
+#endif
+  if (!ok || rename(tmp, path) != 0)
+    remove(tmp);
+  rt_pgo_unlock(lock);
+  free(tmp);
+  free(lock_path);
+}
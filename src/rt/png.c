@@ -0,0 +1,734 @@
+#include "base/compat.h"
+#include "rt/shared.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RT_PNG_SSE2 1
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RT_PNG_NEON 1
+#endif
+
+/*
+ * Scanline kernels for std.math.parse.img.png.
+ *
+ * Decoding inflates the IDAT chunks straight into the scanline buffer and
+ * reverses each row's filter as soon as zlib has produced all of it, so the
+ * buffer is walked once while it is still in cache. Rows are unfiltered in
+ * place and their filter byte is cleared; callers only ever see filter 0.
+ * Up runs 16 bytes at a time; Sub, Average and Paeth depend on the pixel to
+ * the left, so for 3 to 8 bytes per pixel they run one whole pixel per
+ * vector step (the approach libpng takes), and byte by byte below that.
+ *
+ * Encoding picks a filter per row by the minimum sum of absolute differences
+ * heuristic, with every candidate computed in one vector pass. The filtered
+ * rows are then cut into bands that deflate on separate threads, each primed
+ * with the previous 32 KiB as its dictionary and ended with a sync flush so
+ * the raw streams concatenate into one zlib stream (the scheme pigz uses).
+ */
+
+#define RT_PNG_MAX_THREADS RT_MAX_THREADS
+#define RT_PNG_BAND ((size_t)128 << 10)
+#define RT_PNG_WINDOW ((size_t)32 << 10)
+
+static int g_rt_png_threads = -1;
+
+static int rt_png_thread_count(void) {
+  return rt_thread_count(&g_rt_png_threads, "NYTRIX_PNG_THREADS", 0, RT_PNG_MAX_THREADS);
+}
+
+static inline uint8_t rt_png_paeth(int a, int b, int c) {
+  int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+  if (pa <= pb && pa <= pc)
+    return (uint8_t)a;
+  return (uint8_t)(pb <= pc ? b : c);
+}
+
+/* ---- Unfiltering --------------------------------------------------------- */
+
+/* `prev` is the unfiltered row above, or a zero row for the first row. */
+static void rt_png_unfilter_scalar(uint8_t *row, const uint8_t *prev, size_t n, size_t bpp,
+                                   int filter) {
+  size_t i;
+  switch (filter) {
+  case 1:
+    for (i = bpp; i < n; i++)
+      row[i] = (uint8_t)(row[i] + row[i - bpp]);
+    break;
+  case 2:
+    for (i = 0; i < n; i++)
+      row[i] = (uint8_t)(row[i] + prev[i]);
+    break;
+  case 3:
+    for (i = 0; i < bpp && i < n; i++)
+      row[i] = (uint8_t)(row[i] + (prev[i] >> 1));
+    for (; i < n; i++)
+      row[i] = (uint8_t)(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+    break;
+  case 4:
+    for (i = 0; i < bpp && i < n; i++)
+      row[i] = (uint8_t)(row[i] + prev[i]);
+    for (; i < n; i++)
+      row[i] = (uint8_t)(row[i] + rt_png_paeth(row[i - bpp], prev[i], prev[i - bpp]));
+    break;
+  default:
+    break;
+  }
+}
+
+#if defined(RT_PNG_SSE2) || defined(RT_PNG_NEON)
+static inline uint64_t rt_png_load_px(const uint8_t *p, size_t bpp) {
+  uint64_t v = 0;
+  memcpy(&v, p, bpp);
+  return v;
+}
+#endif
+
+#if defined(RT_PNG_SSE2)
+
+static inline __m128i rt_png_abs16(__m128i x) {
+  return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i rt_png_select(__m128i m, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/* Paeth predictor over 16-bit lanes. */
+static inline __m128i rt_png_paeth16(__m128i a, __m128i b, __m128i c) {
+  __m128i pa = _mm_sub_epi16(b, c), pb = _mm_sub_epi16(a, c);
+  __m128i pc = rt_png_abs16(_mm_add_epi16(pa, pb));
+  pa = rt_png_abs16(pa);
+  pb = rt_png_abs16(pb);
+  __m128i least = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+  return rt_png_select(_mm_cmpeq_epi16(least, pa), a,
+                       rt_png_select(_mm_cmpeq_epi16(least, pb), b, c));
+}
+
+static inline __m128i rt_png_avg_floor(__m128i a, __m128i b) {
+  __m128i odd = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+  return _mm_sub_epi8(_mm_avg_epu8(a, b), odd);
+}
+
+static inline __m128i rt_png_ld(const uint8_t *p, size_t bpp) {
+  return _mm_cvtsi64_si128((long long)rt_png_load_px(p, bpp));
+}
+
+static inline void rt_png_st(uint8_t *p, __m128i v, size_t bpp) {
+  uint64_t x = (uint64_t)_mm_cvtsi128_si64(v);
+  memcpy(p, &x, bpp);
+}
+
+static void rt_png_unfilter_simd(uint8_t *row, const uint8_t *prev, size_t n, size_t bpp,
+                                 int filter) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  size_t i = 0;
+  switch (filter) {
+  case 1:
+    for (; i + bpp <= n; i += bpp) {
+      a = _mm_add_epi8(rt_png_ld(row + i, bpp), a);
+      rt_png_st(row + i, a, bpp);
+    }
+    break;
+  case 3:
+    for (; i + bpp <= n; i += bpp) {
+      __m128i b = rt_png_ld(prev + i, bpp);
+      a = _mm_add_epi8(rt_png_ld(row + i, bpp), rt_png_avg_floor(a, b));
+      rt_png_st(row + i, a, bpp);
+    }
+    break;
+  case 4:
+    for (; i + bpp <= n; i += bpp) {
+      __m128i b = _mm_unpacklo_epi8(rt_png_ld(prev + i, bpp), zero);
+      __m128i d = _mm_unpacklo_epi8(rt_png_ld(row + i, bpp), zero);
+      a = _mm_and_si128(_mm_add_epi16(d, rt_png_paeth16(a, b, c)), _mm_set1_epi16(0xff));
+      rt_png_st(row + i, _mm_packus_epi16(a, a), bpp);
+      c = b;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void rt_png_unfilter_up(uint8_t *row, const uint8_t *prev, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(const void *)(row + i)),
+                             _mm_loadu_si128((const __m128i *)(const void *)(prev + i)));
+    _mm_storeu_si128((__m128i *)(void *)(row + i), v);
+  }
+  for (; i < n; i++)
+    row[i] = (uint8_t)(row[i] + prev[i]);
+}
+
+#elif defined(RT_PNG_NEON)
+
+static inline uint8x8_t rt_png_paeth8(uint8x8_t a, uint8x8_t b, uint8x8_t c) {
+  uint16x8_t pa = vmovl_u8(vabd_u8(b, c)), pb = vmovl_u8(vabd_u8(a, c));
+  uint16x8_t pc = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+  uint8x8_t use_a = vmovn_u16(vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+  uint8x8_t use_b = vmovn_u16(vcleq_u16(pb, pc));
+  return vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+}
+
+static inline uint8x8_t rt_png_ld(const uint8_t *p, size_t bpp) {
+  return vcreate_u8(rt_png_load_px(p, bpp));
+}
+
+static inline void rt_png_st(uint8_t *p, uint8x8_t v, size_t bpp) {
+  uint64_t x = vget_lane_u64(vreinterpret_u64_u8(v), 0);
+  memcpy(p, &x, bpp);
+}
+
+static void rt_png_unfilter_simd(uint8_t *row, const uint8_t *prev, size_t n, size_t bpp,
+                                 int filter) {
+  uint8x8_t a = vdup_n_u8(0), c = vdup_n_u8(0);
+  size_t i = 0;
+  switch (filter) {
+  case 1:
+    for (; i + bpp <= n; i += bpp) {
+      a = vadd_u8(rt_png_ld(row + i, bpp), a);
+      rt_png_st(row + i, a, bpp);
+    }
+    break;
+  case 3:
+    for (; i + bpp <= n; i += bpp) {
+      a = vadd_u8(rt_png_ld(row + i, bpp), vhadd_u8(a, rt_png_ld(prev + i, bpp)));
+      rt_png_st(row + i, a, bpp);
+    }
+    break;
+  case 4:
+    for (; i + bpp <= n; i += bpp) {
+      uint8x8_t b = rt_png_ld(prev + i, bpp);
+      a = vadd_u8(rt_png_ld(row + i, bpp), rt_png_paeth8(a, b, c));
+      rt_png_st(row + i, a, bpp);
+      c = b;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void rt_png_unfilter_up(uint8_t *row, const uint8_t *prev, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    vst1q_u8(row + i, vaddq_u8(vld1q_u8(row + i), vld1q_u8(prev + i)));
+  for (; i < n; i++)
+    row[i] = (uint8_t)(row[i] + prev[i]);
+}
+
+#endif
+
+static bool g_rt_png_scalar = false;
+
+static void rt_png_unfilter_row(uint8_t *row, const uint8_t *prev, size_t n, size_t bpp,
+                                int filter) {
+#if defined(RT_PNG_SSE2) || defined(RT_PNG_NEON)
+  if (!g_rt_png_scalar) {
+    if (filter == 2) {
+      rt_png_unfilter_up(row, prev, n);
+      return;
+    }
+    if (bpp >= 3 && bpp <= 8 && n % bpp == 0) {
+      rt_png_unfilter_simd(row, prev, n, bpp, filter);
+      return;
+    }
+  }
+#endif
+  rt_png_unfilter_scalar(row, prev, n, bpp, filter);
+}
+
+/* ---- Row layout ---------------------------------------------------------- */
+
+/* A non-interlaced image is one pass; Adam7 has seven, some possibly empty. */
+typedef struct {
+  int npass;
+  size_t stride[7];
+  size_t rows[7];
+  size_t bpp;
+} rt_png_layout_t;
+
+static void rt_png_layout(rt_png_layout_t *l, size_t w, size_t h, size_t bits, bool interlace) {
+  static const uint8_t x0[7] = {0, 4, 0, 2, 0, 1, 0}, y0[7] = {0, 0, 4, 0, 2, 0, 1};
+  static const uint8_t xs[7] = {8, 8, 4, 4, 2, 2, 1}, ys[7] = {8, 8, 8, 4, 4, 2, 2};
+  l->bpp = bits < 8 ? 1 : bits / 8;
+  l->npass = interlace ? 7 : 1;
+  for (int p = 0; p < l->npass; p++) {
+    size_t pw = interlace ? (w + xs[p] - 1 - x0[p]) / xs[p] : w;
+    size_t ph = interlace ? (h + ys[p] - 1 - y0[p]) / ys[p] : h;
+    if (interlace && (w <= x0[p] || h <= y0[p]))
+      pw = ph = 0;
+    l->stride[p] = (pw * bits + 7) / 8;
+    l->rows[p] = pw ? ph : 0;
+  }
+}
+
+/* Walks rows in stream order, unfiltering each one once it is complete. */
+typedef struct {
+  rt_png_layout_t l;
+  int pass;
+  size_t row;
+  size_t at; /* offset of the current row's filter byte */
+  uint8_t *zero;
+} rt_png_walk_t;
+
+static void rt_png_walk_skip_empty(rt_png_walk_t *wk) {
+  while (wk->pass < wk->l.npass && wk->row >= wk->l.rows[wk->pass]) {
+    wk->pass++;
+    wk->row = 0;
+  }
+}
+
+/* Unfilters every row that lies within raw[0, avail); false on a bad filter. */
+static bool rt_png_walk(rt_png_walk_t *wk, uint8_t *raw, size_t avail) {
+  for (rt_png_walk_skip_empty(wk); wk->pass < wk->l.npass; rt_png_walk_skip_empty(wk)) {
+    size_t stride = wk->l.stride[wk->pass];
+    if (wk->at + 1 + stride > avail)
+      return true;
+    uint8_t *row = raw + wk->at + 1;
+    int filter = raw[wk->at];
+    if (filter > 4)
+      return false;
+    if (filter) {
+      const uint8_t *prev = wk->row ? row - stride - 1 : wk->zero;
+      rt_png_unfilter_row(row, prev, stride, wk->l.bpp, filter);
+      raw[wk->at] = 0;
+    }
+    wk->at += 1 + stride;
+    wk->row++;
+  }
+  return true;
+}
+
+static bool rt_png_list_items(int64_t lst, int64_t **items, size_t *n) {
+  if (!is_ptr(lst) || !rt_addr_readable_safe((uintptr_t)lst, 16))
+    return false;
+  int64_t tag = *(int64_t *)((char *)(uintptr_t)lst - 8);
+  if (tag != TAG_LIST && tag != TAG_TUPLE)
+    return false;
+  int64_t len = rt_untag_v(*(int64_t *)(uintptr_t)lst);
+  *n = len > 0 ? (size_t)len : 0;
+  *items = (int64_t *)((char *)(uintptr_t)lst + 16);
+  return true;
+}
+
+/* Inflates the IDAT chunks into raw, unfiltering rows as they complete.
+   Returns the bytes produced, -1 on a zlib error and -2 on a bad filter. */
+int64_t rt_png_inflate_unfilter(int64_t idat_v, int64_t raw_v, int64_t raw_len_v, int64_t w_v,
+                                int64_t h_v, int64_t bits_v, int64_t interlace_v) {
+  int64_t *chunks;
+  size_t nchunks;
+  int64_t raw_len = rt_untag_v(raw_len_v), w = rt_untag_v(w_v), h = rt_untag_v(h_v);
+  int64_t bits = rt_untag_v(bits_v);
+  if (!rt_png_list_items(idat_v, &chunks, &nchunks) || !is_ptr(raw_v) || raw_len <= 0 || w <= 0 ||
+      h <= 0 || bits <= 0 || bits > 64)
+    return rt_tag_v(-1);
+  g_rt_png_scalar = rt_env_enabled("NYTRIX_PNG_SCALAR");
+  uint8_t *raw = (uint8_t *)(uintptr_t)raw_v;
+  rt_png_walk_t wk = {0};
+  rt_png_layout(&wk.l, (size_t)w, (size_t)h, (size_t)bits, rt_untag_v(interlace_v) != 0);
+  size_t widest = 0;
+  for (int p = 0; p < wk.l.npass; p++)
+    widest = wk.l.stride[p] > widest ? wk.l.stride[p] : widest;
+  wk.zero = calloc(1, widest + 16);
+  z_stream z = {0};
+  if (!wk.zero || inflateInit(&z) != Z_OK) {
+    free(wk.zero);
+    return rt_tag_v(-1);
+  }
+  int64_t res = 0;
+  size_t produced = 0;
+  bool end = false;
+  for (size_t ci = 0; ci < nchunks && !end && produced < (size_t)raw_len; ci++) {
+    int64_t c = chunks[ci];
+    if (!is_v_str(c))
+      continue;
+    z.next_in = (Bytef *)(uintptr_t)c;
+    z.avail_in = (uInt)rt_tagged_str_len(c);
+    while (z.avail_in && produced < (size_t)raw_len) {
+      size_t room = (size_t)raw_len - produced;
+      z.next_out = raw + produced;
+      z.avail_out = room > UINT32_MAX ? UINT32_MAX : (uInt)room;
+      int rc = inflate(&z, Z_NO_FLUSH);
+      produced += (size_t)(z.next_out - (raw + produced));
+      if (rc == Z_STREAM_END) {
+        end = true;
+        break;
+      }
+      if (rc != Z_OK && rc != Z_BUF_ERROR) {
+        res = -1;
+        break;
+      }
+      if (!rt_png_walk(&wk, raw, produced)) {
+        res = -2;
+        break;
+      }
+      if (rc == Z_BUF_ERROR)
+        break;
+    }
+    if (res)
+      break;
+  }
+  if (!res && !rt_png_walk(&wk, raw, produced))
+    res = -2;
+  inflateEnd(&z);
+  free(wk.zero);
+  return rt_tag_v(res ? res : (int64_t)produced);
+}
+
+/* ---- Expansion to RGBA --------------------------------------------------- */
+
+/* Expands unfiltered 8-bit rows (filter byte first) to RGBA. `lut` maps
+   gray or palette samples to packed pixels; `trns` is the 8-bit RGB key
+   r | g << 8 | b << 16, or negative. Returns 0, or -1 for other types. */
+int64_t rt_png_expand8(int64_t raw_v, int64_t pixels_v, int64_t w_v, int64_t h_v,
+                       int64_t color_type_v, int64_t lut_v, int64_t trns_v) {
+  int64_t w = rt_untag_v(w_v), h = rt_untag_v(h_v), ct = rt_untag_v(color_type_v);
+  int64_t trns = rt_untag_v(trns_v);
+  if (!is_ptr(raw_v) || !is_ptr(pixels_v) || w <= 0 || h <= 0)
+    return rt_tag_v(-1);
+  static const uint8_t channels[7] = {1, 0, 3, 1, 2, 0, 4};
+  if (ct < 0 || ct > 6 || !channels[ct])
+    return rt_tag_v(-1);
+  const uint32_t *lut = NULL;
+  size_t lut_n = 0;
+  if (ct == 0 || ct == 3) {
+    if (!is_v_str(lut_v))
+      return rt_tag_v(-1);
+    lut = (const uint32_t *)(uintptr_t)lut_v;
+    lut_n = rt_tagged_str_len(lut_v) / 4;
+  }
+  const uint8_t *raw = (const uint8_t *)(uintptr_t)raw_v;
+  uint8_t *out = (uint8_t *)(uintptr_t)pixels_v;
+  size_t stride = (size_t)w * channels[ct];
+  uint32_t key = trns < 0 ? UINT32_MAX : (uint32_t)trns & 0xffffffu;
+  for (int64_t y = 0; y < h; y++) {
+    const uint8_t *s = raw + (size_t)y * (stride + 1) + 1;
+    uint8_t *d = out + (size_t)y * (size_t)w * 4;
+    switch (ct) {
+    case 6:
+      memcpy(d, s, stride);
+      break;
+    case 2:
+      for (int64_t x = 0; x < w; x++, s += 3, d += 4) {
+        uint32_t rgb = (uint32_t)s[0] | (uint32_t)s[1] << 8 | (uint32_t)s[2] << 16;
+        uint32_t px = rgb | (rgb == key ? 0u : 0xff000000u);
+        memcpy(d, &px, 4);
+      }
+      break;
+    case 4:
+      for (int64_t x = 0; x < w; x++, s += 2, d += 4) {
+        d[0] = d[1] = d[2] = s[0];
+        d[3] = s[1];
+      }
+      break;
+    default:
+      for (int64_t x = 0; x < w; x++, d += 4) {
+        uint32_t px = s[x] < lut_n ? lut[s[x]] : 0;
+        memcpy(d, &px, 4);
+      }
+      break;
+    }
+  }
+  return rt_tag_v(0);
+}
+
+/* ---- Filtering ----------------------------------------------------------- */
+
+/* Writes the four filtered candidates of a row into out[0..3] and returns
+   their sums of absolute (signed) differences in sad[0..3]. */
+static void rt_png_filter_scalar(const uint8_t *cur, const uint8_t *prev, size_t n, size_t bpp,
+                                 size_t from, uint8_t *out[4], uint64_t sad[4]) {
+  for (size_t i = from; i < n; i++) {
+    int x = cur[i], b = prev[i];
+    int a = i >= bpp ? cur[i - bpp] : 0, c = i >= bpp ? prev[i - bpp] : 0;
+    uint8_t v[4] = {(uint8_t)(x - a), (uint8_t)(x - b), (uint8_t)(x - ((a + b) >> 1)),
+                    (uint8_t)(x - rt_png_paeth(a, b, c))};
+    for (int f = 0; f < 4; f++) {
+      out[f][i] = v[f];
+      sad[f] += (uint64_t)abs((int8_t)v[f]);
+    }
+  }
+}
+
+#if defined(RT_PNG_SSE2)
+
+static inline uint64_t rt_png_sad(__m128i v) {
+  __m128i m = _mm_min_epu8(v, _mm_sub_epi8(_mm_setzero_si128(), v));
+  __m128i s = _mm_sad_epu8(m, _mm_setzero_si128());
+  return (uint64_t)_mm_cvtsi128_si32(s) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+}
+
+static size_t rt_png_filter_simd(const uint8_t *cur, const uint8_t *prev, size_t n, size_t bpp,
+                                 uint8_t *out[4], uint64_t sad[4]) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = bpp;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(const void *)(cur + i));
+    __m128i a = _mm_loadu_si128((const __m128i *)(const void *)(cur + i - bpp));
+    __m128i b = _mm_loadu_si128((const __m128i *)(const void *)(prev + i));
+    __m128i c = _mm_loadu_si128((const __m128i *)(const void *)(prev + i - bpp));
+    __m128i plo = rt_png_paeth16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+                                 _mm_unpacklo_epi8(c, zero));
+    __m128i phi = rt_png_paeth16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+                                 _mm_unpackhi_epi8(c, zero));
+    __m128i v[4] = {_mm_sub_epi8(x, a), _mm_sub_epi8(x, b), _mm_sub_epi8(x, rt_png_avg_floor(a, b)),
+                    _mm_sub_epi8(x, _mm_packus_epi16(plo, phi))};
+    for (int f = 0; f < 4; f++) {
+      _mm_storeu_si128((__m128i *)(void *)(out[f] + i), v[f]);
+      sad[f] += rt_png_sad(v[f]);
+    }
+  }
+  return i;
+}
+
+#elif defined(RT_PNG_NEON)
+
+static inline uint64_t rt_png_sad(uint8x16_t v) {
+  uint8x16_t m = vreinterpretq_u8_s8(vabsq_s8(vreinterpretq_s8_u8(v)));
+  return vaddlvq_u8(m);
+}
+
+static size_t rt_png_filter_simd(const uint8_t *cur, const uint8_t *prev, size_t n, size_t bpp,
+                                 uint8_t *out[4], uint64_t sad[4]) {
+  size_t i = bpp;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t x = vld1q_u8(cur + i), a = vld1q_u8(cur + i - bpp);
+    uint8x16_t b = vld1q_u8(prev + i), c = vld1q_u8(prev + i - bpp);
+    uint8x16_t p = vcombine_u8(rt_png_paeth8(vget_low_u8(a), vget_low_u8(b), vget_low_u8(c)),
+                               rt_png_paeth8(vget_high_u8(a), vget_high_u8(b), vget_high_u8(c)));
+    uint8x16_t v[4] = {vsubq_u8(x, a), vsubq_u8(x, b), vsubq_u8(x, vhaddq_u8(a, b)),
+                       vsubq_u8(x, p)};
+    for (int f = 0; f < 4; f++) {
+      vst1q_u8(out[f] + i, v[f]);
+      sad[f] += rt_png_sad(v[f]);
+    }
+  }
+  return i;
+}
+
+#endif
+
+/* Filters one row into dst (filter byte first) and returns the filter used. */
+static int rt_png_filter_row(const uint8_t *cur, const uint8_t *prev, size_t n, size_t bpp,
+                             uint8_t *dst, uint8_t *scratch) {
+  uint8_t *out[4] = {scratch, scratch + n, scratch + 2 * n, scratch + 3 * n};
+  uint64_t sad[5] = {0};
+  for (size_t i = 0; i < n; i++)
+    sad[4] += (uint64_t)abs((int8_t)cur[i]);
+  size_t from = 0;
+#if defined(RT_PNG_SSE2) || defined(RT_PNG_NEON)
+  if (!g_rt_png_scalar && n >= bpp + 16) {
+    rt_png_filter_scalar(cur, prev, bpp, bpp, 0, out, sad);
+    from = rt_png_filter_simd(cur, prev, n, bpp, out, sad);
+  }
+#endif
+  rt_png_filter_scalar(cur, prev, n, bpp, from, out, sad);
+  int best = 0;
+  uint64_t best_sad = sad[4];
+  for (int f = 0; f < 4; f++) {
+    if (sad[f] < best_sad) {
+      best_sad = sad[f];
+      best = f + 1;
+    }
+  }
+  dst[0] = (uint8_t)best;
+  memcpy(dst + 1, best ? out[best - 1] : cur, n);
+  return best;
+}
+
+/* ---- Parallel band deflate ----------------------------------------------- */
+
+typedef struct {
+  const uint8_t *pixels;
+  uint8_t *raw;
+  size_t stride, bpp;
+  size_t y0, y1; /* rows of this band */
+  bool adaptive;
+  int level;
+  bool last;
+  int phase; /* 0 filters the rows, 1 deflates them */
+  uint8_t *out;
+  size_t out_len;
+  uLong adler;
+  bool ok;
+} rt_png_band_t;
+
+static void rt_png_band_filter(rt_png_band_t *b) {
+  size_t n = b->stride, row = n + 1;
+  uint8_t *scratch = b->adaptive ? malloc(4 * n + 16) : NULL;
+  if (b->adaptive && !scratch) {
+    b->ok = false;
+    return;
+  }
+  uint8_t *zero = b->y0 == 0 && b->adaptive ? calloc(1, n + 16) : NULL;
+  if (b->y0 == 0 && b->adaptive && !zero) {
+    free(scratch);
+    b->ok = false;
+    return;
+  }
+  for (size_t y = b->y0; y < b->y1; y++) {
+    const uint8_t *cur = b->pixels + y * n;
+    uint8_t *dst = b->raw + y * row;
+    if (!b->adaptive) {
+      dst[0] = 0;
+      memcpy(dst + 1, cur, n);
+      continue;
+    }
+    rt_png_filter_row(cur, y ? cur - n : zero, n, b->bpp, dst, scratch);
+  }
+  free(zero);
+  free(scratch);
+}
+
+static void rt_png_band_deflate(rt_png_band_t *b) {
+  size_t row = b->stride + 1;
+  const uint8_t *src = b->raw + b->y0 * row;
+  size_t len = (b->y1 - b->y0) * row;
+  size_t start = b->y0 * row;
+  z_stream z = {0};
+  if (deflateInit2(&z, b->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    b->ok = false;
+    return;
+  }
+  if (start) {
+    size_t dict = start < RT_PNG_WINDOW ? start : RT_PNG_WINDOW;
+    deflateSetDictionary(&z, src - dict, (uInt)dict);
+  }
+  size_t cap = (size_t)deflateBound(&z, (uLong)len) + 64;
+  b->out = malloc(cap);
+  if (!b->out) {
+    deflateEnd(&z);
+    b->ok = false;
+    return;
+  }
+  z.next_in = (Bytef *)(uintptr_t)src;
+  z.avail_in = (uInt)len;
+  z.next_out = b->out;
+  z.avail_out = (uInt)cap;
+  int rc = deflate(&z, b->last ? Z_FINISH : Z_SYNC_FLUSH);
+  b->ok = b->last ? rc == Z_STREAM_END : rc == Z_OK && z.avail_in == 0;
+  b->out_len = cap - z.avail_out;
+  b->adler = adler32(adler32(0, NULL, 0), src, (uInt)len);
+  deflateEnd(&z);
+}
+
+static void rt_png_band_run(void *arg) {
+  rt_png_band_t *b = (rt_png_band_t *)arg;
+  if (!b->ok)
+    return;
+  if (b->phase == 0)
+    rt_png_band_filter(b);
+  else
+    rt_png_band_deflate(b);
+}
+
+/* Filters and compresses 8-bit RGB or RGBA pixels into the zlib stream that
+   goes into IDAT. Returns a string, or 0 on failure. */
+int64_t rt_png_encode_idat(int64_t pixels_v, int64_t w_v, int64_t h_v, int64_t ch_v,
+                           int64_t level_v) {
+  int64_t w = rt_untag_v(w_v), h = rt_untag_v(h_v), ch = rt_untag_v(ch_v);
+  int level = (int)rt_untag_v(level_v);
+  if (!is_ptr(pixels_v) || w <= 0 || h <= 0 || (ch != 3 && ch != 4))
+    return 0;
+  if (level < -1 || level > 9)
+    level = Z_DEFAULT_COMPRESSION;
+  g_rt_png_scalar = rt_env_enabled("NYTRIX_PNG_SCALAR");
+  size_t stride = (size_t)w * (size_t)ch, row = stride + 1;
+  size_t raw_len = (size_t)h * row;
+  uint8_t *raw = malloc(raw_len);
+  if (!raw)
+    return 0;
+  int nb = (int)(raw_len / RT_PNG_BAND);
+  int threads = rt_png_thread_count();
+  if (nb > threads)
+    nb = threads;
+  if (nb < 1)
+    nb = 1;
+  if ((int64_t)nb > h)
+    nb = (int)h;
+  rt_png_band_t bands[RT_PNG_MAX_THREADS];
+  memset(bands, 0, sizeof(bands));
+  for (int i = 0; i < nb; i++) {
+    rt_png_band_t *b = &bands[i];
+    b->pixels = (const uint8_t *)(uintptr_t)pixels_v;
+    b->raw = raw;
+    b->stride = stride;
+    b->bpp = (size_t)ch;
+    b->y0 = (size_t)h * (size_t)i / (size_t)nb;
+    b->y1 = (size_t)h * (size_t)(i + 1) / (size_t)nb;
+    b->adaptive = level != 0;
+    b->level = level;
+    b->last = i == nb - 1;
+    b->ok = true;
+  }
+  rt_parallel_run(rt_png_band_run, bands, sizeof(bands[0]), nb);
+  for (int i = 0; i < nb; i++)
+    bands[i].phase = 1;
+  rt_parallel_run(rt_png_band_run, bands, sizeof(bands[0]), nb);
+
+  bool ok = true;
+  size_t total = 2 + 4;
+  uLong adler = adler32(0, NULL, 0);
+  for (int i = 0; i < nb; i++) {
+    ok = ok && bands[i].ok;
+    total += bands[i].out_len;
+    adler = adler32_combine(adler, bands[i].adler, (z_off_t)((bands[i].y1 - bands[i].y0) * row));
+  }
+  int64_t out = 0;
+  if (ok)
+    out = rt_malloc((int64_t)(((uint64_t)total + 1u) << 1) | 1);
+  if (out) {
+    uint8_t *o = (uint8_t *)(uintptr_t)out;
+    int lvl = level < 0 ? 6 : level;
+    int flevel = lvl < 2 ? 0 : lvl < 6 ? 1 : lvl == 6 ? 2 : 3;
+    o[0] = 0x78;
+    o[1] = (uint8_t)(flevel << 6);
+    o[1] = (uint8_t)(o[1] + 31 - ((o[0] << 8) | o[1]) % 31);
+    size_t at = 2;
+    for (int i = 0; i < nb; i++) {
+      memcpy(o + at, bands[i].out, bands[i].out_len);
+      at += bands[i].out_len;
+    }
+    o[at++] = (uint8_t)(adler >> 24);
+    o[at++] = (uint8_t)(adler >> 16);
+    o[at++] = (uint8_t)(adler >> 8);
+    o[at++] = (uint8_t)adler;
+    *(int64_t *)((char *)(uintptr_t)out - 8) = TAG_STR;
+    *(int64_t *)((char *)(uintptr_t)out - 16) = ((int64_t)total << 1) | 1;
+    o[total] = '\0';
+  }
+  for (int i = 0; i < nb; i++)
+    free(bands[i].out);
+  free(raw);
+  return out;
+}
+
+/* CRC-32 of buf[start, start + len), as chunks carry it. */
+int64_t rt_png_crc(int64_t buf_v, int64_t start_v, int64_t len_v) {
+  int64_t start = rt_untag_v(start_v), len = rt_untag_v(len_v);
+  if (!is_ptr(buf_v) || start < 0 || len < 0)
+    return rt_tag_v(0);
+  const Bytef *p = (const Bytef *)(uintptr_t)buf_v + start;
+  uLong c = crc32(0L, Z_NULL, 0);
+  while (len > 0) {
+    uInt n = len > (int64_t)UINT32_MAX ? UINT32_MAX : (uInt)len;
+    c = crc32(c, p, n);
+    p += n;
+    len -= n;
+  }
+  return rt_tag_v((int64_t)c);
+}
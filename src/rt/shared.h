@@ -3,6 +3,7 @@
 
 #include "base/compat.h"
 #include "base/util.h"
+#include "base/value.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -37,6 +38,7 @@
 #ifndef _WIN32
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #ifdef __APPLE__
@@ -60,29 +62,10 @@
 #define NY_MAGIC2 0x4E59545249584EULL
 #define NY_MAGIC3 0xDEADBEEFCAFEBABEULL
 
-#define NY_VALUE_INT_TAG_BIT UINT64_C(1)
-#define NY_VALUE_INT_SHIFT 1
-#define NY_VALUE_PTR_TAG_MASK UINT64_C(7)
-#define NY_VALUE_PTR_MIN_ADDR ((uintptr_t)0x1000)
-
-#if UINTPTR_MAX == 0xffffffff
-#define NY_NATIVE_TAG_MASK UINT64_C(3)
-#define NY_NATIVE_TAG UINT64_C(2)
-#define NY_NATIVE_SHIFT 2
-#define NY_NATIVE_MARK (UINT64_C(1) << 63)
-#define NY_NATIVE_IS(v)                                                                            \
-  (((((uint64_t)(v) & NY_NATIVE_MARK) != 0ULL) &&                                                  \
-    (((uint64_t)(v) & NY_NATIVE_TAG_MASK) == NY_NATIVE_TAG)))
-#else
-#define NY_NATIVE_TAG_MASK NY_VALUE_PTR_TAG_MASK
-#define NY_NATIVE_TAG UINT64_C(6)
-#define NY_NATIVE_SHIFT 3
-#define NY_NATIVE_IS(v) ((((uint64_t)(v)) & NY_NATIVE_TAG_MASK) == NY_NATIVE_TAG)
-#endif
-
 #define is_int(v) ((((uint64_t)(v)) & NY_VALUE_INT_TAG_BIT) != 0)
 #define is_ptr(v)                                                                                    \
-  (((((uint64_t)(v)) & NY_VALUE_INT_TAG_BIT) == 0) && (uintptr_t)(v) > NY_VALUE_PTR_MIN_ADDR)
+  (((((uint64_t)(v)) & NY_VALUE_INT_TAG_BIT) == 0) && (uintptr_t)(v) > NY_VALUE_PTR_MIN_ADDR &&     \
+   !ny_value_is_flt_imm((uint64_t)(v)))
 
 static inline bool rt_env_is_truthy(const char *v) {
   return ny_env_is_truthy(v);
@@ -101,6 +84,87 @@ static inline bool rt_env_enabled_default_on(const char *name) {
   return rt_env_is_truthy(v);
 }
 
+/* ---- Worker threads ------------------------------------------------------ */
+
+#define RT_MAX_THREADS 64
+
+/* Worker count for a parallel kernel. `*setting` is the module's override:
+ * -1 until first use, when it is read from `env_name` (or `def` when unset);
+ * 0 means one worker per CPU. The result is clamped to `max`. */
+static inline int rt_thread_count(int *setting, const char *env_name, int def, int max) {
+  if (max > RT_MAX_THREADS)
+    max = RT_MAX_THREADS;
+  if (*setting < 0) {
+    const char *env = getenv(env_name);
+    int n = env && *env ? atoi(env) : def;
+    *setting = n < 0 ? 1 : n;
+  }
+  if (*setting == 0) {
+    long n = ny_cpu_count();
+    return n > max ? max : (int)n;
+  }
+  return *setting > max ? max : *setting;
+}
+
+typedef void (*rt_task_fn)(void *arg);
+
+typedef struct {
+  rt_task_fn fn;
+  void *arg;
+} rt_task_t;
+
+#if defined(_WIN32)
+static inline DWORD WINAPI rt_task_trampoline(LPVOID p) {
+  rt_task_t *t = (rt_task_t *)p;
+  t->fn(t->arg);
+  return 0;
+}
+#else
+static inline void *rt_task_trampoline(void *p) {
+  rt_task_t *t = (rt_task_t *)p;
+  t->fn(t->arg);
+  return NULL;
+}
+#endif
+
+/* Runs fn over `count` argument records `arg_size` bytes apart (0 hands every
+ * worker the same record), on worker threads for all but the first. A worker
+ * that cannot be started runs inline. */
+static inline void rt_parallel_run(rt_task_fn fn, void *args, size_t arg_size, int count) {
+  rt_task_t tasks[RT_MAX_THREADS];
+#if defined(_WIN32)
+  HANDLE th[RT_MAX_THREADS];
+#else
+  pthread_t th[RT_MAX_THREADS];
+#endif
+  bool started[RT_MAX_THREADS] = {false};
+  if (count > RT_MAX_THREADS)
+    count = RT_MAX_THREADS;
+  for (int i = 1; i < count; i++) {
+    tasks[i].fn = fn;
+    tasks[i].arg = (char *)args + (size_t)i * arg_size;
+#if defined(_WIN32)
+    th[i] = CreateThread(NULL, 0, rt_task_trampoline, &tasks[i], 0, NULL);
+    started[i] = th[i] != NULL;
+#else
+    started[i] = pthread_create(&th[i], NULL, rt_task_trampoline, &tasks[i]) == 0;
+#endif
+    if (!started[i])
+      fn(tasks[i].arg);
+  }
+  fn(args);
+  for (int i = 1; i < count; i++) {
+    if (!started[i])
+      continue;
+#if defined(_WIN32)
+    WaitForSingleObject(th[i], INFINITE);
+    CloseHandle(th[i]);
+#else
+    pthread_join(th[i], NULL);
+#endif
+  }
+}
+
 static inline int rt_addr_mapped(uintptr_t p, size_t n) {
   if (p < 0x1000 || n == 0)
     return 0;
@@ -453,7 +517,7 @@ static inline bool is_valid_heap_ptr(int64_t v) {
 #define is_heap_ptr(v) is_valid_heap_ptr(v)
 #define is_any_ptr(v)                                                                               \
   (((v) != 0 && ((((uint64_t)(v)) & NY_VALUE_INT_TAG_BIT) == 0) &&                                  \
-    (uintptr_t)(v) > NY_VALUE_PTR_MIN_ADDR))
+    (uintptr_t)(v) > NY_VALUE_PTR_MIN_ADDR && !ny_value_is_flt_imm((uint64_t)(v))))
 
 #define NY_IMM_NIL ((int64_t)0)
 #define NY_IMM_FALSE ((int64_t)2)
@@ -554,7 +618,7 @@ static inline int64_t rt_runtime_tag_raw_name(const char *s, size_t n) {
 }
 
 static inline int64_t rt_heap_object_ptr(int64_t v) {
-  if (v == 0 || NY_NATIVE_IS(v))
+  if (v == 0 || NY_NATIVE_IS(v) || ny_value_is_flt_imm((uint64_t)v))
     return 0;
   if (is_ptr(v) && (((uint64_t)v) & NY_VALUE_PTR_TAG_MASK) == 0)
     return is_heap_ptr(v) ? v : 0;
@@ -576,6 +640,8 @@ static inline bool ny_small_int_fits_i64(int64_t raw) {
 }
 
 static inline int is_v_flt(int64_t v) {
+  if (ny_value_is_flt_imm((uint64_t)v))
+    return 1;
   if (!is_ptr(v) || (v & 15) != 8)
     return 0;
   uintptr_t p = (uintptr_t)v;
@@ -695,6 +761,8 @@ static inline int64_t _rt_flt_unbox_val(int64_t v) {
     memcpy(&res, &d, 8);
     return res;
   }
+  if (ny_value_is_flt_imm((uint64_t)v))
+    return (int64_t)ny_value_flt_imm_decode((uint64_t)v);
   if (is_v_flt(v)) {
     int64_t bits;
     memcpy(&bits, (const void *)(uintptr_t)v, 8);
@@ -703,6 +771,18 @@ static inline int64_t _rt_flt_unbox_val(int64_t v) {
   return 0;
 }
 
+/* Payload of a float value already known to satisfy is_v_flt. */
+static inline double rt_flt_payload(int64_t v) {
+  double d;
+  if (ny_value_is_flt_imm((uint64_t)v)) {
+    uint64_t bits = ny_value_flt_imm_decode((uint64_t)v);
+    memcpy(&d, &bits, 8);
+  } else {
+    memcpy(&d, (const void *)(uintptr_t)v, 8);
+  }
+  return d;
+}
+
 static inline int64_t _rt_load_item_fast(int64_t lst, int64_t i_v) {
   if (!is_ptr(lst))
     return 0;
@@ -726,6 +806,7 @@ int _ny_aot_set_args(int argc, char **argv, char **envp);
 int64_t rt_malloc(int64_t n);
 int64_t rt_malloc_uninit(int64_t n);
 int64_t rt_free(int64_t ptr);
+bool rt_fs_view_release(int64_t view_v);
 int64_t rt_ptr_key(int64_t ptr);
 int64_t rt_atomic_load64(int64_t addr, int64_t idx);
 int64_t rt_atomic_store64(int64_t addr, int64_t idx, int64_t value);
@@ -1687,14 +1687,14 @@ int64_t rt_simd_mat4_mul(int64_t a_lst, int64_t b_lst, int64_t o_lst) {
     if (is_int(av)) {
       da = (double)(av >> 1);
     } else if (is_v_flt(av)) {
-      memcpy(&da, (void *)(uintptr_t)av, 8);
+      da = rt_flt_payload(av);
     } else {
       da = 0.0;
     }
     if (is_int(bv)) {
       db = (double)(bv >> 1);
     } else if (is_v_flt(bv)) {
-      memcpy(&db, (void *)(uintptr_t)bv, 8);
+      db = rt_flt_payload(bv);
     } else {
       db = 0.0;
     }
@@ -33,10 +33,9 @@ static void rt_val_to_str_info(int64_t v, char *buf, size_t bsize, const char **
     }
     *out_len = len;
     *out_s = p;
-  } else if (is_ptr(v)) {
+  } else if (is_ptr(v) || is_v_flt(v)) {
     if (is_v_flt(v)) {
-      double d;
-      memcpy(&d, (void *)(uintptr_t)v, 8);
+      double d = rt_flt_payload(v);
       *out_len = snprintf(buf, bsize, "%g", d);
       *out_s = buf;
       return;
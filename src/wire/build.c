@@ -1,6 +1,7 @@
 #include "wire/build.h"
 #include "base/common.h"
 #include "base/util.h"
+#include "base/value.h"
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
@@ -343,11 +344,12 @@ static time_t ny_runtime_latest_dep_mtime(const char *root) {
   static const char *const deps[] = {
       "src/rt/init.c",     "src/rt/ast.c",       "src/rt/bigint.c", "src/rt/core.c",
       "src/rt/ffi.c",      "src/rt/ffigates.c",  "src/rt/gc.c",     "src/rt/math.c",
-      "src/rt/memory.c",   "src/rt/os.c",        "src/rt/simmd.c",
-      "src/rt/string.c",
+      "src/rt/memory.c",   "src/rt/ndarray.c",   "src/rt/os.c",     "src/rt/simmd.c",
+      "src/rt/string.c",   "src/rt/lattice.c",   "src/rt/ecm.c",    "src/rt/modarith.c",
       "src/rt/shared.h",   "src/rt/runtime.h",   "src/rt/defs.h",   "src/parse/ast.h",
       "src/parse/json.h",  "src/parse/parser.h", "src/parse/lexer.h", "src/code/types.h",
-      "src/base/common.h", "src/base/compat.h",
+      "src/base/common.h", "src/base/compat.h", "src/rt/ntt.c",     "src/rt/json.c", "src/rt/csv.c",
+      "src/rt/png.c", "src/rt/jpeg.c", "src/rt/pgo.c", "src/rt/ic.c", "src/base/util.h",
   };
   time_t latest = 0;
   char full[PATH_MAX];
@@ -382,11 +384,11 @@ static void ny_runtime_cache_path(char *out, size_t out_len, const char *cc, con
   else
     snprintf(dwarf_key, sizeof(dwarf_key), "d0");
   char key[PATH_MAX * 2];
-  snprintf(key, sizeof(key), "%s|%s|%d|%d|%d|%s|%s|%s|%s|%s|%s", cc ? cc : "",
+  snprintf(key, sizeof(key), "%s|%s|%d|%d|%d|%s|%s|%s|%s|%s|%s|%s", cc ? cc : "",
            root ? root : "", debug ? 1 : 0, speed_level, native_tune ? 1 : 0,
            llvm_include_arg ? llvm_include_arg : "", host_flags ? host_flags : "",
            host_triple ? host_triple : "", arm_float_abi ? arm_float_abi : "", dwarf_key,
-           cache_rev);
+           cache_rev, NY_VALUE_ENCODING);
   uint64_t h = ny_hash64(key, strlen(key));
 #ifdef _WIN32
   snprintf(out, out_len, "%s/ny_rt_cache_%016llx_%s.obj", tmp, (unsigned long long)h,
@@ -933,6 +935,9 @@ bool ny_builder_compile_runtime(const char *cc, const char *out_runtime, const c
                                         "/D_CRT_SECURE_NO_WARNINGS",
                                         "/D_CRT_NONSTDC_NO_WARNINGS",
                                         "/DNYTRIX_RUNTIME_ONLY",
+#if NYTRIX_INLINE_FLOAT
+                                        "/DNYTRIX_INLINE_FLOAT=1",
+#endif
                                         include_arg,
                                         llvm_include_arg,
                                         gmp_include_arg,
@@ -1037,6 +1042,9 @@ bool ny_builder_compile_runtime(const char *cc, const char *out_runtime, const c
   runtime_args[ra_i++] = "-D_CRT_NONSTDC_NO_WARNINGS";
 #endif
   runtime_args[ra_i++] = "-DNYTRIX_RUNTIME_ONLY";
+#if NYTRIX_INLINE_FLOAT
+  runtime_args[ra_i++] = "-DNYTRIX_INLINE_FLOAT=1";
+#endif
   runtime_args[ra_i++] = include_arg;
   runtime_args[ra_i++] = llvm_include_arg;
 #ifdef _WIN32
@@ -1077,6 +1085,9 @@ bool ny_builder_compile_runtime(const char *cc, const char *out_runtime, const c
   runtime_args[ra_i++] = "-ffunction-sections";
   runtime_args[ra_i++] = "-fdata-sections";
   runtime_args[ra_i++] = "-DNYTRIX_RUNTIME_ONLY";
+#if NYTRIX_INLINE_FLOAT
+  runtime_args[ra_i++] = "-DNYTRIX_INLINE_FLOAT=1";
+#endif
   runtime_args[ra_i++] = include_arg;
   runtime_args[ra_i++] = llvm_include_arg;
   if (sanitize_kind && *sanitize_kind) {
@@ -1162,6 +1173,98 @@ bool ny_builder_compile_runtime(const char *cc, const char *out_runtime, const c
   return true;
 }
 
+#ifndef _WIN32
+static bool ny_builder_cc_is_clang(const char *cc) {
+  if (!cc || !*cc)
+    return false;
+  const char *base = strrchr(cc, '/');
+  base = base ? base + 1 : cc;
+  if (strncmp(base, "clang", 5) == 0)
+    return strncmp(base, "clang-cl", 8) != 0;
+#ifdef __APPLE__
+  return strcmp(base, "cc") == 0;
+#else
+  return false;
+#endif
+}
+#endif
+
+/* Compiles the runtime to LLVM bitcode instead of an object so AOT builds
+ * can link it into the program module. Only clang emits bitcode; for any
+ * other compiler this returns false and the caller keeps the object path. */
+bool ny_builder_compile_runtime_bitcode(const char *cc, const char *out_bc, int speed_level,
+                                        bool native_tune) {
+#ifdef _WIN32
+  (void)cc;
+  (void)out_bc;
+  (void)speed_level;
+  (void)native_tune;
+  return false;
+#else
+  if (!ny_builder_cc_is_clang(cc) || !out_bc || !*out_bc)
+    return false;
+  const char *root = ny_src_root();
+  static char include_arg[PATH_MAX + 12];
+  static char runtime_src[PATH_MAX];
+  char cache_bc[PATH_MAX];
+  bool target_windows = ny_builder_target_is_windows();
+  if (target_windows)
+    return false;
+  if (speed_level < 0)
+    speed_level = 0;
+  if (speed_level > 3)
+    speed_level = 3;
+  snprintf(runtime_src, sizeof(runtime_src), "%s/src/rt/init.c", root);
+  snprintf(include_arg, sizeof(include_arg), "-I%s/src", root);
+  ny_runtime_cache_path(cache_bc, sizeof(cache_bc), cc, root, false, speed_level, native_tune,
+                        "-emit-llvm");
+  size_t cache_len = strlen(cache_bc);
+  if (cache_len > 2 && cache_len + 2 < sizeof(cache_bc) &&
+      strcmp(cache_bc + cache_len - 2, ".o") == 0)
+    memcpy(cache_bc + cache_len - 2, ".bc", 4);
+  if (ny_try_restore_runtime_cache(cache_bc, out_bc, root))
+    return true;
+  const char *args[64];
+  size_t n = 0;
+  if (ny_tool_in_path("ccache"))
+    args[n++] = "ccache";
+  args[n++] = cc;
+  args[n++] = "-std=gnu11";
+  args[n++] = speed_level >= 2 ? "-O3" : "-Os";
+  args[n++] = "-emit-llvm";
+  args[n++] = "-fomit-frame-pointer";
+  args[n++] = "-foptimize-sibling-calls";
+  if (native_tune)
+    args[n++] = "-march=native";
+#if defined(__arm__) && !defined(__aarch64__)
+  args[n++] = ny_builder_arm_float_abi_flag();
+#endif
+  args[n++] = ny_env_enabled("NYTRIX_NO_PIE") ? "-fno-pie" : "-fPIE";
+  args[n++] = "-fvisibility=hidden";
+  args[n++] = "-DNYTRIX_RUNTIME_ONLY";
+#if NYTRIX_INLINE_FLOAT
+  args[n++] = "-DNYTRIX_INLINE_FLOAT=1";
+#endif
+  args[n++] = include_arg;
+  args[n++] = "-c";
+  args[n++] = runtime_src;
+  args[n++] = "-o";
+  args[n++] = out_bc;
+  args[n] = NULL;
+  char *host_pool[16];
+  size_t pool_len = 0;
+  int rc = spawn_with_host_flags(args, getenv("NYTRIX_HOST_CFLAGS"), host_pool, &pool_len);
+  ny_free_host_pool(host_pool, pool_len);
+  if (rc != 0) {
+    if (verbose_enabled >= 2)
+      fprintf(stderr, "[**] Runtime bitcode compilation failed (exit=%d)\n", rc);
+    return false;
+  }
+  ny_update_runtime_cache(cache_bc, out_bc);
+  return true;
+#endif
+}
+
 bool ny_builder_link(const char *cc, const char *obj_path, const char *runtime_obj,
                      const char *runtime_ast_obj, const char *const extra_objs[],
                      size_t extra_count, const char *const link_dirs[], size_t link_dir_count,
@@ -11,6 +11,8 @@ int ny_exec_spawn(const char *const argv[]);
 bool ny_builder_compile_runtime(const char *cc, const char *out_runtime, const char *out_ast,
                                 bool debug, bool profile, int speed_level, bool native_tune,
                                 const char *sanitize_kind);
+bool ny_builder_compile_runtime_bitcode(const char *cc, const char *out_bc, int speed_level,
+                                        bool native_tune);
 bool ny_builder_link(const char *cc, const char *obj_path, const char *runtime_obj,
                      const char *runtime_ast_obj, const char *const extra_objs[],
                      size_t extra_count, const char *const link_dirs[], size_t link_dir_count,
@@ -5,6 +5,7 @@
 #include "base/loader.h"
 #include "base/time.h"
 #include "base/util.h"
+#include "base/value.h"
 #include <llvm-c/Analysis.h>
 #include <llvm-c/BitReader.h>
 #include <llvm-c/BitWriter.h>
@@ -525,6 +526,7 @@ char *ny_std_bc_cache_path(const char *stdlib_path, const char *const *uses, siz
 
   uint64_t h = NY_FNV1A64_OFFSET_BASIS;
   h = ny_fnv1a64_cstr("std-bc-cache-v5", h);
+  h = ny_fnv1a64_cstr(NY_VALUE_ENCODING, h);
   h = ny_hash64_u64(h, (uint64_t)(unsigned)std_mode);
   h = ny_hash_cstrv(h, uses, use_count);
   h = ny_fnv1a64_cstr(stdlib_path, h);
@@ -780,6 +782,101 @@ bool ny_jit_cache_save_ir(const char *cache_path, LLVMModuleRef module) {
   return ny_jit_cache_save(cache_path, module);
 }
 
+enum { NY_COMPTIME_CACHE_VERSION = 1 };
+
+bool ny_comptime_cache_enabled(void) {
+  return ny_env_enabled_default_on("NYTRIX_COMPTIME_CACHE");
+}
+
+static bool ny_comptime_cache_path(char *out, size_t out_len, uint64_t key) {
+  const char *root = ny_default_cache_root_dir();
+  char dir[PATH_MAX];
+  snprintf(dir, sizeof(dir), "%s/comptime",
+           root && *root ? root : ny_get_temp_dir());
+  if (!ny_cache_dir_ready(dir))
+    return false;
+  int n = snprintf(out, out_len, "%s/v%d-%016llx-%016llx.ctv", dir,
+                   (int)NY_COMPTIME_CACHE_VERSION,
+                   (unsigned long long)ny_cache_compiler_source_fingerprint(),
+                   (unsigned long long)key);
+  return n > 0 && (size_t)n < out_len;
+}
+
+char *ny_comptime_cache_load(uint64_t key, size_t *out_len) {
+  if (out_len)
+    *out_len = 0;
+  char path[PATH_MAX];
+  if (!ny_comptime_cache_enabled() ||
+      !ny_comptime_cache_path(path, sizeof(path), key))
+    return NULL;
+  if (ny_access(path, R_OK) != 0)
+    return NULL;
+  size_t len = 0;
+  char *data = ny_read_file_raw(path, &len);
+  if (!data)
+    return NULL;
+  if (ny_trace_cache_enabled())
+    fprintf(stderr, "[cache] comptime hit %s (%zu bytes)\n", path, len);
+  if (out_len)
+    *out_len = len;
+  return data;
+}
+
+bool ny_comptime_cache_save(uint64_t key, const char *data, size_t len) {
+  char path[PATH_MAX];
+  if (!data || !ny_comptime_cache_enabled() ||
+      !ny_comptime_cache_path(path, sizeof(path), key))
+    return false;
+  bool ok = ny_write_text_file_atomic(path, data, len);
+  if (ny_trace_cache_enabled())
+    fprintf(stderr, "[cache] comptime %s %s (%zu bytes)\n",
+            ok ? "store" : "store failed", path, len);
+  return ok;
+}
+
+enum { NY_REPL_STD_OBJECT_CACHE_VERSION = 1 };
+
+char *ny_repl_std_object_cache_path(uint64_t key) {
+  if (!ny_jit_cache_enabled())
+    return NULL;
+  const char *root = ny_default_cache_root_dir();
+  char dir[PATH_MAX];
+  snprintf(dir, sizeof(dir), "%s/repl", root && *root ? root : ny_get_temp_dir());
+  if (!ny_cache_dir_ready(dir))
+    return NULL;
+  char path[PATH_MAX];
+  int n = snprintf(path, sizeof(path), "%s/v%d-%016llx-%016llx.o", dir,
+                   (int)NY_REPL_STD_OBJECT_CACHE_VERSION,
+                   (unsigned long long)ny_cache_compiler_source_fingerprint(),
+                   (unsigned long long)key);
+  if (n <= 0 || (size_t)n >= sizeof(path))
+    return NULL;
+  return ny_strdup(path);
+}
+
+bool ny_repl_std_object_cache_save(const char *path, LLVMModuleRef module, int opt_level) {
+  if (!path || !module)
+    return false;
+  char tmp[PATH_MAX];
+  int n = snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  if (n <= 0 || (size_t)n >= sizeof(tmp))
+    return false;
+  extern bool ny_llvm_emit_object(LLVMModuleRef module, const char *path, int opt_level);
+  LLVMModuleRef emit_mod = LLVMCloneModule(module);
+  if (!emit_mod)
+    return false;
+  LLVMStripModuleDebugInfo(emit_mod);
+  bool ok = ny_llvm_emit_object(emit_mod, tmp, opt_level);
+  LLVMDisposeModule(emit_mod);
+  if (!ok || rename(tmp, path) != 0) {
+    remove(tmp);
+    ok = false;
+  }
+  if (ny_trace_cache_enabled())
+    fprintf(stderr, "[cache] repl std object %s %s\n", ok ? "store" : "store failed", path);
+  return ok;
+}
+
 #ifndef _WIN32
 static bool ny_jit_cache_use_native(void) {
 
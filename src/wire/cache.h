@@ -3,6 +3,8 @@
 
 #include <llvm-c/Core.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* Cache path utilities */
 bool ny_cache_path_is_ir(const char *cache_path);
@@ -21,6 +23,13 @@ bool ny_jit_cache_save(const char *cache_path, LLVMModuleRef module);
 bool ny_jit_cache_load_ir(const char *cache_path, LLVMContextRef ctx, LLVMModuleRef *out_module);
 bool ny_jit_cache_save_ir(const char *cache_path, LLVMModuleRef module);
 
+bool ny_comptime_cache_enabled(void);
+char *ny_comptime_cache_load(uint64_t key, size_t *out_len);
+bool ny_comptime_cache_save(uint64_t key, const char *data, size_t len);
+
+char *ny_repl_std_object_cache_path(uint64_t key);
+bool ny_repl_std_object_cache_save(const char *path, LLVMModuleRef module, int opt_level);
+
 #ifndef _WIN32
 bool ny_jit_native_cache_enabled(void);
 char *ny_jit_native_cache_path(const char *bc_path);
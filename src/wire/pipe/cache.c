@@ -310,6 +310,7 @@ static void ny_build_aot_cache_path(const ny_options *opt, const char *source,
     return;
   uint64_t h = NY_FNV1A64_OFFSET_BASIS;
   h = ny_fnv1a64_cstr("aot-cache-v10", h);
+  h = ny_fnv1a64_cstr(NY_VALUE_ENCODING, h);
   h = ny_fnv1a64_cstr(VERSION, h);
 #ifdef NYTRIX_VERSION_COMMIT
   h = ny_fnv1a64_cstr(NYTRIX_VERSION_COMMIT, h);
@@ -538,6 +539,7 @@ static uint64_t ny_build_std_cache_path(const ny_options *opt,
   out[0] = '\0';
   uint64_t h = NY_FNV1A64_OFFSET_BASIS;
   h = ny_fnv1a64_cstr("std-cache-v10", h);
+  h = ny_fnv1a64_cstr(NY_VALUE_ENCODING, h);
   h = ny_hash64_u64(h, (uint64_t)std_mode);
   if (opt) {
     const unsigned opt_fields[] = {
@@ -1117,8 +1117,11 @@ static void ny_drop_jit_llvm_used_metadata(LLVMModuleRef module) {
   ny_drop_llvm_used_globals(module);
 }
 
+/* `entry_only` keeps just the entry points alive. The JIT always wants that;
+ * AOT builds want it once the runtime has been linked into the module, since
+ * nothing outside the module can reference its symbols any more. */
 static void ny_prepare_internalize(LLVMModuleRef module, const ny_options *opt,
-                                   const codegen_t *cg, bool is_jit) {
+                                   const codegen_t *cg, bool entry_only) {
   if (!module || !opt)
     return;
   VEC(LLVMValueRef) preserve;
@@ -1131,8 +1134,8 @@ static void ny_prepare_internalize(LLVMModuleRef module, const ny_options *opt,
     const char *name = LLVMGetValueName2(fn, &name_len);
     if (!name || name_len == 0)
       continue;
-    if (is_jit ? ny_should_preserve_jit_symbol(cg, name)
-               : ny_should_preserve_aot_symbol(cg, name)) {
+    if (entry_only ? ny_should_preserve_jit_symbol(cg, name)
+                   : ny_should_preserve_aot_symbol(cg, name)) {
       vec_push(&preserve, fn);
     }
   }
@@ -1146,8 +1149,8 @@ static void ny_prepare_internalize(LLVMModuleRef module, const ny_options *opt,
       continue;
     if (ny_is_llvm_special_global(name))
       continue;
-    if (is_jit ? ny_should_preserve_jit_symbol(cg, name)
-               : ny_should_preserve_aot_symbol(cg, name)) {
+    if (entry_only ? ny_should_preserve_jit_symbol(cg, name)
+                   : ny_should_preserve_aot_symbol(cg, name)) {
       vec_push(&preserve, gv);
     }
   }
@@ -1157,7 +1160,7 @@ static void ny_prepare_internalize(LLVMModuleRef module, const ny_options *opt,
 }
 
 static void run_dead_strip_if_needed(const ny_options *opt, codegen_t *cg,
-                                     LLVMModuleRef module) {
+                                     LLVMModuleRef module, bool whole_program) {
   if (!opt || !module)
     return;
   bool is_aot = (opt->output_file != NULL);
@@ -1210,7 +1213,7 @@ static void run_dead_strip_if_needed(const ny_options *opt, codegen_t *cg,
   }
 
   if (internalize_enabled) {
-    ny_prepare_internalize(module, opt, cg, is_jit);
+    ny_prepare_internalize(module, opt, cg, is_jit || whole_program);
     if (verbose_enabled >= 1)
       NY_LOG_INFO("%s internalize: enabled via llvm.used\n",
                   is_aot ? "AOT" : "JIT");
@@ -1258,6 +1261,129 @@ static void run_dead_strip_if_needed(const ny_options *opt, codegen_t *cg,
   LLVMDisposePassBuilderOptions(popt);
 }
 
+static int ny_runtime_speed_level(const ny_options *opt, bool *native_out) {
+  ny_opt_profile_kind_t runtime_profile =
+      ny_opt_profile_kind_from_name(opt->opt_profile);
+  bool runtime_speed = opt->opt_level >= 3 ||
+                       runtime_profile == NY_OPT_PROFILE_SPEED ||
+                       runtime_profile == NY_OPT_PROFILE_PEAK ||
+                       ny_env_enabled("NYTRIX_RUNTIME_SPEED");
+  const char *runtime_opt_env = ny_env_str_nonempty("NYTRIX_RUNTIME_OPT");
+  int level = runtime_speed ? 3 : 0;
+  if (runtime_opt_env) {
+    if (strcmp(runtime_opt_env, "0") == 0 ||
+        strcmp(runtime_opt_env, "size") == 0)
+      level = 0;
+    else if (strcmp(runtime_opt_env, "2") == 0)
+      level = 2;
+    else if (strcmp(runtime_opt_env, "3") == 0 ||
+             strcmp(runtime_opt_env, "speed") == 0)
+      level = 3;
+  }
+  if (native_out)
+    *native_out =
+        level >= 3 && ny_env_enabled_default_on("NYTRIX_RUNTIME_NATIVE");
+  return level;
+}
+
+static bool ny_runtime_lto_wanted(const ny_options *opt,
+                                  const char *output_path) {
+#ifdef _WIN32
+  (void)opt;
+  (void)output_path;
+  return false;
+#else
+  if (!opt || !output_path || !*output_path || opt->run_jit)
+    return false;
+  if (opt->native_backend != NY_NATIVE_BACKEND_LLVM ||
+      ny_output_path_is_object(output_path))
+    return false;
+  if (opt->debug_symbols || opt->gprof == 1 ||
+      (opt->sanitize && *opt->sanitize))
+    return false;
+  if (opt->runtime_lto >= 0)
+    return opt->runtime_lto != 0;
+  const char *env = ny_env_str_nonempty("NYTRIX_RUNTIME_LTO");
+  if (env)
+    return ny_env_truthy(env);
+  return opt->opt_level >= 2;
+#endif
+}
+
+static bool ny_same_arch(const char *a, const char *b) {
+  if (!a || !*a || !b || !*b)
+    return true;
+  size_t la = strcspn(a, "-");
+  size_t lb = strcspn(b, "-");
+  return la == lb && strncmp(a, b, la) == 0;
+}
+
+/* Links the runtime into `module` as bitcode so internalize and globaldce
+ * see the whole program and the optimizer can inline rt_* helpers into user
+ * code. Returns false with the module untouched when the bitcode cannot be
+ * built or read (non-clang CC, clang newer than our LLVM, other target), in
+ * which case the caller links the runtime object as usual. */
+static bool ny_link_runtime_bitcode(const ny_options *opt, codegen_t *cg) {
+  bool native = false;
+  int speed = ny_runtime_speed_level(opt, &native);
+  const char *cc = ny_builder_choose_cc();
+  char bc[4096];
+  char bc_name[64];
+  snprintf(bc_name, sizeof(bc_name), "ny_rt_%ld_%llu.bc", (long)getpid(),
+           (unsigned long long)ny_ticks_now());
+  ny_join_path(bc, sizeof(bc), ny_get_temp_dir(), bc_name);
+  if (!ny_builder_compile_runtime_bitcode(cc, bc, speed, native)) {
+    (void)unlink(bc);
+    NY_LOG_V2("runtime LTO: no runtime bitcode from %s\n", cc);
+    return false;
+  }
+  LLVMMemoryBufferRef buf = NULL;
+  char *msg = NULL;
+  bool read = LLVMCreateMemoryBufferWithContentsOfFile(bc, &buf, &msg) == 0;
+  (void)unlink(bc);
+  if (!read) {
+    NY_LOG_V2("runtime LTO: %s\n", msg ? msg : "cannot read runtime bitcode");
+    if (msg)
+      LLVMDisposeMessage(msg);
+    return false;
+  }
+  LLVMModuleRef rt = NULL;
+  bool parsed = LLVMParseBitcodeInContext2(cg->ctx, buf, &rt) == 0;
+  LLVMDisposeMemoryBuffer(buf);
+  if (!parsed || !rt) {
+    NY_LOG_V2("%s", "runtime LTO: runtime bitcode is not readable by this "
+                    "LLVM; linking the runtime object instead\n");
+    return false;
+  }
+  if (!ny_same_arch(LLVMGetTarget(rt), LLVMGetTarget(cg->module))) {
+    LLVMDisposeModule(rt);
+    return false;
+  }
+  /* A strong definition on both sides would make the IR linker fail halfway
+   * through, so back out before touching the program module. */
+  for (LLVMValueRef fn = LLVMGetFirstFunction(rt); fn;
+       fn = LLVMGetNextFunction(fn)) {
+    if (LLVMIsDeclaration(fn) || LLVMGetLinkage(fn) == LLVMInternalLinkage ||
+        LLVMGetLinkage(fn) == LLVMPrivateLinkage)
+      continue;
+    LLVMValueRef mine = LLVMGetNamedFunction(cg->module, LLVMGetValueName(fn));
+    if (mine && !LLVMIsDeclaration(mine) &&
+        LLVMGetLinkage(mine) == LLVMExternalLinkage) {
+      NY_LOG_V2("runtime LTO: %s is defined twice\n", LLVMGetValueName(fn));
+      LLVMDisposeModule(rt);
+      return false;
+    }
+  }
+  LLVMSetTarget(rt, LLVMGetTarget(cg->module));
+  LLVMSetDataLayout(rt, LLVMGetDataLayoutStr(cg->module));
+  if (LLVMLinkModules2(cg->module, rt) != 0) {
+    NY_LOG_WARN("%s", "runtime LTO: linking runtime bitcode failed\n");
+    return false;
+  }
+  NY_LOG_V2("%s", "runtime LTO: runtime linked into the program module\n");
+  return true;
+}
+
 typedef VEC(char *) ny_link_lib_vec;
 
 static bool ny_link_lib_basename(const char *lib, const char **base_out,
@@ -1706,6 +1832,7 @@ int ny_pipeline_run(ny_options *opt) {
   char aot_run_path[4096] = {0};
   bool aot_run_temp = false;
   bool loaded_from_cache = false;
+  bool runtime_in_module = false;
   char *jit_cache_file = NULL;
   char *type_errors_json = NULL;
 #ifndef _WIN32
@@ -2287,6 +2414,7 @@ int ny_pipeline_run(ny_options *opt) {
   }
 #endif
   fflush(stderr);
+  ny_pgo_annotate_functions(&cg);
   codegen_debug_finalize(&cg);
   maybe_log_phase_time(opt->do_timing, "Codegen:", t_codegen);
   ny_trace_ir_stats("post_codegen", cg.module);
@@ -2337,7 +2465,9 @@ int ny_pipeline_run(ny_options *opt) {
       ny_env_enabled("NYTRIX_JIT_HOST_ATTRS")) {
     ny_llvm_apply_host_attrs(cg.module);
   }
-  run_dead_strip_if_needed(opt, &cg, cg.module);
+  if (ny_runtime_lto_wanted(opt, output_path))
+    runtime_in_module = ny_link_runtime_bitcode(opt, &cg);
+  run_dead_strip_if_needed(opt, &cg, cg.module, runtime_in_module);
   ny_dump_diagnose_ir_stage(opt, cg.module, "diag.pre.ll", "pre-opt");
   if (opt->emit_ir_pre_path) {
     LLVMModuleRef dump_mod = ny_prepare_ir_dump_module(opt, cg.module);
@@ -2392,7 +2522,8 @@ int ny_pipeline_run(ny_options *opt) {
     ny_stage_emit_artifact(opt, NY_STOP_AFTER_OPT, &prog, &cg, parse_name,
                            cg.module, false);
   }
-  if (write_compile_caches && jit_cache_file && !loaded_from_cache) {
+  if (write_compile_caches && jit_cache_file && !loaded_from_cache &&
+      !runtime_in_module) {
 #ifndef _WIN32
     if (native_cache_file && opt->run_jit && !opt->command_string) {
       ny_tick_t t_native = opt->do_timing ? ny_ticks_now() : 0;
@@ -2448,7 +2579,7 @@ skip_compilation:
     jit_cache_file = NULL;
   }
   if (write_compile_caches && !auto_std_bc_cache_saved && !use_std_bc_cache &&
-      auto_std_bc_cache &&
+      auto_std_bc_cache && !runtime_in_module &&
       cg.module &&
       !loaded_from_cache && !opt->emit_module && std_mode != STD_MODE_NONE &&
       !has_local) {
@@ -2469,6 +2600,7 @@ skip_compilation:
   if (loaded_from_cache && cg.module)
     codegen_prepare(&cg);
   ny_clear_origin_sections(cg.module);
+  ny_pgo_place_hot_functions(cg.module);
 
   if (opt->emit_ir_path) {
     ny_ensure_parent_dir_for_path(opt->emit_ir_path);
@@ -2592,34 +2724,18 @@ skip_compilation:
       snprintf(rto_name, sizeof(rto_name), "ny_rt_%ld_%llu.o", (long)getpid(),
                (unsigned long long)ny_ticks_now());
       ny_join_path(rto, sizeof(rto), ny_get_temp_dir(), rto_name);
-      ny_opt_profile_kind_t runtime_profile =
-          ny_opt_profile_kind_from_name(opt->opt_profile);
-      bool runtime_speed = opt->opt_level >= 3 ||
-                           runtime_profile == NY_OPT_PROFILE_SPEED ||
-                           runtime_profile == NY_OPT_PROFILE_PEAK ||
-                           ny_env_enabled("NYTRIX_RUNTIME_SPEED");
-      const char *runtime_opt_env = ny_env_str_nonempty("NYTRIX_RUNTIME_OPT");
-      int runtime_speed_level = runtime_speed ? 3 : 0;
-      if (runtime_opt_env) {
-        if (strcmp(runtime_opt_env, "0") == 0 ||
-            strcmp(runtime_opt_env, "size") == 0)
-          runtime_speed_level = 0;
-        else if (strcmp(runtime_opt_env, "2") == 0)
-          runtime_speed_level = 2;
-        else if (strcmp(runtime_opt_env, "3") == 0 ||
-                 strcmp(runtime_opt_env, "speed") == 0)
-          runtime_speed_level = 3;
-      }
-      bool runtime_native = runtime_speed_level >= 3 &&
-                            ny_env_enabled_default_on("NYTRIX_RUNTIME_NATIVE");
-      NY_LOG_V2(
-          "Compiling runtime to %s using %s (debug=%d speed=%d native=%d)...\n",
-          rto, cc, opt->debug_symbols, runtime_speed_level,
-          runtime_native ? 1 : 0);
+      bool runtime_native = false;
+      int runtime_speed_level = ny_runtime_speed_level(opt, &runtime_native);
+      if (!runtime_in_module)
+        NY_LOG_V2(
+            "Compiling runtime to %s using %s (debug=%d speed=%d native=%d)...\n",
+            rto, cc, opt->debug_symbols, runtime_speed_level,
+            runtime_native ? 1 : 0);
       ny_tick_t t_runtime_obj = opt->do_timing ? ny_ticks_now() : 0;
-      if (!ny_builder_compile_runtime(cc, rto, NULL, opt->debug_symbols,
-                                       opt->gprof == 1, runtime_speed_level,
-                                       runtime_native, opt->sanitize)) {
+      if (!runtime_in_module &&
+          !ny_builder_compile_runtime(cc, rto, NULL, opt->debug_symbols,
+                                      opt->gprof == 1, runtime_speed_level,
+                                      runtime_native, opt->sanitize)) {
         maybe_log_phase_time(opt->do_timing, "Runtime obj:", t_runtime_obj);
         unlink(obj);
         dump_debug_bundle(opt, source, cg.module);
@@ -2645,7 +2761,7 @@ skip_compilation:
       ny_link_lib_vec_merge(&merged_libs, opt, &cg);
       ny_tick_t t_link = opt->do_timing ? ny_ticks_now() : 0;
       if (!ny_builder_link(
-              cc, obj, rto, NULL, NULL, 0,
+              cc, obj, runtime_in_module ? NULL : rto, NULL, NULL, 0,
               (const char *const *)opt->link_dirs.data, opt->link_dirs.len,
               (const char *const *)merged_libs.data, merged_libs.len,
               output_path, link_strip, opt->debug_symbols, opt->gprof == 1,